@@ -1,10 +1,67 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 // BMB Runtime Library
+
+// Runtime statistics: same BMB_RUNTIME_STATS options and report as
+// runtime/runtime.c ("text"/"1", "json", "leaks", "file=PATH";
+// BMB_RUNTIME_STATS_SAMPLE sets the call-site sampling period). This
+// runtime is single-threaded, so the counters are plain globals.
+#if defined(__GNUC__) || defined(__clang__)
+#define BMB_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define BMB_CALLER() __builtin_return_address(0)
+#else
+#define BMB_UNLIKELY(x) (x)
+#define BMB_CALLER() NULL
+#endif
+
+enum {
+    BMB_API_STRING_NEW, BMB_API_STRING_CONCAT, BMB_API_STRING_SLICE, BMB_API_CHR,
+    BMB_API_INT_TO_STRING, BMB_API_READ_FILE, BMB_API_SB_NEW, BMB_API_SB_PUSH,
+    BMB_API_SB_BUILD, BMB_API_VEC_NEW, BMB_API_VEC_GROW, BMB_API_BOX_NEW, BMB_API_COUNT
+};
+static const char* const bmb_api_names[BMB_API_COUNT] = {
+    "string_new", "string_concat", "string_slice", "chr", "int_to_string", "read_file",
+    "sb_new", "sb_push", "sb_build", "vec_new", "vec_grow", "box_new",
+};
+
+#define BMB_STATS_SITES 1024
+#define BMB_STATS_TOP_SITES 20
+
+typedef struct { void* site; int api; int64_t samples; int64_t bytes; } BmbStatSite;
+
+static int bmb_stats_on = 0, bmb_stats_json = 0, bmb_stats_leaks = 0;
+static char bmb_stats_path[1024];
+static int64_t bmb_stats_sample = 256, bmb_stat_countdown = 256;
+static uint64_t bmb_stat_rng = 0x9E3779B97F4A7C15ull;
+static int64_t bmb_stat_calls[BMB_API_COUNT], bmb_stat_bytes[BMB_API_COUNT];
+static int64_t bmb_stat_live_vecs = 0, bmb_stat_live_boxes = 0;
+static BmbStatSite bmb_stat_sites[BMB_STATS_SITES];
+
+static void bmb_stat_record(int api, int64_t bytes, void* caller) {
+    bmb_stat_calls[api]++;
+    bmb_stat_bytes[api] += bytes;
+    if (!caller || --bmb_stat_countdown > 0) return;
+    // Random interval in [1, 2 * period) so alternating call patterns don't alias
+    bmb_stat_rng ^= bmb_stat_rng << 13;
+    bmb_stat_rng ^= bmb_stat_rng >> 7;
+    bmb_stat_rng ^= bmb_stat_rng << 17;
+    bmb_stat_countdown = 1 + (int64_t)(bmb_stat_rng % (uint64_t)(2 * bmb_stats_sample - 1));
+    size_t h = (size_t)(((uint64_t)(uintptr_t)caller * 0x9E3779B97F4A7C15ull) >> 54);
+    for (size_t k = 0; k < BMB_STATS_SITES; k++) {
+        BmbStatSite* e = &bmb_stat_sites[(h + k) & (BMB_STATS_SITES - 1)];
+        if (!e->site) { e->site = caller; e->api = api; }
+        if (e->site == caller && e->api == api) { e->samples++; e->bytes += bytes; return; }
+    }
+}
+
+#define BMB_STAT(api, bytes) \
+    do { if (BMB_UNLIKELY(bmb_stats_on)) bmb_stat_record((api), (int64_t)(bytes), BMB_CALLER()); } while (0)
 void bmb_println_i64(int64_t n) { printf("%ld\n", n); }
 void bmb_print_i64(int64_t n) { printf("%ld", n); }
+int64_t bmb_flush(void) { fflush(stdout); return 0; }
 int64_t bmb_read_int() { int64_t n; scanf("%ld", &n); return n; }
 void bmb_assert(int cond) { if (!cond) { fprintf(stderr, "Assertion failed!\n"); exit(1); } }
 int64_t bmb_abs(int64_t n) { return n < 0 ? -n : n; }
@@ -16,6 +73,7 @@ int64_t bmb_f64_to_i64(double f) { return (int64_t)f; }
 // v0.97: Character functions
 // v0.46: bmb_chr returns char* (string) to match LLVM codegen expectations
 char* bmb_chr(int64_t n) {
+    BMB_STAT(BMB_API_CHR, 2);
     char* s = (char*)malloc(2);
     s[0] = (char)n;
     s[1] = '\0';
@@ -30,74 +88,116 @@ int64_t bmb_ord(const char* s) {
 // v0.97: String functions
 void bmb_print_str(const char* s) { printf("%s", s); }
 void bmb_println_str(const char* s) { printf("%s\n", s); }
-int64_t bmb_str_len(const char* s) { int64_t len = 0; while (s[len]) len++; return len; }
+int64_t bmb_str_len(const char* s) { return (int64_t)strlen(s); }
 
 // v0.98: Vector functions
-// Layout: ptr[0] = capacity, ptr[1] = length, ptr[2...] = data
+// Layout: a handle points at a BmbVec header {data, len, cap}; data is a
+// separate i64 array. Same layout as runtime/runtime.c and the inline
+// vector code emitted by the text codegen.
+typedef struct BmbVec {
+    int64_t* data;
+    int64_t len;
+    int64_t cap;
+} BmbVec;
+
+#define BMB_VEC_MIN_CAP 4
+
+static BmbVec* bmb_vec_alloc(int64_t cap) {
+    BmbVec* v = (BmbVec*)malloc(sizeof(BmbVec));
+    if (!v) { fprintf(stderr, "panic: out of memory (vector)\n"); exit(1); }
+    v->data = NULL;
+    v->len = 0;
+    v->cap = 0;
+    if (BMB_UNLIKELY(bmb_stats_on)) bmb_stat_live_vecs++;
+    if (cap > 0) {
+        v->data = (int64_t*)malloc((size_t)cap * sizeof(int64_t));
+        if (!v->data) { fprintf(stderr, "panic: out of memory (vector)\n"); exit(1); }
+        v->cap = cap;
+    }
+    return v;
+}
+
 int64_t bmb_vec_new() {
-    int64_t* vec = (int64_t*)malloc(10 * sizeof(int64_t));
-    vec[0] = 8;  // capacity
-    vec[1] = 0;  // length
-    return (int64_t)vec;
+    BMB_STAT(BMB_API_VEC_NEW, sizeof(BmbVec));
+    return (int64_t)bmb_vec_alloc(0);
 }
 
 int64_t bmb_vec_with_capacity(int64_t cap) {
-    int64_t* vec = (int64_t*)malloc((cap + 2) * sizeof(int64_t));
-    vec[0] = cap;  // capacity
-    vec[1] = 0;    // length
-    return (int64_t)vec;
+    BMB_STAT(BMB_API_VEC_NEW, sizeof(BmbVec) + (cap > 0 ? cap : 0) * sizeof(int64_t));
+    return (int64_t)bmb_vec_alloc(cap);
+}
+
+// Slow path of bmb_vec_push: make room for one more element
+void bmb_vec_grow(BmbVec* v) {
+    int64_t new_cap = v->cap == 0 ? BMB_VEC_MIN_CAP : v->cap * 2;
+    int64_t* data = (int64_t*)realloc(v->data, (size_t)new_cap * sizeof(int64_t));
+    if (!data) { fprintf(stderr, "panic: out of memory (vector)\n"); exit(1); }
+    BMB_STAT(BMB_API_VEC_GROW, (new_cap - v->cap) * (int64_t)sizeof(int64_t));
+    v->data = data;
+    v->cap = new_cap;
+}
+
+// Slow path for stack vectors (vec_new_inline): the inline elements after
+// the header are copied to the heap on the first spill
+void bmb_vec_grow_inline(BmbVec* v) {
+    int64_t* inline_data = (int64_t*)(v + 1);
+    if (v->data != inline_data) { bmb_vec_grow(v); return; }
+    int64_t new_cap = v->cap * 2;
+    int64_t* data = (int64_t*)malloc((size_t)new_cap * sizeof(int64_t));
+    if (!data) { fprintf(stderr, "panic: out of memory (vector)\n"); exit(1); }
+    memcpy(data, inline_data, (size_t)v->len * sizeof(int64_t));
+    BMB_STAT(BMB_API_VEC_GROW, new_cap * (int64_t)sizeof(int64_t));
+    v->data = data;
+    v->cap = new_cap;
+}
+
+void bmb_vec_index_oob(int64_t index, int64_t len) {
+    fflush(stdout);
+    fprintf(stderr, "panic: vec_get: index %ld out of bounds (len=%ld)\n", index, len);
+    exit(1);
 }
 
 void bmb_vec_push(int64_t vec_ptr, int64_t value) {
-    int64_t* vec = (int64_t*)vec_ptr;
-    int64_t cap = vec[0];
-    int64_t len = vec[1];
-    if (len >= cap) {
-        // Grow: double capacity
-        int64_t new_cap = cap * 2;
-        int64_t* new_vec = (int64_t*)realloc(vec, (new_cap + 2) * sizeof(int64_t));
-        new_vec[0] = new_cap;
-        vec = new_vec;
-    }
-    vec[2 + len] = value;
-    vec[1] = len + 1;
+    BmbVec* v = (BmbVec*)vec_ptr;
+    if (v->len >= v->cap) bmb_vec_grow(v);
+    v->data[v->len++] = value;
 }
 
 int64_t bmb_vec_pop(int64_t vec_ptr) {
-    int64_t* vec = (int64_t*)vec_ptr;
-    int64_t len = vec[1];
-    if (len == 0) return 0;  // Empty vector
-    vec[1] = len - 1;
-    return vec[2 + len - 1];
+    BmbVec* v = (BmbVec*)vec_ptr;
+    if (v->len == 0) return 0;  // Empty vector
+    return v->data[--v->len];
 }
 
 int64_t bmb_vec_get(int64_t vec_ptr, int64_t index) {
-    int64_t* vec = (int64_t*)vec_ptr;
-    return vec[2 + index];
+    BmbVec* v = (BmbVec*)vec_ptr;
+    if ((uint64_t)index >= (uint64_t)v->len) bmb_vec_index_oob(index, v->len);
+    return v->data[index];
 }
 
-void bmb_vec_set(int64_t vec_ptr, int64_t index, int64_t value) {
-    int64_t* vec = (int64_t*)vec_ptr;
-    vec[2 + index] = value;
+// vec_get with the bounds check elided (index proven in range by contracts)
+int64_t bmb_vec_get_unchecked(int64_t vec_ptr, int64_t index) {
+    return ((BmbVec*)vec_ptr)->data[index];
 }
 
-int64_t bmb_vec_len(int64_t vec_ptr) {
-    int64_t* vec = (int64_t*)vec_ptr;
-    return vec[1];
+void bmb_vec_set(int64_t vec_ptr, int64_t index, int64_t value) {
+    ((BmbVec*)vec_ptr)->data[index] = value;
 }
 
-int64_t bmb_vec_cap(int64_t vec_ptr) {
-    int64_t* vec = (int64_t*)vec_ptr;
-    return vec[0];
-}
+int64_t bmb_vec_len(int64_t vec_ptr) { return ((BmbVec*)vec_ptr)->len; }
+
+int64_t bmb_vec_cap(int64_t vec_ptr) { return ((BmbVec*)vec_ptr)->cap; }
 
 void bmb_vec_free(int64_t vec_ptr) {
-    free((void*)vec_ptr);
+    BmbVec* v = (BmbVec*)vec_ptr;
+    if (!v) return;
+    free(v->data);
+    free(v);
+    if (BMB_UNLIKELY(bmb_stats_on)) bmb_stat_live_vecs--;
 }
 
 void bmb_vec_clear(int64_t vec_ptr) {
-    int64_t* vec = (int64_t*)vec_ptr;
-    vec[1] = 0;  // Reset length
+    ((BmbVec*)vec_ptr)->len = 0;  // Reset length, keep capacity
 }
 
 // v0.99: String conversion functions
@@ -126,6 +226,7 @@ char* bmb_char_to_string(int32_t c) {
 }
 
 char* bmb_int_to_string(int64_t n) {
+    BMB_STAT(BMB_API_INT_TO_STRING, 21);
     char* s = (char*)malloc(21);  // Max i64 is 20 digits + sign
     snprintf(s, 21, "%ld", (long)n);
     return s;
@@ -147,11 +248,19 @@ int64_t bmb_calloc(int64_t count, int64_t size) {
 
 // Box convenience
 int64_t bmb_box_new_i64(int64_t value) {
+    BMB_STAT(BMB_API_BOX_NEW, sizeof(int64_t));
+    if (BMB_UNLIKELY(bmb_stats_on)) bmb_stat_live_boxes++;
     int64_t* ptr = (int64_t*)malloc(sizeof(int64_t));
     *ptr = value;
     return (int64_t)ptr;
 }
 
+void bmb_box_free_i64(int64_t ptr) {
+    if (!ptr) return;
+    free((int64_t*)ptr);
+    if (BMB_UNLIKELY(bmb_stats_on)) bmb_stat_live_boxes--;
+}
+
 // v0.100: String concatenation
 char* bmb_string_concat(const char* a, const char* b) {
     if (!a || !b) {
@@ -159,13 +268,12 @@ char* bmb_string_concat(const char* a, const char* b) {
         result[0] = '\0';
         return result;
     }
-    size_t len_a = 0, len_b = 0;
-    while (a[len_a]) len_a++;
-    while (b[len_b]) len_b++;
+    // strlen/memcpy are vectorized by libc
+    size_t len_a = strlen(a), len_b = strlen(b);
+    BMB_STAT(BMB_API_STRING_CONCAT, len_a + len_b + 1);
     char* result = (char*)malloc(len_a + len_b + 1);
-    for (size_t i = 0; i < len_a; i++) result[i] = a[i];
-    for (size_t i = 0; i < len_b; i++) result[len_a + i] = b[i];
-    result[len_a + len_b] = '\0';
+    memcpy(result, a, len_a);
+    memcpy(result + len_a, b, len_b + 1);
     return result;
 }
 
@@ -177,8 +285,9 @@ char* bmb_string_from_cstr(const char* s) {
 
 // Create new string with given length (allocates copy)
 char* bmb_string_new(const char* s, int64_t len) {
+    BMB_STAT(BMB_API_STRING_NEW, len + 1);
     char* result = (char*)malloc(len + 1);
-    for (int64_t i = 0; i < len; i++) result[i] = s[i];
+    memcpy(result, s, len);
     result[len] = '\0';
     return result;
 }
@@ -186,9 +295,7 @@ char* bmb_string_new(const char* s, int64_t len) {
 // String length (alias for bmb_str_len with ptr signature)
 int64_t bmb_string_len(const char* s) {
     if (!s) return 0;
-    int64_t len = 0;
-    while (s[len]) len++;
-    return len;
+    return (int64_t)strlen(s);
 }
 
 // Get byte at index (NOT Unicode character)
@@ -201,11 +308,7 @@ int64_t bmb_string_char_at(const char* s, int64_t index) {
 int64_t bmb_string_eq(const char* a, const char* b) {
     if (a == b) return 1;  // Same pointer
     if (!a || !b) return 0;  // One is null
-    while (*a && *b) {
-        if (*a != *b) return 0;
-        a++; b++;
-    }
-    return (*a == *b) ? 1 : 0;  // Both should be '\0'
+    return strcmp(a, b) == 0 ? 1 : 0;
 }
 
 // String slice (substring from start to end, exclusive)
@@ -215,11 +318,12 @@ char* bmb_string_slice(const char* s, int64_t start, int64_t end) {
         empty[0] = '\0';
         return empty;
     }
+    // char* strings must stay NUL-terminated, so this runtime cannot hand out
+    // views; copy in one memcpy instead of byte by byte.
     int64_t len = end - start;
+    BMB_STAT(BMB_API_STRING_SLICE, len + 1);
     char* result = (char*)malloc(len + 1);
-    for (int64_t i = 0; i < len; i++) {
-        result[i] = s[start + i];
-    }
+    memcpy(result, s + start, len);
     result[len] = '\0';
     return result;
 }
@@ -270,7 +374,16 @@ typedef struct {
     int64_t cap;
 } StringBuilder;
 
+// Grow geometrically so that `extra` more bytes plus the NUL fit
+static void bmb_sb_reserve(StringBuilder* sb, int64_t extra) {
+    while (sb->len + extra + 1 > sb->cap) {
+        sb->cap *= 2;
+        sb->data = (char*)realloc(sb->data, sb->cap);
+    }
+}
+
 int64_t bmb_sb_new(void) {
+    BMB_STAT(BMB_API_SB_NEW, sizeof(StringBuilder) + 64);
     StringBuilder* sb = (StringBuilder*)malloc(sizeof(StringBuilder));
     sb->cap = 64;
     sb->len = 0;
@@ -285,21 +398,44 @@ int64_t bmb_sb_push(int64_t handle, const char* s) {
     int64_t slen = 0;
     while (s[slen]) slen++;
 
-    // Grow if needed
-    while (sb->len + slen + 1 > sb->cap) {
-        sb->cap *= 2;
-        sb->data = (char*)realloc(sb->data, sb->cap);
-    }
-
-    // Append
-    for (int64_t i = 0; i < slen; i++) {
-        sb->data[sb->len + i] = s[i];
-    }
+    BMB_STAT(BMB_API_SB_PUSH, slen);
+    bmb_sb_reserve(sb, slen);
+    memcpy(sb->data + sb->len, s, slen);
     sb->len += slen;
     sb->data[sb->len] = '\0';
     return sb->len;
 }
 
+// Append one byte without building a temporary string
+int64_t bmb_sb_push_char(int64_t handle, int64_t c) {
+    if (!handle) return 0;
+    StringBuilder* sb = (StringBuilder*)handle;
+    BMB_STAT(BMB_API_SB_PUSH, 1);
+    bmb_sb_reserve(sb, 1);
+    sb->data[sb->len++] = (char)c;
+    sb->data[sb->len] = '\0';
+    return sb->len;
+}
+
+// Append the decimal form of n without building a temporary string
+int64_t bmb_sb_push_int(int64_t handle, int64_t n) {
+    if (!handle) return 0;
+    StringBuilder* sb = (StringBuilder*)handle;
+    char tmp[20];
+    int64_t i = 0;
+    uint64_t u = n < 0 ? (uint64_t)0 - (uint64_t)n : (uint64_t)n;
+    do {
+        tmp[i++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    BMB_STAT(BMB_API_SB_PUSH, i + (n < 0));
+    bmb_sb_reserve(sb, i + 1);
+    if (n < 0) sb->data[sb->len++] = '-';
+    while (i) sb->data[sb->len++] = tmp[--i];
+    sb->data[sb->len] = '\0';
+    return sb->len;
+}
+
 int64_t bmb_sb_len(int64_t handle) {
     StringBuilder* sb = (StringBuilder*)handle;
     return sb->len;
@@ -312,11 +448,10 @@ char* bmb_sb_build(int64_t handle) {
         return empty;
     }
     StringBuilder* sb = (StringBuilder*)handle;
+    BMB_STAT(BMB_API_SB_BUILD, sb->len + 1);
     // Return copy of the built string
     char* result = (char*)malloc(sb->len + 1);
-    for (int64_t i = 0; i <= sb->len; i++) {
-        result[i] = sb->data[i];
-    }
+    memcpy(result, sb->data, sb->len + 1);
     return result;
 }
 
@@ -381,13 +516,19 @@ char* bmb_read_file(const char* path) {
     fseek(f, 0, SEEK_END);
     long size = ftell(f);
     fseek(f, 0, SEEK_SET);
+    if (size < 0) size = 0;
+    BMB_STAT(BMB_API_READ_FILE, size + 1);
     char* content = (char*)malloc(size + 1);
-    if (content) {
-        size_t read = fread(content, 1, size, f);
-        content[read] = '\0';
+    if (!content) {
+        // Never hand out a string literal: callers may free or modify the result
+        fclose(f);
+        fprintf(stderr, "panic: out of memory reading file (%ld bytes)\n", size);
+        exit(1);
     }
+    size_t read = fread(content, 1, size, f);
+    content[read] = '\0';
     fclose(f);
-    return content ? content : "";
+    return content;
 }
 
 int64_t bmb_write_file(const char* path, const char* content) {
@@ -437,6 +578,42 @@ int64_t str_eq(const char* a, const char* b) {
     return bmb_string_eq(a, b);
 }
 
+// String search builtins (runtime/runtime.c has the SIMD kernels; these
+// char* versions lean on libc's vectorized memchr/memcmp)
+int64_t str_find(const char* s, const char* needle, int64_t from) {
+    if (!s || !needle) return -1;
+    int64_t n = (int64_t)strlen(s), m = (int64_t)strlen(needle);
+    if (from < 0) from = 0;
+    for (int64_t i = from; i + m <= n; i++) {
+        const char* r = (const char*)memchr(s + i, m ? needle[0] : s[i], (size_t)(n - m + 1 - i));
+        if (!r) return -1;
+        i = r - s;
+        if (memcmp(s + i, needle, (size_t)m) == 0) return i;
+    }
+    return -1;
+}
+
+int64_t str_find_byte(const char* s, int64_t byte, int64_t from) {
+    if (!s) return -1;
+    int64_t n = (int64_t)strlen(s);
+    if (from < 0) from = 0;
+    if (from >= n) return -1;
+    const char* r = (const char*)memchr(s + from, (int)(unsigned char)byte, (size_t)(n - from));
+    return r ? r - s : -1;
+}
+
+int64_t str_count_byte(const char* s, int64_t byte) {
+    if (!s) return 0;
+    int64_t count = 0;
+    for (; *s; s++) count += (unsigned char)*s == (unsigned char)byte;
+    return count;
+}
+
+int64_t str_starts_with(const char* s, const char* prefix) {
+    if (!s || !prefix) return 0;
+    return strncmp(s, prefix, strlen(prefix)) == 0 ? 1 : 0;
+}
+
 // v0.50.20: StringBuilder wrappers
 int64_t sb_new(void) {
     return bmb_sb_new();
@@ -446,6 +623,14 @@ int64_t sb_push(int64_t handle, const char* s) {
     return bmb_sb_push(handle, s);
 }
 
+int64_t sb_push_char(int64_t handle, int64_t c) {
+    return bmb_sb_push_char(handle, c);
+}
+
+int64_t sb_push_int(int64_t handle, int64_t n) {
+    return bmb_sb_push_int(handle, n);
+}
+
 char* sb_build(int64_t handle) {
     return bmb_sb_build(handle);
 }
@@ -481,10 +666,102 @@ int64_t max(int64_t a, int64_t b) {
     return bmb_max(a, b);
 }
 
+// Runtime statistics report (see the top of this file)
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static int bmb_site_cmp(const void* a, const void* b) {
+    int64_t x = ((const BmbStatSite*)a)->bytes, y = ((const BmbStatSite*)b)->bytes;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void bmb_stats_report(void) {
+    fflush(stdout);
+    int64_t peak_rss = 0;
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) peak_rss = (int64_t)ru.ru_maxrss * 1024;
+#ifdef __APPLE__
+    peak_rss /= 1024;   // ru_maxrss is already bytes on macOS
+#endif
+#endif
+    // Sites are printed as absolute addresses: this runtime does not know
+    // the executable's load address
+    static BmbStatSite rows[BMB_STATS_SITES];
+    size_t nrows = 0;
+    for (size_t i = 0; i < BMB_STATS_SITES; i++) {
+        if (bmb_stat_sites[i].site) rows[nrows++] = bmb_stat_sites[i];
+    }
+    qsort(rows, nrows, sizeof(BmbStatSite), bmb_site_cmp);
+    if (nrows > BMB_STATS_TOP_SITES) nrows = BMB_STATS_TOP_SITES;
+
+    FILE* out = bmb_stats_path[0] ? fopen(bmb_stats_path, "w") : stderr;
+    if (!out) return;
+    if (bmb_stats_json) {
+        fprintf(out, "{\"sample_period\":%lld,\"apis\":{", (long long)bmb_stats_sample);
+        for (int a = 0; a < BMB_API_COUNT; a++) {
+            fprintf(out, "%s\"%s\":{\"calls\":%lld,\"bytes\":%lld}", a ? "," : "", bmb_api_names[a],
+                    (long long)bmb_stat_calls[a], (long long)bmb_stat_bytes[a]);
+        }
+        fprintf(out, "},\"peak_rss_bytes\":%lld,\"sites\":[", (long long)peak_rss);
+        for (size_t i = 0; i < nrows; i++) {
+            fprintf(out, "%s{\"address\":\"%p\",\"api\":\"%s\",\"samples\":%lld,\"est_calls\":%lld,\"est_bytes\":%lld}",
+                    i ? "," : "", rows[i].site, bmb_api_names[rows[i].api], (long long)rows[i].samples,
+                    (long long)(rows[i].samples * bmb_stats_sample), (long long)(rows[i].bytes * bmb_stats_sample));
+        }
+        fprintf(out, "]");
+        if (bmb_stats_leaks) {
+            fprintf(out, ",\"live_at_exit\":{\"vectors\":%lld,\"boxes\":%lld}",
+                    (long long)bmb_stat_live_vecs, (long long)bmb_stat_live_boxes);
+        }
+        fprintf(out, "}\n");
+    } else {
+        fprintf(out, "== bmb runtime stats ==\n%-16s %14s %16s\n", "api", "calls", "bytes");
+        for (int a = 0; a < BMB_API_COUNT; a++) {
+            if (!bmb_stat_calls[a]) continue;
+            fprintf(out, "%-16s %14lld %16lld\n", bmb_api_names[a],
+                    (long long)bmb_stat_calls[a], (long long)bmb_stat_bytes[a]);
+        }
+        fprintf(out, "peak rss: %lld bytes\n", (long long)peak_rss);
+        if (nrows) fprintf(out, "top allocation sites (1 in %lld sampled):\n", (long long)bmb_stats_sample);
+        for (size_t i = 0; i < nrows; i++) {
+            fprintf(out, "  %-14p %-16s ~%lld calls ~%lld bytes\n", rows[i].site, bmb_api_names[rows[i].api],
+                    (long long)(rows[i].samples * bmb_stats_sample), (long long)(rows[i].bytes * bmb_stats_sample));
+        }
+        if (bmb_stats_leaks) {
+            fprintf(out, "live at exit:\n  vectors: %lld\n  boxes: %lld\n",
+                    (long long)bmb_stat_live_vecs, (long long)bmb_stat_live_boxes);
+        }
+    }
+    if (out != stderr) fclose(out);
+}
+
+static void bmb_stats_init(void) {
+    const char* opts = getenv("BMB_RUNTIME_STATS");
+    if (!opts || !*opts || strcmp(opts, "0") == 0) return;
+    for (const char* p = opts; *p;) {
+        size_t n = strcspn(p, ",");
+        if (n == 4 && strncmp(p, "json", 4) == 0) bmb_stats_json = 1;
+        else if (n == 5 && strncmp(p, "leaks", 5) == 0) bmb_stats_leaks = 1;
+        else if (n > 5 && strncmp(p, "file=", 5) == 0 && n - 5 < sizeof(bmb_stats_path)) {
+            memcpy(bmb_stats_path, p + 5, n - 5);
+            bmb_stats_path[n - 5] = '\0';
+        }
+        p += n;
+        if (*p == ',') p++;
+    }
+    const char* sample = getenv("BMB_RUNTIME_STATS_SAMPLE");
+    if (sample && atoll(sample) > 0) bmb_stats_sample = bmb_stat_countdown = atoll(sample);
+    bmb_stats_on = 1;
+    atexit(bmb_stats_report);
+}
+
 // Entry point
 int64_t bmb_user_main(void);
 int main(int argc, char** argv) {
     g_argc = argc;
     g_argv = argv;
+    bmb_stats_init();
     return (int)bmb_user_main();
 }
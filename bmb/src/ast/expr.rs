@@ -1,6 +1,6 @@
 //! Expression AST nodes
 
-use super::{Spanned, Type};
+use super::{Spanned, Symbol, Type};
 use serde::{Deserialize, Serialize};
 
 /// Expression
@@ -20,7 +20,7 @@ pub enum Expr {
     Unit,
 
     /// Variable reference
-    Var(String),
+    Var(Symbol),
 
     /// Binary operation
     Binary {
@@ -106,7 +106,7 @@ pub enum Expr {
 
     /// Function call
     Call {
-        func: String,
+        func: Symbol,
         args: Vec<Spanned<Expr>>,
     },
 
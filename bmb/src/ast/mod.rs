@@ -2,11 +2,14 @@
 
 mod expr;
 pub mod output;
+mod shift;
 mod span;
+mod symbol;
 mod types;
 
 pub use expr::*;
 pub use span::*;
+pub use symbol::Symbol;
 pub use types::*;
 
 use serde::{Deserialize, Serialize};
@@ -281,7 +284,7 @@ pub struct FnDef {
     /// Attributes (v0.2): @inline, @pure, @decreases, etc.
     pub attributes: Vec<Attribute>,
     pub visibility: Visibility,
-    pub name: Spanned<String>,
+    pub name: Spanned<Symbol>,
     /// Type parameters (v0.13.1): e.g., `<T>`, `<T: Ord, U>`
     pub type_params: Vec<TypeParam>,
     pub params: Vec<Param>,
@@ -304,7 +307,7 @@ pub struct FnDef {
 /// Function parameter
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Param {
-    pub name: Spanned<String>,
+    pub name: Spanned<Symbol>,
     pub ty: Spanned<Type>,
 }
 
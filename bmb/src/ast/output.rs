@@ -339,7 +339,7 @@ pub fn format_expr(expr: &Expr) -> String {
         // v0.64: Character literal
         Expr::CharLit(c) => format!("'{}'", c.escape_default()),
         Expr::Unit => "()".to_string(),
-        Expr::Var(name) => name.clone(),
+        Expr::Var(name) => name.to_string(),
         Expr::Ret => "ret".to_string(),
         Expr::It => "it".to_string(),
 
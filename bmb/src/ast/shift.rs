@@ -0,0 +1,384 @@
+//! Span relocation
+//!
+//! Moves every span of a node by a fixed byte delta. The LSP server parses
+//! top-level items separately and reuses an unchanged item after text
+//! before it was edited; relocating is much cheaper than parsing it again.
+
+use super::*;
+
+fn shift(span: &mut Span, delta: isize) {
+    span.start = span.start.saturating_add_signed(delta);
+    span.end = span.end.saturating_add_signed(delta);
+}
+
+fn shift_name<T>(spanned: &mut Spanned<T>, delta: isize) {
+    shift(&mut spanned.span, delta);
+}
+
+impl ModuleHeader {
+    /// Move every span in the header by `delta` bytes
+    pub fn shift_spans(&mut self, delta: isize) {
+        shift_name(&mut self.name, delta);
+        for s in self.version.iter_mut().chain(&mut self.summary).chain(&mut self.exports) {
+            shift_name(s, delta);
+        }
+        for dep in &mut self.depends {
+            shift_name(&mut dep.module_path, delta);
+            for import in &mut dep.imports {
+                shift_name(import, delta);
+            }
+            shift(&mut dep.span, delta);
+        }
+        shift(&mut self.span, delta);
+    }
+}
+
+impl Item {
+    /// Move every span in the item by `delta` bytes
+    pub fn shift_spans(&mut self, delta: isize) {
+        match self {
+            Item::FnDef(f) => shift_fn(f, delta),
+            Item::StructDef(s) => {
+                shift_attrs(&mut s.attributes, delta);
+                shift_name(&mut s.name, delta);
+                for field in &mut s.fields {
+                    shift_name(&mut field.name, delta);
+                    shift_type(&mut field.ty, delta);
+                }
+                shift(&mut s.span, delta);
+            }
+            Item::EnumDef(e) => {
+                shift_attrs(&mut e.attributes, delta);
+                shift_name(&mut e.name, delta);
+                for variant in &mut e.variants {
+                    shift_name(&mut variant.name, delta);
+                    for field in &mut variant.fields {
+                        shift_type(field, delta);
+                    }
+                }
+                shift(&mut e.span, delta);
+            }
+            Item::TypeAlias(t) => {
+                shift_attrs(&mut t.attributes, delta);
+                shift_name(&mut t.name, delta);
+                shift_type(&mut t.target, delta);
+                if let Some(refinement) = &mut t.refinement {
+                    shift_expr(refinement, delta);
+                }
+                shift(&mut t.span, delta);
+            }
+            Item::Use(u) => {
+                for segment in &mut u.path {
+                    shift_name(segment, delta);
+                }
+                shift(&mut u.span, delta);
+            }
+            Item::ExternFn(e) => {
+                shift_attrs(&mut e.attributes, delta);
+                shift_name(&mut e.name, delta);
+                shift_params(&mut e.params, delta);
+                shift_type(&mut e.ret_ty, delta);
+                shift(&mut e.span, delta);
+            }
+            Item::TraitDef(t) => {
+                shift_attrs(&mut t.attributes, delta);
+                shift_name(&mut t.name, delta);
+                for method in &mut t.methods {
+                    shift_name(&mut method.name, delta);
+                    shift_params(&mut method.params, delta);
+                    shift_type(&mut method.ret_ty, delta);
+                    shift(&mut method.span, delta);
+                }
+                shift(&mut t.span, delta);
+            }
+            Item::ImplBlock(i) => {
+                shift_attrs(&mut i.attributes, delta);
+                shift_name(&mut i.trait_name, delta);
+                shift_type(&mut i.target_type, delta);
+                for method in &mut i.methods {
+                    shift_fn(method, delta);
+                }
+                shift(&mut i.span, delta);
+            }
+        }
+    }
+}
+
+fn shift_fn(f: &mut FnDef, delta: isize) {
+    shift_attrs(&mut f.attributes, delta);
+    shift_name(&mut f.name, delta);
+    shift_params(&mut f.params, delta);
+    if let Some(ret_name) = &mut f.ret_name {
+        shift_name(ret_name, delta);
+    }
+    shift_type(&mut f.ret_ty, delta);
+    for cond in f.pre.iter_mut().chain(&mut f.post) {
+        shift_expr(cond, delta);
+    }
+    for contract in &mut f.contracts {
+        if let Some(name) = &mut contract.name {
+            shift_name(name, delta);
+        }
+        shift_expr(&mut contract.condition, delta);
+        shift(&mut contract.span, delta);
+    }
+    shift_expr(&mut f.body, delta);
+    shift(&mut f.span, delta);
+}
+
+fn shift_attrs(attrs: &mut [Attribute], delta: isize) {
+    for attr in attrs {
+        match attr {
+            Attribute::Simple { name, span } => {
+                shift_name(name, delta);
+                shift(span, delta);
+            }
+            Attribute::WithArgs { name, args, span } => {
+                shift_name(name, delta);
+                for arg in args {
+                    shift_expr(arg, delta);
+                }
+                shift(span, delta);
+            }
+            Attribute::WithReason { name, reason, span } => {
+                shift_name(name, delta);
+                shift_name(reason, delta);
+                shift(span, delta);
+            }
+        }
+    }
+}
+
+fn shift_params(params: &mut [Param], delta: isize) {
+    for param in params {
+        shift_name(&mut param.name, delta);
+        shift_type(&mut param.ty, delta);
+    }
+}
+
+fn shift_type(ty: &mut Spanned<Type>, delta: isize) {
+    shift(&mut ty.span, delta);
+    shift_type_node(&mut ty.node, delta);
+}
+
+/// Types only carry spans inside refinement constraints
+fn shift_type_node(ty: &mut Type, delta: isize) {
+    match ty {
+        Type::Refined { base, constraints } => {
+            shift_type_node(base, delta);
+            for c in constraints {
+                shift_expr(c, delta);
+            }
+        }
+        Type::Range(inner) | Type::Ref(inner) | Type::RefMut(inner) | Type::Array(inner, _) | Type::Nullable(inner) => {
+            shift_type_node(inner, delta);
+        }
+        Type::Generic { type_args: types, .. } | Type::Tuple(types) => {
+            for t in types {
+                shift_type_node(t, delta);
+            }
+        }
+        Type::Struct { fields, .. } => {
+            for (_, t) in fields {
+                shift_type_node(t, delta);
+            }
+        }
+        Type::Enum { variants, .. } => {
+            for t in variants.iter_mut().flat_map(|(_, ts)| ts) {
+                shift_type_node(t, delta);
+            }
+        }
+        Type::Fn { params, ret } => {
+            for t in params {
+                shift_type_node(t, delta);
+            }
+            shift_type_node(ret, delta);
+        }
+        Type::I32 | Type::I64 | Type::U32 | Type::U64 | Type::F64 | Type::Bool | Type::Unit
+        | Type::String | Type::Char | Type::Named(_) | Type::TypeVar(_) | Type::Never => {}
+    }
+}
+
+fn shift_exprs(exprs: &mut [Spanned<Expr>], delta: isize) {
+    for e in exprs {
+        shift_expr(e, delta);
+    }
+}
+
+fn shift_expr(expr: &mut Spanned<Expr>, delta: isize) {
+    shift(&mut expr.span, delta);
+    match &mut expr.node {
+        Expr::IntLit(_) | Expr::FloatLit(_) | Expr::BoolLit(_) | Expr::StringLit(_) | Expr::CharLit(_)
+        | Expr::Unit | Expr::Var(_) | Expr::Continue | Expr::Ret | Expr::It | Expr::Todo { .. } => {}
+        Expr::Binary { left, right, .. } => {
+            shift_expr(left, delta);
+            shift_expr(right, delta);
+        }
+        Expr::Unary { expr, .. }
+        | Expr::Loop { body: expr }
+        | Expr::Assign { value: expr, .. }
+        | Expr::TupleField { expr, .. }
+        | Expr::Ref(expr)
+        | Expr::RefMut(expr)
+        | Expr::Deref(expr)
+        | Expr::StateRef { expr, .. } => shift_expr(expr, delta),
+        Expr::If { cond, then_branch, else_branch } => {
+            shift_expr(cond, delta);
+            shift_expr(then_branch, delta);
+            shift_expr(else_branch, delta);
+        }
+        Expr::Let { ty, value, body, .. } => {
+            if let Some(ty) = ty {
+                shift_type(ty, delta);
+            }
+            shift_expr(value, delta);
+            shift_expr(body, delta);
+        }
+        Expr::While { cond, invariant, body } => {
+            shift_expr(cond, delta);
+            if let Some(inv) = invariant {
+                shift_expr(inv, delta);
+            }
+            shift_expr(body, delta);
+        }
+        Expr::For { iter, body, .. } => {
+            shift_expr(iter, delta);
+            shift_expr(body, delta);
+        }
+        Expr::Break { value } | Expr::Return { value } => {
+            if let Some(v) = value {
+                shift_expr(v, delta);
+            }
+        }
+        Expr::Range { start, end, .. } => {
+            shift_expr(start, delta);
+            shift_expr(end, delta);
+        }
+        Expr::Call { args, .. }
+        | Expr::Block(args)
+        | Expr::EnumVariant { args, .. }
+        | Expr::ArrayLit(args)
+        | Expr::Tuple(args) => shift_exprs(args, delta),
+        Expr::StructInit { fields, .. } => {
+            for (name, value) in fields {
+                shift_name(name, delta);
+                shift_expr(value, delta);
+            }
+        }
+        Expr::FieldAccess { expr, field } => {
+            shift_expr(expr, delta);
+            shift_name(field, delta);
+        }
+        Expr::Match { expr, arms } => {
+            shift_expr(expr, delta);
+            for arm in arms {
+                shift_pattern(&mut arm.pattern, delta);
+                if let Some(guard) = &mut arm.guard {
+                    shift_expr(guard, delta);
+                }
+                shift_expr(&mut arm.body, delta);
+            }
+        }
+        Expr::Index { expr, index } => {
+            shift_expr(expr, delta);
+            shift_expr(index, delta);
+        }
+        Expr::MethodCall { receiver, args, .. } => {
+            shift_expr(receiver, delta);
+            shift_exprs(args, delta);
+        }
+        Expr::Closure { params, ret_ty, body } => {
+            for param in params {
+                shift_name(&mut param.name, delta);
+                if let Some(ty) = &mut param.ty {
+                    shift_type(ty, delta);
+                }
+            }
+            if let Some(ty) = ret_ty {
+                shift_type(ty, delta);
+            }
+            shift_expr(body, delta);
+        }
+        Expr::Forall { var, ty, body } | Expr::Exists { var, ty, body } => {
+            shift_name(var, delta);
+            shift_type(ty, delta);
+            shift_expr(body, delta);
+        }
+        Expr::Cast { expr, ty } => {
+            shift_expr(expr, delta);
+            shift_type(ty, delta);
+        }
+    }
+}
+
+fn shift_pattern(pattern: &mut Spanned<Pattern>, delta: isize) {
+    shift(&mut pattern.span, delta);
+    match &mut pattern.node {
+        Pattern::Wildcard | Pattern::Var(_) | Pattern::Literal(_) | Pattern::Range { .. } => {}
+        Pattern::EnumVariant { bindings: patterns, .. }
+        | Pattern::Or(patterns)
+        | Pattern::Tuple(patterns)
+        | Pattern::Array(patterns) => {
+            for p in patterns {
+                shift_pattern(p, delta);
+            }
+        }
+        Pattern::Struct { fields, .. } => {
+            for (name, p) in fields {
+                shift_name(name, delta);
+                shift_pattern(p, delta);
+            }
+        }
+        Pattern::Binding { pattern, .. } => shift_pattern(pattern, delta),
+        Pattern::ArrayRest { prefix, suffix } => {
+            for p in prefix.iter_mut().chain(suffix) {
+                shift_pattern(p, delta);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn sp<T>(node: T, start: usize, end: usize) -> Spanned<T> {
+        Spanned::new(node, Span::new(start, end))
+    }
+
+    #[test]
+    fn test_shift_fn_spans() {
+        // fn f(x: i64) -> i64 = x + 1;
+        let mut item = Item::FnDef(FnDef {
+            attributes: vec![],
+            visibility: Visibility::Private,
+            name: sp("f".into(), 3, 4),
+            type_params: vec![],
+            params: vec![Param { name: sp("x".into(), 5, 6), ty: sp(Type::I64, 8, 11) }],
+            ret_name: None,
+            ret_ty: sp(Type::I64, 16, 19),
+            pre: None,
+            post: None,
+            contracts: vec![],
+            body: sp(
+                Expr::Binary {
+                    left: Box::new(sp(Expr::Var("x".into()), 22, 23)),
+                    op: BinOp::Add,
+                    right: Box::new(sp(Expr::IntLit(1), 26, 27)),
+                },
+                22,
+                27,
+            ),
+            span: Span::new(0, 28),
+        });
+        item.shift_spans(10);
+        item.shift_spans(-4);
+        let Item::FnDef(f) = &item else { unreachable!() };
+        assert_eq!(f.span, Span::new(6, 34));
+        assert_eq!(f.name.span, Span::new(9, 10));
+        assert_eq!(f.params[0].ty.span, Span::new(14, 17));
+        let Expr::Binary { left, right, .. } = &f.body.node else { unreachable!() };
+        assert_eq!(left.span, Span::new(28, 29));
+        assert_eq!(right.span, Span::new(32, 33));
+    }
+}
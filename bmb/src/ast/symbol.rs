@@ -0,0 +1,175 @@
+//! Process-wide symbol interner
+//!
+//! Every distinct name is stored once and identified by a `Symbol`, which
+//! compares and hashes as a `u32` and is `Copy`. The table is shared by all
+//! threads, so modules parsed in parallel agree on ids; lookups of already
+//! interned names take only the read lock. Names are never freed: a
+//! compilation has a bounded set of them. Symbols serialize as their name,
+//! since ids differ between processes.
+
+use std::collections::HashMap;
+use std::fmt;
+use std::ops::Deref;
+use std::sync::{OnceLock, RwLock};
+
+use serde::{Deserialize, Deserializer, Serialize, Serializer};
+
+/// Interned name
+#[derive(Clone, Copy, PartialEq, Eq, Hash, PartialOrd, Ord)]
+pub struct Symbol(u32);
+
+impl Symbol {
+    pub const OPTION: Symbol = Symbol(0);
+    pub const SOME: Symbol = Symbol(1);
+    pub const NONE: Symbol = Symbol(2);
+    pub const RESULT: Symbol = Symbol(3);
+    pub const OK: Symbol = Symbol(4);
+    pub const ERR: Symbol = Symbol(5);
+
+    /// Intern `name`, returning its id
+    pub fn intern(name: &str) -> Symbol {
+        if let Some(sym) = Symbol::lookup(name) {
+            return sym;
+        }
+        let mut interner = interner().write().unwrap_or_else(|e| e.into_inner());
+        interner.insert(name)
+    }
+
+    /// Id of an already interned name
+    pub fn lookup(name: &str) -> Option<Symbol> {
+        interner().read().unwrap_or_else(|e| e.into_inner()).ids.get(name).copied()
+    }
+
+    pub fn as_str(self) -> &'static str {
+        interner().read().unwrap_or_else(|e| e.into_inner()).names[self.0 as usize]
+    }
+
+    /// Whether this id names `name` (without interning it)
+    pub fn is(self, name: &str) -> bool {
+        Symbol::lookup(name) == Some(self)
+    }
+
+    /// Dense index of the symbol (interning order)
+    pub fn index(self) -> u32 {
+        self.0
+    }
+}
+
+impl fmt::Debug for Symbol {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "{}", self.as_str())
+    }
+}
+
+impl fmt::Display for Symbol {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(self.as_str())
+    }
+}
+
+/// Names read as strings, so a `Symbol` goes wherever a `&str` does
+impl Deref for Symbol {
+    type Target = str;
+
+    fn deref(&self) -> &str {
+        self.as_str()
+    }
+}
+
+impl PartialEq<str> for Symbol {
+    fn eq(&self, other: &str) -> bool {
+        self.as_str() == other
+    }
+}
+
+impl PartialEq<&str> for Symbol {
+    fn eq(&self, other: &&str) -> bool {
+        self.as_str() == *other
+    }
+}
+
+impl PartialEq<String> for Symbol {
+    fn eq(&self, other: &String) -> bool {
+        self.as_str() == other
+    }
+}
+
+impl From<Symbol> for String {
+    fn from(sym: Symbol) -> String {
+        sym.as_str().to_string()
+    }
+}
+
+impl From<&str> for Symbol {
+    fn from(name: &str) -> Self {
+        Symbol::intern(name)
+    }
+}
+
+impl Serialize for Symbol {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        serializer.serialize_str(self.as_str())
+    }
+}
+
+impl<'de> Deserialize<'de> for Symbol {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        let name = String::deserialize(deserializer)?;
+        Ok(Symbol::intern(&name))
+    }
+}
+
+struct Interner {
+    ids: HashMap<&'static str, Symbol>,
+    names: Vec<&'static str>,
+}
+
+impl Interner {
+    fn insert(&mut self, name: &str) -> Symbol {
+        if let Some(&sym) = self.ids.get(name) {
+            return sym;
+        }
+        let name: &'static str = Box::leak(name.to_string().into_boxed_str());
+        let sym = Symbol(self.names.len() as u32);
+        self.names.push(name);
+        self.ids.insert(name, sym);
+        sym
+    }
+}
+
+fn interner() -> &'static RwLock<Interner> {
+    static INTERNER: OnceLock<RwLock<Interner>> = OnceLock::new();
+    INTERNER.get_or_init(|| {
+        let mut interner = Interner { ids: HashMap::new(), names: Vec::new() };
+        // Must match the `Symbol` constants
+        for name in ["Option", "Some", "None", "Result", "Ok", "Err"] {
+            interner.insert(name);
+        }
+        RwLock::new(interner)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_symbols_are_shared_across_threads() {
+        let ids: Vec<Symbol> = std::thread::scope(|s| {
+            let handles: Vec<_> = (0..4).map(|_| s.spawn(|| Symbol::intern("symbol_test_name"))).collect();
+            handles.into_iter().map(|h| h.join().unwrap()).collect()
+        });
+        assert!(ids.windows(2).all(|w| w[0] == w[1]));
+        assert_eq!(ids[0].as_str(), "symbol_test_name");
+        assert_eq!(Symbol::intern("Some"), Symbol::SOME);
+        assert!(Symbol::lookup("symbol_test_never_interned").is_none());
+    }
+
+    #[test]
+    fn test_symbols_serialize_as_names() {
+        let json = serde_json::to_string(&Symbol::intern("symbol_test_serde")).unwrap();
+        assert_eq!(json, "\"symbol_test_serde\"");
+        let sym: Symbol = serde_json::from_str(&json).unwrap();
+        assert!(sym.is("symbol_test_serde"));
+    }
+}
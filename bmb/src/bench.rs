@@ -0,0 +1,583 @@
+//! Native benchmark harness for `bmb bench`
+//!
+//! A benchmark is a directory under the suite root that contains
+//! `bmb/main.bmb` (the `tests/bench` layout) or a `bench.json` manifest
+//! naming another source, its arguments and a run cap. Every benchmark is
+//! compiled at `-O2` and `-O3`, run `warmup` times unmeasured and `runs`
+//! times measured, and summarized as median and p95 wall time, peak RSS and
+//! retired user-space instructions (counted in one extra run under
+//! `perf stat` when `perf` is available).
+//!
+//! Results are compared against the `benchmarks` section of a baseline file
+//! (`.github/workflows/performance-baseline.json` in CI) using the
+//! `bench_*_percent` thresholds stored next to it. Instruction counts are
+//! the stable signal; wall time and RSS get looser limits.
+
+use std::collections::BTreeMap;
+use std::path::{Path, PathBuf};
+use std::process::{Command, Stdio};
+use std::time::{Duration, Instant};
+
+use serde::{Deserialize, Serialize};
+
+use crate::build::{BuildConfig, OptLevel};
+
+/// Optimization levels every benchmark is measured at
+pub const OPT_LEVELS: [(&str, OptLevel); 2] = [("O2", OptLevel::Release), ("O3", OptLevel::Aggressive)];
+
+/// Wall-time differences below this are noise, whatever the percentage
+const TIME_NOISE_FLOOR_MS: f64 = 1.0;
+
+/// One benchmark program and how to run it
+#[derive(Debug, Clone, PartialEq)]
+pub struct BenchSpec {
+    /// Path of the benchmark directory relative to the suite root
+    pub name: String,
+    pub dir: PathBuf,
+    pub source: PathBuf,
+    /// Program arguments; `{dir}` and `{tmp}` are expanded when run
+    pub args: Vec<String>,
+    /// Upper bound on measured runs (for slow end-to-end benchmarks)
+    pub max_runs: Option<usize>,
+}
+
+/// Optional `bench.json` in a benchmark directory
+#[derive(Debug, Default, Deserialize)]
+struct Manifest {
+    /// Source file relative to the benchmark directory (default `bmb/main.bmb`)
+    source: Option<String>,
+    #[serde(default)]
+    args: Vec<String>,
+    max_runs: Option<usize>,
+}
+
+/// Find the benchmarks under `root`, sorted by name
+pub fn discover(root: &Path) -> Result<Vec<BenchSpec>, String> {
+    fn walk(root: &Path, dir: &Path, out: &mut Vec<BenchSpec>) -> Result<(), String> {
+        let manifest_path = dir.join("bench.json");
+        let default_source = dir.join("bmb").join("main.bmb");
+        if manifest_path.is_file() || default_source.is_file() {
+            let manifest: Manifest = if manifest_path.is_file() {
+                let text = std::fs::read_to_string(&manifest_path)
+                    .map_err(|e| format!("{}: {}", manifest_path.display(), e))?;
+                serde_json::from_str(&text).map_err(|e| format!("{}: {}", manifest_path.display(), e))?
+            } else {
+                Manifest::default()
+            };
+            let source = manifest.source.map(|s| dir.join(s)).unwrap_or(default_source);
+            if !source.is_file() {
+                return Err(format!("{}: source {} not found", dir.display(), source.display()));
+            }
+            let name = dir.strip_prefix(root).unwrap_or(dir).to_string_lossy().replace('\\', "/");
+            out.push(BenchSpec {
+                name: if name.is_empty() { ".".to_string() } else { name },
+                dir: dir.to_path_buf(),
+                source,
+                args: manifest.args,
+                max_runs: manifest.max_runs,
+            });
+            return Ok(());
+        }
+        let entries = std::fs::read_dir(dir).map_err(|e| format!("{}: {}", dir.display(), e))?;
+        for entry in entries.flatten() {
+            let path = entry.path();
+            if path.is_dir() {
+                walk(root, &path, out)?;
+            }
+        }
+        Ok(())
+    }
+
+    let mut specs = Vec::new();
+    walk(root, root, &mut specs)?;
+    specs.sort_by(|a, b| a.name.cmp(&b.name));
+    Ok(specs)
+}
+
+fn expand_arg(arg: &str, dir: &Path, tmp: &Path) -> String {
+    arg.replace("{dir}", &dir.to_string_lossy()).replace("{tmp}", &tmp.to_string_lossy())
+}
+
+/// One measured run
+#[derive(Debug, Clone, Copy)]
+pub struct Sample {
+    pub wall: Duration,
+    /// Peak resident set size in KiB (Linux only)
+    pub max_rss_kib: Option<u64>,
+}
+
+/// Run `exe` once with stdout discarded, timing it and collecting its peak RSS
+pub fn run_once(exe: &Path, args: &[String]) -> Result<Sample, String> {
+    let start = Instant::now();
+    let child = Command::new(exe)
+        .args(args)
+        .stdin(Stdio::null())
+        .stdout(Stdio::null())
+        .stderr(Stdio::piped())
+        .spawn()
+        .map_err(|e| format!("{}: {}", exe.display(), e))?;
+    let (status, max_rss_kib, stderr) = wait_with_rusage(child)?;
+    let wall = start.elapsed();
+    if !status.success() {
+        let detail = stderr.lines().last().unwrap_or("").trim().to_string();
+        return Err(format!("{} exited with {}{}", exe.display(), status,
+            if detail.is_empty() { String::new() } else { format!(": {}", detail) }));
+    }
+    Ok(Sample { wall, max_rss_kib })
+}
+
+/// Reap `child` with `wait4` so its `ru_maxrss` comes back with the status
+#[cfg(target_os = "linux")]
+fn wait_with_rusage(mut child: std::process::Child) -> Result<(std::process::ExitStatus, Option<u64>, String), String> {
+    use std::ffi::{c_int, c_long};
+    use std::io::Read;
+    use std::os::unix::process::ExitStatusExt;
+
+    #[repr(C)]
+    struct RUsage {
+        ru_utime: [c_long; 2],
+        ru_stime: [c_long; 2],
+        ru_maxrss: c_long,
+        rest: [c_long; 13],
+    }
+    unsafe extern "C" {
+        fn wait4(pid: c_int, status: *mut c_int, options: c_int, rusage: *mut RUsage) -> c_int;
+    }
+
+    // Drain stderr first so a chatty program cannot block on a full pipe
+    let mut stderr = String::new();
+    if let Some(mut pipe) = child.stderr.take() {
+        let _ = pipe.read_to_string(&mut stderr);
+    }
+    let pid = child.id() as c_int;
+    let mut status: c_int = 0;
+    let mut usage = RUsage { ru_utime: [0; 2], ru_stime: [0; 2], ru_maxrss: 0, rest: [0; 13] };
+    loop {
+        // SAFETY: `pid` is our unreaped child and both out-pointers are valid
+        let ret = unsafe { wait4(pid, &mut status, 0, &mut usage) };
+        if ret == pid {
+            break;
+        }
+        let err = std::io::Error::last_os_error();
+        if err.kind() != std::io::ErrorKind::Interrupted {
+            return Err(format!("wait4: {}", err));
+        }
+    }
+    Ok((std::process::ExitStatus::from_raw(status), Some(usage.ru_maxrss as u64), stderr))
+}
+
+#[cfg(not(target_os = "linux"))]
+fn wait_with_rusage(child: std::process::Child) -> Result<(std::process::ExitStatus, Option<u64>, String), String> {
+    let output = child.wait_with_output().map_err(|e| e.to_string())?;
+    Ok((output.status, None, String::from_utf8_lossy(&output.stderr).into_owned()))
+}
+
+/// Whether `perf stat` can be used for instruction counts
+pub fn perf_available() -> bool {
+    Command::new("perf")
+        .arg("--version")
+        .stdout(Stdio::null())
+        .stderr(Stdio::null())
+        .status()
+        .map(|s| s.success())
+        .unwrap_or(false)
+}
+
+/// Count retired user-space instructions of one run with `perf stat`
+pub fn count_instructions(exe: &Path, args: &[String], scratch: &Path) -> Option<u64> {
+    let report = scratch.join("perf-stat.csv");
+    let status = Command::new("perf")
+        .args(["stat", "-x", ",", "-e", "instructions:u", "-o"])
+        .arg(&report)
+        .arg("--")
+        .arg(exe)
+        .args(args)
+        .stdin(Stdio::null())
+        .stdout(Stdio::null())
+        .stderr(Stdio::null())
+        .status()
+        .ok()?;
+    let text = std::fs::read_to_string(&report).ok()?;
+    let _ = std::fs::remove_file(&report);
+    if !status.success() {
+        return None;
+    }
+    parse_perf_instructions(&text)
+}
+
+/// Extract the counter from `perf stat -x,` output (`<count>,,instructions:u,...`)
+fn parse_perf_instructions(text: &str) -> Option<u64> {
+    text.lines()
+        .filter(|line| line.contains(",instructions"))
+        .find_map(|line| line.split(',').next()?.trim().parse().ok())
+}
+
+/// Summary of one benchmark at one optimization level
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+pub struct Measurement {
+    pub median_ms: f64,
+    pub p95_ms: f64,
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub max_rss_kib: Option<u64>,
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub instructions: Option<u64>,
+}
+
+impl Measurement {
+    /// Summarize samples; RSS is the largest seen across runs
+    pub fn from_samples(samples: &[Sample], instructions: Option<u64>) -> Self {
+        let mut ms: Vec<f64> = samples.iter().map(|s| s.wall.as_secs_f64() * 1000.0).collect();
+        ms.sort_by(|a, b| a.total_cmp(b));
+        Self {
+            median_ms: round(median(&ms)),
+            p95_ms: round(percentile(&ms, 95.0)),
+            max_rss_kib: samples.iter().filter_map(|s| s.max_rss_kib).max(),
+            instructions,
+        }
+    }
+}
+
+fn round(ms: f64) -> f64 {
+    (ms * 1000.0).round() / 1000.0
+}
+
+/// Median of sorted values (mean of the middle pair for even counts)
+pub fn median(sorted: &[f64]) -> f64 {
+    match sorted.len() {
+        0 => 0.0,
+        n if n % 2 == 1 => sorted[n / 2],
+        n => (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0,
+    }
+}
+
+/// Nearest-rank percentile of sorted values
+pub fn percentile(sorted: &[f64], p: f64) -> f64 {
+    if sorted.is_empty() {
+        return 0.0;
+    }
+    let rank = ((p / 100.0) * sorted.len() as f64).ceil() as usize;
+    sorted[rank.clamp(1, sorted.len()) - 1]
+}
+
+/// Run settings for `bmb bench`
+#[derive(Debug, Clone)]
+pub struct BenchOptions {
+    pub runs: usize,
+    pub warmup: usize,
+    /// Count instructions with `perf stat` (one extra run per level)
+    pub instructions: bool,
+    pub verbose: bool,
+}
+
+/// Result of one benchmark at one optimization level
+#[derive(Debug, Clone)]
+pub struct BenchResult {
+    pub name: String,
+    pub opt: &'static str,
+    pub measurement: Measurement,
+}
+
+/// Build `spec` at every level in [`OPT_LEVELS`] and measure it
+pub fn run_benchmark(spec: &BenchSpec, options: &BenchOptions, work_dir: &Path) -> Result<Vec<BenchResult>, String> {
+    let scratch = work_dir.join(spec.name.replace(['/', '\\'], "_"));
+    std::fs::create_dir_all(&scratch).map_err(|e| format!("{}: {}", scratch.display(), e))?;
+    let args: Vec<String> = spec.args.iter().map(|a| expand_arg(a, &spec.dir, &scratch)).collect();
+    let runs = spec.max_runs.map_or(options.runs, |max| options.runs.min(max)).max(1);
+
+    let mut results = Vec::new();
+    for (opt, level) in OPT_LEVELS {
+        let exe = scratch.join(format!("main-{}{}", opt, std::env::consts::EXE_SUFFIX));
+        let config = BuildConfig::new(spec.source.clone())
+            .output(exe.clone())
+            .opt_level(level)
+            .cache(false)
+            .verbose(options.verbose);
+        crate::build::build(&config).map_err(|e| format!("{} (-{}): {}", spec.name, opt, e))?;
+
+        for _ in 0..options.warmup {
+            run_once(&exe, &args).map_err(|e| format!("{} (-{}): {}", spec.name, opt, e))?;
+        }
+        let samples = (0..runs)
+            .map(|_| run_once(&exe, &args))
+            .collect::<Result<Vec<_>, _>>()
+            .map_err(|e| format!("{} (-{}): {}", spec.name, opt, e))?;
+        let instructions = if options.instructions { count_instructions(&exe, &args, &scratch) } else { None };
+        results.push(BenchResult {
+            name: spec.name.clone(),
+            opt,
+            measurement: Measurement::from_samples(&samples, instructions),
+        });
+    }
+    Ok(results)
+}
+
+/// Allowed growth per metric before a result counts as a regression
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Thresholds {
+    pub median_percent: f64,
+    pub rss_percent: f64,
+    pub instructions_percent: f64,
+}
+
+impl Default for Thresholds {
+    fn default() -> Self {
+        Self { median_percent: 10.0, rss_percent: 10.0, instructions_percent: 2.0 }
+    }
+}
+
+/// Stored results: `benchmarks[name][opt]`
+pub type BaselineResults = BTreeMap<String, BTreeMap<String, Measurement>>;
+
+/// The benchmark part of a baseline file
+#[derive(Debug, Clone, Default)]
+pub struct Baseline {
+    pub thresholds: Thresholds,
+    pub benchmarks: BaselineResults,
+}
+
+/// Read thresholds and results from a baseline file; other keys are ignored
+pub fn load_baseline(path: &Path) -> Result<Baseline, String> {
+    let text = std::fs::read_to_string(path).map_err(|e| format!("{}: {}", path.display(), e))?;
+    let value: serde_json::Value = serde_json::from_str(&text).map_err(|e| format!("{}: {}", path.display(), e))?;
+    let defaults = Thresholds::default();
+    let limit = |key: &str, default: f64| value["thresholds"][key].as_f64().unwrap_or(default);
+    let benchmarks = match value.get("benchmarks") {
+        Some(b) => serde_json::from_value(b.clone()).map_err(|e| format!("{}: benchmarks: {}", path.display(), e))?,
+        None => BaselineResults::new(),
+    };
+    Ok(Baseline {
+        thresholds: Thresholds {
+            median_percent: limit("bench_median_percent", defaults.median_percent),
+            rss_percent: limit("bench_rss_percent", defaults.rss_percent),
+            instructions_percent: limit("bench_instructions_percent", defaults.instructions_percent),
+        },
+        benchmarks,
+    })
+}
+
+/// Merge `results` into the `benchmarks` section of a baseline file,
+/// keeping every other key (and benchmarks that were not run)
+pub fn save_baseline(path: &Path, results: &[BenchResult]) -> Result<(), String> {
+    let mut value: serde_json::Value = match std::fs::read_to_string(path) {
+        Ok(text) => serde_json::from_str(&text).map_err(|e| format!("{}: {}", path.display(), e))?,
+        Err(_) => serde_json::json!({}),
+    };
+    if !value.is_object() {
+        return Err(format!("{}: not a JSON object", path.display()));
+    }
+    let mut benchmarks: BaselineResults = value
+        .get("benchmarks")
+        .and_then(|b| serde_json::from_value(b.clone()).ok())
+        .unwrap_or_default();
+    for r in results {
+        benchmarks.entry(r.name.clone()).or_default().insert(r.opt.to_string(), r.measurement.clone());
+    }
+    value["benchmarks"] = serde_json::to_value(&benchmarks).map_err(|e| e.to_string())?;
+    value["benchmarks_measured_at"] = chrono::Local::now().format("%Y-%m-%d").to_string().into();
+    let defaults = Thresholds::default();
+    let thresholds = &mut value["thresholds"];
+    for (key, limit) in [
+        ("bench_median_percent", defaults.median_percent),
+        ("bench_rss_percent", defaults.rss_percent),
+        ("bench_instructions_percent", defaults.instructions_percent),
+    ] {
+        if thresholds.get(key).is_none() {
+            thresholds[key] = limit.into();
+        }
+    }
+    let text = serde_json::to_string_pretty(&value).map_err(|e| e.to_string())?;
+    std::fs::write(path, text + "\n").map_err(|e| format!("{}: {}", path.display(), e))
+}
+
+/// A metric that grew past its threshold
+#[derive(Debug, Clone, PartialEq)]
+pub struct Regression {
+    pub name: String,
+    pub opt: &'static str,
+    pub metric: &'static str,
+    pub baseline: f64,
+    pub current: f64,
+    pub limit_percent: f64,
+}
+
+impl Regression {
+    pub fn percent(&self) -> f64 {
+        change_percent(self.baseline, self.current)
+    }
+}
+
+fn change_percent(baseline: f64, current: f64) -> f64 {
+    if baseline == 0.0 { 0.0 } else { 100.0 * (current - baseline) / baseline }
+}
+
+/// Percent change of the median against the baseline, if there is one
+pub fn median_change(result: &BenchResult, baseline: &BaselineResults) -> Option<f64> {
+    let base = baseline.get(&result.name)?.get(result.opt)?;
+    Some(change_percent(base.median_ms, result.measurement.median_ms))
+}
+
+/// Compare results against a baseline; results without a baseline entry,
+/// and metrics missing on either side, are not checked
+pub fn compare(results: &[BenchResult], baseline: &Baseline) -> Vec<Regression> {
+    let t = baseline.thresholds;
+    let mut regressions = Vec::new();
+    for r in results {
+        let Some(base) = baseline.benchmarks.get(&r.name).and_then(|b| b.get(r.opt)) else { continue };
+        let cur = &r.measurement;
+        let mut check = |metric: &'static str, old: Option<f64>, new: Option<f64>, limit: f64, floor: f64| {
+            let (Some(old), Some(new)) = (old, new) else { return };
+            if new - old > floor && change_percent(old, new) > limit {
+                regressions.push(Regression {
+                    name: r.name.clone(),
+                    opt: r.opt,
+                    metric,
+                    baseline: old,
+                    current: new,
+                    limit_percent: limit,
+                });
+            }
+        };
+        check("median", Some(base.median_ms), Some(cur.median_ms), t.median_percent, TIME_NOISE_FLOOR_MS);
+        check("max RSS", base.max_rss_kib.map(|v| v as f64), cur.max_rss_kib.map(|v| v as f64), t.rss_percent, 0.0);
+        check(
+            "instructions",
+            base.instructions.map(|v| v as f64),
+            cur.instructions.map(|v| v as f64),
+            t.instructions_percent,
+            0.0,
+        );
+    }
+    regressions
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn temp_dir(tag: &str) -> PathBuf {
+        let dir = std::env::temp_dir().join(format!("bmb_bench_{}_{}", tag, std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        std::fs::create_dir_all(&dir).unwrap();
+        dir
+    }
+
+    fn result(name: &str, opt: &'static str, median_ms: f64, rss: u64, instructions: u64) -> BenchResult {
+        BenchResult {
+            name: name.to_string(),
+            opt,
+            measurement: Measurement {
+                median_ms,
+                p95_ms: median_ms,
+                max_rss_kib: Some(rss),
+                instructions: Some(instructions),
+            },
+        }
+    }
+
+    #[test]
+    fn test_discover_layout_and_manifest() {
+        let root = temp_dir("discover");
+        std::fs::create_dir_all(root.join("string/search/bmb")).unwrap();
+        std::fs::write(root.join("string/search/bmb/main.bmb"), "fn main() -> i64 = 0;").unwrap();
+        std::fs::create_dir_all(root.join("bootstrap/self")).unwrap();
+        std::fs::write(root.join("compiler.bmb"), "fn main() -> i64 = 0;").unwrap();
+        std::fs::write(
+            root.join("bootstrap/self/bench.json"),
+            r#"{"source": "../../compiler.bmb", "args": ["{dir}/x", "{tmp}/out.ll"], "max_runs": 2}"#,
+        )
+        .unwrap();
+
+        let specs = discover(&root).unwrap();
+        let names: Vec<&str> = specs.iter().map(|s| s.name.as_str()).collect();
+        assert_eq!(names, ["bootstrap/self", "string/search"]);
+        assert_eq!(specs[0].max_runs, Some(2));
+        assert!(specs[0].source.ends_with("compiler.bmb"));
+        assert_eq!(expand_arg(&specs[0].args[1], &specs[0].dir, Path::new("/t")), "/t/out.ll");
+        assert!(specs[1].source.ends_with("bmb/main.bmb"));
+
+        std::fs::write(root.join("bootstrap/self/bench.json"), r#"{"source": "missing.bmb"}"#).unwrap();
+        assert!(discover(&root).unwrap_err().contains("not found"));
+        let _ = std::fs::remove_dir_all(&root);
+    }
+
+    #[test]
+    fn test_median_and_percentile() {
+        assert_eq!(median(&[1.0, 2.0, 9.0]), 2.0);
+        assert_eq!(median(&[1.0, 2.0, 4.0, 9.0]), 3.0);
+        let values: Vec<f64> = (1..=20).map(f64::from).collect();
+        assert_eq!(percentile(&values, 95.0), 19.0);
+        assert_eq!(percentile(&values, 100.0), 20.0);
+        assert_eq!(percentile(&[7.0], 95.0), 7.0);
+
+        let samples: Vec<Sample> = [5u64, 1, 3]
+            .iter()
+            .map(|&ms| Sample { wall: Duration::from_millis(ms), max_rss_kib: Some(ms * 100) })
+            .collect();
+        let m = Measurement::from_samples(&samples, Some(42));
+        assert_eq!((m.median_ms, m.p95_ms, m.max_rss_kib, m.instructions), (3.0, 5.0, Some(500), Some(42)));
+    }
+
+    #[test]
+    fn test_parse_perf_output() {
+        let text = "# started on Mon\n\n123456789,,instructions:u,1000,100.00,,\n";
+        assert_eq!(parse_perf_instructions(text), Some(123456789));
+        assert_eq!(parse_perf_instructions("<not supported>,,instructions:u,0,100.00,,\n"), None);
+    }
+
+    #[test]
+    fn test_compare_applies_thresholds() {
+        let mut baseline = Baseline::default();
+        baseline.benchmarks.entry("a".into()).or_default().insert("O2".into(), result("a", "O2", 100.0, 1000, 1_000_000).measurement);
+        baseline.benchmarks.entry("b".into()).or_default().insert("O2".into(), result("b", "O2", 0.5, 1000, 1_000_000).measurement);
+
+        let results = [
+            // 5% slower, 3% more instructions, same RSS
+            result("a", "O2", 105.0, 1000, 1_030_000),
+            // tripled, but under the noise floor
+            result("b", "O2", 1.5, 1000, 1_000_000),
+            // no baseline entry
+            result("c", "O2", 500.0, 9000, 9_000_000),
+        ];
+        let regressions = compare(&results, &baseline);
+        assert_eq!(regressions.len(), 1, "{:?}", regressions);
+        assert_eq!((regressions[0].name.as_str(), regressions[0].metric), ("a", "instructions"));
+        assert!((regressions[0].percent() - 3.0).abs() < 1e-9);
+        assert_eq!(median_change(&results[0], &baseline.benchmarks).map(f64::round), Some(5.0));
+        assert_eq!(median_change(&results[2], &baseline.benchmarks), None);
+    }
+
+    #[test]
+    fn test_save_baseline_keeps_other_keys() {
+        let dir = temp_dir("baseline");
+        let path = dir.join("performance-baseline.json");
+        std::fs::write(
+            &path,
+            r#"{"gate": "4.1", "thresholds": {"regression_percent": 2, "bench_median_percent": 15},
+                "benchmarks": {"old": {"O2": {"median_ms": 1.0, "p95_ms": 1.0}}}}"#,
+        )
+        .unwrap();
+        save_baseline(&path, &[result("new", "O3", 20.0, 2048, 5)]).unwrap();
+
+        let value: serde_json::Value = serde_json::from_str(&std::fs::read_to_string(&path).unwrap()).unwrap();
+        assert_eq!(value["gate"], "4.1");
+        assert_eq!(value["thresholds"]["regression_percent"], 2);
+        let baseline = load_baseline(&path).unwrap();
+        assert_eq!(baseline.thresholds.median_percent, 15.0);
+        assert_eq!(baseline.thresholds.instructions_percent, Thresholds::default().instructions_percent);
+        assert!(baseline.benchmarks.contains_key("old"));
+        assert_eq!(baseline.benchmarks["new"]["O3"].max_rss_kib, Some(2048));
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn test_run_once_reports_status_and_rss() {
+        let sh = Path::new("/bin/sh");
+        let ok = run_once(sh, &["-c".to_string(), "exit 0".to_string()]).unwrap();
+        if cfg!(target_os = "linux") {
+            assert!(ok.max_rss_kib.unwrap_or(0) > 0);
+        }
+        let err = run_once(sh, &["-c".to_string(), "echo boom >&2; exit 3".to_string()]).unwrap_err();
+        assert!(err.contains("boom"), "{}", err);
+    }
+}
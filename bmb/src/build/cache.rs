@@ -0,0 +1,340 @@
+//! Incremental Build Cache
+//!
+//! Content-addressed store under `.bmb/cache` (beside `.bmb/index`):
+//!
+//! - `fn/<key>.json`: optimized MIR and emitted LLVM IR for one function,
+//!   keyed on its lowered MIR, the MIR of everything it transitively calls,
+//!   the optimization level and the target
+//! - `obj/<key>.o`: object file compiled from a complete IR module
+//! - `runtime/<key>.o`: prebuilt `runtime.c` per target and optimization level
+//!
+//! Keys cover every input of an artifact, so entries are never updated in
+//! place; a stale entry is simply never looked up again. Removing the
+//! directory is always safe.
+
+use std::collections::{BTreeSet, HashMap};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+use serde::{Deserialize, Serialize};
+
+use crate::mir::{MirFunction, MirInst, MirProgram};
+
+/// Bumped whenever the entry format or key derivation changes
+const CACHE_FORMAT: &str = "1";
+
+/// Stable 128-bit content hash (two independent FNV-1a lanes)
+///
+/// `std`'s hashers are not guaranteed stable across releases, so they
+/// cannot key anything that outlives the process.
+#[derive(Debug, Clone)]
+pub struct ContentHasher {
+    lo: u64,
+    hi: u64,
+}
+
+impl ContentHasher {
+    pub fn new() -> Self {
+        let mut hasher = Self { lo: 0xcbf2_9ce4_8422_2325, hi: 0x6c62_272e_07bb_0142 };
+        hasher.field(CACHE_FORMAT.as_bytes());
+        hasher.field(env!("CARGO_PKG_VERSION").as_bytes());
+        hasher
+    }
+
+    /// Hash one length-prefixed field, so ("ab", "c") and ("a", "bc") differ
+    pub fn field(&mut self, bytes: &[u8]) -> &mut Self {
+        self.raw(&(bytes.len() as u64).to_le_bytes());
+        self.raw(bytes);
+        self
+    }
+
+    fn raw(&mut self, bytes: &[u8]) {
+        for &b in bytes {
+            self.lo = (self.lo ^ b as u64).wrapping_mul(0x0000_0100_0000_01b3);
+            self.hi = (self.hi ^ b as u64).wrapping_mul(0x9e37_79b9_7f4a_7c15 | 1);
+        }
+    }
+
+    pub fn finish(&self) -> String {
+        format!("{:016x}{:016x}", self.hi, self.lo)
+    }
+}
+
+impl Default for ContentHasher {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Cached result of optimizing and emitting one function
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct FunctionEntry {
+    pub name: String,
+    /// MIR after the optimization pipeline
+    pub mir: MirFunction,
+    /// Emitted LLVM IR (text backend only)
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub ir: Option<String>,
+}
+
+/// Kinds of object file held by the cache
+#[derive(Debug, Clone, Copy)]
+pub enum ObjectKind {
+    /// Compiled program module
+    Module,
+    /// Compiled `runtime.c`
+    Runtime,
+}
+
+impl ObjectKind {
+    fn dir(self) -> &'static str {
+        match self {
+            ObjectKind::Module => "obj",
+            ObjectKind::Runtime => "runtime",
+        }
+    }
+}
+
+/// On-disk build cache rooted at a `.bmb/cache` directory
+#[derive(Debug)]
+pub struct BuildCache {
+    root: PathBuf,
+}
+
+impl BuildCache {
+    /// Open (lazily creating) the cache at `root`
+    pub fn open(root: impl Into<PathBuf>) -> Self {
+        Self { root: root.into() }
+    }
+
+    /// Default cache location for a build input: `$BMB_CACHE_DIR`, or
+    /// `.bmb/cache` in the directory containing the source file
+    pub fn default_root(input: &Path) -> PathBuf {
+        if let Ok(dir) = std::env::var("BMB_CACHE_DIR") {
+            return PathBuf::from(dir);
+        }
+        input
+            .parent()
+            .unwrap_or_else(|| Path::new("."))
+            .join(".bmb")
+            .join("cache")
+    }
+
+    pub fn root(&self) -> &Path {
+        &self.root
+    }
+
+    /// Compute the cache key of every function in `program`
+    ///
+    /// `profile` names everything outside the MIR that shapes the output
+    /// (optimization level, target triple). A function's key also covers
+    /// the lowered MIR of all functions it transitively calls, because the
+    /// program-level passes (pure CSE, const evaluation) and the emitted
+    /// call signatures depend on them.
+    pub fn function_keys(program: &MirProgram, profile: &str) -> HashMap<String, String> {
+        let own: HashMap<&str, String> = program
+            .functions
+            .iter()
+            .map(|f| {
+                let hash = ContentHasher::new().field(format!("{:?}", f).as_bytes()).finish();
+                (f.name.as_str(), hash)
+            })
+            .collect();
+
+        let callees: HashMap<&str, Vec<&str>> = program
+            .functions
+            .iter()
+            .map(|f| {
+                let calls = f
+                    .blocks
+                    .iter()
+                    .flat_map(|b| b.instructions.iter())
+                    .filter_map(|inst| match inst {
+                        MirInst::Call { func, .. } if own.contains_key(func.as_str()) => {
+                            Some(func.as_str())
+                        }
+                        _ => None,
+                    })
+                    .collect();
+                (f.name.as_str(), calls)
+            })
+            .collect();
+
+        program
+            .functions
+            .iter()
+            .map(|f| {
+                // Transitive callees, sorted so the key is order-independent
+                let mut reach: BTreeSet<&str> = BTreeSet::new();
+                let mut stack = vec![f.name.as_str()];
+                while let Some(name) = stack.pop() {
+                    for &callee in &callees[name] {
+                        if reach.insert(callee) {
+                            stack.push(callee);
+                        }
+                    }
+                }
+
+                let mut hasher = ContentHasher::new();
+                hasher.field(profile.as_bytes()).field(own[f.name.as_str()].as_bytes());
+                for dep in reach {
+                    hasher.field(dep.as_bytes()).field(own[dep].as_bytes());
+                }
+                (f.name.clone(), hasher.finish())
+            })
+            .collect()
+    }
+
+    /// Look up a function entry; unreadable or mismatched entries are misses
+    pub fn load_function(&self, key: &str) -> Option<FunctionEntry> {
+        let text = std::fs::read_to_string(self.function_path(key)).ok()?;
+        serde_json::from_str(&text).ok()
+    }
+
+    /// Store a function entry
+    pub fn store_function(&self, key: &str, entry: &FunctionEntry) -> std::io::Result<()> {
+        let json = serde_json::to_string(entry)
+            .map_err(|e| std::io::Error::new(std::io::ErrorKind::InvalidData, e))?;
+        self.write_atomic(&self.function_path(key), json.as_bytes())
+    }
+
+    /// Path of a cached object file, if present
+    pub fn lookup_object(&self, kind: ObjectKind, key: &str) -> Option<PathBuf> {
+        let path = self.object_path(kind, key);
+        path.exists().then_some(path)
+    }
+
+    /// Scratch path to compile an object into before `commit_object`
+    pub fn staging_path(&self, kind: ObjectKind, key: &str) -> std::io::Result<PathBuf> {
+        let dir = self.root.join(kind.dir());
+        std::fs::create_dir_all(&dir)?;
+        Ok(dir.join(Self::temp_name(key)))
+    }
+
+    /// Move a compiled object from its staging path into the cache
+    pub fn commit_object(&self, kind: ObjectKind, key: &str, staged: &Path) -> std::io::Result<PathBuf> {
+        let path = self.object_path(kind, key);
+        std::fs::rename(staged, &path)?;
+        Ok(path)
+    }
+
+    fn function_path(&self, key: &str) -> PathBuf {
+        self.root.join("fn").join(format!("{}.json", key))
+    }
+
+    fn object_path(&self, kind: ObjectKind, key: &str) -> PathBuf {
+        let ext = if cfg!(windows) { "obj" } else { "o" };
+        self.root.join(kind.dir()).join(format!("{}.{}", key, ext))
+    }
+
+    /// Write via a temporary file and rename, so concurrent builds never
+    /// observe a partially written entry
+    fn write_atomic(&self, path: &Path, bytes: &[u8]) -> std::io::Result<()> {
+        let dir = path.parent().unwrap_or(&self.root);
+        std::fs::create_dir_all(dir)?;
+        let key = path.file_stem().and_then(|s| s.to_str()).unwrap_or("entry");
+        let tmp = dir.join(Self::temp_name(key));
+        std::fs::write(&tmp, bytes)?;
+        std::fs::rename(&tmp, path)
+    }
+
+    fn temp_name(key: &str) -> String {
+        static COUNTER: AtomicUsize = AtomicUsize::new(0);
+        format!(
+            "{}.{}.{}.tmp",
+            key,
+            std::process::id(),
+            COUNTER.fetch_add(1, Ordering::Relaxed)
+        )
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::mir::{BasicBlock, Constant, MirType, Operand, Place, Terminator};
+
+    fn func(name: &str, calls: &[&str], ret: i64) -> MirFunction {
+        let instructions = calls
+            .iter()
+            .map(|c| MirInst::Call { dest: Some(Place::new("_t0")), func: c.to_string(), args: vec![] })
+            .collect();
+        MirFunction {
+            name: name.to_string(),
+            params: vec![],
+            ret_ty: MirType::I64,
+            locals: vec![],
+            blocks: vec![BasicBlock {
+                label: "entry".to_string(),
+                instructions,
+                terminator: Terminator::Return(Some(Operand::Constant(Constant::Int(ret)))),
+            }],
+            preconditions: vec![],
+            postconditions: vec![],
+            is_pure: false,
+            is_const: false,
+        }
+    }
+
+    fn program(functions: Vec<MirFunction>) -> MirProgram {
+        MirProgram { functions, extern_fns: vec![] }
+    }
+
+    #[test]
+    fn test_content_hash_fields_are_delimited() {
+        let a = ContentHasher::new().field(b"ab").field(b"c").finish();
+        let b = ContentHasher::new().field(b"a").field(b"bc").finish();
+        assert_ne!(a, b);
+        assert_eq!(a, ContentHasher::new().field(b"ab").field(b"c").finish());
+        assert_eq!(a.len(), 32);
+    }
+
+    #[test]
+    fn test_function_keys_track_transitive_callees() {
+        let before = program(vec![func("main", &["f"], 0), func("f", &["g"], 1), func("g", &[], 2), func("h", &[], 3)]);
+        let after = program(vec![func("main", &["f"], 0), func("f", &["g"], 1), func("g", &[], 20), func("h", &[], 3)]);
+
+        let k1 = BuildCache::function_keys(&before, "O2");
+        let k2 = BuildCache::function_keys(&after, "O2");
+
+        // g changed; f and main reach it through calls; h does not
+        assert_ne!(k1["g"], k2["g"]);
+        assert_ne!(k1["f"], k2["f"]);
+        assert_ne!(k1["main"], k2["main"]);
+        assert_eq!(k1["h"], k2["h"]);
+
+        // Profile is part of every key
+        let k3 = BuildCache::function_keys(&before, "O3");
+        assert_ne!(k1["h"], k3["h"]);
+    }
+
+    #[test]
+    fn test_function_keys_handle_recursion() {
+        let p = program(vec![func("even", &["odd"], 0), func("odd", &["even"], 1)]);
+        let keys = BuildCache::function_keys(&p, "O0");
+        assert_eq!(keys.len(), 2);
+        assert_ne!(keys["even"], keys["odd"]);
+    }
+
+    #[test]
+    fn test_cache_roundtrip() {
+        let root = std::env::temp_dir().join(format!("bmb_cache_test_{}", std::process::id()));
+        let cache = BuildCache::open(&root);
+
+        assert!(cache.load_function("k").is_none());
+        let entry = FunctionEntry { name: "g".to_string(), mir: func("g", &[], 2), ir: Some("define i64 @g()".to_string()) };
+        cache.store_function("k", &entry).unwrap();
+        let loaded = cache.load_function("k").unwrap();
+        assert_eq!(loaded.name, "g");
+        assert_eq!(loaded.ir.as_deref(), Some("define i64 @g()"));
+        assert_eq!(format!("{:?}", loaded.mir), format!("{:?}", entry.mir));
+
+        assert!(cache.lookup_object(ObjectKind::Runtime, "r").is_none());
+        let staged = cache.staging_path(ObjectKind::Runtime, "r").unwrap();
+        std::fs::write(&staged, b"obj").unwrap();
+        let path = cache.commit_object(ObjectKind::Runtime, "r", &staged).unwrap();
+        assert_eq!(cache.lookup_object(ObjectKind::Runtime, "r"), Some(path));
+
+        let _ = std::fs::remove_dir_all(&root);
+    }
+}
@@ -3,10 +3,11 @@
 //! This module orchestrates the full compilation pipeline:
 //! BMB Source → AST → MIR → LLVM IR → Object File → Executable
 
-use std::path::PathBuf;
+pub mod cache;
+
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
 
-#[cfg(feature = "llvm")]
-use std::path::Path;
 #[cfg(feature = "llvm")]
 use std::process::Command;
 
@@ -16,11 +17,16 @@ use crate::cfg::{CfgEvaluator, Target};
 use crate::codegen::CodeGenError;
 #[cfg(feature = "llvm")]
 use crate::codegen::CodeGen;
-use crate::mir::lower_program;
+use crate::mir::{lower_program, MirProgram};
 use crate::parser::parse;
 use crate::lexer::tokenize;
+use crate::profile::{Profiler, SpanKind};
 use crate::types::TypeChecker;
 
+use cache::{BuildCache, FunctionEntry};
+#[cfg(not(feature = "llvm"))]
+use cache::{ContentHasher, ObjectKind};
+
 /// Build configuration
 #[derive(Debug, Clone)]
 pub struct BuildConfig {
@@ -41,6 +47,20 @@ pub struct BuildConfig {
     /// Target triple for cross-compilation (v0.50.23)
     /// e.g., "x86_64-unknown-linux-gnu", "x86_64-pc-windows-msvc", "aarch64-apple-darwin"
     pub target_triple: Option<String>,
+    /// Reuse and update the incremental build cache (`.bmb/cache`)
+    pub cache: bool,
+    /// Worker threads for MIR optimization and IR emission (0 = all cores)
+    pub jobs: usize,
+    /// Link the runtime into the program module as LLVM bitcode before
+    /// code generation, so clang optimizes across the boundary
+    pub lto: bool,
+    /// Print per-phase and per-pass timings (`--time-passes`)
+    pub time_passes: bool,
+    /// Write a Chrome trace of the build to this file (`--trace`)
+    pub trace: Option<PathBuf>,
+    /// Call the runtime for vec/box allocation so BMB_RUNTIME_STATS
+    /// counts it (`--runtime-stats`)
+    pub runtime_stats: bool,
 }
 
 impl BuildConfig {
@@ -56,6 +76,12 @@ impl BuildConfig {
             verbose: false,
             target: Target::Native,
             target_triple: None,
+            cache: true,
+            jobs: 0,
+            lto: false,
+            time_passes: false,
+            trace: None,
+            runtime_stats: false,
         }
     }
 
@@ -94,6 +120,42 @@ impl BuildConfig {
         self.verbose = v;
         self
     }
+
+    /// Enable or disable the incremental build cache
+    pub fn cache(mut self, enabled: bool) -> Self {
+        self.cache = enabled;
+        self
+    }
+
+    /// Set the number of worker threads (0 = one per core)
+    pub fn jobs(mut self, n: usize) -> Self {
+        self.jobs = n;
+        self
+    }
+
+    /// Enable or disable link-time optimization with the runtime
+    pub fn lto(mut self, enabled: bool) -> Self {
+        self.lto = enabled;
+        self
+    }
+
+    /// Print a timing table for every phase and MIR pass after the build
+    pub fn time_passes(mut self, enabled: bool) -> Self {
+        self.time_passes = enabled;
+        self
+    }
+
+    /// Write a Chrome trace-event file of the build
+    pub fn trace(mut self, path: Option<PathBuf>) -> Self {
+        self.trace = path;
+        self
+    }
+
+    /// Route inlined vec/box allocation through the runtime's counters
+    pub fn runtime_stats(mut self, enabled: bool) -> Self {
+        self.runtime_stats = enabled;
+        self
+    }
 }
 
 /// Optimization level
@@ -146,6 +208,29 @@ pub type BuildResult<T> = Result<T, BuildError>;
 
 /// Build a BMB program
 pub fn build(config: &BuildConfig) -> BuildResult<()> {
+    let profiler = if config.time_passes || config.trace.is_some() {
+        Profiler::new()
+    } else {
+        Profiler::disabled()
+    };
+
+    let result = build_profiled(config, &profiler);
+
+    // Report even when the build failed: the phases that ran are still useful
+    if config.time_passes {
+        eprint!("{}", profiler.report());
+    }
+    if let Some(path) = &config.trace {
+        profiler.write_trace(path)?;
+        if config.verbose {
+            println!("  Wrote trace: {}", path.display());
+        }
+    }
+
+    result
+}
+
+fn build_profiled(config: &BuildConfig, profiler: &Profiler) -> BuildResult<()> {
     // Read source
     let source = std::fs::read_to_string(&config.input)?;
     let filename = config.input.display().to_string();
@@ -155,11 +240,17 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
     }
 
     // Tokenize
+    let mut span = profiler.span(SpanKind::Phase, "lex");
     let tokens = tokenize(&source).map_err(|e| BuildError::Parse(e.message().to_string()))?;
+    span.set_size(tokens.len());
+    span.finish();
 
     // Parse
+    let mut span = profiler.span(SpanKind::Phase, "parse");
     let program = parse(&filename, &source, tokens)
         .map_err(|e| BuildError::Parse(e.message().to_string()))?;
+    span.set_size(program.items.len());
+    span.finish();
 
     if config.verbose {
         println!("  Parsed {} items", program.items.len());
@@ -167,7 +258,7 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
 
     // v0.12.3: Filter items by @cfg attributes
     let cfg_eval = CfgEvaluator::new(config.target);
-    let program = cfg_eval.filter_program(&program);
+    let program = profiler.time(SpanKind::Phase, "cfg filter", || cfg_eval.filter_program(&program));
 
     if config.verbose {
         println!("  After @cfg filtering: {} items (target: {})",
@@ -175,22 +266,62 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
     }
 
     // Type check
+    let span = profiler.span(SpanKind::Phase, "type check");
     let mut type_checker = TypeChecker::new();
     type_checker
         .check_program(&program)
         .map_err(|e| BuildError::Type(format!("{:?}", e)))?;
+    span.finish();
 
     if config.verbose {
         println!("  Type check passed");
     }
 
     // Lower to MIR
+    let mut span = profiler.span(SpanKind::Phase, "MIR lowering");
     let mut mir = lower_program(&program);
+    if span.is_recording() {
+        span.set_size(mir_size(&mir));
+    }
+    span.finish();
+
+    // Functions run on the runtime thread pool must not race
+    crate::mir::race::check(&mir).map_err(|errors| {
+        BuildError::Type(errors.iter().map(|e| e.to_string()).collect::<Vec<_>>().join("\n"))
+    })?;
 
     if config.verbose {
         println!("  Generated MIR for {} functions", mir.functions.len());
     }
 
+    // Incremental build cache: look up every function by the hash of its
+    // lowered MIR, its transitive callees and the build profile
+    let cache = config.cache.then(|| BuildCache::open(BuildCache::default_root(&config.input)));
+    let profile = format!(
+        "{:?}/{}/{}{}",
+        config.opt_level,
+        config.target_triple.as_deref().unwrap_or("native"),
+        if cfg!(feature = "llvm") { "inkwell" } else { "text" },
+        if config.runtime_stats { "/runtime-stats" } else { "" }
+    );
+    let span = profiler.span(SpanKind::Phase, "cache lookup");
+    let keys = if cache.is_some() { BuildCache::function_keys(&mir, &profile) } else { HashMap::new() };
+    let mut hits: HashMap<String, FunctionEntry> = HashMap::new();
+    if let Some(cache) = &cache {
+        for func in &mir.functions {
+            if let Some(entry) = cache.load_function(&keys[&func.name])
+                && entry.name == func.name
+            {
+                hits.insert(func.name.clone(), entry);
+            }
+        }
+        if config.verbose {
+            println!("  Build cache: reused {}/{} functions ({})",
+                     hits.len(), mir.functions.len(), cache.root().display());
+        }
+    }
+    span.finish();
+
     // v0.29: Run MIR optimizations
     {
         use crate::mir::{OptimizationPipeline, OptLevel as MirOptLevel};
@@ -202,11 +333,29 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
             OptLevel::Aggressive => MirOptLevel::Aggressive,
         };
 
-        let pipeline = OptimizationPipeline::for_level(mir_opt_level);
-        let stats = pipeline.optimize(&mut mir);
+        let mut pipeline = OptimizationPipeline::for_level(mir_opt_level);
+        pipeline.set_jobs(config.jobs);
+        // Only the text backend implements stack vectors (vec_new_inline)
+        pipeline.set_stack_vectors(cfg!(not(feature = "llvm")));
+        let mut span = profiler.span(SpanKind::Phase, "MIR optimization");
+        let stats = pipeline.optimize_profiled(&mut mir, |f| hits.contains_key(&f.name), profiler);
 
         if config.verbose && !stats.pass_counts.is_empty() {
             println!("  MIR optimizations applied: {:?}", stats.pass_counts);
+            println!("  MIR optimization hits: {:?}", stats.hit_counts);
+            if stats.allocations_eliminated() > 0 {
+                println!("  Allocations eliminated: {}", stats.allocations_eliminated());
+            }
+        }
+
+        // Cached functions skipped the pipeline; swap in their optimized MIR
+        for func in &mut mir.functions {
+            if let Some(entry) = hits.get(&func.name) {
+                *func = entry.mir.clone();
+            }
+        }
+        if span.is_recording() {
+            span.set_size(mir_size(&mir));
         }
     }
 
@@ -215,6 +364,10 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
     {
         use crate::codegen::OptLevel as CodeGenOptLevel;
 
+        if let Some(cache) = &cache {
+            store_functions(cache, &keys, &mir, &hits, &HashMap::new(), config.verbose);
+        }
+
         let codegen_opt = match config.opt_level {
             OptLevel::Debug => CodeGenOptLevel::Debug,
             OptLevel::Release => CodeGenOptLevel::Release,
@@ -224,9 +377,16 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
 
         let codegen = CodeGen::with_opt_level(codegen_opt);
 
+        if config.lto && config.verbose {
+            println!("  LTO needs the text backend; linking the prebuilt runtime");
+        }
+
         if config.emit_ir {
             // Emit LLVM IR
+            let mut span = profiler.span(SpanKind::Phase, "LLVM IR emission");
             let ir = codegen.generate_ir(&mir)?;
+            span.set_size(ir.len());
+            span.finish();
             let ir_path = config.output.with_extension("ll");
             std::fs::write(&ir_path, ir)?;
             if config.verbose {
@@ -237,7 +397,7 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
 
         // Generate object file
         let obj_path = config.output.with_extension("o");
-        codegen.compile(&mir, &obj_path)?;
+        profiler.time(SpanKind::Phase, "LLVM codegen", || codegen.compile(&mir, &obj_path))?;
 
         if config.verbose {
             println!("  Generated object file: {}", obj_path.display());
@@ -245,7 +405,7 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
 
         // Link if building executable
         if matches!(config.output_type, OutputType::Executable) {
-            link_executable(&obj_path, &config.output, config.verbose)?;
+            profiler.time(SpanKind::Phase, "link", || link_executable(&obj_path, &config.output, config.verbose))?;
         }
 
         Ok(())
@@ -262,10 +422,24 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
             TextCodeGen::with_target(triple)
         } else {
             TextCodeGen::new()
-        };
-        let ir = codegen.generate(&mir).map_err(|_| BuildError::CodeGen(
+        }
+        .with_jobs(config.jobs)
+        .with_runtime_stats(config.runtime_stats);
+        let reuse: HashMap<String, String> = hits
+            .iter()
+            .filter_map(|(name, entry)| entry.ir.clone().map(|ir| (name.clone(), ir)))
+            .collect();
+        let mut span = profiler.span(SpanKind::Phase, "LLVM IR emission");
+        let (ir, function_ir) = codegen.generate_incremental(&mir, &reuse).map_err(|_| BuildError::CodeGen(
             CodeGenError::LlvmNotAvailable, // Use existing error type
         ))?;
+        span.set_size(ir.len());
+        span.finish();
+
+        if let Some(cache) = &cache {
+            let function_ir: HashMap<String, String> = function_ir.into_iter().collect();
+            store_functions(cache, &keys, &mir, &hits, &function_ir, config.verbose);
+        }
 
         let ir_path = config.output.with_extension("ll");
         std::fs::write(&ir_path, &ir)?;
@@ -289,10 +463,6 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
             println!("  Using runtime: {}", runtime_path.display());
         }
 
-        // Compile IR to object file with optimization
-        let obj_path = config.output.with_extension(if cfg!(windows) { "obj" } else { "o" });
-        let mut cmd = Command::new(&clang);
-
         // Apply optimization based on config
         let opt_flag = match config.opt_level {
             OptLevel::Debug => "-O0",
@@ -300,47 +470,109 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
             OptLevel::Size => "-Os",
             OptLevel::Aggressive => "-O3",
         };
+        let obj_ext = if cfg!(windows) { "obj" } else { "o" };
 
-        cmd.args([opt_flag, "-c", ir_path.to_str().unwrap(), "-o", obj_path.to_str().unwrap()]);
-
-        let output_result = cmd.output()?;
-        if !output_result.status.success() {
-            let stderr = String::from_utf8_lossy(&output_result.stderr);
-            return Err(BuildError::Linker(format!("clang compile failed: {}", stderr)));
-        }
+        // Compile runtime at the program's optimization level; the cache
+        // keeps one prebuilt object per runtime source, target and level.
+        // With LTO the runtime is kept as bitcode and merged into the module.
+        let compile_runtime = |out: &Path| -> BuildResult<()> {
+            let mut cmd = Command::new(&clang);
+            cmd.args([opt_flag, "-c", runtime_path.to_str().unwrap(), "-o", out.to_str().unwrap()]);
+            if config.lto {
+                cmd.arg("-emit-llvm");
+            }
 
-        if config.verbose {
-            println!("  Compiled to object file: {}", obj_path.display());
-        }
+            // Add Windows SDK include paths if on Windows
+            #[cfg(target_os = "windows")]
+            {
+                if let Some(include_paths) = find_windows_sdk_includes() {
+                    for path in include_paths {
+                        cmd.arg("-I").arg(path);
+                    }
+                }
+            }
 
-        // Compile runtime
-        let runtime_obj = config.output.with_file_name("runtime").with_extension(if cfg!(windows) { "obj" } else { "o" });
-        let mut cmd = Command::new(&clang);
-        cmd.args(["-c", runtime_path.to_str().unwrap(), "-o", runtime_obj.to_str().unwrap()]);
+            profiler.time(SpanKind::Phase, "clang runtime", || run_compiler(&mut cmd, "runtime compile"))
+        };
+        let runtime_key = ContentHasher::new()
+            .field(&std::fs::read(&runtime_path)?)
+            .field(opt_flag.as_bytes())
+            .field(config.target_triple.as_deref().unwrap_or("native").as_bytes())
+            .field(clang.as_bytes())
+            .field(if config.lto { "bitcode" } else { "object" }.as_bytes())
+            .finish();
+        let runtime_obj = match &cache {
+            Some(cache) => cached_object(cache, ObjectKind::Runtime, &runtime_key, compile_runtime, config.verbose)?,
+            None => {
+                let ext = if config.lto { "bc" } else { obj_ext };
+                let runtime_obj = config.output.with_file_name("runtime").with_extension(ext);
+                compile_runtime(&runtime_obj)?;
+                runtime_obj
+            }
+        };
 
-        // Add Windows SDK include paths if on Windows
-        #[cfg(target_os = "windows")]
-        {
-            if let Some(include_paths) = find_windows_sdk_includes() {
-                for path in include_paths {
-                    cmd.arg("-I").arg(path);
+        // Compile IR to object file with optimization; an identical module
+        // (e.g. after a comment-only edit) reuses the cached object. With
+        // LTO the runtime bitcode is linked in first, so the object already
+        // contains the runtime and clang can inline it into the program.
+        let llvm_link = if config.lto {
+            let llvm_link = find_llvm_link(&clang).map_err(BuildError::Linker)?;
+            if config.verbose {
+                println!("  LTO: merging runtime bitcode with {}", llvm_link);
+            }
+            Some(llvm_link)
+        } else {
+            None
+        };
+        let compile_ir = |out: &Path| -> BuildResult<()> {
+            let input = match &llvm_link {
+                Some(llvm_link) => {
+                    let merged = out.with_extension("bc");
+                    let mut cmd = Command::new(llvm_link);
+                    cmd.args([ir_path.to_str().unwrap(), runtime_obj.to_str().unwrap(), "-o", merged.to_str().unwrap()]);
+                    profiler.time(SpanKind::Phase, "llvm-link", || run_compiler(&mut cmd, "llvm-link"))?;
+                    merged
                 }
+                None => ir_path.clone(),
+            };
+            let mut cmd = Command::new(&clang);
+            cmd.args([opt_flag, "-c", input.to_str().unwrap(), "-o", out.to_str().unwrap()]);
+            let result = profiler.time(SpanKind::Phase, "clang module", || run_compiler(&mut cmd, "clang compile"));
+            if llvm_link.is_some() {
+                let _ = std::fs::remove_file(&input);
             }
-        }
+            result
+        };
+        let obj_path = match &cache {
+            Some(cache) => {
+                let mut key = ContentHasher::new();
+                key.field(ir.as_bytes()).field(opt_flag.as_bytes()).field(clang.as_bytes());
+                if config.lto {
+                    key.field(runtime_key.as_bytes());
+                }
+                cached_object(cache, ObjectKind::Module, &key.finish(), compile_ir, config.verbose)?
+            }
+            None => {
+                let obj_path = config.output.with_extension(obj_ext);
+                compile_ir(&obj_path)?;
+                obj_path
+            }
+        };
 
-        let output_result = cmd.output()?;
-        if !output_result.status.success() {
-            let stderr = String::from_utf8_lossy(&output_result.stderr);
-            return Err(BuildError::Linker(format!("runtime compile failed: {}", stderr)));
+        if config.verbose {
+            println!("  Compiled to object file: {}", obj_path.display());
         }
 
         // Link using lld-link on Windows (more reliable than clang auto-detection)
+        let span = profiler.span(SpanKind::Phase, "link");
         #[cfg(target_os = "windows")]
         {
             let mut cmd = Command::new("lld-link");
+            cmd.arg(obj_path.to_str().unwrap());
+            if !config.lto {
+                cmd.arg(runtime_obj.to_str().unwrap());
+            }
             cmd.args([
-                obj_path.to_str().unwrap(),
-                runtime_obj.to_str().unwrap(),
                 &format!("/OUT:{}", config.output.to_str().unwrap()),
                 "/SUBSYSTEM:CONSOLE",
                 "/ENTRY:mainCRTStartup",
@@ -376,12 +608,12 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
         #[cfg(not(target_os = "windows"))]
         {
             let mut cmd = Command::new(&clang);
-            cmd.args([
-                obj_path.to_str().unwrap(),
-                runtime_obj.to_str().unwrap(),
-                "-o",
-                config.output.to_str().unwrap(),
-            ]);
+            cmd.arg(obj_path.to_str().unwrap());
+            if !config.lto {
+                cmd.arg(runtime_obj.to_str().unwrap());
+            }
+            // The runtime's thread pool (spawn / parallel_for) uses pthreads
+            cmd.args(["-pthread", "-o", config.output.to_str().unwrap()]);
 
             let output_result = cmd.output()?;
             if !output_result.status.success() {
@@ -389,11 +621,14 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
                 return Err(BuildError::Linker(format!("link failed: {}", stderr)));
             }
         }
+        span.finish();
 
-        // Cleanup intermediate files
+        // Cleanup intermediate files (cached objects stay for the next build)
         let _ = std::fs::remove_file(&ir_path);
-        let _ = std::fs::remove_file(&obj_path);
-        let _ = std::fs::remove_file(&runtime_obj);
+        if cache.is_none() {
+            let _ = std::fs::remove_file(&obj_path);
+            let _ = std::fs::remove_file(&runtime_obj);
+        }
 
         if config.verbose {
             println!("  Created executable: {}", config.output.display());
@@ -403,6 +638,72 @@ pub fn build(config: &BuildConfig) -> BuildResult<()> {
     }
 }
 
+/// MIR size of the whole program, as reported by `--time-passes`
+fn mir_size(mir: &MirProgram) -> usize {
+    mir.functions
+        .iter()
+        .map(|f| f.blocks.iter().map(|b| b.instructions.len() + 1).sum::<usize>())
+        .sum()
+}
+
+/// Record freshly optimized functions, with their IR when the backend
+/// produced it, in the build cache. Failures only cost a future rebuild.
+fn store_functions(
+    cache: &BuildCache,
+    keys: &HashMap<String, String>,
+    mir: &MirProgram,
+    hits: &HashMap<String, FunctionEntry>,
+    function_ir: &HashMap<String, String>,
+    verbose: bool,
+) {
+    for func in mir.functions.iter().filter(|f| !hits.contains_key(&f.name)) {
+        let entry = FunctionEntry {
+            name: func.name.clone(),
+            mir: func.clone(),
+            ir: function_ir.get(&func.name).cloned(),
+        };
+        if let Err(e) = cache.store_function(&keys[&func.name], &entry)
+            && verbose
+        {
+            println!("  Build cache: could not store {}: {}", func.name, e);
+        }
+    }
+}
+
+/// Return the cached object for `key`, running `compile` into the cache on a miss
+#[cfg(not(feature = "llvm"))]
+fn cached_object(
+    cache: &BuildCache,
+    kind: ObjectKind,
+    key: &str,
+    compile: impl FnOnce(&Path) -> BuildResult<()>,
+    verbose: bool,
+) -> BuildResult<PathBuf> {
+    if let Some(path) = cache.lookup_object(kind, key) {
+        if verbose {
+            println!("  Build cache: reused {:?} object", kind);
+        }
+        return Ok(path);
+    }
+    let staged = cache.staging_path(kind, key)?;
+    if let Err(e) = compile(&staged) {
+        let _ = std::fs::remove_file(&staged);
+        return Err(e);
+    }
+    Ok(cache.commit_object(kind, key, &staged)?)
+}
+
+/// Run a clang invocation, mapping a non-zero exit to a linker error
+#[cfg(not(feature = "llvm"))]
+fn run_compiler(cmd: &mut std::process::Command, what: &str) -> BuildResult<()> {
+    let output_result = cmd.output()?;
+    if !output_result.status.success() {
+        let stderr = String::from_utf8_lossy(&output_result.stderr);
+        return Err(BuildError::Linker(format!("{} failed: {}", what, stderr)));
+    }
+    Ok(())
+}
+
 /// Find clang compiler
 fn find_clang() -> Result<String, String> {
     use std::process::Command;
@@ -427,6 +728,26 @@ fn find_clang() -> Result<String, String> {
     Err("clang not found. Please install LLVM/clang.".to_string())
 }
 
+/// Find llvm-link, preferring the one from clang's own LLVM install
+#[cfg(not(feature = "llvm"))]
+fn find_llvm_link(clang: &str) -> Result<String, String> {
+    use std::process::Command;
+
+    // `clang-17` pairs with `llvm-link-17`, `/opt/llvm/bin/clang` with `/opt/llvm/bin/llvm-link`
+    let exe = if cfg!(windows) { ".exe" } else { "" };
+    let paired = clang.trim_end_matches(".exe").replacen("clang", "llvm-link", 1);
+    let mut candidates = vec![format!("{}{}", paired, exe)];
+    candidates.extend(["llvm-link", "llvm-link-18", "llvm-link-17", "llvm-link-16", "llvm-link-15"].map(String::from));
+
+    for candidate in candidates {
+        if Command::new(&candidate).arg("--version").output().is_ok() {
+            return Ok(candidate);
+        }
+    }
+
+    Err("llvm-link not found; --lto needs the LLVM tools that match clang.".to_string())
+}
+
 /// Find runtime.c source file
 fn find_runtime_c() -> Result<std::path::PathBuf, String> {
     use std::path::PathBuf;
@@ -144,7 +144,7 @@ mod tests {
             args: vec![Spanned::new(
                 Expr::Binary {
                     left: Box::new(Spanned::new(
-                        Expr::Var("target".to_string()),
+                        Expr::Var("target".into()),
                         Span::new(4, 10),
                     )),
                     op: BinOp::Eq,
@@ -163,7 +163,7 @@ mod tests {
         FnDef {
             attributes: attrs,
             visibility: Visibility::Private,
-            name: Spanned::new(name.to_string(), Span::new(0, name.len())),
+            name: Spanned::new(name.into(), Span::new(0, name.len())),
             type_params: vec![],
             params: vec![],
             ret_name: None,
@@ -244,6 +244,11 @@ impl<'ctx> LlvmContext<'ctx> {
         let read_int_fn = self.module.add_function("bmb_read_int", read_int_type, None);
         self.functions.insert("read_int".to_string(), read_int_fn);
 
+        // flush() -> i64
+        let flush_type = i64_type.fn_type(&[], false);
+        let flush_fn = self.module.add_function("bmb_flush", flush_type, None);
+        self.functions.insert("flush".to_string(), flush_fn);
+
         // assert(bool) -> void
         let assert_type = void_type.fn_type(&[bool_type.into()], false);
         let assert_fn = self.module.add_function("bmb_assert", assert_type, None);
@@ -329,6 +334,20 @@ impl<'ctx> LlvmContext<'ctx> {
         let string_eq_fn = self.module.add_function("bmb_string_eq", string_eq_type, None);
         self.functions.insert("string_eq".to_string(), string_eq_fn);
 
+        // String search: str_find(ptr, ptr, i64), str_find_byte(ptr, i64, i64) -> i64
+        let str_find_type = i64_type.fn_type(&[ptr_type.into(), ptr_type.into(), i64_type.into()], false);
+        let str_find_fn = self.module.add_function("str_find", str_find_type, None);
+        self.functions.insert("str_find".to_string(), str_find_fn);
+        let str_find_byte_type = i64_type.fn_type(&[ptr_type.into(), i64_type.into(), i64_type.into()], false);
+        let str_find_byte_fn = self.module.add_function("str_find_byte", str_find_byte_type, None);
+        self.functions.insert("str_find_byte".to_string(), str_find_byte_fn);
+
+        // str_count_byte(ptr, i64) -> i64, str_starts_with(ptr, ptr) -> i64
+        let str_count_byte_fn = self.module.add_function("str_count_byte", byte_at_type, None);
+        self.functions.insert("str_count_byte".to_string(), str_count_byte_fn);
+        let str_starts_with_fn = self.module.add_function("str_starts_with", string_eq_type, None);
+        self.functions.insert("str_starts_with".to_string(), str_starts_with_fn);
+
         // v0.98: Vector functions
         // vec_new() -> i64 (returns pointer as i64)
         let vec_new_type = i64_type.fn_type(&[], false);
@@ -355,6 +374,10 @@ impl<'ctx> LlvmContext<'ctx> {
         let vec_get_fn = self.module.add_function("bmb_vec_get", vec_get_type, None);
         self.functions.insert("vec_get".to_string(), vec_get_fn);
 
+        // vec_get_unchecked(vec: i64, index: i64) -> i64 (bounds proven by contracts)
+        let vec_get_unchecked_fn = self.module.add_function("bmb_vec_get_unchecked", vec_get_type, None);
+        self.functions.insert("vec_get_unchecked".to_string(), vec_get_unchecked_fn);
+
         // vec_set(vec: i64, index: i64, value: i64) -> void
         let vec_set_type = void_type.fn_type(&[i64_type.into(), i64_type.into(), i64_type.into()], false);
         let vec_set_fn = self.module.add_function("bmb_vec_set", vec_set_type, None);
@@ -414,6 +437,16 @@ impl<'ctx> LlvmContext<'ctx> {
         let sb_push_fn = self.module.add_function("bmb_sb_push", sb_push_type, None);
         self.functions.insert("sb_push".to_string(), sb_push_fn);
 
+        // sb_push_char(handle: i64, c: i64) -> i64
+        let sb_push_char_type = i64_type.fn_type(&[i64_type.into(), i64_type.into()], false);
+        let sb_push_char_fn = self.module.add_function("bmb_sb_push_char", sb_push_char_type, None);
+        self.functions.insert("sb_push_char".to_string(), sb_push_char_fn);
+
+        // sb_push_int(handle: i64, n: i64) -> i64
+        let sb_push_int_type = i64_type.fn_type(&[i64_type.into(), i64_type.into()], false);
+        let sb_push_int_fn = self.module.add_function("bmb_sb_push_int", sb_push_int_type, None);
+        self.functions.insert("sb_push_int".to_string(), sb_push_int_fn);
+
         // sb_len(handle: i64) -> i64
         let sb_len_type = i64_type.fn_type(&[i64_type.into()], false);
         let sb_len_fn = self.module.add_function("bmb_sb_len", sb_len_type, None);
@@ -865,6 +898,7 @@ impl<'ctx> LlvmContext<'ctx> {
             Constant::String(_) => self.context.ptr_type(inkwell::AddressSpace::default()).into(),
             Constant::Unit => self.context.i8_type().into(),
             Constant::Char(_) => self.context.i32_type().into(),
+            Constant::FnRef(_) => self.context.ptr_type(inkwell::AddressSpace::default()).into(),
         }
     }
 
@@ -899,6 +933,13 @@ impl<'ctx> LlvmContext<'ctx> {
             Constant::Unit => self.context.i8_type().const_int(0, false).into(),
             // v0.95: Char as i32 Unicode code point
             Constant::Char(c) => self.context.i32_type().const_int(*c as u64, false).into(),
+            Constant::FnRef(name) => self
+                .functions
+                .get(name)
+                .expect("function reference to an undeclared function")
+                .as_global_value()
+                .as_pointer_value()
+                .into(),
         }
     }
 
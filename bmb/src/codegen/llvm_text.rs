@@ -31,10 +31,17 @@ pub enum TextCodeGenError {
 /// Result type for text code generation
 pub type TextCodeGenResult<T> = Result<T, TextCodeGenError>;
 
+/// Elements a stack vector (`vec_new_inline`) holds before spilling to the heap
+const VEC_INLINE_CAP: usize = 4;
+
 /// Text-based LLVM IR Generator
 pub struct TextCodeGen {
     /// Target triple (default: x86_64-pc-windows-msvc for Windows)
     target_triple: String,
+    /// Worker threads for per-function emission (0 = all cores)
+    jobs: usize,
+    /// Call the runtime for vec/box allocation instead of inlining malloc/free
+    runtime_stats: bool,
 }
 
 impl TextCodeGen {
@@ -42,6 +49,8 @@ impl TextCodeGen {
     pub fn new() -> Self {
         Self {
             target_triple: Self::default_target_triple(),
+            jobs: 1,
+            runtime_stats: false,
         }
     }
 
@@ -49,9 +58,26 @@ impl TextCodeGen {
     pub fn with_target(target: impl Into<String>) -> Self {
         Self {
             target_triple: target.into(),
+            jobs: 1,
+            runtime_stats: false,
         }
     }
 
+    /// Emit functions on `n` worker threads (0 = one per core); the module
+    /// text is the same for every job count
+    pub fn with_jobs(mut self, n: usize) -> Self {
+        self.jobs = n;
+        self
+    }
+
+    /// Route `vec_new`/`vec_with_capacity`/`vec_free` and `box_new_i64`/
+    /// `box_free_i64` through the runtime (`bmb_vec_new` etc.) so that
+    /// BMB_RUNTIME_STATS counts them; element access stays inline
+    pub fn with_runtime_stats(mut self, enabled: bool) -> Self {
+        self.runtime_stats = enabled;
+        self
+    }
+
     /// Get default target triple based on platform
     fn default_target_triple() -> String {
         #[cfg(target_os = "windows")]
@@ -74,6 +100,18 @@ impl TextCodeGen {
 
     /// Generate complete LLVM IR module as text
     pub fn generate(&self, program: &MirProgram) -> TextCodeGenResult<String> {
+        self.generate_incremental(program, &HashMap::new()).map(|(ir, _)| ir)
+    }
+
+    /// Generate the module, splicing in prebuilt IR for functions found in
+    /// `reuse` (keyed by function name) instead of re-emitting them.
+    /// Also returns each function's IR so the build cache can store it;
+    /// this is only sound because string globals are named by content.
+    pub fn generate_incremental(
+        &self,
+        program: &MirProgram,
+        reuse: &HashMap<String, String>,
+    ) -> TextCodeGenResult<(String, Vec<(String, String)>)> {
         let mut output = String::new();
 
         // Module header
@@ -97,83 +135,121 @@ impl TextCodeGen {
         // Runtime declarations
         self.emit_runtime_declarations(&mut output)?;
 
-        // Generate functions with string table and function type map
-        for func in &program.functions {
-            self.emit_function_with_strings(&mut output, func, &string_table, &fn_return_types)?;
+        // Generate functions with string table and function type map;
+        // each function is emitted into its own buffer, then concatenated
+        // in program order
+        let emitted = crate::parallel::map(&program.functions, self.jobs, |func| -> TextCodeGenResult<String> {
+            match reuse.get(&func.name) {
+                Some(ir) => Ok(ir.clone()),
+                None => {
+                    let mut ir = String::new();
+                    self.emit_function_with_strings(&mut ir, func, &string_table, &fn_return_types)?;
+                    Ok(ir)
+                }
+            }
+        });
+        let mut function_ir = Vec::with_capacity(program.functions.len());
+        for (func, ir) in program.functions.iter().zip(emitted) {
+            let ir = ir?;
+            output.push_str(&ir);
+            function_ir.push((func.name.clone(), ir));
         }
 
-        Ok(output)
+        Ok((output, function_ir))
     }
 
     /// Collect all string constants from the program
+    ///
+    /// Globals are named `.str.<hash>` after their content rather than by
+    /// discovery order, so a function's IR does not change when literals
+    /// are added elsewhere in the program.
     fn collect_string_constants(&self, program: &MirProgram) -> HashMap<String, String> {
         let mut table = HashMap::new();
-        let mut counter = 0;
+        let mut taken = std::collections::HashSet::new();
+        let mut intern = |s: &String| {
+            if table.contains_key(s) {
+                return;
+            }
+            let mut name = format!(".str.{:016x}", Self::fnv1a(s.as_bytes()));
+            let mut n = 0;
+            while !taken.insert(name.clone()) {
+                n += 1;
+                name = format!(".str.{:016x}.{}", Self::fnv1a(s.as_bytes()), n);
+            }
+            table.insert(s.clone(), name);
+        };
 
         for func in &program.functions {
             for block in &func.blocks {
                 for inst in &block.instructions {
-                    if let MirInst::Const { value: Constant::String(s), .. } = inst
-                        && !table.contains_key(s) {
-                            table.insert(s.clone(), format!(".str.{}", counter));
-                            counter += 1;
-                        }
+                    if let MirInst::Const { value: Constant::String(s), .. } = inst {
+                        intern(s);
+                    }
                     // Check for string constants in call arguments
                     if let MirInst::Call { args, .. } = inst {
                         for arg in args {
-                            if let Operand::Constant(Constant::String(s)) = arg
-                                && !table.contains_key(s) {
-                                    table.insert(s.clone(), format!(".str.{}", counter));
-                                    counter += 1;
-                                }
+                            if let Operand::Constant(Constant::String(s)) = arg {
+                                intern(s);
+                            }
                         }
                     }
                     // Check for string constants in phi values
                     if let MirInst::Phi { values, .. } = inst {
                         for (val, _label) in values {
-                            if let Operand::Constant(Constant::String(s)) = val
-                                && !table.contains_key(s) {
-                                    table.insert(s.clone(), format!(".str.{}", counter));
-                                    counter += 1;
-                                }
+                            if let Operand::Constant(Constant::String(s)) = val {
+                                intern(s);
+                            }
                         }
                     }
                     // Check for string constants in BinOp operands
                     if let MirInst::BinOp { lhs, rhs, .. } = inst {
                         for operand in [lhs, rhs] {
-                            if let Operand::Constant(Constant::String(s)) = operand
-                                && !table.contains_key(s) {
-                                    table.insert(s.clone(), format!(".str.{}", counter));
-                                    counter += 1;
-                                }
+                            if let Operand::Constant(Constant::String(s)) = operand {
+                                intern(s);
+                            }
                         }
                     }
                 }
                 // Check for string constants in Return terminator
-                if let Terminator::Return(Some(Operand::Constant(Constant::String(s)))) = &block.terminator
-                    && !table.contains_key(s) {
-                        table.insert(s.clone(), format!(".str.{}", counter));
-                        counter += 1;
-                    }
+                if let Terminator::Return(Some(Operand::Constant(Constant::String(s)))) = &block.terminator {
+                    intern(s);
+                }
             }
         }
 
         table
     }
 
+    /// 64-bit FNV-1a, used for content-derived global names
+    fn fnv1a(bytes: &[u8]) -> u64 {
+        bytes.iter().fold(0xcbf2_9ce4_8422_2325u64, |h, &b| {
+            (h ^ b as u64).wrapping_mul(0x0000_0100_0000_01b3)
+        })
+    }
+
     /// Emit string global constants
     fn emit_string_globals(&self, out: &mut String, table: &HashMap<String, String>) -> TextCodeGenResult<()> {
         if table.is_empty() {
             return Ok(());
         }
 
+        // Sorted so the module text is deterministic (the build cache keys
+        // object files on it)
+        let mut entries: Vec<(&String, &String)> = table.iter().collect();
+        entries.sort_by(|a, b| a.1.cmp(b.1));
+
         writeln!(out, "; String constants")?;
-        for (content, name) in table {
+        for (content, name) in entries {
             // Escape the string for LLVM IR
             let escaped = self.escape_string_for_llvm(content);
             let len = content.len() + 1; // +1 for null terminator
             writeln!(out, "@{} = private unnamed_addr constant [{} x i8] c\"{}\\00\"",
                      name, len, escaped)?;
+            // Static BmbString header {data, len, cap, owner} so a literal costs no
+            // allocation at runtime; cap 0 with owner pointing at the header itself
+            // marks it static (bmb_string_is_static in runtime.c)
+            writeln!(out, "@{}.hdr = private constant {{ ptr, i64, i64, ptr }} {{ ptr @{}, i64 {}, i64 0, ptr @{}.hdr }}",
+                     name, name, content.len(), name)?;
         }
         writeln!(out)?;
 
@@ -212,6 +288,7 @@ impl TextCodeGen {
         writeln!(out, "declare void @println(i64)")?;
         writeln!(out, "declare void @print(i64)")?;
         writeln!(out, "declare i64 @read_int()")?;
+        writeln!(out, "declare i64 @flush()")?;
         writeln!(out, "declare void @assert(i1)")?;
         writeln!(out, "declare i64 @bmb_abs(i64)")?;  // bmb_ prefix to avoid stdlib conflict
         writeln!(out, "declare i64 @min(i64, i64)")?;
@@ -239,6 +316,10 @@ impl TextCodeGen {
         writeln!(out, "declare i64 @bmb_file_exists(ptr)")?;
         writeln!(out, "declare i64 @bmb_file_size(ptr)")?;
         writeln!(out, "declare ptr @bmb_read_file(ptr)")?;
+        writeln!(out, "declare ptr @bmb_read_file_mapped(ptr)")?;
+        writeln!(out, "declare i64 @bmb_file_open(ptr)")?;
+        writeln!(out, "declare ptr @bmb_read_line(i64)")?;
+        writeln!(out, "declare i64 @bmb_file_close(i64)")?;
         writeln!(out, "declare i64 @bmb_write_file(ptr, ptr)")?;
         writeln!(out, "declare i64 @bmb_append_file(ptr, ptr)")?;
         writeln!(out)?;
@@ -247,11 +328,36 @@ impl TextCodeGen {
         writeln!(out, "; Runtime declarations - StringBuilder")?;
         writeln!(out, "declare i64 @bmb_sb_new()")?;
         writeln!(out, "declare i64 @bmb_sb_push(i64, ptr)")?;
+        writeln!(out, "declare i64 @bmb_sb_push_char(i64, i64)")?;
+        writeln!(out, "declare i64 @bmb_sb_push_int(i64, i64)")?;
         writeln!(out, "declare i64 @bmb_sb_len(i64)")?;
         writeln!(out, "declare ptr @bmb_sb_build(i64)")?;
         writeln!(out, "declare i64 @bmb_sb_clear(i64)")?;
         writeln!(out)?;
 
+        // String arena: region allocator backing every BmbString
+        writeln!(out, "; Runtime declarations - String arena")?;
+        writeln!(out, "declare i64 @bmb_arena_push()")?;
+        writeln!(out, "declare i64 @bmb_arena_pop()")?;
+        writeln!(out)?;
+
+        // Thread pool: tasks are `i64 (i64)` functions passed by address
+        writeln!(out, "; Runtime declarations - Thread pool")?;
+        writeln!(out, "declare i64 @bmb_spawn(ptr, i64)")?;
+        writeln!(out, "declare i64 @bmb_join(i64)")?;
+        writeln!(out, "declare i64 @bmb_parallel_for(i64, i64, ptr)")?;
+        writeln!(out)?;
+
+        if self.runtime_stats {
+            writeln!(out, "; Runtime declarations - Counted allocation (--runtime-stats)")?;
+            writeln!(out, "declare i64 @bmb_vec_new()")?;
+            writeln!(out, "declare i64 @bmb_vec_with_capacity(i64)")?;
+            writeln!(out, "declare void @bmb_vec_free(i64)")?;
+            writeln!(out, "declare i64 @bmb_box_new_i64(i64)")?;
+            writeln!(out, "declare void @bmb_box_free_i64(i64)")?;
+            writeln!(out)?;
+        }
+
         // Phase 32.3: Process execution runtime functions
         writeln!(out, "; Runtime declarations - Process execution")?;
         writeln!(out, "declare i64 @bmb_system(ptr)")?;
@@ -284,18 +390,61 @@ impl TextCodeGen {
         writeln!(out, "declare i64 @file_exists(ptr)")?;
         writeln!(out, "declare i64 @file_size(ptr)")?;
         writeln!(out, "declare ptr @read_file(ptr)")?;
+        writeln!(out, "declare ptr @read_file_mapped(ptr)")?;
+        writeln!(out, "declare i64 @file_open(ptr)")?;
+        writeln!(out, "declare ptr @read_line(i64)")?;
+        writeln!(out, "declare i64 @file_close(i64)")?;
         writeln!(out, "declare i64 @write_file(ptr, ptr)")?;
         writeln!(out, "declare i64 @append_file(ptr, ptr)")?;
         writeln!(out)?;
 
+        // String search (SIMD kernels in runtime.c)
+        writeln!(out, "declare i64 @str_find(ptr, ptr, i64)")?;
+        writeln!(out, "declare i64 @str_find_byte(ptr, i64, i64)")?;
+        writeln!(out, "declare i64 @str_count_byte(ptr, i64)")?;
+        writeln!(out, "declare i64 @str_starts_with(ptr, ptr)")?;
+        writeln!(out)?;
+
         // StringBuilder wrappers
         writeln!(out, "declare i64 @sb_new()")?;
         writeln!(out, "declare i64 @sb_push(i64, ptr)")?;
+        writeln!(out, "declare i64 @sb_push_char(i64, i64)")?;
+        writeln!(out, "declare i64 @sb_push_int(i64, i64)")?;
         writeln!(out, "declare i64 @sb_len(i64)")?;
         writeln!(out, "declare ptr @sb_build(i64)")?;
         writeln!(out, "declare i64 @sb_clear(i64)")?;
         writeln!(out)?;
 
+        // String arena wrappers
+        writeln!(out, "declare i64 @arena_push()")?;
+        writeln!(out, "declare i64 @arena_pop()")?;
+        writeln!(out)?;
+
+        // RFC-0007: Hash tables (Swiss-table layout in runtime.c; handles are pointers)
+        writeln!(out, "; Runtime declarations - HashMap / HashSet")?;
+        writeln!(out, "declare i64 @hash_i64(i64)")?;
+        writeln!(out, "declare i64 @hashmap_new()")?;
+        writeln!(out, "declare i64 @hashmap_insert(i64, i64, i64)")?;
+        writeln!(out, "declare i64 @hashmap_get(i64, i64)")?;
+        writeln!(out, "declare i64 @hashmap_contains(i64, i64)")?;
+        writeln!(out, "declare i64 @hashmap_remove(i64, i64)")?;
+        writeln!(out, "declare i64 @hashmap_len(i64)")?;
+        writeln!(out, "declare void @hashmap_free(i64)")?;
+        writeln!(out, "declare i64 @hashset_new()")?;
+        writeln!(out, "declare i64 @hashset_insert(i64, i64)")?;
+        writeln!(out, "declare i64 @hashset_contains(i64, i64)")?;
+        writeln!(out, "declare i64 @hashset_remove(i64, i64)")?;
+        writeln!(out, "declare i64 @hashset_len(i64)")?;
+        writeln!(out, "declare void @hashset_free(i64)")?;
+        writeln!(out, "declare i64 @strmap_new()")?;
+        writeln!(out, "declare i64 @strmap_insert(i64, ptr, i64)")?;
+        writeln!(out, "declare i64 @strmap_get(i64, ptr)")?;
+        writeln!(out, "declare i64 @strmap_contains(i64, ptr)")?;
+        writeln!(out, "declare i64 @strmap_remove(i64, ptr)")?;
+        writeln!(out, "declare i64 @strmap_len(i64)")?;
+        writeln!(out, "declare void @strmap_free(i64)")?;
+        writeln!(out)?;
+
         // v0.34: Math intrinsics for Phase 34.4 Benchmark Gate
         writeln!(out, "; Runtime declarations - Math intrinsics")?;
         writeln!(out, "declare double @llvm.sqrt.f64(double)")?;
@@ -309,6 +458,13 @@ impl TextCodeGen {
         writeln!(out, "declare ptr @calloc(i64, i64)")?;
         writeln!(out)?;
 
+        // Vector slow paths (runtime.c); the fast paths are emitted inline
+        writeln!(out, "; Runtime declarations - Vector slow paths")?;
+        writeln!(out, "declare void @bmb_vec_grow(ptr) cold")?;
+        writeln!(out, "declare void @bmb_vec_grow_inline(ptr) cold")?;
+        writeln!(out, "declare void @bmb_vec_index_oob(i64, i64) cold noreturn")?;
+        writeln!(out)?;
+
         Ok(())
     }
 
@@ -480,30 +636,6 @@ impl TextCodeGen {
             }
         }
 
-        // Build map for string constants in phi nodes
-        // Key: (dest_block, string_value, pred_block) -> temp_name
-        // String constants need to be wrapped with bmb_string_from_cstr before phi
-        let mut phi_string_map: std::collections::HashMap<(String, String, String), String> =
-            std::collections::HashMap::new();
-        let mut string_phi_counter = 0u32;
-
-        for block in &func.blocks {
-            for inst in &block.instructions {
-                if let MirInst::Phi { dest: _, values } = inst {
-                    for (val, pred_label) in values {
-                        if let Operand::Constant(Constant::String(s)) = val {
-                            let key = (block.label.clone(), s.clone(), pred_label.clone());
-                            phi_string_map.entry(key).or_insert_with(|| {
-                                let temp_name = format!("_str_phi_{}", string_phi_counter);
-                                string_phi_counter += 1;
-                                temp_name
-                            });
-                        }
-                    }
-                }
-            }
-        }
-
         // Collect local variable names for alloca-based handling
         // Using alloca avoids SSA dominance issues when locals are assigned in branches
         // Exclude: void-typed locals (can't allocate), phi destinations (they're SSA values)
@@ -513,9 +645,19 @@ impl TextCodeGen {
             .map(|(name, _)| name.clone())
             .collect();
 
+        // Stack vectors (escape analysis): header plus inline elements, one
+        // frame slot per vec_new_inline so loops reuse it
+        let inline_vecs: Vec<&str> = func.blocks.iter()
+            .flat_map(|b| b.instructions.iter())
+            .filter_map(|inst| match inst {
+                MirInst::Call { dest: Some(d), func: f, .. } if f == "vec_new_inline" => Some(d.name.as_str()),
+                _ => None,
+            })
+            .collect();
+
         // Emit entry block with allocas for local variables (excluding phi-referenced ones)
         // Use "alloca_entry" to avoid conflicts with user variables named "entry"
-        if !local_names.is_empty() {
+        if !local_names.is_empty() || !inline_vecs.is_empty() {
             writeln!(out, "alloca_entry:")?;
             for (name, ty) in &func.locals {
                 if local_names.contains(name) {
@@ -526,6 +668,9 @@ impl TextCodeGen {
                     }
                 }
             }
+            for name in &inline_vecs {
+                writeln!(out, "  %{}.vecbuf = alloca [{} x i64], align 8", name, 3 + VEC_INLINE_CAP)?;
+            }
             // Jump to the actual first block
             if let Some(first_block) = func.blocks.first() {
                 writeln!(out, "  br label %bb_{}", first_block.label)?;
@@ -534,7 +679,7 @@ impl TextCodeGen {
 
         // Emit basic blocks with place type information
         for block in &func.blocks {
-            self.emit_block_with_strings(out, block, func, string_table, fn_return_types, &place_types, &mut name_counts, &local_names, &phi_load_map, &phi_string_map)?;
+            self.emit_block_with_strings(out, block, func, string_table, fn_return_types, &place_types, &mut name_counts, &local_names, &phi_load_map)?;
         }
 
         writeln!(out, "}}")?;
@@ -557,8 +702,7 @@ impl TextCodeGen {
         let mut empty_name_counts = HashMap::new();
         let empty_local_names = std::collections::HashSet::new();
         let empty_phi_map = std::collections::HashMap::new();
-        let empty_phi_string_map = std::collections::HashMap::new();
-        self.emit_block_with_strings(out, block, func, &empty_str_table, &empty_fn_types, &empty_place_types, &mut empty_name_counts, &empty_local_names, &empty_phi_map, &empty_phi_string_map)
+        self.emit_block_with_strings(out, block, func, &empty_str_table, &empty_fn_types, &empty_place_types, &mut empty_name_counts, &empty_local_names, &empty_phi_map)
     }
 
     /// Emit a basic block with string table support
@@ -574,14 +718,44 @@ impl TextCodeGen {
         name_counts: &mut HashMap<String, u32>,
         local_names: &std::collections::HashSet<String>,
         phi_load_map: &std::collections::HashMap<(String, String, String), String>,
-        phi_string_map: &std::collections::HashMap<(String, String, String), String>,
     ) -> TextCodeGenResult<()> {
         // Use bb_ prefix to avoid collision with variable names
         writeln!(out, "bb_{}:", block.label)?;
 
         // Emit instructions (pass phi_load_map for phi node handling)
-        for inst in &block.instructions {
-            self.emit_instruction_with_strings(out, inst, func, string_table, fn_return_types, place_types, name_counts, local_names, phi_load_map, phi_string_map, &block.label)?;
+        // A tail call must be followed directly by its `ret`
+        let tail_call = self
+            .musttail_call(block, func, fn_return_types, place_types)
+            .filter(|_| !phi_load_map.keys().any(|(_, _, pred)| pred == &block.label));
+        let body = if tail_call.is_some() {
+            &block.instructions[..block.instructions.len() - 1]
+        } else {
+            &block.instructions[..]
+        };
+
+        for inst in body {
+            self.emit_instruction_with_strings(out, inst, func, string_table, fn_return_types, place_types, name_counts, local_names, phi_load_map)?;
+        }
+
+        if let Some((callee, args)) = tail_call {
+            let base = format!("{}.tail", block.label);
+            let args = self.emit_call_args(out, &base, args, func, string_table, place_types, local_names)?;
+            let ret_ty = self.mir_type_to_llvm(&func.ret_ty);
+            if ret_ty == "void" {
+                writeln!(out, "  musttail call void @{}({})", callee, args.join(", "))?;
+                writeln!(out, "  ret void")?;
+            } else {
+                writeln!(out, "  %{} = musttail call {} @{}({})", base, ret_ty, callee, args.join(", "))?;
+                writeln!(out, "  ret {} %{}", ret_ty, base)?;
+            }
+            return Ok(());
+        }
+
+        // Inline builtins that branch (vec_push, checked vec_get) leave us in a
+        // block of their own; end on a predictable label so successor phis can name it
+        if Self::block_is_split(block) {
+            writeln!(out, "  br label %bb_{}.exit", block.label)?;
+            writeln!(out, "bb_{}.exit:", block.label)?;
         }
 
         // Emit loads for locals that will be used in phi nodes of successor blocks
@@ -600,21 +774,154 @@ impl TextCodeGen {
             }
         }
 
-        // Emit bmb_string_from_cstr calls for string constants in phi nodes
-        // This must happen BEFORE the terminator
-        for ((_dest_block, string_val, pred_block), temp_name) in phi_string_map {
-            if pred_block == &block.label {
-                // Look up the global string constant name
-                if let Some(global_name) = string_table.get(string_val) {
-                    writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})", temp_name, global_name)?;
+        // Emit terminator
+        self.emit_terminator(out, &block.terminator, func, string_table, local_names)?;
+
+        Ok(())
+    }
+
+    /// Typed argument list of a call, loading locals from their allocas first
+    #[allow(clippy::too_many_arguments)]
+    fn emit_call_args(
+        &self,
+        out: &mut String,
+        call_base: &str,
+        args: &[Operand],
+        func: &MirFunction,
+        string_table: &HashMap<String, String>,
+        place_types: &HashMap<String, &'static str>,
+        local_names: &std::collections::HashSet<String>,
+    ) -> TextCodeGenResult<Vec<String>> {
+        let mut arg_vals = Vec::with_capacity(args.len());
+        for (i, arg) in args.iter().enumerate() {
+            let ty = self.operand_llvm_type(arg, func, place_types);
+
+            let val = match arg {
+                Operand::Place(p) if local_names.contains(&p.name) => {
+                    // Emit load from alloca (use call_base for uniqueness)
+                    let load_name = format!("{}.{}.arg{}", call_base, p.name, i);
+                    writeln!(out, "  %{} = load {}, ptr %{}.addr", load_name, ty, p.name)?;
+                    format!("%{}", load_name)
+                }
+                Operand::Constant(Constant::String(s)) => {
+                    // String constants are passed as their static BmbString global
+                    if let Some(global_name) = string_table.get(s) {
+                        let wrapper_name = format!("{}.strarg{}", call_base, i);
+                        writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr", wrapper_name, global_name)?;
+                        format!("%{}", wrapper_name)
+                    } else {
+                        self.format_operand_with_strings(arg, string_table)
+                    }
+                }
+                _ => self.format_operand_with_strings(arg, string_table),
+            };
+            arg_vals.push(format!("{} {}", ty, val));
+        }
+        Ok(arg_vals)
+    }
+
+    fn operand_llvm_type(
+        &self,
+        op: &Operand,
+        func: &MirFunction,
+        place_types: &HashMap<String, &'static str>,
+    ) -> &'static str {
+        match op {
+            Operand::Constant(c) => self.constant_type(c),
+            Operand::Place(p) => place_types.get(&p.name).copied().unwrap_or_else(|| self.infer_place_type(p, func)),
+        }
+    }
+
+    /// The user-function call ending `block` when the block returns its
+    /// result, caller and callee share a prototype and no argument points
+    /// into the caller's frame, so the call can be emitted as `musttail`
+    /// (MIR lowering puts tail calls in this shape)
+    fn musttail_call<'b>(
+        &self,
+        block: &'b BasicBlock,
+        func: &MirFunction,
+        fn_return_types: &HashMap<String, &'static str>,
+        place_types: &HashMap<String, &'static str>,
+    ) -> Option<(&'b str, &'b [Operand])> {
+        let Some(MirInst::Call { dest: Some(dest), func: callee, args }) = block.instructions.last() else {
+            return None;
+        };
+        let returns_result =
+            matches!(&block.terminator, Terminator::Return(Some(Operand::Place(p))) if p.name == dest.name);
+        let ret_ty = self.mir_type_to_llvm(&func.ret_ty);
+        let same_prototype = fn_return_types.get(callee) == Some(&ret_ty)
+            && args.len() == func.params.len()
+            && args
+                .iter()
+                .zip(&func.params)
+                .all(|(arg, (_, ty))| self.operand_llvm_type(arg, func, place_types) == self.mir_type_to_llvm(ty));
+        let eligible = returns_result && same_prototype && func.name != "main" && callee != "main"
+            && !Self::block_is_split(block);
+        if !eligible {
+            return None;
+        }
+        // A tail callee must not touch the caller's frame, which is gone by the
+        // time it runs
+        let frame = Self::frame_places(func);
+        (!args.iter().any(|arg| matches!(arg, Operand::Place(p) if frame.contains(p.name.as_str()))))
+            .then_some((callee.as_str(), args.as_slice()))
+    }
+
+    /// Places that point into the function's own stack frame: the allocas of
+    /// struct, enum, array and inline-vector values, and copies of them
+    fn frame_places(func: &MirFunction) -> std::collections::HashSet<&str> {
+        let insts = || func.blocks.iter().flat_map(|b| &b.instructions);
+        let mut frame: std::collections::HashSet<&str> = insts()
+            .filter_map(|inst| match inst {
+                MirInst::StructInit { dest, .. }
+                | MirInst::EnumVariant { dest, .. }
+                | MirInst::ArrayInit { dest, .. } => Some(dest.name.as_str()),
+                MirInst::Call { dest: Some(dest), func, .. } if func == "vec_new_inline" => Some(dest.name.as_str()),
+                _ => None,
+            })
+            .collect();
+        loop {
+            let before = frame.len();
+            for inst in insts() {
+                match inst {
+                    MirInst::Copy { dest, src } if frame.contains(src.name.as_str()) => {
+                        frame.insert(dest.name.as_str());
+                    }
+                    MirInst::Phi { dest, values }
+                        if values.iter().any(|(v, _)| matches!(v, Operand::Place(p) if frame.contains(p.name.as_str()))) =>
+                    {
+                        frame.insert(dest.name.as_str());
+                    }
+                    _ => {}
                 }
             }
+            if frame.len() == before {
+                return frame;
+            }
         }
+    }
 
-        // Emit terminator
-        self.emit_terminator(out, &block.terminator, func, string_table, local_names)?;
+    /// Whether emitting this block opens extra LLVM blocks (see emit_block_with_strings)
+    fn block_is_split(block: &BasicBlock) -> bool {
+        block.instructions.iter().any(|inst| {
+            matches!(inst, MirInst::Call { func, args, .. }
+                if (func == "vec_push" || func == "vec_push_inline" || func == "vec_get") && args.len() == 2)
+        })
+    }
 
-        Ok(())
+    /// LLVM label that control leaves MIR block `label` from
+    fn exit_label(func: &MirFunction, label: &str) -> String {
+        match func.blocks.iter().find(|b| b.label == label) {
+            Some(b) if Self::block_is_split(b) => format!("bb_{}.exit", label),
+            _ => format!("bb_{}", label),
+        }
+    }
+
+    /// Whether MIR block `label` does nothing but end in `unreachable`
+    fn is_unreachable_block(func: &MirFunction, label: &str) -> bool {
+        func.blocks.iter().any(|b| {
+            b.label == label && b.instructions.is_empty() && matches!(b.terminator, Terminator::Unreachable)
+        })
     }
 
     /// Get unique name for SSA definition, handling duplicates
@@ -641,8 +948,6 @@ impl TextCodeGen {
         name_counts: &mut HashMap<String, u32>,
         local_names: &std::collections::HashSet<String>,
         _phi_load_map: &std::collections::HashMap<(String, String, String), String>,
-        phi_string_map: &std::collections::HashMap<(String, String, String), String>,
-        current_block_label: &str,
     ) -> TextCodeGenResult<()> {
         match inst {
             MirInst::Const { dest, value } => {
@@ -667,7 +972,7 @@ impl TextCodeGen {
                         }
                         Constant::String(s) => {
                             if let Some(global_name) = string_table.get(s) {
-                                writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})",
+                                writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr",
                                          temp_name, global_name)?;
                             } else {
                                 writeln!(out, "  ; string constant not in table: {}", s)?;
@@ -678,6 +983,9 @@ impl TextCodeGen {
                         Constant::Char(c) => {
                             writeln!(out, "  %{} = add {} 0, {}", temp_name, ty, *c as u32)?;
                         }
+                        Constant::FnRef(name) => {
+                            writeln!(out, "  %{} = bitcast ptr @{} to ptr", temp_name, name)?;
+                        }
                     }
                     writeln!(out, "  store {} %{}, ptr %{}.addr", ty, temp_name, dest.name)?;
                 } else {
@@ -699,9 +1007,9 @@ impl TextCodeGen {
                             writeln!(out, "  %{} = add i8 0, 0", dest_name)?;
                         }
                         Constant::String(s) => {
-                            // Phase 32.3: String constants are loaded via bmb_string_from_cstr
+                            // String constants are static BmbString globals (see emit_string_globals)
                             if let Some(global_name) = string_table.get(s) {
-                                writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})",
+                                writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr",
                                          dest_name, global_name)?;
                             } else {
                                 // Fallback if string not in table (shouldn't happen)
@@ -712,6 +1020,9 @@ impl TextCodeGen {
                         Constant::Char(c) => {
                             writeln!(out, "  %{} = add {} 0, {}", dest_name, ty, *c as u32)?;
                         }
+                        Constant::FnRef(name) => {
+                            writeln!(out, "  %{} = bitcast ptr @{} to ptr", dest_name, name)?;
+                        }
                     }
                 }
             }
@@ -789,18 +1100,18 @@ impl TextCodeGen {
 
                 // String concatenation: either operand is ptr with Add op
                 if (lhs_ty == "ptr" || rhs_ty == "ptr") && *op == MirBinOp::Add {
-                    // Wrap string constant operands with bmb_string_from_cstr
+                    // String constant operands refer to their static BmbString global
                     let lhs_final = if let Operand::Constant(Constant::String(s)) = lhs {
                         if let Some(global_name) = string_table.get(s) {
                             let wrapper_name = format!("{}.lhs.str", dest_name);
-                            writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})", wrapper_name, global_name)?;
+                            writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr", wrapper_name, global_name)?;
                             format!("%{}", wrapper_name)
                         } else { lhs_str.clone() }
                     } else { lhs_str.clone() };
                     let rhs_final = if let Operand::Constant(Constant::String(s)) = rhs {
                         if let Some(global_name) = string_table.get(s) {
                             let wrapper_name = format!("{}.rhs.str", dest_name);
-                            writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})", wrapper_name, global_name)?;
+                            writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr", wrapper_name, global_name)?;
                             format!("%{}", wrapper_name)
                         } else { rhs_str.clone() }
                     } else { rhs_str.clone() };
@@ -812,18 +1123,18 @@ impl TextCodeGen {
                         writeln!(out, "  store ptr %{}, ptr %{}.addr", dest_name, dest.name)?;
                     }
                 } else if (lhs_ty == "ptr" || rhs_ty == "ptr") && *op == MirBinOp::Eq {
-                    // Wrap string constant operands with bmb_string_from_cstr
+                    // String constant operands refer to their static BmbString global
                     let lhs_final = if let Operand::Constant(Constant::String(s)) = lhs {
                         if let Some(global_name) = string_table.get(s) {
                             let wrapper_name = format!("{}.lhs.str", dest_name);
-                            writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})", wrapper_name, global_name)?;
+                            writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr", wrapper_name, global_name)?;
                             format!("%{}", wrapper_name)
                         } else { lhs_str.clone() }
                     } else { lhs_str.clone() };
                     let rhs_final = if let Operand::Constant(Constant::String(s)) = rhs {
                         if let Some(global_name) = string_table.get(s) {
                             let wrapper_name = format!("{}.rhs.str", dest_name);
-                            writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})", wrapper_name, global_name)?;
+                            writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr", wrapper_name, global_name)?;
                             format!("%{}", wrapper_name)
                         } else { rhs_str.clone() }
                     } else { rhs_str.clone() };
@@ -838,18 +1149,18 @@ impl TextCodeGen {
                         writeln!(out, "  store i1 %{}, ptr %{}.addr", dest_name, dest.name)?;
                     }
                 } else if (lhs_ty == "ptr" || rhs_ty == "ptr") && *op == MirBinOp::Ne {
-                    // Wrap string constant operands with bmb_string_from_cstr
+                    // String constant operands refer to their static BmbString global
                     let lhs_final = if let Operand::Constant(Constant::String(s)) = lhs {
                         if let Some(global_name) = string_table.get(s) {
                             let wrapper_name = format!("{}.lhs.str", dest_name);
-                            writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})", wrapper_name, global_name)?;
+                            writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr", wrapper_name, global_name)?;
                             format!("%{}", wrapper_name)
                         } else { lhs_str.clone() }
                     } else { lhs_str.clone() };
                     let rhs_final = if let Operand::Constant(Constant::String(s)) = rhs {
                         if let Some(global_name) = string_table.get(s) {
                             let wrapper_name = format!("{}.rhs.str", dest_name);
-                            writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})", wrapper_name, global_name)?;
+                            writeln!(out, "  %{} = bitcast ptr @{}.hdr to ptr", wrapper_name, global_name)?;
                             format!("%{}", wrapper_name)
                         } else { rhs_str.clone() }
                     } else { rhs_str.clone() };
@@ -1054,7 +1365,7 @@ impl TextCodeGen {
                 }
 
                 // v0.34.2: box_new_i64(value) -> i64 - allocates 8 bytes and stores value
-                if fn_name == "box_new_i64" && args.len() == 1 {
+                if fn_name == "box_new_i64" && args.len() == 1 && !self.runtime_stats {
                     // Get value argument
                     let val_val = match &args[0] {
                         Operand::Place(p) if local_names.contains(&p.name) => {
@@ -1087,7 +1398,7 @@ impl TextCodeGen {
                 }
 
                 // v0.34.2: box_free_i64(ptr) -> Unit - frees memory (alias for free)
-                if fn_name == "box_free_i64" && args.len() == 1 {
+                if fn_name == "box_free_i64" && args.len() == 1 && !self.runtime_stats {
                     // Get pointer argument
                     let ptr_val = match &args[0] {
                         Operand::Place(p) if local_names.contains(&p.name) => {
@@ -1169,7 +1480,7 @@ impl TextCodeGen {
 
                 // v0.34.2.3: Vec<i64> dynamic array builtins (RFC-0007)
                 // vec_new() -> i64: allocate header (24 bytes) with zeroed ptr/len/cap
-                if fn_name == "vec_new" && args.is_empty() {
+                if fn_name == "vec_new" && args.is_empty() && !self.runtime_stats {
                     let vec_idx = *name_counts.entry("vec_new".to_string()).or_insert(0);
                     *name_counts.get_mut("vec_new").unwrap() += 1;
                     // Call malloc(24) for header
@@ -1199,8 +1510,35 @@ impl TextCodeGen {
                     return Ok(());
                 }
 
+                // vec_new_inline() -> i64: stack vector from escape analysis; the
+                // header points at the inline elements that follow it
+                if fn_name == "vec_new_inline" && args.is_empty() {
+                    if let Some(d) = dest {
+                        let header_ptr = format!("{}.vecbuf", d.name);
+                        let inline_ptr = format!("{}.vecbuf.data", d.name);
+                        let inline_i64 = format!("{}.vecbuf.data.int", d.name);
+                        let len_ptr = format!("{}.vecbuf.len", d.name);
+                        let cap_ptr = format!("{}.vecbuf.cap", d.name);
+                        writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 3", inline_ptr, header_ptr)?;
+                        writeln!(out, "  %{} = ptrtoint ptr %{} to i64", inline_i64, inline_ptr)?;
+                        writeln!(out, "  store i64 %{}, ptr %{}", inline_i64, header_ptr)?;
+                        writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 1", len_ptr, header_ptr)?;
+                        writeln!(out, "  store i64 0, ptr %{}", len_ptr)?;
+                        writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 2", cap_ptr, header_ptr)?;
+                        writeln!(out, "  store i64 {}, ptr %{}", VEC_INLINE_CAP, cap_ptr)?;
+                        if local_names.contains(&d.name) {
+                            let conv_name = format!("{}.vecbuf.conv", d.name);
+                            writeln!(out, "  %{} = ptrtoint ptr %{} to i64", conv_name, header_ptr)?;
+                            writeln!(out, "  store i64 %{}, ptr %{}.addr", conv_name, d.name)?;
+                        } else {
+                            writeln!(out, "  %{} = ptrtoint ptr %{} to i64", d.name, header_ptr)?;
+                        }
+                    }
+                    return Ok(());
+                }
+
                 // vec_with_capacity(cap) -> i64: allocate header + data array
-                if fn_name == "vec_with_capacity" && args.len() == 1 {
+                if fn_name == "vec_with_capacity" && args.len() == 1 && !self.runtime_stats {
                     let vec_idx = *name_counts.entry("vec_cap_alloc".to_string()).or_insert(0);
                     *name_counts.get_mut("vec_cap_alloc").unwrap() += 1;
                     // Get capacity argument
@@ -1307,7 +1645,9 @@ impl TextCodeGen {
                 }
 
                 // vec_get(vec, index) -> i64: read data[index]
-                if fn_name == "vec_get" && args.len() == 2 {
+                // Bounds-checked against header[1]; vec_get_unchecked (produced by
+                // ContractBasedOptimization when pre proves 0 <= index < vec_len) skips the check
+                if (fn_name == "vec_get" || fn_name == "vec_get_unchecked") && args.len() == 2 {
                     let vec_idx = *name_counts.entry("vec_get".to_string()).or_insert(0);
                     *name_counts.get_mut("vec_get").unwrap() += 1;
                     let vec_val = match &args[0] {
@@ -1329,6 +1669,22 @@ impl TextCodeGen {
                     // Get header and data pointer
                     let header_ptr = format!("vec.get.header.{}", vec_idx);
                     writeln!(out, "  %{} = inttoptr i64 {} to ptr", header_ptr, vec_val)?;
+                    if fn_name == "vec_get" {
+                        // Unsigned compare covers both index < 0 and index >= len
+                        let len_ptr = format!("vec.get.len.ptr.{}", vec_idx);
+                        writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 1", len_ptr, header_ptr)?;
+                        let len_val = format!("vec.get.len.{}", vec_idx);
+                        writeln!(out, "  %{} = load i64, ptr %{}", len_val, len_ptr)?;
+                        let oob = format!("vec.get.oob.{}", vec_idx);
+                        writeln!(out, "  %{} = icmp uge i64 {}, %{}", oob, idx_val, len_val)?;
+                        let oob_label = format!("vec.get.fail.{}", vec_idx);
+                        let ok_label = format!("vec.get.ok.{}", vec_idx);
+                        writeln!(out, "  br i1 %{}, label %{}, label %{}", oob, oob_label, ok_label)?;
+                        writeln!(out, "{}:", oob_label)?;
+                        writeln!(out, "  call void @bmb_vec_index_oob(i64 {}, i64 %{})", idx_val, len_val)?;
+                        writeln!(out, "  unreachable")?;
+                        writeln!(out, "{}:", ok_label)?;
+                    }
                     let data_i64 = format!("vec.get.data.i64.{}", vec_idx);
                     writeln!(out, "  %{} = load i64, ptr %{}", data_i64, header_ptr)?;
                     let data_ptr = format!("vec.get.data.ptr.{}", vec_idx);
@@ -1392,8 +1748,11 @@ impl TextCodeGen {
                 }
 
                 // vec_push(vec, value) -> Unit: append with auto-grow
-                // This is complex - generates inline growth logic
-                if fn_name == "vec_push" && args.len() == 2 {
+                // Inline fast path; growth calls the cold bmb_vec_grow in the runtime
+                // (bmb_vec_grow_inline for stack vectors, which moves the inline
+                // elements to the heap on the first spill)
+                if (fn_name == "vec_push" || fn_name == "vec_push_inline") && args.len() == 2 {
+                    let grow_fn = if fn_name == "vec_push" { "bmb_vec_grow" } else { "bmb_vec_grow_inline" };
                     let vec_idx = *name_counts.entry("vec_push".to_string()).or_insert(0);
                     *name_counts.get_mut("vec_push").unwrap() += 1;
                     let vec_val = match &args[0] {
@@ -1417,14 +1776,12 @@ impl TextCodeGen {
                     let header_ptr = format!("vp.header.{}", vec_idx);
                     writeln!(out, "  %{} = inttoptr i64 {} to ptr", header_ptr, vec_val)?;
 
-                    // Load current ptr, len, cap
-                    let ptr_i64 = format!("vp.ptr.{}", vec_idx);
+                    // Load current len, cap
                     let len_ptr = format!("vp.len.ptr.{}", vec_idx);
                     let len_val = format!("vp.len.{}", vec_idx);
                     let cap_ptr = format!("vp.cap.ptr.{}", vec_idx);
                     let cap_val = format!("vp.cap.{}", vec_idx);
 
-                    writeln!(out, "  %{} = load i64, ptr %{}", ptr_i64, header_ptr)?;
                     writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 1", len_ptr, header_ptr)?;
                     writeln!(out, "  %{} = load i64, ptr %{}", len_val, len_ptr)?;
                     writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 2", cap_ptr, header_ptr)?;
@@ -1434,79 +1791,32 @@ impl TextCodeGen {
                     let need_grow = format!("vp.need_grow.{}", vec_idx);
                     writeln!(out, "  %{} = icmp sge i64 %{}, %{}", need_grow, len_val, cap_val)?;
 
-                    // Branch: if need grow, allocate new; else store directly
+                    // Branch: growth is out of line in the runtime (cold), so the
+                    // common path is just the compare, the store and the len bump
                     let grow_label = format!("vp.grow.{}", vec_idx);
                     let store_label = format!("vp.store.{}", vec_idx);
-                    let cont_label = format!("vp.cont.{}", vec_idx);
                     writeln!(out, "  br i1 %{}, label %{}, label %{}", need_grow, grow_label, store_label)?;
 
                     // Grow block
                     writeln!(out, "{}:", grow_label)?;
-                    // new_cap = cap == 0 ? 4 : cap * 2
-                    let is_zero = format!("vp.is_zero.{}", vec_idx);
-                    writeln!(out, "  %{} = icmp eq i64 %{}, 0", is_zero, cap_val)?;
-                    let doubled = format!("vp.doubled.{}", vec_idx);
-                    writeln!(out, "  %{} = mul i64 %{}, 2", doubled, cap_val)?;
-                    let new_cap = format!("vp.new_cap.{}", vec_idx);
-                    writeln!(out, "  %{} = select i1 %{}, i64 4, i64 %{}", new_cap, is_zero, doubled)?;
-                    // new_size = new_cap * 8
-                    let new_size = format!("vp.new_size.{}", vec_idx);
-                    writeln!(out, "  %{} = mul i64 %{}, 8", new_size, new_cap)?;
-                    // Check if ptr == 0 for first alloc vs realloc
-                    let ptr_is_null = format!("vp.ptr_null.{}", vec_idx);
-                    writeln!(out, "  %{} = icmp eq i64 %{}, 0", ptr_is_null, ptr_i64)?;
-                    let alloc_label = format!("vp.alloc.{}", vec_idx);
-                    let realloc_label = format!("vp.realloc.{}", vec_idx);
-                    let merge_label = format!("vp.merge.{}", vec_idx);
-                    writeln!(out, "  br i1 %{}, label %{}, label %{}", ptr_is_null, alloc_label, realloc_label)?;
-
-                    // First allocation
-                    writeln!(out, "{}:", alloc_label)?;
-                    let new_data_a = format!("vp.new_data.a.{}", vec_idx);
-                    writeln!(out, "  %{} = call ptr @malloc(i64 %{})", new_data_a, new_size)?;
-                    writeln!(out, "  br label %{}", merge_label)?;
-
-                    // Realloc
-                    writeln!(out, "{}:", realloc_label)?;
-                    let old_ptr = format!("vp.old_ptr.{}", vec_idx);
-                    writeln!(out, "  %{} = inttoptr i64 %{} to ptr", old_ptr, ptr_i64)?;
-                    let new_data_r = format!("vp.new_data.r.{}", vec_idx);
-                    writeln!(out, "  %{} = call ptr @realloc(ptr %{}, i64 %{})", new_data_r, old_ptr, new_size)?;
-                    writeln!(out, "  br label %{}", merge_label)?;
-
-                    // Merge block with phi
-                    writeln!(out, "{}:", merge_label)?;
-                    let new_data = format!("vp.new_data.{}", vec_idx);
-                    writeln!(out, "  %{} = phi ptr [ %{}, %{} ], [ %{}, %{} ]", new_data, new_data_a, alloc_label, new_data_r, realloc_label)?;
-                    // Update header: ptr and cap
-                    let new_ptr_i64 = format!("vp.new_ptr.{}", vec_idx);
-                    writeln!(out, "  %{} = ptrtoint ptr %{} to i64", new_ptr_i64, new_data)?;
-                    writeln!(out, "  store i64 %{}, ptr %{}", new_ptr_i64, header_ptr)?;
-                    writeln!(out, "  store i64 %{}, ptr %{}", new_cap, cap_ptr)?;
+                    writeln!(out, "  call void @{}(ptr %{})", grow_fn, header_ptr)?;
                     writeln!(out, "  br label %{}", store_label)?;
 
                     // Store block
                     writeln!(out, "{}:", store_label)?;
-                    // Re-load ptr since it may have changed
+                    // Re-load ptr since growth may have moved the data
                     let cur_ptr = format!("vp.cur_ptr.{}", vec_idx);
                     writeln!(out, "  %{} = load i64, ptr %{}", cur_ptr, header_ptr)?;
                     let data_ptr = format!("vp.data_ptr.{}", vec_idx);
                     writeln!(out, "  %{} = inttoptr i64 %{} to ptr", data_ptr, cur_ptr)?;
-                    // Re-load len
-                    let cur_len = format!("vp.cur_len.{}", vec_idx);
-                    writeln!(out, "  %{} = load i64, ptr %{}", cur_len, len_ptr)?;
                     // Store value at data[len]
                     let slot = format!("vp.slot.{}", vec_idx);
-                    writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 %{}", slot, data_ptr, cur_len)?;
+                    writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 %{}", slot, data_ptr, len_val)?;
                     writeln!(out, "  store i64 {}, ptr %{}", val_val, slot)?;
                     // Increment len
                     let new_len = format!("vp.new_len.{}", vec_idx);
-                    writeln!(out, "  %{} = add i64 %{}, 1", new_len, cur_len)?;
+                    writeln!(out, "  %{} = add i64 %{}, 1", new_len, len_val)?;
                     writeln!(out, "  store i64 %{}, ptr %{}", new_len, len_ptr)?;
-                    writeln!(out, "  br label %{}", cont_label)?;
-
-                    // Continue
-                    writeln!(out, "{}:", cont_label)?;
                     return Ok(());
                 }
 
@@ -1559,7 +1869,7 @@ impl TextCodeGen {
                 }
 
                 // vec_free(vec) -> Unit: free data array and header
-                if fn_name == "vec_free" && args.len() == 1 {
+                if fn_name == "vec_free" && args.len() == 1 && !self.runtime_stats {
                     let vec_idx = *name_counts.entry("vec_free".to_string()).or_insert(0);
                     *name_counts.get_mut("vec_free").unwrap() += 1;
                     let vec_val = match &args[0] {
@@ -1575,24 +1885,58 @@ impl TextCodeGen {
                     writeln!(out, "  %{} = inttoptr i64 {} to ptr", header_ptr, vec_val)?;
                     let ptr_i64 = format!("vfree.ptr.{}", vec_idx);
                     writeln!(out, "  %{} = load i64, ptr %{}", ptr_i64, header_ptr)?;
-                    // Check if data ptr is non-null
-                    let ptr_nonnull = format!("vfree.nonnull.{}", vec_idx);
-                    writeln!(out, "  %{} = icmp ne i64 %{}, 0", ptr_nonnull, ptr_i64)?;
-                    let free_data_label = format!("vfree.data.{}", vec_idx);
-                    let free_header_label = format!("vfree.header.lbl.{}", vec_idx);
-                    writeln!(out, "  br i1 %{}, label %{}, label %{}", ptr_nonnull, free_data_label, free_header_label)?;
-                    // Free data array
-                    writeln!(out, "{}:", free_data_label)?;
+                    // free(NULL) is a no-op, so an empty vector needs no branch
                     let data_ptr = format!("vfree.data.ptr.{}", vec_idx);
                     writeln!(out, "  %{} = inttoptr i64 %{} to ptr", data_ptr, ptr_i64)?;
                     writeln!(out, "  call void @free(ptr %{})", data_ptr)?;
-                    writeln!(out, "  br label %{}", free_header_label)?;
-                    // Free header
-                    writeln!(out, "{}:", free_header_label)?;
                     writeln!(out, "  call void @free(ptr %{})", header_ptr)?;
                     return Ok(());
                 }
 
+                // vec_free_inline(vec) -> Unit: the header lives in the frame; free
+                // the data only if it spilled out of the inline elements
+                if fn_name == "vec_free_inline" && args.len() == 1 {
+                    let vec_idx = *name_counts.entry("vec_free_inline".to_string()).or_insert(0);
+                    *name_counts.get_mut("vec_free_inline").unwrap() += 1;
+                    let vec_val = match &args[0] {
+                        Operand::Place(p) if local_names.contains(&p.name) => {
+                            let load_name = format!("vfreei.vec.{}", vec_idx);
+                            writeln!(out, "  %{} = load i64, ptr %{}.addr", load_name, p.name)?;
+                            format!("%{}", load_name)
+                        }
+                        _ => self.format_operand_with_strings(&args[0], string_table),
+                    };
+                    let header_ptr = format!("vfreei.header.{}", vec_idx);
+                    let data_i64 = format!("vfreei.ptr.{}", vec_idx);
+                    let data_ptr = format!("vfreei.data.{}", vec_idx);
+                    let inline_ptr = format!("vfreei.inline.{}", vec_idx);
+                    let spilled = format!("vfreei.spilled.{}", vec_idx);
+                    let to_free = format!("vfreei.free.{}", vec_idx);
+                    writeln!(out, "  %{} = inttoptr i64 {} to ptr", header_ptr, vec_val)?;
+                    writeln!(out, "  %{} = load i64, ptr %{}", data_i64, header_ptr)?;
+                    writeln!(out, "  %{} = inttoptr i64 %{} to ptr", data_ptr, data_i64)?;
+                    writeln!(out, "  %{} = getelementptr i64, ptr %{}, i64 3", inline_ptr, header_ptr)?;
+                    writeln!(out, "  %{} = icmp ne ptr %{}, %{}", spilled, data_ptr, inline_ptr)?;
+                    writeln!(out, "  %{} = select i1 %{}, ptr %{}, ptr null", to_free, spilled, data_ptr)?;
+                    writeln!(out, "  call void @free(ptr %{})", to_free)?;
+                    return Ok(());
+                }
+
+                // Thread pool builtins are bmb_-prefixed in runtime.c so a user
+                // function named `join` or `spawn` keeps its own symbol
+                let fn_name = match fn_name.as_str() {
+                    "spawn" | "join" | "parallel_for" if !fn_return_types.contains_key(fn_name) => {
+                        &format!("bmb_{}", fn_name)
+                    }
+                    // --runtime-stats: counted out-of-line allocation
+                    "vec_new" | "vec_with_capacity" | "vec_free" | "box_new_i64" | "box_free_i64"
+                        if self.runtime_stats && !fn_return_types.contains_key(fn_name) =>
+                    {
+                        &format!("bmb_{}", fn_name)
+                    }
+                    _ => fn_name,
+                };
+
                 // First check user-defined functions, then fall back to builtins
                 let ret_ty = fn_return_types
                     .get(fn_name)
@@ -1603,40 +1947,8 @@ impl TextCodeGen {
                 let call_base = dest.as_ref().map(|d| d.name.clone()).unwrap_or_else(|| format!("call_{}", fn_name));
 
                 // Emit loads for local variables used as arguments
-                let mut arg_vals: Vec<(String, String)> = Vec::new(); // (type, value)
-                for (i, arg) in args.iter().enumerate() {
-                    let ty = match arg {
-                        Operand::Constant(c) => self.constant_type(c),
-                        Operand::Place(p) => place_types.get(&p.name).copied()
-                            .unwrap_or_else(|| self.infer_place_type(p, func)),
-                    };
-
-                    let val = match arg {
-                        Operand::Place(p) if local_names.contains(&p.name) => {
-                            // Emit load from alloca (use call_base for uniqueness)
-                            let load_name = format!("{}.{}.arg{}", call_base, p.name, i);
-                            writeln!(out, "  %{} = load {}, ptr %{}.addr", load_name, ty, p.name)?;
-                            format!("%{}", load_name)
-                        }
-                        Operand::Constant(Constant::String(s)) => {
-                            // String constants need to be wrapped with bmb_string_from_cstr
-                            if let Some(global_name) = string_table.get(s) {
-                                let wrapper_name = format!("{}.strarg{}", call_base, i);
-                                writeln!(out, "  %{} = call ptr @bmb_string_from_cstr(ptr @{})", wrapper_name, global_name)?;
-                                format!("%{}", wrapper_name)
-                            } else {
-                                self.format_operand_with_strings(arg, string_table)
-                            }
-                        }
-                        _ => self.format_operand_with_strings(arg, string_table),
-                    };
-                    arg_vals.push((ty.to_string(), val));
-                }
-
-                let args_str: Vec<String> = arg_vals
-                    .iter()
-                    .map(|(ty, val)| format!("{} {}", ty, val))
-                    .collect();
+                let args_str =
+                    self.emit_call_args(out, &call_base, args, func, string_table, place_types, local_names)?;
 
                 if ret_ty == "void" {
                     writeln!(
@@ -1698,7 +2010,6 @@ impl TextCodeGen {
 
                 // Find the dest block label by looking at which block contains this phi
                 // We need to check phi_load_map for locals that were pre-loaded
-                // and phi_string_map for string constants that were wrapped
                 let phi_args: Vec<String> = values
                     .iter()
                     .map(|(val, label)| {
@@ -1712,18 +2023,11 @@ impl TextCodeGen {
                             } else {
                                 self.format_operand_with_strings(val, string_table)
                             }
-                        } else if let Operand::Constant(Constant::String(s)) = val {
-                            // Check if this string constant was pre-wrapped for phi
-                            let key = (current_block_label.to_string(), s.clone(), label.clone());
-                            if let Some(temp_name) = phi_string_map.get(&key) {
-                                format!("%{}", temp_name)
-                            } else {
-                                self.format_operand_with_strings(val, string_table)
-                            }
                         } else {
+                            // String constants are static BmbString globals, usable directly
                             self.format_operand_with_strings(val, string_table)
                         };
-                        format!("[ {}, %bb_{} ]", val_str, label)
+                        format!("[ {}, %{} ]", val_str, Self::exit_label(func, label))
                     })
                     .collect();
 
@@ -1769,7 +2073,7 @@ impl TextCodeGen {
             }
 
             // v0.19.1: Enum variant
-            MirInst::EnumVariant { dest, enum_name, variant, args } => {
+            MirInst::EnumVariant { dest, enum_name, variant, discriminant, args } => {
                 // Enums are represented as tagged unions:
                 // - First word: discriminant (variant index)
                 // - Following words: variant data
@@ -1777,8 +2081,7 @@ impl TextCodeGen {
                 // Allocate space for enum (discriminant + max variant size)
                 let size = 1 + args.len().max(1);
                 writeln!(out, "  %{} = alloca i64, i32 {}", dest.name, size)?;
-                // Store discriminant (simplified: hash of variant name)
-                let discriminant: i64 = variant.bytes().fold(0i64, |acc, b| acc.wrapping_mul(31).wrapping_add(b as i64));
+                // Store discriminant (the tag `match` switches on)
                 writeln!(out, "  %{}_disc = getelementptr i64, ptr %{}, i32 0", dest.name, dest.name)?;
                 writeln!(out, "  store i64 {}, ptr %{}_disc", discriminant, dest.name)?;
                 // Store variant arguments
@@ -1851,8 +2154,7 @@ impl TextCodeGen {
                 // Special handling for string constant returns
                 if let Operand::Constant(Constant::String(s)) = val {
                     if let Some(global_name) = string_table.get(s) {
-                        writeln!(out, "  %_ret_str = call ptr @bmb_string_from_cstr(ptr @{})", global_name)?;
-                        writeln!(out, "  ret ptr %_ret_str")?;
+                        writeln!(out, "  ret ptr @{}.hdr", global_name)?;
                     } else {
                         // Fallback - shouldn't happen
                         writeln!(out, "  ret {} {}", ty, self.format_operand_with_strings(val, string_table))?;
@@ -1917,7 +2219,19 @@ impl TextCodeGen {
                 for (val, label) in cases {
                     writeln!(out, "    i64 {}, label %bb_{}", val, label)?;
                 }
-                writeln!(out, "  ]")?;
+                // A default that is never taken (an exhaustive match) gets the
+                // weights of a failed __builtin_expect, so LLVM lays the cases
+                // out as the hot path; its `unreachable` also spares the jump
+                // table a range check
+                if Self::is_unreachable_block(func, default) {
+                    let weights = std::iter::once("i32 1")
+                        .chain(cases.iter().map(|_| "i32 2000"))
+                        .collect::<Vec<_>>()
+                        .join(", ");
+                    writeln!(out, "  ], !prof !{{!\"branch_weights\", {}}}", weights)?;
+                } else {
+                    writeln!(out, "  ]")?;
+                }
             }
         }
 
@@ -1958,6 +2272,7 @@ impl TextCodeGen {
             // v0.64: Character constant (32-bit Unicode codepoint)
             Constant::Char(_) => "i32",
             Constant::Unit => "i8",
+            Constant::FnRef(_) => "ptr",
         }
     }
 
@@ -1985,6 +2300,7 @@ impl TextCodeGen {
             // v0.64: Character constant (Unicode codepoint)
             Constant::Char(c) => (*c as u32).to_string(),
             Constant::Unit => "0".to_string(),
+            Constant::FnRef(name) => format!("@{}", name),
         }
     }
 
@@ -2003,7 +2319,7 @@ impl TextCodeGen {
             Operand::Constant(c) => match c {
                 Constant::String(s) => {
                     if let Some(global_name) = string_table.get(s) {
-                        format!("@{}", global_name)
+                        format!("@{}.hdr", global_name)
                     } else {
                         // Fallback - shouldn't happen if collect_string_constants is correct
                         format!("\"{}\"", s)
@@ -2046,9 +2362,10 @@ impl TextCodeGen {
         match fn_name {
             // Void return
             "println" | "print" | "assert" | "bmb_print_str" | "print_str" => "void",
+            "hashmap_free" | "hashset_free" | "strmap_free" => "void",
 
             // i64 return - Basic
-            "read_int" | "abs" | "bmb_abs" | "min" | "max" | "f64_to_i64" => "i64",
+            "read_int" | "flush" | "abs" | "bmb_abs" | "min" | "max" | "f64_to_i64" => "i64",
 
             // f64 return - Math intrinsics (v0.34)
             "sqrt" | "i64_to_f64" => "double",
@@ -2057,25 +2374,40 @@ impl TextCodeGen {
             // v0.46: byte_at added as preferred name (same as interpreter)
             "bmb_string_len" | "bmb_string_char_at" | "bmb_string_eq" | "bmb_ord"
             | "len" | "char_at" | "byte_at" | "ord" => "i64",
+            "str_find" | "str_find_byte" | "str_count_byte" | "str_starts_with" => "i64",
 
             // i64 return - File I/O (both full and wrapper names)
             "bmb_file_exists" | "bmb_file_size" | "bmb_write_file" | "bmb_append_file"
-            | "file_exists" | "file_size" | "write_file" | "append_file" => "i64",
+            | "bmb_file_open" | "bmb_file_close"
+            | "file_exists" | "file_size" | "write_file" | "append_file"
+            | "file_open" | "file_close" => "i64",
 
             // i64 return - StringBuilder (handle is i64)
-            "bmb_sb_new" | "bmb_sb_push" | "bmb_sb_len" | "bmb_sb_clear"
-            | "sb_new" | "sb_push" | "sb_len" | "sb_clear" => "i64",
+            "bmb_sb_new" | "bmb_sb_push" | "bmb_sb_push_char" | "bmb_sb_push_int" | "bmb_sb_len"
+            | "bmb_sb_clear" | "sb_new" | "sb_push" | "sb_push_char" | "sb_push_int" | "sb_len"
+            | "sb_clear" => "i64",
+
+            // i64 return - String arena (nesting depth)
+            "bmb_arena_push" | "bmb_arena_pop" | "arena_push" | "arena_pop" => "i64",
 
             // i64 return - Process
             "bmb_system" => "i64",
 
+            // i64 return - Thread pool (task handle / results)
+            "bmb_spawn" | "bmb_join" | "bmb_parallel_for" => "i64",
+
+            // Counted allocation (--runtime-stats)
+            "bmb_vec_new" | "bmb_vec_with_capacity" | "bmb_box_new_i64" => "i64",
+            "bmb_vec_free" | "bmb_box_free_i64" => "void",
+
             // ptr return - String operations (both full and wrapper names)
             "bmb_string_new" | "bmb_string_from_cstr" | "bmb_string_slice"
             | "bmb_string_concat" | "bmb_chr"
             | "slice" | "chr" => "ptr",
 
             // ptr return - File I/O (both full and wrapper names)
-            "bmb_read_file" | "read_file" => "ptr",
+            "bmb_read_file" | "read_file" | "bmb_read_file_mapped" | "read_file_mapped"
+            | "bmb_read_line" | "read_line" => "ptr",
 
             // ptr return - StringBuilder (both full and wrapper names)
             "bmb_sb_build" | "sb_build" => "ptr",
@@ -2215,4 +2547,483 @@ mod tests {
         assert!(ir.contains("%_t0 = add nsw i64 %a, %b"));  // nsw for optimization
         assert!(ir.contains("ret i64 %_t0"));
     }
+
+    #[test]
+    fn test_tail_calls_use_musttail() {
+        // fn even(n) = if n == 0 { 1 } else { odd(n - 1) }, as MIR lowering leaves it
+        let parity = |name: &str, other: &str| MirFunction {
+            name: name.to_string(),
+            params: vec![("n".to_string(), MirType::I64)],
+            ret_ty: MirType::I64,
+            locals: vec![("_t1".to_string(), MirType::I64)],
+            blocks: vec![
+                BasicBlock {
+                    label: "entry".to_string(),
+                    instructions: vec![MirInst::BinOp {
+                        dest: Place::new("_t0"),
+                        op: MirBinOp::Eq,
+                        lhs: Operand::Place(Place::new("n")),
+                        rhs: Operand::Constant(Constant::Int(0)),
+                    }],
+                    terminator: Terminator::Branch {
+                        cond: Operand::Place(Place::new("_t0")),
+                        then_label: "then_0".to_string(),
+                        else_label: "else_1".to_string(),
+                    },
+                },
+                BasicBlock {
+                    label: "then_0".to_string(),
+                    instructions: vec![],
+                    terminator: Terminator::Return(Some(Operand::Constant(Constant::Int(1)))),
+                },
+                BasicBlock {
+                    label: "else_1".to_string(),
+                    instructions: vec![
+                        MirInst::BinOp {
+                            dest: Place::new("_t2"),
+                            op: MirBinOp::Sub,
+                            lhs: Operand::Place(Place::new("n")),
+                            rhs: Operand::Constant(Constant::Int(1)),
+                        },
+                        MirInst::Call {
+                            dest: Some(Place::new("_t1")),
+                            func: other.to_string(),
+                            args: vec![Operand::Place(Place::new("_t2"))],
+                        },
+                    ],
+                    terminator: Terminator::Return(Some(Operand::Place(Place::new("_t1")))),
+                },
+            ],
+            preconditions: vec![],
+            postconditions: vec![],
+            is_pure: false,
+            is_const: false,
+        };
+        let program = MirProgram { functions: vec![parity("even", "odd"), parity("odd", "even")], extern_fns: vec![] };
+
+        let ir = TextCodeGen::new().generate(&program).unwrap();
+        assert!(ir.contains("  %else_1.tail = musttail call i64 @odd(i64 %_t2)\n  ret i64 %else_1.tail\n"), "{ir}");
+        assert!(ir.contains("musttail call i64 @even("));
+        assert!(!ir.contains("store i64 %_t1.call"));
+    }
+
+    #[test]
+    fn test_tail_call_with_frame_argument_is_not_musttail() {
+        // fn f(p: P) -> i64 = g(P { x: 1 }): the struct lives in f's frame
+        let func = |name: &str, instructions, terminator| MirFunction {
+            name: name.to_string(),
+            params: vec![("p".to_string(), MirType::StructPtr("P".to_string()))],
+            ret_ty: MirType::I64,
+            locals: vec![],
+            blocks: vec![BasicBlock { label: "entry".to_string(), instructions, terminator }],
+            preconditions: vec![],
+            postconditions: vec![],
+            is_pure: false,
+            is_const: false,
+        };
+        let f = func(
+            "f",
+            vec![
+                MirInst::StructInit {
+                    dest: Place::new("_t0"),
+                    struct_name: "P".to_string(),
+                    fields: vec![("x".to_string(), Operand::Constant(Constant::Int(1)))],
+                },
+                MirInst::Copy { dest: Place::new("q"), src: Place::new("_t0") },
+                MirInst::Call {
+                    dest: Some(Place::new("_t1")),
+                    func: "g".to_string(),
+                    args: vec![Operand::Place(Place::new("q"))],
+                },
+            ],
+            Terminator::Return(Some(Operand::Place(Place::new("_t1")))),
+        );
+        let g = func("g", vec![], Terminator::Return(Some(Operand::Constant(Constant::Int(0)))));
+        let program = MirProgram { functions: vec![f, g], extern_fns: vec![] };
+
+        let ir = TextCodeGen::new().generate(&program).unwrap();
+        assert!(ir.contains("call i64 @g("), "{ir}");
+        assert!(!ir.contains("musttail"), "{ir}");
+    }
+
+    #[test]
+    fn test_vec_fast_paths() {
+        // vec_push in a branch feeding a phi, plus a checked and an unchecked vec_get
+        let call = |dest: Option<&str>, func: &str, args: &[&str]| MirInst::Call {
+            dest: dest.map(Place::new),
+            func: func.to_string(),
+            args: args.iter().map(|a| Operand::Place(Place::new(*a))).collect(),
+        };
+        let program = MirProgram {
+            functions: vec![MirFunction {
+                name: "f".to_string(),
+                params: vec![
+                    ("v".to_string(), MirType::I64),
+                    ("i".to_string(), MirType::I64),
+                    ("c".to_string(), MirType::Bool),
+                ],
+                ret_ty: MirType::I64,
+                locals: vec![],
+                blocks: vec![
+                    BasicBlock {
+                        label: "entry".to_string(),
+                        instructions: vec![],
+                        terminator: Terminator::Branch {
+                            cond: Operand::Place(Place::new("c")),
+                            then_label: "then".to_string(),
+                            else_label: "join".to_string(),
+                        },
+                    },
+                    BasicBlock {
+                        label: "then".to_string(),
+                        instructions: vec![call(None, "vec_push", &["v", "i"])],
+                        terminator: Terminator::Goto("join".to_string()),
+                    },
+                    BasicBlock {
+                        label: "join".to_string(),
+                        instructions: vec![
+                            MirInst::Phi {
+                                dest: Place::new("k"),
+                                values: vec![
+                                    (Operand::Constant(Constant::Int(0)), "entry".to_string()),
+                                    (Operand::Constant(Constant::Int(1)), "then".to_string()),
+                                ],
+                            },
+                            call(Some("a"), "vec_get", &["v", "k"]),
+                            call(Some("b"), "vec_get_unchecked", &["v", "i"]),
+                            MirInst::BinOp {
+                                dest: Place::new("r"),
+                                op: MirBinOp::Add,
+                                lhs: Operand::Place(Place::new("a")),
+                                rhs: Operand::Place(Place::new("b")),
+                            },
+                        ],
+                        terminator: Terminator::Return(Some(Operand::Place(Place::new("r")))),
+                    },
+                ],
+                preconditions: vec![],
+                postconditions: vec![],
+                is_pure: false,
+                is_const: false,
+            }],
+            extern_fns: vec![],
+        };
+
+        let ir = TextCodeGen::new().generate(&program).unwrap();
+
+        // Growth is a cold out-of-line call, not inline malloc/realloc
+        assert!(ir.contains("call void @bmb_vec_grow(ptr %vp.header.0)"));
+        assert!(!ir.contains("@realloc(ptr %"));
+        // The phi names the block the push actually ends in
+        assert!(ir.contains("[ 1, %bb_then.exit ]"));
+        assert!(ir.contains("[ 0, %bb_entry ]"));
+        // Only the checked get carries a bounds check
+        assert_eq!(ir.matches("call void @bmb_vec_index_oob").count(), 1);
+    }
+
+    #[test]
+    fn test_task_builtins_pass_function_addresses() {
+        let func = |name: &str, params: &[&str], instructions: Vec<MirInst>, ret: Operand| MirFunction {
+            name: name.to_string(),
+            params: params.iter().map(|p| (p.to_string(), MirType::I64)).collect(),
+            ret_ty: MirType::I64,
+            locals: vec![],
+            blocks: vec![BasicBlock {
+                label: "entry".to_string(),
+                instructions,
+                terminator: Terminator::Return(Some(ret)),
+            }],
+            preconditions: vec![],
+            postconditions: vec![],
+            is_pure: false,
+            is_const: false,
+        };
+        let call = |dest: &str, func: &str, args: Vec<Operand>| MirInst::Call {
+            dest: Some(Place::new(dest)),
+            func: func.to_string(),
+            args,
+        };
+        let square = Operand::Constant(Constant::FnRef("square".to_string()));
+        let program = MirProgram {
+            functions: vec![
+                func("square", &["i"], vec![], Operand::Place(Place::new("i"))),
+                func(
+                    "main",
+                    &[],
+                    vec![
+                        call("s", "parallel_for", vec![Operand::Constant(Constant::Int(0)), Operand::Constant(Constant::Int(8)), square.clone()]),
+                        call("h", "spawn", vec![square, Operand::Place(Place::new("s"))]),
+                        call("r", "join", vec![Operand::Place(Place::new("h"))]),
+                    ],
+                    Operand::Place(Place::new("r")),
+                ),
+                // A user function named like a builtin keeps its own symbol
+                func("join", &["x"], vec![], Operand::Place(Place::new("x"))),
+            ],
+            extern_fns: vec![],
+        };
+
+        let ir = TextCodeGen::new().generate(&program).unwrap();
+        assert!(ir.contains("declare i64 @bmb_parallel_for(i64, i64, ptr)"));
+        assert!(ir.contains("= call i64 @bmb_parallel_for(i64 0, i64 8, ptr @square)"), "{}", ir);
+        assert!(ir.contains("= call i64 @bmb_spawn(ptr @square, i64 %s)"));
+        assert!(ir.contains("= call i64 @join(i64 %h)"));
+    }
+
+    #[test]
+    fn test_runtime_stats_routes_vec_and_box_through_runtime() {
+        let call = |dest: Option<&str>, func: &str, args: Vec<Operand>| MirInst::Call {
+            dest: dest.map(Place::new),
+            func: func.to_string(),
+            args,
+        };
+        let program = MirProgram {
+            functions: vec![MirFunction {
+                name: "f".to_string(),
+                params: vec![],
+                ret_ty: MirType::I64,
+                locals: vec![],
+                blocks: vec![BasicBlock {
+                    label: "entry".to_string(),
+                    instructions: vec![
+                        call(Some("v"), "vec_with_capacity", vec![Operand::Constant(Constant::Int(8))]),
+                        call(None, "vec_push", vec![Operand::Place(Place::new("v")), Operand::Constant(Constant::Int(1))]),
+                        call(None, "vec_free", vec![Operand::Place(Place::new("v"))]),
+                        call(Some("b"), "box_new_i64", vec![Operand::Constant(Constant::Int(7))]),
+                    ],
+                    terminator: Terminator::Return(Some(Operand::Place(Place::new("b")))),
+                }],
+                preconditions: vec![],
+                postconditions: vec![],
+                is_pure: false,
+                is_const: false,
+            }],
+            extern_fns: vec![],
+        };
+
+        let inline = TextCodeGen::new().generate(&program).unwrap();
+        assert!(!inline.contains("@bmb_vec_with_capacity"));
+        assert!(inline.contains("call ptr @malloc(i64 8)"));
+
+        let counted = TextCodeGen::new().with_runtime_stats(true).generate(&program).unwrap();
+        assert!(counted.contains("declare i64 @bmb_vec_with_capacity(i64)"));
+        assert!(counted.contains("= call i64 @bmb_vec_with_capacity(i64 8)"), "{}", counted);
+        assert!(counted.contains("call void @bmb_vec_free(i64 %v)"));
+        assert!(counted.contains("= call i64 @bmb_box_new_i64(i64 7)"));
+        // Element access is still inline
+        assert!(counted.contains("call void @bmb_vec_grow("));
+    }
+
+    #[test]
+    fn test_stack_vector_lives_in_the_frame() {
+        let call = |dest: Option<&str>, func: &str, args: Vec<Operand>| MirInst::Call {
+            dest: dest.map(Place::new),
+            func: func.to_string(),
+            args,
+        };
+        let v = || Operand::Place(Place::new("v"));
+        let mut instructions = vec![call(Some("v"), "vec_new_inline", vec![])];
+        // Six pushes: the last two spill past the inline elements
+        for i in 1..=6 {
+            instructions.push(call(None, "vec_push_inline", vec![v(), Operand::Constant(Constant::Int(i * 10))]));
+        }
+        instructions.push(call(Some("r"), "vec_get", vec![v(), Operand::Constant(Constant::Int(5))]));
+        instructions.push(call(None, "vec_free_inline", vec![v()]));
+        let program = MirProgram {
+            functions: vec![MirFunction {
+                name: "main".to_string(),
+                params: vec![],
+                ret_ty: MirType::I64,
+                locals: vec![],
+                blocks: vec![BasicBlock {
+                    label: "entry".to_string(),
+                    instructions,
+                    terminator: Terminator::Return(Some(Operand::Place(Place::new("r")))),
+                }],
+                preconditions: vec![],
+                postconditions: vec![],
+                is_pure: false,
+                is_const: false,
+            }],
+            extern_fns: vec![],
+        };
+
+        let ir = TextCodeGen::new().generate(&program).unwrap();
+        let entry = ir.split("alloca_entry:").nth(1).unwrap();
+        assert!(entry.lines().nth(1).unwrap().contains("%v.vecbuf = alloca [7 x i64]"), "{}", ir);
+        assert!(ir.contains("call void @bmb_vec_grow_inline(ptr %vp.header.0)"));
+        assert!(!ir.contains("@malloc(i64 24)"));
+        // Only spilled data is freed, never the header
+        assert!(ir.contains("select i1 %vfreei.spilled.0, ptr %vfreei.data.0, ptr null"));
+        assert_eq!(ir.matches("call void @free(").count(), 1);
+    }
+
+    #[test]
+    fn test_exhaustive_switch_is_weighted() {
+        let block = |label: &str, terminator| BasicBlock {
+            label: label.to_string(),
+            instructions: vec![],
+            terminator,
+        };
+        let ret = |n| Terminator::Return(Some(Operand::Constant(Constant::Int(n))));
+        let x = || Operand::Place(Place::new("x"));
+        let program = MirProgram {
+            functions: vec![MirFunction {
+                name: "pick".to_string(),
+                params: vec![("x".to_string(), MirType::I64)],
+                ret_ty: MirType::I64,
+                locals: vec![],
+                blocks: vec![
+                    block("entry", Terminator::Switch {
+                        discriminant: x(),
+                        cases: vec![(0, "a".to_string()), (1, "b".to_string()), (2, "c".to_string())],
+                        default: "dead".to_string(),
+                    }),
+                    block("a", Terminator::Switch {
+                        discriminant: x(),
+                        cases: vec![(7, "b".to_string())],
+                        default: "c".to_string(),
+                    }),
+                    block("b", ret(1)),
+                    block("c", ret(2)),
+                    block("dead", Terminator::Unreachable),
+                ],
+                preconditions: vec![],
+                postconditions: vec![],
+                is_pure: false,
+                is_const: false,
+            }],
+            extern_fns: vec![],
+        };
+
+        let ir = TextCodeGen::new().generate(&program).unwrap();
+        assert!(ir.contains("  ], !prof !{!\"branch_weights\", i32 1, i32 2000, i32 2000, i32 2000}"), "{}", ir);
+        // A default that is taken keeps LLVM's even weights
+        assert_eq!(ir.matches("!prof").count(), 1, "{}", ir);
+    }
+
+    #[test]
+    fn test_string_literals_are_static() {
+        // A literal used as a call argument, a phi input and a return value
+        let program = MirProgram {
+            functions: vec![MirFunction {
+                name: "pick".to_string(),
+                params: vec![("c".to_string(), MirType::Bool)],
+                ret_ty: MirType::String,
+                locals: vec![],
+                blocks: vec![
+                    BasicBlock {
+                        label: "entry".to_string(),
+                        instructions: vec![MirInst::Call {
+                            dest: None,
+                            func: "print_str".to_string(),
+                            args: vec![Operand::Constant(Constant::String("hi".to_string()))],
+                        }],
+                        terminator: Terminator::Branch {
+                            cond: Operand::Place(Place::new("c")),
+                            then_label: "yes".to_string(),
+                            else_label: "no".to_string(),
+                        },
+                    },
+                    BasicBlock {
+                        label: "yes".to_string(),
+                        instructions: vec![],
+                        terminator: Terminator::Goto("join".to_string()),
+                    },
+                    BasicBlock {
+                        label: "no".to_string(),
+                        instructions: vec![],
+                        terminator: Terminator::Return(Some(Operand::Constant(Constant::String("no".to_string())))),
+                    },
+                    BasicBlock {
+                        label: "join".to_string(),
+                        instructions: vec![MirInst::Phi {
+                            dest: Place::new("r"),
+                            values: vec![(Operand::Constant(Constant::String("hi".to_string())), "yes".to_string())],
+                        }],
+                        terminator: Terminator::Return(Some(Operand::Place(Place::new("r")))),
+                    },
+                ],
+                preconditions: vec![],
+                postconditions: vec![],
+                is_pure: false,
+                is_const: false,
+            }],
+            extern_fns: vec![],
+        };
+
+        let ir = TextCodeGen::new().generate(&program).unwrap();
+        let body = &ir[ir.find("define ").unwrap()..];
+
+        // Each literal gets one constant header; no use site allocates
+        assert_eq!(ir.matches(".hdr = private constant { ptr, i64, i64, ptr }").count(), 2);
+        assert!(!body.contains("@bmb_string_from_cstr"));
+        assert!(body.contains("phi ptr [ @.str."));
+        assert!(body.contains("ret ptr @.str."));
+    }
+
+    #[test]
+    fn test_incremental_generation_is_stable() {
+        let greet = |name: &str, text: &str| MirFunction {
+            name: name.to_string(),
+            params: vec![],
+            ret_ty: MirType::String,
+            locals: vec![],
+            blocks: vec![BasicBlock {
+                label: "entry".to_string(),
+                instructions: vec![],
+                terminator: Terminator::Return(Some(Operand::Constant(Constant::String(text.to_string())))),
+            }],
+            preconditions: vec![],
+            postconditions: vec![],
+            is_pure: false,
+            is_const: false,
+        };
+        let one = MirProgram { functions: vec![greet("b", "bee")], extern_fns: vec![] };
+        let two = MirProgram { functions: vec![greet("a", "ay"), greet("b", "bee")], extern_fns: vec![] };
+
+        let codegen = TextCodeGen::new();
+        let (ir_one, parts_one) = codegen.generate_incremental(&one, &HashMap::new()).unwrap();
+        let (ir_two, parts_two) = codegen.generate_incremental(&two, &HashMap::new()).unwrap();
+
+        // Deterministic module text, and b's IR is unaffected by a's literal
+        assert_eq!(ir_one, codegen.generate(&one).unwrap());
+        assert_eq!(parts_one[0], parts_two[1]);
+
+        // Spliced IR is used verbatim
+        let reuse: HashMap<String, String> = parts_two.iter().cloned().collect();
+        let (spliced, _) = codegen.generate_incremental(&two, &reuse).unwrap();
+        assert_eq!(spliced, ir_two);
+    }
+
+    #[test]
+    fn test_parallel_emission_matches_serial() {
+        let functions = (0..64)
+            .map(|i| MirFunction {
+                name: format!("f{}", i),
+                params: vec![("x".to_string(), MirType::I64)],
+                ret_ty: MirType::I64,
+                locals: vec![],
+                blocks: vec![BasicBlock {
+                    label: "entry".to_string(),
+                    instructions: vec![MirInst::BinOp {
+                        dest: Place::new("r"),
+                        op: MirBinOp::Add,
+                        lhs: Operand::Place(Place::new("x")),
+                        rhs: Operand::Constant(Constant::Int(i)),
+                    }],
+                    terminator: Terminator::Return(Some(Operand::Place(Place::new("r")))),
+                }],
+                preconditions: vec![],
+                postconditions: vec![],
+                is_pure: false,
+                is_const: false,
+            })
+            .collect();
+        let program = MirProgram { functions, extern_fns: vec![] };
+
+        let serial = TextCodeGen::new().generate(&program).unwrap();
+        let parallel = TextCodeGen::new().with_jobs(4).generate(&program).unwrap();
+        assert_eq!(serial, parallel);
+    }
 }
@@ -12,7 +12,20 @@
 //!     ↓
 //! .wat file → wat2wasm → .wasm
 //! ```
+//!
+//! Linear memory layout:
+//! ```text
+//! 0..512      I/O scratch (integer formatting, iovecs)
+//! 512..552    allocator free-list heads (9 size classes + large blocks)
+//! 1024..      string constants, from data segments ([len: i32][bytes])
+//! heap base.. blocks from $bmb_alloc, grown with memory.grow
+//! ```
+//! The runtime is emitted into every module, so strings, vectors,
+//! StringBuilders and boxes need no host calls. String copies use the
+//! bulk-memory `memory.copy`/`memory.fill` instructions, and `with_simd`
+//! adds SIMD128 loops to the byte-scan kernels.
 
+use std::collections::{HashMap, HashSet};
 use std::fmt::Write;
 use thiserror::Error;
 
@@ -55,21 +68,35 @@ pub enum WasmTarget {
     Standalone,
 }
 
+/// Allocator free-list heads, one word per size class (16 B .. 4 KiB)
+const FREE_LIST_BASE: u32 = 512;
+/// Head of the first-fit list for blocks above 4 KiB
+const LARGE_FREE_LIST: u32 = FREE_LIST_BASE + 9 * 4;
+/// String constants are laid out from here; the heap starts after them
+const DATA_BASE: u32 = 1024;
+/// WASM page size
+const PAGE_SIZE: u32 = 65536;
+
 /// Text-based WASM Code Generator
 pub struct WasmCodeGen {
     /// Target environment
     target: WasmTarget,
     /// Memory pages (64KB each)
     memory_pages: u32,
+    /// Emit SIMD128 loops in the byte-scan kernels
+    simd: bool,
+    /// Address of each string constant's data segment
+    strings: HashMap<String, u32>,
+    /// First heap address (after the string constants)
+    heap_base: u32,
+    /// Functions defined by the program (these shadow runtime builtins)
+    user_fns: HashSet<String>,
 }
 
 impl WasmCodeGen {
     /// Create a new WASM code generator with default settings
     pub fn new() -> Self {
-        Self {
-            target: WasmTarget::default(),
-            memory_pages: 1,
-        }
+        Self::with_target(WasmTarget::default())
     }
 
     /// Create with specific target environment
@@ -77,6 +104,10 @@ impl WasmCodeGen {
         Self {
             target,
             memory_pages: 1,
+            simd: false,
+            strings: HashMap::new(),
+            heap_base: DATA_BASE,
+            user_fns: HashSet::new(),
         }
     }
 
@@ -86,8 +117,73 @@ impl WasmCodeGen {
         self
     }
 
+    /// Use SIMD128 in the byte-scan kernels (needs a runtime with the
+    /// WASM SIMD proposal, which all current browsers and wasmtime have)
+    pub fn with_simd(mut self, enabled: bool) -> Self {
+        self.simd = enabled;
+        self
+    }
+
     /// Generate complete WASM module as text (.wat format)
     pub fn generate(&self, program: &MirProgram) -> WasmCodeGenResult<String> {
+        self.with_layout(program).emit_module(program)
+    }
+
+    /// A copy of this generator with the program's string constants laid
+    /// out in memory
+    fn with_layout(&self, program: &MirProgram) -> Self {
+        let mut strings = HashMap::new();
+        let mut next = DATA_BASE;
+        let mut intern = |op: &Operand| {
+            if let Operand::Constant(Constant::String(s)) = op
+                && !strings.contains_key(s)
+            {
+                strings.insert(s.clone(), next);
+                next = (next + 4 + s.len() as u32).next_multiple_of(8);
+            }
+        };
+        for func in &program.functions {
+            for block in &func.blocks {
+                for inst in &block.instructions {
+                    match inst {
+                        MirInst::Const { value, .. } => intern(&Operand::Constant(value.clone())),
+                        MirInst::BinOp { lhs, rhs, .. } => {
+                            intern(lhs);
+                            intern(rhs);
+                        }
+                        MirInst::UnaryOp { src, .. } => intern(src),
+                        MirInst::Call { args, .. }
+                        | MirInst::EnumVariant { args, .. }
+                        | MirInst::ArrayInit { elements: args, .. } => args.iter().for_each(&mut intern),
+                        MirInst::Phi { values, .. } => values.iter().for_each(|(v, _)| intern(v)),
+                        MirInst::StructInit { fields, .. } => fields.iter().for_each(|(_, v)| intern(v)),
+                        MirInst::FieldStore { value, .. } => intern(value),
+                        MirInst::IndexLoad { index, .. } => intern(index),
+                        MirInst::IndexStore { index, value, .. } => {
+                            intern(index);
+                            intern(value);
+                        }
+                        MirInst::Copy { .. } | MirInst::FieldAccess { .. } => {}
+                    }
+                }
+                match &block.terminator {
+                    Terminator::Return(Some(op)) | Terminator::Branch { cond: op, .. } => intern(op),
+                    Terminator::Switch { discriminant, .. } => intern(discriminant),
+                    _ => {}
+                }
+            }
+        }
+        Self {
+            target: self.target,
+            memory_pages: self.memory_pages,
+            simd: self.simd,
+            strings,
+            heap_base: next.next_multiple_of(16),
+            user_fns: program.functions.iter().map(|f| f.name.clone()).collect(),
+        }
+    }
+
+    fn emit_module(&self, program: &MirProgram) -> WasmCodeGenResult<String> {
         let mut output = String::new();
 
         // Module header
@@ -95,8 +191,9 @@ impl WasmCodeGen {
         writeln!(output, "  ;; Generated by BMB compiler (v0.12.1)")?;
         writeln!(output)?;
 
-        // Memory declaration
+        // Memory declaration and string constants
         self.emit_memory(&mut output)?;
+        self.emit_data(&mut output)?;
 
         // Global variables for runtime
         self.emit_globals(&mut output)?;
@@ -125,10 +222,29 @@ impl WasmCodeGen {
 
     /// Emit memory declaration
     fn emit_memory(&self, out: &mut String) -> WasmCodeGenResult<()> {
-        writeln!(out, "  ;; Memory: {} pages ({}KB)",
-            self.memory_pages,
-            self.memory_pages * 64)?;
-        writeln!(out, "  (memory (export \"memory\") {})", self.memory_pages)?;
+        // At least enough pages for the constants; the allocator grows the rest
+        let pages = self.memory_pages.max(self.heap_base.div_ceil(PAGE_SIZE));
+        writeln!(out, "  ;; Memory: {} pages ({}KB), grown on demand by $bmb_alloc",
+            pages,
+            pages * 64)?;
+        writeln!(out, "  (memory (export \"memory\") {})", pages)?;
+        writeln!(out)?;
+        Ok(())
+    }
+
+    /// Emit one data segment per string constant (`[len: i32][bytes]`)
+    fn emit_data(&self, out: &mut String) -> WasmCodeGenResult<()> {
+        if self.strings.is_empty() {
+            return Ok(());
+        }
+        let mut strings: Vec<(&String, u32)> = self.strings.iter().map(|(s, &addr)| (s, addr)).collect();
+        strings.sort_by_key(|&(_, addr)| addr);
+        writeln!(out, "  ;; String constants")?;
+        for (s, addr) in strings {
+            let mut bytes = (s.len() as u32).to_le_bytes().to_vec();
+            bytes.extend_from_slice(s.as_bytes());
+            writeln!(out, "  (data (i32.const {}) \"{}\")", addr, wat_string(&bytes))?;
+        }
         writeln!(out)?;
         Ok(())
     }
@@ -137,7 +253,7 @@ impl WasmCodeGen {
     fn emit_globals(&self, out: &mut String) -> WasmCodeGenResult<()> {
         writeln!(out, "  ;; Globals for runtime")?;
         // Heap pointer for simple memory allocation (starts after reserved area)
-        writeln!(out, "  (global $heap_ptr (mut i32) (i32.const 1024))")?;
+        writeln!(out, "  (global $heap_ptr (mut i32) (i32.const {}))", self.heap_base)?;
         // Buffer pointer for I/O operations
         writeln!(out, "  (global $io_buf i32 (i32.const 0))")?;
         writeln!(out)?;
@@ -263,6 +379,13 @@ impl WasmCodeGen {
             }
         }
 
+        writeln!(out)?;
+        self.emit_allocator(out)?;
+        self.emit_string_runtime(out)?;
+        self.emit_byte_scan_runtime(out)?;
+        self.emit_vec_runtime(out)?;
+        self.emit_sb_runtime(out)?;
+
         writeln!(out)?;
         Ok(())
     }
@@ -401,6 +524,13 @@ impl WasmCodeGen {
         writeln!(out, "      (then (call $proc_exit (i32.const 1)))")?;
         writeln!(out, "    )")?;
         writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $print_str: Write a string to stdout")?;
+        writeln!(out, "  (func $print_str (param $s i32)")?;
+        writeln!(out, "    (i32.store (i32.const 200) (i32.add (local.get $s) (i32.const 4)))")?;
+        writeln!(out, "    (i32.store (i32.const 204) (i32.load (local.get $s)))")?;
+        writeln!(out, "    (drop (call $fd_write (i32.const 1) (i32.const 200) (i32.const 1) (i32.const 208)))")?;
+        writeln!(out, "  )")?;
 
         Ok(())
     }
@@ -439,6 +569,533 @@ impl WasmCodeGen {
         Ok(())
     }
 
+    /// Emit the size-class allocator and the malloc/box builtins built on it
+    fn emit_allocator(&self, out: &mut String) -> WasmCodeGenResult<()> {
+        writeln!(out, "  ;; Allocator: blocks carry an 8-byte header holding the payload capacity.")?;
+        writeln!(out, "  ;; Requests up to 4 KiB round up to a power-of-two class (16..4096), one free")?;
+        writeln!(out, "  ;; list each with heads at {}; larger blocks share a first-fit list at {}.", FREE_LIST_BASE, LARGE_FREE_LIST)?;
+        writeln!(out, "  ;; A free block links the list through its first word. New blocks are")?;
+        writeln!(out, "  ;; bump-allocated from $heap_ptr with memory.grow when memory runs out.")?;
+        writeln!(out, "  ;; $bmb_alloc: Allocate $size bytes (8-byte aligned, never 0)")?;
+        writeln!(out, "  (func $bmb_alloc (param $size i32) (result i32)")?;
+        writeln!(out, "    (local $cap i32)")?;
+        writeln!(out, "    (local $head i32)")?;
+        writeln!(out, "    (local $ptr i32)")?;
+        writeln!(out, "    (local $prev i32)")?;
+        writeln!(out, "    (local $end i32)")?;
+        writeln!(out, "    (local $have i32)")?;
+        writeln!(out, "    (local $pages i32)")?;
+        writeln!(out)?;
+        writeln!(out, "    (if (i32.le_u (local.get $size) (i32.const 4096))")?;
+        writeln!(out, "      (then")?;
+        writeln!(out, "        ;; Round up to a power-of-two size class and pop its free list")?;
+        writeln!(out, "        (local.set $cap (select (i32.const 16) (local.get $size) (i32.lt_u (local.get $size) (i32.const 16))))")?;
+        writeln!(out, "        (local.set $cap (i32.shl (i32.const 1) (i32.sub (i32.const 32) (i32.clz (i32.sub (local.get $cap) (i32.const 1))))))")?;
+        writeln!(out, "        (local.set $head (i32.add (i32.const {}) (i32.shl (i32.sub (i32.const 27) (i32.clz (local.get $cap))) (i32.const 2))))", FREE_LIST_BASE)?;
+        writeln!(out, "        (local.set $ptr (i32.load (local.get $head)))")?;
+        writeln!(out, "        (if (local.get $ptr)")?;
+        writeln!(out, "          (then")?;
+        writeln!(out, "            (i32.store (local.get $head) (i32.load (local.get $ptr)))")?;
+        writeln!(out, "            (return (local.get $ptr))")?;
+        writeln!(out, "          )")?;
+        writeln!(out, "        )")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "      (else")?;
+        writeln!(out, "        ;; Large block: first fit from the large free list")?;
+        writeln!(out, "        (local.set $cap (i32.and (i32.add (local.get $size) (i32.const 7)) (i32.const -8)))")?;
+        writeln!(out, "        (local.set $ptr (i32.load (i32.const {})))", LARGE_FREE_LIST)?;
+        writeln!(out, "        (block $searched")?;
+        writeln!(out, "          (loop $search")?;
+        writeln!(out, "            (br_if $searched (i32.eqz (local.get $ptr)))")?;
+        writeln!(out, "            (if (i32.ge_u (i32.load (i32.sub (local.get $ptr) (i32.const 8))) (local.get $cap))")?;
+        writeln!(out, "              (then")?;
+        writeln!(out, "                (if (local.get $prev)")?;
+        writeln!(out, "                  (then (i32.store (local.get $prev) (i32.load (local.get $ptr))))")?;
+        writeln!(out, "                  (else (i32.store (i32.const {}) (i32.load (local.get $ptr))))", LARGE_FREE_LIST)?;
+        writeln!(out, "                )")?;
+        writeln!(out, "                (return (local.get $ptr))")?;
+        writeln!(out, "              )")?;
+        writeln!(out, "            )")?;
+        writeln!(out, "            (local.set $prev (local.get $ptr))")?;
+        writeln!(out, "            (local.set $ptr (i32.load (local.get $ptr)))")?;
+        writeln!(out, "            (br $search)")?;
+        writeln!(out, "          )")?;
+        writeln!(out, "        )")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out)?;
+        writeln!(out, "    ;; Bump-allocate a fresh block, growing memory (at least doubling) when full")?;
+        writeln!(out, "    (local.set $ptr (i32.add (global.get $heap_ptr) (i32.const 8)))")?;
+        writeln!(out, "    (local.set $end (i32.add (local.get $ptr) (local.get $cap)))")?;
+        writeln!(out, "    (local.set $have (i32.shl (memory.size) (i32.const 16)))")?;
+        writeln!(out, "    (if (i32.gt_u (local.get $end) (local.get $have))")?;
+        writeln!(out, "      (then")?;
+        writeln!(out, "        (local.set $pages (i32.shr_u (i32.add (i32.sub (local.get $end) (local.get $have)) (i32.const 65535)) (i32.const 16)))")?;
+        writeln!(out, "        (if (i32.eq (memory.grow (select (local.get $pages) (memory.size) (i32.gt_u (local.get $pages) (memory.size)))) (i32.const -1))")?;
+        writeln!(out, "          (then")?;
+        writeln!(out, "            (if (i32.eq (memory.grow (local.get $pages)) (i32.const -1))")?;
+        writeln!(out, "              (then unreachable)")?;
+        writeln!(out, "            )")?;
+        writeln!(out, "          )")?;
+        writeln!(out, "        )")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i32.store (i32.sub (local.get $ptr) (i32.const 8)) (local.get $cap))")?;
+        writeln!(out, "    (global.set $heap_ptr (local.get $end))")?;
+        writeln!(out, "    (local.get $ptr)")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_free: Return a block to its free list (0 is ignored)")?;
+        writeln!(out, "  (func $bmb_free (param $ptr i32)")?;
+        writeln!(out, "    (local $cap i32)")?;
+        writeln!(out, "    (local $head i32)")?;
+        writeln!(out, "    (if (i32.eqz (local.get $ptr)) (then (return)))")?;
+        writeln!(out, "    (local.set $cap (i32.load (i32.sub (local.get $ptr) (i32.const 8))))")?;
+        writeln!(out, "    (local.set $head (i32.const {}))", LARGE_FREE_LIST)?;
+        writeln!(out, "    (if (i32.le_u (local.get $cap) (i32.const 4096))")?;
+        writeln!(out, "      (then")?;
+        writeln!(out, "        (local.set $head (i32.add (i32.const {}) (i32.shl (i32.sub (i32.const 27) (i32.clz (local.get $cap))) (i32.const 2))))", FREE_LIST_BASE)?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i32.store (local.get $ptr) (i32.load (local.get $head)))")?;
+        writeln!(out, "    (i32.store (local.get $head) (local.get $ptr))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_realloc: Resize a block, keeping its contents")?;
+        writeln!(out, "  (func $bmb_realloc (param $ptr i32) (param $size i32) (result i32)")?;
+        writeln!(out, "    (local $cap i32)")?;
+        writeln!(out, "    (local $new i32)")?;
+        writeln!(out, "    (if (i32.eqz (local.get $ptr)) (then (return (call $bmb_alloc (local.get $size)))))")?;
+        writeln!(out, "    (local.set $cap (i32.load (i32.sub (local.get $ptr) (i32.const 8))))")?;
+        writeln!(out, "    (if (i32.ge_u (local.get $cap) (local.get $size)) (then (return (local.get $ptr))))")?;
+        writeln!(out, "    (local.set $new (call $bmb_alloc (local.get $size)))")?;
+        writeln!(out, "    (memory.copy (local.get $new) (local.get $ptr) (local.get $cap))")?;
+        writeln!(out, "    (call $bmb_free (local.get $ptr))")?;
+        writeln!(out, "    (local.get $new)")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; malloc-family builtins (pointers are i64 in BMB)")?;
+        writeln!(out, "  (func $bmb_malloc (param $size i64) (result i64)")?;
+        writeln!(out, "    (i64.extend_i32_u (call $bmb_alloc (i32.wrap_i64 (local.get $size))))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_calloc (param $count i64) (param $size i64) (result i64)")?;
+        writeln!(out, "    (local $bytes i32)")?;
+        writeln!(out, "    (local $ptr i32)")?;
+        writeln!(out, "    (local.set $bytes (i32.wrap_i64 (i64.mul (local.get $count) (local.get $size))))")?;
+        writeln!(out, "    (local.set $ptr (call $bmb_alloc (local.get $bytes)))")?;
+        writeln!(out, "    (memory.fill (local.get $ptr) (i32.const 0) (local.get $bytes))")?;
+        writeln!(out, "    (i64.extend_i32_u (local.get $ptr))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_realloc_i64 (param $ptr i64) (param $size i64) (result i64)")?;
+        writeln!(out, "    (i64.extend_i32_u (call $bmb_realloc (i32.wrap_i64 (local.get $ptr)) (i32.wrap_i64 (local.get $size))))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_free_i64 (param $ptr i64)")?;
+        writeln!(out, "    (call $bmb_free (i32.wrap_i64 (local.get $ptr)))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_load_i64 (param $ptr i64) (result i64)")?;
+        writeln!(out, "    (i64.load (i32.wrap_i64 (local.get $ptr)))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_store_i64 (param $ptr i64) (param $value i64)")?;
+        writeln!(out, "    (i64.store (i32.wrap_i64 (local.get $ptr)) (local.get $value))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; Boxes: one heap-allocated i64")?;
+        writeln!(out, "  (func $bmb_box_new_i64 (param $value i64) (result i64)")?;
+        writeln!(out, "    (local $ptr i32)")?;
+        writeln!(out, "    (local.set $ptr (call $bmb_alloc (i32.const 8)))")?;
+        writeln!(out, "    (i64.store (local.get $ptr) (local.get $value))")?;
+        writeln!(out, "    (i64.extend_i32_u (local.get $ptr))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_box_get_i64 (param $box i64) (result i64)")?;
+        writeln!(out, "    (i64.load (i32.wrap_i64 (local.get $box)))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_box_set_i64 (param $box i64) (param $value i64)")?;
+        writeln!(out, "    (i64.store (i32.wrap_i64 (local.get $box)) (local.get $value))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_box_free_i64 (param $box i64)")?;
+        writeln!(out, "    (call $bmb_free (i32.wrap_i64 (local.get $box)))")?;
+        writeln!(out, "  )")?;
+        Ok(())
+    }
+
+    /// Emit string primitives; strings are `[len: i32][bytes]`
+    fn emit_string_runtime(&self, out: &mut String) -> WasmCodeGenResult<()> {
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_string_new: Allocate a string of $len bytes (contents uninitialized)")?;
+        writeln!(out, "  (func $bmb_string_new (param $len i32) (result i32)")?;
+        writeln!(out, "    (local $s i32)")?;
+        writeln!(out, "    (local.set $s (call $bmb_alloc (i32.add (local.get $len) (i32.const 4))))")?;
+        writeln!(out, "    (i32.store (local.get $s) (local.get $len))")?;
+        writeln!(out, "    (local.get $s)")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_string_concat: a + b with two bulk copies")?;
+        writeln!(out, "  (func $bmb_string_concat (param $a i32) (param $b i32) (result i32)")?;
+        writeln!(out, "    (local $la i32)")?;
+        writeln!(out, "    (local $lb i32)")?;
+        writeln!(out, "    (local $s i32)")?;
+        writeln!(out, "    (local.set $la (i32.load (local.get $a)))")?;
+        writeln!(out, "    (local.set $lb (i32.load (local.get $b)))")?;
+        writeln!(out, "    (local.set $s (call $bmb_string_new (i32.add (local.get $la) (local.get $lb))))")?;
+        writeln!(out, "    (memory.copy (i32.add (local.get $s) (i32.const 4)) (i32.add (local.get $a) (i32.const 4)) (local.get $la))")?;
+        writeln!(out, "    (memory.copy (i32.add (i32.add (local.get $s) (i32.const 4)) (local.get $la)) (i32.add (local.get $b) (i32.const 4)) (local.get $lb))")?;
+        writeln!(out, "    (local.get $s)")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_string_slice: Bytes [start, end) clamped to the string")?;
+        writeln!(out, "  (func $bmb_string_slice (param $s i32) (param $start i64) (param $end i64) (result i32)")?;
+        writeln!(out, "    (local $len i64)")?;
+        writeln!(out, "    (local $r i32)")?;
+        writeln!(out, "    (local.set $len (i64.extend_i32_u (i32.load (local.get $s))))")?;
+        writeln!(out, "    (if (i64.lt_s (local.get $start) (i64.const 0)) (then (local.set $start (i64.const 0))))")?;
+        writeln!(out, "    (if (i64.gt_s (local.get $start) (local.get $len)) (then (local.set $start (local.get $len))))")?;
+        writeln!(out, "    (if (i64.gt_s (local.get $end) (local.get $len)) (then (local.set $end (local.get $len))))")?;
+        writeln!(out, "    (if (i64.lt_s (local.get $end) (local.get $start)) (then (local.set $end (local.get $start))))")?;
+        writeln!(out, "    (local.set $r (call $bmb_string_new (i32.wrap_i64 (i64.sub (local.get $end) (local.get $start)))))")?;
+        writeln!(out, "    (memory.copy")?;
+        writeln!(out, "      (i32.add (local.get $r) (i32.const 4))")?;
+        writeln!(out, "      (i32.add (i32.add (local.get $s) (i32.const 4)) (i32.wrap_i64 (local.get $start)))")?;
+        writeln!(out, "      (i32.load (local.get $r)))")?;
+        writeln!(out, "    (local.get $r)")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_string_len (param $s i32) (result i64)")?;
+        writeln!(out, "    (i64.extend_i32_u (i32.load (local.get $s)))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_string_byte_at: Byte at index (0 when out of range)")?;
+        writeln!(out, "  (func $bmb_string_byte_at (param $s i32) (param $i i64) (result i64)")?;
+        writeln!(out, "    (if (i64.ge_u (local.get $i) (i64.extend_i32_u (i32.load (local.get $s))))")?;
+        writeln!(out, "      (then (return (i64.const 0)))")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i64.load8_u (i32.add (i32.add (local.get $s) (i32.const 4)) (i32.wrap_i64 (local.get $i))))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_string_eq: 1 if both strings hold the same bytes")?;
+        writeln!(out, "  (func $bmb_string_eq (param $a i32) (param $b i32) (result i32)")?;
+        writeln!(out, "    (local $len i32)")?;
+        writeln!(out, "    (local $i i32)")?;
+        writeln!(out, "    (if (i32.eq (local.get $a) (local.get $b)) (then (return (i32.const 1))))")?;
+        writeln!(out, "    (local.set $len (i32.load (local.get $a)))")?;
+        writeln!(out, "    (if (i32.ne (local.get $len) (i32.load (local.get $b))) (then (return (i32.const 0))))")?;
+        writeln!(out, "    (local.set $a (i32.add (local.get $a) (i32.const 4)))")?;
+        writeln!(out, "    (local.set $b (i32.add (local.get $b) (i32.const 4)))")?;
+        writeln!(out, "    ;; Eight bytes at a time, then the tail")?;
+        writeln!(out, "    (block $words_done")?;
+        writeln!(out, "      (loop $words")?;
+        writeln!(out, "        (br_if $words_done (i32.gt_u (i32.add (local.get $i) (i32.const 8)) (local.get $len)))")?;
+        writeln!(out, "        (if (i64.ne (i64.load (i32.add (local.get $a) (local.get $i))) (i64.load (i32.add (local.get $b) (local.get $i))))")?;
+        writeln!(out, "          (then (return (i32.const 0)))")?;
+        writeln!(out, "        )")?;
+        writeln!(out, "        (local.set $i (i32.add (local.get $i) (i32.const 8)))")?;
+        writeln!(out, "        (br $words)")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (block $done")?;
+        writeln!(out, "      (loop $bytes")?;
+        writeln!(out, "        (br_if $done (i32.ge_u (local.get $i) (local.get $len)))")?;
+        writeln!(out, "        (if (i32.ne (i32.load8_u (i32.add (local.get $a) (local.get $i))) (i32.load8_u (i32.add (local.get $b) (local.get $i))))")?;
+        writeln!(out, "          (then (return (i32.const 0)))")?;
+        writeln!(out, "        )")?;
+        writeln!(out, "        (local.set $i (i32.add (local.get $i) (i32.const 1)))")?;
+        writeln!(out, "        (br $bytes)")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i32.const 1)")?;
+        writeln!(out, "  )")?;
+        Ok(())
+    }
+
+    /// Emit the byte-scan kernels (`str_count_byte`, `str_find_byte`, `str_find`),
+    /// with a SIMD128 16-byte loop ahead of the scalar tail when enabled
+    fn emit_byte_scan_runtime(&self, out: &mut String) -> WasmCodeGenResult<()> {
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_str_count_byte: Occurrences of one byte")?;
+        writeln!(out, "  (func $bmb_str_count_byte (param $s i32) (param $byte i64) (result i64)")?;
+        writeln!(out, "    (local $p i32)")?;
+        writeln!(out, "    (local $end i32)")?;
+        writeln!(out, "    (local $b i32)")?;
+        writeln!(out, "    (local $count i32)")?;
+        writeln!(out, "    (local.set $p (i32.add (local.get $s) (i32.const 4)))")?;
+        writeln!(out, "    (local.set $end (i32.add (local.get $p) (i32.load (local.get $s))))")?;
+        writeln!(out, "    (local.set $b (i32.and (i32.wrap_i64 (local.get $byte)) (i32.const 255)))")?;
+        if self.simd {
+            writeln!(out, "    ;; SIMD128: compare 16 bytes at a time and count the lane mask bits")?;
+            writeln!(out, "    (block $chunks_done")?;
+            writeln!(out, "      (loop $chunks")?;
+            writeln!(out, "        (br_if $chunks_done (i32.gt_u (i32.add (local.get $p) (i32.const 16)) (local.get $end)))")?;
+            writeln!(out, "        (local.set $count (i32.add (local.get $count)")?;
+            writeln!(out, "          (i32.popcnt (i8x16.bitmask (i8x16.eq (v128.load align=1 (local.get $p)) (i8x16.splat (local.get $b)))))))")?;
+            writeln!(out, "        (local.set $p (i32.add (local.get $p) (i32.const 16)))")?;
+            writeln!(out, "        (br $chunks)")?;
+            writeln!(out, "      )")?;
+            writeln!(out, "    )")?;
+        }
+        writeln!(out, "    (block $done")?;
+        writeln!(out, "      (loop $bytes")?;
+        writeln!(out, "        (br_if $done (i32.ge_u (local.get $p) (local.get $end)))")?;
+        writeln!(out, "        (local.set $count (i32.add (local.get $count) (i32.eq (i32.load8_u (local.get $p)) (local.get $b))))")?;
+        writeln!(out, "        (local.set $p (i32.add (local.get $p) (i32.const 1)))")?;
+        writeln!(out, "        (br $bytes)")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i64.extend_i32_u (local.get $count))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_str_find_byte: Index of the first $byte at or after $from, or -1")?;
+        writeln!(out, "  (func $bmb_str_find_byte (param $s i32) (param $byte i64) (param $from i64) (result i64)")?;
+        writeln!(out, "    (local $base i32)")?;
+        writeln!(out, "    (local $p i32)")?;
+        writeln!(out, "    (local $end i32)")?;
+        writeln!(out, "    (local $b i32)")?;
+        writeln!(out, "    (local $mask i32)")?;
+        writeln!(out, "    (if (i64.lt_s (local.get $from) (i64.const 0)) (then (local.set $from (i64.const 0))))")?;
+        writeln!(out, "    (if (i64.ge_s (local.get $from) (i64.extend_i32_u (i32.load (local.get $s))))")?;
+        writeln!(out, "      (then (return (i64.const -1)))")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (local.set $base (i32.add (local.get $s) (i32.const 4)))")?;
+        writeln!(out, "    (local.set $p (i32.add (local.get $base) (i32.wrap_i64 (local.get $from))))")?;
+        writeln!(out, "    (local.set $end (i32.add (local.get $base) (i32.load (local.get $s))))")?;
+        writeln!(out, "    (local.set $b (i32.and (i32.wrap_i64 (local.get $byte)) (i32.const 255)))")?;
+        if self.simd {
+            writeln!(out, "    ;; SIMD128: the first set bit of the lane mask is the first match")?;
+            writeln!(out, "    (block $chunks_done")?;
+            writeln!(out, "      (loop $chunks")?;
+            writeln!(out, "        (br_if $chunks_done (i32.gt_u (i32.add (local.get $p) (i32.const 16)) (local.get $end)))")?;
+            writeln!(out, "        (local.set $mask (i8x16.bitmask (i8x16.eq (v128.load align=1 (local.get $p)) (i8x16.splat (local.get $b)))))")?;
+            writeln!(out, "        (if (local.get $mask)")?;
+            writeln!(out, "          (then (return (i64.extend_i32_u (i32.add (i32.sub (local.get $p) (local.get $base)) (i32.ctz (local.get $mask))))))")?;
+            writeln!(out, "        )")?;
+            writeln!(out, "        (local.set $p (i32.add (local.get $p) (i32.const 16)))")?;
+            writeln!(out, "        (br $chunks)")?;
+            writeln!(out, "      )")?;
+            writeln!(out, "    )")?;
+        }
+        Ok(())
+    }
+
+    /// Emit the vector builtins
+    fn emit_vec_runtime(&self, out: &mut String) -> WasmCodeGenResult<()> {
+        writeln!(out)?;
+        writeln!(out, "  ;; Vectors: a 12-byte header [data, len, cap] over a block of i64 elements")?;
+        writeln!(out, "  (func $bmb_vec_with_capacity (param $cap i64) (result i64)")?;
+        writeln!(out, "    (local $v i32)")?;
+        writeln!(out, "    (local.set $v (call $bmb_alloc (i32.const 12)))")?;
+        writeln!(out, "    (i32.store (local.get $v) (i32.const 0))")?;
+        writeln!(out, "    (i32.store offset=4 (local.get $v) (i32.const 0))")?;
+        writeln!(out, "    (i32.store offset=8 (local.get $v) (i32.const 0))")?;
+        writeln!(out, "    (if (i64.gt_s (local.get $cap) (i64.const 0))")?;
+        writeln!(out, "      (then")?;
+        writeln!(out, "        (i32.store (local.get $v) (call $bmb_alloc (i32.shl (i32.wrap_i64 (local.get $cap)) (i32.const 3))))")?;
+        writeln!(out, "        (i32.store offset=8 (local.get $v) (i32.wrap_i64 (local.get $cap)))")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i64.extend_i32_u (local.get $v))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_vec_new (result i64)")?;
+        writeln!(out, "    (call $bmb_vec_with_capacity (i64.const 0))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_vec_push (param $vec i64) (param $value i64)")?;
+        writeln!(out, "    (local $v i32)")?;
+        writeln!(out, "    (local $len i32)")?;
+        writeln!(out, "    (local $cap i32)")?;
+        writeln!(out, "    (local.set $v (i32.wrap_i64 (local.get $vec)))")?;
+        writeln!(out, "    (local.set $len (i32.load offset=4 (local.get $v)))")?;
+        writeln!(out, "    (if (i32.ge_u (local.get $len) (i32.load offset=8 (local.get $v)))")?;
+        writeln!(out, "      (then")?;
+        writeln!(out, "        ;; Double the capacity (at least 8 elements)")?;
+        writeln!(out, "        (local.set $cap (i32.shl (i32.load offset=8 (local.get $v)) (i32.const 1)))")?;
+        writeln!(out, "        (if (i32.lt_u (local.get $cap) (i32.const 8)) (then (local.set $cap (i32.const 8))))")?;
+        writeln!(out, "        (i32.store (local.get $v)")?;
+        writeln!(out, "          (call $bmb_realloc (i32.load (local.get $v)) (i32.shl (local.get $cap) (i32.const 3))))")?;
+        writeln!(out, "        (i32.store offset=8 (local.get $v) (local.get $cap))")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i64.store (i32.add (i32.load (local.get $v)) (i32.shl (local.get $len) (i32.const 3))) (local.get $value))")?;
+        writeln!(out, "    (i32.store offset=4 (local.get $v) (i32.add (local.get $len) (i32.const 1)))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_vec_pop (param $vec i64) (result i64)")?;
+        writeln!(out, "    (local $v i32)")?;
+        writeln!(out, "    (local $len i32)")?;
+        writeln!(out, "    (local.set $v (i32.wrap_i64 (local.get $vec)))")?;
+        writeln!(out, "    (local.set $len (i32.load offset=4 (local.get $v)))")?;
+        writeln!(out, "    (if (i32.eqz (local.get $len)) (then (return (i64.const 0))))")?;
+        writeln!(out, "    (local.set $len (i32.sub (local.get $len) (i32.const 1)))")?;
+        writeln!(out, "    (i32.store offset=4 (local.get $v) (local.get $len))")?;
+        writeln!(out, "    (i64.load (i32.add (i32.load (local.get $v)) (i32.shl (local.get $len) (i32.const 3))))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_vec_get: Bounds-checked element load (traps when out of range)")?;
+        writeln!(out, "  (func $bmb_vec_get (param $vec i64) (param $index i64) (result i64)")?;
+        writeln!(out, "    (local $v i32)")?;
+        writeln!(out, "    (local.set $v (i32.wrap_i64 (local.get $vec)))")?;
+        writeln!(out, "    (if (i64.ge_u (local.get $index) (i64.extend_i32_u (i32.load offset=4 (local.get $v))))")?;
+        writeln!(out, "      (then unreachable)")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i64.load (i32.add (i32.load (local.get $v)) (i32.shl (i32.wrap_i64 (local.get $index)) (i32.const 3))))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_vec_set (param $vec i64) (param $index i64) (param $value i64)")?;
+        writeln!(out, "    (local $v i32)")?;
+        writeln!(out, "    (local.set $v (i32.wrap_i64 (local.get $vec)))")?;
+        writeln!(out, "    (if (i64.ge_u (local.get $index) (i64.extend_i32_u (i32.load offset=4 (local.get $v))))")?;
+        writeln!(out, "      (then unreachable)")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i64.store (i32.add (i32.load (local.get $v)) (i32.shl (i32.wrap_i64 (local.get $index)) (i32.const 3))) (local.get $value))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_vec_len (param $vec i64) (result i64)")?;
+        writeln!(out, "    (i64.extend_i32_u (i32.load offset=4 (i32.wrap_i64 (local.get $vec))))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_vec_cap (param $vec i64) (result i64)")?;
+        writeln!(out, "    (i64.extend_i32_u (i32.load offset=8 (i32.wrap_i64 (local.get $vec))))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_vec_clear (param $vec i64)")?;
+        writeln!(out, "    (i32.store offset=4 (i32.wrap_i64 (local.get $vec)) (i32.const 0))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_vec_free (param $vec i64)")?;
+        writeln!(out, "    (local $v i32)")?;
+        writeln!(out, "    (local.set $v (i32.wrap_i64 (local.get $vec)))")?;
+        writeln!(out, "    (if (i32.eqz (local.get $v)) (then (return)))")?;
+        writeln!(out, "    (call $bmb_free (i32.load (local.get $v)))")?;
+        writeln!(out, "    (call $bmb_free (local.get $v))")?;
+        writeln!(out, "  )")?;
+        Ok(())
+    }
+
+    /// Emit the StringBuilder builtins
+    fn emit_sb_runtime(&self, out: &mut String) -> WasmCodeGenResult<()> {
+        writeln!(out)?;
+        writeln!(out, "  ;; StringBuilders: a 12-byte header [buf, len, cap] over a growable byte block")?;
+        writeln!(out, "  (func $bmb_sb_new (result i64)")?;
+        writeln!(out, "    (local $sb i32)")?;
+        writeln!(out, "    (local.set $sb (call $bmb_alloc (i32.const 12)))")?;
+        writeln!(out, "    (i32.store (local.get $sb) (call $bmb_alloc (i32.const 64)))")?;
+        writeln!(out, "    (i32.store offset=4 (local.get $sb) (i32.const 0))")?;
+        writeln!(out, "    (i32.store offset=8 (local.get $sb) (i32.const 64))")?;
+        writeln!(out, "    (i64.extend_i32_u (local.get $sb))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_sb_reserve: Make room for $extra more bytes (geometric growth)")?;
+        writeln!(out, "  (func $bmb_sb_reserve (param $sb i32) (param $extra i32)")?;
+        writeln!(out, "    (local $need i32)")?;
+        writeln!(out, "    (local $cap i32)")?;
+        writeln!(out, "    (local.set $need (i32.add (i32.load offset=4 (local.get $sb)) (local.get $extra)))")?;
+        writeln!(out, "    (local.set $cap (i32.load offset=8 (local.get $sb)))")?;
+        writeln!(out, "    (if (i32.gt_u (local.get $need) (local.get $cap))")?;
+        writeln!(out, "      (then")?;
+        writeln!(out, "        (local.set $cap (i32.shl (local.get $cap) (i32.const 1)))")?;
+        writeln!(out, "        (if (i32.lt_u (local.get $cap) (local.get $need)) (then (local.set $cap (local.get $need))))")?;
+        writeln!(out, "        (i32.store (local.get $sb) (call $bmb_realloc (i32.load (local.get $sb)) (local.get $cap)))")?;
+        writeln!(out, "        (i32.store offset=8 (local.get $sb) (local.get $cap))")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_sb_push (param $handle i64) (param $s i32) (result i64)")?;
+        writeln!(out, "    (local $sb i32)")?;
+        writeln!(out, "    (local $len i32)")?;
+        writeln!(out, "    (local $n i32)")?;
+        writeln!(out, "    (local.set $sb (i32.wrap_i64 (local.get $handle)))")?;
+        writeln!(out, "    (local.set $n (i32.load (local.get $s)))")?;
+        writeln!(out, "    (call $bmb_sb_reserve (local.get $sb) (local.get $n))")?;
+        writeln!(out, "    (local.set $len (i32.load offset=4 (local.get $sb)))")?;
+        writeln!(out, "    (memory.copy (i32.add (i32.load (local.get $sb)) (local.get $len)) (i32.add (local.get $s) (i32.const 4)) (local.get $n))")?;
+        writeln!(out, "    (local.set $len (i32.add (local.get $len) (local.get $n)))")?;
+        writeln!(out, "    (i32.store offset=4 (local.get $sb) (local.get $len))")?;
+        writeln!(out, "    (i64.extend_i32_u (local.get $len))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_sb_push_char (param $handle i64) (param $c i64) (result i64)")?;
+        writeln!(out, "    (local $sb i32)")?;
+        writeln!(out, "    (local $len i32)")?;
+        writeln!(out, "    (local.set $sb (i32.wrap_i64 (local.get $handle)))")?;
+        writeln!(out, "    (call $bmb_sb_reserve (local.get $sb) (i32.const 1))")?;
+        writeln!(out, "    (local.set $len (i32.load offset=4 (local.get $sb)))")?;
+        writeln!(out, "    (i32.store8 (i32.add (i32.load (local.get $sb)) (local.get $len)) (i32.wrap_i64 (local.get $c)))")?;
+        writeln!(out, "    (local.set $len (i32.add (local.get $len) (i32.const 1)))")?;
+        writeln!(out, "    (i32.store offset=4 (local.get $sb) (local.get $len))")?;
+        writeln!(out, "    (i64.extend_i32_u (local.get $len))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_sb_push_int: Append the decimal form of $n in place")?;
+        writeln!(out, "  (func $bmb_sb_push_int (param $handle i64) (param $n i64) (result i64)")?;
+        writeln!(out, "    (local $sb i32)")?;
+        writeln!(out, "    (local $u i64)")?;
+        writeln!(out, "    (local $p i32)")?;
+        writeln!(out, "    (local $lo i32)")?;
+        writeln!(out, "    (local $hi i32)")?;
+        writeln!(out, "    (local $t i32)")?;
+        writeln!(out, "    (local.set $sb (i32.wrap_i64 (local.get $handle)))")?;
+        writeln!(out, "    (call $bmb_sb_reserve (local.get $sb) (i32.const 20))")?;
+        writeln!(out, "    (local.set $p (i32.add (i32.load (local.get $sb)) (i32.load offset=4 (local.get $sb))))")?;
+        writeln!(out, "    (local.set $u (local.get $n))")?;
+        writeln!(out, "    (if (i64.lt_s (local.get $n) (i64.const 0))")?;
+        writeln!(out, "      (then")?;
+        writeln!(out, "        (i32.store8 (local.get $p) (i32.const 45))  ;; '-'")?;
+        writeln!(out, "        (local.set $p (i32.add (local.get $p) (i32.const 1)))")?;
+        writeln!(out, "        (local.set $u (i64.sub (i64.const 0) (local.get $n)))")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    ;; Digits come out reversed; write them, then swap into place")?;
+        writeln!(out, "    (local.set $lo (local.get $p))")?;
+        writeln!(out, "    (loop $digits")?;
+        writeln!(out, "      (i32.store8 (local.get $p) (i32.add (i32.const 48) (i32.wrap_i64 (i64.rem_u (local.get $u) (i64.const 10)))))")?;
+        writeln!(out, "      (local.set $p (i32.add (local.get $p) (i32.const 1)))")?;
+        writeln!(out, "      (local.set $u (i64.div_u (local.get $u) (i64.const 10)))")?;
+        writeln!(out, "      (br_if $digits (i64.ne (local.get $u) (i64.const 0)))")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (local.set $hi (i32.sub (local.get $p) (i32.const 1)))")?;
+        writeln!(out, "    (block $reversed")?;
+        writeln!(out, "      (loop $swap")?;
+        writeln!(out, "        (br_if $reversed (i32.ge_u (local.get $lo) (local.get $hi)))")?;
+        writeln!(out, "        (local.set $t (i32.load8_u (local.get $lo)))")?;
+        writeln!(out, "        (i32.store8 (local.get $lo) (i32.load8_u (local.get $hi)))")?;
+        writeln!(out, "        (i32.store8 (local.get $hi) (local.get $t))")?;
+        writeln!(out, "        (local.set $lo (i32.add (local.get $lo) (i32.const 1)))")?;
+        writeln!(out, "        (local.set $hi (i32.sub (local.get $hi) (i32.const 1)))")?;
+        writeln!(out, "        (br $swap)")?;
+        writeln!(out, "      )")?;
+        writeln!(out, "    )")?;
+        writeln!(out, "    (i32.store offset=4 (local.get $sb) (i32.sub (local.get $p) (i32.load (local.get $sb))))")?;
+        writeln!(out, "    (i64.extend_i32_u (i32.load offset=4 (local.get $sb)))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_sb_len (param $handle i64) (result i64)")?;
+        writeln!(out, "    (i64.extend_i32_u (i32.load offset=4 (i32.wrap_i64 (local.get $handle))))")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  ;; $bmb_sb_build: Copy the contents out as a string")?;
+        writeln!(out, "  (func $bmb_sb_build (param $handle i64) (result i32)")?;
+        writeln!(out, "    (local $sb i32)")?;
+        writeln!(out, "    (local $s i32)")?;
+        writeln!(out, "    (local.set $sb (i32.wrap_i64 (local.get $handle)))")?;
+        writeln!(out, "    (local.set $s (call $bmb_string_new (i32.load offset=4 (local.get $sb))))")?;
+        writeln!(out, "    (memory.copy (i32.add (local.get $s) (i32.const 4)) (i32.load (local.get $sb)) (i32.load offset=4 (local.get $sb)))")?;
+        writeln!(out, "    (local.get $s)")?;
+        writeln!(out, "  )")?;
+        writeln!(out)?;
+        writeln!(out, "  (func $bmb_sb_clear (param $handle i64) (result i64)")?;
+        writeln!(out, "    (i32.store offset=4 (i32.wrap_i64 (local.get $handle)) (i32.const 0))")?;
+        writeln!(out, "    (i64.const 0)")?;
+        writeln!(out, "  )")?;
+        Ok(())
+    }
+
     /// Emit a function definition
     fn emit_function(&self, out: &mut String, func: &MirFunction) -> WasmCodeGenResult<()> {
         // Function signature
@@ -577,6 +1234,22 @@ impl WasmCodeGen {
                     writeln!(out, "    i32.or")?;
                     // Store result
                     writeln!(out, "    local.set ${}", dest.name)?;
+                } else if matches!(op, MirBinOp::Add | MirBinOp::Eq | MirBinOp::Ne)
+                    && (self.infer_operand_mir_type(lhs, func) == MirType::String
+                        || self.infer_operand_mir_type(rhs, func) == MirType::String)
+                {
+                    // String concatenation and comparison go through the runtime
+                    self.emit_operand(out, lhs)?;
+                    self.emit_operand(out, rhs)?;
+                    if *op == MirBinOp::Add {
+                        writeln!(out, "    call $bmb_string_concat")?;
+                    } else {
+                        writeln!(out, "    call $bmb_string_eq")?;
+                        if *op == MirBinOp::Ne {
+                            writeln!(out, "    i32.eqz")?;
+                        }
+                    }
+                    writeln!(out, "    local.set ${}", dest.name)?;
                 } else {
                     // Push operands
                     self.emit_operand(out, lhs)?;
@@ -626,6 +1299,23 @@ impl WasmCodeGen {
                     self.emit_operand(out, arg)?;
                 }
 
+                // Builtins with a WASM runtime implementation
+                if let Some((callee, returns)) = self.runtime_builtin(fn_name) {
+                    writeln!(out, "    call ${}", callee)?;
+                    match (dest, returns) {
+                        (Some(d), true) => writeln!(out, "    local.set ${}", d.name)?,
+                        (Some(d), false) => {
+                            // Unit builtins still get a destination from lowering
+                            let default = self.default_value(&self.infer_place_mir_type(&d.name, func));
+                            writeln!(out, "    {}", if default.is_empty() { "i32.const 0" } else { default })?;
+                            writeln!(out, "    local.set ${}", d.name)?;
+                        }
+                        (None, true) => writeln!(out, "    drop")?,
+                        (None, false) => {}
+                    }
+                    return Ok(());
+                }
+
                 // Call function
                 writeln!(out, "    call ${}", fn_name)?;
 
@@ -643,11 +1333,10 @@ impl WasmCodeGen {
 
             // v0.19.0: Struct operations
             MirInst::StructInit { dest, struct_name, fields } => {
-                // In WASM, structs are stored in linear memory
-                // For now, allocate space on the stack and store field values
+                // In WASM, structs are stored in linear memory, 8 bytes per field
                 writeln!(out, "    ;; struct {} init with {} fields", struct_name, fields.len())?;
-                // Allocate memory (simplified: just store pointer in local)
-                writeln!(out, "    i32.const 0  ;; TODO: proper memory allocation")?;
+                writeln!(out, "    i32.const {}", fields.len().max(1) * 8)?;
+                writeln!(out, "    call $bmb_alloc")?;
                 writeln!(out, "    local.set ${}", dest.name)?;
                 for (i, (field_name, value)) in fields.iter().enumerate() {
                     writeln!(out, "    ;; field {} at offset {}", field_name, i * 8)?;
@@ -681,13 +1370,12 @@ impl WasmCodeGen {
             }
 
             // v0.19.1: Enum variant
-            MirInst::EnumVariant { dest, enum_name, variant, args } => {
+            MirInst::EnumVariant { dest, enum_name, variant, discriminant, args } => {
                 // Enums are represented as tagged unions in linear memory
                 writeln!(out, "    ;; enum {}::{} with {} args", enum_name, variant, args.len())?;
-                // Calculate discriminant (simplified: hash of variant name)
-                let discriminant: i64 = variant.bytes().fold(0i64, |acc, b| acc.wrapping_mul(31).wrapping_add(b as i64));
-                // Allocate memory (simplified: just use a constant address)
-                writeln!(out, "    i32.const 0  ;; TODO: proper memory allocation")?;
+                // Discriminant word followed by the arguments
+                writeln!(out, "    i32.const {}", (args.len() + 1) * 8)?;
+                writeln!(out, "    call $bmb_alloc")?;
                 writeln!(out, "    local.set ${}", dest.name)?;
                 // Store discriminant at offset 0
                 writeln!(out, "    local.get ${}", dest.name)?;
@@ -706,9 +1394,9 @@ impl WasmCodeGen {
             // v0.19.3: Array operations
             MirInst::ArrayInit { dest, element_type: _, elements } => {
                 writeln!(out, "    ;; array init with {} elements", elements.len())?;
-                // Allocate memory for array (simplified: use constant address)
-                let size = elements.len() * 8; // 8 bytes per element
-                writeln!(out, "    i32.const 0  ;; TODO: proper memory allocation for {} bytes", size)?;
+                // 8 bytes per element
+                writeln!(out, "    i32.const {}", elements.len().max(1) * 8)?;
+                writeln!(out, "    call $bmb_alloc")?;
                 writeln!(out, "    local.set ${}", dest.name)?;
                 // Store each element
                 for (i, elem) in elements.iter().enumerate() {
@@ -757,10 +1445,16 @@ impl WasmCodeGen {
             Constant::Float(f) => writeln!(out, "    f64.const {}", f)?,
             Constant::Bool(b) => writeln!(out, "    i32.const {}", if *b { 1 } else { 0 })?,
             Constant::Unit => writeln!(out, "    ;; unit (no value)")?,
-            Constant::String(_s) => {
-                // String constants require memory management
-                writeln!(out, "    ;; TODO: string constant")?;
-                writeln!(out, "    i32.const 0")?;
+            // The WASM runtime has no thread pool (and no function tables)
+            Constant::FnRef(name) => {
+                return Err(WasmCodeGenError::UnsupportedFeature(format!("function reference `{}`", name)));
+            }
+            Constant::String(s) => {
+                // Address of the constant's data segment
+                let addr = self.strings.get(s).ok_or_else(|| {
+                    WasmCodeGenError::UnsupportedFeature(format!("string constant {:?} outside the data layout", s))
+                })?;
+                writeln!(out, "    i32.const {}", addr)?;
             }
             // v0.64: Character constant (Unicode codepoint as i32)
             Constant::Char(c) => writeln!(out, "    i32.const {}", *c as u32)?,
@@ -768,6 +1462,52 @@ impl WasmCodeGen {
         Ok(())
     }
 
+    /// The WASM runtime function implementing a BMB builtin, and whether it
+    /// returns a value. Functions defined by the program take precedence.
+    fn runtime_builtin(&self, name: &str) -> Option<(&'static str, bool)> {
+        if self.user_fns.contains(name) {
+            return None;
+        }
+        let builtin = match name {
+            "len" | "str_len" => ("bmb_string_len", true),
+            "byte_at" => ("bmb_string_byte_at", true),
+            "slice" => ("bmb_string_slice", true),
+            "str_find" => ("bmb_str_find", true),
+            "str_find_byte" => ("bmb_str_find_byte", true),
+            "str_count_byte" => ("bmb_str_count_byte", true),
+            "sb_new" => ("bmb_sb_new", true),
+            "sb_push" => ("bmb_sb_push", true),
+            "sb_push_char" => ("bmb_sb_push_char", true),
+            "sb_push_int" => ("bmb_sb_push_int", true),
+            "sb_len" => ("bmb_sb_len", true),
+            "sb_build" => ("bmb_sb_build", true),
+            "sb_clear" => ("bmb_sb_clear", true),
+            "vec_new" => ("bmb_vec_new", true),
+            "vec_with_capacity" => ("bmb_vec_with_capacity", true),
+            "vec_push" => ("bmb_vec_push", false),
+            "vec_pop" => ("bmb_vec_pop", true),
+            "vec_get" => ("bmb_vec_get", true),
+            "vec_set" => ("bmb_vec_set", false),
+            "vec_len" => ("bmb_vec_len", true),
+            "vec_cap" => ("bmb_vec_cap", true),
+            "vec_clear" => ("bmb_vec_clear", false),
+            "vec_free" => ("bmb_vec_free", false),
+            "box_new_i64" => ("bmb_box_new_i64", true),
+            "box_get_i64" => ("bmb_box_get_i64", true),
+            "box_set_i64" => ("bmb_box_set_i64", false),
+            "box_free_i64" => ("bmb_box_free_i64", false),
+            "malloc" => ("bmb_malloc", true),
+            "calloc" => ("bmb_calloc", true),
+            "realloc" => ("bmb_realloc_i64", true),
+            "free" => ("bmb_free_i64", false),
+            "load_i64" => ("bmb_load_i64", true),
+            "store_i64" => ("bmb_store_i64", false),
+            "print_str" if self.target == WasmTarget::Wasi => ("print_str", false),
+            _ => return None,
+        };
+        Some(builtin)
+    }
+
     /// Emit an operand (push to stack)
     fn emit_operand(&self, out: &mut String, op: &Operand) -> WasmCodeGenResult<()> {
         match op {
@@ -987,6 +1727,7 @@ impl WasmCodeGen {
                     // v0.64: Character type
                     Constant::Char(_) => MirType::Char,
                     Constant::Unit => MirType::Unit,
+                    Constant::FnRef(_) => MirType::I64,
                 };
                 Some((dest.name.clone(), ty))
             }
@@ -1097,6 +1838,7 @@ impl WasmCodeGen {
                 // v0.64: Character type
                 Constant::Char(_) => MirType::Char,
                 Constant::Unit => MirType::Unit,
+                Constant::FnRef(_) => MirType::I64,
             },
             Operand::Place(p) => self.infer_place_mir_type(&p.name, func),
         }
@@ -1113,6 +1855,7 @@ impl WasmCodeGen {
                 // v0.64: Character type
                 Constant::Char(_) => "i32",
                 Constant::Unit => "i32",
+                Constant::FnRef(_) => "i64",
             },
             Operand::Place(p) => {
                 // Check parameters
@@ -1134,6 +1877,24 @@ impl WasmCodeGen {
     }
 }
 
+/// Escape bytes for a WAT string literal
+fn wat_string(bytes: &[u8]) -> String {
+    let mut s = String::with_capacity(bytes.len());
+    for &b in bytes {
+        match b {
+            b'"' | b'\\' => {
+                s.push('\\');
+                s.push(b as char);
+            }
+            0x20..=0x7e => s.push(b as char),
+            _ => {
+                let _ = write!(s, "\\{:02x}", b);
+            }
+        }
+    }
+    s
+}
+
 impl Default for WasmCodeGen {
     fn default() -> Self {
         Self::new()
@@ -1357,4 +2118,108 @@ mod tests {
         assert!(wat.contains("(param i32 i32 i32 i32)"));
         assert!(wat.contains("(result i32)"));
     }
+
+    fn string_program() -> MirProgram {
+        MirProgram {
+            functions: vec![MirFunction {
+                name: "main".to_string(),
+                params: vec![],
+                ret_ty: MirType::I64,
+                locals: vec![
+                    ("s".to_string(), MirType::String),
+                    ("t".to_string(), MirType::String),
+                    ("n".to_string(), MirType::I64),
+                    ("p".to_string(), MirType::Struct { name: "P".to_string(), fields: vec![] }),
+                ],
+                blocks: vec![BasicBlock {
+                    label: "entry".to_string(),
+                    instructions: vec![
+                        MirInst::BinOp {
+                            dest: Place::new("s"),
+                            op: MirBinOp::Add,
+                            lhs: Operand::Constant(Constant::String("say \"hi\"\n".to_string())),
+                            rhs: Operand::Constant(Constant::String("!".to_string())),
+                        },
+                        MirInst::Call {
+                            dest: Some(Place::new("t")),
+                            func: "slice".to_string(),
+                            args: vec![
+                                Operand::Place(Place::new("s")),
+                                Operand::Constant(Constant::Int(1)),
+                                Operand::Constant(Constant::Int(3)),
+                            ],
+                        },
+                        MirInst::Call {
+                            dest: Some(Place::new("n")),
+                            func: "vec_push".to_string(),
+                            args: vec![Operand::Constant(Constant::Int(0)), Operand::Constant(Constant::Int(1))],
+                        },
+                        MirInst::StructInit {
+                            dest: Place::new("p"),
+                            struct_name: "P".to_string(),
+                            fields: vec![("x".to_string(), Operand::Constant(Constant::Int(1)))],
+                        },
+                    ],
+                    terminator: Terminator::Return(Some(Operand::Constant(Constant::Int(0)))),
+                }],
+                preconditions: vec![],
+                postconditions: vec![],
+                is_pure: false,
+                is_const: false,
+            }],
+            extern_fns: vec![],
+        }
+    }
+
+    #[test]
+    fn test_string_constants_and_heap_runtime() {
+        let wat = WasmCodeGen::with_target(WasmTarget::Standalone).generate(&string_program()).unwrap();
+
+        // Constants are [len][bytes] segments from DATA_BASE; the heap follows
+        assert!(wat.contains(r#"(data (i32.const 1024) "\09\00\00\00say \"hi\"\0a")"#), "{}", wat);
+        assert!(wat.contains(r#"(data (i32.const 1040) "\01\00\00\00!")"#));
+        assert!(wat.contains("(global $heap_ptr (mut i32) (i32.const 1056))"));
+
+        // Concat, slice and struct allocation use the runtime
+        assert!(wat.contains("i32.const 1024\n    i32.const 1040\n    call $bmb_string_concat"));
+        assert!(wat.contains("call $bmb_string_slice\n    local.set $t"));
+        assert!(wat.contains("i32.const 8\n    call $bmb_alloc\n    local.set $p"));
+        assert!(!wat.contains("TODO"));
+        // vec_push returns nothing in WASM; its i64 destination gets a zero
+        assert!(wat.contains("call $bmb_vec_push\n    i64.const 0\n    local.set $n"));
+
+        // Allocator grows memory; strings copy in bulk
+        assert!(wat.contains("(func $bmb_alloc (param $size i32) (result i32)"));
+        assert!(wat.contains("memory.grow"));
+        assert!(wat.contains("(memory.copy"));
+        assert!(wat.contains("(memory.fill"));
+        assert_eq!(wat.matches('(').count(), wat.matches(')').count());
+    }
+
+    #[test]
+    fn test_simd_byte_scan_is_opt_in() {
+        let program = MirProgram { functions: vec![], extern_fns: vec![] };
+        let scalar = WasmCodeGen::new().generate(&program).unwrap();
+        let simd = WasmCodeGen::new().with_simd(true).generate(&program).unwrap();
+
+        assert!(scalar.contains("(func $bmb_str_count_byte"));
+        assert!(!scalar.contains("v128"));
+        assert_eq!(simd.matches("i8x16.bitmask").count(), 2);
+        assert!(simd.contains("(v128.load align=1"));
+        assert_eq!(simd.matches('(').count(), simd.matches(')').count());
+    }
+
+    #[test]
+    fn test_user_function_shadows_builtin() {
+        let mut program = string_program();
+        let mut slice_fn = program.functions[0].clone();
+        slice_fn.name = "slice".to_string();
+        program.functions.push(slice_fn);
+
+        let wat = WasmCodeGen::new().generate(&program).unwrap();
+        assert!(wat.contains("call $slice\n"));
+        assert!(!wat.contains("call $bmb_string_slice\n    local.set $t"));
+        // print_str is WASI-only
+        assert!(wat.contains("(func $print_str"));
+    }
 }
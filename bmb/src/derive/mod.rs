@@ -122,11 +122,11 @@ impl<'a> DeriveContext<'a> {
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::ast::{Spanned, Span};
+    use crate::ast::{Spanned, Span, Symbol};
 
     fn make_derive_attr(traits: &[&str]) -> Attribute {
         let args: Vec<_> = traits.iter().map(|t| {
-            Spanned::new(Expr::Var(t.to_string()), Span::new(0, t.len()))
+            Spanned::new(Expr::Var(Symbol::intern(t)), Span::new(0, t.len()))
         }).collect();
 
         Attribute::WithArgs {
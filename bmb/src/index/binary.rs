@@ -0,0 +1,504 @@
+//! Compact binary encoding of the project index
+//!
+//! `.bmb/index/index.bin` holds the same data as the JSON files, in a form
+//! that is cheap to load for long-running consumers such as `bmb q serve`:
+//!
+//! ```text
+//! "BMBI" version:u8
+//! strings: count, (len, utf8 bytes)*
+//! manifest, symbols, functions, types
+//! ```
+//!
+//! Integers are LEB128 varints and every string (names, file paths, types)
+//! is stored once in the string table and referenced by id, so repeated file
+//! names and type names cost a byte or two each. An optional string is
+//! encoded as `0` for `None` or `id + 1`.
+
+use super::{
+    BodyInfo, ContractExpr, ContractInfo, FieldInfo, FunctionEntry, FunctionSignature, Manifest,
+    ParamInfo, ProjectIndex, RefinementInfo, SymbolEntry, SymbolKind, TypeEntry,
+};
+use std::collections::HashMap;
+use std::io;
+
+const MAGIC: &[u8; 4] = b"BMBI";
+const FORMAT_VERSION: u8 = 1;
+
+/// Encode an index into the binary format
+pub fn encode(index: &ProjectIndex) -> Vec<u8> {
+    let mut enc = Encoder::default();
+
+    let m = &index.manifest;
+    for s in [&m.version, &m.bmb_version, &m.project, &m.indexed_at] {
+        enc.str(s);
+    }
+    for n in [m.files, m.functions, m.types, m.structs, m.enums, m.contracts] {
+        enc.uint(n);
+    }
+
+    enc.uint(index.symbols.len());
+    for sym in &index.symbols {
+        enc.body.push(symbol_kind_tag(sym.kind));
+        enc.str(&sym.name);
+        enc.str(&sym.file);
+        enc.uint(sym.line);
+        enc.bool(sym.is_pub);
+        enc.opt_str(sym.signature.as_deref());
+        enc.opt_str(sym.doc.as_deref());
+    }
+
+    enc.uint(index.functions.len());
+    for f in &index.functions {
+        enc.str(&f.name);
+        enc.str(&f.file);
+        enc.uint(f.line);
+        enc.bool(f.is_pub);
+        enc.uint(f.signature.params.len());
+        for p in &f.signature.params {
+            enc.str(&p.name);
+            enc.str(&p.ty);
+        }
+        enc.str(&f.signature.return_type);
+        match &f.contracts {
+            None => enc.bool(false),
+            Some(c) => {
+                enc.bool(true);
+                enc.opt_contracts(c.pre.as_deref());
+                enc.opt_contracts(c.post.as_deref());
+            }
+        }
+        match &f.body_info {
+            None => enc.bool(false),
+            Some(b) => {
+                enc.bool(true);
+                enc.strs(&b.calls);
+                enc.body.push(b.recursive as u8 | (b.has_loop as u8) << 1);
+            }
+        }
+    }
+
+    enc.uint(index.types.len());
+    for t in &index.types {
+        enc.str(&t.name);
+        enc.str(&t.file);
+        enc.uint(t.line);
+        enc.bool(t.is_pub);
+        enc.str(&t.kind);
+        enc.uint(t.fields.len());
+        for field in &t.fields {
+            enc.str(&field.name);
+            enc.str(&field.ty);
+        }
+        enc.strs(&t.variants);
+        match &t.refinement {
+            None => enc.bool(false),
+            Some(r) => {
+                enc.bool(true);
+                enc.str(&r.base);
+                enc.str(&r.constraint);
+            }
+        }
+    }
+
+    enc.finish()
+}
+
+/// Decode an index written by [`encode`]
+pub fn decode(bytes: &[u8]) -> io::Result<ProjectIndex> {
+    if bytes.len() < MAGIC.len() + 1 || &bytes[..MAGIC.len()] != MAGIC {
+        return Err(invalid("not a BMB binary index"));
+    }
+    if bytes[MAGIC.len()] != FORMAT_VERSION {
+        return Err(invalid("unsupported binary index version"));
+    }
+
+    let mut dec = Decoder { bytes, pos: MAGIC.len() + 1, strings: Vec::new() };
+    let count = dec.uint()?;
+    for _ in 0..count {
+        let len = dec.uint()?;
+        let raw = dec.take(len)?;
+        let s = std::str::from_utf8(raw).map_err(|_| invalid("string table is not UTF-8"))?;
+        dec.strings.push(s.to_string());
+    }
+
+    let manifest = Manifest {
+        version: dec.str()?,
+        bmb_version: dec.str()?,
+        project: dec.str()?,
+        indexed_at: dec.str()?,
+        files: dec.uint()?,
+        functions: dec.uint()?,
+        types: dec.uint()?,
+        structs: dec.uint()?,
+        enums: dec.uint()?,
+        contracts: dec.uint()?,
+    };
+
+    let symbols = dec.list(|dec| {
+        Ok(SymbolEntry {
+            kind: symbol_kind_from_tag(dec.byte()?)?,
+            name: dec.str()?,
+            file: dec.str()?,
+            line: dec.uint()?,
+            is_pub: dec.bool()?,
+            signature: dec.opt_str()?,
+            doc: dec.opt_str()?,
+        })
+    })?;
+
+    let functions = dec.list(|dec| {
+        let name = dec.str()?;
+        let file = dec.str()?;
+        let line = dec.uint()?;
+        let is_pub = dec.bool()?;
+        let params = dec.list(|dec| Ok(ParamInfo { name: dec.str()?, ty: dec.str()? }))?;
+        let return_type = dec.str()?;
+        let contracts = if dec.bool()? {
+            Some(ContractInfo { pre: dec.opt_contracts()?, post: dec.opt_contracts()? })
+        } else {
+            None
+        };
+        let body_info = if dec.bool()? {
+            let calls = dec.strs()?;
+            let flags = dec.byte()?;
+            Some(BodyInfo { calls, recursive: flags & 1 != 0, has_loop: flags & 2 != 0 })
+        } else {
+            None
+        };
+        Ok(FunctionEntry {
+            name,
+            file,
+            line,
+            is_pub,
+            signature: FunctionSignature { params, return_type },
+            contracts,
+            body_info,
+        })
+    })?;
+
+    let types = dec.list(|dec| {
+        Ok(TypeEntry {
+            name: dec.str()?,
+            file: dec.str()?,
+            line: dec.uint()?,
+            is_pub: dec.bool()?,
+            kind: dec.str()?,
+            fields: dec.list(|dec| Ok(FieldInfo { name: dec.str()?, ty: dec.str()? }))?,
+            variants: dec.strs()?,
+            refinement: if dec.bool()? {
+                Some(RefinementInfo { base: dec.str()?, constraint: dec.str()? })
+            } else {
+                None
+            },
+        })
+    })?;
+
+    if dec.pos != bytes.len() {
+        return Err(invalid("trailing bytes after binary index"));
+    }
+
+    Ok(ProjectIndex { manifest, symbols, functions, types })
+}
+
+fn symbol_kind_tag(kind: SymbolKind) -> u8 {
+    match kind {
+        SymbolKind::Function => 0,
+        SymbolKind::Struct => 1,
+        SymbolKind::Enum => 2,
+        SymbolKind::Type => 3,
+        SymbolKind::Trait => 4,
+        SymbolKind::Const => 5,
+    }
+}
+
+fn symbol_kind_from_tag(tag: u8) -> io::Result<SymbolKind> {
+    Ok(match tag {
+        0 => SymbolKind::Function,
+        1 => SymbolKind::Struct,
+        2 => SymbolKind::Enum,
+        3 => SymbolKind::Type,
+        4 => SymbolKind::Trait,
+        5 => SymbolKind::Const,
+        _ => return Err(invalid("unknown symbol kind")),
+    })
+}
+
+fn invalid(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, msg.to_string())
+}
+
+#[derive(Default)]
+struct Encoder {
+    strings: Vec<String>,
+    ids: HashMap<String, usize>,
+    body: Vec<u8>,
+}
+
+impl Encoder {
+    fn uint(&mut self, n: usize) {
+        write_uint(&mut self.body, n);
+    }
+
+    fn bool(&mut self, b: bool) {
+        self.body.push(b as u8);
+    }
+
+    fn intern(&mut self, s: &str) -> usize {
+        if let Some(&id) = self.ids.get(s) {
+            return id;
+        }
+        let id = self.strings.len();
+        self.strings.push(s.to_string());
+        self.ids.insert(s.to_string(), id);
+        id
+    }
+
+    fn str(&mut self, s: &str) {
+        let id = self.intern(s);
+        self.uint(id);
+    }
+
+    fn opt_str(&mut self, s: Option<&str>) {
+        match s {
+            None => self.uint(0),
+            Some(s) => {
+                let id = self.intern(s);
+                self.uint(id + 1);
+            }
+        }
+    }
+
+    fn strs(&mut self, list: &[String]) {
+        self.uint(list.len());
+        for s in list {
+            self.str(s);
+        }
+    }
+
+    fn opt_contracts(&mut self, list: Option<&[ContractExpr]>) {
+        let Some(list) = list else {
+            self.bool(false);
+            return;
+        };
+        self.bool(true);
+        self.uint(list.len());
+        for c in list {
+            self.str(&c.expr);
+            self.strs(&c.quantifiers);
+            self.strs(&c.calls);
+            self.body.push(c.uses_old as u8 | (c.uses_ret as u8) << 1);
+        }
+    }
+
+    fn finish(self) -> Vec<u8> {
+        let mut out = Vec::with_capacity(self.body.len() + 16 * self.strings.len());
+        out.extend_from_slice(MAGIC);
+        out.push(FORMAT_VERSION);
+        write_uint(&mut out, self.strings.len());
+        for s in &self.strings {
+            write_uint(&mut out, s.len());
+            out.extend_from_slice(s.as_bytes());
+        }
+        out.extend_from_slice(&self.body);
+        out
+    }
+}
+
+fn write_uint(out: &mut Vec<u8>, mut n: usize) {
+    while n >= 0x80 {
+        out.push((n as u8) | 0x80);
+        n >>= 7;
+    }
+    out.push(n as u8);
+}
+
+struct Decoder<'a> {
+    bytes: &'a [u8],
+    pos: usize,
+    strings: Vec<String>,
+}
+
+impl<'a> Decoder<'a> {
+    fn byte(&mut self) -> io::Result<u8> {
+        let b = *self.bytes.get(self.pos).ok_or_else(|| invalid("truncated binary index"))?;
+        self.pos += 1;
+        Ok(b)
+    }
+
+    fn take(&mut self, len: usize) -> io::Result<&'a [u8]> {
+        let end = self.pos.checked_add(len).filter(|&e| e <= self.bytes.len());
+        let end = end.ok_or_else(|| invalid("truncated binary index"))?;
+        let slice = &self.bytes[self.pos..end];
+        self.pos = end;
+        Ok(slice)
+    }
+
+    fn uint(&mut self) -> io::Result<usize> {
+        let mut n: usize = 0;
+        let mut shift = 0;
+        loop {
+            let b = self.byte()?;
+            if shift >= usize::BITS {
+                return Err(invalid("varint overflow"));
+            }
+            n |= ((b & 0x7f) as usize) << shift;
+            if b & 0x80 == 0 {
+                return Ok(n);
+            }
+            shift += 7;
+        }
+    }
+
+    fn bool(&mut self) -> io::Result<bool> {
+        Ok(self.byte()? != 0)
+    }
+
+    fn string(&self, id: usize) -> io::Result<String> {
+        self.strings.get(id).cloned().ok_or_else(|| invalid("string id out of range"))
+    }
+
+    fn str(&mut self) -> io::Result<String> {
+        let id = self.uint()?;
+        self.string(id)
+    }
+
+    fn opt_str(&mut self) -> io::Result<Option<String>> {
+        match self.uint()? {
+            0 => Ok(None),
+            id => self.string(id - 1).map(Some),
+        }
+    }
+
+    fn list<T>(&mut self, mut item: impl FnMut(&mut Self) -> io::Result<T>) -> io::Result<Vec<T>> {
+        let len = self.uint()?;
+        // Every element takes at least one byte; reject lengths a corrupt
+        // file could use to request a huge allocation
+        if len > self.bytes.len() - self.pos {
+            return Err(invalid("truncated binary index"));
+        }
+        let mut out = Vec::with_capacity(len);
+        for _ in 0..len {
+            out.push(item(self)?);
+        }
+        Ok(out)
+    }
+
+    fn strs(&mut self) -> io::Result<Vec<String>> {
+        self.list(|dec| dec.str())
+    }
+
+    fn opt_contracts(&mut self) -> io::Result<Option<Vec<ContractExpr>>> {
+        if !self.bool()? {
+            return Ok(None);
+        }
+        self.list(|dec| {
+            let expr = dec.str()?;
+            let quantifiers = dec.strs()?;
+            let calls = dec.strs()?;
+            let flags = dec.byte()?;
+            Ok(ContractExpr {
+                expr,
+                quantifiers,
+                calls,
+                uses_old: flags & 1 != 0,
+                uses_ret: flags & 2 != 0,
+            })
+        })
+        .map(Some)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn sample_index() -> ProjectIndex {
+        let functions = vec![FunctionEntry {
+            name: "abs".to_string(),
+            file: "src/math.bmb".to_string(),
+            line: 3,
+            is_pub: true,
+            signature: FunctionSignature {
+                params: vec![ParamInfo { name: "x".to_string(), ty: "i64".to_string() }],
+                return_type: "i64".to_string(),
+            },
+            contracts: Some(ContractInfo {
+                pre: None,
+                post: Some(vec![ContractExpr {
+                    expr: "ret >= 0".to_string(),
+                    quantifiers: Vec::new(),
+                    calls: Vec::new(),
+                    uses_old: false,
+                    uses_ret: true,
+                }]),
+            }),
+            body_info: Some(BodyInfo {
+                calls: vec!["neg".to_string()],
+                recursive: false,
+                has_loop: true,
+            }),
+        }];
+        let types = vec![TypeEntry {
+            name: "Pos".to_string(),
+            file: "src/math.bmb".to_string(),
+            line: 1,
+            is_pub: false,
+            kind: "type".to_string(),
+            fields: Vec::new(),
+            variants: Vec::new(),
+            refinement: Some(RefinementInfo {
+                base: "i64".to_string(),
+                constraint: "self > 0".to_string(),
+            }),
+        }];
+        let symbols = vec![SymbolEntry {
+            kind: SymbolKind::Function,
+            name: "abs".to_string(),
+            file: "src/math.bmb".to_string(),
+            line: 3,
+            is_pub: true,
+            signature: Some("fn(x: i64) -> i64".to_string()),
+            doc: None,
+        }];
+        ProjectIndex {
+            manifest: Manifest {
+                version: "1".to_string(),
+                bmb_version: "0.0.0".to_string(),
+                project: "demo".to_string(),
+                indexed_at: "2026-01-01T00:00:00Z".to_string(),
+                files: 1,
+                functions: 1,
+                types: 1,
+                structs: 0,
+                enums: 0,
+                contracts: 1,
+            },
+            symbols,
+            functions,
+            types,
+        }
+    }
+
+    #[test]
+    fn test_binary_index_round_trip() {
+        let index = sample_index();
+        let bytes = encode(&index);
+        let decoded = decode(&bytes).unwrap();
+        // The JSON form is the reference representation
+        assert_eq!(
+            serde_json::to_value(&decoded).unwrap(),
+            serde_json::to_value(&index).unwrap()
+        );
+        assert!(bytes.len() < serde_json::to_vec(&index).unwrap().len());
+    }
+
+    #[test]
+    fn test_binary_index_rejects_corrupt_input() {
+        let bytes = encode(&sample_index());
+        assert!(decode(b"JSON").is_err());
+        assert!(decode(&bytes[..bytes.len() - 1]).is_err());
+        let mut trailing = bytes.clone();
+        trailing.push(0);
+        assert!(decode(&trailing).is_err());
+    }
+}
@@ -4,9 +4,12 @@
 //! RFC-0001: AI-Native Code Query System
 
 use crate::ast::{self, Expr, FnDef, Item, Program, StateKind, Type, Visibility};
+use crate::smt::SolverResult;
 use serde::{Deserialize, Serialize};
 use std::path::Path;
 
+pub mod binary;
+
 /// Index manifest containing metadata about the index
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Manifest {
@@ -156,6 +159,51 @@ pub struct ProjectIndex {
     pub types: Vec<TypeEntry>,
 }
 
+impl ProjectIndex {
+    /// Replace every entry that came from `file` with the entries of
+    /// `update` (an index of that file alone), or drop them when the file
+    /// was deleted. Lets watchers refresh one file without re-indexing the
+    /// whole project.
+    pub fn replace_file(&mut self, file: &str, update: Option<ProjectIndex>) {
+        let had_file = self.symbols.iter().any(|s| s.file == file)
+            || self.functions.iter().any(|f| f.file == file)
+            || self.types.iter().any(|t| t.file == file);
+
+        self.symbols.retain(|s| s.file != file);
+        self.functions.retain(|f| f.file != file);
+        self.types.retain(|t| t.file != file);
+
+        let mut files = self.manifest.files;
+        match update {
+            Some(update) => {
+                if !had_file {
+                    files += 1;
+                }
+                self.symbols.extend(update.symbols);
+                self.functions.extend(update.functions);
+                self.types.extend(update.types);
+                self.manifest.indexed_at = update.manifest.indexed_at;
+            }
+            None => {
+                if had_file {
+                    files = files.saturating_sub(1);
+                }
+            }
+        }
+        self.manifest.files = files;
+        self.recount();
+    }
+
+    /// Recompute the manifest's entry counts from the index contents
+    fn recount(&mut self) {
+        self.manifest.functions = self.functions.len();
+        self.manifest.types = self.types.len();
+        self.manifest.structs = self.types.iter().filter(|t| t.kind == "struct").count();
+        self.manifest.enums = self.types.iter().filter(|t| t.kind == "enum").count();
+        self.manifest.contracts = self.functions.iter().filter(|f| f.contracts.is_some()).count();
+    }
+}
+
 // =============================================================================
 // v0.50.24 - Proof Verification Index (Task 47.7-47.8)
 // =============================================================================
@@ -204,6 +252,46 @@ pub struct ProofEntry {
     pub verified_at: Option<String>,
 }
 
+/// Solver answer cached for one SMT obligation
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum ObligationResult {
+    Sat,
+    Unsat,
+}
+
+/// A proved or disproved obligation, keyed by the hash of its SMT script
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct ObligationEntry {
+    pub key: String,
+    pub result: ObligationResult,
+    /// Model for sat answers (counterexamples)
+    #[serde(default, skip_serializing_if = "Vec::is_empty")]
+    pub model: Vec<(String, String)>,
+}
+
+impl ObligationEntry {
+    /// Convert a definite solver answer; unknown and timeout are not cached
+    pub fn from_solver(key: String, result: &SolverResult) -> Option<Self> {
+        match result {
+            SolverResult::Sat(model) => {
+                let mut model: Vec<_> = model.iter().map(|(k, v)| (k.clone(), v.clone())).collect();
+                model.sort();
+                Some(Self { key, result: ObligationResult::Sat, model })
+            }
+            SolverResult::Unsat => Some(Self { key, result: ObligationResult::Unsat, model: Vec::new() }),
+            SolverResult::Unknown | SolverResult::Timeout => None,
+        }
+    }
+
+    pub fn to_solver(&self) -> SolverResult {
+        match self.result {
+            ObligationResult::Sat => SolverResult::Sat(self.model.iter().cloned().collect()),
+            ObligationResult::Unsat => SolverResult::Unsat,
+        }
+    }
+}
+
 /// Proof index containing verification results
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct ProofIndex {
@@ -212,6 +300,9 @@ pub struct ProofIndex {
     pub z3_version: Option<String>,
     pub verified_at: String,
     pub proofs: Vec<ProofEntry>,
+    /// Solver answers reused by the next `bmb verify` with the same Z3
+    #[serde(default, skip_serializing_if = "Vec::is_empty")]
+    pub obligations: Vec<ObligationEntry>,
 }
 
 impl ProofIndex {
@@ -223,6 +314,7 @@ impl ProofIndex {
             z3_version,
             verified_at: now.format("%Y-%m-%dT%H:%M:%SZ").to_string(),
             proofs: Vec::new(),
+            obligations: Vec::new(),
         }
     }
 
@@ -310,7 +402,7 @@ impl IndexGenerator {
         let signature = self.format_fn_signature(fn_def);
         self.symbols.push(SymbolEntry {
             kind: SymbolKind::Function,
-            name: fn_def.name.node.clone(),
+            name: fn_def.name.node.to_string(),
             file: filename.to_string(),
             line,
             is_pub,
@@ -323,7 +415,7 @@ impl IndexGenerator {
             .params
             .iter()
             .map(|p| ParamInfo {
-                name: p.name.node.clone(),
+                name: p.name.node.to_string(),
                 ty: self.format_type(&p.ty.node),
             })
             .collect();
@@ -332,7 +424,7 @@ impl IndexGenerator {
         let body_info = self.analyze_body(&fn_def.body.node, &fn_def.name.node);
 
         self.functions.push(FunctionEntry {
-            name: fn_def.name.node.clone(),
+            name: fn_def.name.node.to_string(),
             file: filename.to_string(),
             line,
             is_pub,
@@ -526,7 +618,7 @@ impl IndexGenerator {
             Expr::BoolLit(b) => b.to_string(),
             Expr::StringLit(s) => format!("\"{}\"", s),
             Expr::Unit => "()".to_string(),
-            Expr::Var(name) => name.clone(),
+            Expr::Var(name) => name.to_string(),
             Expr::Ret => "ret".to_string(),
             Expr::It => "it".to_string(),
             Expr::Binary { left, op, right } => {
@@ -671,8 +763,8 @@ impl IndexGenerator {
     fn collect_calls(&self, expr: &Expr, calls: &mut Vec<String>) {
         match expr {
             Expr::Call { func, args } => {
-                if !calls.contains(func) {
-                    calls.push(func.clone());
+                if !calls.iter().any(|c| c == func.as_str()) {
+                    calls.push(func.to_string());
                 }
                 for arg in args {
                     self.collect_calls(&arg.node, calls);
@@ -739,23 +831,21 @@ impl IndexGenerator {
             project: self.project_name,
             indexed_at,
             files: self.files_indexed,
-            functions: self.functions.len(),
-            types: self.types.len(),
-            structs: self.types.iter().filter(|t| t.kind == "struct").count(),
-            enums: self.types.iter().filter(|t| t.kind == "enum").count(),
-            contracts: self
-                .functions
-                .iter()
-                .filter(|f| f.contracts.is_some())
-                .count(),
+            functions: 0,
+            types: 0,
+            structs: 0,
+            enums: 0,
+            contracts: 0,
         };
 
-        ProjectIndex {
+        let mut index = ProjectIndex {
             manifest,
             symbols: self.symbols,
             functions: self.functions,
             types: self.types,
-        }
+        };
+        index.recount();
+        index
     }
 }
 
@@ -784,13 +874,23 @@ pub fn write_index(index: &ProjectIndex, project_root: &Path) -> std::io::Result
     let types_json = serde_json::to_string_pretty(&index.types)?;
     std::fs::write(&types_path, types_json)?;
 
+    // Write the compact binary form last so it is never older than the JSON
+    std::fs::write(index_dir.join("index.bin"), binary::encode(index))?;
+
     Ok(())
 }
 
 /// Read index from the .bmb/index directory
+///
+/// Prefers `index.bin` when it is at least as new as the JSON manifest and
+/// falls back to the JSON files otherwise (older indexes, hand-edited JSON).
 pub fn read_index(project_root: &Path) -> std::io::Result<ProjectIndex> {
     let index_dir = project_root.join(".bmb").join("index");
 
+    if let Some(index) = read_binary_index(&index_dir) {
+        return Ok(index);
+    }
+
     let manifest_path = index_dir.join("manifest.json");
     let manifest_json = std::fs::read_to_string(&manifest_path)?;
     let manifest: Manifest = serde_json::from_str(&manifest_json)?;
@@ -815,6 +915,16 @@ pub fn read_index(project_root: &Path) -> std::io::Result<ProjectIndex> {
     })
 }
 
+fn read_binary_index(index_dir: &Path) -> Option<ProjectIndex> {
+    let bin_path = index_dir.join("index.bin");
+    let modified = |p: &Path| std::fs::metadata(p).and_then(|m| m.modified()).ok();
+    let bin_time = modified(&bin_path)?;
+    if modified(&index_dir.join("manifest.json")).is_some_and(|json_time| json_time > bin_time) {
+        return None;
+    }
+    binary::decode(&std::fs::read(&bin_path).ok()?).ok()
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -824,4 +934,41 @@ mod tests {
         let generator = IndexGenerator::new("test-project");
         assert_eq!(generator.files_indexed, 0);
     }
+
+    fn function(name: &str, file: &str) -> FunctionEntry {
+        FunctionEntry {
+            name: name.to_string(),
+            file: file.to_string(),
+            line: 1,
+            is_pub: false,
+            signature: FunctionSignature { params: Vec::new(), return_type: "()".to_string() },
+            contracts: None,
+            body_info: None,
+        }
+    }
+
+    fn file_index(functions: Vec<FunctionEntry>) -> ProjectIndex {
+        let mut index = IndexGenerator::new("demo").generate();
+        index.functions = functions;
+        index
+    }
+
+    #[test]
+    fn test_replace_file_updates_entries_and_counts() {
+        let mut index = IndexGenerator::new("demo").generate();
+        index.replace_file("a.bmb", Some(file_index(vec![function("f", "a.bmb")])));
+        index.replace_file("b.bmb", Some(file_index(vec![function("g", "b.bmb")])));
+        assert_eq!((index.manifest.files, index.manifest.functions), (2, 2));
+
+        index.replace_file(
+            "a.bmb",
+            Some(file_index(vec![function("f2", "a.bmb"), function("f3", "a.bmb")])),
+        );
+        let names: Vec<&str> = index.functions.iter().map(|f| f.name.as_str()).collect();
+        assert_eq!(names, ["g", "f2", "f3"]);
+        assert_eq!((index.manifest.files, index.manifest.functions), (2, 3));
+
+        index.replace_file("b.bmb", None);
+        assert_eq!((index.manifest.files, index.manifest.functions), (1, 2));
+    }
 }
@@ -0,0 +1,88 @@
+//! Heap allocation counter
+//!
+//! `CountingAlloc` wraps the system allocator and counts allocations per
+//! thread. The `bmb` binary installs it so `bmb run --alloc-stats` can
+//! report what the interpreter thread allocated; without it installed the
+//! counters stay at zero.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::Cell;
+
+thread_local! {
+    static COUNT: Cell<u64> = const { Cell::new(0) };
+    static BYTES: Cell<u64> = const { Cell::new(0) };
+}
+
+/// System allocator that counts allocations (including reallocations)
+pub struct CountingAlloc;
+
+fn record(bytes: usize) {
+    // try_with: allocations can happen while thread-locals are torn down
+    let _ = COUNT.try_with(|c| c.set(c.get() + 1));
+    let _ = BYTES.try_with(|b| b.set(b.get() + bytes as u64));
+}
+
+unsafe impl GlobalAlloc for CountingAlloc {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        record(layout.size());
+        unsafe { System.alloc(layout) }
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        record(layout.size());
+        unsafe { System.alloc_zeroed(layout) }
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        unsafe { System.dealloc(ptr, layout) }
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        record(new_size);
+        unsafe { System.realloc(ptr, layout, new_size) }
+    }
+}
+
+/// Allocations made by one thread
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct AllocStats {
+    pub count: u64,
+    pub bytes: u64,
+}
+
+impl AllocStats {
+    /// Totals for the current thread so far
+    pub fn current() -> Self {
+        AllocStats {
+            count: COUNT.with(Cell::get),
+            bytes: BYTES.with(Cell::get),
+        }
+    }
+
+    /// Allocations made since `earlier`
+    pub fn since(self, earlier: AllocStats) -> AllocStats {
+        AllocStats {
+            count: self.count - earlier.count,
+            bytes: self.bytes - earlier.bytes,
+        }
+    }
+}
+
+#[cfg(test)]
+#[global_allocator]
+static TEST_ALLOC: CountingAlloc = CountingAlloc;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_counts_thread_allocations() {
+        let before = AllocStats::current();
+        let v: Vec<u64> = Vec::with_capacity(16);
+        let used = AllocStats::current().since(before);
+        drop(v);
+        assert_eq!(used.count, 1);
+        assert_eq!(used.bytes, 128);
+    }
+}
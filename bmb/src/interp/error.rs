@@ -34,6 +34,8 @@ pub enum ErrorKind {
     IndexOutOfBounds,
     /// v0.31: Todo placeholder reached at runtime
     TodoNotImplemented,
+    /// Wall-clock deadline exceeded
+    Timeout,
 }
 
 impl RuntimeError {
@@ -118,6 +120,13 @@ impl RuntimeError {
             message: format!("todo: {msg}"),
         }
     }
+
+    pub fn timeout() -> Self {
+        RuntimeError {
+            kind: ErrorKind::Timeout,
+            message: "timed out".to_string(),
+        }
+    }
 }
 
 impl fmt::Display for RuntimeError {
@@ -2,7 +2,10 @@
 
 use super::env::{child_env, EnvRef, Environment};
 use super::error::{InterpResult, RuntimeError};
+use super::layout::{Payload, StructLayout};
+use crate::ast::Symbol;
 use super::scope::ScopeStack;
+use super::slots::{Callee, SlotExpr, SlotFn, SlotProgram};
 use super::value::Value;
 use crate::ast::{BinOp, EnumDef, Expr, FnDef, LiteralPattern, Pattern, Program, Spanned, StructDef, Type, UnOp};
 use std::cell::RefCell;
@@ -49,17 +52,35 @@ const MAX_RECURSION_DEPTH: usize = 100000;
 const STACK_RED_ZONE: usize = 128 * 1024; // 128KB remaining triggers growth
 const STACK_GROW_SIZE: usize = 4 * 1024 * 1024; // Grow by 4MB each time
 
+/// Deadline checks between clock reads (see `Interpreter::set_deadline`)
+const DEADLINE_CHECK_INTERVAL: u32 = 1024;
+
 /// Builtin function type
 pub type BuiltinFn = fn(&[Value]) -> InterpResult<Value>;
 
+/// Index of `field` in values of `layout`
+fn field_slot(layout: &StructLayout, field: &str) -> InterpResult<usize> {
+    layout.index_of(field).ok_or_else(|| RuntimeError::type_error("field", field))
+}
+
+/// Outcome of evaluating an expression in tail position
+enum TailCall {
+    Done(Value),
+    /// A user function still to be called with these arguments
+    Call(Rc<FnDef>, Vec<Value>),
+}
+
 /// The interpreter
 pub struct Interpreter {
     /// Global environment
     global_env: EnvRef,
-    /// User-defined functions
-    functions: HashMap<String, FnDef>,
+    /// User-defined functions, shared so a call takes a reference count
+    /// instead of deep-cloning the definition
+    functions: HashMap<String, Rc<FnDef>>,
     /// Struct definitions
     struct_defs: HashMap<String, StructDef>,
+    /// Field layouts of defined structs, shared by their values
+    struct_layouts: HashMap<String, Rc<StructLayout>>,
     /// Enum definitions
     enum_defs: HashMap<String, EnumDef>,
     /// Builtin functions
@@ -72,6 +93,18 @@ pub struct Interpreter {
     use_scope_stack: bool,
     /// v0.35.1: String intern table for O(1) literal reuse (json_parse optimization)
     string_intern: HashMap<String, Rc<String>>,
+    /// Flag to enable slot-frame evaluation
+    use_slot_frames: bool,
+    /// Lowered functions, resolved lazily after the function set changes
+    slots: Option<SlotProgram>,
+    /// Flat value stack holding every active slot frame
+    slot_stack: Vec<Value>,
+    /// Start of the current frame in `slot_stack`
+    frame_base: usize,
+    /// Wall-clock limit for the current run, checked at calls and loop iterations
+    deadline: Option<std::time::Instant>,
+    /// Deadline checks since the clock was last read
+    deadline_ticks: u32,
 }
 
 impl Interpreter {
@@ -81,12 +114,19 @@ impl Interpreter {
             global_env: Environment::new().into_ref(),
             functions: HashMap::new(),
             struct_defs: HashMap::new(),
+            struct_layouts: HashMap::new(),
             enum_defs: HashMap::new(),
             builtins: HashMap::new(),
             recursion_depth: 0,
             scope_stack: ScopeStack::new(),
             use_scope_stack: false,
             string_intern: HashMap::new(),
+            use_slot_frames: false,
+            slots: None,
+            slot_stack: Vec::new(),
+            frame_base: 0,
+            deadline: None,
+            deadline_ticks: 0,
         };
         interp.register_builtins();
         interp
@@ -112,6 +152,7 @@ impl Interpreter {
         self.builtins.insert("println_str".to_string(), builtin_println_str);
         self.builtins.insert("assert".to_string(), builtin_assert);
         self.builtins.insert("read_int".to_string(), builtin_read_int);
+        self.builtins.insert("flush".to_string(), builtin_flush);
         self.builtins.insert("abs".to_string(), builtin_abs);
         self.builtins.insert("min".to_string(), builtin_min);
         self.builtins.insert("max".to_string(), builtin_max);
@@ -121,6 +162,10 @@ impl Interpreter {
         self.builtins.insert("append_file".to_string(), builtin_append_file);
         self.builtins.insert("file_exists".to_string(), builtin_file_exists);
         self.builtins.insert("file_size".to_string(), builtin_file_size);
+        self.builtins.insert("read_file_mapped".to_string(), builtin_read_file_mapped);
+        self.builtins.insert("file_open".to_string(), builtin_file_open);
+        self.builtins.insert("read_line".to_string(), builtin_read_line);
+        self.builtins.insert("file_close".to_string(), builtin_file_close);
 
         // v0.31.11: Process execution builtins for Phase 32.0.2 Bootstrap Infrastructure
         self.builtins.insert("exec".to_string(), builtin_exec);
@@ -133,8 +178,14 @@ impl Interpreter {
         self.builtins.insert("get_arg".to_string(), builtin_get_arg);
 
         // v0.31.13: StringBuilder builtins for Phase 32.0.4 O(n²) fix
+        self.builtins.insert("arena_push".to_string(), builtin_arena_push);
+        self.builtins.insert("arena_pop".to_string(), builtin_arena_pop);
+        // spawn / parallel_for need the interpreter (see call_task)
+        self.builtins.insert("join".to_string(), builtin_join);
         self.builtins.insert("sb_new".to_string(), builtin_sb_new);
         self.builtins.insert("sb_push".to_string(), builtin_sb_push);
+        self.builtins.insert("sb_push_char".to_string(), builtin_sb_push_char);
+        self.builtins.insert("sb_push_int".to_string(), builtin_sb_push_int);
         self.builtins.insert("sb_build".to_string(), builtin_sb_build);
         self.builtins.insert("sb_len".to_string(), builtin_sb_len);
         self.builtins.insert("sb_clear".to_string(), builtin_sb_clear);
@@ -149,6 +200,10 @@ impl Interpreter {
             .insert("char_to_string".to_string(), builtin_char_to_string);
         // v0.67: String utilities
         self.builtins.insert("str_len".to_string(), builtin_str_len);
+        self.builtins.insert("str_find".to_string(), builtin_str_find);
+        self.builtins.insert("str_find_byte".to_string(), builtin_str_find_byte);
+        self.builtins.insert("str_count_byte".to_string(), builtin_str_count_byte);
+        self.builtins.insert("str_starts_with".to_string(), builtin_str_starts_with);
 
         // v0.34: Math intrinsics for Phase 34.4 Benchmark Gate (n_body, mandelbrot_fp)
         self.builtins.insert("sqrt".to_string(), builtin_sqrt);
@@ -211,6 +266,31 @@ impl Interpreter {
             .insert("hashset_len".to_string(), builtin_hashset_len);
         self.builtins
             .insert("hashset_free".to_string(), builtin_hashset_free);
+
+        // String-keyed map builtins
+        self.builtins.insert("strmap_new".to_string(), builtin_strmap_new);
+        self.builtins.insert("strmap_insert".to_string(), builtin_strmap_insert);
+        self.builtins.insert("strmap_get".to_string(), builtin_strmap_get);
+        self.builtins.insert("strmap_contains".to_string(), builtin_strmap_contains);
+        self.builtins.insert("strmap_remove".to_string(), builtin_strmap_remove);
+        self.builtins.insert("strmap_len".to_string(), builtin_strmap_len);
+        self.builtins.insert("strmap_free".to_string(), builtin_strmap_free);
+    }
+
+    /// Layout for values of struct `name`; structs without a definition
+    /// (not loaded) get one from the field order of the initializer
+    fn struct_layout<'a>(&mut self, name: &str, init_fields: impl Iterator<Item = &'a str>) -> Rc<StructLayout> {
+        if let Some(layout) = self.struct_layouts.get(name) {
+            return Rc::clone(layout);
+        }
+        let layout = Rc::new(StructLayout::new(name, init_fields));
+        self.struct_layouts.insert(name.to_string(), Rc::clone(&layout));
+        layout
+    }
+
+    /// Look up a builtin function (shared with the bytecode VM)
+    pub fn builtin(&self, name: &str) -> Option<BuiltinFn> {
+        self.builtins.get(name).copied()
     }
 
     /// v0.30.280: Enable ScopeStack-based evaluation for better memory efficiency
@@ -224,15 +304,57 @@ impl Interpreter {
         self.use_scope_stack = false;
     }
 
+    /// Enable slot-frame evaluation: locals live at resolved indices in a
+    /// flat per-call frame (see `slots`). Takes precedence over ScopeStack.
+    pub fn enable_slot_frames(&mut self) {
+        self.use_slot_frames = true;
+        self.slot_stack.clear();
+        self.frame_base = 0;
+    }
+
+    /// Disable slot-frame evaluation
+    pub fn disable_slot_frames(&mut self) {
+        self.use_slot_frames = false;
+    }
+
     /// Load a program (register functions, structs, enums)
+    /// Abort evaluation with a timeout error once `deadline` has passed.
+    /// `None` (the default) lets code run unbounded.
+    pub fn set_deadline(&mut self, deadline: Option<std::time::Instant>) {
+        self.deadline = deadline;
+        self.deadline_ticks = 0;
+    }
+
+    /// Fail once the deadline has passed; the clock is only read every
+    /// `DEADLINE_CHECK_INTERVAL` calls so hot loops stay cheap
+    #[inline]
+    fn check_deadline(&mut self) -> InterpResult<()> {
+        if let Some(deadline) = self.deadline {
+            self.deadline_ticks += 1;
+            if self.deadline_ticks >= DEADLINE_CHECK_INTERVAL {
+                self.deadline_ticks = 0;
+                if std::time::Instant::now() >= deadline {
+                    return Err(RuntimeError::timeout());
+                }
+            }
+        }
+        Ok(())
+    }
+
     pub fn load(&mut self, program: &Program) {
+        self.slots = None;
         for item in &program.items {
             match item {
                 crate::ast::Item::FnDef(fn_def) => {
                     self.functions
-                        .insert(fn_def.name.node.clone(), fn_def.clone());
+                        .insert(fn_def.name.node.to_string(), Rc::new(fn_def.clone()));
                 }
                 crate::ast::Item::StructDef(struct_def) => {
+                    let layout = StructLayout::new(
+                        &struct_def.name.node,
+                        struct_def.fields.iter().map(|f| f.name.node.as_str()),
+                    );
+                    self.struct_layouts.insert(struct_def.name.node.clone(), Rc::new(layout));
                     self.struct_defs
                         .insert(struct_def.name.node.clone(), struct_def.clone());
                 }
@@ -259,13 +381,14 @@ impl Interpreter {
 
         // Look for a main function or evaluate the last function
         if let Some(main_fn) = self.functions.get("main").cloned() {
-            self.call_function(&main_fn, &[])
+            self.call_entry(main_fn)
         } else if let Some(last_item) = program.items.last() {
             match last_item {
                 crate::ast::Item::FnDef(fn_def) => {
                     // If no main, just evaluate the body of the last function
                     // (for simple scripts without main)
-                    self.call_function(fn_def, &[])
+                    let fn_def = Rc::clone(&self.functions[fn_def.name.node.as_str()]);
+                    self.call_entry(fn_def)
                 }
                 crate::ast::Item::StructDef(_) | crate::ast::Item::EnumDef(_) => {
                     // Struct/Enum definitions don't produce values
@@ -285,6 +408,21 @@ impl Interpreter {
         }
     }
 
+    /// Call a parameterless entry point through the enabled evaluation path
+    fn call_entry(&mut self, fn_def: Rc<FnDef>) -> InterpResult<Value> {
+        if self.use_slot_frames
+            && let Some(idx) = self.resolved_slots().lookup(&fn_def.name.node)
+        {
+            let func = Rc::clone(&self.resolved_slots().fns[idx]);
+            let start = self.slot_stack.len();
+            return self.call_slot_fn(&func, start);
+        }
+        if self.use_scope_stack {
+            return self.call_function_fast(fn_def, Vec::new());
+        }
+        self.call_function(&fn_def, &[])
+    }
+
     /// Evaluate a single expression (for REPL)
     pub fn eval_expr(&mut self, expr: &Spanned<Expr>) -> InterpResult<Value> {
         self.eval(expr, &self.global_env.clone())
@@ -315,11 +453,20 @@ impl Interpreter {
             return builtin(&args);
         }
 
+        if self.use_slot_frames
+            && let Some(idx) = self.resolved_slots().lookup(name)
+        {
+            let func = Rc::clone(&self.resolved_slots().fns[idx]);
+            let start = self.slot_stack.len();
+            self.slot_stack.extend(args);
+            return self.call_slot_fn(&func, start);
+        }
+
         // Then user-defined functions
         if let Some(fn_def) = self.functions.get(name).cloned() {
             // v0.30.280: Use ScopeStack fast path when enabled
             if self.use_scope_stack {
-                return self.call_function_fast(&fn_def, &args);
+                return self.call_function_fast(fn_def, args);
             }
             return self.call_function(&fn_def, &args);
         }
@@ -422,6 +569,7 @@ impl Interpreter {
             Expr::While { cond, invariant: _, body } => {
                 while self.eval(cond, env)?.is_truthy() {
                     self.eval(body, env)?;
+                    self.check_deadline()?;
                 }
                 Ok(Value::Unit)
             }
@@ -455,6 +603,7 @@ impl Interpreter {
                         for i in start..end {
                             child.borrow_mut().define(var.clone(), Value::Int(i));
                             self.eval(body, &child)?;
+                            self.check_deadline()?;
                         }
                         Ok(Value::Unit)
                     }
@@ -462,6 +611,10 @@ impl Interpreter {
                 }
             }
 
+            Expr::Call { func, args } if self.task_builtin(func).is_some() => {
+                self.call_task(func, args, false, |interp, arg| interp.eval(arg, env))
+            }
+
             Expr::Call { func, args } => {
                 let arg_vals: Vec<Value> = args
                     .iter()
@@ -486,20 +639,20 @@ impl Interpreter {
             }
 
             Expr::StructInit { name, fields } => {
-                let mut field_values = HashMap::new();
+                let layout = self.struct_layout(name, fields.iter().map(|(f, _)| f.node.as_str()));
+                let mut field_values = vec![Value::Unit; layout.fields.len()];
                 for (field_name, field_expr) in fields {
                     let val = self.eval(field_expr, env)?;
-                    field_values.insert(field_name.node.clone(), val);
+                    field_values[field_slot(&layout, &field_name.node)?] = val;
                 }
-                Ok(Value::Struct(name.clone(), field_values))
+                Ok(Value::Struct(layout, field_values.into_boxed_slice()))
             }
 
             Expr::FieldAccess { expr: obj_expr, field } => {
                 let obj = self.eval(obj_expr, env)?;
                 match obj {
-                    Value::Struct(_, fields) => {
-                        fields.get(&field.node).cloned()
-                            .ok_or_else(|| RuntimeError::type_error("field", &field.node))
+                    Value::Struct(layout, fields) => {
+                        Ok(fields[field_slot(&layout, &field.node)?].clone())
                     }
                     _ => Err(RuntimeError::type_error("struct", obj.type_name())),
                 }
@@ -518,11 +671,8 @@ impl Interpreter {
             }
 
             Expr::EnumVariant { enum_name, variant, args } => {
-                let arg_vals: Vec<Value> = args
-                    .iter()
-                    .map(|a| self.eval(a, env))
-                    .collect::<InterpResult<Vec<_>>>()?;
-                Ok(Value::Enum(enum_name.clone(), variant.clone(), arg_vals))
+                let payload = Payload::try_collect(args.len(), args.iter().map(|a| self.eval(a, env)))?;
+                Ok(Value::Enum(Symbol::intern(enum_name), Symbol::intern(variant), payload))
             }
 
             Expr::Match { expr: match_expr, arms } => {
@@ -609,15 +759,12 @@ impl Interpreter {
                             Err(RuntimeError::index_out_of_bounds(idx as i64, s.len()))
                         }
                     }
-                    // v0.93: Handle StringRope (lazy concatenated strings)
-                    Value::StringRope(_) => {
-                        let s = arr_val.materialize_string()
-                            .ok_or_else(|| RuntimeError::type_error("string", "invalid StringRope"))?;
-                        if idx < s.len() {
-                            Ok(Value::Int(s.as_bytes()[idx] as i64))
-                        } else {
-                            Err(RuntimeError::index_out_of_bounds(idx as i64, s.len()))
-                        }
+                    // v0.93: Handle StringRope (lazy concatenated strings) without flattening
+                    Value::StringRope(ref rope) => {
+                        let rope = rope.borrow();
+                        rope.byte_at(idx)
+                            .map(|b| Value::Int(b as i64))
+                            .ok_or_else(|| RuntimeError::index_out_of_bounds(idx as i64, rope.len()))
                     }
                     _ => Err(RuntimeError::type_error("array or string", arr_val.type_name())),
                 }
@@ -669,7 +816,7 @@ impl Interpreter {
             Expr::Loop { body } => {
                 loop {
                     match self.eval(body, env) {
-                        Ok(_) => continue,
+                        Ok(_) => self.check_deadline()?,
                         Err(e) => return Err(e),
                     }
                 }
@@ -718,11 +865,21 @@ impl Interpreter {
     /// Evaluate method call (v0.5 Phase 8, v0.30.283: StringRope support)
     fn eval_method_call(&self, receiver: Value, method: &str, args: Vec<Value>) -> InterpResult<Value> {
         match receiver {
-            // v0.30.283: Handle StringRope by materializing
+            // v0.30.283: len and byte_at read ropes in place; other methods flatten once
+            Value::StringRope(ref rope) if method == "len" => Ok(Value::Int(rope.borrow().len() as i64)),
+            Value::StringRope(ref rope) if method == "byte_at" && args.len() == 1 => {
+                let idx = match &args[0] {
+                    Value::Int(n) => *n as usize,
+                    _ => return Err(RuntimeError::type_error("integer", args[0].type_name())),
+                };
+                let rope = rope.borrow();
+                rope.byte_at(idx)
+                    .map(|b| Value::Int(b as i64))
+                    .ok_or_else(|| RuntimeError::index_out_of_bounds(idx as i64, rope.len()))
+            }
             Value::StringRope(_) => {
-                let materialized = receiver.materialize_string()
+                let s = receiver.shared_string()
                     .ok_or_else(|| RuntimeError::type_error("string", "invalid StringRope"))?;
-                let s = Rc::new(materialized);
                 self.eval_method_call(Value::Str(s), method, args)
             }
             Value::Str(s) => {
@@ -771,36 +928,36 @@ impl Interpreter {
                 }
             }
             // v0.18: Option<T> methods
-            Value::Enum(enum_name, variant, values) if enum_name == "Option" => {
+            Value::Enum(Symbol::OPTION, variant, values) => {
                 match method {
-                    "is_some" => Ok(Value::Bool(variant == "Some")),
-                    "is_none" => Ok(Value::Bool(variant == "None")),
+                    "is_some" => Ok(Value::Bool(variant == Symbol::SOME)),
+                    "is_none" => Ok(Value::Bool(variant == Symbol::NONE)),
                     "unwrap_or" => {
                         if args.len() != 1 {
                             return Err(RuntimeError::arity_mismatch("unwrap_or", 1, args.len()));
                         }
-                        match variant.as_str() {
-                            "Some" => Ok(values.first().cloned().unwrap_or(Value::Unit)),
-                            "None" => Ok(args.into_iter().next().unwrap()),
-                            _ => Err(RuntimeError::type_error("Option variant", &variant)),
+                        match variant {
+                            Symbol::SOME => Ok(values.get(0).unwrap_or(Value::Unit)),
+                            Symbol::NONE => Ok(args.into_iter().next().unwrap()),
+                            _ => Err(RuntimeError::type_error("Option variant", variant.as_str())),
                         }
                     }
                     _ => Err(RuntimeError::undefined_function(&format!("Option.{}", method))),
                 }
             }
             // v0.18: Result<T, E> methods
-            Value::Enum(enum_name, variant, values) if enum_name == "Result" => {
+            Value::Enum(Symbol::RESULT, variant, values) => {
                 match method {
-                    "is_ok" => Ok(Value::Bool(variant == "Ok")),
-                    "is_err" => Ok(Value::Bool(variant == "Err")),
+                    "is_ok" => Ok(Value::Bool(variant == Symbol::OK)),
+                    "is_err" => Ok(Value::Bool(variant == Symbol::ERR)),
                     "unwrap_or" => {
                         if args.len() != 1 {
                             return Err(RuntimeError::arity_mismatch("unwrap_or", 1, args.len()));
                         }
-                        match variant.as_str() {
-                            "Ok" => Ok(values.first().cloned().unwrap_or(Value::Unit)),
-                            "Err" => Ok(args.into_iter().next().unwrap()),
-                            _ => Err(RuntimeError::type_error("Result variant", &variant)),
+                        match variant {
+                            Symbol::OK => Ok(values.get(0).unwrap_or(Value::Unit)),
+                            Symbol::ERR => Ok(args.into_iter().next().unwrap()),
+                            _ => Err(RuntimeError::type_error("Result variant", variant.as_str())),
                         }
                     }
                     _ => Err(RuntimeError::undefined_function(&format!("Result.{}", method))),
@@ -825,8 +982,7 @@ impl Interpreter {
                     (crate::ast::LiteralPattern::String(s), Value::Str(v)) if s == v.as_ref() => Some(vec![]),
                     // v0.30.283: StringRope support for pattern matching
                     (crate::ast::LiteralPattern::String(s), Value::StringRope(r)) => {
-                        let materialized: String = r.borrow().iter().map(|f| f.as_str()).collect();
-                        if s == &materialized { Some(vec![]) } else { None }
+                        if r.borrow().eq_str(s) { Some(vec![]) } else { None }
                     }
                     _ => None,
                 }
@@ -835,14 +991,14 @@ impl Interpreter {
             // v0.41: Nested patterns in enum bindings
             Pattern::EnumVariant { enum_name, variant, bindings } => {
                 match value {
-                    Value::Enum(e_name, v_name, args) if e_name == enum_name && v_name == variant => {
+                    Value::Enum(e_name, v_name, args) if e_name.is(enum_name) && v_name.is(variant) => {
                         if bindings.len() != args.len() {
                             return None;
                         }
                         let mut result = vec![];
                         for (binding, arg) in bindings.iter().zip(args.iter()) {
                             // Recursively match nested patterns
-                            if let Some(inner_bindings) = self.match_pattern(&binding.node, arg) {
+                            if let Some(inner_bindings) = self.match_pattern(&binding.node, &arg) {
                                 result.extend(inner_bindings);
                             } else {
                                 return None;
@@ -856,10 +1012,10 @@ impl Interpreter {
 
             Pattern::Struct { name, fields } => {
                 match value {
-                    Value::Struct(s_name, s_fields) if s_name == name => {
+                    Value::Struct(layout, s_fields) if layout.name.is(name) => {
                         let mut result = vec![];
                         for (field_name, field_pat) in fields {
-                            if let Some(field_val) = s_fields.get(&field_name.node) {
+                            if let Some(field_val) = layout.index_of(&field_name.node).map(|i| &s_fields[i]) {
                                 if let Some(inner_bindings) = self.match_pattern(&field_pat.node, field_val) {
                                     result.extend(inner_bindings);
                                 } else {
@@ -1024,6 +1180,8 @@ impl Interpreter {
             ));
         }
 
+        self.check_deadline()?;
+
         // Check recursion depth
         self.recursion_depth += 1;
         if self.recursion_depth > MAX_RECURSION_DEPTH {
@@ -1038,7 +1196,7 @@ impl Interpreter {
         for (param, arg) in fn_def.params.iter().zip(args.iter()) {
             func_env
                 .borrow_mut()
-                .define(param.name.node.clone(), arg.clone());
+                .define(param.name.node.to_string(), arg.clone());
         }
 
         // Evaluate pre-condition if present
@@ -1175,8 +1333,8 @@ impl Interpreter {
             BinOp::AddChecked => match (&left, &right) {
                 (Value::Int(a), Value::Int(b)) => {
                     match a.checked_add(*b) {
-                        Some(v) => Ok(Value::Enum("Option".to_string(), "Some".to_string(), vec![Value::Int(v)])),
-                        None => Ok(Value::Enum("Option".to_string(), "None".to_string(), vec![])),
+                        Some(v) => Ok(Value::Enum(Symbol::OPTION, Symbol::SOME, Payload::Int(v))),
+                        None => Ok(Value::Enum(Symbol::OPTION, Symbol::NONE, Payload::Empty)),
                     }
                 }
                 _ => Err(RuntimeError::type_error(
@@ -1187,8 +1345,8 @@ impl Interpreter {
             BinOp::SubChecked => match (&left, &right) {
                 (Value::Int(a), Value::Int(b)) => {
                     match a.checked_sub(*b) {
-                        Some(v) => Ok(Value::Enum("Option".to_string(), "Some".to_string(), vec![Value::Int(v)])),
-                        None => Ok(Value::Enum("Option".to_string(), "None".to_string(), vec![])),
+                        Some(v) => Ok(Value::Enum(Symbol::OPTION, Symbol::SOME, Payload::Int(v))),
+                        None => Ok(Value::Enum(Symbol::OPTION, Symbol::NONE, Payload::Empty)),
                     }
                 }
                 _ => Err(RuntimeError::type_error(
@@ -1199,8 +1357,8 @@ impl Interpreter {
             BinOp::MulChecked => match (&left, &right) {
                 (Value::Int(a), Value::Int(b)) => {
                     match a.checked_mul(*b) {
-                        Some(v) => Ok(Value::Enum("Option".to_string(), "Some".to_string(), vec![Value::Int(v)])),
-                        None => Ok(Value::Enum("Option".to_string(), "None".to_string(), vec![])),
+                        Some(v) => Ok(Value::Enum(Symbol::OPTION, Symbol::SOME, Payload::Int(v))),
+                        None => Ok(Value::Enum(Symbol::OPTION, Symbol::NONE, Payload::Empty)),
                     }
                 }
                 _ => Err(RuntimeError::type_error(
@@ -1331,7 +1489,8 @@ impl Interpreter {
 
     /// Define a function (for REPL)
     pub fn define_function(&mut self, fn_def: FnDef) {
-        self.functions.insert(fn_def.name.node.clone(), fn_def);
+        self.functions.insert(fn_def.name.node.to_string(), Rc::new(fn_def));
+        self.slots = None;
     }
 
     // ============ v0.30.280: ScopeStack-based Fast Evaluation ============
@@ -1407,6 +1566,10 @@ impl Interpreter {
                 self.eval_fast(body)
             }
 
+            Expr::Call { func, args } if self.task_builtin(func).is_some() => {
+                self.call_task(func, args, true, |interp, arg| interp.eval_fast(arg))
+            }
+
             Expr::Call { func, args } => {
                 let arg_vals: Vec<Value> = args
                     .iter()
@@ -1449,6 +1612,7 @@ impl Interpreter {
             Expr::While { cond, invariant: _, body } => {
                 while self.eval_fast(cond)?.is_truthy() {
                     self.eval_fast(body)?;
+                    self.check_deadline()?;
                 }
                 Ok(Value::Unit)
             }
@@ -1480,20 +1644,20 @@ impl Interpreter {
 
             // v0.30.280: Struct support
             Expr::StructInit { name, fields } => {
-                let mut field_values = std::collections::HashMap::new();
+                let layout = self.struct_layout(name, fields.iter().map(|(f, _)| f.node.as_str()));
+                let mut field_values = vec![Value::Unit; layout.fields.len()];
                 for (field_name, field_expr) in fields {
                     let val = self.eval_fast(field_expr)?;
-                    field_values.insert(field_name.node.clone(), val);
+                    field_values[field_slot(&layout, &field_name.node)?] = val;
                 }
-                Ok(Value::Struct(name.clone(), field_values))
+                Ok(Value::Struct(layout, field_values.into_boxed_slice()))
             }
 
             Expr::FieldAccess { expr: obj_expr, field } => {
                 let obj = self.eval_fast(obj_expr)?;
                 match obj {
-                    Value::Struct(_, fields) => {
-                        fields.get(&field.node).cloned()
-                            .ok_or_else(|| RuntimeError::type_error("field", &field.node))
+                    Value::Struct(layout, fields) => {
+                        Ok(fields[field_slot(&layout, &field.node)?].clone())
                     }
                     _ => Err(RuntimeError::type_error("struct", obj.type_name())),
                 }
@@ -1513,11 +1677,8 @@ impl Interpreter {
 
             // v0.30.280: Enum support
             Expr::EnumVariant { enum_name, variant, args } => {
-                let arg_vals: Vec<Value> = args
-                    .iter()
-                    .map(|a| self.eval_fast(a))
-                    .collect::<InterpResult<Vec<_>>>()?;
-                Ok(Value::Enum(enum_name.clone(), variant.clone(), arg_vals))
+                let payload = Payload::try_collect(args.len(), args.iter().map(|a| self.eval_fast(a)))?;
+                Ok(Value::Enum(Symbol::intern(enum_name), Symbol::intern(variant), payload))
             }
 
             // v0.30.280: Array support
@@ -1560,15 +1721,12 @@ impl Interpreter {
                             Err(RuntimeError::index_out_of_bounds(idx as i64, s.len()))
                         }
                     }
-                    // v0.93: Handle StringRope (lazy concatenated strings)
-                    Value::StringRope(_) => {
-                        let s = arr_val.materialize_string()
-                            .ok_or_else(|| RuntimeError::type_error("string", "invalid StringRope"))?;
-                        if idx < s.len() {
-                            Ok(Value::Int(s.as_bytes()[idx] as i64))
-                        } else {
-                            Err(RuntimeError::index_out_of_bounds(idx as i64, s.len()))
-                        }
+                    // v0.93: Handle StringRope (lazy concatenated strings) without flattening
+                    Value::StringRope(ref rope) => {
+                        let rope = rope.borrow();
+                        rope.byte_at(idx)
+                            .map(|b| Value::Int(b as i64))
+                            .ok_or_else(|| RuntimeError::index_out_of_bounds(idx as i64, rope.len()))
                     }
                     _ => Err(RuntimeError::type_error("array or string", arr_val.type_name())),
                 }
@@ -1583,191 +1741,681 @@ impl Interpreter {
     }
 
     /// Call a function by name using ScopeStack
+    /// Position of the function argument when `func` is `spawn` or
+    /// `parallel_for` and the program does not define its own
+    fn task_builtin(&self, func: &str) -> Option<usize> {
+        crate::mir::race::task_fn_arg(func).filter(|_| !self.functions.contains_key(func))
+    }
+
+    /// `spawn(f, x)` / `parallel_for(lo, hi, f)`. The interpreter runs tasks
+    /// one after another: spawn calls f(x) at once and keeps the result for
+    /// join, parallel_for returns the wrapping sum of f(lo) .. f(hi - 1).
+    fn call_task(
+        &mut self,
+        builtin: &str,
+        args: &[Spanned<Expr>],
+        fast: bool,
+        mut eval: impl FnMut(&mut Self, &Spanned<Expr>) -> InterpResult<Value>,
+    ) -> InterpResult<Value> {
+        let fn_pos = self.task_builtin(builtin).unwrap_or_default();
+        let task = match args.get(fn_pos).map(|a| &a.node) {
+            Some(Expr::Var(name)) => name.clone(),
+            _ => return Err(RuntimeError::type_error("function name", builtin)),
+        };
+        let mut ints = Vec::with_capacity(2);
+        for (_, arg) in args.iter().enumerate().filter(|(i, _)| *i != fn_pos) {
+            match eval(self, arg)? {
+                Value::Int(n) => ints.push(n),
+                other => return Err(RuntimeError::type_error("i64", other.type_name())),
+            }
+        }
+        let run = |interp: &mut Self, i: i64| -> InterpResult<i64> {
+            let result = if fast {
+                interp.call_fast(&task, vec![Value::Int(i)])?
+            } else {
+                interp.call(&task, vec![Value::Int(i)])?
+            };
+            match result {
+                Value::Int(n) => Ok(n),
+                other => Err(RuntimeError::type_error("i64", other.type_name())),
+            }
+        };
+        match (builtin, ints.as_slice()) {
+            ("spawn", &[x]) => {
+                let result = run(self, x)?;
+                let handle = TASK_COUNTER.with(|c| {
+                    let mut c = c.borrow_mut();
+                    *c += 1;
+                    *c
+                });
+                TASK_RESULTS.with(|t| t.borrow_mut().insert(handle, result));
+                Ok(Value::Int(handle))
+            }
+            ("parallel_for", &[lo, hi]) => {
+                let mut sum = 0i64;
+                for i in lo..hi {
+                    sum = sum.wrapping_add(run(self, i)?);
+                }
+                Ok(Value::Int(sum))
+            }
+            _ => Err(RuntimeError::arity_mismatch(builtin, if builtin == "spawn" { 2 } else { 3 }, args.len())),
+        }
+    }
+
     fn call_fast(&mut self, name: &str, args: Vec<Value>) -> InterpResult<Value> {
         if let Some(builtin) = self.builtins.get(name) {
             return builtin(&args);
         }
         if let Some(fn_def) = self.functions.get(name).cloned() {
-            return self.call_function_fast(&fn_def, &args);
+            return self.call_function_fast(fn_def, args);
         }
         Err(RuntimeError::undefined_function(name))
     }
 
     /// Call a user-defined function using ScopeStack
-    fn call_function_fast(&mut self, fn_def: &FnDef, args: &[Value]) -> InterpResult<Value> {
-        if fn_def.params.len() != args.len() {
-            return Err(RuntimeError::arity_mismatch(
-                &fn_def.name.node,
-                fn_def.params.len(),
-                args.len(),
-            ));
-        }
-
+    ///
+    /// Calls in tail position come back as `TailCall::Call` and run in this
+    /// loop instead of recursing, so tail-recursive code uses constant
+    /// Rust stack and recursion depth. Each step shares the callee's
+    /// definition with the function table rather than copying it.
+    fn call_function_fast(&mut self, mut fn_def: Rc<FnDef>, mut args: Vec<Value>) -> InterpResult<Value> {
         self.recursion_depth += 1;
         if self.recursion_depth > MAX_RECURSION_DEPTH {
             self.recursion_depth -= 1;
             return Err(RuntimeError::stack_overflow());
         }
 
-        self.scope_stack.push_scope();
-        for (param, arg) in fn_def.params.iter().zip(args.iter()) {
-            self.scope_stack.define(param.name.node.clone(), arg.clone());
-        }
+        let result = loop {
+            if let Err(e) = self.check_deadline() {
+                break Err(e);
+            }
+            if fn_def.params.len() != args.len() {
+                break Err(RuntimeError::arity_mismatch(
+                    &fn_def.name.node,
+                    fn_def.params.len(),
+                    args.len(),
+                ));
+            }
+
+            self.scope_stack.push_scope();
+            for (param, arg) in fn_def.params.iter().zip(std::mem::take(&mut args)) {
+                self.scope_stack.define(param.name.node.to_string(), arg);
+            }
 
-        let result = self.eval_fast(&fn_def.body);
-        self.scope_stack.pop_scope();
+            let step = self.eval_fast_tail(&fn_def.body);
+            self.scope_stack.pop_scope();
+            match step {
+                Ok(TailCall::Call(def, next_args)) => (fn_def, args) = (def, next_args),
+                Ok(TailCall::Done(value)) => break Ok(value),
+                Err(e) => break Err(e),
+            }
+        };
         self.recursion_depth -= 1;
         result
     }
-}
 
-impl Default for Interpreter {
-    fn default() -> Self {
-        Self::new()
+    /// Evaluate a function body, handing a call in tail position back to
+    /// `call_function_fast` instead of making it
+    fn eval_fast_tail(&mut self, expr: &Spanned<Expr>) -> InterpResult<TailCall> {
+        stacker::maybe_grow(STACK_RED_ZONE, STACK_GROW_SIZE, || self.eval_fast_tail_inner(expr))
     }
-}
 
-// ============ Built-in Functions ============
+    fn eval_fast_tail_inner(&mut self, expr: &Spanned<Expr>) -> InterpResult<TailCall> {
+        match &expr.node {
+            Expr::Call { func, args } if !self.builtins.contains_key(func.as_str()) && self.task_builtin(func).is_none() => {
+                let Some(fn_def) = self.functions.get(func.as_str()).cloned() else {
+                    return Err(RuntimeError::undefined_function(func));
+                };
+                let arg_vals: Vec<Value> = args
+                    .iter()
+                    .map(|a| self.eval_fast(a))
+                    .collect::<InterpResult<Vec<_>>>()?;
+                Ok(TailCall::Call(fn_def, arg_vals))
+            }
 
-fn builtin_print(args: &[Value]) -> InterpResult<Value> {
-    for (i, arg) in args.iter().enumerate() {
-        if i > 0 {
-            print!(" ");
-        }
-        print!("{arg}");
-    }
-    io::stdout().flush().map_err(|e| RuntimeError::io_error(&e.to_string()))?;
-    Ok(Value::Unit)
-}
+            Expr::If { cond, then_branch, else_branch } => {
+                if self.eval_fast(cond)?.is_truthy() {
+                    self.eval_fast_tail(then_branch)
+                } else {
+                    self.eval_fast_tail(else_branch)
+                }
+            }
 
-fn builtin_println(args: &[Value]) -> InterpResult<Value> {
-    for (i, arg) in args.iter().enumerate() {
-        if i > 0 {
-            print!(" ");
+            Expr::Let { name, value, body, .. } => {
+                let val = self.eval_fast(value)?;
+                self.scope_stack.define(name.clone(), val);
+                self.eval_fast_tail(body)
+            }
+
+            Expr::Block(exprs) => {
+                let Some((last, init)) = exprs.split_last() else {
+                    return Ok(TailCall::Done(Value::Unit));
+                };
+                self.scope_stack.push_scope();
+                for e in init {
+                    self.eval_fast(e)?;
+                }
+                let result = self.eval_fast_tail(last)?;
+                self.scope_stack.pop_scope();
+                Ok(result)
+            }
+
+            Expr::Match { expr: match_expr, arms } => {
+                let val = self.eval_fast(match_expr)?;
+                for arm in arms {
+                    if let Some(bindings) = self.match_pattern(&arm.pattern.node, &val) {
+                        self.scope_stack.push_scope();
+                        for (name, bound_val) in bindings {
+                            self.scope_stack.define(name, bound_val);
+                        }
+                        if let Some(guard) = &arm.guard {
+                            let guard_result = self.eval_fast(guard)?;
+                            if !guard_result.is_truthy() {
+                                self.scope_stack.pop_scope();
+                                continue;
+                            }
+                        }
+                        let result = self.eval_fast_tail(&arm.body);
+                        self.scope_stack.pop_scope();
+                        return result;
+                    }
+                }
+                Err(RuntimeError::type_error("matching arm", "no match found"))
+            }
+
+            _ => self.eval_fast(expr).map(TailCall::Done),
         }
-        print!("{arg}");
     }
-    println!();
-    Ok(Value::Unit)
-}
 
-/// print_str(s: String) -> i64
-/// Prints a string without newline. Returns 0 on success.
-/// v0.31.21: Added for gotgan string output
-fn builtin_print_str(args: &[Value]) -> InterpResult<Value> {
-    if args.len() != 1 {
-        return Err(RuntimeError::arity_mismatch("print_str", 1, args.len()));
-    }
-    // v0.35.5: Handle both Value::Str and Value::StringRope using materialize_string
-    if let Some(s) = args[0].materialize_string() {
-        print!("{}", s);
-        io::stdout().flush().map_err(|e| RuntimeError::io_error(&e.to_string()))?;
-        Ok(Value::Int(0))
-    } else {
-        Err(RuntimeError::type_error("String", args[0].type_name()))
-    }
-}
+    // ============ Slot-frame Evaluation ============
 
-/// println_str(s: String) -> Unit
-/// Prints a string with newline.
-/// v0.100: Added for string output consistency
-fn builtin_println_str(args: &[Value]) -> InterpResult<Value> {
-    if args.len() != 1 {
-        return Err(RuntimeError::arity_mismatch("println_str", 1, args.len()));
-    }
-    if let Some(s) = args[0].materialize_string() {
-        println!("{}", s);
-        Ok(Value::Unit)
-    } else {
-        Err(RuntimeError::type_error("String", args[0].type_name()))
+    /// Lowered program, resolving it first if the function set changed
+    fn resolved_slots(&mut self) -> &SlotProgram {
+        self.slots
+            .get_or_insert_with(|| SlotProgram::resolve(&self.functions, &self.builtins))
     }
-}
 
-fn builtin_assert(args: &[Value]) -> InterpResult<Value> {
-    if args.is_empty() {
-        return Err(RuntimeError::arity_mismatch("assert", 1, 0));
+    #[inline]
+    fn set_slot(&mut self, slot: u32, value: Value) {
+        self.slot_stack[self.frame_base + slot as usize] = value;
     }
-    if !args[0].is_truthy() {
-        return Err(RuntimeError::assertion_failed(None));
-    }
-    Ok(Value::Unit)
-}
 
-fn builtin_read_int(_args: &[Value]) -> InterpResult<Value> {
-    let stdin = io::stdin();
-    let line = stdin
-        .lock()
-        .lines()
-        .next()
-        .ok_or_else(|| RuntimeError::io_error("end of input"))?
-        .map_err(|e| RuntimeError::io_error(&e.to_string()))?;
+    /// Evaluate a slot-resolved expression in the current frame
+    fn eval_slot(&mut self, expr: &SlotExpr) -> InterpResult<Value> {
+        stacker::maybe_grow(STACK_RED_ZONE, STACK_GROW_SIZE, || self.eval_slot_inner(expr))
+    }
 
-    line.trim()
-        .parse::<i64>()
-        .map(Value::Int)
-        .map_err(|_| RuntimeError::type_error("integer", "invalid input"))
-}
+    /// Inner slot eval implementation
+    fn eval_slot_inner(&mut self, expr: &SlotExpr) -> InterpResult<Value> {
+        match expr {
+            SlotExpr::Const(v) => Ok(v.clone()),
 
-fn builtin_abs(args: &[Value]) -> InterpResult<Value> {
-    if args.len() != 1 {
-        return Err(RuntimeError::arity_mismatch("abs", 1, args.len()));
-    }
-    match &args[0] {
-        Value::Int(n) => Ok(Value::Int(n.abs())),
-        Value::Float(f) => Ok(Value::Float(f.abs())),
-        _ => Err(RuntimeError::type_error("numeric", args[0].type_name())),
-    }
-}
+            SlotExpr::Local(slot) => Ok(self.slot_stack[self.frame_base + *slot as usize].clone()),
 
-fn builtin_min(args: &[Value]) -> InterpResult<Value> {
-    if args.len() != 2 {
-        return Err(RuntimeError::arity_mismatch("min", 2, args.len()));
-    }
-    match (&args[0], &args[1]) {
-        (Value::Int(a), Value::Int(b)) => Ok(Value::Int(*a.min(b))),
-        (Value::Float(a), Value::Float(b)) => Ok(Value::Float(a.min(*b))),
-        _ => Err(RuntimeError::type_error("numeric", "mixed types")),
-    }
-}
+            SlotExpr::Binary { left, op, right } => match op {
+                BinOp::And => {
+                    if !self.eval_slot(left)?.is_truthy() {
+                        return Ok(Value::Bool(false));
+                    }
+                    Ok(Value::Bool(self.eval_slot(right)?.is_truthy()))
+                }
+                BinOp::Or => {
+                    if self.eval_slot(left)?.is_truthy() {
+                        return Ok(Value::Bool(true));
+                    }
+                    Ok(Value::Bool(self.eval_slot(right)?.is_truthy()))
+                }
+                _ => {
+                    let lval = self.eval_slot(left)?;
+                    let rval = self.eval_slot(right)?;
+                    self.eval_binary(*op, lval, rval)
+                }
+            },
 
-fn builtin_max(args: &[Value]) -> InterpResult<Value> {
-    if args.len() != 2 {
-        return Err(RuntimeError::arity_mismatch("max", 2, args.len()));
-    }
-    match (&args[0], &args[1]) {
-        (Value::Int(a), Value::Int(b)) => Ok(Value::Int(*a.max(b))),
-        (Value::Float(a), Value::Float(b)) => Ok(Value::Float(a.max(*b))),
-        _ => Err(RuntimeError::type_error("numeric", "mixed types")),
-    }
-}
+            SlotExpr::Unary { op, expr: inner } => {
+                let val = self.eval_slot(inner)?;
+                self.eval_unary(*op, val)
+            }
 
-// ============ v0.34: Math Intrinsics for Phase 34.4 Benchmark Gate ============
+            SlotExpr::If { cond, then_branch, else_branch } => {
+                if self.eval_slot(cond)?.is_truthy() {
+                    self.eval_slot(then_branch)
+                } else {
+                    self.eval_slot(else_branch)
+                }
+            }
 
-/// sqrt(x: f64) -> f64
-/// Returns the square root of a floating-point number.
-/// Returns NaN for negative inputs.
-fn builtin_sqrt(args: &[Value]) -> InterpResult<Value> {
-    if args.len() != 1 {
-        return Err(RuntimeError::arity_mismatch("sqrt", 1, args.len()));
-    }
-    match &args[0] {
-        Value::Float(f) => Ok(Value::Float(f.sqrt())),
-        Value::Int(n) => Ok(Value::Float((*n as f64).sqrt())),
-        _ => Err(RuntimeError::type_error("f64", args[0].type_name())),
-    }
-}
+            SlotExpr::Let { slot, value, body } => {
+                let val = self.eval_slot(value)?;
+                self.set_slot(*slot, val);
+                self.eval_slot(body)
+            }
 
-/// i64_to_f64(x: i64) -> f64
-/// Converts an integer to a floating-point number.
-fn builtin_i64_to_f64(args: &[Value]) -> InterpResult<Value> {
-    if args.len() != 1 {
-        return Err(RuntimeError::arity_mismatch("i64_to_f64", 1, args.len()));
-    }
-    match &args[0] {
-        Value::Int(n) => Ok(Value::Float(*n as f64)),
-        _ => Err(RuntimeError::type_error("i64", args[0].type_name())),
-    }
-}
+            SlotExpr::Assign { slot, value } => {
+                let val = self.eval_slot(value)?;
+                self.set_slot(*slot, val);
+                Ok(Value::Unit)
+            }
+
+            SlotExpr::While { cond, body } => {
+                while self.eval_slot(cond)?.is_truthy() {
+                    self.eval_slot(body)?;
+                    self.check_deadline()?;
+                }
+                Ok(Value::Unit)
+            }
+
+            SlotExpr::For { slot, iter, body } => {
+                let iter_val = self.eval_slot(iter)?;
+                match iter_val {
+                    Value::Range(start, end) => {
+                        for i in start..end {
+                            self.set_slot(*slot, Value::Int(i));
+                            self.eval_slot(body)?;
+                            self.check_deadline()?;
+                        }
+                        Ok(Value::Unit)
+                    }
+                    _ => Err(RuntimeError::type_error("Range", iter_val.type_name())),
+                }
+            }
+
+            // Exits only through an error, as in the environment path
+            SlotExpr::Loop(body) => loop {
+                self.eval_slot(body)?;
+                self.check_deadline()?;
+            },
+
+            SlotExpr::Range { start, end, kind } => {
+                let start_val = self.eval_slot(start)?;
+                let end_val = self.eval_slot(end)?;
+                match (&start_val, &end_val) {
+                    (Value::Int(s), Value::Int(e)) => {
+                        let effective_end = match kind {
+                            crate::ast::RangeKind::Inclusive => *e + 1,
+                            crate::ast::RangeKind::Exclusive => *e,
+                        };
+                        Ok(Value::Range(*s, effective_end))
+                    }
+                    _ => Err(RuntimeError::type_error(
+                        "integer",
+                        &format!("{} {} {}", start_val.type_name(), kind, end_val.type_name()),
+                    )),
+                }
+            }
+
+            SlotExpr::Call { callee, args } => self.call_slot(callee, args),
+
+            SlotExpr::MethodCall { receiver, method, args } => {
+                let recv_val = self.eval_slot(receiver)?;
+                let arg_vals: Vec<Value> = args
+                    .iter()
+                    .map(|a| self.eval_slot(a))
+                    .collect::<InterpResult<Vec<_>>>()?;
+                self.eval_method_call(recv_val, method, arg_vals)
+            }
+
+            SlotExpr::Block(exprs) => {
+                let mut result = Value::Unit;
+                for e in exprs {
+                    result = self.eval_slot(e)?;
+                }
+                Ok(result)
+            }
+
+            SlotExpr::Scope { body, start, end } => {
+                let result = self.eval_slot(body);
+                for slot in *start..*end {
+                    self.set_slot(slot, Value::Unit);
+                }
+                result
+            }
+
+            SlotExpr::Match { expr: match_expr, arms } => {
+                let val = self.eval_slot(match_expr)?;
+                for arm in arms {
+                    if let Some(bindings) = self.match_pattern(&arm.pattern, &val) {
+                        for (slot, (_, bound_val)) in arm.binds.iter().zip(bindings) {
+                            self.set_slot(*slot, bound_val);
+                        }
+                        // v0.40: Check pattern guard if present
+                        if let Some(guard) = &arm.guard
+                            && !self.eval_slot(guard)?.is_truthy()
+                        {
+                            continue;
+                        }
+                        return self.eval_slot(&arm.body);
+                    }
+                }
+                Err(RuntimeError::type_error("matching arm", "no match found"))
+            }
+
+            SlotExpr::StructInit { name, fields } => {
+                let layout = self.struct_layout(name, fields.iter().map(|(f, _)| f.as_str()));
+                let mut field_values = vec![Value::Unit; layout.fields.len()];
+                for (field_name, field_expr) in fields {
+                    let val = self.eval_slot(field_expr)?;
+                    field_values[field_slot(&layout, field_name)?] = val;
+                }
+                Ok(Value::Struct(layout, field_values.into_boxed_slice()))
+            }
+
+            SlotExpr::FieldAccess { expr: obj_expr, field } => {
+                let obj = self.eval_slot(obj_expr)?;
+                match obj {
+                    Value::Struct(layout, fields) => Ok(fields[field_slot(&layout, field)?].clone()),
+                    _ => Err(RuntimeError::type_error("struct", obj.type_name())),
+                }
+            }
+
+            SlotExpr::TupleField { expr: tuple_expr, index } => {
+                let tuple_val = self.eval_slot(tuple_expr)?;
+                match tuple_val {
+                    Value::Tuple(elems) => elems
+                        .get(*index)
+                        .cloned()
+                        .ok_or_else(|| RuntimeError::index_out_of_bounds(*index as i64, elems.len())),
+                    _ => Err(RuntimeError::type_error("tuple", tuple_val.type_name())),
+                }
+            }
+
+            SlotExpr::EnumVariant { enum_name, variant, args } => {
+                let payload = Payload::try_collect(args.len(), args.iter().map(|a| self.eval_slot(a)))?;
+                Ok(Value::Enum(*enum_name, *variant, payload))
+            }
+
+            SlotExpr::Ref(inner) => {
+                let val = self.eval_slot(inner)?;
+                Ok(Value::Ref(Rc::new(RefCell::new(val))))
+            }
+
+            SlotExpr::Deref(inner) => {
+                let val = self.eval_slot(inner)?;
+                match val {
+                    Value::Ref(r) => Ok(r.borrow().clone()),
+                    _ => Err(RuntimeError::type_error("reference", val.type_name())),
+                }
+            }
+
+            SlotExpr::ArrayLit(elems) => Ok(Value::Array(
+                elems.iter().map(|e| self.eval_slot(e)).collect::<InterpResult<Vec<_>>>()?,
+            )),
+
+            SlotExpr::Tuple(elems) => Ok(Value::Tuple(
+                elems.iter().map(|e| self.eval_slot(e)).collect::<InterpResult<Vec<_>>>()?,
+            )),
+
+            SlotExpr::Index { expr, index } => {
+                let arr_val = self.eval_slot(expr)?;
+                let idx_val = self.eval_slot(index)?;
+                let idx = match idx_val {
+                    Value::Int(n) => n as usize,
+                    _ => return Err(RuntimeError::type_error("integer", idx_val.type_name())),
+                };
+                match arr_val {
+                    Value::Array(arr) => arr
+                        .get(idx)
+                        .cloned()
+                        .ok_or_else(|| RuntimeError::index_out_of_bounds(idx as i64, arr.len())),
+                    Value::Str(s) => s
+                        .as_bytes()
+                        .get(idx)
+                        .map(|b| Value::Int(*b as i64))
+                        .ok_or_else(|| RuntimeError::index_out_of_bounds(idx as i64, s.len())),
+                    Value::StringRope(ref rope) => {
+                        let rope = rope.borrow();
+                        rope.byte_at(idx)
+                            .map(|b| Value::Int(b as i64))
+                            .ok_or_else(|| RuntimeError::index_out_of_bounds(idx as i64, rope.len()))
+                    }
+                    _ => Err(RuntimeError::type_error("array or string", arr_val.type_name())),
+                }
+            }
+
+            SlotExpr::Return(value) => match value {
+                Some(v) => self.eval_slot(v),
+                None => Ok(Value::Unit),
+            },
+
+            SlotExpr::Cast { expr, ty } => {
+                let val = self.eval_slot(expr)?;
+                self.eval_cast(val, ty)
+            }
+
+            SlotExpr::Todo(msg) => Err(RuntimeError::todo(msg)),
+        }
+    }
+
+    /// Evaluate arguments straight onto the slot stack, where they become
+    /// the first slots of the callee's frame, and dispatch
+    fn call_slot(&mut self, callee: &Callee, args: &[SlotExpr]) -> InterpResult<Value> {
+        let start = self.slot_stack.len();
+        for arg in args {
+            match self.eval_slot(arg) {
+                Ok(val) => self.slot_stack.push(val),
+                Err(e) => {
+                    self.slot_stack.truncate(start);
+                    return Err(e);
+                }
+            }
+        }
+
+        match callee {
+            Callee::Builtin(builtin) => {
+                let result = builtin(&self.slot_stack[start..]);
+                self.slot_stack.truncate(start);
+                result
+            }
+            Callee::Slot(idx) => {
+                let func = Rc::clone(&self.resolved_slots().fns[*idx]);
+                self.call_slot_fn(&func, start)
+            }
+            Callee::Env(name) => {
+                let arg_vals = self.slot_stack.split_off(start);
+                self.call(name, arg_vals)
+            }
+        }
+    }
+
+    /// Run a lowered function whose arguments occupy `slot_stack[start..]`
+    fn call_slot_fn(&mut self, func: &SlotFn, start: usize) -> InterpResult<Value> {
+        let argc = self.slot_stack.len() - start;
+        if argc != func.params {
+            self.slot_stack.truncate(start);
+            return Err(RuntimeError::arity_mismatch(&func.name, func.params, argc));
+        }
+
+        if let Err(e) = self.check_deadline() {
+            self.slot_stack.truncate(start);
+            return Err(e);
+        }
+
+        self.recursion_depth += 1;
+        if self.recursion_depth > MAX_RECURSION_DEPTH {
+            self.recursion_depth -= 1;
+            self.slot_stack.truncate(start);
+            return Err(RuntimeError::stack_overflow());
+        }
+
+        self.slot_stack.resize(start + func.frame_size, Value::Unit);
+        let saved_base = std::mem::replace(&mut self.frame_base, start);
+
+        let result = match &func.pre {
+            Some(pre) => match self.eval_slot(pre) {
+                Ok(v) if !v.is_truthy() => Err(RuntimeError::pre_condition_failed(&func.name)),
+                Ok(_) => self.eval_slot(&func.body),
+                Err(e) => Err(e),
+            },
+            None => self.eval_slot(&func.body),
+        };
+
+        self.frame_base = saved_base;
+        self.slot_stack.truncate(start);
+        self.recursion_depth -= 1;
+        result
+    }
+}
+
+impl Default for Interpreter {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+// ============ Built-in Functions ============
+
+fn builtin_print(args: &[Value]) -> InterpResult<Value> {
+    for (i, arg) in args.iter().enumerate() {
+        if i > 0 {
+            print!(" ");
+        }
+        print!("{arg}");
+    }
+    io::stdout().flush().map_err(|e| RuntimeError::io_error(&e.to_string()))?;
+    Ok(Value::Unit)
+}
+
+fn builtin_println(args: &[Value]) -> InterpResult<Value> {
+    for (i, arg) in args.iter().enumerate() {
+        if i > 0 {
+            print!(" ");
+        }
+        print!("{arg}");
+    }
+    println!();
+    Ok(Value::Unit)
+}
+
+/// print_str(s: String) -> i64
+/// Prints a string without newline. Returns 0 on success.
+/// v0.31.21: Added for gotgan string output
+fn builtin_print_str(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("print_str", 1, args.len()));
+    }
+    // Ropes are written fragment by fragment, never flattened
+    let mut out = io::stdout().lock();
+    match args[0].write_string(&mut out) {
+        Some(written) => {
+            written.and_then(|_| out.flush()).map_err(|e| RuntimeError::io_error(&e.to_string()))?;
+            Ok(Value::Int(0))
+        }
+        None => Err(RuntimeError::type_error("String", args[0].type_name())),
+    }
+}
+
+/// println_str(s: String) -> Unit
+/// Prints a string with newline.
+/// v0.100: Added for string output consistency
+fn builtin_println_str(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("println_str", 1, args.len()));
+    }
+    let mut out = io::stdout().lock();
+    match args[0].write_string(&mut out) {
+        Some(written) => {
+            written.and_then(|_| out.write_all(b"\n")).map_err(|e| RuntimeError::io_error(&e.to_string()))?;
+            Ok(Value::Unit)
+        }
+        None => Err(RuntimeError::type_error("String", args[0].type_name())),
+    }
+}
+
+fn builtin_assert(args: &[Value]) -> InterpResult<Value> {
+    if args.is_empty() {
+        return Err(RuntimeError::arity_mismatch("assert", 1, 0));
+    }
+    if !args[0].is_truthy() {
+        return Err(RuntimeError::assertion_failed(None));
+    }
+    Ok(Value::Unit)
+}
+
+/// flush() -> i64
+/// Writes any buffered stdout output. Returns 0.
+fn builtin_flush(args: &[Value]) -> InterpResult<Value> {
+    if !args.is_empty() {
+        return Err(RuntimeError::arity_mismatch("flush", 0, args.len()));
+    }
+    io::stdout().flush().map_err(|e| RuntimeError::io_error(&e.to_string()))?;
+    Ok(Value::Int(0))
+}
+
+fn builtin_read_int(_args: &[Value]) -> InterpResult<Value> {
+    let stdin = io::stdin();
+    let line = stdin
+        .lock()
+        .lines()
+        .next()
+        .ok_or_else(|| RuntimeError::io_error("end of input"))?
+        .map_err(|e| RuntimeError::io_error(&e.to_string()))?;
+
+    line.trim()
+        .parse::<i64>()
+        .map(Value::Int)
+        .map_err(|_| RuntimeError::type_error("integer", "invalid input"))
+}
+
+fn builtin_abs(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("abs", 1, args.len()));
+    }
+    match &args[0] {
+        Value::Int(n) => Ok(Value::Int(n.abs())),
+        Value::Float(f) => Ok(Value::Float(f.abs())),
+        _ => Err(RuntimeError::type_error("numeric", args[0].type_name())),
+    }
+}
+
+fn builtin_min(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("min", 2, args.len()));
+    }
+    match (&args[0], &args[1]) {
+        (Value::Int(a), Value::Int(b)) => Ok(Value::Int(*a.min(b))),
+        (Value::Float(a), Value::Float(b)) => Ok(Value::Float(a.min(*b))),
+        _ => Err(RuntimeError::type_error("numeric", "mixed types")),
+    }
+}
+
+fn builtin_max(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("max", 2, args.len()));
+    }
+    match (&args[0], &args[1]) {
+        (Value::Int(a), Value::Int(b)) => Ok(Value::Int(*a.max(b))),
+        (Value::Float(a), Value::Float(b)) => Ok(Value::Float(a.max(*b))),
+        _ => Err(RuntimeError::type_error("numeric", "mixed types")),
+    }
+}
+
+// ============ v0.34: Math Intrinsics for Phase 34.4 Benchmark Gate ============
+
+/// sqrt(x: f64) -> f64
+/// Returns the square root of a floating-point number.
+/// Returns NaN for negative inputs.
+fn builtin_sqrt(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("sqrt", 1, args.len()));
+    }
+    match &args[0] {
+        Value::Float(f) => Ok(Value::Float(f.sqrt())),
+        Value::Int(n) => Ok(Value::Float((*n as f64).sqrt())),
+        _ => Err(RuntimeError::type_error("f64", args[0].type_name())),
+    }
+}
+
+/// i64_to_f64(x: i64) -> f64
+/// Converts an integer to a floating-point number.
+fn builtin_i64_to_f64(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("i64_to_f64", 1, args.len()));
+    }
+    match &args[0] {
+        Value::Int(n) => Ok(Value::Float(*n as f64)),
+        _ => Err(RuntimeError::type_error("i64", args[0].type_name())),
+    }
+}
 
 /// f64_to_i64(x: f64) -> i64
 /// Converts a floating-point number to an integer (truncates toward zero).
@@ -2648,40 +3296,147 @@ fn builtin_hashset_insert(args: &[Value]) -> InterpResult<Value> {
     }
 }
 
-/// hashset_contains(set: i64, value: i64) -> i64
-/// Returns 1 if value exists, 0 otherwise
-fn builtin_hashset_contains(args: &[Value]) -> InterpResult<Value> {
-    builtin_hashmap_contains(args)
+/// hashset_contains(set: i64, value: i64) -> i64
+/// Returns 1 if value exists, 0 otherwise
+fn builtin_hashset_contains(args: &[Value]) -> InterpResult<Value> {
+    builtin_hashmap_contains(args)
+}
+
+/// hashset_remove(set: i64, value: i64) -> i64
+/// Returns 1 if removed, 0 if not found
+fn builtin_hashset_remove(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("hashset_remove", 2, args.len()));
+    }
+    let result = builtin_hashmap_remove(args)?;
+    match result {
+        Value::Int(v) => Ok(Value::Int(if v == i64::MIN { 0 } else { 1 })),
+        _ => Ok(result),
+    }
+}
+
+/// hashset_len(set: i64) -> i64
+fn builtin_hashset_len(args: &[Value]) -> InterpResult<Value> {
+    builtin_hashmap_len(args)
+}
+
+/// hashset_free(set: i64) -> Unit
+fn builtin_hashset_free(args: &[Value]) -> InterpResult<Value> {
+    builtin_hashmap_free(args)
+}
+
+// ============ v0.31.10: File I/O Builtins for Phase 32.0 Bootstrap Infrastructure ============
+
+/// Helper: Extract string from Value (handles both Str and StringRope)
+fn extract_string(val: &Value) -> Option<String> {
+    val.materialize_string()
+}
+
+// ============ String-keyed Map Builtins ============
+// String -> i64 map with the same return conventions as hashmap_*.
+// The native runtime shares the Swiss-table code of hashmap_*.
+
+thread_local! {
+    /// Live string maps keyed by handle
+    static STRING_MAPS: SbRefCell<HashMap<i64, HashMap<String, i64>>> = SbRefCell::new(HashMap::new());
+    /// Counter for generating string map handles (starts at 1; 0 is never a valid map)
+    static STRMAP_COUNTER: SbRefCell<i64> = const { SbRefCell::new(1) };
+}
+
+fn with_strmap<R>(name: &str, id: &Value, f: impl FnOnce(&mut HashMap<String, i64>) -> R) -> InterpResult<R> {
+    let Value::Int(id) = id else {
+        return Err(RuntimeError::type_error("i64", id.type_name()));
+    };
+    STRING_MAPS.with(|maps| match maps.borrow_mut().get_mut(id) {
+        Some(map) => Ok(f(map)),
+        None => Err(RuntimeError::io_error(&format!("{}: invalid map handle {}", name, id))),
+    })
+}
+
+fn strmap_key(arg: &Value) -> InterpResult<String> {
+    extract_string(arg).ok_or_else(|| RuntimeError::type_error("string", arg.type_name()))
+}
+
+/// strmap_new() -> i64: Create empty string-keyed map
+fn builtin_strmap_new(args: &[Value]) -> InterpResult<Value> {
+    if !args.is_empty() {
+        return Err(RuntimeError::arity_mismatch("strmap_new", 0, args.len()));
+    }
+    let id = STRMAP_COUNTER.with(|counter| {
+        let mut c = counter.borrow_mut();
+        let id = *c;
+        *c += 1;
+        id
+    });
+    STRING_MAPS.with(|maps| maps.borrow_mut().insert(id, HashMap::new()));
+    Ok(Value::Int(id))
+}
+
+/// strmap_insert(map: i64, key: String, value: i64) -> i64: old value, or 0 for a new key
+fn builtin_strmap_insert(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 3 {
+        return Err(RuntimeError::arity_mismatch("strmap_insert", 3, args.len()));
+    }
+    let key = strmap_key(&args[1])?;
+    let Value::Int(value) = args[2] else {
+        return Err(RuntimeError::type_error("i64", args[2].type_name()));
+    };
+    let old = with_strmap("strmap_insert", &args[0], |map| map.insert(key, value))?;
+    Ok(Value::Int(old.unwrap_or(0)))
 }
 
-/// hashset_remove(set: i64, value: i64) -> i64
-/// Returns 1 if removed, 0 if not found
-fn builtin_hashset_remove(args: &[Value]) -> InterpResult<Value> {
+/// strmap_get(map: i64, key: String) -> i64: value, or i64::MIN if absent
+fn builtin_strmap_get(args: &[Value]) -> InterpResult<Value> {
     if args.len() != 2 {
-        return Err(RuntimeError::arity_mismatch("hashset_remove", 2, args.len()));
-    }
-    let result = builtin_hashmap_remove(args)?;
-    match result {
-        Value::Int(v) => Ok(Value::Int(if v == i64::MIN { 0 } else { 1 })),
-        _ => Ok(result),
+        return Err(RuntimeError::arity_mismatch("strmap_get", 2, args.len()));
     }
+    let key = strmap_key(&args[1])?;
+    let v = with_strmap("strmap_get", &args[0], |map| map.get(&key).copied())?;
+    Ok(Value::Int(v.unwrap_or(i64::MIN)))
 }
 
-/// hashset_len(set: i64) -> i64
-fn builtin_hashset_len(args: &[Value]) -> InterpResult<Value> {
-    builtin_hashmap_len(args)
+/// strmap_contains(map: i64, key: String) -> i64: 1 if present, 0 otherwise
+fn builtin_strmap_contains(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("strmap_contains", 2, args.len()));
+    }
+    let key = strmap_key(&args[1])?;
+    let found = with_strmap("strmap_contains", &args[0], |map| map.contains_key(&key))?;
+    Ok(Value::Int(if found { 1 } else { 0 }))
 }
 
-/// hashset_free(set: i64) -> Unit
-fn builtin_hashset_free(args: &[Value]) -> InterpResult<Value> {
-    builtin_hashmap_free(args)
+/// strmap_remove(map: i64, key: String) -> i64: removed value, or i64::MIN if absent
+fn builtin_strmap_remove(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("strmap_remove", 2, args.len()));
+    }
+    let key = strmap_key(&args[1])?;
+    let v = with_strmap("strmap_remove", &args[0], |map| map.remove(&key))?;
+    Ok(Value::Int(v.unwrap_or(i64::MIN)))
 }
 
-// ============ v0.31.10: File I/O Builtins for Phase 32.0 Bootstrap Infrastructure ============
+/// strmap_len(map: i64) -> i64: entry count
+fn builtin_strmap_len(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("strmap_len", 1, args.len()));
+    }
+    let len = with_strmap("strmap_len", &args[0], |map| map.len() as i64)?;
+    Ok(Value::Int(len))
+}
 
-/// Helper: Extract string from Value (handles both Str and StringRope)
-fn extract_string(val: &Value) -> Option<String> {
-    val.materialize_string()
+/// strmap_free(map: i64) -> Unit: release the map
+fn builtin_strmap_free(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("strmap_free", 1, args.len()));
+    }
+    match &args[0] {
+        // Like hashmap_free, freeing the null handle is a no-op
+        Value::Int(id) => {
+            STRING_MAPS.with(|maps| maps.borrow_mut().remove(id));
+            Ok(Value::Unit)
+        }
+        other => Err(RuntimeError::type_error("i64", other.type_name())),
+    }
 }
 
 /// read_file(path: String) -> String
@@ -2782,6 +3537,85 @@ fn builtin_file_size(args: &[Value]) -> InterpResult<Value> {
     }
 }
 
+/// read_file_mapped(path: String) -> String
+/// Same result as read_file; the native runtime maps the file instead of copying it.
+fn builtin_read_file_mapped(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("read_file_mapped", 1, args.len()));
+    }
+    builtin_read_file(args)
+}
+
+thread_local! {
+    /// Open line readers for file_open/read_line/file_close, keyed by handle.
+    static LINE_READERS: SbRefCell<HashMap<i64, io::BufReader<fs::File>>> = SbRefCell::new(HashMap::new());
+    /// Counter for generating line reader handles
+    static LINE_READER_COUNTER: SbRefCell<i64> = const { SbRefCell::new(0) };
+}
+
+/// file_open(path: String) -> i64
+/// Opens a file for line-by-line reading. Returns a handle, or -1 on error.
+fn builtin_file_open(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("file_open", 1, args.len()));
+    }
+    match extract_string(&args[0]) {
+        Some(path) => {
+            let Ok(file) = fs::File::open(&path) else {
+                return Ok(Value::Int(-1));
+            };
+            let id = LINE_READER_COUNTER.with(|counter| {
+                let mut c = counter.borrow_mut();
+                let id = *c;
+                *c += 1;
+                id
+            });
+            LINE_READERS.with(|readers| {
+                readers.borrow_mut().insert(id, io::BufReader::new(file));
+            });
+            Ok(Value::Int(id))
+        }
+        None => Err(RuntimeError::type_error("string", args[0].type_name())),
+    }
+}
+
+/// read_line(handle: i64) -> String
+/// Returns the next line including its trailing newline, or "" at end of file.
+fn builtin_read_line(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("read_line", 1, args.len()));
+    }
+    match &args[0] {
+        Value::Int(id) => LINE_READERS.with(|readers| {
+            let mut map = readers.borrow_mut();
+            let Some(reader) = map.get_mut(id) else {
+                return Err(RuntimeError::io_error(&format!("Invalid file handle: {}", id)));
+            };
+            let mut line = Vec::new();
+            reader
+                .read_until(b'\n', &mut line)
+                .map_err(|e| RuntimeError::io_error(&format!("read_line: {}", e)))?;
+            Ok(Value::Str(Rc::new(String::from_utf8_lossy(&line).into_owned())))
+        }),
+        _ => Err(RuntimeError::type_error("i64", args[0].type_name())),
+    }
+}
+
+/// file_close(handle: i64) -> i64
+/// Closes a line reader. Returns 0, or -1 for an unknown handle.
+fn builtin_file_close(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("file_close", 1, args.len()));
+    }
+    match &args[0] {
+        Value::Int(id) => {
+            let removed = LINE_READERS.with(|readers| readers.borrow_mut().remove(id).is_some());
+            Ok(Value::Int(if removed { 0 } else { -1 }))
+        }
+        _ => Err(RuntimeError::type_error("i64", args[0].type_name())),
+    }
+}
+
 // ============ v0.31.11: Process Execution Builtins for Phase 32.0.2 Bootstrap Infrastructure ============
 
 /// Helper: Parse command arguments string into Vec<String>
@@ -2992,6 +3826,47 @@ fn builtin_sb_push(args: &[Value]) -> InterpResult<Value> {
     }
 }
 
+/// sb_push_char(id: i64, code: i64) -> i64
+/// Appends the character with the given code. Returns the same ID for chaining.
+fn builtin_sb_push_char(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("sb_push_char", 2, args.len()));
+    }
+    match (&args[0], &args[1]) {
+        (Value::Int(id), Value::Int(code)) => {
+            let c = u32::try_from(*code).ok().and_then(char::from_u32).ok_or_else(|| {
+                RuntimeError::io_error(&format!("sb_push_char: invalid character code {}", code))
+            })?;
+            sb_push_piece(*id, |builder| builder.push(c.to_string()))
+        }
+        _ => Err(RuntimeError::type_error("(i64, i64)", "other")),
+    }
+}
+
+/// sb_push_int(id: i64, n: i64) -> i64
+/// Appends the decimal form of n. Returns the same ID for chaining.
+fn builtin_sb_push_int(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("sb_push_int", 2, args.len()));
+    }
+    match (&args[0], &args[1]) {
+        (Value::Int(id), Value::Int(n)) => sb_push_piece(*id, |builder| builder.push(n.to_string())),
+        _ => Err(RuntimeError::type_error("(i64, i64)", "other")),
+    }
+}
+
+fn sb_push_piece(id: i64, push: impl FnOnce(&mut Vec<String>)) -> InterpResult<Value> {
+    STRING_BUILDERS.with(|builders| {
+        let mut map = builders.borrow_mut();
+        if let Some(builder) = map.get_mut(&id) {
+            push(builder);
+            Ok(Value::Int(id))
+        } else {
+            Err(RuntimeError::io_error(&format!("Invalid string builder ID: {}", id)))
+        }
+    })
+}
+
 /// sb_build(id: i64) -> String
 /// Materializes the builder into a single string and removes the builder.
 fn builtin_sb_build(args: &[Value]) -> InterpResult<Value> {
@@ -3062,6 +3937,78 @@ fn builtin_sb_clear(args: &[Value]) -> InterpResult<Value> {
     }
 }
 
+// ============ String Arena Builtins ============
+// The native runtime bump-allocates strings into regions that are released
+// wholesale by arena_pop(). Interpreter strings are reference counted, so
+// here only the nesting depth is tracked to keep return values identical.
+
+thread_local! {
+    /// Current arena nesting depth (mirrors BMB_ARENA_MAX_DEPTH in runtime.c)
+    static ARENA_DEPTH: SbRefCell<i64> = const { SbRefCell::new(0) };
+}
+
+const ARENA_MAX_DEPTH: i64 = 256;
+
+/// arena_push() -> i64
+/// Opens a string region. Returns the new depth, or -1 if nested too deeply.
+fn builtin_arena_push(args: &[Value]) -> InterpResult<Value> {
+    if !args.is_empty() {
+        return Err(RuntimeError::arity_mismatch("arena_push", 0, args.len()));
+    }
+    let depth = ARENA_DEPTH.with(|d| {
+        let mut d = d.borrow_mut();
+        if *d >= ARENA_MAX_DEPTH {
+            -1
+        } else {
+            *d += 1;
+            *d
+        }
+    });
+    Ok(Value::Int(depth))
+}
+
+/// arena_pop() -> i64
+/// Closes the innermost string region. Returns the remaining depth, or -1 if none is open.
+fn builtin_arena_pop(args: &[Value]) -> InterpResult<Value> {
+    if !args.is_empty() {
+        return Err(RuntimeError::arity_mismatch("arena_pop", 0, args.len()));
+    }
+    let depth = ARENA_DEPTH.with(|d| {
+        let mut d = d.borrow_mut();
+        if *d <= 0 {
+            -1
+        } else {
+            *d -= 1;
+            *d
+        }
+    });
+    Ok(Value::Int(depth))
+}
+
+// ============ Thread Pool Builtins ============
+// spawn and parallel_for are evaluated by Interpreter::call_task; results
+// of spawned tasks wait here until joined.
+
+thread_local! {
+    static TASK_RESULTS: SbRefCell<HashMap<i64, i64>> = SbRefCell::new(HashMap::new());
+    static TASK_COUNTER: SbRefCell<i64> = const { SbRefCell::new(0) };
+}
+
+/// join(task: i64) -> i64
+/// Returns the result of a spawned task; each task is joined once.
+fn builtin_join(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 1 {
+        return Err(RuntimeError::arity_mismatch("join", 1, args.len()));
+    }
+    match &args[0] {
+        Value::Int(handle) => TASK_RESULTS
+            .with(|t| t.borrow_mut().remove(handle))
+            .map(Value::Int)
+            .ok_or_else(|| RuntimeError::io_error(&format!("Invalid task handle: {}", handle))),
+        _ => Err(RuntimeError::type_error("i64", args[0].type_name())),
+    }
+}
+
 /// chr(code: i64) -> char
 /// Converts a Unicode codepoint to a character.
 /// v0.31.21: Added for gotgan string handling
@@ -3158,14 +4105,94 @@ fn builtin_str_len(args: &[Value]) -> InterpResult<Value> {
     }
     match &args[0] {
         Value::Str(s) => Ok(Value::Int(s.chars().count() as i64)),
-        Value::StringRope(fragments) => {
-            let count: usize = fragments.borrow().iter().map(|s| s.chars().count()).sum();
+        Value::StringRope(rope) => {
+            let count: usize = rope.borrow().fragments().iter().map(|s| s.chars().count()).sum();
             Ok(Value::Int(count as i64))
         }
         _ => Err(RuntimeError::type_error("String", args[0].type_name())),
     }
 }
 
+/// Byte offset argument of the str_* search builtins (negative means 0)
+fn search_from(v: &Value) -> InterpResult<usize> {
+    match v {
+        Value::Int(n) => Ok((*n).max(0) as usize),
+        other => Err(RuntimeError::type_error("i64", other.type_name())),
+    }
+}
+
+/// Byte argument of the str_* search builtins
+fn search_byte(v: &Value) -> InterpResult<u8> {
+    match v {
+        Value::Int(n) => Ok(*n as u8),
+        other => Err(RuntimeError::type_error("i64", other.type_name())),
+    }
+}
+
+/// str_find(s: String, needle: String, from: i64) -> i64
+/// Byte offset of the first occurrence of needle at or after from, or -1.
+fn builtin_str_find(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 3 {
+        return Err(RuntimeError::arity_mismatch("str_find", 3, args.len()));
+    }
+    let s = args[0]
+        .materialize_string()
+        .ok_or_else(|| RuntimeError::type_error("String", args[0].type_name()))?;
+    let needle = args[1]
+        .materialize_string()
+        .ok_or_else(|| RuntimeError::type_error("String", args[1].type_name()))?;
+    let from = search_from(&args[2])?;
+    let (hay, pat) = (s.as_bytes(), needle.as_bytes());
+    if from + pat.len() > hay.len() {
+        return Ok(Value::Int(-1));
+    }
+    if pat.is_empty() {
+        return Ok(Value::Int(from as i64));
+    }
+    let found = hay[from..].windows(pat.len()).position(|w| w == pat);
+    Ok(Value::Int(found.map_or(-1, |i| (from + i) as i64)))
+}
+
+/// str_find_byte(s: String, byte: i64, from: i64) -> i64
+fn builtin_str_find_byte(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 3 {
+        return Err(RuntimeError::arity_mismatch("str_find_byte", 3, args.len()));
+    }
+    let s = args[0]
+        .materialize_string()
+        .ok_or_else(|| RuntimeError::type_error("String", args[0].type_name()))?;
+    let byte = search_byte(&args[1])?;
+    let from = search_from(&args[2])?;
+    let found = s.as_bytes().get(from..).and_then(|rest| rest.iter().position(|&b| b == byte));
+    Ok(Value::Int(found.map_or(-1, |i| (from + i) as i64)))
+}
+
+/// str_count_byte(s: String, byte: i64) -> i64
+fn builtin_str_count_byte(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("str_count_byte", 2, args.len()));
+    }
+    let s = args[0]
+        .materialize_string()
+        .ok_or_else(|| RuntimeError::type_error("String", args[0].type_name()))?;
+    let byte = search_byte(&args[1])?;
+    Ok(Value::Int(s.bytes().filter(|&b| b == byte).count() as i64))
+}
+
+/// str_starts_with(s: String, prefix: String) -> i64 (1 or 0)
+fn builtin_str_starts_with(args: &[Value]) -> InterpResult<Value> {
+    if args.len() != 2 {
+        return Err(RuntimeError::arity_mismatch("str_starts_with", 2, args.len()));
+    }
+    let s = args[0]
+        .materialize_string()
+        .ok_or_else(|| RuntimeError::type_error("String", args[0].type_name()))?;
+    let prefix = args[1]
+        .materialize_string()
+        .ok_or_else(|| RuntimeError::type_error("String", args[1].type_name()))?;
+    Ok(Value::Int(s.as_bytes().starts_with(prefix.as_bytes()) as i64))
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -3236,7 +4263,7 @@ mod tests {
             ty: None,
             value: Box::new(spanned(Expr::IntLit(10))),
             body: Box::new(spanned(Expr::Binary {
-                left: Box::new(spanned(Expr::Var("x".to_string()))),
+                left: Box::new(spanned(Expr::Var("x".into()))),
                 op: BinOp::Mul,
                 right: Box::new(spanned(Expr::IntLit(2))),
             })),
@@ -3334,4 +4361,396 @@ mod tests {
             Value::Bool(true)
         );
     }
+
+    #[test]
+    fn test_arena_push_pop_depth() {
+        assert_eq!(builtin_arena_push(&[]).unwrap(), Value::Int(1));
+        assert_eq!(builtin_arena_push(&[]).unwrap(), Value::Int(2));
+        assert_eq!(builtin_arena_pop(&[]).unwrap(), Value::Int(1));
+        assert_eq!(builtin_arena_pop(&[]).unwrap(), Value::Int(0));
+        // Unbalanced pop reports -1 like the native runtime
+        assert_eq!(builtin_arena_pop(&[]).unwrap(), Value::Int(-1));
+    }
+
+    #[test]
+    fn test_sb_push_char_and_int() {
+        let id = builtin_sb_new(&[]).unwrap();
+        builtin_sb_push_char(&[id.clone(), Value::Int(120)]).unwrap();
+        builtin_sb_push_char(&[id.clone(), Value::Int(61)]).unwrap();
+        builtin_sb_push_int(&[id.clone(), Value::Int(i64::MIN)]).unwrap();
+        assert_eq!(builtin_sb_len(&[id.clone()]).unwrap(), Value::Int(22));
+        assert_eq!(
+            builtin_sb_build(&[id]).unwrap(),
+            Value::Str(Rc::new(format!("x={}", i64::MIN)))
+        );
+    }
+
+    #[test]
+    fn test_strmap_builtins() {
+        let key = |k: &str| Value::Str(Rc::new(k.to_string()));
+        let m = builtin_strmap_new(&[]).unwrap();
+        assert_eq!(builtin_strmap_insert(&[m.clone(), key("a"), Value::Int(1)]).unwrap(), Value::Int(0));
+        assert_eq!(builtin_strmap_insert(&[m.clone(), key("a"), Value::Int(2)]).unwrap(), Value::Int(1));
+        assert_eq!(builtin_strmap_get(&[m.clone(), key("a")]).unwrap(), Value::Int(2));
+        assert_eq!(builtin_strmap_get(&[m.clone(), key("b")]).unwrap(), Value::Int(i64::MIN));
+        assert_eq!(builtin_strmap_contains(&[m.clone(), key("a")]).unwrap(), Value::Int(1));
+        assert_eq!(builtin_strmap_len(&[m.clone()]).unwrap(), Value::Int(1));
+        assert_eq!(builtin_strmap_remove(&[m.clone(), key("a")]).unwrap(), Value::Int(2));
+        assert_eq!(builtin_strmap_remove(&[m.clone(), key("a")]).unwrap(), Value::Int(i64::MIN));
+        assert_eq!(builtin_strmap_free(&[m.clone()]).unwrap(), Value::Unit);
+        assert!(builtin_strmap_len(&[m]).is_err());
+    }
+
+    #[test]
+    fn test_str_search_builtins() {
+        let s = |v: &str| Value::Str(Rc::new(v.to_string()));
+        let i = Value::Int;
+        let hay = s("abcabcab");
+        assert_eq!(builtin_str_find(&[hay.clone(), s("cab"), i(0)]).unwrap(), i(2));
+        assert_eq!(builtin_str_find(&[hay.clone(), s("cab"), i(3)]).unwrap(), i(5));
+        assert_eq!(builtin_str_find(&[hay.clone(), s("cab"), i(6)]).unwrap(), i(-1));
+        assert_eq!(builtin_str_find(&[hay.clone(), s(""), i(8)]).unwrap(), i(8));
+        assert_eq!(builtin_str_find(&[hay.clone(), s(""), i(9)]).unwrap(), i(-1));
+        assert_eq!(builtin_str_find_byte(&[hay.clone(), i(99), i(-4)]).unwrap(), i(2));
+        assert_eq!(builtin_str_find_byte(&[hay.clone(), i(99), i(6)]).unwrap(), i(-1));
+        assert_eq!(builtin_str_find_byte(&[hay.clone(), i(97), i(100)]).unwrap(), i(-1));
+        assert_eq!(builtin_str_count_byte(&[hay.clone(), i(98)]).unwrap(), i(3));
+        assert_eq!(builtin_str_starts_with(&[hay.clone(), s("abca")]).unwrap(), i(1));
+        assert_eq!(builtin_str_starts_with(&[hay, s("abd")]).unwrap(), i(0));
+    }
+
+    fn var(name: &str) -> Spanned<Expr> {
+        spanned(Expr::Var(name.into()))
+    }
+
+    fn int(n: i64) -> Spanned<Expr> {
+        spanned(Expr::IntLit(n))
+    }
+
+    fn bin(left: Spanned<Expr>, op: BinOp, right: Spanned<Expr>) -> Spanned<Expr> {
+        spanned(Expr::Binary { left: Box::new(left), op, right: Box::new(right) })
+    }
+
+    fn call(func: &str, args: Vec<Spanned<Expr>>) -> Spanned<Expr> {
+        spanned(Expr::Call { func: func.into(), args })
+    }
+
+    fn let_in(name: &str, value: Spanned<Expr>, body: Spanned<Expr>) -> Spanned<Expr> {
+        spanned(Expr::Let {
+            name: name.to_string(),
+            mutable: true,
+            ty: None,
+            value: Box::new(value),
+            body: Box::new(body),
+        })
+    }
+
+    fn func(name: &str, params: &[&str], body: Spanned<Expr>) -> FnDef {
+        FnDef {
+            attributes: vec![],
+            visibility: crate::ast::Visibility::Private,
+            name: spanned(name.into()),
+            type_params: vec![],
+            params: params
+                .iter()
+                .map(|p| crate::ast::Param { name: spanned(Symbol::intern(p)), ty: spanned(Type::I64) })
+                .collect(),
+            ret_name: None,
+            ret_ty: spanned(Type::I64),
+            pre: None,
+            post: None,
+            contracts: vec![],
+            body,
+            span: Span { start: 0, end: 0 },
+        }
+    }
+
+    #[test]
+    fn test_compact_struct_and_enum_values() {
+        use crate::interp::alloc::AllocStats;
+
+        let mut interp = Interpreter::new();
+        let field = |name: &str| crate::ast::StructField { name: spanned(name.to_string()), ty: spanned(Type::I64) };
+        interp.load(&Program {
+            header: None,
+            items: vec![crate::ast::Item::StructDef(StructDef {
+                attributes: vec![],
+                visibility: crate::ast::Visibility::Private,
+                name: spanned("EvalTestPoint".to_string()),
+                type_params: vec![],
+                fields: vec![field("x"), field("y")],
+                span: Span { start: 0, end: 0 },
+            })],
+        });
+        let env = interp.global_env.clone();
+
+        // Initializer order does not matter; fields follow the definition
+        let point = spanned(Expr::StructInit {
+            name: "EvalTestPoint".to_string(),
+            fields: vec![(spanned("y".to_string()), int(2)), (spanned("x".to_string()), int(1))],
+        });
+        let option = |variant: &str, args| {
+            spanned(Expr::EnumVariant { enum_name: "Option".to_string(), variant: variant.to_string(), args })
+        };
+        let none = option("None", vec![]);
+        let some = option("Some", vec![int(7)]);
+        for expr in [&point, &none, &some] {
+            interp.eval(expr, &env).unwrap();
+        }
+
+        let before = AllocStats::current();
+        let p = interp.eval(&point, &env).unwrap();
+        assert_eq!(AllocStats::current().since(before).count, 1);
+        assert_eq!(format!("{}", p), "EvalTestPoint { x: 1, y: 2 }");
+
+        let before = AllocStats::current();
+        let n = interp.eval(&none, &env).unwrap();
+        let s = interp.eval(&some, &env).unwrap();
+        assert_eq!(AllocStats::current().since(before).count, 0);
+        assert_eq!(format!("{} {}", n, s), "Option::None Option::Some(7)");
+
+        let get_y = spanned(Expr::FieldAccess { expr: Box::new(point), field: spanned("y".to_string()) });
+        assert_eq!(interp.eval(&get_y, &env).unwrap(), Value::Int(2));
+    }
+
+    /// fib, a while loop whose lets outlive their `Let` body, and a match
+    /// binding, evaluated on every path
+    fn slot_test_interpreter() -> Interpreter {
+        let mut interp = Interpreter::new();
+        interp.define_function(func(
+            "fib",
+            &["n"],
+            spanned(Expr::If {
+                cond: Box::new(bin(var("n"), BinOp::Le, int(1))),
+                then_branch: Box::new(var("n")),
+                else_branch: Box::new(bin(
+                    call("fib", vec![bin(var("n"), BinOp::Sub, int(1))]),
+                    BinOp::Add,
+                    call("fib", vec![bin(var("n"), BinOp::Sub, int(2))]),
+                )),
+            }),
+        ));
+        let step = spanned(Expr::Block(vec![
+            spanned(Expr::Assign {
+                name: "acc".to_string(),
+                value: Box::new(bin(var("acc"), BinOp::Add, call("fib", vec![var("i")]))),
+            }),
+            spanned(Expr::Assign { name: "i".to_string(), value: Box::new(bin(var("i"), BinOp::Add, int(1))) }),
+        ]));
+        interp.define_function(func(
+            "sum_fibs",
+            &["n"],
+            spanned(Expr::Block(vec![
+                let_in(
+                    "acc",
+                    int(0),
+                    let_in(
+                        "i",
+                        int(0),
+                        spanned(Expr::While {
+                            cond: Box::new(bin(var("i"), BinOp::Lt, var("n"))),
+                            invariant: None,
+                            body: Box::new(step),
+                        }),
+                    ),
+                ),
+                var("acc"),
+            ])),
+        ));
+        let some = |e| spanned(Expr::EnumVariant { enum_name: "Option".to_string(), variant: "Some".to_string(), args: vec![e] });
+        interp.define_function(func(
+            "unwrap_double",
+            &["x"],
+            spanned(Expr::Match {
+                expr: Box::new(some(var("x"))),
+                arms: vec![
+                    crate::ast::MatchArm {
+                        pattern: spanned(Pattern::EnumVariant {
+                            enum_name: "Option".to_string(),
+                            variant: "Some".to_string(),
+                            bindings: vec![spanned(Pattern::Var("v".to_string()))],
+                        }),
+                        guard: Some(bin(var("v"), BinOp::Gt, int(0))),
+                        body: bin(var("v"), BinOp::Mul, int(2)),
+                    },
+                    crate::ast::MatchArm { pattern: spanned(Pattern::Wildcard), guard: None, body: var("x") },
+                ],
+            }),
+        ));
+        interp
+    }
+
+    #[test]
+    fn test_slot_frames_match_other_paths() {
+        let cases: &[(&str, i64, i64)] =
+            &[("fib", 15, 610), ("sum_fibs", 10, 88), ("unwrap_double", 21, 42), ("unwrap_double", -3, -3)];
+        for &(name, arg, expected) in cases {
+            for mode in 0..3 {
+                let mut interp = slot_test_interpreter();
+                match mode {
+                    1 => interp.enable_scope_stack(),
+                    2 => interp.enable_slot_frames(),
+                    _ => {}
+                }
+                let got = interp.call_function_with_args(name, vec![Value::Int(arg)]).unwrap();
+                assert_eq!(got, Value::Int(expected), "{name}({arg}) in mode {mode}");
+                assert!(interp.slot_stack.is_empty());
+            }
+        }
+
+        // Parameters plus acc and i; the loop body declares nothing
+        let mut interp = slot_test_interpreter();
+        let slots = interp.resolved_slots();
+        assert_eq!(slots.fns[slots.lookup("sum_fibs").unwrap()].frame_size, 3);
+        assert_eq!(slots.fns[slots.lookup("unwrap_double").unwrap()].frame_size, 2);
+    }
+
+    #[test]
+    fn test_slot_frames_fall_back_to_env() {
+        let mut interp = slot_test_interpreter();
+        // Closures are not lowered; the function runs on the environment path
+        interp.define_function(func(
+            "via_closure",
+            &["n"],
+            spanned(Expr::Closure { params: vec![], ret_ty: None, body: Box::new(call("fib", vec![var("n")])) }),
+        ));
+        interp.define_function(func("caller", &["n"], bin(call("via_closure", vec![var("n")]), BinOp::Add, int(1))));
+        interp.enable_slot_frames();
+
+        assert!(interp.resolved_slots().lookup("via_closure").is_none());
+        assert!(interp.resolved_slots().lookup("caller").is_some());
+        assert_eq!(interp.call_function_with_args("caller", vec![Value::Int(10)]).unwrap(), Value::Int(56));
+
+        let err = interp.call_function_with_args("fib", vec![]).unwrap_err();
+        assert!(err.message.contains("fib"), "{}", err.message);
+        assert!(interp.slot_stack.is_empty());
+    }
+
+    #[test]
+    fn test_tasks_run_sequentially_in_every_mode() {
+        for mode in 0..3 {
+            let mut interp = Interpreter::new();
+            interp.define_function(func("square", &["i"], bin(var("i"), BinOp::Mul, var("i"))));
+            // sum of squares below n, once through parallel_for and once per spawned task
+            interp.define_function(func("pfor", &["n"], call("parallel_for", vec![int(0), var("n"), var("square")])));
+            interp.define_function(func(
+                "pair",
+                &["n"],
+                let_in(
+                    "h",
+                    call("spawn", vec![var("square"), var("n")]),
+                    bin(call("join", vec![var("h")]), BinOp::Add, call("square", vec![int(2)])),
+                ),
+            ));
+            match mode {
+                1 => interp.enable_scope_stack(),
+                2 => interp.enable_slot_frames(),
+                _ => {}
+            }
+            assert_eq!(interp.call_function_with_args("pfor", vec![Value::Int(4)]).unwrap(), Value::Int(14), "mode {mode}");
+            assert_eq!(interp.call_function_with_args("pair", vec![Value::Int(5)]).unwrap(), Value::Int(29), "mode {mode}");
+        }
+        assert!(builtin_join(&[Value::Int(-7)]).is_err());
+    }
+
+    #[test]
+    fn test_scope_stack_tail_calls_run_in_constant_depth() {
+        let mut interp = Interpreter::new();
+        // Mutually tail-recursive parity check, deeper than MAX_RECURSION_DEPTH
+        let parity = |name: &str, other: &str, base: i64| {
+            func(
+                name,
+                &["n"],
+                spanned(Expr::If {
+                    cond: Box::new(bin(var("n"), BinOp::Eq, int(0))),
+                    then_branch: Box::new(int(base)),
+                    else_branch: Box::new(spanned(Expr::Block(vec![let_in(
+                        "m",
+                        bin(var("n"), BinOp::Sub, int(1)),
+                        call(other, vec![var("m")]),
+                    )]))),
+                }),
+            )
+        };
+        interp.define_function(parity("is_even", "is_odd", 1));
+        interp.define_function(parity("is_odd", "is_even", 0));
+        interp.enable_scope_stack();
+
+        let n = MAX_RECURSION_DEPTH as i64 * 2 + 1;
+        assert_eq!(interp.call_function_with_args("is_odd", vec![Value::Int(n)]).unwrap(), Value::Int(1));
+        assert_eq!(interp.call_function_with_args("is_even", vec![Value::Int(n)]).unwrap(), Value::Int(0));
+        assert_eq!(interp.recursion_depth, 0);
+
+        // Calls outside tail position still nest
+        interp.define_function(func("fib", &["n"], spanned(Expr::If {
+            cond: Box::new(bin(var("n"), BinOp::Le, int(1))),
+            then_branch: Box::new(var("n")),
+            else_branch: Box::new(bin(
+                call("fib", vec![bin(var("n"), BinOp::Sub, int(1))]),
+                BinOp::Add,
+                call("fib", vec![bin(var("n"), BinOp::Sub, int(2))]),
+            )),
+        })));
+        assert_eq!(interp.call_function_with_args("fib", vec![Value::Int(15)]).unwrap(), Value::Int(610));
+    }
+
+    #[test]
+    fn test_deadline_stops_runaway_code() {
+        use crate::interp::ErrorKind;
+        use std::time::{Duration, Instant};
+
+        let run = |spin: FnDef, mode: usize| {
+            let mut interp = Interpreter::new();
+            interp.define_function(spin);
+            match mode {
+                1 => interp.enable_scope_stack(),
+                2 => interp.enable_slot_frames(),
+                _ => {}
+            }
+            interp.set_deadline(Some(Instant::now() + Duration::from_millis(20)));
+            let err = interp.call_function_with_args("spin", vec![Value::Int(1)]).unwrap_err();
+            assert_eq!(err.kind, ErrorKind::Timeout, "mode {}: {}", mode, err.message);
+            assert_eq!(interp.recursion_depth, 0);
+        };
+
+        let looping = func("spin", &["n"], spanned(Expr::While {
+            cond: Box::new(spanned(Expr::BoolLit(true))),
+            invariant: None,
+            body: Box::new(var("n")),
+        }));
+        for mode in 0..3 {
+            run(looping.clone(), mode);
+        }
+        // Tail recursion on the scope stack runs in constant depth and never
+        // reaches MAX_RECURSION_DEPTH
+        run(func("spin", &["n"], call("spin", vec![var("n")])), 1);
+    }
+
+    #[test]
+    fn test_line_reader() {
+        let path = std::env::temp_dir().join(format!("bmb_line_reader_{}.txt", std::process::id()));
+        fs::write(&path, "one\ntwo\n\nlast").unwrap();
+        let path_val = Value::Str(Rc::new(path.to_string_lossy().into_owned()));
+
+        let h = builtin_file_open(&[path_val]).unwrap();
+        let mut lines = Vec::new();
+        loop {
+            let line = builtin_read_line(&[h.clone()]).unwrap();
+            if line == Value::Str(Rc::new(String::new())) {
+                break;
+            }
+            lines.push(line);
+        }
+        assert_eq!(builtin_file_close(&[h.clone()]).unwrap(), Value::Int(0));
+        assert_eq!(builtin_file_close(&[h]).unwrap(), Value::Int(-1));
+        fs::remove_file(&path).unwrap();
+
+        let expected: Vec<Value> =
+            ["one\n", "two\n", "\n", "last"].iter().map(|s| Value::Str(Rc::new(s.to_string()))).collect();
+        assert_eq!(lines, expected);
+        assert_eq!(
+            builtin_file_open(&[Value::Str(Rc::new("/nonexistent/bmb".to_string()))]).unwrap(),
+            Value::Int(-1)
+        );
+    }
 }
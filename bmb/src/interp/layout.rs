@@ -0,0 +1,148 @@
+//! Compact layouts for struct and enum values
+//!
+//! Type, variant and field names are interned once into `Symbol` ids, so a
+//! struct value is a shared layout plus one boxed slice of fields in
+//! definition order, and an enum value is two ids plus a payload that
+//! needs no allocation for nullary variants or a single scalar argument.
+
+
+use super::value::Value;
+use crate::ast::Symbol;
+
+/// Field order of a struct type, shared by all of its values
+#[derive(Debug, PartialEq, Eq)]
+pub struct StructLayout {
+    pub name: Symbol,
+    pub fields: Box<[Symbol]>,
+}
+
+impl StructLayout {
+    pub fn new<'a>(name: &str, fields: impl IntoIterator<Item = &'a str>) -> Self {
+        StructLayout {
+            name: Symbol::intern(name),
+            fields: fields.into_iter().map(Symbol::intern).collect(),
+        }
+    }
+
+    /// Position of a field in the value's field slice
+    pub fn index_of(&self, field: &str) -> Option<usize> {
+        let sym = Symbol::lookup(field)?;
+        self.fields.iter().position(|f| *f == sym)
+    }
+}
+
+/// Enum variant arguments
+#[derive(Debug, Clone)]
+pub enum Payload {
+    /// Nullary variant (`Option::None`)
+    Empty,
+    /// Single scalar argument, stored inline (`Some(3)`, `Ok(true)`)
+    Int(i64),
+    Float(f64),
+    Bool(bool),
+    Char(char),
+    /// Every other argument list
+    Boxed(Box<[Value]>),
+}
+
+impl Payload {
+    /// Payload holding one value
+    pub fn one(value: Value) -> Self {
+        match value {
+            Value::Int(n) => Payload::Int(n),
+            Value::Float(f) => Payload::Float(f),
+            Value::Bool(b) => Payload::Bool(b),
+            Value::Char(c) => Payload::Char(c),
+            other => Payload::Boxed(Box::new([other])),
+        }
+    }
+
+    /// Build a payload of `len` values without an intermediate `Vec`
+    pub fn try_collect<E>(len: usize, mut values: impl Iterator<Item = Result<Value, E>>) -> Result<Self, E> {
+        match len {
+            0 => Ok(Payload::Empty),
+            1 => match values.next() {
+                Some(value) => Ok(Payload::one(value?)),
+                None => Ok(Payload::Empty),
+            },
+            _ => Ok(Payload::Boxed(values.collect::<Result<_, E>>()?)),
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        match self {
+            Payload::Empty => 0,
+            Payload::Int(_) | Payload::Float(_) | Payload::Bool(_) | Payload::Char(_) => 1,
+            Payload::Boxed(values) => values.len(),
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Argument `i` (inline scalars are rebuilt as values)
+    pub fn get(&self, i: usize) -> Option<Value> {
+        match (self, i) {
+            (Payload::Int(n), 0) => Some(Value::Int(*n)),
+            (Payload::Float(f), 0) => Some(Value::Float(*f)),
+            (Payload::Bool(b), 0) => Some(Value::Bool(*b)),
+            (Payload::Char(c), 0) => Some(Value::Char(*c)),
+            (Payload::Boxed(values), i) => values.get(i).cloned(),
+            _ => None,
+        }
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = Value> + '_ {
+        (0..self.len()).filter_map(|i| self.get(i))
+    }
+}
+
+impl From<Vec<Value>> for Payload {
+    fn from(mut values: Vec<Value>) -> Self {
+        match values.len() {
+            0 => Payload::Empty,
+            1 => Payload::one(values.pop().expect("one value")),
+            _ => Payload::Boxed(values.into_boxed_slice()),
+        }
+    }
+}
+
+impl PartialEq for Payload {
+    fn eq(&self, other: &Self) -> bool {
+        self.len() == other.len() && self.iter().eq(other.iter())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_well_known_syms() {
+        assert_eq!(Symbol::intern("Option"), Symbol::OPTION);
+        assert_eq!(Symbol::intern("Err"), Symbol::ERR);
+        assert_eq!(Symbol::NONE.as_str(), "None");
+        let point = Symbol::intern("layout_test_Point");
+        assert_eq!(Symbol::intern("layout_test_Point"), point);
+        assert!(point.is("layout_test_Point"));
+        assert!(!Symbol::SOME.is("layout_test_never_interned"));
+    }
+
+    #[test]
+    fn test_payload_inlines_scalars() {
+        assert!(matches!(Payload::one(Value::Int(7)), Payload::Int(7)));
+        assert!(matches!(Payload::from(vec![]), Payload::Empty));
+        let pair = Payload::from(vec![Value::Int(1), Value::Bool(true)]);
+        assert_eq!(pair.len(), 2);
+        assert!(matches!(pair.get(1), Some(Value::Bool(true))));
+        assert_eq!(Payload::one(Value::Int(3)), Payload::Boxed(Box::new([Value::Int(3)])));
+    }
+
+    #[test]
+    fn test_struct_layout_index() {
+        let layout = StructLayout::new("layout_test_Pair", ["first", "second"]);
+        assert_eq!(layout.index_of("second"), Some(1));
+        assert_eq!(layout.index_of("layout_test_missing_field"), None);
+    }
+}
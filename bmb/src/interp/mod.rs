@@ -1,13 +1,19 @@
 //! Interpreter module for BMB
 
+pub mod alloc;
 mod env;
 mod error;
 mod eval;
+mod layout;
+mod rope;
 mod scope;
+mod slots;
 mod value;
 
 pub use env::{child_env, EnvRef, Environment};
 pub use error::{ErrorKind, InterpResult, RuntimeError};
 pub use eval::{set_program_args, BuiltinFn, Interpreter};
+pub use layout::{Payload, StructLayout};
+pub use rope::Rope;
 pub use scope::ScopeStack;
 pub use value::Value;
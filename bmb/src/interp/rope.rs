@@ -0,0 +1,143 @@
+//! String ropes for lazy concatenation
+//!
+//! A rope keeps the fragments of a concatenated string together with the
+//! running byte offset at the end of each fragment. Length is O(1) and a
+//! byte lookup is a binary search over the offsets, so the common
+//! "append, then inspect" loops of the bootstrap compiler never copy the
+//! string. A rope flattens itself into one fragment once it collects
+//! `FLATTEN_FRAGMENTS` pieces, or when a reader needs contiguous bytes.
+
+use std::io::{self, Write};
+use std::rc::Rc;
+
+/// Fragment count at which concatenation flattens the result
+pub const FLATTEN_FRAGMENTS: usize = 256;
+
+/// Concatenated string fragments
+#[derive(Debug, Clone, Default)]
+pub struct Rope {
+    fragments: Vec<Rc<String>>,
+    /// `ends[i]` is the byte offset just past `fragments[i]`
+    ends: Vec<usize>,
+}
+
+impl Rope {
+    pub fn with_capacity(fragments: usize) -> Self {
+        Rope {
+            fragments: Vec::with_capacity(fragments),
+            ends: Vec::with_capacity(fragments),
+        }
+    }
+
+    pub fn push(&mut self, fragment: Rc<String>) {
+        self.ends.push(self.len() + fragment.len());
+        self.fragments.push(fragment);
+    }
+
+    pub fn extend(&mut self, other: &Rope) {
+        for fragment in &other.fragments {
+            self.push(Rc::clone(fragment));
+        }
+    }
+
+    /// Total length in bytes
+    pub fn len(&self) -> usize {
+        self.ends.last().copied().unwrap_or(0)
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn fragments(&self) -> &[Rc<String>] {
+        &self.fragments
+    }
+
+    /// Byte at offset `index`
+    pub fn byte_at(&self, index: usize) -> Option<u8> {
+        let i = self.ends.partition_point(|&end| end <= index);
+        let start = if i == 0 { 0 } else { self.ends[i - 1] };
+        self.fragments.get(i)?.as_bytes().get(index - start).copied()
+    }
+
+    pub fn bytes(&self) -> impl Iterator<Item = u8> + '_ {
+        self.fragments.iter().flat_map(|f| f.bytes())
+    }
+
+    pub fn eq_str(&self, s: &str) -> bool {
+        self.len() == s.len() && self.bytes().eq(s.bytes())
+    }
+
+    /// Collapse into a single fragment and return it
+    pub fn flatten(&mut self) -> Rc<String> {
+        if self.fragments.len() != 1 {
+            let mut flat = String::with_capacity(self.len());
+            for fragment in &self.fragments {
+                flat.push_str(fragment);
+            }
+            let flat = Rc::new(flat);
+            self.fragments = vec![Rc::clone(&flat)];
+            self.ends = vec![flat.len()];
+        }
+        Rc::clone(&self.fragments[0])
+    }
+
+    /// Flatten if the rope has grown past `FLATTEN_FRAGMENTS`
+    pub fn compact(&mut self) {
+        if self.fragments.len() >= FLATTEN_FRAGMENTS {
+            self.flatten();
+        }
+    }
+
+    /// Write every fragment in order without building a flat copy
+    pub fn write_to(&self, out: &mut impl Write) -> io::Result<()> {
+        for fragment in &self.fragments {
+            out.write_all(fragment.as_bytes())?;
+        }
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn rope(parts: &[&str]) -> Rope {
+        let mut r = Rope::default();
+        for p in parts {
+            r.push(Rc::new(p.to_string()));
+        }
+        r
+    }
+
+    #[test]
+    fn test_rope_len_and_byte_at() {
+        let r = rope(&["ab", "", "cde", "f"]);
+        assert_eq!(r.len(), 6);
+        let bytes: Vec<u8> = (0..6).map(|i| r.byte_at(i).unwrap()).collect();
+        assert_eq!(bytes, b"abcdef");
+        assert_eq!(r.byte_at(6), None);
+        assert!(Rope::default().byte_at(0).is_none());
+    }
+
+    #[test]
+    fn test_rope_flatten_and_compact() {
+        let mut r = rope(&["x", "y", "z"]);
+        assert!(r.eq_str("xyz"));
+        assert_eq!(r.flatten().as_str(), "xyz");
+        assert_eq!(r.fragments().len(), 1);
+        assert_eq!(r.byte_at(2), Some(b'z'));
+
+        let mut big = rope(&["a"; FLATTEN_FRAGMENTS]);
+        big.compact();
+        assert_eq!(big.fragments().len(), 1);
+        assert_eq!(big.len(), FLATTEN_FRAGMENTS);
+    }
+
+    #[test]
+    fn test_rope_write_to() {
+        let mut out = Vec::new();
+        rope(&["he", "llo"]).write_to(&mut out).unwrap();
+        assert_eq!(out, b"hello");
+    }
+}
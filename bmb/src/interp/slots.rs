@@ -0,0 +1,512 @@
+//! Slot resolution for frame-based evaluation
+//!
+//! A pre-pass over each function assigns every parameter, `let`, `for`
+//! variable and match binding a fixed slot in the function's frame, and
+//! lowers the body into a `SlotExpr` tree whose variable accesses are slot
+//! indices. At run time a call reserves `frame_size` values on one flat
+//! stack, so reading or writing a local is an index operation instead of a
+//! hash lookup per enclosing scope (`Environment`, `ScopeStack`).
+//!
+//! Call targets are resolved at the same time: builtins become function
+//! pointers and user functions become indices into `SlotProgram::fns`.
+//! Functions using constructs the lowering does not cover (closures,
+//! break/continue, contract-only expressions) are left to the environment
+//! evaluator and reached through `Callee::Env`.
+
+use super::eval::BuiltinFn;
+use crate::ast::Symbol;
+use super::value::Value;
+use crate::ast::{BinOp, Expr, FnDef, MatchArm, Pattern, RangeKind, Spanned, Type, UnOp};
+use std::collections::{HashMap, HashSet};
+use std::rc::Rc;
+
+/// Index of a local within its function's frame
+pub type Slot = u32;
+
+/// Expression with variables resolved to frame slots
+#[derive(Debug)]
+pub enum SlotExpr {
+    /// Literal
+    Const(Value),
+    /// Local variable read
+    Local(Slot),
+    Binary {
+        left: Box<SlotExpr>,
+        op: BinOp,
+        right: Box<SlotExpr>,
+    },
+    Unary {
+        op: UnOp,
+        expr: Box<SlotExpr>,
+    },
+    If {
+        cond: Box<SlotExpr>,
+        then_branch: Box<SlotExpr>,
+        else_branch: Box<SlotExpr>,
+    },
+    /// Store `value` into `slot`, then evaluate `body`
+    Let {
+        slot: Slot,
+        value: Box<SlotExpr>,
+        body: Box<SlotExpr>,
+    },
+    Assign {
+        slot: Slot,
+        value: Box<SlotExpr>,
+    },
+    While {
+        cond: Box<SlotExpr>,
+        body: Box<SlotExpr>,
+    },
+    For {
+        slot: Slot,
+        iter: Box<SlotExpr>,
+        body: Box<SlotExpr>,
+    },
+    Loop(Box<SlotExpr>),
+    Range {
+        start: Box<SlotExpr>,
+        end: Box<SlotExpr>,
+        kind: RangeKind,
+    },
+    Call {
+        callee: Callee,
+        args: Vec<SlotExpr>,
+    },
+    MethodCall {
+        receiver: Box<SlotExpr>,
+        method: String,
+        args: Vec<SlotExpr>,
+    },
+    Block(Vec<SlotExpr>),
+    /// Lexical scope: slots `start..end` are reset to unit on exit so the
+    /// values they held are released as soon as the scope ends
+    Scope {
+        body: Box<SlotExpr>,
+        start: Slot,
+        end: Slot,
+    },
+    Match {
+        expr: Box<SlotExpr>,
+        arms: Vec<SlotArm>,
+    },
+    StructInit {
+        name: String,
+        fields: Vec<(String, SlotExpr)>,
+    },
+    FieldAccess {
+        expr: Box<SlotExpr>,
+        field: String,
+    },
+    TupleField {
+        expr: Box<SlotExpr>,
+        index: usize,
+    },
+    EnumVariant {
+        enum_name: Symbol,
+        variant: Symbol,
+        args: Vec<SlotExpr>,
+    },
+    Ref(Box<SlotExpr>),
+    Deref(Box<SlotExpr>),
+    ArrayLit(Vec<SlotExpr>),
+    Tuple(Vec<SlotExpr>),
+    Index {
+        expr: Box<SlotExpr>,
+        index: Box<SlotExpr>,
+    },
+    Return(Option<Box<SlotExpr>>),
+    Cast {
+        expr: Box<SlotExpr>,
+        ty: Type,
+    },
+    Todo(String),
+}
+
+/// Match arm with its bindings resolved to slots
+#[derive(Debug)]
+pub struct SlotArm {
+    pub pattern: Pattern,
+    /// Slot for each binding, in the order `match_pattern` yields them
+    pub binds: Vec<Slot>,
+    pub guard: Option<SlotExpr>,
+    pub body: SlotExpr,
+}
+
+/// Resolved call target
+#[derive(Debug, Clone)]
+pub enum Callee {
+    /// Builtin function
+    Builtin(BuiltinFn),
+    /// Lowered user function, by index into `SlotProgram::fns`
+    Slot(usize),
+    /// User function evaluated by the environment path (or undefined)
+    Env(String),
+}
+
+/// A lowered function
+#[derive(Debug)]
+pub struct SlotFn {
+    pub name: String,
+    /// Parameters occupy slots `0..params`
+    pub params: usize,
+    /// Total slots the frame needs
+    pub frame_size: usize,
+    pub pre: Option<SlotExpr>,
+    pub body: SlotExpr,
+}
+
+/// All lowered functions of a program
+#[derive(Debug, Default)]
+pub struct SlotProgram {
+    pub fns: Vec<Rc<SlotFn>>,
+    index: HashMap<String, usize>,
+}
+
+impl SlotProgram {
+    /// Lower every function that the slot evaluator supports
+    pub fn resolve(functions: &HashMap<String, Rc<FnDef>>, builtins: &HashMap<String, BuiltinFn>) -> Self {
+        let mut names: Vec<&String> = functions.keys().collect();
+        names.sort();
+
+        // Lowering success does not depend on the call map, so one retry
+        // with the unsupported functions routed to `Callee::Env` suffices
+        let mut excluded: HashSet<&str> = HashSet::new();
+        loop {
+            let lowerable: Vec<&String> = names.iter().copied().filter(|n| !excluded.contains(n.as_str())).collect();
+            let index: HashMap<String, usize> =
+                lowerable.iter().enumerate().map(|(i, n)| ((*n).clone(), i)).collect();
+
+            let mut fns = Vec::with_capacity(lowerable.len());
+            let mut failed = false;
+            for name in &lowerable {
+                match Resolver::new(builtins, &index).lower_fn(&functions[*name]) {
+                    Some(f) => fns.push(Rc::new(f)),
+                    None => {
+                        excluded.insert(name.as_str());
+                        failed = true;
+                    }
+                }
+            }
+            if !failed {
+                return SlotProgram { fns, index };
+            }
+        }
+    }
+
+    /// Index of a lowered function
+    pub fn lookup(&self, name: &str) -> Option<usize> {
+        self.index.get(name).copied()
+    }
+}
+
+/// Lexical scope during resolution
+struct ScopeInfo {
+    start: Slot,
+    /// Highest slot (exclusive) used by this scope or any nested one
+    high: Slot,
+    names: Vec<(String, Slot)>,
+}
+
+/// Per-function resolver
+struct Resolver<'a> {
+    builtins: &'a HashMap<String, BuiltinFn>,
+    index: &'a HashMap<String, usize>,
+    scopes: Vec<ScopeInfo>,
+    next: Slot,
+}
+
+impl<'a> Resolver<'a> {
+    fn new(builtins: &'a HashMap<String, BuiltinFn>, index: &'a HashMap<String, usize>) -> Self {
+        Resolver { builtins, index, scopes: Vec::new(), next: 0 }
+    }
+
+    fn lower_fn(mut self, fn_def: &FnDef) -> Option<SlotFn> {
+        self.open();
+        for param in &fn_def.params {
+            self.declare(&param.name.node);
+        }
+        let pre = match &fn_def.pre {
+            Some(pre) => Some(self.lower(pre)?),
+            None => None,
+        };
+        let body = self.lower(&fn_def.body)?;
+        let (_, high) = self.close();
+        Some(SlotFn {
+            name: fn_def.name.node.to_string(),
+            params: fn_def.params.len(),
+            frame_size: high as usize,
+            pre,
+            body,
+        })
+    }
+
+    fn open(&mut self) {
+        self.scopes.push(ScopeInfo { start: self.next, high: self.next, names: Vec::new() });
+    }
+
+    /// Close the innermost scope, returning the slot range it used
+    fn close(&mut self) -> (Slot, Slot) {
+        let scope = self.scopes.pop().expect("scope underflow");
+        if let Some(parent) = self.scopes.last_mut() {
+            parent.high = parent.high.max(scope.high);
+        }
+        self.next = scope.start;
+        (scope.start, scope.high)
+    }
+
+    fn declare(&mut self, name: &str) -> Slot {
+        let slot = self.next;
+        self.next += 1;
+        let scope = self.scopes.last_mut().expect("no open scope");
+        scope.high = scope.high.max(self.next);
+        scope.names.push((name.to_string(), slot));
+        slot
+    }
+
+    fn lookup(&self, name: &str) -> Option<Slot> {
+        self.scopes
+            .iter()
+            .rev()
+            .flat_map(|s| s.names.iter().rev())
+            .find(|(n, _)| n == name)
+            .map(|(_, slot)| *slot)
+    }
+
+    /// Lower `expr` in a fresh scope, wrapping it so the scope's slots are
+    /// released on exit
+    fn scoped(&mut self, f: impl FnOnce(&mut Self) -> Option<SlotExpr>) -> Option<SlotExpr> {
+        self.open();
+        let body = f(self)?;
+        let (start, end) = self.close();
+        Some(if end > start {
+            SlotExpr::Scope { body: Box::new(body), start, end }
+        } else {
+            body
+        })
+    }
+
+    fn boxed(&mut self, expr: &Spanned<Expr>) -> Option<Box<SlotExpr>> {
+        self.lower(expr).map(Box::new)
+    }
+
+    fn lower_all(&mut self, exprs: &[Spanned<Expr>]) -> Option<Vec<SlotExpr>> {
+        exprs.iter().map(|e| self.lower(e)).collect()
+    }
+
+    fn callee(&self, name: &str) -> Callee {
+        // Same precedence as `Interpreter::call`: builtins shadow user functions
+        if let Some(builtin) = self.builtins.get(name) {
+            Callee::Builtin(*builtin)
+        } else if let Some(&idx) = self.index.get(name) {
+            Callee::Slot(idx)
+        } else {
+            Callee::Env(name.to_string())
+        }
+    }
+
+    /// Lower one expression; `None` means the function must fall back to
+    /// the environment evaluator (the resolver is then discarded, so scopes
+    /// need not be balanced on that path)
+    fn lower(&mut self, expr: &Spanned<Expr>) -> Option<SlotExpr> {
+        Some(match &expr.node {
+            Expr::IntLit(n) => SlotExpr::Const(Value::Int(*n)),
+            Expr::FloatLit(f) => SlotExpr::Const(Value::Float(*f)),
+            Expr::BoolLit(b) => SlotExpr::Const(Value::Bool(*b)),
+            Expr::StringLit(s) => SlotExpr::Const(Value::Str(Rc::new(s.clone()))),
+            Expr::CharLit(c) => SlotExpr::Const(Value::Char(*c)),
+            Expr::Unit => SlotExpr::Const(Value::Unit),
+
+            Expr::Var(name) => SlotExpr::Local(self.lookup(name)?),
+
+            Expr::Binary { left, op, right } => SlotExpr::Binary {
+                left: self.boxed(left)?,
+                op: *op,
+                right: self.boxed(right)?,
+            },
+
+            Expr::Unary { op, expr } => SlotExpr::Unary { op: *op, expr: self.boxed(expr)? },
+
+            Expr::If { cond, then_branch, else_branch } => SlotExpr::If {
+                cond: self.boxed(cond)?,
+                then_branch: Box::new(self.scoped(|r| r.lower(then_branch))?),
+                else_branch: Box::new(self.scoped(|r| r.lower(else_branch))?),
+            },
+
+            // The binding stays visible until the enclosing scope ends,
+            // matching `Environment::define` in the current scope
+            Expr::Let { name, value, body, .. } => {
+                let value = self.boxed(value)?;
+                let slot = self.declare(name);
+                SlotExpr::Let { slot, value, body: self.boxed(body)? }
+            }
+
+            Expr::Assign { name, value } => SlotExpr::Assign {
+                slot: self.lookup(name)?,
+                value: self.boxed(value)?,
+            },
+
+            Expr::While { cond, body, .. } => SlotExpr::While {
+                cond: self.boxed(cond)?,
+                body: Box::new(self.scoped(|r| r.lower(body))?),
+            },
+
+            Expr::For { var, iter, body } => {
+                let iter = self.boxed(iter)?;
+                self.scoped(|r| {
+                    let slot = r.declare(var);
+                    Some(SlotExpr::For { slot, iter, body: r.boxed(body)? })
+                })?
+            }
+
+            Expr::Loop { body } => SlotExpr::Loop(Box::new(self.scoped(|r| r.lower(body))?)),
+
+            Expr::Range { start, end, kind } => SlotExpr::Range {
+                start: self.boxed(start)?,
+                end: self.boxed(end)?,
+                kind: *kind,
+            },
+
+            Expr::Call { func, args } => SlotExpr::Call {
+                callee: self.callee(func),
+                args: self.lower_all(args)?,
+            },
+
+            Expr::MethodCall { receiver, method, args } => SlotExpr::MethodCall {
+                receiver: self.boxed(receiver)?,
+                method: method.clone(),
+                args: self.lower_all(args)?,
+            },
+
+            Expr::Block(exprs) => self.scoped(|r| r.lower_all(exprs).map(SlotExpr::Block))?,
+
+            Expr::Match { expr: scrutinee, arms } => {
+                let scrutinee = self.boxed(scrutinee)?;
+                self.scoped(|r| {
+                    let arms = arms.iter().map(|a| r.lower_arm(a)).collect::<Option<Vec<_>>>()?;
+                    Some(SlotExpr::Match { expr: scrutinee, arms })
+                })?
+            }
+
+            Expr::StructInit { name, fields } => SlotExpr::StructInit {
+                name: name.clone(),
+                fields: fields
+                    .iter()
+                    .map(|(f, e)| Some((f.node.clone(), self.lower(e)?)))
+                    .collect::<Option<Vec<_>>>()?,
+            },
+
+            Expr::FieldAccess { expr, field } => SlotExpr::FieldAccess {
+                expr: self.boxed(expr)?,
+                field: field.node.clone(),
+            },
+
+            Expr::TupleField { expr, index } => SlotExpr::TupleField { expr: self.boxed(expr)?, index: *index },
+
+            Expr::EnumVariant { enum_name, variant, args } => SlotExpr::EnumVariant {
+                enum_name: Symbol::intern(enum_name),
+                variant: Symbol::intern(variant),
+                args: self.lower_all(args)?,
+            },
+
+            Expr::Ref(inner) | Expr::RefMut(inner) => SlotExpr::Ref(self.boxed(inner)?),
+            Expr::Deref(inner) => SlotExpr::Deref(self.boxed(inner)?),
+
+            Expr::ArrayLit(elems) => SlotExpr::ArrayLit(self.lower_all(elems)?),
+            Expr::Tuple(elems) => SlotExpr::Tuple(self.lower_all(elems)?),
+
+            Expr::Index { expr, index } => SlotExpr::Index {
+                expr: self.boxed(expr)?,
+                index: self.boxed(index)?,
+            },
+
+            Expr::Return { value } => SlotExpr::Return(match value {
+                Some(v) => Some(self.boxed(v)?),
+                None => None,
+            }),
+
+            Expr::Cast { expr, ty } => SlotExpr::Cast { expr: self.boxed(expr)?, ty: ty.node.clone() },
+
+            Expr::Todo { message } => {
+                SlotExpr::Todo(message.clone().unwrap_or_else(|| "not yet implemented".to_string()))
+            }
+
+            // Closures, loop control and contract-only expressions
+            Expr::Closure { .. }
+            | Expr::Break { .. }
+            | Expr::Continue
+            | Expr::Ret
+            | Expr::It
+            | Expr::StateRef { .. }
+            | Expr::Forall { .. }
+            | Expr::Exists { .. } => return None,
+        })
+    }
+
+    /// Lower one match arm inside the match's scope; arms reuse the same
+    /// slots since only one of them binds
+    fn lower_arm(&mut self, arm: &MatchArm) -> Option<SlotArm> {
+        let names = pattern_bindings(&arm.pattern.node)?;
+        self.open();
+        let binds = names.iter().map(|n| self.declare(n)).collect();
+        let guard = match &arm.guard {
+            Some(g) => Some(self.lower(g)?),
+            None => None,
+        };
+        let body = self.lower(&arm.body)?;
+        self.close();
+        Some(SlotArm { pattern: arm.pattern.node.clone(), binds, guard, body })
+    }
+}
+
+/// Names bound by `pattern`, in the order `Interpreter::match_pattern`
+/// returns them; `None` if alternatives of an or-pattern bind differently
+fn pattern_bindings(pattern: &Pattern) -> Option<Vec<String>> {
+    let mut out = Vec::new();
+    collect_bindings(pattern, &mut out)?;
+    Some(out)
+}
+
+fn collect_bindings(pattern: &Pattern, out: &mut Vec<String>) -> Option<()> {
+    match pattern {
+        Pattern::Wildcard | Pattern::Literal(_) | Pattern::Range { .. } => {}
+        Pattern::Var(name) => out.push(name.clone()),
+        Pattern::EnumVariant { bindings, .. } => {
+            for b in bindings {
+                collect_bindings(&b.node, out)?;
+            }
+        }
+        Pattern::Struct { fields, .. } => {
+            for (_, p) in fields {
+                collect_bindings(&p.node, out)?;
+            }
+        }
+        Pattern::Or(alts) => {
+            let mut first: Option<Vec<String>> = None;
+            for alt in alts {
+                let names = pattern_bindings(&alt.node)?;
+                match &first {
+                    Some(f) if *f != names => return None,
+                    Some(_) => {}
+                    None => first = Some(names),
+                }
+            }
+            out.extend(first.unwrap_or_default());
+        }
+        Pattern::Binding { name, pattern } => {
+            collect_bindings(&pattern.node, out)?;
+            out.push(name.clone());
+        }
+        Pattern::Tuple(pats) | Pattern::Array(pats) => {
+            for p in pats {
+                collect_bindings(&p.node, out)?;
+            }
+        }
+        Pattern::ArrayRest { prefix, suffix } => {
+            for p in prefix.iter().chain(suffix) {
+                collect_bindings(&p.node, out)?;
+            }
+        }
+    }
+    Some(())
+}
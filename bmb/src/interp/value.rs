@@ -4,6 +4,10 @@ use std::fmt;
 use std::rc::Rc;
 use std::cell::RefCell;
 
+use super::layout::{Payload, StructLayout};
+use crate::ast::Symbol;
+use super::rope::Rope;
+
 /// Runtime value
 #[derive(Debug, Clone)]
 pub enum Value {
@@ -18,14 +22,14 @@ pub enum Value {
     /// Character value (v0.64)
     Char(char),
     /// String rope for lazy concatenation (v0.30.283)
-    /// Stores fragments that are concatenated only when materialized
-    StringRope(Rc<RefCell<Vec<Rc<String>>>>),
+    /// Shared so that flattening on first contiguous read benefits every copy
+    StringRope(Rc<RefCell<Rope>>),
     /// Unit value
     Unit,
-    /// Struct value: (type_name, fields)
-    Struct(String, std::collections::HashMap<String, Value>),
-    /// Enum variant: (enum_name, variant_name, values)
-    Enum(String, String, Vec<Value>),
+    /// Struct value: shared layout and fields in definition order
+    Struct(Rc<StructLayout>, Box<[Value]>),
+    /// Enum variant: (enum, variant, arguments)
+    Enum(Symbol, Symbol, Payload),
     /// Range value (v0.5 Phase 3): (start, end) exclusive end
     Range(i64, i64),
     /// Reference value (v0.5 Phase 5): points to a value
@@ -46,7 +50,7 @@ impl Value {
             Value::Str(s) => !s.is_empty(),
             // v0.64: Char is truthy if not null char
             Value::Char(c) => *c != '\0',
-            Value::StringRope(fragments) => !fragments.borrow().is_empty(),
+            Value::StringRope(rope) => !rope.borrow().fragments().is_empty(),
             Value::Unit => false,
             Value::Struct(_, _) => true,
             Value::Enum(_, _, _) => true,
@@ -68,8 +72,8 @@ impl Value {
             Value::Char(_) => "char",
             Value::StringRope(_) => "String",  // Same type name for user
             Value::Unit => "()",
-            Value::Struct(name, _) => name,
-            Value::Enum(name, _, _) => name,
+            Value::Struct(layout, _) => layout.name.as_str(),
+            Value::Enum(name, _, _) => name.as_str(),
             Value::Range(_, _) => "Range",
             Value::Ref(_) => "&ref",
             Value::Array(_) => "array",
@@ -79,44 +83,62 @@ impl Value {
 
     /// Materialize a StringRope into a regular String (v0.30.283)
     pub fn materialize_string(&self) -> Option<String> {
+        self.shared_string().map(|s| s.as_ref().clone())
+    }
+
+    /// The string contents without copying; a rope is flattened in place
+    pub fn shared_string(&self) -> Option<Rc<String>> {
         match self {
-            Value::Str(s) => Some(s.as_ref().clone()),
-            Value::StringRope(fragments) => {
-                let frags = fragments.borrow();
-                let total_len: usize = frags.iter().map(|s| s.len()).sum();
-                let mut result = String::with_capacity(total_len);
-                for frag in frags.iter() {
-                    result.push_str(frag);
-                }
-                Some(result)
-            }
+            Value::Str(s) => Some(Rc::clone(s)),
+            Value::StringRope(rope) => Some(rope.borrow_mut().flatten()),
             _ => None,
         }
     }
 
-    /// Create a StringRope from two string values (v0.30.283)
-    pub fn concat_strings(a: &Value, b: &Value) -> Option<Value> {
-        let mut fragments: Vec<Rc<String>> = Vec::new();
+    /// Byte length of a string value, O(1) for ropes
+    pub fn string_len(&self) -> Option<usize> {
+        match self {
+            Value::Str(s) => Some(s.len()),
+            Value::StringRope(rope) => Some(rope.borrow().len()),
+            _ => None,
+        }
+    }
 
-        // Collect fragments from first operand
-        match a {
-            Value::Str(s) => fragments.push(s.clone()),
-            Value::StringRope(frags) => {
-                fragments.extend(frags.borrow().iter().cloned());
-            }
-            _ => return None,
+    /// Byte at `index` of a string value, O(log fragments) for ropes
+    pub fn string_byte_at(&self, index: usize) -> Option<u8> {
+        match self {
+            Value::Str(s) => s.as_bytes().get(index).copied(),
+            Value::StringRope(rope) => rope.borrow().byte_at(index),
+            _ => None,
         }
+    }
 
-        // Collect fragments from second operand
-        match b {
-            Value::Str(s) => fragments.push(s.clone()),
-            Value::StringRope(frags) => {
-                fragments.extend(frags.borrow().iter().cloned());
-            }
-            _ => return None,
+    /// Write a string value's bytes, fragment by fragment for ropes
+    pub fn write_string(&self, out: &mut impl std::io::Write) -> Option<std::io::Result<()>> {
+        match self {
+            Value::Str(s) => Some(out.write_all(s.as_bytes())),
+            Value::StringRope(rope) => Some(rope.borrow().write_to(out)),
+            _ => None,
         }
+    }
 
-        Some(Value::StringRope(Rc::new(RefCell::new(fragments))))
+    /// Create a StringRope from two string values (v0.30.283)
+    pub fn concat_strings(a: &Value, b: &Value) -> Option<Value> {
+        let fragments = |v: &Value| match v {
+            Value::Str(_) => Some(1),
+            Value::StringRope(rope) => Some(rope.borrow().fragments().len()),
+            _ => None,
+        };
+        let mut rope = Rope::with_capacity(fragments(a)? + fragments(b)?);
+        for operand in [a, b] {
+            match operand {
+                Value::Str(s) => rope.push(Rc::clone(s)),
+                Value::StringRope(other) => rope.extend(&other.borrow()),
+                _ => unreachable!("checked above"),
+            }
+        }
+        rope.compact();
+        Some(Value::StringRope(Rc::new(RefCell::new(rope))))
     }
 
     /// Try to convert to i64
@@ -162,20 +184,17 @@ impl fmt::Display for Value {
             Value::Str(s) => write!(f, "\"{s}\""),
             // v0.64: Char display
             Value::Char(c) => write!(f, "'{c}'"),
-            Value::StringRope(fragments) => {
-                // Materialize for display (v0.30.283)
-                let frags = fragments.borrow();
-                let total_len: usize = frags.iter().map(|s| s.len()).sum();
-                let mut result = String::with_capacity(total_len);
-                for frag in frags.iter() {
-                    result.push_str(frag);
+            Value::StringRope(rope) => {
+                write!(f, "\"")?;
+                for fragment in rope.borrow().fragments() {
+                    f.write_str(fragment)?;
                 }
-                write!(f, "\"{}\"", result)
+                write!(f, "\"")
             }
             Value::Unit => write!(f, "()"),
-            Value::Struct(name, fields) => {
-                write!(f, "{} {{ ", name)?;
-                for (i, (k, v)) in fields.iter().enumerate() {
+            Value::Struct(layout, fields) => {
+                write!(f, "{} {{ ", layout.name)?;
+                for (i, (k, v)) in layout.fields.iter().zip(fields.iter()).enumerate() {
                     if i > 0 {
                         write!(f, ", ")?;
                     }
@@ -237,29 +256,14 @@ impl PartialEq for Value {
             // v0.64: Character equality (by Unicode codepoint)
             (Value::Char(a), Value::Char(b)) => a == b,
             (Value::Str(a), Value::Str(b)) => a == b,
-            // StringRope comparisons (v0.30.283): materialize and compare
+            // StringRope comparisons (v0.30.283): lengths first, then bytes in place
             (Value::StringRope(a), Value::StringRope(b)) => {
-                let a_frags = a.borrow();
-                let b_frags = b.borrow();
-                if a_frags.len() == b_frags.len() {
-                    a_frags.iter().zip(b_frags.iter()).all(|(x, y)| x == y)
-                } else {
-                    // Different fragment counts, materialize to compare
-                    let a_str: String = a_frags.iter().map(|s| s.as_str()).collect();
-                    let b_str: String = b_frags.iter().map(|s| s.as_str()).collect();
-                    a_str == b_str
-                }
-            }
-            (Value::Str(a), Value::StringRope(b)) => {
-                let b_str: String = b.borrow().iter().map(|s| s.as_str()).collect();
-                a.as_str() == b_str
-            }
-            (Value::StringRope(a), Value::Str(b)) => {
-                let a_str: String = a.borrow().iter().map(|s| s.as_str()).collect();
-                a_str == b.as_str()
+                let (a, b) = (a.borrow(), b.borrow());
+                a.len() == b.len() && a.bytes().eq(b.bytes())
             }
+            (Value::Str(a), Value::StringRope(b)) | (Value::StringRope(b), Value::Str(a)) => b.borrow().eq_str(a),
             (Value::Unit, Value::Unit) => true,
-            (Value::Struct(n1, f1), Value::Struct(n2, f2)) => n1 == n2 && f1 == f2,
+            (Value::Struct(l1, f1), Value::Struct(l2, f2)) => l1 == l2 && f1 == f2,
             (Value::Enum(e1, v1, a1), Value::Enum(e2, v2, a2)) => e1 == e2 && v1 == v2 && a1 == a2,
             (Value::Range(s1, e1), Value::Range(s2, e2)) => s1 == s2 && e1 == e2,
             (Value::Ref(r1), Value::Ref(r2)) => *r1.borrow() == *r2.borrow(),
@@ -284,6 +288,20 @@ mod tests {
         assert_eq!(format!("{}", Value::Str(Rc::new("hello".to_string()))), "\"hello\"");
     }
 
+    #[test]
+    fn test_compact_aggregates() {
+        let layout = Rc::new(StructLayout::new("value_test_Point", ["x", "y"]));
+        let point = Value::Struct(layout, Box::new([Value::Int(1), Value::Int(2)]));
+        assert_eq!(format!("{}", point), "value_test_Point { x: 1, y: 2 }");
+        assert_eq!(point.type_name(), "value_test_Point");
+
+        let some = Value::Enum(Symbol::OPTION, Symbol::SOME, Payload::one(Value::Int(5)));
+        assert_eq!(format!("{}", some), "Option::Some(5)");
+        assert_eq!(format!("{}", Value::Enum(Symbol::OPTION, Symbol::NONE, Payload::Empty)), "Option::None");
+        // Down from 72 bytes with String/HashMap/Vec aggregates
+        assert!(std::mem::size_of::<Value>() <= 40);
+    }
+
     #[test]
     fn test_value_truthy() {
         assert!(Value::Bool(true).is_truthy());
@@ -329,6 +347,30 @@ mod tests {
         assert_eq!(rope, a);
     }
 
+    #[test]
+    fn test_string_rope_reads_without_flattening() {
+        let mut result = Value::Str(Rc::new(String::new()));
+        for i in 0..300 {
+            let fragment = Value::Str(Rc::new(format!("{}", i % 10)));
+            result = Value::concat_strings(&result, &fragment).unwrap();
+            // Length and byte reads leave the rope's fragments alone
+            assert_eq!(result.string_len(), Some(i + 1));
+            assert_eq!(result.string_byte_at(i), Some(b'0' + (i % 10) as u8));
+        }
+        // Concatenation flattened once the rope reached the threshold
+        if let Value::StringRope(rope) = &result {
+            assert!(rope.borrow().fragments().len() < crate::interp::rope::FLATTEN_FRAGMENTS);
+        }
+        let shared = result.shared_string().unwrap();
+        assert_eq!(shared.len(), 300);
+        assert_eq!(result, Value::Str(shared));
+
+        let mut out = Vec::new();
+        let ab = Value::concat_strings(&Value::Str(Rc::new("a".into())), &Value::Str(Rc::new("b".into()))).unwrap();
+        ab.write_string(&mut out).unwrap().unwrap();
+        assert_eq!(out, b"ab");
+    }
+
     #[test]
     fn test_string_rope_display() {
         let rope = Value::concat_strings(
@@ -348,8 +390,8 @@ mod tests {
         }
 
         // Should have 101 fragments (empty + 100 fragments)
-        if let Value::StringRope(frags) = &result {
-            assert_eq!(frags.borrow().len(), 101);
+        if let Value::StringRope(rope) = &result {
+            assert_eq!(rope.borrow().fragments().len(), 101);
         }
 
         // Materialize should produce correct result
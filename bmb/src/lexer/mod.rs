@@ -28,3 +28,47 @@ pub fn tokenize(source: &str) -> Result<Vec<(Token, Span)>> {
 
     Ok(tokens)
 }
+
+/// Streaming token iterator in the parser's `(start, token, end)` shape
+///
+/// Tokens are produced as the parser pulls them, so no intermediate token
+/// vector is built. Iteration stops at the first lexer error, which is kept
+/// for `take_error`.
+pub struct Tokens<'src> {
+    lexer: logos::Lexer<'src, Token>,
+    error: Option<CompileError>,
+}
+
+/// Lex `source` lazily (see `Tokens`)
+pub fn tokens(source: &str) -> Tokens<'_> {
+    Tokens { lexer: Token::lexer(source), error: None }
+}
+
+impl Tokens<'_> {
+    /// The lexer error that ended iteration, if any
+    pub fn take_error(&mut self) -> Option<CompileError> {
+        self.error.take()
+    }
+}
+
+impl Iterator for Tokens<'_> {
+    type Item = (usize, Token, usize);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.error.is_some() {
+            return None;
+        }
+        let result = self.lexer.next()?;
+        let span = Span::new(self.lexer.span().start, self.lexer.span().end);
+        match result {
+            Ok(token) => Some((span.start, token, span.end)),
+            Err(_) => {
+                self.error = Some(CompileError::lexer(
+                    format!("unexpected character: {:?}", self.lexer.slice()),
+                    span,
+                ));
+                None
+            }
+        }
+    }
+}
@@ -34,6 +34,7 @@
 #![allow(clippy::type_complexity)]
 
 pub mod ast;
+pub mod bench;
 pub mod build;
 pub mod cfg;
 pub mod codegen;
@@ -44,13 +45,16 @@ pub mod interp;
 pub mod lexer;
 pub mod lsp;
 pub mod mir;
+pub mod parallel;
 pub mod parser;
+pub mod profile;
 pub mod query;
 pub mod repl;
 pub mod resolver;
 pub mod smt;
 pub mod types;
 pub mod verify;
+pub mod vm;
 
 pub use ast::Span;
 pub use error::{CompileError, Result};
@@ -0,0 +1,369 @@
+//! Document text and incremental analysis state
+//!
+//! Edits arrive as ranges (incremental sync) and are applied to the stored
+//! text; a line table maps between byte offsets and positions. Analysis
+//! tokenizes the whole document, which is cheap, but parses and type checks
+//! per top-level item. An item whose text did not change is reused from the
+//! previous analysis, relocated if text before it moved, and a function
+//! whose text and the program's declarations did not change is not checked
+//! again.
+
+use std::collections::{HashMap, HashSet};
+use std::hash::{DefaultHasher, Hash, Hasher};
+use std::ops::Range;
+
+use tower_lsp::lsp_types::{Position, TextDocumentContentChangeEvent};
+
+use crate::ast::{FnDef, Item, ModuleHeader, Program, Span};
+use crate::error::Result;
+use crate::lexer::{self, Token};
+use crate::parser;
+use crate::types::TypeChecker;
+
+use super::{collect_item_symbols, SymbolDef, SymbolRef};
+
+/// Byte offsets of the line starts of a document
+#[derive(Clone)]
+pub(super) struct LineIndex {
+    starts: Vec<usize>,
+}
+
+impl LineIndex {
+    pub fn new(text: &str) -> Self {
+        let mut starts = vec![0];
+        starts.extend(text.bytes().enumerate().filter(|&(_, b)| b == b'\n').map(|(i, _)| i + 1));
+        Self { starts }
+    }
+
+    /// Position of a byte offset (columns count UTF-16 code units, the LSP
+    /// default encoding)
+    pub fn position(&self, offset: usize, text: &str) -> Position {
+        let offset = offset.min(text.len());
+        let line = self.starts.partition_point(|&s| s <= offset) - 1;
+        let start = self.starts[line];
+        let col = text.get(start..offset).map_or(offset - start, |s| s.chars().map(char::len_utf16).sum());
+        Position::new(line as u32, col as u32)
+    }
+
+    /// Byte offset of a position; columns past the end of a line clamp to it,
+    /// and a column inside a surrogate pair to the start of its character
+    pub fn offset(&self, position: Position, text: &str) -> usize {
+        let Some(&start) = self.starts.get(position.line as usize) else {
+            return text.len();
+        };
+        let end = self.starts.get(position.line as usize + 1).map_or(text.len(), |&next| next - 1);
+        let mut units = 0;
+        for (i, c) in text[start..end].char_indices() {
+            units += c.len_utf16();
+            if units > position.character as usize {
+                return start + i;
+            }
+        }
+        end
+    }
+}
+
+/// Apply one `didChange` content change to `text`
+pub(super) fn apply_change(text: &mut String, lines: &mut LineIndex, change: TextDocumentContentChangeEvent) {
+    match change.range {
+        Some(range) => {
+            let start = lines.offset(range.start, text);
+            let end = lines.offset(range.end, text).max(start);
+            text.replace_range(start..end, &change.text);
+        }
+        None => *text = change.text,
+    }
+    *lines = LineIndex::new(text);
+}
+
+/// Split a token stream at top-level item boundaries
+///
+/// An item starts at a declaration keyword or attribute at nesting depth
+/// zero, right after the previous item ended with `;` or `}` (or after the
+/// module header's `===`). Tokens before the first item (the module header)
+/// form their own range.
+pub(super) fn item_ranges(tokens: &[(Token, Span)]) -> Vec<Range<usize>> {
+    let mut ranges = Vec::new();
+    let mut start = 0;
+    let mut depth = 0usize;
+    let mut at_boundary = true;
+    for (i, (tok, _)) in tokens.iter().enumerate() {
+        let starts_item = matches!(
+            tok,
+            Token::At
+                | Token::Pub
+                | Token::Fn
+                | Token::Struct
+                | Token::Enum
+                | Token::Use
+                | Token::Extern
+                | Token::Trait
+                | Token::Impl
+                | Token::Type
+        );
+        if depth == 0 && at_boundary && starts_item && i > start {
+            ranges.push(start..i);
+            start = i;
+        }
+        match tok {
+            Token::LParen | Token::LBrace | Token::LBracket => depth += 1,
+            Token::RParen | Token::RBrace | Token::RBracket => depth = depth.saturating_sub(1),
+            _ => {}
+        }
+        at_boundary = depth == 0 && matches!(tok, Token::Semi | Token::RBrace | Token::HeaderSep);
+    }
+    if start < tokens.len() {
+        ranges.push(start..tokens.len());
+    }
+    ranges
+}
+
+/// Items parsed from one chunk of source text
+struct ParsedChunk {
+    /// Byte offset of the chunk the spans below were computed for
+    start: usize,
+    header: Option<ModuleHeader>,
+    items: Vec<Item>,
+    definitions: Vec<SymbolDef>,
+    references: Vec<SymbolRef>,
+}
+
+impl ParsedChunk {
+    fn parse(tokens: Vec<(Token, Span)>, start: usize) -> Result<Self> {
+        let program = parser::parse("<lsp>", "", tokens)?;
+        let mut definitions = Vec::new();
+        let mut references = Vec::new();
+        for item in &program.items {
+            collect_item_symbols(item, &mut definitions, &mut references);
+        }
+        Ok(Self { start, header: program.header, items: program.items, definitions, references })
+    }
+
+    fn relocate(&mut self, start: usize) {
+        let delta = start as isize - self.start as isize;
+        let shift = |span: &mut Span| {
+            span.start = span.start.saturating_add_signed(delta);
+            span.end = span.end.saturating_add_signed(delta);
+        };
+        if let Some(header) = &mut self.header {
+            header.shift_spans(delta);
+        }
+        for item in &mut self.items {
+            item.shift_spans(delta);
+        }
+        self.definitions.iter_mut().for_each(|d| shift(&mut d.span));
+        self.references.iter_mut().for_each(|r| shift(&mut r.span));
+        self.start = start;
+    }
+}
+
+/// A parsed document with its symbols
+pub(super) struct ParsedDocument {
+    pub program: Program,
+    pub definitions: Vec<SymbolDef>,
+    pub references: Vec<SymbolRef>,
+}
+
+/// Parsed items and checked function bodies kept between analyses of one document
+#[derive(Default)]
+pub(super) struct AnalysisCache {
+    /// Chunks of the last analysis, by source text
+    chunks: HashMap<String, ParsedChunk>,
+    /// Keys (see `type_check`) of function bodies that checked cleanly
+    checked: HashSet<u64>,
+}
+
+impl AnalysisCache {
+    /// Parse `content`, reusing the items whose text did not change
+    pub fn parse(&mut self, content: &str) -> Result<ParsedDocument> {
+        let tokens = lexer::tokenize(content)?;
+        let mut previous = std::mem::take(&mut self.chunks);
+        let mut doc = ParsedDocument {
+            program: Program { header: None, items: Vec::new() },
+            definitions: Vec::new(),
+            references: Vec::new(),
+        };
+        for range in item_ranges(&tokens) {
+            let start = tokens[range.start].1.start;
+            let text = &content[start..tokens[range.end - 1].1.end];
+            let chunk = match previous.remove(text) {
+                Some(mut chunk) => {
+                    if chunk.start != start {
+                        chunk.relocate(start);
+                    }
+                    chunk
+                }
+                None => match ParsedChunk::parse(tokens[range].to_vec(), start) {
+                    Ok(chunk) => chunk,
+                    // A chunk may fail on its own only because the split
+                    // guessed an item boundary wrong; the whole document
+                    // decides, and its error is the one to report
+                    Err(_) => return self.parse_whole(tokens),
+                },
+            };
+            if doc.program.header.is_none() {
+                doc.program.header = chunk.header.clone();
+            }
+            doc.program.items.extend(chunk.items.iter().cloned());
+            doc.definitions.extend(chunk.definitions.iter().cloned());
+            doc.references.extend(chunk.references.iter().cloned());
+            self.chunks.insert(text.to_string(), chunk);
+        }
+        Ok(doc)
+    }
+
+    fn parse_whole(&mut self, tokens: Vec<(Token, Span)>) -> Result<ParsedDocument> {
+        let chunk = ParsedChunk::parse(tokens, 0)?;
+        Ok(ParsedDocument {
+            program: Program { header: chunk.header, items: chunk.items },
+            definitions: chunk.definitions,
+            references: chunk.references,
+        })
+    }
+
+    /// Type check `program`, skipping function bodies that checked cleanly
+    /// against the same declarations in an earlier analysis
+    pub fn type_check(&mut self, content: &str, program: &Program) -> Result<()> {
+        let text = |span: Span| content.get(span.start..span.end).unwrap_or("");
+        let mut declarations = DefaultHasher::new();
+        for item in &program.items {
+            match item {
+                Item::FnDef(f) => text(Span::new(f.span.start, f.body.span.start)).hash(&mut declarations),
+                other => text(item_span(other)).hash(&mut declarations),
+            }
+        }
+        let declarations = declarations.finish();
+        let key = |f: &FnDef| {
+            let mut h = DefaultHasher::new();
+            declarations.hash(&mut h);
+            text(f.span).hash(&mut h);
+            h.finish()
+        };
+
+        let mut checker = TypeChecker::new();
+        let result = checker.check_program_where(program, |f| !self.checked.contains(&key(f)));
+
+        // Bodies are checked in order, so when one fails every function
+        // before it passed; errors outside any function leave nothing known
+        let fns: Vec<&FnDef> = program
+            .items
+            .iter()
+            .filter_map(|item| match item {
+                Item::FnDef(f) => Some(f),
+                _ => None,
+            })
+            .collect();
+        let passed_before = match &result {
+            Ok(()) => usize::MAX,
+            Err(e) => match e.span() {
+                Some(span) if fns.iter().any(|f| f.span.start <= span.start && span.end <= f.span.end) => span.start,
+                _ => 0,
+            },
+        };
+        self.checked = fns
+            .iter()
+            .map(|f| (f, key(f)))
+            .filter(|(f, k)| f.span.end <= passed_before || self.checked.contains(k))
+            .map(|(_, k)| k)
+            .collect();
+        result
+    }
+}
+
+fn item_span(item: &Item) -> Span {
+    match item {
+        Item::FnDef(f) => f.span,
+        Item::StructDef(s) => s.span,
+        Item::EnumDef(e) => e.span,
+        Item::TypeAlias(t) => t.span,
+        Item::Use(u) => u.span,
+        Item::ExternFn(e) => e.span,
+        Item::TraitDef(t) => t.span,
+        Item::ImplBlock(i) => i.span,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tower_lsp::lsp_types::Range as LspRange;
+
+    #[test]
+    fn test_line_index_round_trip() {
+        let text = "fn a() = 1;\n\nfn b() = 2;";
+        let lines = LineIndex::new(text);
+        assert_eq!(lines.position(0, text), Position::new(0, 0));
+        assert_eq!(lines.position(12, text), Position::new(1, 0));
+        assert_eq!(lines.position(16, text), Position::new(2, 3));
+        assert_eq!(lines.offset(Position::new(2, 3), text), 16);
+        // Columns past the end of a line clamp to its newline
+        assert_eq!(lines.offset(Position::new(0, 40), text), 11);
+        assert_eq!(lines.offset(Position::new(9, 0), text), text.len());
+    }
+
+    #[test]
+    fn test_line_index_counts_characters() {
+        let text = "let s = \"é\"; x";
+        let lines = LineIndex::new(text);
+        let x = text.find('x').unwrap();
+        assert_eq!(lines.position(x, text), Position::new(0, 13));
+        assert_eq!(lines.offset(Position::new(0, 13), text), x);
+    }
+
+    #[test]
+    fn test_line_index_counts_utf16_units() {
+        // The emoji is one character but a surrogate pair in UTF-16
+        let text = "let s = \"\u{1F600}\"; x";
+        let lines = LineIndex::new(text);
+        let x = text.find('x').unwrap();
+        assert_eq!(lines.position(x, text), Position::new(0, 14));
+        assert_eq!(lines.offset(Position::new(0, 14), text), x);
+
+        // An edit after the emoji splices at the right byte
+        let mut text = text.to_string();
+        let mut lines = LineIndex::new(&text);
+        let change = TextDocumentContentChangeEvent {
+            range: Some(LspRange::new(Position::new(0, 14), Position::new(0, 15))),
+            range_length: None,
+            text: "y".to_string(),
+        };
+        apply_change(&mut text, &mut lines, change);
+        assert_eq!(text, "let s = \"\u{1F600}\"; y");
+    }
+
+    #[test]
+    fn test_apply_incremental_changes() {
+        let mut text = "fn a() = 1;\nfn b() = 2;".to_string();
+        let mut lines = LineIndex::new(&text);
+        let edit = |start: (u32, u32), end: (u32, u32), new: &str| TextDocumentContentChangeEvent {
+            range: Some(LspRange::new(Position::new(start.0, start.1), Position::new(end.0, end.1))),
+            range_length: None,
+            text: new.to_string(),
+        };
+        apply_change(&mut text, &mut lines, edit((1, 9), (1, 10), "20"));
+        apply_change(&mut text, &mut lines, edit((0, 11), (0, 11), "\nfn c() = 3;"));
+        assert_eq!(text, "fn a() = 1;\nfn c() = 3;\nfn b() = 20;");
+        assert_eq!(lines.position(text.len(), &text), Position::new(2, 12));
+        apply_change(
+            &mut text,
+            &mut lines,
+            TextDocumentContentChangeEvent { range: None, range_length: None, text: "fn d() = 4;".to_string() },
+        );
+        assert_eq!(text, "fn d() = 4;");
+    }
+
+    #[test]
+    fn test_item_ranges_split_top_level_items() {
+        use Token::*;
+        let ident = |s: &str| Ident(s.to_string());
+        // @pure fn f() = if c { 1 } else { 2 };  struct S { x: i64 }  impl T for S { fn m() = 0; }
+        let toks = vec![
+            At, ident("pure"), Fn, ident("f"), LParen, RParen, Eq, If, ident("c"), LBrace, IntLit(1), RBrace,
+            Else, LBrace, IntLit(2), RBrace, Semi,
+            Struct, ident("S"), LBrace, ident("x"), Colon, TyI64, RBrace,
+            Impl, ident("T"), For, ident("S"), LBrace, Fn, ident("m"), LParen, RParen, Eq, IntLit(0), Semi, RBrace,
+        ];
+        let tokens: Vec<(Token, Span)> = toks.into_iter().enumerate().map(|(i, t)| (t, Span::new(i, i + 1))).collect();
+        assert_eq!(item_ranges(&tokens), vec![0..17, 17..24, 24..37]);
+    }
+}
@@ -7,9 +7,17 @@
 //! - Formatting (v0.9.0)
 //! - Go to Definition (v0.9.0)
 //! - Find References (v0.9.0)
+//!
+//! Documents use incremental sync. Edits are applied as they arrive;
+//! analysis runs after a short debounce on a blocking thread, drops itself
+//! when a newer edit supersedes it, and re-parses and re-checks only the
+//! top-level items that changed (see `document`).
+
+mod document;
 
 use std::collections::HashMap;
-use std::sync::RwLock;
+use std::sync::{Arc, Mutex, RwLock};
+use std::time::Duration;
 
 use tower_lsp::jsonrpc::Result;
 use tower_lsp::lsp_types::*;
@@ -17,9 +25,11 @@ use tower_lsp::{Client, LanguageServer, LspService, Server};
 
 use crate::ast::{Expr, Item, Program, Span};
 use crate::error::CompileError;
-use crate::lexer;
-use crate::parser;
-use crate::types::TypeChecker;
+
+use document::{apply_change, AnalysisCache, LineIndex, ParsedDocument};
+
+/// Quiet period after an edit before the document is analyzed
+const ANALYSIS_DEBOUNCE: Duration = Duration::from_millis(150);
 
 /// BMB Language keywords for completion
 const BMB_KEYWORDS: &[&str] = &[
@@ -73,395 +83,341 @@ enum SymbolKind {
 /// Document state
 struct DocumentState {
     content: String,
+    /// Line starts of `content`
+    lines: LineIndex,
+    /// AST of the last completed analysis (None if it failed to parse)
     ast: Option<Program>,
     /// Symbol definitions in this document
     definitions: Vec<SymbolDef>,
     /// Symbol references in this document
     references: Vec<SymbolRef>,
-    #[allow(dead_code)]
     version: i32,
+    /// Bumped by every edit; analyses of older generations are dropped
+    generation: u64,
+    /// Items and checked bodies reused by the next analysis
+    cache: Arc<Mutex<AnalysisCache>>,
 }
 
 /// BMB Language Server Backend
 pub struct Backend {
     client: Client,
-    documents: RwLock<HashMap<Url, DocumentState>>,
+    documents: Arc<RwLock<HashMap<Url, DocumentState>>>,
 }
 
 impl Backend {
     pub fn new(client: Client) -> Self {
         Self {
             client,
-            documents: RwLock::new(HashMap::new()),
+            documents: Arc::new(RwLock::new(HashMap::new())),
         }
     }
 
-    /// Analyze document and publish diagnostics
-    async fn analyze_document(&self, uri: &Url, content: &str, version: i32) {
-        let diagnostics = self.get_diagnostics(uri, content);
+    /// Analyze a document after `delay` and publish diagnostics
+    ///
+    /// The analysis is dropped if the document changed in the meantime
+    /// (`generation` is stale): before it starts, and again before its
+    /// results are stored, so a slow analysis never overwrites a newer one.
+    fn schedule_analysis(&self, uri: Url, generation: u64, delay: Duration) {
+        let documents = Arc::clone(&self.documents);
+        let client = self.client.clone();
+        tokio::spawn(async move {
+            tokio::time::sleep(delay).await;
+            let (content, lines, cache) = {
+                let docs = documents.read().unwrap();
+                match docs.get(&uri) {
+                    Some(doc) if doc.generation == generation => {
+                        (doc.content.clone(), doc.lines.clone(), Arc::clone(&doc.cache))
+                    }
+                    _ => return,
+                }
+            };
 
-        // Parse AST if successful for hover/completion
-        let ast = self.try_parse(content);
+            let analysis = tokio::task::spawn_blocking(move || {
+                let mut cache = cache.lock().unwrap();
+                analyze(&content, &lines, &mut cache)
+            })
+            .await;
+            let Ok((parsed, diagnostics)) = analysis else { return };
+
+            let version = {
+                let mut docs = documents.write().unwrap();
+                let Some(doc) = docs.get_mut(&uri).filter(|doc| doc.generation == generation) else {
+                    return;
+                };
+                let (ast, definitions, references) = match parsed {
+                    Some(p) => (Some(p.program), p.definitions, p.references),
+                    None => (None, Vec::new(), Vec::new()),
+                };
+                doc.ast = ast;
+                doc.definitions = definitions;
+                doc.references = references;
+                doc.version
+            };
 
-        // Collect symbols from AST
-        let (definitions, references) = if let Some(ref ast) = ast {
-            self.collect_symbols(ast)
-        } else {
-            (Vec::new(), Vec::new())
-        };
+            client.publish_diagnostics(uri, diagnostics, Some(version)).await;
+        });
+    }
 
-        // Store document state
-        {
-            let mut docs = self.documents.write().unwrap();
-            docs.insert(uri.clone(), DocumentState {
-                content: content.to_string(),
-                ast,
-                definitions,
-                references,
-                version,
-            });
+    /// Get word at position for hover
+    fn get_word_at_position(&self, doc: &DocumentState, position: Position) -> Option<String> {
+        let content = &doc.content;
+        let offset = doc.lines.offset(position, content);
+
+        // Find word boundaries
+        let bytes = content.as_bytes();
+        let mut start = offset;
+        let mut end = offset;
+
+        // Walk back to find start of word
+        while start > 0 && Self::is_ident_char(bytes[start - 1] as char) {
+            start -= 1;
         }
 
-        // Publish diagnostics
-        self.client
-            .publish_diagnostics(uri.clone(), diagnostics, Some(version))
-            .await;
+        // Walk forward to find end of word
+        while end < bytes.len() && Self::is_ident_char(bytes[end] as char) {
+            end += 1;
+        }
+
+        if start < end {
+            Some(content[start..end].to_string())
+        } else {
+            None
+        }
     }
 
-    /// Collect symbol definitions and references from AST
-    fn collect_symbols(&self, ast: &Program) -> (Vec<SymbolDef>, Vec<SymbolRef>) {
-        let mut definitions = Vec::new();
-        let mut references = Vec::new();
-
-        for item in &ast.items {
-            match item {
-                Item::FnDef(f) => {
-                    // Function definition
-                    definitions.push(SymbolDef {
-                        name: f.name.node.clone(),
-                        kind: SymbolKind::Function,
-                        span: f.name.span,
-                    });
+    fn is_ident_char(c: char) -> bool {
+        c.is_alphanumeric() || c == '_'
+    }
+}
 
-                    // Parameters as definitions
-                    for param in &f.params {
-                        definitions.push(SymbolDef {
-                            name: param.name.node.clone(),
-                            kind: SymbolKind::Parameter,
-                            span: param.name.span,
-                        });
-                    }
+/// Parse and type check a document, reusing unchanged items from `cache`
+fn analyze(content: &str, lines: &LineIndex, cache: &mut AnalysisCache) -> (Option<ParsedDocument>, Vec<Diagnostic>) {
+    let parsed = match cache.parse(content) {
+        Ok(parsed) => parsed,
+        Err(e) => return (None, vec![error_to_diagnostic(&e, lines, content)]),
+    };
+    let diagnostics = match cache.type_check(content, &parsed.program) {
+        Ok(()) => Vec::new(),
+        Err(e) => vec![error_to_diagnostic(&e, lines, content)],
+    };
+    (Some(parsed), diagnostics)
+}
 
-                    // Collect references from body
-                    self.collect_expr_refs(&f.body.node, &mut references);
+/// Collect the symbol definitions and references of one top-level item
+fn collect_item_symbols(item: &Item, definitions: &mut Vec<SymbolDef>, references: &mut Vec<SymbolRef>) {
+    match item {
+        Item::FnDef(f) => {
+            // Function definition
+            definitions.push(SymbolDef {
+                name: f.name.node.to_string(),
+                kind: SymbolKind::Function,
+                span: f.name.span,
+            });
 
-                    // Pre/post conditions
-                    if let Some(pre) = &f.pre {
-                        self.collect_expr_refs(&pre.node, &mut references);
-                    }
-                    if let Some(post) = &f.post {
-                        self.collect_expr_refs(&post.node, &mut references);
-                    }
-                }
-                Item::StructDef(s) => {
-                    definitions.push(SymbolDef {
-                        name: s.name.node.clone(),
-                        kind: SymbolKind::Struct,
-                        span: s.name.span,
-                    });
-                }
-                Item::EnumDef(e) => {
-                    definitions.push(SymbolDef {
-                        name: e.name.node.clone(),
-                        kind: SymbolKind::Enum,
-                        span: e.name.span,
-                    });
-                }
-                Item::Use(_) => {}
-                // v0.13.0: Extern functions as function definitions
-                Item::ExternFn(e) => {
-                    definitions.push(SymbolDef {
-                        name: e.name.node.clone(),
-                        kind: SymbolKind::Function,
-                        span: e.name.span,
-                    });
-                }
-                // v0.20.1: Trait definitions
-                Item::TraitDef(t) => {
-                    definitions.push(SymbolDef {
-                        name: t.name.node.clone(),
-                        kind: SymbolKind::Trait,
-                        span: t.name.span,
-                    });
-                }
-                // v0.20.1: Impl blocks - register methods
-                Item::ImplBlock(i) => {
-                    for method in &i.methods {
-                        definitions.push(SymbolDef {
-                            name: method.name.node.clone(),
-                            kind: SymbolKind::Method,
-                            span: method.name.span,
-                        });
-                        self.collect_expr_refs(&method.body.node, &mut references);
-                    }
-                }
-                // v0.50.6: Type aliases - register as type definitions
-                Item::TypeAlias(_) => {}
+            // Parameters as definitions
+            for param in &f.params {
+                definitions.push(SymbolDef {
+                    name: param.name.node.to_string(),
+                    kind: SymbolKind::Parameter,
+                    span: param.name.span,
+                });
             }
-        }
 
-        (definitions, references)
-    }
+            // Collect references from body
+            collect_expr_refs(&f.body.node, references);
 
-    /// Collect symbol references from expression
-    fn collect_expr_refs(&self, expr: &Expr, refs: &mut Vec<SymbolRef>) {
-        match expr {
-            Expr::Var(_name) => {
-                // This is a reference to a variable/function
-                // Note: We can't easily get the span here from Expr::Var
-                // For a more complete implementation, Expr::Var would need to be Spanned
-            }
-            Expr::Call { func: _, args, .. } => {
-                // Function call is a reference (name-only, no span in current AST)
-                for arg in args {
-                    self.collect_expr_refs(&arg.node, refs);
-                }
-            }
-            Expr::Let { value, body, .. } => {
-                self.collect_expr_refs(&value.node, refs);
-                self.collect_expr_refs(&body.node, refs);
+            // Pre/post conditions
+            if let Some(pre) = &f.pre {
+                collect_expr_refs(&pre.node, references);
             }
-            Expr::If { cond, then_branch, else_branch } => {
-                self.collect_expr_refs(&cond.node, refs);
-                self.collect_expr_refs(&then_branch.node, refs);
-                self.collect_expr_refs(&else_branch.node, refs);
-            }
-            Expr::Binary { left, right, .. } => {
-                self.collect_expr_refs(&left.node, refs);
-                self.collect_expr_refs(&right.node, refs);
-            }
-            Expr::Unary { expr, .. } => {
-                self.collect_expr_refs(&expr.node, refs);
-            }
-            Expr::Block(stmts) => {
-                for stmt in stmts {
-                    self.collect_expr_refs(&stmt.node, refs);
-                }
-            }
-            // v0.37: Include invariant in refs collection
-            Expr::While { cond, invariant, body } => {
-                self.collect_expr_refs(&cond.node, refs);
-                if let Some(inv) = invariant {
-                    self.collect_expr_refs(&inv.node, refs);
-                }
-                self.collect_expr_refs(&body.node, refs);
+            if let Some(post) = &f.post {
+                collect_expr_refs(&post.node, references);
             }
-            Expr::For { iter, body, .. } => {
-                self.collect_expr_refs(&iter.node, refs);
-                self.collect_expr_refs(&body.node, refs);
-            }
-            Expr::Match { expr, arms } => {
-                self.collect_expr_refs(&expr.node, refs);
-                for arm in arms {
-                    self.collect_expr_refs(&arm.body.node, refs);
-                }
-            }
-            Expr::MethodCall { receiver, args, .. } => {
-                self.collect_expr_refs(&receiver.node, refs);
-                for arg in args {
-                    self.collect_expr_refs(&arg.node, refs);
-                }
-            }
-            Expr::FieldAccess { expr, .. } => {
-                self.collect_expr_refs(&expr.node, refs);
-            }
-            // v0.43: Tuple field access
-            Expr::TupleField { expr, .. } => {
-                self.collect_expr_refs(&expr.node, refs);
-            }
-            Expr::Index { expr, index } => {
-                self.collect_expr_refs(&expr.node, refs);
-                self.collect_expr_refs(&index.node, refs);
-            }
-            Expr::ArrayLit(elems) => {
-                for elem in elems {
-                    self.collect_expr_refs(&elem.node, refs);
-                }
-            }
-            // v0.42: Tuple expressions
-            Expr::Tuple(elems) => {
-                for elem in elems {
-                    self.collect_expr_refs(&elem.node, refs);
-                }
-            }
-            Expr::StructInit { fields, .. } => {
-                for (_, value) in fields {
-                    self.collect_expr_refs(&value.node, refs);
-                }
-            }
-            Expr::Range { start, end, .. } => {
-                self.collect_expr_refs(&start.node, refs);
-                self.collect_expr_refs(&end.node, refs);
-            }
-            Expr::Assign { value, .. } => {
-                self.collect_expr_refs(&value.node, refs);
-            }
-            Expr::Ref(inner) | Expr::RefMut(inner) | Expr::Deref(inner) => {
-                self.collect_expr_refs(&inner.node, refs);
-            }
-            Expr::EnumVariant { args, .. } => {
-                for arg in args {
-                    self.collect_expr_refs(&arg.node, refs);
-                }
-            }
-            Expr::StateRef { expr, .. } => {
-                self.collect_expr_refs(&expr.node, refs);
+        }
+        Item::StructDef(s) => {
+            definitions.push(SymbolDef {
+                name: s.name.node.clone(),
+                kind: SymbolKind::Struct,
+                span: s.name.span,
+            });
+        }
+        Item::EnumDef(e) => {
+            definitions.push(SymbolDef {
+                name: e.name.node.clone(),
+                kind: SymbolKind::Enum,
+                span: e.name.span,
+            });
+        }
+        Item::Use(_) => {}
+        // v0.13.0: Extern functions as function definitions
+        Item::ExternFn(e) => {
+            definitions.push(SymbolDef {
+                name: e.name.node.clone(),
+                kind: SymbolKind::Function,
+                span: e.name.span,
+            });
+        }
+        // v0.20.1: Trait definitions
+        Item::TraitDef(t) => {
+            definitions.push(SymbolDef {
+                name: t.name.node.clone(),
+                kind: SymbolKind::Trait,
+                span: t.name.span,
+            });
+        }
+        // v0.20.1: Impl blocks - register methods
+        Item::ImplBlock(i) => {
+            for method in &i.methods {
+                definitions.push(SymbolDef {
+                    name: method.name.node.to_string(),
+                    kind: SymbolKind::Method,
+                    span: method.name.span,
+                });
+                collect_expr_refs(&method.body.node, references);
             }
-            // Literals and simple expressions
-            _ => {}
         }
+        // v0.50.6: Type aliases - register as type definitions
+        Item::TypeAlias(_) => {}
     }
+}
 
-    /// Get diagnostics from lexer, parser, and type checker
-    fn get_diagnostics(&self, uri: &Url, content: &str) -> Vec<Diagnostic> {
-        let mut diagnostics = Vec::new();
-        let filename = uri.path();
-
-        // Try to tokenize
-        let tokens = match lexer::tokenize(content) {
-            Ok(tokens) => tokens,
-            Err(e) => {
-                diagnostics.push(self.error_to_diagnostic(&e, content));
-                return diagnostics;
+/// Collect symbol references from expression
+fn collect_expr_refs(expr: &Expr, refs: &mut Vec<SymbolRef>) {
+    match expr {
+        Expr::Var(_name) => {
+            // This is a reference to a variable/function
+            // Note: We can't easily get the span here from Expr::Var
+            // For a more complete implementation, Expr::Var would need to be Spanned
+        }
+        Expr::Call { func: _, args, .. } => {
+            // Function call is a reference (name-only, no span in current AST)
+            for arg in args {
+                collect_expr_refs(&arg.node, refs);
             }
-        };
-
-        // Try to parse
-        let ast = match parser::parse(filename, content, tokens) {
-            Ok(ast) => ast,
-            Err(e) => {
-                diagnostics.push(self.error_to_diagnostic(&e, content));
-                return diagnostics;
+        }
+        Expr::Let { value, body, .. } => {
+            collect_expr_refs(&value.node, refs);
+            collect_expr_refs(&body.node, refs);
+        }
+        Expr::If { cond, then_branch, else_branch } => {
+            collect_expr_refs(&cond.node, refs);
+            collect_expr_refs(&then_branch.node, refs);
+            collect_expr_refs(&else_branch.node, refs);
+        }
+        Expr::Binary { left, right, .. } => {
+            collect_expr_refs(&left.node, refs);
+            collect_expr_refs(&right.node, refs);
+        }
+        Expr::Unary { expr, .. } => {
+            collect_expr_refs(&expr.node, refs);
+        }
+        Expr::Block(stmts) => {
+            for stmt in stmts {
+                collect_expr_refs(&stmt.node, refs);
             }
-        };
-
-        // Type check
-        let mut checker = TypeChecker::new();
-        if let Err(e) = checker.check_program(&ast) {
-            diagnostics.push(self.error_to_diagnostic(&e, content));
         }
-
-        diagnostics
-    }
-
-    /// Try to parse content, returning AST if successful
-    fn try_parse(&self, content: &str) -> Option<Program> {
-        let tokens = lexer::tokenize(content).ok()?;
-        parser::parse("<lsp>", content, tokens).ok()
-    }
-
-    /// Convert CompileError to LSP Diagnostic
-    fn error_to_diagnostic(&self, error: &CompileError, content: &str) -> Diagnostic {
-        let (range, severity) = if let Some(span) = error.span() {
-            (self.span_to_range(span, content), DiagnosticSeverity::ERROR)
-        } else {
-            (Range::default(), DiagnosticSeverity::ERROR)
-        };
-
-        let source = match error {
-            CompileError::Lexer { .. } => "bmb-lexer",
-            CompileError::Parser { .. } => "bmb-parser",
-            CompileError::Type { .. } => "bmb-types",
-            _ => "bmb",
-        };
-
-        Diagnostic {
-            range,
-            severity: Some(severity),
-            source: Some(source.to_string()),
-            message: error.message().to_string(),
-            ..Default::default()
+        // v0.37: Include invariant in refs collection
+        Expr::While { cond, invariant, body } => {
+            collect_expr_refs(&cond.node, refs);
+            if let Some(inv) = invariant {
+                collect_expr_refs(&inv.node, refs);
+            }
+            collect_expr_refs(&body.node, refs);
         }
-    }
-
-    /// Convert Span (byte offset) to LSP Range (line/character)
-    fn span_to_range(&self, span: Span, content: &str) -> Range {
-        let start = self.offset_to_position(span.start, content);
-        let end = self.offset_to_position(span.end, content);
-        Range { start, end }
-    }
-
-    /// Convert byte offset to LSP Position
-    fn offset_to_position(&self, offset: usize, content: &str) -> Position {
-        let mut line = 0u32;
-        let mut col = 0u32;
-
-        for (i, c) in content.char_indices() {
-            if i >= offset {
-                break;
+        Expr::For { iter, body, .. } => {
+            collect_expr_refs(&iter.node, refs);
+            collect_expr_refs(&body.node, refs);
+        }
+        Expr::Match { expr, arms } => {
+            collect_expr_refs(&expr.node, refs);
+            for arm in arms {
+                collect_expr_refs(&arm.body.node, refs);
             }
-            if c == '\n' {
-                line += 1;
-                col = 0;
-            } else {
-                col += 1;
+        }
+        Expr::MethodCall { receiver, args, .. } => {
+            collect_expr_refs(&receiver.node, refs);
+            for arg in args {
+                collect_expr_refs(&arg.node, refs);
             }
         }
-
-        Position::new(line, col)
-    }
-
-    /// Convert LSP Position to byte offset
-    fn position_to_offset(&self, position: Position, content: &str) -> usize {
-        let mut current_line = 0u32;
-        let mut current_col = 0u32;
-
-        for (i, c) in content.char_indices() {
-            if current_line == position.line && current_col == position.character {
-                return i;
+        Expr::FieldAccess { expr, .. } => {
+            collect_expr_refs(&expr.node, refs);
+        }
+        // v0.43: Tuple field access
+        Expr::TupleField { expr, .. } => {
+            collect_expr_refs(&expr.node, refs);
+        }
+        Expr::Index { expr, index } => {
+            collect_expr_refs(&expr.node, refs);
+            collect_expr_refs(&index.node, refs);
+        }
+        Expr::ArrayLit(elems) => {
+            for elem in elems {
+                collect_expr_refs(&elem.node, refs);
             }
-            if c == '\n' {
-                if current_line == position.line {
-                    return i;
-                }
-                current_line += 1;
-                current_col = 0;
-            } else {
-                current_col += 1;
+        }
+        // v0.42: Tuple expressions
+        Expr::Tuple(elems) => {
+            for elem in elems {
+                collect_expr_refs(&elem.node, refs);
             }
         }
-
-        content.len()
-    }
-
-    /// Get word at position for hover
-    fn get_word_at_position(&self, content: &str, position: Position) -> Option<String> {
-        let offset = self.position_to_offset(position, content);
-
-        // Find word boundaries
-        let bytes = content.as_bytes();
-        let mut start = offset;
-        let mut end = offset;
-
-        // Walk back to find start of word
-        while start > 0 && Self::is_ident_char(bytes[start - 1] as char) {
-            start -= 1;
+        Expr::StructInit { fields, .. } => {
+            for (_, value) in fields {
+                collect_expr_refs(&value.node, refs);
+            }
         }
-
-        // Walk forward to find end of word
-        while end < bytes.len() && Self::is_ident_char(bytes[end] as char) {
-            end += 1;
+        Expr::Range { start, end, .. } => {
+            collect_expr_refs(&start.node, refs);
+            collect_expr_refs(&end.node, refs);
         }
-
-        if start < end {
-            Some(content[start..end].to_string())
-        } else {
-            None
+        Expr::Assign { value, .. } => {
+            collect_expr_refs(&value.node, refs);
+        }
+        Expr::Ref(inner) | Expr::RefMut(inner) | Expr::Deref(inner) => {
+            collect_expr_refs(&inner.node, refs);
+        }
+        Expr::EnumVariant { args, .. } => {
+            for arg in args {
+                collect_expr_refs(&arg.node, refs);
+            }
+        }
+        Expr::StateRef { expr, .. } => {
+            collect_expr_refs(&expr.node, refs);
         }
+        // Literals and simple expressions
+        _ => {}
     }
+}
 
-    fn is_ident_char(c: char) -> bool {
-        c.is_alphanumeric() || c == '_'
+/// Convert CompileError to LSP Diagnostic
+fn error_to_diagnostic(error: &CompileError, lines: &LineIndex, content: &str) -> Diagnostic {
+    let range = match error.span() {
+        Some(span) => span_to_range(span, lines, content),
+        None => Range::default(),
+    };
+
+    let source = match error {
+        CompileError::Lexer { .. } => "bmb-lexer",
+        CompileError::Parser { .. } => "bmb-parser",
+        CompileError::Type { .. } => "bmb-types",
+        _ => "bmb",
+    };
+
+    Diagnostic {
+        range,
+        severity: Some(DiagnosticSeverity::ERROR),
+        source: Some(source.to_string()),
+        message: error.message().to_string(),
+        ..Default::default()
+    }
+}
+
+/// Convert Span (byte offset) to LSP Range (line/character)
+fn span_to_range(span: Span, lines: &LineIndex, content: &str) -> Range {
+    Range {
+        start: lines.position(span.start, content),
+        end: lines.position(span.end, content),
     }
 }
 
@@ -471,7 +427,7 @@ impl LanguageServer for Backend {
         Ok(InitializeResult {
             capabilities: ServerCapabilities {
                 text_document_sync: Some(TextDocumentSyncCapability::Kind(
-                    TextDocumentSyncKind::FULL,
+                    TextDocumentSyncKind::INCREMENTAL,
                 )),
                 hover_provider: Some(HoverProviderCapability::Simple(true)),
                 completion_provider: Some(CompletionOptions {
@@ -508,17 +464,46 @@ impl LanguageServer for Backend {
         let content = params.text_document.text;
         let version = params.text_document.version;
 
-        self.analyze_document(&uri, &content, version).await;
+        let generation = {
+            let mut docs = self.documents.write().unwrap();
+            // Reopening keeps the item cache of an earlier session
+            let (generation, cache) = match docs.remove(&uri) {
+                Some(doc) => (doc.generation + 1, doc.cache),
+                None => (0, Arc::default()),
+            };
+            docs.insert(uri.clone(), DocumentState {
+                lines: LineIndex::new(&content),
+                content,
+                ast: None,
+                definitions: Vec::new(),
+                references: Vec::new(),
+                version,
+                generation,
+                cache,
+            });
+            generation
+        };
+
+        self.schedule_analysis(uri, generation, Duration::ZERO);
     }
 
     async fn did_change(&self, params: DidChangeTextDocumentParams) {
         let uri = params.text_document.uri;
         let version = params.text_document.version;
 
-        // Full sync - take the whole content
-        if let Some(change) = params.content_changes.into_iter().next() {
-            self.analyze_document(&uri, &change.text, version).await;
-        }
+        // Incremental sync: apply the edits in order
+        let generation = {
+            let mut docs = self.documents.write().unwrap();
+            let Some(doc) = docs.get_mut(&uri) else { return };
+            for change in params.content_changes {
+                apply_change(&mut doc.content, &mut doc.lines, change);
+            }
+            doc.version = version;
+            doc.generation += 1;
+            doc.generation
+        };
+
+        self.schedule_analysis(uri, generation, ANALYSIS_DEBOUNCE);
     }
 
     async fn did_close(&self, params: DidCloseTextDocumentParams) {
@@ -536,7 +521,7 @@ impl LanguageServer for Backend {
             None => return Ok(None),
         };
 
-        let word = match self.get_word_at_position(&doc.content, position) {
+        let word = match self.get_word_at_position(doc, position) {
             Some(w) => w,
             None => return Ok(None),
         };
@@ -660,7 +645,7 @@ impl LanguageServer for Backend {
                             .map(|(i, p)| format!("${{{}:{}}}", i + 1, p.name.node))
                             .collect();
                         items.push(CompletionItem {
-                            label: f.name.node.clone(),
+                            label: f.name.node.to_string(),
                             kind: Some(CompletionItemKind::FUNCTION),
                             detail: Some(format!("fn -> {:?}", f.ret_ty.node)),
                             insert_text: Some(format!("{}({})", f.name.node, params.join(", "))),
@@ -742,7 +727,7 @@ impl LanguageServer for Backend {
         };
 
         // Get the word at cursor position
-        let word = match self.get_word_at_position(&doc.content, position) {
+        let word = match self.get_word_at_position(doc, position) {
             Some(w) => w,
             None => return Ok(None),
         };
@@ -750,7 +735,7 @@ impl LanguageServer for Backend {
         // Search for definition
         for def in &doc.definitions {
             if def.name == word {
-                let range = self.span_to_range(def.span, &doc.content);
+                let range = span_to_range(def.span, &doc.lines, &doc.content);
                 return Ok(Some(GotoDefinitionResponse::Scalar(Location {
                     uri: uri.clone(),
                     range,
@@ -773,7 +758,7 @@ impl LanguageServer for Backend {
         };
 
         // Get the word at cursor position
-        let word = match self.get_word_at_position(&doc.content, position) {
+        let word = match self.get_word_at_position(doc, position) {
             Some(w) => w,
             None => return Ok(None),
         };
@@ -786,7 +771,7 @@ impl LanguageServer for Backend {
                 if def.name == word {
                     locations.push(Location {
                         uri: uri.clone(),
-                        range: self.span_to_range(def.span, &doc.content),
+                        range: span_to_range(def.span, &doc.lines, &doc.content),
                     });
                 }
             }
@@ -797,7 +782,7 @@ impl LanguageServer for Backend {
             if reference.name == word {
                 locations.push(Location {
                     uri: uri.clone(),
-                    range: self.span_to_range(reference.span, &doc.content),
+                    range: span_to_range(reference.span, &doc.lines, &doc.content),
                 });
             }
         }
@@ -1004,7 +989,7 @@ fn format_expr(expr: &Expr) -> String {
         // v0.64: Character literal
         Expr::CharLit(c) => format!("'{}'", c.escape_default()),
         Expr::Unit => "()".to_string(),
-        Expr::Var(name) => name.clone(),
+        Expr::Var(name) => name.to_string(),
         Expr::Ret => "ret".to_string(),
         Expr::It => "it".to_string(),
 
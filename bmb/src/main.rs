@@ -7,6 +7,10 @@ use std::sync::atomic::{AtomicBool, Ordering};
 /// v0.71: Global flag for human-readable output (default: machine/AI-friendly)
 static HUMAN_OUTPUT: AtomicBool = AtomicBool::new(false);
 
+// Counts allocations per thread for `bmb run --alloc-stats`
+#[global_allocator]
+static ALLOC: bmb::interp::alloc::CountingAlloc = bmb::interp::alloc::CountingAlloc;
+
 /// Check if human output mode is enabled (default: false = machine mode)
 pub fn is_human_output() -> bool {
     HUMAN_OUTPUT.load(Ordering::Relaxed)
@@ -50,6 +54,9 @@ enum Command {
         /// WASM target environment (wasi, browser, standalone)
         #[arg(long, default_value = "wasi")]
         wasm_target: String,
+        /// Use WASM SIMD128 for runtime byte scans (needs a SIMD-capable engine)
+        #[arg(long)]
+        wasm_simd: bool,
         /// Build for all targets (native + WASM) - v0.12.4
         #[arg(long)]
         all_targets: bool,
@@ -57,6 +64,24 @@ enum Command {
         /// Examples: x86_64-unknown-linux-gnu, x86_64-pc-windows-msvc, aarch64-apple-darwin
         #[arg(long)]
         target: Option<String>,
+        /// Ignore and do not update the incremental build cache (.bmb/cache)
+        #[arg(long)]
+        no_cache: bool,
+        /// Link the runtime as LLVM bitcode so it is optimized with the program
+        #[arg(long)]
+        lto: bool,
+        /// Worker threads for optimization and code generation (0 = all cores)
+        #[arg(short = 'j', long, default_value_t = 0)]
+        jobs: usize,
+        /// Print wall time, allocations and IR size for every phase and MIR pass
+        #[arg(long)]
+        time_passes: bool,
+        /// Write a Chrome trace-event file of the build (chrome://tracing, Perfetto)
+        #[arg(long, value_name = "FILE")]
+        trace: Option<PathBuf>,
+        /// Count vec/box allocations too when the program runs with BMB_RUNTIME_STATS
+        #[arg(long)]
+        runtime_stats: bool,
         /// Verbose output
         #[arg(short, long)]
         verbose: bool,
@@ -71,6 +96,16 @@ enum Command {
         /// v0.71: Human-readable output (colors, formatting). Default: machine/JSON
         #[arg(long)]
         human: bool,
+        /// Interpreter variable storage
+        #[arg(long, value_enum, default_value = "env")]
+        frames: FrameMode,
+        /// Run on the bytecode VM (falls back to the interpreter for
+        /// programs the VM does not support)
+        #[arg(long)]
+        vm: bool,
+        /// Report heap allocations made while running (on stderr)
+        #[arg(long)]
+        alloc_stats: bool,
     },
     /// Start interactive REPL
     Repl,
@@ -92,6 +127,9 @@ enum Command {
         /// Timeout in seconds
         #[arg(long, short = 't', default_value = "10")]
         timeout: u32,
+        /// Functions verified in parallel, one Z3 session each (0 = all cores)
+        #[arg(short = 'j', long, default_value_t = 0)]
+        jobs: usize,
     },
     /// Parse and dump AST (debug)
     Parse {
@@ -116,6 +154,45 @@ enum Command {
         /// Verbose output (show all test results)
         #[arg(short, long)]
         verbose: bool,
+        /// Test files run in parallel, one interpreter each (0 = all cores)
+        #[arg(short = 'j', long, default_value_t = 0)]
+        jobs: usize,
+        /// Wall-time limit per test in seconds (0 = no limit)
+        #[arg(long, short = 't', default_value = "10")]
+        timeout: u32,
+        /// Report the N slowest tests
+        #[arg(long, value_name = "N", default_value_t = 0)]
+        slowest: usize,
+        /// Write per-test timings as JSON to this file
+        #[arg(long, value_name = "FILE")]
+        timings: Option<PathBuf>,
+    },
+    /// Build and time the native benchmarks under a directory (requires LLVM)
+    Bench {
+        /// Benchmark suite root
+        #[arg(default_value = "tests/bench")]
+        dir: PathBuf,
+        /// Only run benchmarks whose name contains this pattern
+        #[arg(long, short)]
+        filter: Option<String>,
+        /// Measured runs per benchmark and optimization level
+        #[arg(long, default_value_t = 5)]
+        runs: usize,
+        /// Unmeasured runs before measuring
+        #[arg(long, default_value_t = 1)]
+        warmup: usize,
+        /// Compare against the `benchmarks` section of this file and exit 1 on regression
+        #[arg(long, value_name = "FILE")]
+        baseline: Option<PathBuf>,
+        /// Store the results in the baseline file instead of comparing
+        #[arg(long, requires = "baseline")]
+        save_baseline: bool,
+        /// Skip instruction counting with `perf stat`
+        #[arg(long)]
+        no_perf: bool,
+        /// Verbose output
+        #[arg(short, long)]
+        verbose: bool,
     },
     /// Format a BMB source file
     Fmt {
@@ -171,6 +248,18 @@ enum Command {
     },
 }
 
+/// Variable storage used by the interpreter
+#[derive(Clone, Copy, Debug, Default, clap::ValueEnum)]
+enum FrameMode {
+    /// Environment chain (default)
+    #[default]
+    Env,
+    /// Stack of per-scope hash maps
+    Scope,
+    /// Resolved slot indices into flat per-call frames
+    Slots,
+}
+
 /// Output format for queries (v0.48 - RFC-0001)
 #[derive(Clone, Copy, Debug, Default, clap::ValueEnum)]
 enum OutputFormat {
@@ -316,6 +405,9 @@ enum QueryType {
         /// Host to bind to
         #[arg(long, default_value = "127.0.0.1")]
         host: String,
+        /// Re-index changed files and refresh the resident index
+        #[arg(long)]
+        watch: bool,
     },
     /// Query verification proof results (v0.50.24 - Task 47.7-47.8)
     Proof {
@@ -355,17 +447,38 @@ fn main() {
             emit_mir,
             emit_wasm,
             wasm_target,
+            wasm_simd,
             all_targets,
             target,
+            no_cache,
+            lto,
+            jobs,
+            time_passes,
+            trace,
+            runtime_stats,
             verbose,
-        } => build_file(&file, output, release, aggressive, emit_ir, emit_mir, emit_wasm, &wasm_target, all_targets, target.as_deref(), verbose),
-        Command::Run { file, args, human: _ } => run_file(&file, &args),
+        } => build_file(&file, output, release, aggressive, emit_ir, emit_mir, emit_wasm, &wasm_target, wasm_simd, all_targets, target.as_deref(), no_cache, lto, jobs, time_passes, trace.as_deref(), runtime_stats, verbose),
+        Command::Run { file, args, human: _, frames, vm, alloc_stats } => {
+            run_file(&file, &args, frames, vm, alloc_stats)
+        }
         Command::Repl => start_repl(),
         Command::Check { file, include_paths } => check_file_with_includes(&file, &include_paths),
-        Command::Verify { file, z3_path, timeout } => verify_file(&file, &z3_path, timeout),
+        Command::Verify { file, z3_path, timeout, jobs } => verify_file(&file, &z3_path, timeout, jobs),
         Command::Parse { file, format } => parse_file(&file, &format),
         Command::Tokens { file } => tokenize_file(&file),
-        Command::Test { file, filter, verbose } => test_file(&file, filter.as_deref(), verbose),
+        Command::Test { file, filter, verbose, jobs, timeout, slowest, timings } => {
+            let options = TestOptions { verbose, jobs, timeout, slowest, timings };
+            test_file(&file, filter.as_deref(), &options)
+        }
+        Command::Bench { dir, filter, runs, warmup, baseline, save_baseline, no_perf, verbose } => {
+            let options = bmb::bench::BenchOptions {
+                runs,
+                warmup,
+                instructions: !no_perf && bmb::bench::perf_available(),
+                verbose,
+            };
+            bench_dir(&dir, filter.as_deref(), &options, baseline.as_deref(), save_baseline)
+        }
         Command::Fmt { file, check } => fmt_file(&file, check),
         Command::Lint { file, strict, include_paths } => lint_file(&file, strict, &include_paths),
         Command::Lsp => start_lsp(),
@@ -396,8 +509,15 @@ fn build_file(
     emit_mir: bool,
     emit_wasm: bool,
     wasm_target: &str,
+    wasm_simd: bool,
     all_targets: bool,
     target: Option<&str>,
+    no_cache: bool,
+    lto: bool,
+    jobs: usize,
+    time_passes: bool,
+    trace: Option<&Path>,
+    runtime_stats: bool,
     verbose: bool,
 ) -> Result<(), Box<dyn std::error::Error>> {
     // v0.21.2: If emitting MIR, just output MIR and return
@@ -415,13 +535,13 @@ fn build_file(
         if verbose {
             println!("\n=== Native Build ===");
         }
-        build_native(path, output.clone(), release, aggressive, emit_ir, target, verbose)?;
+        build_native(path, output.clone(), release, aggressive, emit_ir, target, no_cache, lto, jobs, time_passes, trace, runtime_stats, verbose)?;
 
         // Then build WASM
         if verbose {
             println!("\n=== WASM Build ===");
         }
-        build_wasm(path, None, wasm_target, verbose)?;
+        build_wasm(path, None, wasm_target, wasm_simd, verbose)?;
 
         if verbose {
             println!("\n=== All targets built successfully! ===");
@@ -431,13 +551,14 @@ fn build_file(
 
     // If emitting WASM, use the WASM code generator
     if emit_wasm {
-        return build_wasm(path, output, wasm_target, verbose);
+        return build_wasm(path, output, wasm_target, wasm_simd, verbose);
     }
 
     // Default: build native
-    build_native(path, output, release, aggressive, emit_ir, target, verbose)
+    build_native(path, output, release, aggressive, emit_ir, target, no_cache, lto, jobs, time_passes, trace, runtime_stats, verbose)
 }
 
+#[allow(clippy::too_many_arguments)]
 fn build_native(
     path: &Path,
     output: Option<PathBuf>,
@@ -445,12 +566,24 @@ fn build_native(
     aggressive: bool,
     emit_ir: bool,
     target: Option<&str>,
+    no_cache: bool,
+    lto: bool,
+    jobs: usize,
+    time_passes: bool,
+    trace: Option<&Path>,
+    runtime_stats: bool,
     verbose: bool,
 ) -> Result<(), Box<dyn std::error::Error>> {
     use bmb::build::{BuildConfig, OptLevel};
 
     let mut config = BuildConfig::new(path.to_path_buf())
         .emit_ir(emit_ir)
+        .cache(!no_cache)
+        .lto(lto)
+        .jobs(jobs)
+        .time_passes(time_passes)
+        .trace(trace.map(Path::to_path_buf))
+        .runtime_stats(runtime_stats)
         .verbose(verbose);
 
     // v0.50.23: Cross-compilation target
@@ -491,6 +624,7 @@ fn build_wasm(
     path: &PathBuf,
     output: Option<PathBuf>,
     wasm_target: &str,
+    simd: bool,
     verbose: bool,
 ) -> Result<(), Box<dyn std::error::Error>> {
     use bmb::cfg::{CfgEvaluator, Target};
@@ -540,7 +674,7 @@ fn build_wasm(
     };
 
     // Generate WASM text
-    let codegen = WasmCodeGen::with_target(target);
+    let codegen = WasmCodeGen::with_target(target).with_simd(simd);
     let wat = codegen.generate(&mir)?;
 
     // Determine output path
@@ -623,7 +757,13 @@ fn emit_mir_file(
 /// v0.30.241: Stack size for interpreter thread (64MB for deep recursion in bootstrap)
 const INTERPRETER_STACK_SIZE: usize = 64 * 1024 * 1024;
 
-fn run_file(path: &Path, extra_args: &[String]) -> Result<(), Box<dyn std::error::Error>> {
+fn run_file(
+    path: &Path,
+    extra_args: &[String],
+    frames: FrameMode,
+    vm: bool,
+    alloc_stats: bool,
+) -> Result<(), Box<dyn std::error::Error>> {
     // v0.30.241: Run entire pipeline in a thread with larger stack to prevent overflow
     // Bootstrap files have deep recursion that exceeds default 1MB Windows stack
     // We run everything in the thread because Value uses Rc<RefCell<>> (not Send)
@@ -658,11 +798,37 @@ fn run_file(path: &Path, extra_args: &[String]) -> Result<(), Box<dyn std::error
             checker.check_program(&ast)
                 .map_err(|e| format!("Type error: {}", e))?;
 
+            // Allocations are counted per thread; this thread only runs the program
+            let report_allocs = |start: bmb::interp::alloc::AllocStats| {
+                if alloc_stats {
+                    let used = bmb::interp::alloc::AllocStats::current().since(start);
+                    eprintln!("allocations: {} ({} bytes)", used.count, used.bytes);
+                }
+            };
+            let start = bmb::interp::alloc::AllocStats::current();
+
+            if vm {
+                match bmb::vm::compile_ast(&ast, "main") {
+                    Ok(program) => {
+                        bmb::vm::run(&program).map_err(|e| format!("Runtime error: {}", e.message))?;
+                        report_allocs(start);
+                        return Ok(());
+                    }
+                    Err(e) => eprintln!("note: {}; using the interpreter", e),
+                }
+            }
+
             // Run with interpreter
             let mut interpreter = bmb::interp::Interpreter::new();
+            match frames {
+                FrameMode::Env => {}
+                FrameMode::Scope => interpreter.enable_scope_stack(),
+                FrameMode::Slots => interpreter.enable_slot_frames(),
+            }
             interpreter.load(&ast);
             interpreter.run(&ast)
                 .map_err(|e| format!("Runtime error: {}", e.message))?;
+            report_allocs(start);
 
             Ok(())
         })?;
@@ -726,8 +892,7 @@ fn check_file_with_includes(path: &PathBuf, include_paths: &[PathBuf]) -> Result
                 if module_path.exists() {
                     // Load using the original filename convention
                     let lib_source = std::fs::read_to_string(&module_path)?;
-                    let lib_tokens = bmb::lexer::tokenize(&lib_source)?;
-                    let lib_ast = bmb::parser::parse(&module_path.display().to_string(), &lib_source, lib_tokens)?;
+                    let lib_ast = bmb::parser::parse_source(&module_path.display().to_string(), &lib_source)?;
                     // Create a temporary module to register
                     let module = bmb::resolver::Module {
                         name: module_name.clone(),
@@ -830,12 +995,7 @@ fn lint_file(path: &PathBuf, strict: bool, include_paths: &[PathBuf]) -> Result<
                 let module_path = include_path.join(&pkg_dir_name).join("src").join("lib.bmb");
                 if module_path.exists()
                     && let Ok(lib_source) = std::fs::read_to_string(&module_path)
-                    && let Ok(lib_tokens) = bmb::lexer::tokenize(&lib_source)
-                    && let Ok(lib_ast) = bmb::parser::parse(
-                        &module_path.display().to_string(),
-                        &lib_source,
-                        lib_tokens,
-                    )
+                    && let Ok(lib_ast) = bmb::parser::parse_source(&module_path.display().to_string(), &lib_source)
                 {
                     let module = bmb::resolver::Module {
                         name: module_name.clone(),
@@ -1026,8 +1186,8 @@ fn lint_directory(dir: &PathBuf, strict: bool, _include_paths: &[PathBuf]) -> Re
     Ok(())
 }
 
-fn verify_file(path: &PathBuf, z3_path: &str, timeout: u32) -> Result<(), Box<dyn std::error::Error>> {
-    use bmb::index::{ProofEntry, ProofIndex, ProofStatus, write_proof_index};
+fn verify_file(path: &PathBuf, z3_path: &str, timeout: u32, jobs: usize) -> Result<(), Box<dyn std::error::Error>> {
+    use bmb::index::{ObligationEntry, ProofEntry, ProofIndex, ProofStatus, read_proof_index, write_proof_index};
     use bmb::smt::VerifyResult;
 
     let source = std::fs::read_to_string(path)?;
@@ -1046,7 +1206,8 @@ fn verify_file(path: &PathBuf, z3_path: &str, timeout: u32) -> Result<(), Box<dy
     // Set up verifier
     let verifier = bmb::verify::ContractVerifier::new()
         .with_z3_path(z3_path)
-        .with_timeout(timeout);
+        .with_timeout(timeout)
+        .with_jobs(jobs);
 
     // Check if solver is available
     let z3_available = verifier.is_solver_available();
@@ -1063,6 +1224,16 @@ fn verify_file(path: &PathBuf, z3_path: &str, timeout: u32) -> Result<(), Box<dy
     // Get Z3 version if available
     let z3_version = get_z3_version(z3_path);
 
+    // Reuse obligations proved or disproved by a previous run with the same Z3
+    let current_dir = std::env::current_dir()?;
+    if let Ok(previous) = read_proof_index(&current_dir)
+        && previous.z3_version == z3_version
+    {
+        verifier.solver().preload_cache(
+            previous.obligations.iter().map(|o| (o.key.clone(), o.to_solver())),
+        );
+    }
+
     // Verify contracts
     let start_time = std::time::Instant::now();
     let report = verifier.verify_program(&ast);
@@ -1116,8 +1287,14 @@ fn verify_file(path: &PathBuf, z3_path: &str, timeout: u32) -> Result<(), Box<dy
         });
     }
 
+    proof_index.obligations = verifier
+        .solver()
+        .cached_results()
+        .into_iter()
+        .filter_map(|(key, result)| ObligationEntry::from_solver(key, &result))
+        .collect();
+
     // Save proof index to .bmb/index/proofs.json
-    let current_dir = std::env::current_dir()?;
     if let Err(e) = write_proof_index(&proof_index, &current_dir) {
         if is_human_output() {
             eprintln!("Warning: Could not save proof index: {}", e);
@@ -1127,6 +1304,10 @@ fn verify_file(path: &PathBuf, z3_path: &str, timeout: u32) -> Result<(), Box<dy
     // Print report
     if is_human_output() {
         print!("{}", report);
+        let hits = verifier.solver().cache_hits();
+        if hits > 0 {
+            println!("({} obligation(s) reused from .bmb/index/proofs.json)", hits);
+        }
     } else {
         let verified = report.verified_count();
         let failed = report.failed_count();
@@ -1192,12 +1373,47 @@ fn tokenize_file(path: &PathBuf) -> Result<(), Box<dyn std::error::Error>> {
     Ok(())
 }
 
-fn test_file(path: &PathBuf, filter: Option<&str>, verbose: bool) -> Result<(), Box<dyn std::error::Error>> {
-    use std::time::Instant;
+/// `bmb test` options beyond the path and filter
+struct TestOptions {
+    verbose: bool,
+    jobs: usize,
+    /// Per-test limit in seconds, 0 for none
+    timeout: u32,
+    slowest: usize,
+    timings: Option<PathBuf>,
+}
+
+/// Outcome of a single test function
+enum TestStatus {
+    Passed,
+    Failed(String),
+    TimedOut,
+}
+
+struct TestRun {
+    name: String,
+    status: TestStatus,
+    elapsed: std::time::Duration,
+}
+
+/// All tests of one file, run on one worker
+struct TestFileRun {
+    filename: String,
+    tests: Vec<TestRun>,
+    elapsed: std::time::Duration,
+}
+
+fn test_file(path: &PathBuf, filter: Option<&str>, options: &TestOptions) -> Result<(), Box<dyn std::error::Error>> {
+    use std::collections::BTreeMap;
+    use std::sync::atomic::AtomicUsize;
+    use std::sync::mpsc;
+    use std::time::{Duration, Instant};
 
     // Collect test files
     let test_files = if path.is_dir() {
-        collect_test_files(path)?
+        let mut files = collect_test_files(path)?;
+        files.sort();
+        files
     } else {
         vec![path.clone()]
     };
@@ -1211,106 +1427,142 @@ fn test_file(path: &PathBuf, filter: Option<&str>, verbose: bool) -> Result<(),
         return Ok(());
     }
 
+    let jobs = match options.jobs {
+        0 => std::thread::available_parallelism().map_or(1, |n| n.get()),
+        n => n,
+    }
+    .min(test_files.len());
+    let timeout = (options.timeout > 0).then(|| Duration::from_secs(options.timeout.into()));
+
     let mut total_passed = 0;
     let mut total_failed = 0;
+    let mut total_timed_out = 0;
     let mut total_tests = 0;
+    let mut runs: Vec<TestFileRun> = Vec::new();
     let start_time = Instant::now();
 
-    for test_file in &test_files {
-        let source = std::fs::read_to_string(test_file)?;
-        let filename = test_file.display().to_string();
-
-        // Tokenize
-        let tokens = bmb::lexer::tokenize(&source)?;
+    // Workers pull files off a shared counter; results are reported in file
+    // order as soon as every earlier file is done, so output stays stable
+    let next_file = AtomicUsize::new(0);
+    let (tx, rx) = mpsc::channel::<(usize, Result<TestFileRun, String>)>();
+
+    let outcome = std::thread::scope(|scope| -> Result<(), Box<dyn std::error::Error>> {
+        for worker in 0..jobs {
+            let tx = tx.clone();
+            let next_file = &next_file;
+            let test_files = &test_files;
+            std::thread::Builder::new()
+                .name(format!("bmb-test-{}", worker))
+                .stack_size(INTERPRETER_STACK_SIZE)
+                .spawn_scoped(scope, move || loop {
+                    let idx = next_file.fetch_add(1, Ordering::Relaxed);
+                    let Some(file) = test_files.get(idx) else { break };
+                    if tx.send((idx, run_test_file(file, filter, timeout))).is_err() {
+                        break;
+                    }
+                })?;
+        }
+        drop(tx);
+
+        let mut pending = BTreeMap::new();
+        let mut next_report = 0;
+        for (idx, result) in rx {
+            pending.insert(idx, result);
+            while let Some(result) = pending.remove(&next_report) {
+                next_report += 1;
+                let run = result?;
+                if run.tests.is_empty() {
+                    continue;
+                }
 
-        // Parse
-        let ast = bmb::parser::parse(&filename, &source, tokens)?;
+                if is_human_output() && (options.verbose || test_files.len() > 1) {
+                    println!("\n📂 {}", run.filename);
+                }
 
-        // Type check
-        let mut checker = bmb::types::TypeChecker::new();
-        checker.check_program(&ast)?;
+                for test in &run.tests {
+                    total_tests += 1;
+                    match &test.status {
+                        TestStatus::Passed => {
+                            total_passed += 1;
+                            if is_human_output() && options.verbose {
+                                println!("  ✅ {} ({:.2?})", test.name, test.elapsed);
+                            }
+                        }
+                        TestStatus::Failed(reason) => {
+                            total_failed += 1;
+                            if is_human_output() {
+                                println!("  ❌ {} - {} ({:.2?})", test.name, reason, test.elapsed);
+                            } else {
+                                println!(r#"{{"type":"test_fail","name":"{}","file":"{}","reason":"{}","ms":{}}}"#,
+                                    test.name, run.filename, reason.replace('"', "\\\""), test.elapsed.as_millis());
+                            }
+                        }
+                        TestStatus::TimedOut => {
+                            total_failed += 1;
+                            total_timed_out += 1;
+                            if is_human_output() {
+                                println!("  ⏱️ {} - timed out after {:.2?}", test.name, test.elapsed);
+                            } else {
+                                println!(r#"{{"type":"test_fail","name":"{}","file":"{}","reason":"timed out","ms":{}}}"#,
+                                    test.name, run.filename, test.elapsed.as_millis());
+                            }
+                        }
+                    }
+                }
+                runs.push(run);
+            }
+        }
+        Ok(())
+    });
+    outcome?;
 
-        // Run tests with interpreter
-        let mut interpreter = bmb::interp::Interpreter::new();
-        interpreter.load(&ast);
+    let elapsed = start_time.elapsed();
 
-        let test_names = interpreter.get_test_functions();
-        let filtered_tests: Vec<_> = test_names
+    if options.slowest > 0 {
+        let mut all: Vec<(&str, &TestRun)> = runs
             .iter()
-            .filter(|name| {
-                filter.is_none_or(|f| name.contains(f))
-            })
+            .flat_map(|run| run.tests.iter().map(move |t| (run.filename.as_str(), t)))
             .collect();
-
-        if filtered_tests.is_empty() {
-            continue;
+        all.sort_by(|a, b| b.1.elapsed.cmp(&a.1.elapsed));
+        if is_human_output() && !all.is_empty() {
+            println!("\n🐢 Slowest tests:");
         }
-
-        if is_human_output() && (verbose || test_files.len() > 1) {
-            println!("\n📂 {}", filename);
-        }
-
-        for test_name in filtered_tests {
-            total_tests += 1;
-            let test_start = Instant::now();
-
-            match interpreter.run_function(test_name) {
-                Ok(value) => {
-                    let passed = match value {
-                        bmb::interp::Value::Bool(b) => b,
-                        bmb::interp::Value::Int(n) => n != 0,
-                        _ => true,
-                    };
-
-                    let elapsed_ms = test_start.elapsed().as_millis();
-
-                    if passed {
-                        total_passed += 1;
-                        if is_human_output() && verbose {
-                            println!("  ✅ {} ({:.2?})", test_name, test_start.elapsed());
-                        }
-                    } else {
-                        total_failed += 1;
-                        if is_human_output() {
-                            println!("  ❌ {} - returned false ({:.2?})", test_name, test_start.elapsed());
-                        } else {
-                            println!(r#"{{"type":"test_fail","name":"{}","file":"{}","reason":"returned false","ms":{}}}"#,
-                                test_name, filename, elapsed_ms);
-                        }
-                    }
-                }
-                Err(e) => {
-                    total_failed += 1;
-                    if is_human_output() {
-                        println!("  ❌ {} - {}", test_name, e.message);
-                    } else {
-                        println!(r#"{{"type":"test_fail","name":"{}","file":"{}","reason":"{}"}}"#,
-                            test_name, filename, e.message.replace('"', "\\\""));
-                    }
-                }
+        for (file, test) in all.into_iter().take(options.slowest) {
+            if is_human_output() {
+                println!("  {:>10.2?}  {} ({})", test.elapsed, test.name, file);
+            } else {
+                println!(r#"{{"type":"test_slow","name":"{}","file":"{}","ms":{:.3}}}"#,
+                    test.name, file, test.elapsed.as_secs_f64() * 1000.0);
             }
         }
     }
 
-    let elapsed = start_time.elapsed();
+    if let Some(timings_path) = &options.timings {
+        write_test_timings(timings_path, &runs, jobs, options.timeout, elapsed)?;
+    }
 
     // Print summary
     if is_human_output() {
         println!();
+        let timed_out = if total_timed_out > 0 {
+            format!(", {} timed out", total_timed_out)
+        } else {
+            String::new()
+        };
         if total_tests == 0 {
             println!("No tests found");
         } else if total_failed == 0 {
-            println!("✅ {} tests passed ({:.2?})", total_passed, elapsed);
+            println!("✅ {} tests passed ({:.2?}, {} jobs)", total_passed, elapsed, jobs);
         } else {
             println!(
-                "❌ {} passed, {} failed of {} tests ({:.2?})",
-                total_passed, total_failed, total_tests, elapsed
+                "❌ {} passed, {} failed{} of {} tests ({:.2?}, {} jobs)",
+                total_passed, total_failed, timed_out, total_tests, elapsed, jobs
             );
             std::process::exit(1);
         }
     } else {
-        println!(r#"{{"type":"test_result","tests":{},"passed":{},"failed":{},"ms":{}}}"#,
-            total_tests, total_passed, total_failed, elapsed.as_millis());
+        println!(r#"{{"type":"test_result","tests":{},"passed":{},"failed":{},"timed_out":{},"ms":{}}}"#,
+            total_tests, total_passed, total_failed, total_timed_out, elapsed.as_millis());
         if total_failed > 0 {
             std::process::exit(1);
         }
@@ -1319,6 +1571,213 @@ fn test_file(path: &PathBuf, filter: Option<&str>, verbose: bool) -> Result<(),
     Ok(())
 }
 
+/// Compile one test file and run its tests in a fresh interpreter.
+/// Runs on a worker thread, hence the `String` error.
+fn run_test_file(
+    path: &Path,
+    filter: Option<&str>,
+    timeout: Option<std::time::Duration>,
+) -> Result<TestFileRun, String> {
+    use std::time::Instant;
+
+    let file_start = Instant::now();
+    let source = std::fs::read_to_string(path).map_err(|e| e.to_string())?;
+    let filename = path.display().to_string();
+
+    // Tokenize
+    let tokens = bmb::lexer::tokenize(&source).map_err(|e| e.to_string())?;
+
+    // Parse
+    let ast = bmb::parser::parse(&filename, &source, tokens).map_err(|e| e.to_string())?;
+
+    // Type check
+    let mut checker = bmb::types::TypeChecker::new();
+    checker.check_program(&ast).map_err(|e| e.to_string())?;
+
+    // Run tests with interpreter
+    let mut interpreter = bmb::interp::Interpreter::new();
+    interpreter.load(&ast);
+
+    let mut test_names: Vec<String> = interpreter
+        .get_test_functions()
+        .into_iter()
+        .filter(|name| filter.is_none_or(|f| name.contains(f)))
+        .collect();
+    test_names.sort();
+
+    let mut tests = Vec::with_capacity(test_names.len());
+    for name in test_names {
+        let test_start = Instant::now();
+        interpreter.set_deadline(timeout.map(|t| test_start + t));
+        let result = interpreter.run_function(&name);
+        let elapsed = test_start.elapsed();
+
+        let status = match result {
+            Ok(bmb::interp::Value::Bool(false)) | Ok(bmb::interp::Value::Int(0)) => {
+                TestStatus::Failed("returned false".to_string())
+            }
+            Ok(_) => TestStatus::Passed,
+            Err(e) if e.kind == bmb::interp::ErrorKind::Timeout => TestStatus::TimedOut,
+            Err(e) => TestStatus::Failed(e.message),
+        };
+        tests.push(TestRun { name, status, elapsed });
+    }
+
+    Ok(TestFileRun { filename, tests, elapsed: file_start.elapsed() })
+}
+
+/// Write `bmb test --timings` output, laid out like
+/// `.github/workflows/performance-baseline.json` so runs can be diffed
+fn write_test_timings(
+    path: &Path,
+    runs: &[TestFileRun],
+    jobs: usize,
+    timeout_secs: u32,
+    elapsed: std::time::Duration,
+) -> Result<(), Box<dyn std::error::Error>> {
+    let ms = |d: std::time::Duration| (d.as_secs_f64() * 1_000_000.0).round() / 1000.0;
+
+    let mut per_file = serde_json::Map::new();
+    let mut tests_total = 0;
+    let mut failed = 0;
+    for run in runs {
+        let mut tests = serde_json::Map::new();
+        for test in &run.tests {
+            let status = match test.status {
+                TestStatus::Passed => "pass",
+                TestStatus::Failed(_) => "fail",
+                TestStatus::TimedOut => "timeout",
+            };
+            tests_total += 1;
+            failed += usize::from(!matches!(test.status, TestStatus::Passed));
+            tests.insert(test.name.clone(), serde_json::json!({ "status": status, "ms": ms(test.elapsed) }));
+        }
+        per_file.insert(run.filename.clone(), serde_json::json!({ "ms": ms(run.elapsed), "tests": tests }));
+    }
+
+    let report = serde_json::json!({
+        "version": env!("CARGO_PKG_VERSION"),
+        "measured_at": chrono::Local::now().format("%Y-%m-%d").to_string(),
+        "jobs": jobs,
+        "timeout_seconds": timeout_secs,
+        "totals": {
+            "files": runs.len(),
+            "tests": tests_total,
+            "failed": failed,
+            "wall_ms": ms(elapsed),
+        },
+        "per_file": per_file,
+    });
+    std::fs::write(path, serde_json::to_string_pretty(&report)? + "\n")?;
+    Ok(())
+}
+
+/// Run the benchmark suite under `dir` (`bmb bench`)
+fn bench_dir(
+    dir: &Path,
+    filter: Option<&str>,
+    options: &bmb::bench::BenchOptions,
+    baseline_path: Option<&Path>,
+    save_baseline: bool,
+) -> Result<(), Box<dyn std::error::Error>> {
+    use bmb::bench;
+
+    let specs: Vec<_> = bench::discover(dir)?
+        .into_iter()
+        .filter(|s| filter.is_none_or(|f| s.name.contains(f)))
+        .collect();
+    if specs.is_empty() {
+        return Err(format!("no benchmarks found under {}", dir.display()).into());
+    }
+    let baseline = match baseline_path {
+        Some(path) if !save_baseline => Some(bench::load_baseline(path)?),
+        _ => None,
+    };
+
+    let work_dir = std::env::temp_dir().join(format!("bmb-bench-{}", std::process::id()));
+    if is_human_output() {
+        println!(
+            "{:<28} {:>3} {:>11} {:>11} {:>10} {:>15} {:>9}",
+            "benchmark", "opt", "median", "p95", "max RSS", "instructions", "vs base"
+        );
+    }
+    let mut results = Vec::new();
+    for spec in &specs {
+        let measured = bench::run_benchmark(spec, options, &work_dir).inspect_err(|_| {
+            let _ = std::fs::remove_dir_all(&work_dir);
+        })?;
+        for r in measured {
+            let m = &r.measurement;
+            let change = baseline.as_ref().and_then(|b| bench::median_change(&r, &b.benchmarks));
+            if is_human_output() {
+                println!(
+                    "{:<28} {:>3} {:>9.2}ms {:>9.2}ms {:>10} {:>15} {:>9}",
+                    r.name,
+                    r.opt,
+                    m.median_ms,
+                    m.p95_ms,
+                    m.max_rss_kib.map_or("-".to_string(), |kib| format!("{:.1} MiB", kib as f64 / 1024.0)),
+                    m.instructions.map_or("-".to_string(), |n| n.to_string()),
+                    change.map_or("-".to_string(), |pct| format!("{:+.1}%", pct)),
+                );
+            } else {
+                let mut line = serde_json::to_value(m)?;
+                line["type"] = "bench".into();
+                line["name"] = r.name.clone().into();
+                line["opt"] = r.opt.into();
+                if let Some(pct) = change {
+                    line["median_change_percent"] = pct.into();
+                }
+                println!("{}", line);
+            }
+            results.push(r);
+        }
+    }
+    let _ = std::fs::remove_dir_all(&work_dir);
+
+    if save_baseline {
+        if let Some(path) = baseline_path {
+            bench::save_baseline(path, &results)?;
+            if is_human_output() {
+                println!("\nSaved {} results to {}", results.len(), path.display());
+            }
+        }
+        return Ok(());
+    }
+    let Some(baseline) = baseline else { return Ok(()) };
+
+    let regressions = bench::compare(&results, &baseline);
+    let missing = results.iter().filter(|r| bench::median_change(r, &baseline.benchmarks).is_none()).count();
+    if is_human_output() {
+        println!();
+        for reg in &regressions {
+            println!(
+                "  ❌ {} -{}: {} {:.2} -> {:.2} ({:+.1}%, limit {}%)",
+                reg.name, reg.opt, reg.metric, reg.baseline, reg.current, reg.percent(), reg.limit_percent
+            );
+        }
+        if missing > 0 {
+            println!("  {} results have no baseline yet (--save-baseline to record them)", missing);
+        }
+        if regressions.is_empty() {
+            println!("✅ No regressions against {}", baseline_path.map_or(String::new(), |p| p.display().to_string()));
+        } else {
+            println!("❌ {} regressions", regressions.len());
+        }
+    } else {
+        for reg in &regressions {
+            println!(r#"{{"type":"bench_regression","name":"{}","opt":"{}","metric":"{}","baseline":{},"current":{},"percent":{:.2}}}"#,
+                reg.name, reg.opt, reg.metric, reg.baseline, reg.current, reg.percent());
+        }
+        println!(r#"{{"type":"bench_result","results":{},"regressions":{},"missing_baseline":{}}}"#,
+            results.len(), regressions.len(), missing);
+    }
+    if !regressions.is_empty() {
+        std::process::exit(1);
+    }
+    Ok(())
+}
+
 fn collect_test_files(dir: &PathBuf) -> Result<Vec<PathBuf>, Box<dyn std::error::Error>> {
     let mut files = Vec::new();
 
@@ -1710,7 +2169,7 @@ fn format_expr(expr: &bmb::ast::Expr) -> String {
         // v0.64: Character literal
         Expr::CharLit(c) => format!("'{}'", c.escape_default()),
         Expr::Unit => "()".to_string(),
-        Expr::Var(name) => name.clone(),
+        Expr::Var(name) => name.to_string(),
         Expr::Ret => "ret".to_string(),
         Expr::It => "it".to_string(),
 
@@ -2135,7 +2594,44 @@ fn do_index_project(path: &PathBuf, verbose: bool) -> Result<(), Box<dyn std::er
 }
 
 /// v0.50.21: Watch for file changes and re-index automatically
+///
+/// Only the changed files are re-parsed; the rest of the index is kept in
+/// memory between events. Falls back to a full re-index when there is no
+/// index to update yet.
 fn run_index_watcher(path: &PathBuf, verbose: bool) -> Result<(), Box<dyn std::error::Error>> {
+    use bmb::index::{read_index, write_index};
+
+    let mut index = read_index(path).ok();
+
+    watch_bmb_changes(path, |changed| {
+        if verbose {
+            println!("\n📝 Detected .bmb file change, re-indexing...");
+        } else {
+            println!("\n🔄 Re-indexing...");
+        }
+
+        let result = match index.as_mut() {
+            Some(index) => {
+                update_index_files(path, index, changed, verbose);
+                write_index(index, path).map_err(Into::into).map(|()| {
+                    println!("✓ Index updated: {} file(s)", changed.len());
+                })
+            }
+            None => do_index_project(path, verbose).map(|()| index = read_index(path).ok()),
+        };
+        if let Err(e) = result {
+            eprintln!("  Error during re-index: {}", e);
+        }
+    })
+}
+
+/// Watch `path` recursively and call `on_change` with each debounced batch
+/// of changed .bmb files. Shared by `bmb index --watch` and
+/// `bmb q serve --watch`.
+fn watch_bmb_changes(
+    path: &Path,
+    mut on_change: impl FnMut(&[PathBuf]),
+) -> Result<(), Box<dyn std::error::Error>> {
     use notify_debouncer_mini::{new_debouncer, notify::RecursiveMode};
     use std::sync::mpsc::channel;
     use std::time::Duration;
@@ -2149,37 +2645,27 @@ fn run_index_watcher(path: &PathBuf, verbose: bool) -> Result<(), Box<dyn std::e
     let mut debouncer = new_debouncer(Duration::from_millis(500), tx)?;
 
     // Watch the directory recursively
-    debouncer.watcher().watch(path.as_path(), RecursiveMode::Recursive)?;
+    debouncer.watcher().watch(path, RecursiveMode::Recursive)?;
 
     // Process events
     loop {
         match rx.recv() {
-            Ok(result) => {
-                match result {
-                    Ok(events) => {
-                        // Check if any .bmb file changed
-                        let bmb_changed = events.iter().any(|e| {
-                            e.path.extension().is_some_and(|ext| ext == "bmb")
-                        });
-
-                        if bmb_changed {
-                            if verbose {
-                                println!("\n📝 Detected .bmb file change, re-indexing...");
-                            } else {
-                                println!("\n🔄 Re-indexing...");
-                            }
+            Ok(Ok(events)) => {
+                let mut changed: Vec<PathBuf> = events
+                    .iter()
+                    .filter(|e| e.path.extension().is_some_and(|ext| ext == "bmb"))
+                    .map(|e| e.path.clone())
+                    .collect();
+                changed.sort();
+                changed.dedup();
 
-                            // Re-index the project
-                            if let Err(e) = do_index_project(path, verbose) {
-                                eprintln!("  Error during re-index: {}", e);
-                            }
-                        }
-                    }
-                    Err(e) => {
-                        eprintln!("Watch error: {}", e);
-                    }
+                if !changed.is_empty() {
+                    on_change(&changed);
                 }
             }
+            Ok(Err(e)) => {
+                eprintln!("Watch error: {}", e);
+            }
             Err(e) => {
                 eprintln!("Channel error: {}", e);
                 break;
@@ -2190,6 +2676,79 @@ fn run_index_watcher(path: &PathBuf, verbose: bool) -> Result<(), Box<dyn std::e
     Ok(())
 }
 
+/// Re-index just the `changed` files of the project at `root` into `index`.
+///
+/// Files are matched to their existing index entries by canonical path, so
+/// the index keeps whatever file naming it was generated with. Deleted files
+/// are dropped; files that no longer parse keep their previous entries.
+fn update_index_files(
+    root: &Path,
+    index: &mut bmb::index::ProjectIndex,
+    changed: &[PathBuf],
+    verbose: bool,
+) {
+    use bmb::index::IndexGenerator;
+    use std::collections::{HashMap, HashSet};
+
+    // Canonicalize the directory only, so deleted files still resolve
+    let normalize = |p: &Path| -> PathBuf {
+        let abs = std::env::current_dir().map(|cwd| cwd.join(p)).unwrap_or_else(|_| p.to_path_buf());
+        match (abs.parent().and_then(|d| d.canonicalize().ok()), abs.file_name()) {
+            (Some(dir), Some(name)) => dir.join(name),
+            _ => abs,
+        }
+    };
+
+    let mut seen = HashSet::new();
+    let mut known: HashMap<PathBuf, String> = HashMap::new();
+    let files = index.symbols.iter().map(|s| &s.file)
+        .chain(index.functions.iter().map(|f| &f.file))
+        .chain(index.types.iter().map(|t| &t.file));
+    for file in files {
+        if seen.insert(file.as_str()) {
+            known.insert(normalize(Path::new(file)), file.clone());
+        }
+    }
+    let root_abs = root.canonicalize().unwrap_or_else(|_| root.to_path_buf());
+
+    for path in changed {
+        let abs = normalize(path);
+        let filename = known.get(&abs).cloned().unwrap_or_else(|| match abs.strip_prefix(&root_abs) {
+            Ok(rel) => root.join(rel).display().to_string(),
+            Err(_) => path.display().to_string(),
+        });
+
+        let Ok(source) = std::fs::read_to_string(&abs) else {
+            if verbose {
+                println!("  Removed: {}", filename);
+            }
+            index.replace_file(&filename, None);
+            continue;
+        };
+
+        let parsed = bmb::lexer::tokenize(&source)
+            .map_err(|e| format!("lex error: {}", e))
+            .and_then(|tokens| {
+                bmb::parser::parse(&filename, &source, tokens).map_err(|e| format!("parse error: {}", e))
+            });
+        match parsed {
+            Ok(ast) => {
+                let mut generator = IndexGenerator::new(&index.manifest.project);
+                generator.index_file(&filename, &ast);
+                index.replace_file(&filename, Some(generator.generate()));
+                if verbose {
+                    println!("  Indexed: {}", filename);
+                }
+            }
+            Err(e) => {
+                if verbose {
+                    eprintln!("  Kept previous entries for {} ({})", filename, e);
+                }
+            }
+        }
+    }
+}
+
 /// v0.25: Run query against project index
 fn run_query(query_type: QueryType) -> Result<(), Box<dyn std::error::Error>> {
     use bmb::index::{read_index, SymbolKind};
@@ -2290,8 +2849,8 @@ fn run_query(query_type: QueryType) -> Result<(), Box<dyn std::error::Error>> {
             println!("{}", format_output(&result, fmt_str(format))?);
         }
 
-        QueryType::Serve { port, host } => {
-            return run_query_server(&host, port, engine);
+        QueryType::Serve { port, host, watch } => {
+            return run_query_server(&host, port, engine, watch.then_some(current_dir.as_path()));
         }
 
         QueryType::Proof { name, unverified, failed, timeout, format } => {
@@ -2336,23 +2895,49 @@ fn run_query(query_type: QueryType) -> Result<(), Box<dyn std::error::Error>> {
 }
 
 /// v0.50.22: HTTP query server for AI tools (RFC-0001 Task 50.7)
+///
+/// The index stays resident in a prebuilt `QueryEngine`. With `watch_root`
+/// set, a background thread re-indexes changed files and swaps in a fresh
+/// engine, so queries never wait on a re-index.
 fn run_query_server(
     host: &str,
     port: u16,
     engine: bmb::query::QueryEngine,
+    watch_root: Option<&Path>,
 ) -> Result<(), Box<dyn std::error::Error>> {
-    use std::io::Read;
     use std::net::TcpListener;
-    use bmb::query::format_output;
+    use std::sync::{Arc, RwLock};
+    use bmb::query::{QueryEngine, format_output};
 
     let addr = format!("{}:{}", host, port);
     let listener = TcpListener::bind(&addr)?;
+    let engine = Arc::new(RwLock::new(engine));
+
+    if let Some(root) = watch_root {
+        let root = root.to_path_buf();
+        let shared = Arc::clone(&engine);
+        let mut index = engine.read().expect("query engine lock poisoned").index().clone();
+        std::thread::spawn(move || {
+            let result = watch_bmb_changes(&root, |changed| {
+                update_index_files(Path::new("."), &mut index, changed, false);
+                let fresh = QueryEngine::new(index.clone());
+                *shared.write().expect("query engine lock poisoned") = fresh;
+                if let Err(e) = bmb::index::write_index(&index, &root) {
+                    eprintln!("  Error writing index: {}", e);
+                }
+                println!("🔄 Index refreshed: {} file(s) changed", changed.len());
+            });
+            if let Err(e) = result {
+                eprintln!("Watch error: {}", e);
+            }
+        });
+    }
 
     println!("BMB Query Server v0.50.22");
     println!("Listening on http://{}", addr);
     println!("Endpoints:");
     println!("  GET  /health      - Health check");
-    println!("  POST /query       - Run query (JSON body)");
+    println!("  POST /query       - Run query (JSON body, or {{\"type\":\"batch\",\"queries\":[...]}})");
     println!("  GET  /metrics     - Project metrics");
     println!("Press Ctrl+C to stop");
 
@@ -2360,9 +2945,7 @@ fn run_query_server(
         match stream {
             Ok(mut stream) => {
                 // Read request
-                let mut buffer = [0; 8192];
-                let n = stream.read(&mut buffer)?;
-                let request = String::from_utf8_lossy(&buffer[..n]);
+                let request = read_http_request(&mut stream)?;
 
                 // Parse request line
                 let first_line = request.lines().next().unwrap_or("");
@@ -2375,6 +2958,7 @@ fn run_query_server(
 
                 let method = parts[0];
                 let path = parts[1];
+                let engine = engine.read().expect("query engine lock poisoned");
 
                 // Route request
                 let (status, body) = match (method, path) {
@@ -2405,6 +2989,7 @@ fn run_query_server(
                         (404, r#"{"error":"Not found"}"#.to_string())
                     }
                 };
+                drop(engine);
 
                 send_json_response(&mut stream, status, &body)?;
             }
@@ -2417,90 +3002,141 @@ fn run_query_server(
     Ok(())
 }
 
+/// Read one HTTP request, honouring `Content-Length` so large (batch)
+/// bodies are not cut off at the first socket read
+fn read_http_request(stream: &mut std::net::TcpStream) -> std::io::Result<String> {
+    use std::io::Read;
+
+    const MAX_REQUEST: usize = 16 * 1024 * 1024;
+
+    let mut data = Vec::new();
+    let mut buffer = [0; 8192];
+    let mut expected: Option<usize> = None;
+
+    loop {
+        let n = stream.read(&mut buffer)?;
+        if n == 0 {
+            break;
+        }
+        data.extend_from_slice(&buffer[..n]);
+
+        if expected.is_none()
+            && let Some(header_end) = data.windows(4).position(|w| w == b"\r\n\r\n")
+        {
+            let headers = String::from_utf8_lossy(&data[..header_end]);
+            let content_length = headers
+                .lines()
+                .filter_map(|line| line.split_once(':'))
+                .find(|(name, _)| name.trim().eq_ignore_ascii_case("content-length"))
+                .and_then(|(_, value)| value.trim().parse::<usize>().ok())
+                .unwrap_or(0);
+            expected = Some(header_end + 4 + content_length);
+        }
+
+        match expected {
+            Some(total) if data.len() >= total => break,
+            // No header terminator in a short read: take what was sent,
+            // as the single-read server did
+            None if n < buffer.len() => break,
+            _ if data.len() >= MAX_REQUEST => break,
+            _ => {}
+        }
+    }
+
+    Ok(String::from_utf8_lossy(&data).into_owned())
+}
+
 /// Handle POST /query request
 fn handle_query_request(engine: &bmb::query::QueryEngine, json_body: &str) -> (u16, String) {
-    use bmb::query::format_output;
-
     // Parse query JSON
     let query: serde_json::Value = match serde_json::from_str(json_body) {
         Ok(v) => v,
         Err(e) => return (400, format!(r#"{{"error":"Invalid JSON: {}"}}"#, e)),
     };
 
-    let query_type = query.get("type").and_then(|v| v.as_str()).unwrap_or("");
+    let (status, result) = if query.get("type").and_then(|v| v.as_str()) == Some("batch") {
+        run_query_batch(engine, &query)
+    } else {
+        run_server_query(engine, &query)
+    };
+    match serde_json::to_string_pretty(&result) {
+        Ok(json) => (status, json),
+        Err(e) => (500, format!(r#"{{"error":"{}"}}"#, e)),
+    }
+}
+
+/// Answer `{"type":"batch","queries":[...]}` in one round trip, with one
+/// result entry per query in request order
+fn run_query_batch(engine: &bmb::query::QueryEngine, query: &serde_json::Value) -> (u16, serde_json::Value) {
+    use bmb::query::BatchResultEntry;
+
+    let Some(queries) = query.get("queries").and_then(|v| v.as_array()) else {
+        return (400, serde_json::json!({"error": "Missing 'queries' array"}));
+    };
+
+    let results: Vec<BatchResultEntry> = queries
+        .iter()
+        .enumerate()
+        .map(|(idx, q)| {
+            let result = if q.get("type").and_then(|v| v.as_str()) == Some("batch") {
+                serde_json::json!({"error": "Nested batch queries are not supported"})
+            } else {
+                run_server_query(engine, q).1
+            };
+            BatchResultEntry { query: idx, result }
+        })
+        .collect();
+
+    (200, serde_json::json!({ "results": results }))
+}
+
+/// Run a single server query and return its HTTP status and JSON result
+fn run_server_query(engine: &bmb::query::QueryEngine, query: &serde_json::Value) -> (u16, serde_json::Value) {
+    fn ok<T: serde::Serialize>(result: &T) -> (u16, serde_json::Value) {
+        match serde_json::to_value(result) {
+            Ok(value) => (200, value),
+            Err(e) => (500, serde_json::json!({"error": e.to_string()})),
+        }
+    }
+    let str_field = |key: &str| query.get(key).and_then(|v| v.as_str()).unwrap_or("");
+    let bool_field = |key: &str| query.get(key).and_then(|v| v.as_bool()).unwrap_or(false);
+
+    let query_type = str_field("type");
 
     match query_type {
         "sym" => {
-            let pattern = query.get("pattern").and_then(|v| v.as_str()).unwrap_or("");
-            let public = query.get("public").and_then(|v| v.as_bool()).unwrap_or(false);
-            let result = engine.query_symbols(pattern, None, public);
-            match format_output(&result, "json") {
-                Ok(json) => (200, json),
-                Err(e) => (500, format!(r#"{{"error":"{}"}}"#, e)),
+            let pattern = str_field("pattern");
+            let public = bool_field("public");
+            if bool_field("prefix") {
+                ok(&engine.query_symbols_prefix(pattern, None, public))
+            } else {
+                ok(&engine.query_symbols(pattern, None, public))
             }
         }
         "fn" => {
-            let name = query.get("name").and_then(|v| v.as_str()).unwrap_or("");
+            let name = str_field("name");
             if !name.is_empty() {
-                let result = engine.query_function(name);
-                match format_output(&result, "json") {
-                    Ok(json) => (200, json),
-                    Err(e) => (500, format!(r#"{{"error":"{}"}}"#, e)),
-                }
+                ok(&engine.query_function(name))
             } else {
-                (400, r#"{"error":"Missing 'name' field"}"#.to_string())
+                (400, serde_json::json!({"error": "Missing 'name' field"}))
             }
         }
         "type" => {
-            let name = query.get("name").and_then(|v| v.as_str()).unwrap_or("");
+            let name = str_field("name");
             if !name.is_empty() {
-                let result = engine.query_type(name);
-                match format_output(&result, "json") {
-                    Ok(json) => (200, json),
-                    Err(e) => (500, format!(r#"{{"error":"{}"}}"#, e)),
-                }
+                ok(&engine.query_type(name))
             } else {
-                (400, r#"{"error":"Missing 'name' field"}"#.to_string())
-            }
-        }
-        "metrics" => {
-            let result = engine.query_metrics();
-            match format_output(&result, "json") {
-                Ok(json) => (200, json),
-                Err(e) => (500, format!(r#"{{"error":"{}"}}"#, e)),
+                (400, serde_json::json!({"error": "Missing 'name' field"}))
             }
         }
+        "metrics" => ok(&engine.query_metrics()),
         "deps" => {
-            let target = query.get("target").and_then(|v| v.as_str()).unwrap_or("");
-            let reverse = query.get("reverse").and_then(|v| v.as_bool()).unwrap_or(false);
-            let transitive = query.get("transitive").and_then(|v| v.as_bool()).unwrap_or(false);
-            let result = engine.query_deps(target, reverse, transitive);
-            match format_output(&result, "json") {
-                Ok(json) => (200, json),
-                Err(e) => (500, format!(r#"{{"error":"{}"}}"#, e)),
-            }
-        }
-        "contract" => {
-            let name = query.get("name").and_then(|v| v.as_str()).unwrap_or("");
-            let uses_old = query.get("uses_old").and_then(|v| v.as_bool()).unwrap_or(false);
-            let result = engine.query_contract(name, uses_old);
-            match format_output(&result, "json") {
-                Ok(json) => (200, json),
-                Err(e) => (500, format!(r#"{{"error":"{}"}}"#, e)),
-            }
-        }
-        "impact" => {
-            let target = query.get("target").and_then(|v| v.as_str()).unwrap_or("");
-            let change = query.get("change").and_then(|v| v.as_str()).unwrap_or("");
-            let result = engine.query_impact(target, change);
-            match format_output(&result, "json") {
-                Ok(json) => (200, json),
-                Err(e) => (500, format!(r#"{{"error":"{}"}}"#, e)),
-            }
-        }
-        _ => {
-            (400, format!(r#"{{"error":"Unknown query type: {}"}}"#, query_type))
+            let target = str_field("target");
+            ok(&engine.query_deps(target, bool_field("reverse"), bool_field("transitive")))
         }
+        "contract" => ok(&engine.query_contract(str_field("name"), bool_field("uses_old"))),
+        "impact" => ok(&engine.query_impact(str_field("target"), str_field("change"))),
+        _ => (400, serde_json::json!({"error": format!("Unknown query type: {}", query_type)})),
     }
 }
 
@@ -0,0 +1,529 @@
+//! Decision trees for `match`
+//!
+//! The arms of a match form a pattern matrix: one row per arm, with
+//! or-patterns expanded into one row per alternative, whose heads are the
+//! [`Constructor`]s the exhaustiveness checker works with. `compile` turns
+//! the matrix into a tree of tests in the manner of Maranget, "Compiling
+//! Pattern Matching to Good Decision Trees" (ML 2008). Each node tests one
+//! component of the scrutinee and specializes the remaining rows on every
+//! outcome, so along any path a discriminant is tested at most once.
+//! Integer literals and enum tags are tested by a single switch, bools by a
+//! branch, and ranges, floats and strings by comparisons.
+//!
+//! Tuples, arrays and structs are not tested at all: once the type checker
+//! has accepted the match they always match, so rows destructure them into
+//! their components right away.
+
+use crate::ast::{MatchArm, Pattern};
+use crate::types::exhaustiveness::{expand_or_pattern, literal_constructor, range_constructor, Constructor};
+
+/// One step from a value to a component of it
+#[derive(Debug, Clone, PartialEq, Eq, Hash)]
+pub enum Access {
+    /// Word `i` of a tuple, array or enum value; word 0 of an enum is its tag
+    Index(usize),
+    /// Element `k` counted back from the end of an array (1 is the last)
+    FromEnd(usize),
+    /// Named struct field
+    Field(String),
+}
+
+/// A component of the scrutinee, as the accesses that lead to it
+pub type Occurrence = Vec<Access>;
+
+/// Comparison made by a [`Decision::Test`] node
+#[derive(Debug, Clone, PartialEq)]
+pub enum Test {
+    /// The occurrence is the bool `true`
+    True,
+    /// Integer equality
+    Int(i64),
+    /// Integer in `start..=end`
+    Range { start: i64, end: i64 },
+    /// Float equality
+    Float(f64),
+    /// String equality
+    String(String),
+}
+
+/// Decision tree of a match
+#[derive(Debug, Clone, PartialEq)]
+pub enum Decision {
+    /// No arm matches; the type checker rules this out for exhaustive matches
+    Fail,
+    /// Arm `arm` matches once `bindings` are bound
+    Leaf { arm: usize, bindings: Vec<(String, Occurrence)> },
+    /// Arm `arm` matches if its guard holds after binding `bindings`
+    Guard { arm: usize, bindings: Vec<(String, Occurrence)>, otherwise: Box<Decision> },
+    /// Jump on the integer value of `occurrence`
+    Switch { occurrence: Occurrence, cases: Vec<(i64, Decision)>, default: Box<Decision> },
+    /// Branch on a comparison of `occurrence`
+    Test { occurrence: Occurrence, test: Test, then: Box<Decision>, otherwise: Box<Decision> },
+}
+
+/// Pattern matrix row: what is left to match of one arm (or alternative)
+#[derive(Clone)]
+struct Row<'a> {
+    arm: usize,
+    /// Refutable patterns still to test, with the occurrence each applies to
+    tests: Vec<(Occurrence, &'a Pattern)>,
+    bindings: Vec<(String, Occurrence)>,
+}
+
+impl<'a> Row<'a> {
+    /// Position of the test this row makes on `occurrence`, if any
+    fn test_at(&self, occurrence: &Occurrence) -> Option<usize> {
+        self.tests.iter().position(|(o, _)| o == occurrence)
+    }
+}
+
+/// What `compile_rows` needs besides the rows
+struct Context<'t> {
+    /// Whether each arm has a guard
+    guarded: Vec<bool>,
+    /// Tag of a variant, from its enum and variant names
+    tag: &'t mut dyn FnMut(&str, &str) -> i64,
+}
+
+/// Compile the arms of a match into a decision tree
+///
+/// `tag` gives the value an enum switch compares against for each variant.
+pub fn compile(arms: &[MatchArm], tag: &mut dyn FnMut(&str, &str) -> i64) -> Decision {
+    let mut cx = Context { guarded: arms.iter().map(|arm| arm.guard.is_some()).collect(), tag };
+    let rows = arms
+        .iter()
+        .enumerate()
+        .flat_map(|(arm, a)| {
+            normalize(Row { arm, tests: vec![(Vec::new(), &a.pattern.node)], bindings: Vec::new() })
+        })
+        .collect();
+    compile_rows(rows, &mut cx)
+}
+
+/// Reduce the tests of a row to refutable patterns
+///
+/// Variables and `@` bindings turn into bindings, products into tests on
+/// their components, and or-patterns split the row into one per alternative.
+fn normalize(row: Row<'_>) -> Vec<Row<'_>> {
+    let mut done = Row { arm: row.arm, tests: Vec::new(), bindings: row.bindings };
+    let mut pending = row.tests;
+    pending.reverse();
+    while let Some((occurrence, pattern)) = pending.pop() {
+        let child = |access: Access| {
+            let mut o = occurrence.clone();
+            o.push(access);
+            o
+        };
+        match pattern {
+            Pattern::Wildcard => {}
+            Pattern::Var(name) => done.bindings.push((name.clone(), occurrence)),
+            Pattern::Binding { name, pattern } => {
+                done.bindings.push((name.clone(), occurrence.clone()));
+                pending.push((occurrence, &pattern.node));
+            }
+            Pattern::Tuple(elems) | Pattern::Array(elems) => {
+                for (i, elem) in elems.iter().enumerate().rev() {
+                    pending.push((child(Access::Index(i)), &elem.node));
+                }
+            }
+            Pattern::Struct { fields, .. } => {
+                for (name, field) in fields.iter().rev() {
+                    pending.push((child(Access::Field(name.node.clone())), &field.node));
+                }
+            }
+            Pattern::ArrayRest { prefix, suffix } => {
+                for (i, elem) in suffix.iter().enumerate().rev() {
+                    pending.push((child(Access::FromEnd(suffix.len() - i)), &elem.node));
+                }
+                for (i, elem) in prefix.iter().enumerate().rev() {
+                    pending.push((child(Access::Index(i)), &elem.node));
+                }
+            }
+            Pattern::Or(_) => {
+                let rest: Vec<_> = pending.iter().rev().cloned().collect();
+                return expand_or_pattern(pattern)
+                    .into_iter()
+                    .flat_map(|alt| {
+                        let mut tests = done.tests.clone();
+                        tests.push((occurrence.clone(), alt));
+                        tests.extend(rest.iter().cloned());
+                        normalize(Row { arm: done.arm, tests, bindings: done.bindings.clone() })
+                    })
+                    .collect();
+            }
+            Pattern::Literal(_) | Pattern::Range { .. } | Pattern::EnumVariant { .. } => {
+                done.tests.push((occurrence, pattern));
+            }
+        }
+    }
+    vec![done]
+}
+
+/// Head constructor of a refutable pattern
+fn head(pattern: &Pattern) -> Constructor {
+    match pattern {
+        Pattern::Literal(lit) => literal_constructor(lit),
+        Pattern::Range { start, end, inclusive } => range_constructor(start, end, *inclusive),
+        Pattern::EnumVariant { enum_name, variant, .. } => {
+            Constructor::EnumVariant { enum_name: enum_name.clone(), variant: variant.clone() }
+        }
+        _ => Constructor::Wildcard,
+    }
+}
+
+fn compile_rows(rows: Vec<Row<'_>>, cx: &mut Context<'_>) -> Decision {
+    let Some(first) = rows.first() else {
+        return Decision::Fail;
+    };
+    let Some((occurrence, pattern)) = first.tests.first() else {
+        let (arm, bindings) = (first.arm, first.bindings.clone());
+        return if cx.guarded[arm] {
+            let otherwise = compile_rows(rows[1..].to_vec(), cx);
+            Decision::Guard { arm, bindings, otherwise: Box::new(otherwise) }
+        } else {
+            Decision::Leaf { arm, bindings }
+        };
+    };
+    let occurrence = occurrence.clone();
+    let heads: Vec<Constructor> = rows
+        .iter()
+        .filter_map(|row| row.test_at(&occurrence).map(|i| head(row.tests[i].1)))
+        .collect();
+
+    match head(pattern) {
+        Constructor::EnumVariant { .. } => compile_enum_switch(rows, occurrence, cx),
+        Constructor::IntLit(_) if heads.iter().all(|h| matches!(h, Constructor::IntLit(_))) => {
+            let mut values: Vec<i64> = Vec::new();
+            for h in &heads {
+                if let Constructor::IntLit(n) = h
+                    && !values.contains(n)
+                {
+                    values.push(*n);
+                }
+            }
+            let cases = values
+                .iter()
+                .map(|&n| {
+                    let value = Constructor::IntLit(n);
+                    (n, compile_rows(specialize(&rows, &occurrence, |h| Some(*h == value)), cx))
+                })
+                .collect();
+            let default = compile_rows(specialize(&rows, &occurrence, |_| Some(false)), cx);
+            Decision::Switch { occurrence, cases, default: Box::new(default) }
+        }
+        Constructor::BoolLit(_) if heads.iter().all(|h| matches!(h, Constructor::BoolLit(_))) => {
+            let then = specialize(&rows, &occurrence, |h| Some(*h == Constructor::BoolLit(true)));
+            let otherwise = specialize(&rows, &occurrence, |h| Some(*h == Constructor::BoolLit(false)));
+            Decision::Test {
+                occurrence,
+                test: Test::True,
+                then: Box::new(compile_rows(then, cx)),
+                otherwise: Box::new(compile_rows(otherwise, cx)),
+            }
+        }
+        tested => {
+            let then = specialize(&rows, &occurrence, |h| outcome(&tested, true, h));
+            let otherwise = specialize(&rows, &occurrence, |h| outcome(&tested, false, h));
+            let test = match tested {
+                Constructor::IntLit(n) => Test::Int(n),
+                Constructor::BoolLit(b) => Test::Int(b as i64),
+                Constructor::IntRange { start, end } => Test::Range { start, end },
+                Constructor::FloatLit(bits) => Test::Float(f64::from_bits(bits)),
+                Constructor::StringLit(s) => Test::String(s),
+                _ => unreachable!("normalized rows only test literals, ranges and enum variants"),
+            };
+            Decision::Test {
+                occurrence,
+                test,
+                then: Box::new(compile_rows(then, cx)),
+                otherwise: Box::new(compile_rows(otherwise, cx)),
+            }
+        }
+    }
+}
+
+/// Switch on the tag of the enum at `occurrence`
+fn compile_enum_switch(rows: Vec<Row<'_>>, occurrence: Occurrence, cx: &mut Context<'_>) -> Decision {
+    let mut variants: Vec<(&str, &str)> = Vec::new();
+    for row in &rows {
+        if let Some(i) = row.test_at(&occurrence)
+            && let Pattern::EnumVariant { enum_name, variant, .. } = row.tests[i].1
+            && !variants.iter().any(|&(_, v)| v == variant)
+        {
+            variants.push((enum_name, variant));
+        }
+    }
+
+    let cases = variants
+        .iter()
+        .map(|&(enum_name, variant)| {
+            let rows = rows
+                .iter()
+                .flat_map(|row| {
+                    let Some(i) = row.test_at(&occurrence) else {
+                        return vec![row.clone()];
+                    };
+                    let Pattern::EnumVariant { variant: v, bindings, .. } = row.tests[i].1 else {
+                        return vec![row.clone()];
+                    };
+                    if v != variant {
+                        return Vec::new();
+                    }
+                    // Payload word `k + 1` holds field `k`
+                    let fields = bindings.iter().enumerate().map(|(k, p)| {
+                        let mut o = occurrence.clone();
+                        o.push(Access::Index(k + 1));
+                        (o, &p.node)
+                    });
+                    let mut row = row.clone();
+                    row.tests.splice(i..=i, fields);
+                    normalize(row)
+                })
+                .collect();
+            ((cx.tag)(enum_name, variant), compile_rows(rows, cx))
+        })
+        .collect();
+    let default = compile_rows(specialize(&rows, &occurrence, |_| Some(false)), cx);
+
+    let mut tag = occurrence;
+    tag.push(Access::Index(0));
+    Decision::Switch { occurrence: tag, cases, default: Box::new(default) }
+}
+
+/// Rows left once the test at `occurrence` has been made
+///
+/// `matched` says, from the head a row tests there, whether the row's test
+/// is now known to succeed (it is dropped from the row), known to fail (the
+/// row is dropped) or still open (the row is kept as it is). Rows that make
+/// no test there are kept.
+fn specialize<'a>(
+    rows: &[Row<'a>],
+    occurrence: &Occurrence,
+    matched: impl Fn(&Constructor) -> Option<bool>,
+) -> Vec<Row<'a>> {
+    rows.iter()
+        .filter_map(|row| {
+            let Some(i) = row.test_at(occurrence) else {
+                return Some(row.clone());
+            };
+            match matched(&head(row.tests[i].1)) {
+                Some(true) => {
+                    let mut row = row.clone();
+                    row.tests.remove(i);
+                    Some(row)
+                }
+                Some(false) => None,
+                None => Some(row.clone()),
+            }
+        })
+        .collect()
+}
+
+/// What `tested` coming out `passed` says about a test for `other` on the
+/// same value: `Some(true)` if it must succeed, `Some(false)` if it must
+/// fail, `None` if it is still open
+fn outcome(tested: &Constructor, passed: bool, other: &Constructor) -> Option<bool> {
+    let range = |c: &Constructor| match c {
+        Constructor::IntLit(n) => Some((*n, *n)),
+        Constructor::IntRange { start, end } => Some((*start, *end)),
+        _ => None,
+    };
+    if let (Some((ts, te)), Some((os, oe))) = (range(tested), range(other)) {
+        let covers = os <= ts && te <= oe;
+        let disjoint = oe < ts || te < os;
+        let within = ts <= os && oe <= te;
+        return match passed {
+            true if covers => Some(true),
+            true if disjoint => Some(false),
+            false if within => Some(false),
+            _ => None,
+        };
+    }
+    match (tested == other, passed) {
+        (true, passed) => Some(passed),
+        (false, true) if std::mem::discriminant(tested) == std::mem::discriminant(other) => Some(false),
+        _ => None,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ast::{Expr, LiteralPattern, Span, Spanned};
+
+    fn spanned<T>(node: T) -> Spanned<T> {
+        Spanned { node, span: Span { start: 0, end: 0 } }
+    }
+
+    fn arm(pattern: Pattern, guarded: bool) -> MatchArm {
+        MatchArm {
+            pattern: spanned(pattern),
+            guard: guarded.then(|| spanned(Expr::BoolLit(true))),
+            body: spanned(Expr::Unit),
+        }
+    }
+
+    fn int(n: i64) -> Pattern {
+        Pattern::Literal(LiteralPattern::Int(n))
+    }
+
+    /// Tags of `enum Option { Some(i64), None }`
+    fn option_tag(_enum_name: &str, variant: &str) -> i64 {
+        ["Some", "None"].iter().position(|&v| v == variant).expect("an Option variant") as i64
+    }
+
+    fn variant(name: &str, bindings: Vec<Pattern>) -> Pattern {
+        Pattern::EnumVariant {
+            enum_name: "Option".to_string(),
+            variant: name.to_string(),
+            bindings: bindings.into_iter().map(spanned).collect(),
+        }
+    }
+
+    /// Run `tree` on a value given by the word at each occurrence
+    fn run(tree: &Decision, value: &dyn Fn(&Occurrence) -> i64, guard: &dyn Fn(usize) -> bool) -> Option<usize> {
+        match tree {
+            Decision::Fail => None,
+            Decision::Leaf { arm, .. } => Some(*arm),
+            Decision::Guard { arm, otherwise, .. } => {
+                if guard(*arm) { Some(*arm) } else { run(otherwise, value, guard) }
+            }
+            Decision::Switch { occurrence, cases, default } => {
+                let v = value(occurrence);
+                let next = cases.iter().find(|(k, _)| *k == v).map_or(&**default, |(_, d)| d);
+                run(next, value, guard)
+            }
+            Decision::Test { occurrence, test, then, otherwise } => {
+                let v = value(occurrence);
+                let passed = match test {
+                    Test::True => v != 0,
+                    Test::Int(n) => v == *n,
+                    Test::Range { start, end } => *start <= v && v <= *end,
+                    Test::Float(_) | Test::String(_) => unreachable!(),
+                };
+                run(if passed { then } else { otherwise }, value, guard)
+            }
+        }
+    }
+
+    /// Occurrences tested along each path, failing on one tested twice
+    fn assert_tested_once(tree: &Decision, seen: &mut Vec<Occurrence>) {
+        let mut visit = |occurrence: &Occurrence, children: Vec<&Decision>| {
+            assert!(!seen.contains(occurrence), "{:?} tested twice", occurrence);
+            for child in children {
+                seen.push(occurrence.clone());
+                assert_tested_once(child, seen);
+                seen.pop();
+            }
+        };
+        match tree {
+            Decision::Fail | Decision::Leaf { .. } => {}
+            Decision::Guard { otherwise, .. } => assert_tested_once(otherwise, seen),
+            Decision::Switch { occurrence, cases, default } => {
+                visit(occurrence, cases.iter().map(|(_, d)| d).chain([&**default]).collect())
+            }
+            Decision::Test { occurrence, then, otherwise, .. } => visit(occurrence, vec![then, otherwise]),
+        }
+    }
+
+    #[test]
+    fn test_nested_enum_tags_are_switched_once() {
+        // Some(Some(1)) => 0, Some(None) => 1, Some(_) => 2, None => 3
+        let arms = vec![
+            arm(variant("Some", vec![variant("Some", vec![int(1)])]), false),
+            arm(variant("Some", vec![variant("None", vec![])]), false),
+            arm(variant("Some", vec![Pattern::Wildcard]), false),
+            arm(variant("None", vec![]), false),
+        ];
+        let tree = compile(&arms, &mut option_tag);
+        assert_tested_once(&tree, &mut Vec::new());
+
+        let Decision::Switch { occurrence, cases, default } = &tree else {
+            panic!("expected a switch on the tag, got {:?}", tree);
+        };
+        assert_eq!(occurrence, &vec![Access::Index(0)]);
+        assert_eq!(cases.len(), 2);
+        assert_eq!(**default, Decision::Fail);
+
+        let (some, none) = (option_tag("Option", "Some"), option_tag("Option", "None"));
+        let value = |outer: i64, inner: i64, payload: i64| {
+            move |o: &Occurrence| match o.as_slice() {
+                [Access::Index(0)] => outer,
+                [Access::Index(1), Access::Index(0)] => inner,
+                [Access::Index(1), Access::Index(1)] => payload,
+                _ => panic!("unexpected load of {:?}", o),
+            }
+        };
+        let no_guard = |_| true;
+        assert_eq!(run(&tree, &value(some, some, 1), &no_guard), Some(0));
+        assert_eq!(run(&tree, &value(some, some, 5), &no_guard), Some(2));
+        assert_eq!(run(&tree, &value(some, none, 0), &no_guard), Some(1));
+        assert_eq!(run(&tree, &value(none, 0, 0), &no_guard), Some(3));
+    }
+
+    #[test]
+    fn test_literals_ranges_and_or_patterns() {
+        // 1 | 2 => 0, 3..=9 => 1, 5 => 2 (unreachable), _ => 3
+        let arms = vec![
+            arm(Pattern::Or(vec![spanned(int(1)), spanned(int(2))]), false),
+            arm(Pattern::Range { start: LiteralPattern::Int(3), end: LiteralPattern::Int(9), inclusive: true }, false),
+            arm(int(5), false),
+            arm(Pattern::Var("n".to_string()), false),
+        ];
+        let tree = compile(&arms, &mut option_tag);
+        for v in -2..12 {
+            let expected = match v {
+                1 | 2 => 0,
+                3..=9 => 1,
+                _ => 3,
+            };
+            assert_eq!(run(&tree, &|_| v, &|_| true), Some(expected), "value {}", v);
+        }
+    }
+
+    #[test]
+    fn test_int_literals_share_one_switch() {
+        let arms = vec![arm(int(0), false), arm(int(1), false), arm(int(2), false), arm(Pattern::Wildcard, false)];
+        let Decision::Switch { occurrence, cases, default } = compile(&arms, &mut option_tag) else {
+            panic!("expected a switch");
+        };
+        assert!(occurrence.is_empty());
+        assert_eq!(cases.iter().map(|(k, _)| *k).collect::<Vec<_>>(), vec![0, 1, 2]);
+        assert_eq!(*default, Decision::Leaf { arm: 3, bindings: vec![] });
+    }
+
+    #[test]
+    fn test_failed_guard_falls_through_to_later_arms() {
+        // (0, x) if .. => 0, (_, 0) => 1, (a, b) => 2
+        let tuple = |a: Pattern, b: Pattern| Pattern::Tuple(vec![spanned(a), spanned(b)]);
+        let var = |n: &str| Pattern::Var(n.to_string());
+        let arms = vec![
+            arm(tuple(int(0), var("x")), true),
+            arm(tuple(Pattern::Wildcard, int(0)), false),
+            arm(tuple(var("a"), var("b")), false),
+        ];
+        let tree = compile(&arms, &mut option_tag);
+        assert_tested_once(&tree, &mut Vec::new());
+
+        let value = |a: i64, b: i64| {
+            move |o: &Occurrence| match o.as_slice() {
+                [Access::Index(0)] => a,
+                [Access::Index(1)] => b,
+                _ => panic!("unexpected load of {:?}", o),
+            }
+        };
+        let pass = |_| true;
+        let fail = |_| false;
+        assert_eq!(run(&tree, &value(0, 4), &pass), Some(0));
+        assert_eq!(run(&tree, &value(0, 4), &fail), Some(2));
+        assert_eq!(run(&tree, &value(0, 0), &fail), Some(1));
+        assert_eq!(run(&tree, &value(3, 0), &pass), Some(1));
+        assert_eq!(run(&tree, &value(3, 3), &pass), Some(2));
+
+        // The guarded arm binds `x` to the second element before its guard
+        let Decision::Switch { cases, .. } = &tree else { panic!("expected a switch") };
+        let Decision::Guard { arm, bindings, .. } = &cases[0].1 else { panic!("expected a guard") };
+        assert_eq!(*arm, 0);
+        assert_eq!(bindings, &vec![("x".to_string(), vec![Access::Index(1)])]);
+    }
+}
@@ -0,0 +1,524 @@
+//! Escape analysis and scalar replacement of allocations
+//!
+//! An allocation escapes when its handle reaches anything other than the
+//! accessors of its own kind: a call argument, a return value, a phi, a
+//! comparison, another aggregate. Handles that never escape are rewritten
+//! so that no heap or aggregate memory is needed at all:
+//!
+//! - **Boxes**: `b = box_new_i64(v)` whose handle is only read, written
+//!   and freed through the box builtins becomes a plain local holding `v`.
+//! - **Structs**: a `StructInit` used only through field accesses and
+//!   stores (possibly via `let` copies of the handle) is split into one
+//!   local per field.
+//! - **Vectors** (opt-in, see `EscapeAnalysis::new`): `vec_new()` becomes
+//!   `vec_new_inline()`, which the text backend places in the stack frame
+//!   with room for a few elements; `vec_push_inline` spills the data to the
+//!   heap once that room runs out and `vec_free_inline` frees only spilled
+//!   data.
+//!
+//! MIR is not in SSA form, so each candidate handle must be defined by
+//! exactly one instruction; a handle reassigned in place is left alone.
+
+use std::collections::{HashMap, HashSet};
+
+use super::loops::{fresh_place, read_places, terminator_reads, written_place};
+use super::optimize::OptimizationPass;
+use super::{Constant, MirFunction, MirInst, MirType, Operand, Place};
+
+/// Vector accessors that take the handle as their first argument and do
+/// not keep it
+const VEC_ACCESSORS: &[&str] = &[
+    "vec_push", "vec_pop", "vec_get", "vec_get_unchecked", "vec_set", "vec_len", "vec_cap", "vec_clear",
+    "vec_free",
+];
+
+/// Replace non-escaping boxes, structs and (optionally) vectors
+pub struct EscapeAnalysis {
+    /// Rewrite vectors to `vec_new_inline` (only backends that implement
+    /// the inline builtins may enable this)
+    stack_vectors: bool,
+}
+
+impl EscapeAnalysis {
+    pub fn new(stack_vectors: bool) -> Self {
+        Self { stack_vectors }
+    }
+
+    /// Rewrite `b = box_new_i64(v)` into a scalar `b`; returns whether it did
+    fn replace_box(func: &mut MirFunction, name: &str) -> bool {
+        let mut news = 0;
+        for inst in all_mentions(func, name) {
+            match inst {
+                MirInst::Call { dest: Some(d), func: f, args }
+                    if f == "box_new_i64" && d.name == name && args.len() == 1 && !is_place(&args[0], name) =>
+                {
+                    news += 1
+                }
+                MirInst::Call { dest, func: f, args }
+                    if matches!(f.as_str(), "box_get_i64" | "load_i64" | "box_free_i64")
+                        && args.len() == 1
+                        && not_dest(dest, name) => {}
+                MirInst::Call { dest, func: f, args }
+                    if matches!(f.as_str(), "box_set_i64" | "store_i64")
+                        && args.len() == 2
+                        && is_place(&args[0], name)
+                        && !is_place(&args[1], name)
+                        && not_dest(dest, name) => {}
+                _ => return false,
+            }
+        }
+        if news != 1 || terminates_with(func, name) || is_param(func, name) {
+            return false;
+        }
+
+        let slot = Place::new(name);
+        for block in &mut func.blocks {
+            block.instructions = std::mem::take(&mut block.instructions)
+                .into_iter()
+                .flat_map(|inst| -> Vec<MirInst> {
+                    let MirInst::Call { dest, func: f, mut args } = inst else { return vec![inst] };
+                    if !args.first().is_some_and(|a| is_place(a, name)) && !dest.as_ref().is_some_and(|d| d.name == name) {
+                        return vec![MirInst::Call { dest, func: f, args }];
+                    }
+                    match f.as_str() {
+                        "box_new_i64" => vec![assign(slot.clone(), args.remove(0))],
+                        "box_get_i64" | "load_i64" => {
+                            dest.map(|d| MirInst::Copy { dest: d, src: slot.clone() }).into_iter().collect()
+                        }
+                        "box_set_i64" | "store_i64" => std::iter::once(assign(slot.clone(), args.remove(1)))
+                            .chain(dest.map(unit_result))
+                            .collect(),
+                        // box_free_i64
+                        _ => dest.map(unit_result).into_iter().collect(),
+                    }
+                })
+                .collect();
+        }
+        set_local_type(func, name, MirType::I64);
+        true
+    }
+
+    /// Split a struct (and the `let` copies of its handle) into field locals
+    fn replace_struct(func: &mut MirFunction, root: &str) -> bool {
+        if is_param(func, root) {
+            return false;
+        }
+
+        // The handle and every place it is copied to
+        let mut members: Vec<String> = vec![root.to_string()];
+        let mut i = 0;
+        while i < members.len() {
+            for block in &func.blocks {
+                for inst in &block.instructions {
+                    if let MirInst::Copy { dest, src } = inst
+                        && src.name == members[i]
+                        && !members.contains(&dest.name)
+                    {
+                        members.push(dest.name.clone());
+                    }
+                }
+            }
+            i += 1;
+        }
+
+        let mut fields: Vec<(String, Operand)> = Vec::new();
+        let mut defs: HashMap<&str, usize> = HashMap::new();
+        for block in &func.blocks {
+            for inst in &block.instructions {
+                if !members.iter().any(|m| mentions(inst, m)) {
+                    continue;
+                }
+                let member = |p: &Place| members.contains(&p.name);
+                let op_member = |o: &Operand| matches!(o, Operand::Place(p) if member(p));
+                match inst {
+                    MirInst::StructInit { dest, fields: init, .. }
+                        if dest.name == root && !init.iter().any(|(_, v)| op_member(v)) =>
+                    {
+                        fields = init.clone();
+                        *defs.entry(root).or_insert(0) += 1;
+                    }
+                    MirInst::Copy { dest, src } if member(dest) && member(src) && dest.name != root => {
+                        *defs.entry(dest.name.as_str()).or_insert(0) += 1;
+                    }
+                    MirInst::FieldAccess { dest, base, .. } if member(base) && !member(dest) => {}
+                    MirInst::FieldStore { base, value, .. } if member(base) && !op_member(value) => {}
+                    _ => return false,
+                }
+            }
+        }
+        if members.iter().any(|m| defs.get(m.as_str()) != Some(&1) || is_param(func, m) || terminates_with(func, m)) {
+            return false;
+        }
+
+        // Every accessed field must exist, and each field needs a type
+        let declared: HashMap<String, MirType> = members
+            .iter()
+            .find_map(|m| match local_type(func, m) {
+                Some(MirType::Struct { fields, .. }) => {
+                    Some(fields.into_iter().map(|(f, t)| (f, *t)).collect())
+                }
+                _ => None,
+            })
+            .unwrap_or_default();
+        let accessed: HashSet<&str> = func
+            .blocks
+            .iter()
+            .flat_map(|b| &b.instructions)
+            .filter_map(|inst| match inst {
+                MirInst::FieldAccess { base, field, .. } | MirInst::FieldStore { base, field, .. }
+                    if members.contains(&base.name) =>
+                {
+                    Some(field.as_str())
+                }
+                _ => None,
+            })
+            .collect();
+        if accessed.iter().any(|f| !fields.iter().any(|(name, _)| name == f)) {
+            return false;
+        }
+        let mut slots: HashMap<String, Place> = HashMap::new();
+        let mut new_locals = Vec::new();
+        for (field, value) in &fields {
+            let Some(ty) = declared.get(field).cloned().or_else(|| operand_type(func, value)) else {
+                return false;
+            };
+            let slot = fresh_place(func, &format!("{}_{}", root, field));
+            new_locals.push((slot.name.clone(), ty));
+            slots.insert(field.clone(), slot);
+        }
+        // Names must also stay distinct among the new locals themselves
+        if slots.values().map(|p| &p.name).collect::<HashSet<_>>().len() != slots.len() {
+            return false;
+        }
+
+        for block in &mut func.blocks {
+            block.instructions = std::mem::take(&mut block.instructions)
+                .into_iter()
+                .flat_map(|inst| -> Vec<MirInst> {
+                    match inst {
+                        MirInst::StructInit { dest, fields, .. } if dest.name == root => fields
+                            .into_iter()
+                            .map(|(field, value)| assign(slots[&field].clone(), value))
+                            .collect(),
+                        MirInst::Copy { dest, .. } if members.contains(&dest.name) => vec![],
+                        MirInst::FieldAccess { dest, base, field } if members.contains(&base.name) => {
+                            vec![MirInst::Copy { dest, src: slots[&field].clone() }]
+                        }
+                        MirInst::FieldStore { base, field, value } if members.contains(&base.name) => {
+                            vec![assign(slots[&field].clone(), value)]
+                        }
+                        inst => vec![inst],
+                    }
+                })
+                .collect();
+        }
+        func.locals.retain(|(name, _)| !members.contains(name));
+        func.locals.extend(new_locals);
+        true
+    }
+
+    /// Move a non-escaping `vec_new()` into the stack frame
+    fn replace_vec(func: &mut MirFunction, name: &str) -> bool {
+        let mut news = 0;
+        for inst in all_mentions(func, name) {
+            match inst {
+                MirInst::Call { dest: Some(d), func: f, args } if f == "vec_new" && d.name == name && args.is_empty() => {
+                    news += 1
+                }
+                MirInst::Call { dest, func: f, args }
+                    if VEC_ACCESSORS.contains(&f.as_str())
+                        && args.first().is_some_and(|a| is_place(a, name))
+                        && !args[1..].iter().any(|a| is_place(a, name))
+                        && not_dest(dest, name) => {}
+                _ => return false,
+            }
+        }
+        if news != 1 || terminates_with(func, name) || is_param(func, name) {
+            return false;
+        }
+
+        for inst in func.blocks.iter_mut().flat_map(|b| &mut b.instructions) {
+            if let MirInst::Call { dest, func: f, args } = inst
+                && (args.first().is_some_and(|a| is_place(a, name)) || dest.as_ref().is_some_and(|d| d.name == name))
+            {
+                match f.as_str() {
+                    "vec_new" => *f = "vec_new_inline".to_string(),
+                    "vec_push" => *f = "vec_push_inline".to_string(),
+                    "vec_free" => *f = "vec_free_inline".to_string(),
+                    _ => {}
+                }
+            }
+        }
+        true
+    }
+}
+
+impl OptimizationPass for EscapeAnalysis {
+    fn name(&self) -> &'static str {
+        "escape_analysis"
+    }
+
+    fn run_on_function(&self, func: &mut MirFunction) -> bool {
+        self.run_counted(func) > 0
+    }
+
+    /// Returns the number of allocations eliminated
+    fn run_counted(&self, func: &mut MirFunction) -> usize {
+        let mut boxes = Vec::new();
+        let mut structs = Vec::new();
+        let mut vecs = Vec::new();
+        for inst in func.blocks.iter().flat_map(|b| &b.instructions) {
+            match inst {
+                MirInst::Call { dest: Some(d), func: f, .. } if f == "box_new_i64" => boxes.push(d.name.clone()),
+                MirInst::Call { dest: Some(d), func: f, .. } if f == "vec_new" && self.stack_vectors => {
+                    vecs.push(d.name.clone())
+                }
+                MirInst::StructInit { dest, .. } => structs.push(dest.name.clone()),
+                _ => {}
+            }
+        }
+
+        let mut eliminated = 0;
+        for name in &boxes {
+            eliminated += Self::replace_box(func, name) as usize;
+        }
+        for name in &structs {
+            eliminated += Self::replace_struct(func, name) as usize;
+        }
+        for name in &vecs {
+            eliminated += Self::replace_vec(func, name) as usize;
+        }
+        eliminated
+    }
+}
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+fn mentions(inst: &MirInst, name: &str) -> bool {
+    written_place(inst) == Some(name) || read_places(inst).contains(&name)
+}
+
+/// Instructions that read or write `name`
+fn all_mentions<'a>(func: &'a MirFunction, name: &'a str) -> impl Iterator<Item = &'a MirInst> {
+    func.blocks.iter().flat_map(|b| &b.instructions).filter(move |inst| mentions(inst, name))
+}
+
+fn terminates_with(func: &MirFunction, name: &str) -> bool {
+    func.blocks.iter().any(|b| terminator_reads(&b.terminator) == Some(name))
+}
+
+fn is_place(op: &Operand, name: &str) -> bool {
+    matches!(op, Operand::Place(p) if p.name == name)
+}
+
+fn not_dest(dest: &Option<Place>, name: &str) -> bool {
+    dest.as_ref().is_none_or(|d| d.name != name)
+}
+
+fn is_param(func: &MirFunction, name: &str) -> bool {
+    func.params.iter().any(|(p, _)| p == name)
+}
+
+fn local_type(func: &MirFunction, name: &str) -> Option<MirType> {
+    func.params.iter().chain(&func.locals).find(|(n, _)| n == name).map(|(_, t)| t.clone())
+}
+
+fn operand_type(func: &MirFunction, op: &Operand) -> Option<MirType> {
+    match op {
+        Operand::Place(p) => local_type(func, &p.name),
+        Operand::Constant(c) => match c {
+            Constant::Int(_) => Some(MirType::I64),
+            Constant::Float(_) => Some(MirType::F64),
+            Constant::Bool(_) => Some(MirType::Bool),
+            Constant::String(_) => Some(MirType::String),
+            Constant::Char(_) => Some(MirType::Char),
+            Constant::Unit => Some(MirType::Unit),
+            Constant::FnRef(_) => None,
+        },
+    }
+}
+
+fn set_local_type(func: &mut MirFunction, name: &str, ty: MirType) {
+    match func.locals.iter_mut().find(|(n, _)| n == name) {
+        Some(local) => local.1 = ty,
+        None => func.locals.push((name.to_string(), ty)),
+    }
+}
+
+fn assign(dest: Place, value: Operand) -> MirInst {
+    match value {
+        Operand::Constant(value) => MirInst::Const { dest, value },
+        Operand::Place(src) => MirInst::Copy { dest, src },
+    }
+}
+
+/// The (unused in practice) result of a replaced unit-returning builtin
+fn unit_result(dest: Place) -> MirInst {
+    MirInst::Const { dest, value: Constant::Int(0) }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::mir::test_util::{block, call, function, int, place, var};
+    use crate::mir::{MirBinOp, Terminator};
+
+    /// `fn f(x)` running `instructions` and returning `ret`
+    fn func(instructions: Vec<MirInst>, ret: Operand) -> MirFunction {
+        function("f", &["x"], &[], vec![block("entry", instructions, Terminator::Return(Some(ret)))])
+    }
+
+    fn calls(func: &MirFunction) -> Vec<&str> {
+        func.blocks
+            .iter()
+            .flat_map(|b| &b.instructions)
+            .filter_map(|inst| match inst {
+                MirInst::Call { func, .. } => Some(func.as_str()),
+                _ => None,
+            })
+            .collect()
+    }
+
+    #[test]
+    fn test_local_box_becomes_scalar() {
+        let mut f = func(
+            vec![
+                call(Some("b"), "box_new_i64", vec![var("x")]),
+                call(Some("v"), "box_get_i64", vec![var("b")]),
+                MirInst::BinOp { dest: place("w"), op: MirBinOp::Add, lhs: var("v"), rhs: int(1) },
+                call(Some("u"), "box_set_i64", vec![var("b"), var("w")]),
+                call(Some("r"), "box_get_i64", vec![var("b")]),
+                call(Some("u2"), "box_free_i64", vec![var("b")]),
+            ],
+            var("r"),
+        );
+        assert_eq!(EscapeAnalysis::new(false).run_counted(&mut f), 1);
+        assert!(calls(&f).is_empty());
+        let insts = &f.blocks[0].instructions;
+        assert!(matches!(&insts[0], MirInst::Copy { dest, src } if dest.name == "b" && src.name == "x"));
+        assert!(matches!(&insts[1], MirInst::Copy { dest, src } if dest.name == "v" && src.name == "b"));
+        assert!(matches!(&insts[3], MirInst::Copy { dest, src } if dest.name == "b" && src.name == "w"));
+        assert!(f.locals.contains(&("b".to_string(), MirType::I64)));
+    }
+
+    #[test]
+    fn test_escaping_box_is_kept() {
+        // Passed to a user function, or returned: the pointer is observable
+        let mut passed = func(
+            vec![
+                call(Some("b"), "box_new_i64", vec![int(1)]),
+                call(Some("r"), "consume", vec![var("b")]),
+            ],
+            var("r"),
+        );
+        let mut returned = func(vec![call(Some("b"), "box_new_i64", vec![int(1)])], var("b"));
+        assert_eq!(EscapeAnalysis::new(false).run_counted(&mut passed), 0);
+        assert_eq!(EscapeAnalysis::new(false).run_counted(&mut returned), 0);
+        assert_eq!(calls(&passed), vec!["box_new_i64", "consume"]);
+    }
+
+    #[test]
+    fn test_struct_split_into_field_locals() {
+        // let p = Point { x: x, y: 2 }; p.y = p.x; p.y
+        let mut f = func(
+            vec![
+                MirInst::StructInit {
+                    dest: place("_t0"),
+                    struct_name: "Point".to_string(),
+                    fields: vec![("x".to_string(), var("x")), ("y".to_string(), int(2))],
+                },
+                MirInst::Copy { dest: place("p"), src: place("_t0") },
+                MirInst::FieldAccess { dest: place("a"), base: place("p"), field: "x".to_string() },
+                MirInst::FieldStore { base: place("p"), field: "y".to_string(), value: var("a") },
+                MirInst::FieldAccess { dest: place("r"), base: place("p"), field: "y".to_string() },
+            ],
+            var("r"),
+        );
+        let point = MirType::Struct {
+            name: "Point".to_string(),
+            fields: vec![("x".to_string(), Box::new(MirType::I64)), ("y".to_string(), Box::new(MirType::I64))],
+        };
+        f.locals.push(("p".to_string(), point));
+        assert_eq!(EscapeAnalysis::new(false).run_counted(&mut f), 1);
+        let insts = &f.blocks[0].instructions;
+        assert_eq!(insts.len(), 5);
+        assert!(matches!(&insts[0], MirInst::Copy { dest, src } if dest.name == "_t0_x" && src.name == "x"));
+        assert!(matches!(&insts[1], MirInst::Const { dest, value: Constant::Int(2) } if dest.name == "_t0_y"));
+        assert!(matches!(&insts[2], MirInst::Copy { dest, src } if dest.name == "a" && src.name == "_t0_x"));
+        assert!(matches!(&insts[3], MirInst::Copy { dest, src } if dest.name == "_t0_y" && src.name == "a"));
+        assert!(matches!(&insts[4], MirInst::Copy { dest, src } if dest.name == "r" && src.name == "_t0_y"));
+        assert!(!f.locals.iter().any(|(n, _)| n == "p"));
+    }
+
+    #[test]
+    fn test_struct_passed_to_call_is_kept() {
+        let mut f = func(
+            vec![
+                MirInst::StructInit {
+                    dest: place("s"),
+                    struct_name: "Pair".to_string(),
+                    fields: vec![("a".to_string(), int(1))],
+                },
+                call(Some("r"), "takes_pair", vec![var("s")]),
+            ],
+            var("r"),
+        );
+        assert_eq!(EscapeAnalysis::new(false).run_counted(&mut f), 0);
+    }
+
+    #[test]
+    fn test_stack_vectors_are_opt_in() {
+        let body = || {
+            func(
+                vec![
+                    call(Some("v"), "vec_new", vec![]),
+                    call(Some("u"), "vec_push", vec![var("v"), var("x")]),
+                    call(Some("r"), "vec_get", vec![var("v"), int(0)]),
+                    call(Some("u2"), "vec_free", vec![var("v")]),
+                ],
+                var("r"),
+            )
+        };
+        let mut heap = body();
+        assert_eq!(EscapeAnalysis::new(false).run_counted(&mut heap), 0);
+
+        let mut stack = body();
+        assert_eq!(EscapeAnalysis::new(true).run_counted(&mut stack), 1);
+        assert_eq!(calls(&stack), vec!["vec_new_inline", "vec_push_inline", "vec_get", "vec_free_inline"]);
+        // Already rewritten: nothing more to do
+        assert_eq!(EscapeAnalysis::new(true).run_counted(&mut stack), 0);
+    }
+
+    #[test]
+    fn test_vector_pushed_into_another_escapes() {
+        let mut f = func(
+            vec![
+                call(Some("v"), "vec_new", vec![]),
+                call(Some("w"), "vec_new", vec![]),
+                call(Some("u"), "vec_push", vec![var("w"), var("v")]),
+            ],
+            var("x"),
+        );
+        // `w` stays local; `v` is stored as an element of `w`
+        assert_eq!(EscapeAnalysis::new(true).run_counted(&mut f), 1);
+        assert_eq!(calls(&f), vec!["vec_new", "vec_new_inline", "vec_push_inline"]);
+    }
+
+    #[test]
+    fn test_pipeline_reports_eliminated_allocations() {
+        use crate::mir::{MirProgram, OptLevel, OptimizationPipeline};
+
+        let f = func(
+            vec![
+                call(Some("b"), "box_new_i64", vec![var("x")]),
+                call(Some("r"), "box_get_i64", vec![var("b")]),
+            ],
+            var("r"),
+        );
+        let mut program = MirProgram { functions: vec![f], extern_fns: vec![] };
+        let stats = OptimizationPipeline::for_level(OptLevel::Release).optimize(&mut program);
+        assert_eq!(stats.allocations_eliminated(), 1);
+    }
+}
@@ -0,0 +1,549 @@
+//! Function inlining
+//!
+//! `FunctionInlining` copies the bodies of small, non-recursive user
+//! functions into their callers. The cost model weighs callee size against
+//! call-site heat: a call inside a loop may pull in a larger body than a
+//! call on a straight-line path, and callers stop growing at
+//! `MAX_CALLER_SIZE`.
+//!
+//! Inlining is contract-aware. The callee's preconditions hold for the
+//! arguments bound to its (renamed) parameters, and its postconditions hold
+//! for the call's result, so both become facts of the caller that
+//! `ContractBasedOptimization` can use.
+
+use std::collections::{HashMap, HashSet};
+
+use super::{BasicBlock, ContractFact, MirFunction, MirInst, MirProgram, Operand, Place, Terminator};
+use super::loops::loop_depths;
+use super::optimize::{single_assignment_places, OptimizationPass};
+
+/// Largest callee inlined at a call outside any loop
+const COLD_SIZE_LIMIT: usize = 12;
+
+/// Extra callee size allowed per enclosing loop of the call site
+const HOT_SIZE_BONUS: usize = 24;
+
+/// Callers are not grown past this size
+const MAX_CALLER_SIZE: usize = 2000;
+
+/// Inlined calls per function and run (bounds nested inlining)
+const MAX_INLINES_PER_RUN: usize = 64;
+
+/// Name contract facts use for the return value (see `lower_function`)
+const RETURN_VAR: &str = "ret";
+
+/// Inline small user functions into their callers
+pub struct FunctionInlining {
+    /// Bodies of the functions that may be inlined, as they were lowered
+    callees: HashMap<String, MirFunction>,
+}
+
+/// Size used by the cost model: instructions plus terminators
+pub(super) fn size(func: &MirFunction) -> usize {
+    func.blocks.iter().map(|b| b.instructions.len() + 1).sum()
+}
+
+/// Size limit for a call site nested in `depth` loops
+fn size_limit(depth: usize) -> usize {
+    COLD_SIZE_LIMIT + HOT_SIZE_BONUS * depth.min(2)
+}
+
+impl FunctionInlining {
+    /// Collect the inlinable functions of a program
+    ///
+    /// A function qualifies when it is small enough for a hot call site and
+    /// cannot reach itself through the call graph (inlining a recursive
+    /// function would never terminate).
+    pub fn from_program(program: &MirProgram) -> Self {
+        let calls: HashMap<&str, HashSet<&str>> = program
+            .functions
+            .iter()
+            .map(|f| {
+                let callees = f
+                    .blocks
+                    .iter()
+                    .flat_map(|b| &b.instructions)
+                    .filter_map(|inst| match inst {
+                        MirInst::Call { func, .. } => Some(func.as_str()),
+                        _ => None,
+                    })
+                    .collect();
+                (f.name.as_str(), callees)
+            })
+            .collect();
+
+        let reaches_itself = |start: &str| {
+            let mut seen = HashSet::new();
+            let mut work: Vec<&str> = calls.get(start).into_iter().flatten().copied().collect();
+            while let Some(f) = work.pop() {
+                if f == start {
+                    return true;
+                }
+                if seen.insert(f) {
+                    work.extend(calls.get(f).into_iter().flatten().copied());
+                }
+            }
+            false
+        };
+
+        let callees = program
+            .functions
+            .iter()
+            .filter(|f| f.name != "main" && size(f) <= size_limit(2) && !reaches_itself(&f.name))
+            .map(|f| (f.name.clone(), f.clone()))
+            .collect();
+        Self { callees }
+    }
+
+    /// Next call site in `func` worth inlining
+    fn next_site(&self, func: &MirFunction) -> Option<(usize, usize)> {
+        let budget = MAX_CALLER_SIZE.saturating_sub(size(func));
+        let depths = loop_depths(func);
+        for (b, block) in func.blocks.iter().enumerate() {
+            for (k, inst) in block.instructions.iter().enumerate() {
+                if let MirInst::Call { func: name, args, .. } = inst
+                    && let Some(callee) = self.callees.get(name)
+                    && name != &func.name
+                    && args.len() == callee.params.len()
+                    && size(callee) <= size_limit(depths[b]).min(budget)
+                {
+                    return Some((b, k));
+                }
+            }
+        }
+        None
+    }
+}
+
+impl OptimizationPass for FunctionInlining {
+    fn name(&self) -> &'static str {
+        "function_inlining"
+    }
+
+    fn run_on_function(&self, func: &mut MirFunction) -> bool {
+        self.run_counted(func) > 0
+    }
+
+    fn run_counted(&self, func: &mut MirFunction) -> usize {
+        let mut count = 0;
+        while count < MAX_INLINES_PER_RUN
+            && let Some((b, k)) = self.next_site(func)
+        {
+            let MirInst::Call { func: name, .. } = &func.blocks[b].instructions[k] else { unreachable!() };
+            let callee = &self.callees[name];
+            inline_call(func, b, k, callee);
+            count += 1;
+        }
+        count
+    }
+}
+
+/// Replace the call at `func.blocks[b].instructions[k]` by the body of `callee`
+///
+/// ```text
+/// bb:    pre; %d = call f(a)         bb:      pre; %p.inl0 = a; goto f_entry.inl0
+///        post; term           =>     ...      (f's blocks; returns become %d = v; goto bb.cont0)
+///                                    bb.cont0: post; term
+/// ```
+fn inline_call(func: &mut MirFunction, b: usize, k: usize, callee: &MirFunction) {
+    let mut n = 0;
+    let suffix = loop {
+        let suffix = format!(".inl{}", n);
+        if !func.blocks.iter().any(|blk| blk.label.ends_with(&suffix)) {
+            break suffix;
+        }
+        n += 1;
+    };
+    let rename = |name: &str| format!("{}{}", name, suffix);
+    // The result is a function-wide fact only if nothing else assigns it
+    let single = single_assignment_places(func);
+
+    let block = &mut func.blocks[b];
+    let call_label = block.label.clone();
+    let cont_label = format!("{}.cont{}", call_label, n);
+    let post: Vec<MirInst> = block.instructions.split_off(k + 1);
+    let Some(MirInst::Call { dest, args, .. }) = block.instructions.pop() else { unreachable!() };
+
+    // Bind the arguments to the renamed parameters and enter the body
+    for ((param, _), arg) in callee.params.iter().zip(args) {
+        let dest = Place::new(rename(param));
+        block.instructions.push(match arg {
+            Operand::Constant(value) => MirInst::Const { dest, value },
+            Operand::Place(src) => MirInst::Copy { dest, src },
+        });
+    }
+    let term = std::mem::replace(&mut block.terminator, Terminator::Goto(rename(&callee.blocks[0].label)));
+
+    // Successor phis now see the continuation block as their predecessor
+    for succ in successors(&term) {
+        if let Some(blk) = func.blocks.iter_mut().find(|blk| blk.label == succ) {
+            for inst in &mut blk.instructions {
+                if let MirInst::Phi { values, .. } = inst {
+                    for (_, from) in values.iter_mut() {
+                        if *from == call_label {
+                            *from = cont_label.clone();
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    let mut body: Vec<BasicBlock> = callee
+        .blocks
+        .iter()
+        .map(|blk| {
+            let mut instructions: Vec<MirInst> = blk
+                .instructions
+                .iter()
+                .map(|inst| {
+                    let mut inst = inst.clone();
+                    rename_inst(&mut inst, &rename);
+                    inst
+                })
+                .collect();
+            let terminator = match &blk.terminator {
+                Terminator::Return(value) => {
+                    match (&dest, value) {
+                        (Some(d), Some(Operand::Constant(c))) => {
+                            instructions.push(MirInst::Const { dest: d.clone(), value: c.clone() });
+                        }
+                        (Some(d), Some(Operand::Place(p))) => {
+                            instructions.push(MirInst::Copy { dest: d.clone(), src: Place::new(rename(&p.name)) });
+                        }
+                        _ => {}
+                    }
+                    Terminator::Goto(cont_label.clone())
+                }
+                other => {
+                    let mut t = other.clone();
+                    rename_terminator(&mut t, &rename);
+                    t
+                }
+            };
+            BasicBlock { label: rename(&blk.label), instructions, terminator }
+        })
+        .collect();
+    body.push(BasicBlock { label: cont_label, instructions: post, terminator: term });
+    func.blocks.splice(b + 1..b + 1, body);
+
+    for (name, ty) in callee.params.iter().chain(&callee.locals) {
+        func.locals.push((rename(name), ty.clone()));
+    }
+
+    // Contract facts: preconditions about parameters the body never
+    // reassigns, postconditions about a result the caller never reassigns
+    let reassigned: HashSet<&str> = callee
+        .blocks
+        .iter()
+        .flat_map(|blk| &blk.instructions)
+        .filter_map(written_place)
+        .collect();
+    let params: HashSet<&str> = callee.params.iter().map(|(p, _)| p.as_str()).collect();
+    let bind = |var: &str| -> Option<String> {
+        if params.contains(var) {
+            (!reassigned.contains(var)).then(|| rename(var))
+        } else if var == RETURN_VAR {
+            dest.as_ref().filter(|d| single.contains(&d.name)).map(|d| d.name.clone())
+        } else {
+            None
+        }
+    };
+    let carried: Vec<ContractFact> = callee
+        .preconditions
+        .iter()
+        .filter(|fact| !fact_vars(fact).contains(&RETURN_VAR))
+        .chain(&callee.postconditions)
+        .filter_map(|fact| rename_fact(fact, &bind))
+        .collect();
+    for fact in carried {
+        if !func.preconditions.contains(&fact) {
+            func.preconditions.push(fact);
+        }
+    }
+}
+
+pub(super) fn successors(term: &Terminator) -> Vec<String> {
+    match term {
+        Terminator::Goto(t) => vec![t.clone()],
+        Terminator::Branch { then_label, else_label, .. } => vec![then_label.clone(), else_label.clone()],
+        Terminator::Switch { cases, default, .. } => {
+            cases.iter().map(|(_, l)| l.clone()).chain(std::iter::once(default.clone())).collect()
+        }
+        Terminator::Return(_) | Terminator::Unreachable => vec![],
+    }
+}
+
+fn written_place(inst: &MirInst) -> Option<&str> {
+    match inst {
+        MirInst::Const { dest, .. }
+        | MirInst::Copy { dest, .. }
+        | MirInst::BinOp { dest, .. }
+        | MirInst::UnaryOp { dest, .. }
+        | MirInst::Phi { dest, .. }
+        | MirInst::StructInit { dest, .. }
+        | MirInst::FieldAccess { dest, .. }
+        | MirInst::EnumVariant { dest, .. }
+        | MirInst::ArrayInit { dest, .. }
+        | MirInst::IndexLoad { dest, .. } => Some(&dest.name),
+        MirInst::Call { dest, .. } => dest.as_ref().map(|d| d.name.as_str()),
+        MirInst::FieldStore { base, .. } => Some(&base.name),
+        MirInst::IndexStore { array, .. } => Some(&array.name),
+    }
+}
+
+fn rename_place(place: &mut Place, rename: &impl Fn(&str) -> String) {
+    place.name = rename(&place.name);
+}
+
+fn rename_operand(op: &mut Operand, rename: &impl Fn(&str) -> String) {
+    if let Operand::Place(p) = op {
+        rename_place(p, rename);
+    }
+}
+
+/// Rename every place and block label an instruction mentions
+fn rename_inst(inst: &mut MirInst, rename: &impl Fn(&str) -> String) {
+    match inst {
+        MirInst::Const { dest, .. } => rename_place(dest, rename),
+        MirInst::Copy { dest, src } => {
+            rename_place(dest, rename);
+            rename_place(src, rename);
+        }
+        MirInst::BinOp { dest, lhs, rhs, .. } => {
+            rename_place(dest, rename);
+            rename_operand(lhs, rename);
+            rename_operand(rhs, rename);
+        }
+        MirInst::UnaryOp { dest, src, .. } => {
+            rename_place(dest, rename);
+            rename_operand(src, rename);
+        }
+        MirInst::Call { dest, args, .. } => {
+            if let Some(d) = dest {
+                rename_place(d, rename);
+            }
+            args.iter_mut().for_each(|a| rename_operand(a, rename));
+        }
+        MirInst::Phi { dest, values } => {
+            rename_place(dest, rename);
+            for (v, label) in values.iter_mut() {
+                rename_operand(v, rename);
+                *label = rename(label);
+            }
+        }
+        MirInst::StructInit { dest, fields, .. } => {
+            rename_place(dest, rename);
+            fields.iter_mut().for_each(|(_, v)| rename_operand(v, rename));
+        }
+        MirInst::FieldAccess { dest, base, .. } => {
+            rename_place(dest, rename);
+            rename_place(base, rename);
+        }
+        MirInst::FieldStore { base, value, .. } => {
+            rename_place(base, rename);
+            rename_operand(value, rename);
+        }
+        MirInst::EnumVariant { dest, args, .. } => {
+            rename_place(dest, rename);
+            args.iter_mut().for_each(|a| rename_operand(a, rename));
+        }
+        MirInst::ArrayInit { dest, elements, .. } => {
+            rename_place(dest, rename);
+            elements.iter_mut().for_each(|e| rename_operand(e, rename));
+        }
+        MirInst::IndexLoad { dest, array, index } => {
+            rename_place(dest, rename);
+            rename_place(array, rename);
+            rename_operand(index, rename);
+        }
+        MirInst::IndexStore { array, index, value } => {
+            rename_place(array, rename);
+            rename_operand(index, rename);
+            rename_operand(value, rename);
+        }
+    }
+}
+
+fn rename_terminator(term: &mut Terminator, rename: &impl Fn(&str) -> String) {
+    match term {
+        Terminator::Return(Some(op)) => rename_operand(op, rename),
+        Terminator::Return(None) | Terminator::Unreachable => {}
+        Terminator::Goto(label) => *label = rename(label),
+        Terminator::Branch { cond, then_label, else_label } => {
+            rename_operand(cond, rename);
+            *then_label = rename(then_label);
+            *else_label = rename(else_label);
+        }
+        Terminator::Switch { discriminant, cases, default } => {
+            rename_operand(discriminant, rename);
+            cases.iter_mut().for_each(|(_, l)| *l = rename(l));
+            *default = rename(default);
+        }
+    }
+}
+
+fn fact_vars(fact: &ContractFact) -> Vec<&str> {
+    match fact {
+        ContractFact::VarCmp { var, .. } | ContractFact::NonNull { var } => vec![var],
+        ContractFact::VarVarCmp { lhs, rhs, .. } => vec![lhs, rhs],
+        ContractFact::ArrayBounds { index, array } => vec![index, array],
+    }
+}
+
+/// `fact` restated over caller places, if every variable it mentions binds
+fn rename_fact(fact: &ContractFact, bind: &impl Fn(&str) -> Option<String>) -> Option<ContractFact> {
+    Some(match fact {
+        ContractFact::VarCmp { var, op, value } => ContractFact::VarCmp { var: bind(var)?, op: *op, value: *value },
+        ContractFact::VarVarCmp { lhs, op, rhs } => ContractFact::VarVarCmp { lhs: bind(lhs)?, op: *op, rhs: bind(rhs)? },
+        ContractFact::ArrayBounds { index, array } => {
+            ContractFact::ArrayBounds { index: bind(index)?, array: bind(array)? }
+        }
+        ContractFact::NonNull { var } => ContractFact::NonNull { var: bind(var)? },
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::mir::test_util::{block, call, function, place, program, var};
+    use crate::mir::{CmpOp, Constant, MirBinOp, MirType};
+
+    fn non_negative(v: &str) -> ContractFact {
+        ContractFact::VarCmp { var: v.to_string(), op: CmpOp::Ge, value: 0 }
+    }
+
+    /// `fn inc(x) -> i64 pre x >= 0 post ret >= 0 = x + 1`
+    fn inc() -> MirFunction {
+        let mut f = function(
+            "inc",
+            &["x"],
+            &[("t", MirType::I64)],
+            vec![block(
+                "entry",
+                vec![MirInst::BinOp { dest: place("t"), op: MirBinOp::Add, lhs: var("x"), rhs: Operand::Constant(Constant::Int(1)) }],
+                Terminator::Return(Some(var("t"))),
+            )],
+        );
+        f.preconditions = vec![non_negative("x")];
+        f.postconditions = vec![non_negative("ret")];
+        f
+    }
+
+    /// A callee of `n` instructions
+    fn sized(name: &str, n: usize) -> MirFunction {
+        let body = (0..n).map(|_| MirInst::Copy { dest: place("t"), src: place("x") }).collect();
+        let entry = block("entry", body, Terminator::Return(Some(var("t"))));
+        function(name, &["x"], &[("t", MirType::I64)], vec![entry])
+    }
+
+    fn calls(func: &MirFunction) -> usize {
+        func.blocks
+            .iter()
+            .flat_map(|b| &b.instructions)
+            .filter(|i| matches!(i, MirInst::Call { .. }))
+            .count()
+    }
+
+    #[test]
+    fn test_inline_small_function() {
+        // entry: r = inc(a); goto merge    merge: v = phi [r, entry]; return v
+        let mut caller = function(
+            "caller",
+            &["a"],
+            &[("r", MirType::I64), ("v", MirType::I64)],
+            vec![
+                block("entry", vec![call(Some("r"), "inc", vec![var("a")])], Terminator::Goto("merge".into())),
+                block(
+                    "merge",
+                    vec![MirInst::Phi { dest: place("v"), values: vec![(var("r"), "entry".into())] }],
+                    Terminator::Return(Some(var("v"))),
+                ),
+            ],
+        );
+        let inliner = FunctionInlining::from_program(&program(vec![inc(), caller.clone()]));
+        assert_eq!(inliner.run_counted(&mut caller), 1);
+        assert_eq!(calls(&caller), 0);
+
+        let labels: Vec<&str> = caller.blocks.iter().map(|b| b.label.as_str()).collect();
+        assert_eq!(labels, ["entry", "entry.inl0", "entry.cont0", "merge"]);
+        assert!(matches!(
+            &caller.blocks[0].instructions[..],
+            [MirInst::Copy { dest, src }] if dest.name == "x.inl0" && src.name == "a"
+        ));
+        assert!(matches!(
+            caller.blocks[1].instructions.last(),
+            Some(MirInst::Copy { dest, src }) if dest.name == "r" && src.name == "t.inl0"
+        ));
+        assert!(matches!(&caller.blocks[1].terminator, Terminator::Goto(l) if l == "entry.cont0"));
+        assert!(matches!(
+            &caller.blocks[3].instructions[0],
+            MirInst::Phi { values, .. } if values[0].1 == "entry.cont0"
+        ));
+        assert!(caller.locals.iter().any(|(l, _)| l == "t.inl0"));
+    }
+
+    #[test]
+    fn test_inline_carries_contract_facts() {
+        let mut caller = function(
+            "caller",
+            &["a"],
+            &[("r", MirType::I64)],
+            vec![block("entry", vec![call(Some("r"), "inc", vec![var("a")])], Terminator::Return(Some(var("r"))))],
+        );
+        let inliner = FunctionInlining::from_program(&program(vec![inc(), caller.clone()]));
+        inliner.run_counted(&mut caller);
+        assert_eq!(caller.preconditions, vec![non_negative("x.inl0"), non_negative("r")]);
+    }
+
+    #[test]
+    fn test_recursive_functions_are_not_inlined() {
+        let recursive = function(
+            "down",
+            &["x"],
+            &[("t", MirType::I64)],
+            vec![block("entry", vec![call(Some("t"), "down", vec![var("x")])], Terminator::Return(Some(var("t"))))],
+        );
+        let mut caller = function(
+            "caller",
+            &["a"],
+            &[("r", MirType::I64)],
+            vec![block("entry", vec![call(Some("r"), "down", vec![var("a")])], Terminator::Return(Some(var("r"))))],
+        );
+        let inliner = FunctionInlining::from_program(&program(vec![recursive, caller.clone()]));
+        assert_eq!(inliner.run_counted(&mut caller), 0);
+        assert_eq!(calls(&caller), 1);
+    }
+
+    #[test]
+    fn test_hot_call_sites_inline_larger_callees() {
+        // Too large for a straight-line call, small enough inside a loop
+        let big = sized("big", 20);
+        let mut cold = function(
+            "cold",
+            &["a"],
+            &[("r", MirType::I64)],
+            vec![block("entry", vec![call(Some("r"), "big", vec![var("a")])], Terminator::Return(Some(var("r"))))],
+        );
+        let mut hot = function(
+            "hot",
+            &["a"],
+            &[("r", MirType::I64)],
+            vec![
+                block("entry", vec![], Terminator::Goto("loop".into())),
+                block(
+                    "loop",
+                    vec![call(Some("r"), "big", vec![var("a")])],
+                    Terminator::Branch { cond: var("r"), then_label: "loop".into(), else_label: "exit".into() },
+                ),
+                block("exit", vec![], Terminator::Return(Some(var("r")))),
+            ],
+        );
+        let inliner = FunctionInlining::from_program(&program(vec![big, cold.clone(), hot.clone()]));
+        assert_eq!(inliner.run_counted(&mut cold), 0);
+        assert_eq!(inliner.run_counted(&mut hot), 1);
+        // The back edge now leaves from the continuation block
+        assert!(matches!(&hot.blocks[3].terminator, Terminator::Branch { then_label, .. } if then_label == "loop"));
+        assert_eq!(hot.blocks[3].label, "loop.cont0");
+    }
+}
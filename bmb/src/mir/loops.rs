@@ -0,0 +1,752 @@
+//! Loop optimizations
+//!
+//! Natural loops are found from back edges of the CFG (an edge whose
+//! target dominates its source). MIR is not in SSA form: loop variables
+//! are reassigned in place, so both passes reason about how often a place
+//! is defined inside the loop instead of about unique definitions.
+//!
+//! - **LICM** moves instructions whose operands are not defined in the
+//!   loop into the loop's preheader. Instructions that may trap (integer
+//!   division, user `@pure` calls) only move when they would have run on
+//!   every trip through the loop anyway.
+//! - **IV strength reduction** replaces `j = i * k` for a basic induction
+//!   variable `i` (one in-loop update `i = i + c`) by a running value
+//!   bumped by `c * k` next to that update.
+
+use std::collections::{HashMap, HashSet};
+
+use super::{Constant, MirBinOp, MirFunction, MirInst, MirProgram, MirType, Operand, Place, Terminator};
+use super::optimize::OptimizationPass;
+
+/// Builtins that never trap and whose result depends only on their arguments
+const PURE_BUILTINS: &[&str] = &["len", "str_len", "abs", "min", "max"];
+
+// ============================================================================
+// Loop Detection
+// ============================================================================
+
+/// Control-flow graph of one function (blocks by index; entry is 0)
+struct Cfg {
+    succs: Vec<Vec<usize>>,
+    preds: Vec<Vec<usize>>,
+    /// Immediate dominator (entry maps to itself; unreachable blocks to None)
+    idom: Vec<Option<usize>>,
+}
+
+impl Cfg {
+    fn new(func: &MirFunction) -> Self {
+        let index: HashMap<&str, usize> =
+            func.blocks.iter().enumerate().map(|(i, b)| (b.label.as_str(), i)).collect();
+        let n = func.blocks.len();
+        let mut succs = vec![Vec::new(); n];
+        let mut preds = vec![Vec::new(); n];
+        for (i, block) in func.blocks.iter().enumerate() {
+            let targets: Vec<&String> = match &block.terminator {
+                Terminator::Goto(t) => vec![t],
+                Terminator::Branch { then_label, else_label, .. } => vec![then_label, else_label],
+                Terminator::Switch { cases, default, .. } => {
+                    cases.iter().map(|(_, l)| l).chain(std::iter::once(default)).collect()
+                }
+                Terminator::Return(_) | Terminator::Unreachable => vec![],
+            };
+            for t in targets {
+                if let Some(&j) = index.get(t.as_str())
+                    && !succs[i].contains(&j)
+                {
+                    succs[i].push(j);
+                    preds[j].push(i);
+                }
+            }
+        }
+        let idom = dominators(&succs, &preds);
+        Cfg { succs, preds, idom }
+    }
+
+    fn dominates(&self, a: usize, mut b: usize) -> bool {
+        loop {
+            if a == b {
+                return true;
+            }
+            match self.idom[b] {
+                Some(d) if d != b => b = d,
+                _ => return false,
+            }
+        }
+    }
+
+    /// Blocks in reverse postorder from the entry
+    fn reverse_postorder(&self) -> Vec<usize> {
+        reverse_postorder(&self.succs)
+    }
+}
+
+fn reverse_postorder(succs: &[Vec<usize>]) -> Vec<usize> {
+    if succs.is_empty() {
+        return Vec::new();
+    }
+    let mut visited = vec![false; succs.len()];
+    let mut post = Vec::with_capacity(succs.len());
+    let mut stack = vec![(0usize, 0usize)];
+    visited[0] = true;
+    while let Some((b, next)) = stack.pop() {
+        if let Some(&s) = succs[b].get(next) {
+            stack.push((b, next + 1));
+            if !visited[s] {
+                visited[s] = true;
+                stack.push((s, 0));
+            }
+        } else {
+            post.push(b);
+        }
+    }
+    post.reverse();
+    post
+}
+
+/// Cooper, Harvey and Kennedy's iterative dominator algorithm
+fn dominators(succs: &[Vec<usize>], preds: &[Vec<usize>]) -> Vec<Option<usize>> {
+    let rpo = reverse_postorder(succs);
+    let mut order = vec![usize::MAX; succs.len()];
+    for (i, &b) in rpo.iter().enumerate() {
+        order[b] = i;
+    }
+    let mut idom: Vec<Option<usize>> = vec![None; succs.len()];
+    if rpo.is_empty() {
+        return idom;
+    }
+    idom[0] = Some(0);
+    let intersect = |idom: &[Option<usize>], mut a: usize, mut b: usize| {
+        while a != b {
+            while order[a] > order[b] {
+                a = idom[a].expect("processed");
+            }
+            while order[b] > order[a] {
+                b = idom[b].expect("processed");
+            }
+        }
+        a
+    };
+    let mut changed = true;
+    while changed {
+        changed = false;
+        for &b in rpo.iter().skip(1) {
+            let mut new_idom = None;
+            for &p in &preds[b] {
+                if idom[p].is_some() {
+                    new_idom = Some(match new_idom {
+                        None => p,
+                        Some(cur) => intersect(&idom, p, cur),
+                    });
+                }
+            }
+            if new_idom.is_some() && idom[b] != new_idom {
+                idom[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+    idom
+}
+
+/// A natural loop
+struct Loop {
+    header: usize,
+    body: HashSet<usize>,
+    /// Single block outside the loop that ends in `goto header`
+    preheader: Option<usize>,
+    /// Blocks that can leave the loop (including by returning)
+    exits: Vec<usize>,
+}
+
+/// Natural loops of `func`, innermost first
+fn find_loops(func: &MirFunction, cfg: &Cfg) -> Vec<Loop> {
+    let mut bodies: HashMap<usize, HashSet<usize>> = HashMap::new();
+    for (tail, succs) in cfg.succs.iter().enumerate() {
+        for &header in succs {
+            if cfg.idom[tail].is_none() || !cfg.dominates(header, tail) {
+                continue;
+            }
+            let body = bodies.entry(header).or_insert_with(|| HashSet::from([header]));
+            let mut work = vec![tail];
+            while let Some(b) = work.pop() {
+                if body.insert(b) {
+                    work.extend(cfg.preds[b].iter().copied());
+                }
+            }
+        }
+    }
+
+    let mut loops: Vec<Loop> = bodies
+        .into_iter()
+        .map(|(header, body)| {
+            let outside: Vec<usize> = cfg.preds[header].iter().copied().filter(|p| !body.contains(p)).collect();
+            let preheader = match outside.as_slice() {
+                [p] if matches!(func.blocks[*p].terminator, Terminator::Goto(_)) => Some(*p),
+                _ => None,
+            };
+            let mut exits: Vec<usize> = body
+                .iter()
+                .copied()
+                .filter(|&b| {
+                    cfg.succs[b].is_empty() || cfg.succs[b].iter().any(|s| !body.contains(s))
+                })
+                .collect();
+            exits.sort_unstable();
+            Loop { header, body, preheader, exits }
+        })
+        .collect();
+    loops.sort_by_key(|l| (l.body.len(), l.header));
+    loops
+}
+
+/// Number of natural loops containing each block (by block index)
+pub(super) fn loop_depths(func: &MirFunction) -> Vec<usize> {
+    let cfg = Cfg::new(func);
+    let mut depths = vec![0; func.blocks.len()];
+    for lp in find_loops(func, &cfg) {
+        for &b in &lp.body {
+            depths[b] += 1;
+        }
+    }
+    depths
+}
+
+// ============================================================================
+// Def/use helpers
+// ============================================================================
+
+/// Places an instruction writes (stores count as writes to the aggregate)
+pub(super) fn written_place(inst: &MirInst) -> Option<&str> {
+    match inst {
+        MirInst::Const { dest, .. }
+        | MirInst::Copy { dest, .. }
+        | MirInst::BinOp { dest, .. }
+        | MirInst::UnaryOp { dest, .. }
+        | MirInst::Phi { dest, .. }
+        | MirInst::StructInit { dest, .. }
+        | MirInst::FieldAccess { dest, .. }
+        | MirInst::EnumVariant { dest, .. }
+        | MirInst::ArrayInit { dest, .. }
+        | MirInst::IndexLoad { dest, .. } => Some(&dest.name),
+        MirInst::Call { dest, .. } => dest.as_ref().map(|d| d.name.as_str()),
+        MirInst::FieldStore { base, .. } => Some(&base.name),
+        MirInst::IndexStore { array, .. } => Some(&array.name),
+    }
+}
+
+pub(super) fn read_places(inst: &MirInst) -> Vec<&str> {
+    fn op(o: &Operand) -> Option<&str> {
+        match o {
+            Operand::Place(p) => Some(&p.name),
+            Operand::Constant(_) => None,
+        }
+    }
+    match inst {
+        MirInst::Const { .. } => vec![],
+        MirInst::Copy { src, .. } => vec![&src.name],
+        MirInst::BinOp { lhs, rhs, .. } => [op(lhs), op(rhs)].into_iter().flatten().collect(),
+        MirInst::UnaryOp { src, .. } => op(src).into_iter().collect(),
+        MirInst::Call { args, .. } => args.iter().filter_map(op).collect(),
+        MirInst::Phi { values, .. } => values.iter().filter_map(|(v, _)| op(v)).collect(),
+        MirInst::StructInit { fields, .. } => fields.iter().filter_map(|(_, v)| op(v)).collect(),
+        MirInst::FieldAccess { base, .. } => vec![&base.name],
+        MirInst::FieldStore { base, value, .. } => std::iter::once(base.name.as_str()).chain(op(value)).collect(),
+        MirInst::EnumVariant { args, .. } => args.iter().filter_map(op).collect(),
+        MirInst::ArrayInit { elements, .. } => elements.iter().filter_map(op).collect(),
+        MirInst::IndexLoad { array, index, .. } => std::iter::once(array.name.as_str()).chain(op(index)).collect(),
+        MirInst::IndexStore { array, index, value } => {
+            std::iter::once(array.name.as_str()).chain(op(index)).chain(op(value)).collect()
+        }
+    }
+}
+
+pub(super) fn terminator_reads(term: &Terminator) -> Option<&str> {
+    match term {
+        Terminator::Return(Some(Operand::Place(p)))
+        | Terminator::Branch { cond: Operand::Place(p), .. }
+        | Terminator::Switch { discriminant: Operand::Place(p), .. } => Some(&p.name),
+        _ => None,
+    }
+}
+
+/// Number of writes to each place inside `body`
+fn loop_defs(func: &MirFunction, body: &HashSet<usize>) -> HashMap<String, usize> {
+    let mut defs = HashMap::new();
+    for &b in body {
+        for inst in &func.blocks[b].instructions {
+            if let Some(name) = written_place(inst) {
+                *defs.entry(name.to_string()).or_insert(0) += 1;
+            }
+        }
+    }
+    defs
+}
+
+// ============================================================================
+// Loop-Invariant Code Motion
+// ============================================================================
+
+/// Hoist loop-invariant computations into loop preheaders
+///
+/// Example:
+/// ```text
+/// while i < len(s) { ... }   // len(s) computed once before the loop
+/// ```
+pub struct LoopInvariantCodeMotion {
+    /// Functions marked @pure or @const (calls to them may be hoisted)
+    pure_functions: HashSet<String>,
+}
+
+impl LoopInvariantCodeMotion {
+    pub fn new(pure_functions: HashSet<String>) -> Self {
+        Self { pure_functions }
+    }
+
+    /// Create from a MirProgram by collecting all @pure functions
+    pub fn from_program(program: &MirProgram) -> Self {
+        Self::new(
+            program
+                .functions
+                .iter()
+                .filter(|f| f.is_pure || f.is_const)
+                .map(|f| f.name.clone())
+                .collect(),
+        )
+    }
+
+    /// Whether `inst` computes a value from its operands alone, and
+    /// whether evaluating it can fail
+    fn classify(&self, inst: &MirInst) -> Option<bool> {
+        match inst {
+            MirInst::Const { .. } | MirInst::Copy { .. } | MirInst::UnaryOp { .. } => Some(false),
+            MirInst::BinOp { op, .. } => Some(matches!(op, MirBinOp::Div | MirBinOp::Mod)),
+            MirInst::Call { dest: Some(_), func, .. } => {
+                if PURE_BUILTINS.contains(&func.as_str()) && !self.pure_functions.contains(func) {
+                    Some(false)
+                } else if self.pure_functions.contains(func) {
+                    // User functions may fail a contract or not terminate
+                    Some(true)
+                } else {
+                    None
+                }
+            }
+            _ => None,
+        }
+    }
+
+    /// Hoist what can be hoisted out of one loop; returns the count
+    fn hoist(&self, func: &mut MirFunction, cfg: &Cfg, lp: &Loop) -> usize {
+        let Some(preheader) = lp.preheader else { return 0 };
+        let mut defs = loop_defs(func, &lp.body);
+        let order: Vec<usize> = cfg.reverse_postorder().into_iter().filter(|b| lp.body.contains(b)).collect();
+        let dominates_exits = |b: usize| lp.exits.iter().all(|&e| cfg.dominates(b, e));
+        let mut hoisted = Vec::new();
+
+        loop {
+            let mut found = None;
+            'search: for &b in &order {
+                for (i, inst) in func.blocks[b].instructions.iter().enumerate() {
+                    let Some(may_trap) = self.classify(inst) else { continue };
+                    let Some(dest) = written_place(inst) else { continue };
+                    if defs.get(dest) != Some(&1)
+                        || read_places(inst).iter().any(|p| defs.contains_key(*p))
+                        || (may_trap && !dominates_exits(b))
+                        || !self.uses_allow_hoist(func, cfg, lp, dest, b, i, dominates_exits(b))
+                    {
+                        continue;
+                    }
+                    found = Some((b, i));
+                    break 'search;
+                }
+            }
+            let Some((b, i)) = found else { break };
+            let inst = func.blocks[b].instructions.remove(i);
+            if let Some(dest) = written_place(&inst) {
+                defs.remove(dest);
+            }
+            hoisted.push(inst);
+        }
+
+        let count = hoisted.len();
+        func.blocks[preheader].instructions.extend(hoisted);
+        count
+    }
+
+    /// Every read of `dest` must see the value defined at (`block`, `index`):
+    /// reads in the loop must come after it, and reads after the loop
+    /// require the definition to run before any exit
+    #[allow(clippy::too_many_arguments)]
+    fn uses_allow_hoist(
+        &self,
+        func: &MirFunction,
+        cfg: &Cfg,
+        lp: &Loop,
+        dest: &str,
+        block: usize,
+        index: usize,
+        runs_before_exit: bool,
+    ) -> bool {
+        let labels: HashMap<&str, usize> =
+            func.blocks.iter().enumerate().map(|(i, b)| (b.label.as_str(), i)).collect();
+        for (b, bb) in func.blocks.iter().enumerate() {
+            let in_loop = lp.body.contains(&b);
+            for (i, inst) in bb.instructions.iter().enumerate() {
+                // A phi reads its operand at the end of the incoming block
+                if let MirInst::Phi { values, .. } = inst {
+                    for (v, pred) in values {
+                        if matches!(v, Operand::Place(p) if p.name == dest) {
+                            let Some(&p) = labels.get(pred.as_str()) else { return false };
+                            if lp.body.contains(&p) {
+                                if !cfg.dominates(block, p) {
+                                    return false;
+                                }
+                            } else if !runs_before_exit {
+                                return false;
+                            }
+                        }
+                    }
+                    continue;
+                }
+                if !read_places(inst).contains(&dest) {
+                    continue;
+                }
+                if in_loop {
+                    let after = if b == block { i > index } else { cfg.dominates(block, b) };
+                    if !after {
+                        return false;
+                    }
+                } else if !runs_before_exit {
+                    return false;
+                }
+            }
+            if terminator_reads(&bb.terminator) == Some(dest) {
+                let ok = if in_loop { cfg.dominates(block, b) } else { runs_before_exit };
+                if !ok {
+                    return false;
+                }
+            }
+        }
+        true
+    }
+}
+
+impl OptimizationPass for LoopInvariantCodeMotion {
+    fn name(&self) -> &'static str {
+        "loop_invariant_code_motion"
+    }
+
+    fn run_on_function(&self, func: &mut MirFunction) -> bool {
+        self.run_counted(func) > 0
+    }
+
+    fn run_counted(&self, func: &mut MirFunction) -> usize {
+        let mut total = 0;
+        // Hoisting never changes the CFG, so one analysis serves every loop
+        let cfg = Cfg::new(func);
+        for lp in find_loops(func, &cfg) {
+            total += self.hoist(func, &cfg, &lp);
+        }
+        total
+    }
+}
+
+// ============================================================================
+// Induction Variable Strength Reduction
+// ============================================================================
+
+/// Replace multiplications of induction variables by running additions
+///
+/// Example:
+/// ```text
+/// for_body:  %off = mul %i, 8      =>   %off = copy %off_iv
+///            %i = add %i, 1              %i = add %i, 1
+///                                        %off_iv = add %off_iv, 8
+/// ```
+pub struct InductionVariableStrengthReduction;
+
+/// `i = i + step`, found at (`block`, `index`)
+struct BasicIv {
+    block: usize,
+    index: usize,
+    step: i64,
+}
+
+impl InductionVariableStrengthReduction {
+    /// Basic induction variables of a loop
+    fn basic_ivs(func: &MirFunction, lp: &Loop, defs: &HashMap<String, usize>) -> HashMap<String, BasicIv> {
+        let mut ivs = HashMap::new();
+        for &b in &lp.body {
+            let insts = &func.blocks[b].instructions;
+            for (i, inst) in insts.iter().enumerate() {
+                let iv = match inst {
+                    MirInst::BinOp { dest, op, lhs, rhs } => step_of(*op, lhs, rhs, &dest.name).map(|s| (&dest.name, s)),
+                    // `i = t` where `t = i + c` earlier in the block (the lowering of `i = i + c`)
+                    MirInst::Copy { dest, src } if defs.get(&src.name) == Some(&1) => insts[..i]
+                        .iter()
+                        .rev()
+                        .find_map(|prev| match prev {
+                            MirInst::BinOp { dest: t, op, lhs, rhs } if t.name == src.name => {
+                                step_of(*op, lhs, rhs, &dest.name)
+                            }
+                            _ => None,
+                        })
+                        .map(|s| (&dest.name, s)),
+                    _ => None,
+                };
+                if let Some((name, step)) = iv
+                    && defs.get(name) == Some(&1)
+                {
+                    ivs.insert(name.clone(), BasicIv { block: b, index: i, step });
+                }
+            }
+        }
+        ivs
+    }
+
+    fn reduce_one(func: &mut MirFunction, lp: &Loop) -> bool {
+        let Some(preheader) = lp.preheader else { return false };
+        let defs = loop_defs(func, &lp.body);
+        let ivs = Self::basic_ivs(func, lp, &defs);
+        if ivs.is_empty() {
+            return false;
+        }
+
+        let mut blocks: Vec<usize> = lp.body.iter().copied().collect();
+        blocks.sort_unstable();
+        for b in blocks {
+            for (i, inst) in func.blocks[b].instructions.iter().enumerate() {
+                let MirInst::BinOp { dest, op: MirBinOp::Mul | MirBinOp::MulWrap, lhs, rhs } = inst else { continue };
+                let (iv, factor) = match (lhs, rhs) {
+                    (Operand::Place(p), Operand::Constant(Constant::Int(k)))
+                    | (Operand::Constant(Constant::Int(k)), Operand::Place(p)) => (p, *k),
+                    _ => continue,
+                };
+                let Some(basic) = ivs.get(&iv.name) else { continue };
+                if defs.get(&dest.name) != Some(&1) || ivs.contains_key(&dest.name) {
+                    continue;
+                }
+                let ty = local_type(func, &dest.name);
+                let Some(bump) = basic.step.checked_mul(factor).filter(|c| fits(&ty, *c)) else { continue };
+
+                let dest = dest.clone();
+                let iv = iv.clone();
+                let (iv_block, iv_index) = (basic.block, basic.index);
+                let running = fresh_place(func, &format!("{}_iv", dest.name));
+                func.locals.push((running.name.clone(), ty));
+
+                func.blocks[preheader].instructions.push(MirInst::BinOp {
+                    dest: running.clone(),
+                    op: MirBinOp::Mul,
+                    lhs: Operand::Place(iv),
+                    rhs: Operand::Constant(Constant::Int(factor)),
+                });
+                func.blocks[b].instructions[i] = MirInst::Copy { dest, src: running.clone() };
+                func.blocks[iv_block].instructions.insert(
+                    iv_index + 1,
+                    MirInst::BinOp {
+                        dest: running.clone(),
+                        op: MirBinOp::Add,
+                        lhs: Operand::Place(running),
+                        rhs: Operand::Constant(Constant::Int(bump)),
+                    },
+                );
+                return true;
+            }
+        }
+        false
+    }
+}
+
+/// Step of `dest = iv ± c` when `iv` is `dest` itself
+fn step_of(op: MirBinOp, lhs: &Operand, rhs: &Operand, dest: &str) -> Option<i64> {
+    match (op, lhs, rhs) {
+        (MirBinOp::Add | MirBinOp::AddWrap, Operand::Place(p), Operand::Constant(Constant::Int(c)))
+        | (MirBinOp::Add | MirBinOp::AddWrap, Operand::Constant(Constant::Int(c)), Operand::Place(p))
+            if p.name == dest =>
+        {
+            Some(*c)
+        }
+        (MirBinOp::Sub | MirBinOp::SubWrap, Operand::Place(p), Operand::Constant(Constant::Int(c))) if p.name == dest => {
+            c.checked_neg()
+        }
+        _ => None,
+    }
+}
+
+fn local_type(func: &MirFunction, name: &str) -> MirType {
+    func.locals
+        .iter()
+        .chain(func.params.iter())
+        .find(|(n, _)| n == name)
+        .map_or(MirType::I64, |(_, t)| t.clone())
+}
+
+/// Whether constant `c` is representable in integer type `ty`
+fn fits(ty: &MirType, c: i64) -> bool {
+    match ty {
+        MirType::I32 => i32::try_from(c).is_ok(),
+        MirType::U32 => u32::try_from(c).is_ok(),
+        MirType::I64 | MirType::U64 => true,
+        _ => false,
+    }
+}
+
+pub(super) fn fresh_place(func: &MirFunction, base: &str) -> Place {
+    let taken = |n: &str| func.locals.iter().chain(func.params.iter()).any(|(l, _)| l == n);
+    let mut name = base.to_string();
+    let mut k = 1;
+    while taken(&name) {
+        name = format!("{}{}", base, k);
+        k += 1;
+    }
+    Place::new(name)
+}
+
+impl OptimizationPass for InductionVariableStrengthReduction {
+    fn name(&self) -> &'static str {
+        "induction_variable_strength_reduction"
+    }
+
+    fn run_on_function(&self, func: &mut MirFunction) -> bool {
+        self.run_counted(func) > 0
+    }
+
+    fn run_counted(&self, func: &mut MirFunction) -> usize {
+        let cfg = Cfg::new(func);
+        let loops = find_loops(func, &cfg);
+        let mut total = 0;
+        for lp in &loops {
+            while Self::reduce_one(func, lp) {
+                total += 1;
+            }
+        }
+        total
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::mir::test_util::{block, call, function, int, place, var};
+
+    fn bin(dest: &str, op: MirBinOp, lhs: Operand, rhs: Operand) -> MirInst {
+        MirInst::BinOp { dest: place(dest), op, lhs, rhs }
+    }
+
+    /// The lowering of
+    /// `var i = 0; var acc = 0; while i < len(s) { acc = acc + i * 8; i = i + 1 }; acc`
+    fn while_loop() -> MirFunction {
+        let locals: Vec<(&str, MirType)> =
+            ["i", "acc", "n", "c", "off", "t1", "t2"].iter().map(|&l| (l, MirType::I64)).collect();
+        let mut func = function(
+            "walk",
+            &[],
+            &locals,
+            vec![
+                block(
+                    "entry",
+                    vec![
+                        MirInst::Const { dest: place("i"), value: Constant::Int(0) },
+                        MirInst::Const { dest: place("acc"), value: Constant::Int(0) },
+                    ],
+                    Terminator::Goto("while_cond".into()),
+                ),
+                block(
+                    "while_cond",
+                    vec![
+                        call(Some("n"), "len", vec![var("s")]),
+                        bin("c", MirBinOp::Lt, var("i"), var("n")),
+                    ],
+                    Terminator::Branch { cond: var("c"), then_label: "while_body".into(), else_label: "while_exit".into() },
+                ),
+                block(
+                    "while_body",
+                    vec![
+                        bin("off", MirBinOp::Mul, var("i"), int(8)),
+                        bin("t1", MirBinOp::Add, var("acc"), var("off")),
+                        MirInst::Copy { dest: place("acc"), src: place("t1") },
+                        bin("t2", MirBinOp::Add, var("i"), int(1)),
+                        MirInst::Copy { dest: place("i"), src: place("t2") },
+                    ],
+                    Terminator::Goto("while_cond".into()),
+                ),
+                block("while_exit", vec![], Terminator::Return(Some(var("acc")))),
+            ],
+        );
+        func.params = vec![("s".to_string(), MirType::String)];
+        func
+    }
+
+    #[test]
+    fn test_find_natural_loop() {
+        let func = while_loop();
+        let cfg = Cfg::new(&func);
+        let loops = find_loops(&func, &cfg);
+        assert_eq!(loops.len(), 1);
+        assert_eq!(loops[0].header, 1);
+        assert_eq!(loops[0].body, HashSet::from([1, 2]));
+        assert_eq!(loops[0].preheader, Some(0));
+        assert_eq!(loops[0].exits, vec![1]);
+    }
+
+    #[test]
+    fn test_licm_hoists_pure_len() {
+        let mut func = while_loop();
+        let licm = LoopInvariantCodeMotion::new(HashSet::new());
+        assert_eq!(licm.run_counted(&mut func), 1);
+        assert!(matches!(
+            func.blocks[0].instructions.last(),
+            Some(MirInst::Call { func, .. }) if func == "len"
+        ));
+        assert_eq!(func.blocks[1].instructions.len(), 1);
+        // Nothing left to hoist: the body only touches loop variables
+        assert_eq!(licm.run_counted(&mut func), 0);
+    }
+
+    #[test]
+    fn test_licm_keeps_division_off_the_zero_trip_path() {
+        // `q = 100 / d` in the body would trap before the loop if hoisted
+        let mut func = while_loop();
+        func.params.push(("d".to_string(), MirType::I64));
+        func.blocks[2].instructions.insert(0, bin("q", MirBinOp::Div, int(100), var("d")));
+        func.blocks[2].instructions.insert(1, bin("r", MirBinOp::Add, int(1), var("d")));
+        let licm = LoopInvariantCodeMotion::new(HashSet::new());
+        assert_eq!(licm.run_counted(&mut func), 2);
+        let hoisted: Vec<&str> = func.blocks[0].instructions.iter().filter_map(written_place).collect();
+        assert!(hoisted.contains(&"r") && hoisted.contains(&"n"));
+        assert!(!hoisted.contains(&"q"));
+    }
+
+    #[test]
+    fn test_iv_strength_reduction() {
+        let mut func = while_loop();
+        assert_eq!(InductionVariableStrengthReduction.run_counted(&mut func), 1);
+        // Preheader seeds the running offset from i
+        assert!(matches!(
+            func.blocks[0].instructions.last(),
+            Some(MirInst::BinOp { dest, op: MirBinOp::Mul, .. }) if dest.name == "off_iv"
+        ));
+        let body = &func.blocks[2].instructions;
+        assert!(matches!(&body[0], MirInst::Copy { dest, src } if dest.name == "off" && src.name == "off_iv"));
+        assert!(matches!(
+            body.last(),
+            Some(MirInst::BinOp { dest, op: MirBinOp::Add, rhs: Operand::Constant(Constant::Int(8)), .. })
+                if dest.name == "off_iv"
+        ));
+        assert!(func.locals.iter().any(|(n, _)| n == "off_iv"));
+    }
+
+    #[test]
+    fn test_pipeline_reports_loop_hits() {
+        use crate::mir::OptimizationPipeline;
+
+        let mut pipeline = OptimizationPipeline::new();
+        pipeline.add_pass(Box::new(LoopInvariantCodeMotion::new(HashSet::new())));
+        pipeline.add_pass(Box::new(InductionVariableStrengthReduction));
+        let mut program = MirProgram { functions: vec![while_loop()], extern_fns: vec![] };
+        let stats = pipeline.optimize(&mut program);
+        assert_eq!(stats.hit_counts.get("loop_invariant_code_motion"), Some(&1));
+        assert_eq!(stats.hit_counts.get("induction_variable_strength_reduction"), Some(&1));
+        assert_eq!(stats.pass_counts.get("loop_invariant_code_motion"), Some(&1));
+    }
+}
@@ -5,8 +5,9 @@
 //! - Making control flow explicit through basic blocks
 //! - Converting operators based on operand types
 
-use crate::ast::{Attribute, BinOp, Expr, FnDef, Item, LiteralPattern, MatchArm, Pattern, Program, Spanned, Type, UnOp};
+use crate::ast::{Attribute, BinOp, Expr, FnDef, Item, MatchArm, Program, Spanned, Type, UnOp};
 
+use super::decision::{self, Access, Decision, Occurrence, Test as DecisionTest};
 use super::{
     CmpOp, Constant, ContractFact, LoweringContext, MirBinOp, MirExternFn, MirFunction, MirInst,
     MirProgram, MirType, MirUnaryOp, Operand, Place, Terminator,
@@ -19,7 +20,16 @@ pub fn lower_program(program: &Program) -> MirProgram {
     for item in &program.items {
         if let Item::FnDef(fn_def) = item {
             let ret_ty = ast_type_to_mir(&fn_def.ret_ty.node);
-            func_return_types.insert(fn_def.name.node.clone(), ret_ty);
+            func_return_types.insert(fn_def.name.node.to_string(), ret_ty);
+        }
+    }
+
+    // Enum tags are variant indices in declaration order
+    let mut enum_variants = std::collections::HashMap::new();
+    for item in &program.items {
+        if let Item::EnumDef(enum_def) = item {
+            let variants = enum_def.variants.iter().map(|v| v.name.node.clone()).collect();
+            enum_variants.insert(enum_def.name.node.clone(), variants);
         }
     }
 
@@ -27,7 +37,7 @@ pub fn lower_program(program: &Program) -> MirProgram {
         .items
         .iter()
         .filter_map(|item| match item {
-            Item::FnDef(fn_def) => Some(lower_function(fn_def, &func_return_types)),
+            Item::FnDef(fn_def) => Some(lower_function(fn_def, &func_return_types, &mut enum_variants)),
             // Type definitions, use statements, extern fns, traits, impl blocks, and type aliases don't produce MIR functions
             Item::StructDef(_) | Item::EnumDef(_) | Item::Use(_) | Item::ExternFn(_) |
             Item::TraitDef(_) | Item::ImplBlock(_) | Item::TypeAlias(_) => None,
@@ -89,8 +99,13 @@ fn extract_module_from_attrs(attrs: &[Attribute]) -> String {
 }
 
 /// Lower a function definition to MIR
-fn lower_function(fn_def: &FnDef, func_return_types: &std::collections::HashMap<String, MirType>) -> MirFunction {
+fn lower_function(
+    fn_def: &FnDef,
+    func_return_types: &std::collections::HashMap<String, MirType>,
+    enum_variants: &mut std::collections::HashMap<String, Vec<String>>,
+) -> MirFunction {
     let mut ctx = LoweringContext::new();
+    ctx.enum_variants = std::mem::take(enum_variants);
 
     // v0.35.4: Add user-defined function return types to context
     for (name, ty) in func_return_types {
@@ -103,8 +118,8 @@ fn lower_function(fn_def: &FnDef, func_return_types: &std::collections::HashMap<
         .iter()
         .map(|p| {
             let ty = ast_type_to_mir(&p.ty.node);
-            ctx.params.insert(p.name.node.clone(), ty.clone());
-            (p.name.node.clone(), ty)
+            ctx.params.insert(p.name.node.to_string(), ty.clone());
+            (p.name.node.to_string(), ty)
         })
         .collect();
 
@@ -118,17 +133,24 @@ fn lower_function(fn_def: &FnDef, func_return_types: &std::collections::HashMap<
 
     // Collect locals
     let locals: Vec<(String, MirType)> = ctx.locals.clone().into_iter().collect();
+    *enum_variants = std::mem::take(&mut ctx.enum_variants);
 
     // v0.38: Extract contract facts for optimization
     let preconditions = extract_contract_facts(fn_def.pre.as_ref());
-    let postconditions = extract_contract_facts(fn_def.post.as_ref());
+    let mut postconditions = extract_contract_facts(fn_def.post.as_ref());
+    // A named return value (`-> r: T`) is the same fact variable as `ret`
+    if let Some(ret_name) = &fn_def.ret_name {
+        for fact in &mut postconditions {
+            rename_fact_var(fact, &ret_name.node, "ret");
+        }
+    }
 
     // v0.38.3: Extract @pure and @const attributes
     let is_pure = has_attribute(&fn_def.attributes, "pure");
     let is_const = has_attribute(&fn_def.attributes, "const");
 
-    MirFunction {
-        name: fn_def.name.node.clone(),
+    let mut func = MirFunction {
+        name: fn_def.name.node.to_string(),
         params,
         ret_ty,
         locals,
@@ -137,7 +159,9 @@ fn lower_function(fn_def: &FnDef, func_return_types: &std::collections::HashMap<
         postconditions,
         is_pure,
         is_const,
-    }
+    };
+    lower_tail_calls(&mut func, func_return_types);
+    func
 }
 
 /// v0.38.3: Check if a function has a specific attribute
@@ -167,35 +191,81 @@ fn extract_facts_from_expr(expr: &Expr, facts: &mut Vec<ContractFact>) {
         Expr::Binary { op, left, right } => {
             if let Some(cmp_op) = binop_to_cmp_op(op) {
                 // Pattern: var op constant
-                if let (Expr::Var(var), Expr::IntLit(val)) = (&left.node, &right.node) {
+                if let (Some(var), Expr::IntLit(val)) = (fact_var(&left.node), &right.node) {
                     facts.push(ContractFact::VarCmp {
-                        var: var.clone(),
+                        var,
                         op: cmp_op,
                         value: *val,
                     });
                 }
                 // Pattern: constant op var (flip the comparison)
-                else if let (Expr::IntLit(val), Expr::Var(var)) = (&left.node, &right.node) {
+                else if let (Expr::IntLit(val), Some(var)) = (&left.node, fact_var(&right.node)) {
                     facts.push(ContractFact::VarCmp {
-                        var: var.clone(),
+                        var,
                         op: flip_cmp_op(cmp_op),
                         value: *val,
                     });
                 }
                 // Pattern: var op var
-                else if let (Expr::Var(lhs_var), Expr::Var(rhs_var)) = (&left.node, &right.node) {
+                else if let (Some(lhs), Some(rhs)) = (fact_var(&left.node), fact_var(&right.node)) {
                     facts.push(ContractFact::VarVarCmp {
-                        lhs: lhs_var.clone(),
+                        lhs,
                         op: cmp_op,
-                        rhs: rhs_var.clone(),
+                        rhs,
                     });
                 }
+                // Pattern: i < vec_len(v) / vec_len(v) > i
+                else if let Some(fact) = array_bounds_fact(&left.node, cmp_op, &right.node) {
+                    facts.push(fact);
+                }
             }
         }
         _ => {}
     }
 }
 
+/// Variable a fact can mention: a named variable, or `ret` in postconditions
+fn fact_var(expr: &Expr) -> Option<String> {
+    match expr {
+        Expr::Var(name) => Some(name.to_string()),
+        Expr::Ret => Some("ret".to_string()),
+        _ => None,
+    }
+}
+
+fn rename_fact_var(fact: &mut ContractFact, from: &str, to: &str) {
+    let vars = match fact {
+        ContractFact::VarCmp { var, .. } | ContractFact::NonNull { var } => vec![var],
+        ContractFact::VarVarCmp { lhs, rhs, .. } => vec![lhs, rhs],
+        ContractFact::ArrayBounds { index, array } => vec![index, array],
+    };
+    for var in vars {
+        if var == from {
+            *var = to.to_string();
+        }
+    }
+}
+
+/// Recognize `index < vec_len(array)` (or its flipped form) as an ArrayBounds fact
+fn array_bounds_fact(left: &Expr, op: CmpOp, right: &Expr) -> Option<ContractFact> {
+    let (index, len_call) = match op {
+        CmpOp::Lt => (left, right),
+        CmpOp::Gt => (right, left),
+        _ => return None,
+    };
+    if let (Expr::Var(index), Expr::Call { func, args }) = (index, len_call)
+        && func == "vec_len"
+        && let [arg] = args.as_slice()
+        && let Expr::Var(array) = &arg.node
+    {
+        return Some(ContractFact::ArrayBounds {
+            index: index.to_string(),
+            array: array.to_string(),
+        });
+    }
+    None
+}
+
 /// Convert BinOp to CmpOp
 fn binop_to_cmp_op(op: &BinOp) -> Option<CmpOp> {
     match op {
@@ -368,6 +438,9 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
                     });
                 }
                 Operand::Place(src) => {
+                    if let Some(&len) = ctx.array_lengths.get(&src.name) {
+                        ctx.array_lengths.insert(name.clone(), len);
+                    }
                     ctx.push_inst(MirInst::Copy {
                         dest: var_place,
                         src,
@@ -436,16 +509,29 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
         }
 
         Expr::Call { func, args } => {
-            // Lower arguments
-            let arg_ops: Vec<Operand> = args.iter().map(|arg| lower_expr(arg, ctx)).collect();
+            // Lower arguments; the function given to spawn / parallel_for is
+            // passed by address (the type checker made sure it names one)
+            let task_fn = super::race::task_fn_arg(func)
+                .filter(|_| !ctx.func_return_types.contains_key(func.as_str()));
+            let arg_ops: Vec<Operand> = args
+                .iter()
+                .enumerate()
+                .map(|(i, arg)| match &arg.node {
+                    Expr::Var(name) if task_fn == Some(i) => Operand::Constant(Constant::FnRef(name.to_string())),
+                    _ => lower_expr(arg, ctx),
+                })
+                .collect();
 
             // Check if this is a void function (runtime functions that return void)
-            let is_void_func = matches!(func.as_str(), "println" | "print" | "assert");
+            let is_void_func = matches!(
+                func.as_str(),
+                "println" | "print" | "assert" | "hashmap_free" | "hashset_free" | "strmap_free"
+            );
 
             if is_void_func {
                 ctx.push_inst(MirInst::Call {
                     dest: None,
-                    func: func.clone(),
+                    func: func.to_string(),
                     args: arg_ops,
                 });
                 Operand::Constant(Constant::Unit)
@@ -454,7 +540,7 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
 
                 // v0.35.4: Store return type for Call result
                 // v0.46: Also handle runtime functions with known return types
-                let ret_ty = if let Some(ty) = ctx.func_return_types.get(func) {
+                let ret_ty = if let Some(ty) = ctx.func_return_types.get(func.as_str()) {
                     ty.clone()
                 } else {
                     // Runtime functions with known return types
@@ -462,7 +548,8 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
                         // String-returning runtime functions
                         // v0.46: get_arg returns string (pointer to BmbString)
                         // v0.46: sb_build returns string (pointer to BmbString)
-                        "int_to_string" | "read_file" | "slice" | "digit_char" | "get_arg" | "sb_build" => MirType::String,
+                        "int_to_string" | "read_file" | "read_file_mapped" | "read_line" | "slice" | "digit_char"
+                        | "get_arg" | "sb_build" => MirType::String,
                         // i64-returning runtime functions
                         // v0.46: arg_count returns i64
                         "byte_at" | "len" | "strlen" | "cstr_byte_at" | "arg_count" => MirType::I64,
@@ -476,7 +563,7 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
 
                 ctx.push_inst(MirInst::Call {
                     dest: Some(dest.clone()),
-                    func: func.clone(),
+                    func: func.to_string(),
                     args: arg_ops,
                 });
                 Operand::Place(dest)
@@ -576,11 +663,13 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
 
             // Create destination for the enum value
             let dest = ctx.fresh_temp();
+            let discriminant = ctx.variant_discriminant(enum_name, variant);
 
             ctx.push_inst(MirInst::EnumVariant {
                 dest: dest.clone(),
                 enum_name: enum_name.clone(),
                 variant: variant.clone(),
+                discriminant,
                 args: mir_args,
             });
 
@@ -682,7 +771,7 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
         }
 
         Expr::Match { expr, arms } => {
-            // v0.19.2: Improved pattern matching with Switch terminator
+            // Arms are compiled into a decision tree (see `decision`)
             if arms.is_empty() {
                 return Operand::Constant(Constant::Unit);
             }
@@ -702,66 +791,7 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
                 }
             };
 
-            // Create labels for each arm and merge point
-            let arm_labels: Vec<String> = arms.iter()
-                .enumerate()
-                .map(|(i, _)| ctx.fresh_label(&format!("match_arm_{}", i)))
-                .collect();
-            let merge_label = ctx.fresh_label("match_merge");
-            let default_label = ctx.fresh_label("match_default");
-
-            // Analyze patterns to generate switch cases
-            let cases = compile_match_patterns(arms, &arm_labels, &default_label);
-
-            // Close current block with switch terminator
-            ctx.finish_block(Terminator::Switch {
-                discriminant: Operand::Place(match_place.clone()),
-                cases,
-                default: default_label.clone(),
-            });
-
-            // Result place for PHI node
-            let result_place = ctx.fresh_temp();
-            let mut phi_values: Vec<(Operand, String)> = Vec::new();
-
-            // Generate code for each arm
-            for (i, arm) in arms.iter().enumerate() {
-                ctx.start_block(arm_labels[i].clone());
-
-                // Bind pattern variables if needed
-                bind_pattern_variables(&arm.pattern.node, &match_place, ctx);
-
-                // Evaluate arm body
-                let arm_result = lower_expr(&arm.body, ctx);
-
-                // Store result for PHI
-                let arm_end_label = ctx.current_block_label().to_string();
-                phi_values.push((arm_result, arm_end_label));
-
-                // Jump to merge block
-                ctx.finish_block(Terminator::Goto(merge_label.clone()));
-            }
-
-            // Generate default block (unreachable for exhaustive matches)
-            ctx.start_block(default_label);
-            ctx.finish_block(Terminator::Unreachable);
-
-            // Generate merge block with PHI
-            ctx.start_block(merge_label);
-
-            // v0.46: Register PHI result type to ensure proper type inference
-            // Use the first arm's result type since all arms should have the same type
-            if let Some((first_result, _)) = phi_values.first() {
-                let phi_result_ty = ctx.operand_type(first_result);
-                ctx.locals.insert(result_place.name.clone(), phi_result_ty);
-            }
-
-            ctx.push_inst(MirInst::Phi {
-                dest: result_place.clone(),
-                values: phi_values,
-            });
-
-            Operand::Place(result_place)
+            lower_match(&match_place, arms, ctx)
         }
 
         // v0.5 Phase 5: References (simplified - just evaluate inner)
@@ -789,6 +819,7 @@ fn lower_expr(expr: &Spanned<Expr>, ctx: &mut LoweringContext) -> Operand {
             };
 
             let dest = ctx.fresh_temp();
+            ctx.array_lengths.insert(dest.name.clone(), mir_elements.len());
             ctx.push_inst(MirInst::ArrayInit {
                 dest: dest.clone(),
                 element_type,
@@ -1078,201 +1109,441 @@ fn ast_unop_to_mir(op: UnOp, ty: &MirType) -> MirUnaryOp {
     }
 }
 
-// v0.19.2: Pattern matching helper functions
-
-/// Compile match patterns to switch cases
-/// Returns a list of (discriminant_value, target_label) pairs
-fn compile_match_patterns(
-    arms: &[MatchArm],
-    arm_labels: &[String],
-    default_label: &str,
-) -> Vec<(i64, String)> {
-    let mut cases = Vec::new();
-    let mut has_wildcard = false;
+// ============================================================================
+// Match
+// ============================================================================
+
+/// Lower a match on `scrutinee` from its decision tree
+///
+/// Every tree node gets a block that loads the component it tests (once per
+/// path, and only once some arm needs it) and ends in the test. Each arm body
+/// is lowered once; the leaves that reach it bind its variables and jump to
+/// it, and the bodies meet at a phi.
+fn lower_match(scrutinee: &Place, arms: &[MatchArm], ctx: &mut LoweringContext) -> Operand {
+    let tree = decision::compile(arms, &mut |enum_name, variant| ctx.variant_discriminant(enum_name, variant));
+    let arm_labels: Vec<String> = arms.iter()
+        .enumerate()
+        .map(|(i, _)| ctx.fresh_label(&format!("match_arm_{}", i)))
+        .collect();
+    let merge_label = ctx.fresh_label("match_merge");
+    let default_label = ctx.fresh_label("match_default");
+
+    let mut emitter = MatchEmitter {
+        arms,
+        arm_labels,
+        default_label,
+        reached: vec![false; arms.len()],
+        failed: false,
+        pending: std::collections::VecDeque::new(),
+    };
+    let mut loaded = Loaded::new();
+    loaded.insert(Vec::new(), scrutinee.clone());
+    emitter.emit(&tree, loaded, ctx);
+    while let Some((label, node, loaded)) = emitter.pending.pop_front() {
+        ctx.start_block(label);
+        emitter.emit(node, loaded, ctx);
+    }
 
+    // Result place for PHI node
+    let result_place = ctx.fresh_temp();
+    let mut phi_values: Vec<(Operand, String)> = Vec::new();
     for (i, arm) in arms.iter().enumerate() {
-        match &arm.pattern.node {
-            Pattern::Literal(lit) => {
-                let value = match lit {
-                    LiteralPattern::Int(n) => *n,
-                    LiteralPattern::Bool(b) => if *b { 1 } else { 0 },
-                    LiteralPattern::Float(f) => *f as i64, // Lossy but necessary for switch
-                    LiteralPattern::String(_) => i as i64, // Use index as placeholder
-                };
-                cases.push((value, arm_labels[i].clone()));
+        if !emitter.reached[i] {
+            continue;
+        }
+        ctx.start_block(emitter.arm_labels[i].clone());
+        let arm_result = lower_expr(&arm.body, ctx);
+        let arm_end_label = ctx.current_block_label().to_string();
+        phi_values.push((arm_result, arm_end_label));
+        ctx.finish_block(Terminator::Goto(merge_label.clone()));
+    }
+
+    // Generate default block (unreachable for exhaustive matches)
+    if emitter.failed {
+        ctx.start_block(emitter.default_label);
+        ctx.finish_block(Terminator::Unreachable);
+    }
+
+    // Generate merge block with PHI
+    ctx.start_block(merge_label);
+
+    // v0.46: Register PHI result type to ensure proper type inference
+    // Use the first arm's result type since all arms should have the same type
+    if let Some((first_result, _)) = phi_values.first() {
+        let phi_result_ty = ctx.operand_type(first_result);
+        ctx.locals.insert(result_place.name.clone(), phi_result_ty);
+    }
+
+    ctx.push_inst(MirInst::Phi {
+        dest: result_place.clone(),
+        values: phi_values,
+    });
+
+    Operand::Place(result_place)
+}
+
+/// Places already holding components of the scrutinee on the current path
+type Loaded = std::collections::HashMap<Occurrence, Place>;
+
+/// Emits the blocks of a match decision tree
+struct MatchEmitter<'a> {
+    arms: &'a [MatchArm],
+    arm_labels: Vec<String>,
+    default_label: String,
+    /// Arms some leaf jumps to; the others are never lowered
+    reached: Vec<bool>,
+    /// Whether some path jumps to the unreachable default block
+    failed: bool,
+    /// Nodes that still need their block
+    pending: std::collections::VecDeque<(String, &'a Decision, Loaded)>,
+}
+
+impl<'a> MatchEmitter<'a> {
+    /// Label to jump to for `node`, queueing its block if it needs one
+    fn target(&mut self, node: &'a Decision, loaded: &Loaded, ctx: &mut LoweringContext) -> String {
+        match node {
+            Decision::Fail => {
+                self.failed = true;
+                self.default_label.clone()
             }
-            Pattern::EnumVariant { variant, .. } => {
-                // For enum variants, use a deterministic discriminant based on variant name
-                // In a real compiler, this would come from the type info
-                let disc = variant_to_discriminant(variant);
-                cases.push((disc, arm_labels[i].clone()));
+            Decision::Leaf { arm, bindings } if bindings.is_empty() => {
+                self.reached[*arm] = true;
+                self.arm_labels[*arm].clone()
             }
-            Pattern::Wildcard | Pattern::Var(_) => {
-                // Wildcard/var patterns catch all - they become the default case
-                // For now, only the last one can be the default
-                has_wildcard = true;
-                // Add a fallthrough to this arm for the default path
-                // We'll handle this by updating the default label
+            _ => {
+                let label = ctx.fresh_label("match_test");
+                self.pending.push_back((label.clone(), node, loaded.clone()));
+                label
             }
-            Pattern::Struct { .. } => {
-                // Struct patterns need field matching - for now, use index
-                cases.push((i as i64, arm_labels[i].clone()));
+        }
+    }
+
+    /// Emit `node` into the current block, which it finishes
+    fn emit(&mut self, node: &'a Decision, mut loaded: Loaded, ctx: &mut LoweringContext) {
+        match node {
+            Decision::Fail => ctx.finish_block(Terminator::Unreachable),
+            Decision::Leaf { arm, bindings } => {
+                bind_match_variables(bindings, &mut loaded, ctx);
+                self.reached[*arm] = true;
+                ctx.finish_block(Terminator::Goto(self.arm_labels[*arm].clone()));
             }
-            // v0.39: Range pattern
-            Pattern::Range { .. } => {
-                // Range patterns need runtime checks - for now, use index
-                cases.push((i as i64, arm_labels[i].clone()));
+            Decision::Guard { arm, bindings, otherwise } => {
+                bind_match_variables(bindings, &mut loaded, ctx);
+                let guard = self.arms[*arm].guard.as_ref().expect("guard nodes come from guarded arms");
+                let cond = lower_expr(guard, ctx);
+                self.reached[*arm] = true;
+                let then_label = self.arm_labels[*arm].clone();
+                let else_label = self.target(otherwise, &loaded, ctx);
+                ctx.finish_block(Terminator::Branch { cond, then_label, else_label });
             }
-            // v0.40: Or-pattern
-            Pattern::Or(_) => {
-                // Or-patterns need to try each alternative - for now, use index
-                cases.push((i as i64, arm_labels[i].clone()));
+            Decision::Switch { occurrence, cases, default } => {
+                let value = load_occurrence(occurrence, &mut loaded, ctx);
+                let cases = cases.iter()
+                    .map(|(key, node)| (*key, self.target(node, &loaded, ctx)))
+                    .collect();
+                let default = self.target(default, &loaded, ctx);
+                ctx.finish_block(Terminator::Switch {
+                    discriminant: Operand::Place(value),
+                    cases,
+                    default,
+                });
             }
-            // v0.41: Binding pattern - treated like the inner pattern for switching
-            Pattern::Binding { pattern, .. } => {
-                // Delegate to inner pattern's logic - for now, use index
-                match &pattern.node {
-                    Pattern::Wildcard | Pattern::Var(_) => {
-                        has_wildcard = true;
-                    }
-                    _ => {
-                        cases.push((i as i64, arm_labels[i].clone()));
+            Decision::Test { occurrence, test, then, otherwise } => {
+                let value = load_occurrence(occurrence, &mut loaded, ctx);
+                let then_label = self.target(then, &loaded, ctx);
+                let else_label = self.target(otherwise, &loaded, ctx);
+                let compare = |op: MirBinOp, rhs: Constant, ctx: &mut LoweringContext| {
+                    let dest = ctx.fresh_temp();
+                    ctx.locals.insert(dest.name.clone(), MirType::Bool);
+                    ctx.push_inst(MirInst::BinOp {
+                        dest: dest.clone(),
+                        op,
+                        lhs: Operand::Place(value.clone()),
+                        rhs: Operand::Constant(rhs),
+                    });
+                    Operand::Place(dest)
+                };
+                let cond = match test {
+                    DecisionTest::True => Operand::Place(value.clone()),
+                    DecisionTest::Int(n) => compare(MirBinOp::Eq, Constant::Int(*n), ctx),
+                    DecisionTest::Float(f) => compare(MirBinOp::FEq, Constant::Float(*f), ctx),
+                    DecisionTest::String(s) => compare(MirBinOp::Eq, Constant::String(s.clone()), ctx),
+                    DecisionTest::Range { start, end } => {
+                        let low = (*start > i64::MIN).then(|| compare(MirBinOp::Ge, Constant::Int(*start), ctx));
+                        let high = (*end < i64::MAX).then_some(Constant::Int(*end));
+                        match (low, high) {
+                            (Some(low), Some(high)) => {
+                                // Both bounds: test the upper one in a block of its own
+                                let upper_label = ctx.fresh_label("match_range");
+                                ctx.finish_block(Terminator::Branch {
+                                    cond: low,
+                                    then_label: upper_label.clone(),
+                                    else_label: else_label.clone(),
+                                });
+                                ctx.start_block(upper_label);
+                                compare(MirBinOp::Le, high, ctx)
+                            }
+                            (Some(low), None) => low,
+                            (None, Some(high)) => compare(MirBinOp::Le, high, ctx),
+                            (None, None) => {
+                                ctx.finish_block(Terminator::Goto(then_label));
+                                return;
+                            }
+                        }
                     }
-                }
-            }
-            // v0.42: Tuple pattern - use index for now
-            Pattern::Tuple(_) => {
-                cases.push((i as i64, arm_labels[i].clone()));
-            }
-            // v0.44: Array pattern - use index for now
-            Pattern::Array(_) => {
-                cases.push((i as i64, arm_labels[i].clone()));
-            }
-            // v0.45: Array rest pattern - use index for now
-            Pattern::ArrayRest { .. } => {
-                cases.push((i as i64, arm_labels[i].clone()));
+                };
+                ctx.finish_block(Terminator::Branch { cond, then_label, else_label });
             }
         }
     }
+}
 
-    // If we have a wildcard, we can still use the cases for non-wildcard matches
-    // The default path will go to unreachable or the wildcard arm
-    let _ = has_wildcard; // Silence unused warning for now
-    let _ = default_label;
-
-    cases
+/// Place holding `occurrence`, loading it and its parents where needed
+fn load_occurrence(occurrence: &Occurrence, loaded: &mut Loaded, ctx: &mut LoweringContext) -> Place {
+    if let Some(place) = loaded.get(occurrence) {
+        return place.clone();
+    }
+    let (access, parent) = occurrence.split_last().expect("the scrutinee itself is always loaded");
+    let base = load_occurrence(&parent.to_vec(), loaded, ctx);
+    let index = match access {
+        Access::Field(field) => {
+            let dest = ctx.fresh_temp();
+            ctx.push_inst(MirInst::FieldAccess { dest: dest.clone(), base, field: field.clone() });
+            loaded.insert(occurrence.clone(), dest.clone());
+            return dest;
+        }
+        Access::Index(i) => *i,
+        // The type checker only accepts rest patterns on fixed-size arrays,
+        // and arrays carry no length at run time
+        Access::FromEnd(k) => match ctx.array_length(&base) {
+            Some(n) => n - k,
+            None => panic!("array rest pattern on `{}`, an array whose length lowering lost track of", base.name),
+        },
+    };
+    let element_len = match ctx.operand_type(&Operand::Place(base.clone())) {
+        MirType::Array { element_type, .. } => match *element_type {
+            MirType::Array { size, .. } => size,
+            _ => None,
+        },
+        _ => None,
+    };
+    let dest = ctx.fresh_temp();
+    if let Some(len) = element_len {
+        ctx.array_lengths.insert(dest.name.clone(), len);
+    }
+    ctx.push_inst(MirInst::IndexLoad {
+        dest: dest.clone(),
+        array: base,
+        index: Operand::Constant(Constant::Int(index as i64)),
+    });
+    loaded.insert(occurrence.clone(), dest.clone());
+    dest
 }
 
-/// Convert variant name to discriminant value
-fn variant_to_discriminant(variant: &str) -> i64 {
-    // Simple hash-based discriminant for now
-    // In a full implementation, this would use the enum definition order
-    let mut hash: i64 = 0;
-    for (i, c) in variant.chars().enumerate() {
-        hash = hash.wrapping_add((c as i64).wrapping_mul((i + 1) as i64));
+/// Bind the variables of a matched arm to the components they name
+fn bind_match_variables(bindings: &[(String, Occurrence)], loaded: &mut Loaded, ctx: &mut LoweringContext) {
+    for (name, occurrence) in bindings {
+        let src = load_occurrence(occurrence, loaded, ctx);
+        // Register the variable type (infer from match place or default to i64)
+        let ty = ctx.operand_type(&Operand::Place(src.clone()));
+        ctx.locals.insert(name.clone(), ty);
+        ctx.push_inst(MirInst::Copy {
+            dest: Place::new(name.clone()),
+            src,
+        });
     }
-    hash
 }
 
-/// Bind pattern variables to values extracted from the match expression
-fn bind_pattern_variables(pattern: &Pattern, match_place: &Place, ctx: &mut LoweringContext) {
-    match pattern {
-        Pattern::Var(name) => {
-            // Create a copy instruction to bind the variable
-            let var_place = Place::new(name.clone());
-            ctx.push_inst(MirInst::Copy {
-                dest: var_place.clone(),
-                src: match_place.clone(),
-            });
-            // Register the variable type (infer from match place or default to i64)
-            if let Some(ty) = ctx.locals.get(&match_place.name).cloned() {
-                ctx.locals.insert(name.clone(), ty);
-            } else if let Some(ty) = ctx.params.get(&match_place.name).cloned() {
-                ctx.locals.insert(name.clone(), ty);
-            } else {
-                ctx.locals.insert(name.clone(), MirType::I64);
-            }
+// ============================================================================
+// Tail calls
+// ============================================================================
+
+/// Rewrite calls in tail position so they need no stack
+///
+/// A call is in tail position when its result flows unchanged to a
+/// `return`: directly, through copies, or through the phis of merge blocks
+/// that do nothing else. Self tail calls become a jump back to the start of
+/// the function with the parameters reassigned. Tail calls to other user
+/// functions get their own `return` right after the call, which the LLVM
+/// backend emits as `musttail`.
+fn lower_tail_calls(func: &mut MirFunction, user_fns: &std::collections::HashMap<String, MirType>) {
+    let sites: Vec<(usize, usize)> = (0..func.blocks.len())
+        .filter_map(|b| tail_call_in(func, b, user_fns).map(|k| (b, k)))
+        .collect();
+    if sites.is_empty() {
+        return;
+    }
+
+    let taken = |func: &MirFunction, name: &str| {
+        func.params.iter().chain(func.locals.iter()).any(|(n, _)| n == name)
+    };
+    let fresh = |func: &MirFunction, base: String| {
+        let mut name = base.clone();
+        let mut k = 1;
+        while taken(func, &name) {
+            name = format!("{}{}", base, k);
+            k += 1;
+        }
+        name
+    };
+
+    let loop_label = func.blocks[0].label.clone();
+    let mut self_calls = false;
+    let mut next_args: Vec<String> = Vec::new();
+
+    for (b, k) in sites {
+        let label = func.blocks[b].label.clone();
+        let Some(MirInst::Call { dest: Some(dest), func: callee, args }) =
+            func.blocks[b].instructions.get(k).cloned()
+        else {
+            continue;
+        };
+        // The copies forwarding the result are dead once this path returns
+        func.blocks[b].instructions.truncate(k + 1);
+        if let Terminator::Goto(merge) = &func.blocks[b].terminator {
+            let merge = merge.clone();
+            drop_phi_edges(func, &merge, &label);
         }
-        // v0.41: Nested patterns in enum bindings
-        Pattern::EnumVariant { bindings, .. } => {
-            // For enum variants with bindings, extract fields
-            for (i, binding) in bindings.iter().enumerate() {
-                let field_place = ctx.fresh_temp();
-                // Use field access to extract (simplified - real impl needs tag/data extraction)
-                ctx.push_inst(MirInst::FieldAccess {
-                    dest: field_place.clone(),
-                    base: match_place.clone(),
-                    field: format!("_{}", i), // Tuple-like access
+
+        if callee == func.name && args.len() == func.params.len() {
+            if next_args.is_empty() {
+                for (param, ty) in func.params.clone() {
+                    let name = fresh(func, format!("{}_next", param));
+                    func.locals.push((name.clone(), ty));
+                    next_args.push(name);
+                }
+            }
+            // Evaluate every argument before any parameter is overwritten
+            let block = &mut func.blocks[b];
+            block.instructions.pop();
+            for (arg, tmp) in args.into_iter().zip(&next_args) {
+                block.instructions.push(match arg {
+                    Operand::Constant(value) => MirInst::Const { dest: Place::new(tmp.clone()), value },
+                    Operand::Place(src) => MirInst::Copy { dest: Place::new(tmp.clone()), src },
                 });
-                // Recursively bind inner patterns
-                bind_pattern_variables(&binding.node, &field_place, ctx);
             }
-        }
-        Pattern::Struct { fields, .. } => {
-            // For struct patterns, bind field patterns
-            for (field_name, field_pattern) in fields {
-                let field_place = ctx.fresh_temp();
-                ctx.push_inst(MirInst::FieldAccess {
-                    dest: field_place.clone(),
-                    base: match_place.clone(),
-                    field: field_name.node.clone(),
+            for ((param, _), tmp) in func.params.iter().zip(&next_args) {
+                block.instructions.push(MirInst::Copy {
+                    dest: Place::new(param.clone()),
+                    src: Place::new(tmp.clone()),
                 });
-                // Recursively bind inner patterns
-                bind_pattern_variables(&field_pattern.node, &field_place, ctx);
             }
+            block.terminator = Terminator::Goto(loop_label.clone());
+            self_calls = true;
+        } else {
+            func.blocks[b].terminator = Terminator::Return(Some(Operand::Place(dest)));
         }
-        Pattern::Wildcard | Pattern::Literal(_) | Pattern::Range { .. } | Pattern::Or(_) => {
-            // No bindings for wildcards, literals, ranges, or or-patterns
-            // Note: Or-patterns with bindings would need special handling
+    }
+
+    if self_calls {
+        // Parameters become locals reassigned by each iteration; the
+        // incoming arguments are copied into them once on entry
+        let mut entry = Vec::new();
+        let params = std::mem::take(&mut func.params);
+        for (param, ty) in &params {
+            let arg = fresh(func, format!("{}_arg", param));
+            entry.push(MirInst::Copy { dest: Place::new(param.clone()), src: Place::new(arg.clone()) });
+            func.params.push((arg, ty.clone()));
         }
-        // v0.41: Binding pattern: name @ pattern
-        Pattern::Binding { name, pattern } => {
-            // Bind the name to the entire value
-            let binding_place = Place::new(name.clone());
-            ctx.push_inst(MirInst::Copy {
-                dest: binding_place.clone(),
-                src: match_place.clone(),
-            });
-            // Register the variable type
-            if let Some(ty) = ctx.locals.get(&match_place.name).cloned() {
-                ctx.locals.insert(name.clone(), ty);
-            } else if let Some(ty) = ctx.params.get(&match_place.name).cloned() {
-                ctx.locals.insert(name.clone(), ty);
-            } else {
-                ctx.locals.insert(name.clone(), MirType::I64);
-            }
-            // Recursively bind inner pattern
-            bind_pattern_variables(&pattern.node, match_place, ctx);
+        func.locals.extend(params);
+        let mut label = "tail_entry".to_string();
+        while func.blocks.iter().any(|b| b.label == label) {
+            label.push('_');
         }
-        // v0.42: Tuple pattern - bind each element
-        Pattern::Tuple(patterns) => {
-            for (i, elem_pattern) in patterns.iter().enumerate() {
-                // Create a place for tuple element access (synthesized name)
-                let elem_place = Place::new(format!("{}.{}", match_place.name, i));
-                bind_pattern_variables(&elem_pattern.node, &elem_place, ctx);
+        func.blocks.insert(
+            0,
+            super::BasicBlock { label, instructions: entry, terminator: Terminator::Goto(loop_label) },
+        );
+    }
+
+    remove_unreachable_blocks(func);
+}
+
+/// Index of the call in tail position at the end of block `b`, if any
+fn tail_call_in(
+    func: &MirFunction,
+    b: usize,
+    user_fns: &std::collections::HashMap<String, MirType>,
+) -> Option<usize> {
+    let insts = &func.blocks[b].instructions;
+    let k = insts.iter().rposition(|inst| matches!(inst, MirInst::Call { .. }))?;
+    let MirInst::Call { dest: Some(dest), func: callee, .. } = &insts[k] else { return None };
+    if !user_fns.contains_key(callee) {
+        return None;
+    }
+    let mut value = dest.name.as_str();
+    for inst in &insts[k + 1..] {
+        match inst {
+            MirInst::Copy { dest, src } if src.name == value => value = &dest.name,
+            _ => return None,
+        }
+    }
+    let already_returns = k + 1 == insts.len()
+        && matches!(&func.blocks[b].terminator, Terminator::Return(Some(Operand::Place(p))) if p.name == value);
+    if already_returns && callee != &func.name {
+        return None;
+    }
+    flows_to_return(func, b, value, 0).then_some(k)
+}
+
+/// Whether `value`, live at the end of block `b`, is returned unchanged
+fn flows_to_return(func: &MirFunction, b: usize, value: &str, depth: usize) -> bool {
+    match &func.blocks[b].terminator {
+        Terminator::Return(Some(Operand::Place(p))) => p.name == value,
+        Terminator::Goto(target) if depth < 64 => {
+            let Some(m) = func.blocks.iter().position(|blk| &blk.label == target) else { return false };
+            let from = &func.blocks[b].label;
+            let mut forwarded = None;
+            for inst in &func.blocks[m].instructions {
+                let MirInst::Phi { dest, values } = inst else { return false };
+                if values.iter().any(|(v, pred)| pred == from && matches!(v, Operand::Place(p) if p.name == value)) {
+                    forwarded = Some(dest.name.as_str());
+                }
             }
+            forwarded.is_some_and(|d| flows_to_return(func, m, d, depth + 1))
         }
-        // v0.44: Array pattern - bind each element
-        Pattern::Array(patterns) => {
-            for (i, elem_pattern) in patterns.iter().enumerate() {
-                // Create a place for array element access (synthesized name)
-                let elem_place = Place::new(format!("{}[{}]", match_place.name, i));
-                bind_pattern_variables(&elem_pattern.node, &elem_place, ctx);
+        _ => false,
+    }
+}
+
+/// Remove the phi entries of block `target` that come from `pred`
+fn drop_phi_edges(func: &mut MirFunction, target: &str, pred: &str) {
+    if let Some(block) = func.blocks.iter_mut().find(|b| b.label == target) {
+        for inst in &mut block.instructions {
+            if let MirInst::Phi { values, .. } = inst {
+                values.retain(|(_, from)| from != pred);
             }
         }
-        // v0.45: Array rest pattern - bind prefix and suffix elements
-        Pattern::ArrayRest { prefix, suffix } => {
-            // Bind prefix elements from the start
-            for (i, elem_pattern) in prefix.iter().enumerate() {
-                let elem_place = Place::new(format!("{}[{}]", match_place.name, i));
-                bind_pattern_variables(&elem_pattern.node, &elem_place, ctx);
+    }
+}
+
+/// Drop blocks no longer reachable from the entry, and their phi entries
+fn remove_unreachable_blocks(func: &mut MirFunction) {
+    let mut reachable = std::collections::HashSet::new();
+    let mut work = vec![func.blocks[0].label.clone()];
+    while let Some(label) = work.pop() {
+        if !reachable.insert(label.clone()) {
+            continue;
+        }
+        let Some(block) = func.blocks.iter().find(|b| b.label == label) else { continue };
+        match &block.terminator {
+            Terminator::Goto(t) => work.push(t.clone()),
+            Terminator::Branch { then_label, else_label, .. } => {
+                work.push(then_label.clone());
+                work.push(else_label.clone());
             }
-            // Bind suffix elements from the end (negative indexing conceptually)
-            // In MIR, we'd need to compute the actual indices at runtime based on array length
-            // For now, use symbolic suffix indices
-            for (i, elem_pattern) in suffix.iter().enumerate() {
-                let elem_place = Place::new(format!("{}[end-{}]", match_place.name, suffix.len() - i));
-                bind_pattern_variables(&elem_pattern.node, &elem_place, ctx);
+            Terminator::Switch { cases, default, .. } => {
+                work.extend(cases.iter().map(|(_, l)| l.clone()));
+                work.push(default.clone());
+            }
+            Terminator::Return(_) | Terminator::Unreachable => {}
+        }
+    }
+    func.blocks.retain(|b| reachable.contains(&b.label));
+    for block in &mut func.blocks {
+        for inst in &mut block.instructions {
+            if let MirInst::Phi { values, .. } = inst {
+                values.retain(|(_, from)| reachable.contains(from));
             }
         }
     }
@@ -1281,7 +1552,7 @@ fn bind_pattern_variables(pattern: &Pattern, match_place: &Place, ctx: &mut Lowe
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::ast::{Param, Span, Spanned, Visibility};
+    use crate::ast::{LiteralPattern, Param, Pattern, Span, Spanned, Visibility};
 
     fn spanned<T>(node: T) -> Spanned<T> {
         Spanned {
@@ -1297,15 +1568,15 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("add".to_string()),
+                name: spanned("add".into()),
                 type_params: vec![],
                 params: vec![
                     Param {
-                        name: spanned("a".to_string()),
+                        name: spanned("a".into()),
                         ty: spanned(Type::I64),
                     },
                     Param {
-                        name: spanned("b".to_string()),
+                        name: spanned("b".into()),
                         ty: spanned(Type::I64),
                     },
                 ],
@@ -1315,9 +1586,9 @@ mod tests {
                 post: None,
                 contracts: vec![],
                 body: spanned(Expr::Binary {
-                    left: Box::new(spanned(Expr::Var("a".to_string()))),
+                    left: Box::new(spanned(Expr::Var("a".into()))),
                     op: BinOp::Add,
-                    right: Box::new(spanned(Expr::Var("b".to_string()))),
+                    right: Box::new(spanned(Expr::Var("b".into()))),
                 }),
                 span: Span { start: 0, end: 0 },
             })],
@@ -1345,15 +1616,15 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("max".to_string()),
+                name: spanned("max".into()),
                 type_params: vec![],
                 params: vec![
                     Param {
-                        name: spanned("a".to_string()),
+                        name: spanned("a".into()),
                         ty: spanned(Type::I64),
                     },
                     Param {
-                        name: spanned("b".to_string()),
+                        name: spanned("b".into()),
                         ty: spanned(Type::I64),
                     },
                 ],
@@ -1364,12 +1635,12 @@ mod tests {
                 contracts: vec![],
                 body: spanned(Expr::If {
                     cond: Box::new(spanned(Expr::Binary {
-                        left: Box::new(spanned(Expr::Var("a".to_string()))),
+                        left: Box::new(spanned(Expr::Var("a".into()))),
                         op: BinOp::Gt,
-                        right: Box::new(spanned(Expr::Var("b".to_string()))),
+                        right: Box::new(spanned(Expr::Var("b".into()))),
                     })),
-                    then_branch: Box::new(spanned(Expr::Var("a".to_string()))),
-                    else_branch: Box::new(spanned(Expr::Var("b".to_string()))),
+                    then_branch: Box::new(spanned(Expr::Var("a".into()))),
+                    else_branch: Box::new(spanned(Expr::Var("b".into()))),
                 }),
                 span: Span { start: 0, end: 0 },
             })],
@@ -1395,7 +1666,7 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![],
                 ret_name: None,
@@ -1408,7 +1679,7 @@ mod tests {
                     mutable: false,
                     ty: None,
                     value: Box::new(spanned(Expr::IntLit(42))),
-                    body: Box::new(spanned(Expr::Var("x".to_string()))),
+                    body: Box::new(spanned(Expr::Var("x".into()))),
                 }),
                 span: Span { start: 0, end: 0 },
             })],
@@ -1429,7 +1700,7 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![],
                 ret_name: None,
@@ -1462,7 +1733,7 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![],
                 ret_name: None,
@@ -1494,7 +1765,7 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![],
                 ret_name: None,
@@ -1529,10 +1800,10 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![Param {
-                    name: spanned("p".to_string()),
+                    name: spanned("p".into()),
                     ty: spanned(Type::Named("Point".to_string())),
                 }],
                 ret_name: None,
@@ -1541,7 +1812,7 @@ mod tests {
                 post: None,
                 contracts: vec![],
                 body: spanned(Expr::FieldAccess {
-                    expr: Box::new(spanned(Expr::Var("p".to_string()))),
+                    expr: Box::new(spanned(Expr::Var("p".into()))),
                     field: spanned("x".to_string()),
                 }),
                 span: Span { start: 0, end: 0 },
@@ -1565,7 +1836,7 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![],
                 ret_name: None,
@@ -1599,7 +1870,7 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![],
                 ret_name: None,
@@ -1626,6 +1897,43 @@ mod tests {
         }));
     }
 
+    #[test]
+    fn test_lower_enum_discriminants_are_declaration_indices() {
+        // `Aa` and `BB` share a name hash; their tags must still differ
+        let construct = |variant: &str| spanned(Expr::EnumVariant {
+            enum_name: "Pair".to_string(),
+            variant: variant.to_string(),
+            args: vec![spanned(Expr::IntLit(1))],
+        });
+        let program = Program {
+            header: None,
+            items: vec![enum_def("Pair", &["Aa", "BB"]), Item::FnDef(FnDef {
+                attributes: vec![],
+                visibility: Visibility::Private,
+                name: spanned("test".into()),
+                type_params: vec![],
+                params: vec![],
+                ret_name: None,
+                ret_ty: spanned(Type::I64),
+                pre: None,
+                post: None,
+                contracts: vec![],
+                body: spanned(Expr::Block(vec![construct("BB"), construct("Aa")])),
+                span: Span { start: 0, end: 0 },
+            })],
+        };
+
+        let mir = lower_program(&program);
+        let tags: Vec<(&str, i64)> = mir.functions[0].blocks.iter()
+            .flat_map(|b| &b.instructions)
+            .filter_map(|inst| match inst {
+                MirInst::EnumVariant { variant, discriminant, .. } => Some((variant.as_str(), *discriminant)),
+                _ => None,
+            })
+            .collect();
+        assert_eq!(tags, vec![("BB", 1), ("Aa", 0)]);
+    }
+
     // v0.19.2: Pattern Matching MIR tests
     #[test]
     fn test_lower_match_literal() {
@@ -1636,10 +1944,10 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![Param {
-                    name: spanned("x".to_string()),
+                    name: spanned("x".into()),
                     ty: spanned(Type::I64),
                 }],
                 ret_name: None,
@@ -1648,7 +1956,7 @@ mod tests {
                 post: None,
                 contracts: vec![],
                 body: spanned(Expr::Match {
-                    expr: Box::new(spanned(Expr::Var("x".to_string()))),
+                    expr: Box::new(spanned(Expr::Var("x".into()))),
                     arms: vec![
                         MatchArm {
                             pattern: spanned(Pattern::Literal(LiteralPattern::Int(0))),
@@ -1696,10 +2004,10 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![Param {
-                    name: spanned("x".to_string()),
+                    name: spanned("x".into()),
                     ty: spanned(Type::I64),
                 }],
                 ret_name: None,
@@ -1708,13 +2016,13 @@ mod tests {
                 post: None,
                 contracts: vec![],
                 body: spanned(Expr::Match {
-                    expr: Box::new(spanned(Expr::Var("x".to_string()))),
+                    expr: Box::new(spanned(Expr::Var("x".into()))),
                     arms: vec![
                         MatchArm {
                             pattern: spanned(Pattern::Var("n".to_string())),
                             guard: None,
                             body: spanned(Expr::Binary {
-                                left: Box::new(spanned(Expr::Var("n".to_string()))),
+                                left: Box::new(spanned(Expr::Var("n".into()))),
                                 op: BinOp::Mul,
                                 right: Box::new(spanned(Expr::IntLit(2))),
                             }),
@@ -1740,6 +2048,189 @@ mod tests {
         assert!(has_copy);
     }
 
+    fn enum_pattern(variant: &str, bindings: Vec<Pattern>) -> Pattern {
+        Pattern::EnumVariant {
+            enum_name: "Option".to_string(),
+            variant: variant.to_string(),
+            bindings: bindings.into_iter().map(spanned).collect(),
+        }
+    }
+
+    /// `enum name { variants.. }`, each variant holding one i64
+    fn enum_def(name: &str, variants: &[&str]) -> Item {
+        Item::EnumDef(crate::ast::EnumDef {
+            attributes: vec![],
+            visibility: Visibility::Private,
+            name: spanned(name.to_string()),
+            type_params: vec![],
+            variants: variants.iter()
+                .map(|v| crate::ast::EnumVariant { name: spanned(v.to_string()), fields: vec![spanned(Type::I64)] })
+                .collect(),
+            span: Span { start: 0, end: 0 },
+        })
+    }
+
+    fn match_fn(arms: Vec<MatchArm>) -> Program {
+        Program {
+            header: None,
+            items: vec![enum_def("Option", &["None", "Some"]), Item::FnDef(FnDef {
+                attributes: vec![],
+                visibility: Visibility::Private,
+                name: spanned("test".into()),
+                type_params: vec![],
+                params: vec![Param {
+                    name: spanned("x".into()),
+                    ty: spanned(Type::I64),
+                }],
+                ret_name: None,
+                ret_ty: spanned(Type::I64),
+                pre: None,
+                post: None,
+                contracts: vec![],
+                body: spanned(Expr::Match {
+                    expr: Box::new(spanned(Expr::Var("x".into()))),
+                    arms,
+                }),
+                span: Span { start: 0, end: 0 },
+            })],
+        }
+    }
+
+    #[test]
+    fn test_lower_match_nested_enum() {
+        let arm = |pattern, body| MatchArm { pattern: spanned(pattern), guard: None, body: spanned(body) };
+        // Some(Some(v)) => v, Some(None) => 1, None => 0
+        let program = match_fn(vec![
+            arm(enum_pattern("Some", vec![enum_pattern("Some", vec![Pattern::Var("v".to_string())])]),
+                Expr::Var("v".into())),
+            arm(enum_pattern("Some", vec![enum_pattern("None", vec![])]), Expr::IntLit(1)),
+            arm(enum_pattern("None", vec![]), Expr::IntLit(0)),
+        ]);
+        let func = &lower_program(&program).functions[0];
+        let loads: Vec<(&str, &str, i64)> = func.blocks.iter()
+            .flat_map(|b| &b.instructions)
+            .filter_map(|inst| match inst {
+                MirInst::IndexLoad { dest, array, index: Operand::Constant(Constant::Int(i)) } => {
+                    Some((dest.name.as_str(), array.name.as_str(), *i))
+                }
+                _ => None,
+            })
+            .collect();
+
+        // The entry block switches on the tag in word 0 of the scrutinee
+        let Terminator::Switch { discriminant: Operand::Place(tag), cases, .. } = &func.blocks[0].terminator else {
+            panic!("expected a switch, got {:?}", func.blocks[0].terminator);
+        };
+        assert!(loads.contains(&(tag.name.as_str(), "x", 0)));
+        let keys: Vec<i64> = cases.iter().map(|(k, _)| *k).collect();
+        // Tags are declaration indices: `Option` declares `None` before `Some`
+        assert_eq!(keys, vec![1, 0]);
+
+        // The payload is loaded once and its tag switched on once
+        let payload = loads.iter().find(|(_, a, i)| *a == "x" && *i == 1).expect("payload load").0;
+        assert_eq!(loads.iter().filter(|(_, a, _)| *a == payload).count(), 2, "{:?}", loads);
+        let switches = func.blocks.iter().filter(|b| matches!(b.terminator, Terminator::Switch { .. })).count();
+        assert_eq!(switches, 2);
+
+        // `v` is bound from the inner payload and each arm body lowered once
+        let inner = loads.iter().find(|(_, a, i)| *a == payload && *i == 1).expect("inner payload load").0;
+        assert!(func.blocks.iter().flat_map(|b| &b.instructions).any(|inst| {
+            matches!(inst, MirInst::Copy { dest, src } if dest.name == "v" && src.name == inner)
+        }));
+        assert_eq!(func.blocks.iter().filter(|b| b.label.starts_with("match_arm_")).count(), 3);
+    }
+
+    #[test]
+    fn test_lower_match_guard_falls_through() {
+        // n if n > 10 => 1, 0 => 2, _ => 3
+        let program = match_fn(vec![
+            MatchArm {
+                pattern: spanned(Pattern::Var("n".to_string())),
+                guard: Some(spanned(Expr::Binary {
+                    left: Box::new(spanned(Expr::Var("n".into()))),
+                    op: BinOp::Gt,
+                    right: Box::new(spanned(Expr::IntLit(10))),
+                })),
+                body: spanned(Expr::IntLit(1)),
+            },
+            MatchArm {
+                pattern: spanned(Pattern::Literal(LiteralPattern::Int(0))),
+                guard: None,
+                body: spanned(Expr::IntLit(2)),
+            },
+            MatchArm { pattern: spanned(Pattern::Wildcard), guard: None, body: spanned(Expr::IntLit(3)) },
+        ]);
+        let func = &lower_program(&program).functions[0];
+
+        // The guard is tested first; when it fails the literal is switched on
+        let Terminator::Branch { then_label, else_label, .. } = &func.blocks[0].terminator else {
+            panic!("expected the guard's branch, got {:?}", func.blocks[0].terminator);
+        };
+        assert!(then_label.starts_with("match_arm_0"));
+        let fallback = func.blocks.iter().find(|b| &b.label == else_label).unwrap();
+        let Terminator::Switch { cases, default, .. } = &fallback.terminator else {
+            panic!("expected a switch, got {:?}", fallback.terminator);
+        };
+        assert_eq!(cases.len(), 1);
+        assert!(cases[0].1.starts_with("match_arm_1") && default.starts_with("match_arm_2"));
+        // Nothing is left for an unreachable default
+        assert!(!func.blocks.iter().any(|b| b.label.starts_with("match_default")));
+    }
+
+    #[test]
+    fn test_lower_match_array_rest_suffix_index() {
+        // let xs = [1, 2, 3]; match xs { [a, .., b] => a + b }
+        let var = |name: &str| spanned(Pattern::Var(name.to_string()));
+        let arm = MatchArm {
+            pattern: spanned(Pattern::ArrayRest { prefix: vec![var("a")], suffix: vec![var("b")] }),
+            guard: None,
+            body: spanned(Expr::Binary {
+                left: Box::new(spanned(Expr::Var("a".into()))),
+                op: BinOp::Add,
+                right: Box::new(spanned(Expr::Var("b".into()))),
+            }),
+        };
+        let program = Program {
+            header: None,
+            items: vec![Item::FnDef(FnDef {
+                attributes: vec![],
+                visibility: Visibility::Private,
+                name: spanned("test".into()),
+                type_params: vec![],
+                params: vec![],
+                ret_name: None,
+                ret_ty: spanned(Type::I64),
+                pre: None,
+                post: None,
+                contracts: vec![],
+                body: spanned(Expr::Let {
+                    name: "xs".to_string(),
+                    mutable: false,
+                    ty: None,
+                    value: Box::new(spanned(Expr::ArrayLit((1..=3).map(|n| spanned(Expr::IntLit(n))).collect()))),
+                    body: Box::new(spanned(Expr::Match {
+                        expr: Box::new(spanned(Expr::Var("xs".into()))),
+                        arms: vec![arm],
+                    })),
+                }),
+                span: Span { start: 0, end: 0 },
+            })],
+        };
+
+        // `b` is element 2, the last of the literal's three
+        let func = &lower_program(&program).functions[0];
+        let indices: Vec<i64> = func.blocks.iter()
+            .flat_map(|b| &b.instructions)
+            .filter_map(|inst| match inst {
+                MirInst::IndexLoad { array, index: Operand::Constant(Constant::Int(i)), .. } if array.name == "xs" => {
+                    Some(*i)
+                }
+                _ => None,
+            })
+            .collect();
+        assert_eq!(indices, vec![0, 2]);
+    }
+
     // v0.19.3: Array MIR tests
     #[test]
     fn test_lower_array_init() {
@@ -1748,7 +2239,7 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![],
                 ret_name: None,
@@ -1781,10 +2272,10 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![Param {
-                    name: spanned("arr".to_string()),
+                    name: spanned("arr".into()),
                     ty: spanned(Type::Array(Box::new(Type::I64), 3)), // [i64; 3]
                 }],
                 ret_name: None,
@@ -1793,7 +2284,7 @@ mod tests {
                 post: None,
                 contracts: vec![],
                 body: spanned(Expr::Index {
-                    expr: Box::new(spanned(Expr::Var("arr".to_string()))),
+                    expr: Box::new(spanned(Expr::Var("arr".into()))),
                     index: Box::new(spanned(Expr::IntLit(0))),
                 }),
                 span: Span { start: 0, end: 0 },
@@ -1817,10 +2308,10 @@ mod tests {
             items: vec![Item::FnDef(FnDef {
                 attributes: vec![],
                 visibility: Visibility::Private,
-                name: spanned("test".to_string()),
+                name: spanned("test".into()),
                 type_params: vec![],
                 params: vec![Param {
-                    name: spanned("obj".to_string()),
+                    name: spanned("obj".into()),
                     ty: spanned(Type::I64), // Simplified for testing
                 }],
                 ret_name: None,
@@ -1829,7 +2320,7 @@ mod tests {
                 post: None,
                 contracts: vec![],
                 body: spanned(Expr::MethodCall {
-                    receiver: Box::new(spanned(Expr::Var("obj".to_string()))),
+                    receiver: Box::new(spanned(Expr::Var("obj".into()))),
                     method: "double".to_string(),
                     args: vec![spanned(Expr::IntLit(10))],
                 }),
@@ -1847,4 +2338,108 @@ mod tests {
         });
         assert!(has_call, "Expected Call instruction for method 'double' with 2 args");
     }
+
+    fn tail_fn(name: &str, params: &[&str], body: Expr) -> Item {
+        Item::FnDef(FnDef {
+            attributes: vec![],
+            visibility: Visibility::Private,
+            name: spanned(name.into()),
+            type_params: vec![],
+            params: params
+                .iter()
+                .map(|p| Param { name: spanned(crate::ast::Symbol::intern(p)), ty: spanned(Type::I64) })
+                .collect(),
+            ret_name: None,
+            ret_ty: spanned(Type::I64),
+            pre: None,
+            post: None,
+            contracts: vec![],
+            body: spanned(body),
+            span: Span { start: 0, end: 0 },
+        })
+    }
+
+    fn var(name: &str) -> Box<Spanned<Expr>> {
+        Box::new(spanned(Expr::Var(name.into())))
+    }
+
+    fn minus_one(name: &str) -> Spanned<Expr> {
+        spanned(Expr::Binary { left: var(name), op: BinOp::Sub, right: Box::new(spanned(Expr::IntLit(1))) })
+    }
+
+    fn is_zero(name: &str) -> Box<Spanned<Expr>> {
+        Box::new(spanned(Expr::Binary { left: var(name), op: BinOp::Eq, right: Box::new(spanned(Expr::IntLit(0))) }))
+    }
+
+    #[test]
+    fn test_self_tail_call_becomes_loop() {
+        // fn sum(n, acc) = if n == 0 { acc } else { sum(n - 1, acc + n) }
+        let program = Program {
+            header: None,
+            items: vec![tail_fn(
+                "sum",
+                &["n", "acc"],
+                Expr::If {
+                    cond: is_zero("n"),
+                    then_branch: var("acc"),
+                    else_branch: Box::new(spanned(Expr::Call {
+                        func: "sum".into(),
+                        args: vec![
+                            minus_one("n"),
+                            spanned(Expr::Binary { left: var("acc"), op: BinOp::Add, right: var("n") }),
+                        ],
+                    })),
+                },
+            )],
+        };
+
+        let mir = lower_program(&program);
+        let func = &mir.functions[0];
+        let calls = func.blocks.iter().flat_map(|b| &b.instructions).filter(|i| matches!(i, MirInst::Call { .. }));
+        assert_eq!(calls.count(), 0);
+
+        // Arguments arrive in fresh parameters and are copied into the loop variables
+        let names: Vec<&str> = func.params.iter().map(|(n, _)| n.as_str()).collect();
+        assert_eq!(names, ["n_arg", "acc_arg"]);
+        assert!(func.locals.iter().any(|(n, _)| n == "n") && func.locals.iter().any(|(n, _)| n == "acc"));
+        assert_eq!(func.blocks[0].label, "tail_entry");
+        assert!(matches!(&func.blocks[0].terminator, Terminator::Goto(l) if l == "entry"));
+        assert!(func.blocks.iter().any(|b| matches!(&b.terminator, Terminator::Goto(l) if l == "entry")
+            && b.label != "tail_entry"));
+
+        // The merge phi only keeps the base-case edge
+        let phi = func.blocks.iter().flat_map(|b| &b.instructions).find_map(|i| match i {
+            MirInst::Phi { values, .. } => Some(values.len()),
+            _ => None,
+        });
+        assert_eq!(phi, Some(1));
+    }
+
+    #[test]
+    fn test_mutual_tail_call_returns_directly() {
+        let parity = |name: &str, other: &str, base: i64| {
+            tail_fn(
+                name,
+                &["n"],
+                Expr::If {
+                    cond: is_zero("n"),
+                    then_branch: Box::new(spanned(Expr::IntLit(base))),
+                    else_branch: Box::new(spanned(Expr::Call { func: other.into(), args: vec![minus_one("n")] })),
+                },
+            )
+        };
+        let program = Program { header: None, items: vec![parity("even", "odd", 1), parity("odd", "even", 0)] };
+
+        let mir = lower_program(&program);
+        let even = &mir.functions[0];
+        let call_block = even
+            .blocks
+            .iter()
+            .find(|b| matches!(b.instructions.last(), Some(MirInst::Call { func, .. }) if func == "odd"))
+            .expect("call to odd");
+        let Some(MirInst::Call { dest: Some(dest), .. }) = call_block.instructions.last() else { unreachable!() };
+        assert!(matches!(&call_block.terminator, Terminator::Return(Some(Operand::Place(p))) if p.name == dest.name));
+        // Parameters of functions without self tail calls are left alone
+        assert_eq!(even.params[0].0, "n");
+    }
 }
@@ -12,9 +12,25 @@
 //! - Dead code elimination
 //! - Common subexpression elimination
 //! - Contract-based optimizations (BMB-specific)
-
+//!
+//! The `loops` module adds loop-invariant code motion and induction
+//! variable strength reduction over natural loops of the CFG, and the
+//! `inline` module a cost-model driven inliner for small functions.
+//! `escape` replaces boxes, structs and vectors that never leave their
+//! function by scalars or stack storage.
+//! `decision` compiles `match` arms into a decision tree for lowering.
+//! `race` checks that functions run on the runtime thread pool by `spawn`
+//! and `parallel_for` cannot race.
+
+mod decision;
+mod escape;
+mod inline;
+mod loops;
 mod lower;
 mod optimize;
+pub mod race;
+#[cfg(test)]
+pub(crate) mod test_util;
 
 pub use lower::lower_program;
 pub use optimize::{
@@ -23,9 +39,14 @@ pub use optimize::{
     CopyPropagation, CommonSubexpressionElimination, ContractBasedOptimization,
     ContractUnreachableElimination, PureFunctionCSE, ConstFunctionEval,
 };
+pub use escape::EscapeAnalysis;
+pub use inline::FunctionInlining;
+pub use loops::{InductionVariableStrengthReduction, LoopInvariantCodeMotion};
 
 use std::collections::HashMap;
 
+use serde::{Deserialize, Serialize};
+
 /// A MIR program containing all functions
 #[derive(Debug, Clone)]
 pub struct MirProgram {
@@ -49,7 +70,7 @@ pub struct MirExternFn {
 }
 
 /// A MIR function with explicit control flow
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct MirFunction {
     /// Function name
     pub name: String,
@@ -76,7 +97,7 @@ pub struct MirFunction {
 
 /// v0.38: A proven fact from a contract condition
 /// Used by ContractBasedOptimization to eliminate redundant checks
-#[derive(Debug, Clone, PartialEq, Eq)]
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
 pub enum ContractFact {
     /// Variable comparison: var op constant (e.g., x >= 0)
     VarCmp {
@@ -102,7 +123,7 @@ pub enum ContractFact {
 }
 
 /// Comparison operator for contract facts
-#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
 pub enum CmpOp {
     Lt,  // <
     Le,  // <=
@@ -113,7 +134,7 @@ pub enum CmpOp {
 }
 
 /// A basic block containing instructions and a terminator
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct BasicBlock {
     /// Block label (unique within function)
     pub label: String,
@@ -124,7 +145,7 @@ pub struct BasicBlock {
 }
 
 /// MIR instruction (non-terminating)
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum MirInst {
     /// Assign a constant to a place: %dest = const value
     Const {
@@ -183,6 +204,8 @@ pub enum MirInst {
         dest: Place,
         enum_name: String,
         variant: String,
+        /// Tag stored in word 0: the variant's index in its enum's declaration
+        discriminant: i64,
         args: Vec<Operand>,
     },
     /// v0.19.3: Array initialization with literal elements: %dest = [elem1, elem2, ...]
@@ -206,7 +229,7 @@ pub enum MirInst {
 }
 
 /// Block terminator (control flow)
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum Terminator {
     /// Return from function: return %value or return
     Return(Option<Operand>),
@@ -230,7 +253,7 @@ pub enum Terminator {
 }
 
 /// An operand in MIR (either a place or constant)
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum Operand {
     /// Reference to a place (variable/temporary)
     Place(Place),
@@ -239,7 +262,7 @@ pub enum Operand {
 }
 
 /// A place represents a memory location (variable or temporary)
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Place {
     pub name: String,
 }
@@ -251,7 +274,7 @@ impl Place {
 }
 
 /// Constant value
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub enum Constant {
     Int(i64),
     Float(f64),
@@ -260,10 +283,12 @@ pub enum Constant {
     /// Character constant (v0.64)
     Char(char),
     Unit,
+    /// Address of a top-level function, passed to `spawn`/`parallel_for`
+    FnRef(String),
 }
 
 /// MIR binary operators
-#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
 pub enum MirBinOp {
     // Integer arithmetic
     Add,
@@ -350,7 +375,7 @@ impl MirBinOp {
 }
 
 /// MIR unary operators
-#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
 pub enum MirUnaryOp {
     /// Integer negation
     Neg,
@@ -376,7 +401,7 @@ impl MirUnaryOp {
 }
 
 /// MIR type system (simplified from AST types)
-#[derive(Debug, Clone, PartialEq, Eq)]
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
 pub enum MirType {
     I32,
     I64,
@@ -437,6 +462,11 @@ pub struct LoweringContext {
     pub params: HashMap<String, MirType>,
     /// v0.35.4: Function return types for Call type inference
     pub func_return_types: HashMap<String, MirType>,
+    /// Variant names of each enum in declaration order, which gives their tags
+    pub enum_variants: HashMap<String, Vec<String>>,
+    /// Lengths of arrays whose type lowering does not track: array literal
+    /// temps, the variables bound to them and arrays loaded out of arrays
+    pub array_lengths: HashMap<String, usize>,
 }
 
 impl LoweringContext {
@@ -467,9 +497,32 @@ impl LoweringContext {
             locals: HashMap::new(),
             params: HashMap::new(),
             func_return_types,
+            enum_variants: HashMap::new(),
+            array_lengths: HashMap::new(),
         }
     }
 
+    /// Length of the fixed-size array at `place`, if lowering knows it
+    pub fn array_length(&self, place: &Place) -> Option<usize> {
+        match self.operand_type(&Operand::Place(place.clone())) {
+            MirType::Array { size: Some(n), .. } => Some(n),
+            _ => self.array_lengths.get(&place.name).copied(),
+        }
+    }
+
+    /// Tag of `enum_name::variant`: its index in the enum's declaration
+    ///
+    /// Variants of an enum the program does not declare (one imported from
+    /// another module) are numbered in the order lowering first meets them.
+    pub fn variant_discriminant(&mut self, enum_name: &str, variant: &str) -> i64 {
+        let variants = self.enum_variants.entry(enum_name.to_string()).or_default();
+        let index = variants.iter().position(|v| v == variant).unwrap_or_else(|| {
+            variants.push(variant.to_string());
+            variants.len() - 1
+        });
+        index as i64
+    }
+
     /// Generate a fresh temporary name
     pub fn fresh_temp(&mut self) -> Place {
         let name = format!("_t{}", self.temp_counter);
@@ -521,6 +574,8 @@ impl LoweringContext {
                 // v0.64: Character type
                 Constant::Char(_) => MirType::Char,
                 Constant::Unit => MirType::Unit,
+                // Function addresses are pointer-sized, like other handles
+                Constant::FnRef(_) => MirType::I64,
             },
             Operand::Place(p) => {
                 if let Some(ty) = self.locals.get(&p.name) {
@@ -636,12 +691,12 @@ fn format_mir_inst(inst: &MirInst) -> String {
         MirInst::FieldStore { base, field, value } => {
             format!("%{}.{} = {}", base.name, field, format_operand(value))
         }
-        MirInst::EnumVariant { dest, enum_name, variant, args } => {
+        MirInst::EnumVariant { dest, enum_name, variant, discriminant, args } => {
             if args.is_empty() {
-                format!("%{} = enum-variant {}::{} 0", dest.name, enum_name, variant)
+                format!("%{} = enum-variant {}::{} {}", dest.name, enum_name, variant, discriminant)
             } else {
                 let args_str: Vec<_> = args.iter().map(format_operand).collect();
-                format!("%{} = enum-variant {}::{} 1 {}", dest.name, enum_name, variant, args_str.join(", "))
+                format!("%{} = enum-variant {}::{} {} {}", dest.name, enum_name, variant, discriminant, args_str.join(", "))
             }
         }
         MirInst::ArrayInit { dest, element_type: _, elements } => {
@@ -694,6 +749,7 @@ fn format_constant(c: &Constant) -> String {
         // v0.64: Character constant
         Constant::Char(c) => format!("C:'{}'", c.escape_default()),
         Constant::Unit => "U".to_string(),
+        Constant::FnRef(name) => format!("FN:{}", name),
     }
 }
 
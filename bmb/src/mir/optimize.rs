@@ -8,7 +8,9 @@
 //!
 //! - **Debug**: No optimizations (preserves debugging)
 //! - **Release**: Standard optimizations (DCE, constant folding, inlining)
-//! - **Aggressive**: All optimizations including contract-based
+//! - **Aggressive**: All optimizations including contract-based and loop
+//!   optimizations (LICM, induction-variable strength reduction) and
+//!   inlining of small functions
 //!
 //! # Contract-Based Optimizations (BMB-specific)
 //!
@@ -24,21 +26,46 @@ use super::{
     CmpOp, Constant, ContractFact, MirBinOp, MirFunction, MirInst, MirProgram, MirUnaryOp,
     Operand, Place, Terminator,
 };
+use super::escape::EscapeAnalysis;
+use super::inline::{self, FunctionInlining};
+use super::loops::{InductionVariableStrengthReduction, LoopInvariantCodeMotion};
+use crate::profile::{Profiler, SpanKind};
 
 /// Optimization pass trait
-pub trait OptimizationPass {
+///
+/// Passes are shared between the worker threads of a parallel pipeline
+/// run, so they must be `Send + Sync` (all built-in passes are stateless
+/// or hold read-only program facts).
+pub trait OptimizationPass: Send + Sync {
     /// Name of the optimization pass
     fn name(&self) -> &'static str;
 
     /// Run the optimization pass on a function
     /// Returns true if any changes were made
     fn run_on_function(&self, func: &mut MirFunction) -> bool;
+
+    /// Run the optimization pass and return how many rewrites it made.
+    /// Passes that count individual hits (instructions hoisted, ...)
+    /// override this; by default a run that changed anything counts once.
+    fn run_counted(&self, func: &mut MirFunction) -> usize {
+        self.run_on_function(func) as usize
+    }
 }
 
 /// Optimization pipeline
 pub struct OptimizationPipeline {
     passes: Vec<Box<dyn OptimizationPass>>,
     max_iterations: usize,
+    /// Worker threads for per-function optimization (0 = all cores)
+    jobs: usize,
+    /// Run loop-invariant code motion (needs program-level purity facts)
+    licm: bool,
+    /// Inline small functions first (needs the callee bodies)
+    inlining: bool,
+    /// Replace non-escaping boxes and structs by scalars
+    escape_analysis: bool,
+    /// Also move non-escaping vectors into the stack frame (backend opt-in)
+    stack_vectors: bool,
 }
 
 impl OptimizationPipeline {
@@ -47,6 +74,11 @@ impl OptimizationPipeline {
         Self {
             passes: Vec::new(),
             max_iterations: 10,
+            jobs: 1,
+            licm: false,
+            inlining: false,
+            escape_analysis: false,
+            stack_vectors: false,
         }
     }
 
@@ -64,6 +96,7 @@ impl OptimizationPipeline {
                 pipeline.add_pass(Box::new(DeadCodeElimination));
                 pipeline.add_pass(Box::new(SimplifyBranches));
                 pipeline.add_pass(Box::new(CopyPropagation));
+                pipeline.escape_analysis = true;
             }
             OptLevel::Aggressive => {
                 // All optimizations
@@ -74,6 +107,10 @@ impl OptimizationPipeline {
                 pipeline.add_pass(Box::new(CommonSubexpressionElimination));
                 pipeline.add_pass(Box::new(ContractBasedOptimization));
                 pipeline.add_pass(Box::new(ContractUnreachableElimination));
+                pipeline.add_pass(Box::new(InductionVariableStrengthReduction));
+                pipeline.licm = true;
+                pipeline.inlining = true;
+                pipeline.escape_analysis = true;
             }
         }
 
@@ -90,8 +127,45 @@ impl OptimizationPipeline {
         self.max_iterations = n;
     }
 
+    /// Optimize functions on `n` worker threads (0 = one per core).
+    /// Functions are independent once program-level facts are gathered,
+    /// so the result is identical for every job count.
+    pub fn set_jobs(&mut self, n: usize) {
+        self.jobs = n;
+    }
+
+    /// Let escape analysis rewrite non-escaping `vec_new()` to the
+    /// `vec_new_inline`/`vec_push_inline`/`vec_free_inline` builtins, which
+    /// only the text LLVM backend implements
+    pub fn set_stack_vectors(&mut self, enabled: bool) {
+        self.stack_vectors = enabled;
+    }
+
     /// Run all passes on a program
     pub fn optimize(&self, program: &mut MirProgram) -> OptimizationStats {
+        self.optimize_where(program, |_| false)
+    }
+
+    /// Run all passes on a program, leaving functions for which `skip`
+    /// returns true untouched (e.g. their optimized form is already in the
+    /// build cache). Program-level information for the pure-CSE and
+    /// const-eval passes is still gathered from every function.
+    pub fn optimize_where(
+        &self,
+        program: &mut MirProgram,
+        skip: impl Fn(&MirFunction) -> bool + Sync,
+    ) -> OptimizationStats {
+        self.optimize_profiled(program, skip, &Profiler::disabled())
+    }
+
+    /// `optimize_where`, recording a span for every optimized function and
+    /// every pass run inside it (with its change in MIR size) in `profiler`
+    pub fn optimize_profiled(
+        &self,
+        program: &mut MirProgram,
+        skip: impl Fn(&MirFunction) -> bool + Sync,
+        profiler: &Profiler,
+    ) -> OptimizationStats {
         let mut stats = OptimizationStats::new();
 
         // v0.38.3: Create PureFunctionCSE pass with program-level information
@@ -100,9 +174,30 @@ impl OptimizationPipeline {
         // v0.38.4: Create ConstFunctionEval pass with program-level information
         let const_eval = ConstFunctionEval::from_program(program);
 
-        for func in &mut program.functions {
-            let func_stats = self.optimize_function_with_program_passes(func, &pure_cse, &const_eval);
-            stats.merge(&func_stats);
+        let licm = self.licm.then(|| LoopInvariantCodeMotion::from_program(program));
+
+        // Callee bodies are snapshotted before any function is optimized, so
+        // every caller inlines the same code regardless of scheduling
+        let inliner = self.inlining.then(|| FunctionInlining::from_program(program));
+
+        let escape = self.escape_analysis.then(|| EscapeAnalysis::new(self.stack_vectors));
+
+        let per_function = crate::parallel::map_mut(&mut program.functions, self.jobs, |func| {
+            (!skip(func)).then(|| {
+                let _span = profiler.span(SpanKind::Function, &func.name);
+                self.optimize_function_with_program_passes(
+                    func,
+                    &pure_cse,
+                    &const_eval,
+                    licm.as_ref(),
+                    inliner.as_ref(),
+                    escape.as_ref(),
+                    profiler,
+                )
+            })
+        });
+        for func_stats in per_function.iter().flatten() {
+            stats.merge(func_stats);
         }
 
         stats
@@ -114,34 +209,67 @@ impl OptimizationPipeline {
         func: &mut MirFunction,
         pure_cse: &PureFunctionCSE,
         const_eval: &ConstFunctionEval,
+        licm: Option<&LoopInvariantCodeMotion>,
+        inliner: Option<&FunctionInlining>,
+        escape: Option<&EscapeAnalysis>,
+        profiler: &Profiler,
     ) -> OptimizationStats {
         let mut stats = OptimizationStats::new();
         let mut iteration = 0;
 
+        if let Some(inliner) = inliner {
+            let hits = run_profiled(profiler, inliner, func);
+            if hits > 0 {
+                stats.record_pass(inliner.name());
+                stats.record_hits(inliner.name(), hits);
+            }
+        }
+
         loop {
             let mut changed = false;
             iteration += 1;
 
+            // Scalarized allocations feed the standard passes below
+            if let Some(escape) = escape {
+                let hits = run_profiled(profiler, escape, func);
+                if hits > 0 {
+                    changed = true;
+                    stats.record_pass(escape.name());
+                    stats.record_hits(escape.name(), hits);
+                }
+            }
+
             // Run standard passes
             for pass in &self.passes {
-                if pass.run_on_function(func) {
+                let hits = run_profiled(profiler, pass.as_ref(), func);
+                if hits > 0 {
                     changed = true;
                     stats.record_pass(pass.name());
+                    stats.record_hits(pass.name(), hits);
                 }
             }
 
             // v0.38.3: Run pure function CSE
-            if pure_cse.run_on_function(func) {
+            if run_profiled(profiler, pure_cse, func) > 0 {
                 changed = true;
                 stats.record_pass(pure_cse.name());
             }
 
             // v0.38.4: Run const function evaluation
-            if const_eval.run_on_function(func) {
+            if run_profiled(profiler, const_eval, func) > 0 {
                 changed = true;
                 stats.record_pass(const_eval.name());
             }
 
+            if let Some(licm) = licm {
+                let hits = run_profiled(profiler, licm, func);
+                if hits > 0 {
+                    changed = true;
+                    stats.record_pass(licm.name());
+                    stats.record_hits(licm.name(), hits);
+                }
+            }
+
             if !changed || iteration >= self.max_iterations {
                 break;
             }
@@ -152,6 +280,18 @@ impl OptimizationPipeline {
     }
 }
 
+/// Run `pass` on `func`, as a profiler span sized by the change in MIR size
+fn run_profiled(profiler: &Profiler, pass: &dyn OptimizationPass, func: &mut MirFunction) -> usize {
+    if !profiler.is_enabled() {
+        return pass.run_counted(func);
+    }
+    let before = inline::size(func) as i64;
+    let mut span = profiler.span(SpanKind::Pass, pass.name());
+    let hits = pass.run_counted(func);
+    span.set_size(inline::size(func) as i64 - before);
+    hits
+}
+
 impl Default for OptimizationPipeline {
     fn default() -> Self {
         Self::new()
@@ -174,6 +314,8 @@ pub struct OptimizationStats {
     pub iterations: usize,
     /// Pass execution counts
     pub pass_counts: HashMap<String, usize>,
+    /// Rewrites made by each pass (instructions hoisted, multiplies reduced, ...)
+    pub hit_counts: HashMap<String, usize>,
 }
 
 impl OptimizationStats {
@@ -185,10 +327,22 @@ impl OptimizationStats {
         *self.pass_counts.entry(name.to_string()).or_insert(0) += 1;
     }
 
+    pub fn record_hits(&mut self, name: &str, hits: usize) {
+        *self.hit_counts.entry(name.to_string()).or_insert(0) += hits;
+    }
+
+    /// Heap and aggregate allocations removed by escape analysis
+    pub fn allocations_eliminated(&self) -> usize {
+        self.hit_counts.get("escape_analysis").copied().unwrap_or(0)
+    }
+
     pub fn merge(&mut self, other: &OptimizationStats) {
         for (name, count) in &other.pass_counts {
             *self.pass_counts.entry(name.clone()).or_insert(0) += count;
         }
+        for (name, hits) in &other.hit_counts {
+            *self.hit_counts.entry(name.clone()).or_insert(0) += hits;
+        }
     }
 }
 
@@ -207,6 +361,7 @@ impl OptimizationPass for ConstantFolding {
     fn run_on_function(&self, func: &mut MirFunction) -> bool {
         let mut changed = false;
         let mut constants: HashMap<String, Constant> = HashMap::new();
+        let single = single_assignment_places(func);
 
         for block in &mut func.blocks {
             let mut new_instructions = Vec::new();
@@ -214,7 +369,9 @@ impl OptimizationPass for ConstantFolding {
             for inst in &block.instructions {
                 match inst {
                     MirInst::Const { dest, value } => {
-                        constants.insert(dest.name.clone(), value.clone());
+                        if single.contains(&dest.name) {
+                            constants.insert(dest.name.clone(), value.clone());
+                        }
                         new_instructions.push(inst.clone());
                     }
                     MirInst::BinOp { dest, op, lhs, rhs } => {
@@ -222,7 +379,9 @@ impl OptimizationPass for ConstantFolding {
                             (get_constant(lhs, &constants), get_constant(rhs, &constants))
                             && let Some(result) = fold_binop(*op, &lhs_const, &rhs_const)
                         {
-                            constants.insert(dest.name.clone(), result.clone());
+                            if single.contains(&dest.name) {
+                                constants.insert(dest.name.clone(), result.clone());
+                            }
                             new_instructions.push(MirInst::Const {
                                 dest: dest.clone(),
                                 value: result,
@@ -236,7 +395,9 @@ impl OptimizationPass for ConstantFolding {
                         if let Some(src_const) = get_constant(src, &constants)
                             && let Some(result) = fold_unaryop(*op, &src_const)
                         {
-                            constants.insert(dest.name.clone(), result.clone());
+                            if single.contains(&dest.name) {
+                                constants.insert(dest.name.clone(), result.clone());
+                            }
                             new_instructions.push(MirInst::Const {
                                 dest: dest.clone(),
                                 value: result,
@@ -247,7 +408,9 @@ impl OptimizationPass for ConstantFolding {
                         new_instructions.push(inst.clone());
                     }
                     MirInst::Copy { dest, src } => {
-                        if let Some(value) = constants.get(&src.name) {
+                        if let Some(value) = constants.get(&src.name)
+                            && single.contains(&dest.name)
+                        {
                             constants.insert(dest.name.clone(), value.clone());
                         }
                         new_instructions.push(inst.clone());
@@ -458,6 +621,24 @@ fn get_inst_dest(inst: &MirInst) -> Option<&Place> {
     }
 }
 
+/// Places assigned exactly once in `func`, counting parameters as assigned
+/// on entry. MIR reassigns loop variables (and tail-call parameters) in
+/// place, so only these places hold one value everywhere they are read.
+pub(super) fn single_assignment_places(func: &MirFunction) -> HashSet<String> {
+    let mut defs: HashMap<&str, usize> = func.params.iter().map(|(name, _)| (name.as_str(), 1)).collect();
+    for inst in func.blocks.iter().flat_map(|b| b.instructions.iter()) {
+        let written = match inst {
+            MirInst::FieldStore { base, .. } => Some(base),
+            MirInst::IndexStore { array, .. } => Some(array),
+            _ => get_inst_dest(inst),
+        };
+        if let Some(place) = written {
+            *defs.entry(place.name.as_str()).or_insert(0) += 1;
+        }
+    }
+    defs.into_iter().filter(|&(_, n)| n == 1).map(|(name, _)| name.to_string()).collect()
+}
+
 fn has_side_effects(inst: &MirInst) -> bool {
     matches!(
         inst,
@@ -517,11 +698,15 @@ impl OptimizationPass for CopyPropagation {
     fn run_on_function(&self, func: &mut MirFunction) -> bool {
         let mut changed = false;
         let mut copies: HashMap<String, Place> = HashMap::new();
+        let single = single_assignment_places(func);
 
         for block in &mut func.blocks {
-            // Build copy map
+            // Build copy map (both sides must hold one value throughout)
             for inst in &block.instructions {
-                if let MirInst::Copy { dest, src } = inst {
+                if let MirInst::Copy { dest, src } = inst
+                    && single.contains(&dest.name)
+                    && single.contains(&src.name)
+                {
                     copies.insert(dest.name.clone(), src.clone());
                 }
             }
@@ -846,9 +1031,10 @@ impl OptimizationPass for ContractBasedOptimization {
 
         // Build set of proven facts from preconditions
         let proven_facts = ProvenFacts::from_preconditions(&func.preconditions);
+        let gets = StableVecGets::new(func);
 
         // Phase 1: Eliminate redundant comparisons based on proven facts
-        for block in &mut func.blocks {
+        for (b, block) in func.blocks.iter_mut().enumerate() {
             for inst in &mut block.instructions {
                 if self.try_eliminate_redundant_check(inst, &proven_facts) {
                     changed = true;
@@ -859,6 +1045,13 @@ impl OptimizationPass for ContractBasedOptimization {
             if self.try_simplify_branch(&mut block.terminator, &proven_facts) {
                 changed = true;
             }
+
+            // Phase 3: Drop bounds checks on vec_get when pre proves 0 <= i < vec_len(v)
+            for (i, inst) in block.instructions.iter_mut().enumerate() {
+                if gets.holds_at(b, i) && self.try_elide_bounds_check(inst, &proven_facts) {
+                    changed = true;
+                }
+            }
         }
 
         changed
@@ -898,6 +1091,20 @@ impl ContractBasedOptimization {
         }
     }
 
+    /// Rewrite `vec_get(v, i)` to `vec_get_unchecked(v, i)` when the index is proven
+    /// in range, so codegen emits the element load without the bounds check
+    fn try_elide_bounds_check(&self, inst: &mut MirInst, facts: &ProvenFacts) -> bool {
+        if let MirInst::Call { func, args, .. } = inst
+            && func == "vec_get"
+            && let [Operand::Place(array), Operand::Place(index)] = args.as_slice()
+            && facts.proves_in_bounds(&index.name, &array.name)
+        {
+            *func = "vec_get_unchecked".to_string();
+            return true;
+        }
+        false
+    }
+
     /// Try to simplify branches based on proven facts
     fn try_simplify_branch(&self, term: &mut Terminator, facts: &ProvenFacts) -> bool {
         if let Terminator::Branch { cond, then_label, else_label } = term {
@@ -917,6 +1124,107 @@ impl ContractBasedOptimization {
     }
 }
 
+/// `vec_get` calls at which the entry facts about their vector and index
+/// still hold
+///
+/// Preconditions describe the values on entry, so a get qualifies only when
+/// its vector handle and index are assigned once (MIR reassigns loop and
+/// tail-call parameters, and inlining rebinds facts onto caller places) and
+/// no call that may change the vector's length can run before it. Any call
+/// the vector, or a copy of it, is passed to counts as such, except the
+/// builtins that only read it.
+struct StableVecGets {
+    /// (block, instruction) of each qualifying `vec_get`
+    sites: HashSet<(usize, usize)>,
+}
+
+impl StableVecGets {
+    const READ_ONLY: [&'static str; 4] = ["vec_get", "vec_get_unchecked", "vec_len", "vec_cap"];
+
+    fn new(func: &MirFunction) -> Self {
+        let single = single_assignment_places(func);
+        let index: HashMap<&str, usize> =
+            func.blocks.iter().enumerate().map(|(i, b)| (b.label.as_str(), i)).collect();
+        let succs: Vec<Vec<usize>> = func
+            .blocks
+            .iter()
+            .map(|b| inline::successors(&b.terminator).iter().filter_map(|l| index.get(l.as_str()).copied()).collect())
+            .collect();
+        // Blocks reachable from the end of block `b`
+        let reachable_after = |b: usize| {
+            let mut seen = vec![false; func.blocks.len()];
+            let mut stack = succs[b].clone();
+            while let Some(n) = stack.pop() {
+                if !std::mem::replace(&mut seen[n], true) {
+                    stack.extend(&succs[n]);
+                }
+            }
+            seen
+        };
+
+        let mut sites = HashSet::new();
+        for (b, block) in func.blocks.iter().enumerate() {
+            for (i, inst) in block.instructions.iter().enumerate() {
+                let MirInst::Call { func: callee, args, .. } = inst else { continue };
+                let [Operand::Place(array), Operand::Place(idx)] = args.as_slice() else { continue };
+                if callee != "vec_get" || !single.contains(&array.name) || !single.contains(&idx.name) {
+                    continue;
+                }
+                let aliases = Self::aliases(func, &array.name);
+                let mutated = func.blocks.iter().enumerate().any(|(mb, mblock)| {
+                    mblock.instructions.iter().enumerate().any(|(mi, minst)| {
+                        Self::may_resize(minst, &aliases)
+                            && ((mb == b && mi < i) || reachable_after(mb)[b])
+                    })
+                });
+                if !mutated {
+                    sites.insert((b, i));
+                }
+            }
+        }
+        StableVecGets { sites }
+    }
+
+    /// `vector` and every place copies or phis connect it with
+    fn aliases(func: &MirFunction, vector: &str) -> HashSet<String> {
+        let mut set = HashSet::from([vector.to_string()]);
+        loop {
+            let before = set.len();
+            for inst in func.blocks.iter().flat_map(|b| &b.instructions) {
+                let (dest, srcs): (&str, Vec<&str>) = match inst {
+                    MirInst::Copy { dest, src } => (&dest.name, vec![src.name.as_str()]),
+                    MirInst::Phi { dest, values } => (
+                        &dest.name,
+                        values.iter().filter_map(|(v, _)| match v {
+                            Operand::Place(p) => Some(p.name.as_str()),
+                            _ => None,
+                        }).collect(),
+                    ),
+                    _ => continue,
+                };
+                if set.contains(dest) || srcs.iter().any(|s| set.contains(*s)) {
+                    set.insert(dest.to_string());
+                    set.extend(srcs.iter().map(|s| s.to_string()));
+                }
+            }
+            if set.len() == before {
+                return set;
+            }
+        }
+    }
+
+    /// Whether `inst` is a call that may change the length of the vector
+    fn may_resize(inst: &MirInst, aliases: &HashSet<String>) -> bool {
+        matches!(inst, MirInst::Call { func, args, .. }
+            if !Self::READ_ONLY.contains(&func.as_str())
+                && args.iter().any(|a| matches!(a, Operand::Place(p) if aliases.contains(&p.name))))
+    }
+
+    fn holds_at(&self, block: usize, inst: usize) -> bool {
+        self.sites.contains(&(block, inst))
+    }
+}
+
 /// Proven facts from preconditions, used for optimization
 struct ProvenFacts {
     /// Variable bounds: var -> (lower_bound, upper_bound) where bounds are Option<i64>
@@ -1061,6 +1369,18 @@ impl ProvenFacts {
         None
     }
 
+    /// Check that `0 <= index < vec_len(array)` is proven
+    fn proves_in_bounds(&self, index: &str, array: &str) -> bool {
+        let non_negative = self
+            .var_bounds
+            .get(index)
+            .is_some_and(|(lower, _)| lower.is_some_and(|l| l >= 0));
+        non_negative
+            && self.var_relations.iter().any(|fact| {
+                matches!(fact, ContractFact::ArrayBounds { index: i, array: a } if i == index && a == array)
+            })
+    }
+
     /// Get a known boolean value for a variable
     fn get_bool_value(&self, var: &str) -> Option<bool> {
         self.bool_values.get(var).copied()
@@ -1408,6 +1728,130 @@ mod tests {
         assert!(matches!(inst, MirInst::Const { value: Constant::Bool(true), .. }));
     }
 
+    #[test]
+    fn test_contract_vec_get_bounds_elision() {
+        // Test: "i >= 0 && i < vec_len(v)" lets vec_get(v, i) skip its bounds check,
+        // while vec_get(v, j) with no contract keeps it
+        let mut func = MirFunction {
+            name: "test_vec_bounds".to_string(),
+            params: vec![
+                ("v".to_string(), MirType::I64),
+                ("i".to_string(), MirType::I64),
+                ("j".to_string(), MirType::I64),
+            ],
+            ret_ty: MirType::I64,
+            locals: vec![],
+            blocks: vec![BasicBlock {
+                label: "entry".to_string(),
+                instructions: vec![
+                    MirInst::Call {
+                        dest: Some(Place::new("a")),
+                        func: "vec_get".to_string(),
+                        args: vec![Operand::Place(Place::new("v")), Operand::Place(Place::new("i"))],
+                    },
+                    MirInst::Call {
+                        dest: Some(Place::new("b")),
+                        func: "vec_get".to_string(),
+                        args: vec![Operand::Place(Place::new("v")), Operand::Place(Place::new("j"))],
+                    },
+                ],
+                terminator: Terminator::Return(Some(Operand::Place(Place::new("a")))),
+            }],
+            preconditions: vec![
+                ContractFact::VarCmp {
+                    var: "i".to_string(),
+                    op: CmpOp::Ge,
+                    value: 0,
+                },
+                ContractFact::ArrayBounds {
+                    index: "i".to_string(),
+                    array: "v".to_string(),
+                },
+                // Upper bound alone is not enough: j could be negative
+                ContractFact::ArrayBounds {
+                    index: "j".to_string(),
+                    array: "v".to_string(),
+                },
+            ],
+            postconditions: vec![],
+            is_pure: false,
+            is_const: false,
+        };
+
+        let pass = ContractBasedOptimization;
+        assert!(pass.run_on_function(&mut func));
+
+        let insts = &func.blocks[0].instructions;
+        assert!(matches!(&insts[0], MirInst::Call { func, .. } if func == "vec_get_unchecked"));
+        assert!(matches!(&insts[1], MirInst::Call { func, .. } if func == "vec_get"));
+    }
+
+    #[test]
+    fn test_contract_vec_get_elision_needs_stable_facts() {
+        let call = |dest: Option<&str>, func: &str, args: &[&str]| MirInst::Call {
+            dest: dest.map(Place::new),
+            func: func.to_string(),
+            args: args.iter().map(|a| Operand::Place(Place::new(*a))).collect(),
+        };
+        let in_bounds = vec![
+            ContractFact::VarCmp { var: "i".to_string(), op: CmpOp::Ge, value: 0 },
+            ContractFact::ArrayBounds { index: "i".to_string(), array: "v".to_string() },
+        ];
+        let func = |blocks| MirFunction {
+            name: "f".to_string(),
+            params: vec![("v".to_string(), MirType::I64), ("i".to_string(), MirType::I64)],
+            ret_ty: MirType::I64,
+            locals: vec![],
+            blocks,
+            preconditions: in_bounds.clone(),
+            postconditions: vec![],
+            is_pure: false,
+            is_const: false,
+        };
+        let block = |label: &str, instructions, terminator| BasicBlock { label: label.to_string(), instructions, terminator };
+        let ret = || Terminator::Return(Some(Operand::Place(Place::new("a"))));
+        let pass = ContractBasedOptimization;
+
+        // A pop through a copy of the handle, in an earlier block
+        let mut popped = func(vec![
+            block("entry", vec![MirInst::Copy { dest: Place::new("w"), src: Place::new("v") }, call(None, "vec_pop", &["w"])],
+                Terminator::Goto("get".to_string())),
+            block("get", vec![call(Some("a"), "vec_get", &["v", "i"])], ret()),
+        ]);
+        pass.run_on_function(&mut popped);
+        assert!(matches!(&popped.blocks[1].instructions[0], MirInst::Call { func, .. } if func == "vec_get"));
+
+        // A push after the get that loops back to it
+        let mut looped = func(vec![
+            block("entry", vec![], Terminator::Goto("body".to_string())),
+            block("body", vec![call(Some("a"), "vec_get", &["v", "i"]), call(None, "vec_push", &["v", "a"])],
+                Terminator::Goto("body".to_string())),
+        ]);
+        pass.run_on_function(&mut looped);
+        assert!(matches!(&looped.blocks[1].instructions[0], MirInst::Call { func, .. } if func == "vec_get"));
+
+        // A reassigned index, as in a self tail call turned into a loop
+        let mut reassigned = func(vec![block(
+            "entry",
+            vec![
+                MirInst::Const { dest: Place::new("i"), value: Constant::Int(7) },
+                call(Some("a"), "vec_get", &["v", "i"]),
+            ],
+            ret(),
+        )]);
+        pass.run_on_function(&mut reassigned);
+        assert!(matches!(&reassigned.blocks[0].instructions[1], MirInst::Call { func, .. } if func == "vec_get"));
+
+        // A push that only runs after the get leaves it unchecked
+        let mut after = func(vec![block(
+            "entry",
+            vec![call(Some("a"), "vec_get", &["v", "i"]), call(None, "vec_push", &["v", "a"])],
+            ret(),
+        )]);
+        assert!(pass.run_on_function(&mut after));
+        assert!(matches!(&after.blocks[0].instructions[0], MirInst::Call { func, .. } if func == "vec_get_unchecked"));
+    }
+
     #[test]
     fn test_contract_unreachable_elimination() {
         // Test: precondition "x >= 0" should eliminate branch to negative case
@@ -0,0 +1,354 @@
+//! Race check for functions run on the runtime thread pool
+//!
+//! `spawn(f, x)` and `parallel_for(lo, hi, f)` run the top-level function
+//! `f` on several threads at once. BMB values are copied, so tasks can only
+//! share memory through handles: vectors, hash maps, boxes and raw
+//! pointers. A task is accepted when it cannot write memory another task
+//! may reach:
+//!
+//! - `@pure` (and `@const`) functions are trusted by their contract;
+//! - otherwise every write, direct or through a callee, must go to memory
+//!   the function allocated itself, or, for `spawn`, through the argument
+//!   handed to that one task (the spawner must leave it alone until
+//!   `join`). `parallel_for` bodies get an index, never a handle.
+//!
+//! String builder and line reader handles are per thread in the runtime, so
+//! using one a task did not create is reported the same way.
+//!
+//! Each function gets a summary — the parameters it writes through and the
+//! first write to memory of unknown origin — computed to a fixed point over
+//! the call graph, so recursion and helper functions are handled.
+
+use std::collections::{BTreeSet, HashMap, HashSet};
+
+use super::{Constant, MirFunction, MirInst, MirProgram, Operand};
+
+/// Builtins that run a function on the thread pool, with the position of
+/// the function argument
+pub fn task_fn_arg(builtin: &str) -> Option<usize> {
+    match builtin {
+        "spawn" => Some(0),
+        "parallel_for" => Some(2),
+        _ => None,
+    }
+}
+
+/// Builtins that write through (or otherwise need exclusive use of) the
+/// handle in their first argument
+const HANDLE_WRITES: &[&str] = &[
+    "vec_push", "vec_pop", "vec_set", "vec_clear", "vec_free",
+    "hashmap_insert", "hashmap_remove", "hashmap_free",
+    "hashset_insert", "hashset_remove", "hashset_free",
+    "strmap_insert", "strmap_remove", "strmap_free",
+    "store_i64", "box_set_i64", "box_free_i64", "free", "realloc",
+    // Per-thread runtime tables
+    "sb_push", "sb_push_char", "sb_push_int", "sb_build", "sb_len", "sb_clear",
+    "read_line", "file_close",
+];
+
+/// Builtins returning memory no one else can reach yet
+const ALLOCATORS: &[&str] = &[
+    "vec_new", "vec_with_capacity", "hashmap_new", "hashset_new", "strmap_new",
+    "box_new_i64", "malloc", "calloc", "sb_new", "file_open",
+];
+
+/// A task spawned onto the pool that may race, with the reason
+#[derive(Debug, Clone, PartialEq)]
+pub struct RaceError {
+    /// Function that starts the task
+    pub caller: String,
+    /// `spawn` or `parallel_for`
+    pub builtin: String,
+    /// Function run as the task
+    pub task: String,
+    pub reason: String,
+}
+
+impl std::fmt::Display for RaceError {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        write!(
+            f,
+            "`{}` in `{}` may race: `{}` {}; mark it @pure or write only to memory it allocates",
+            self.builtin, self.caller, self.task, self.reason
+        )
+    }
+}
+
+#[derive(Debug, Clone, Default, PartialEq)]
+struct Summary {
+    /// Parameters written through
+    writes_params: BTreeSet<usize>,
+    /// First write to memory of unknown origin
+    unknown: Option<String>,
+}
+
+/// Where a handle came from, within one function
+#[derive(Debug, Clone, Copy, PartialEq)]
+enum Origin {
+    Owned,
+    Param(usize),
+    Unknown,
+}
+
+/// Check every `spawn` and `parallel_for` in `program`
+pub fn check(program: &MirProgram) -> Result<(), Vec<RaceError>> {
+    let functions: HashMap<&str, &MirFunction> =
+        program.functions.iter().map(|f| (f.name.as_str(), f)).collect();
+    let summaries = summarize(&functions);
+
+    let mut errors = Vec::new();
+    for func in &program.functions {
+        for (builtin, task) in task_calls(func) {
+            let Some(summary) = summaries.get(task) else { continue };
+            let reason = match (&summary.unknown, builtin) {
+                (Some(write), _) => Some(write.clone()),
+                (None, "parallel_for") if !summary.writes_params.is_empty() => {
+                    Some("writes through its index argument as a handle".to_string())
+                }
+                _ => None,
+            };
+            if let Some(reason) = reason {
+                errors.push(RaceError {
+                    caller: func.name.clone(),
+                    builtin: builtin.to_string(),
+                    task: task.to_string(),
+                    reason,
+                });
+            }
+        }
+    }
+    if errors.is_empty() { Ok(()) } else { Err(errors) }
+}
+
+/// `(builtin, task function)` for each task started in `func`
+fn task_calls(func: &MirFunction) -> impl Iterator<Item = (&str, &str)> {
+    func.blocks.iter().flat_map(|b| &b.instructions).filter_map(|inst| match inst {
+        MirInst::Call { func: builtin, args, .. } => {
+            let pos = task_fn_arg(builtin)?;
+            match args.get(pos) {
+                Some(Operand::Constant(Constant::FnRef(task))) => Some((builtin.as_str(), task.as_str())),
+                _ => None,
+            }
+        }
+        _ => None,
+    })
+}
+
+fn summarize<'a>(functions: &HashMap<&'a str, &'a MirFunction>) -> HashMap<&'a str, Summary> {
+    let mut summaries: HashMap<&str, Summary> = functions.keys().map(|&n| (n, Summary::default())).collect();
+    // Summaries only grow, so this terminates
+    loop {
+        let mut changed = false;
+        for (&name, func) in functions {
+            let summary = summarize_function(func, &summaries);
+            if summaries[name] != summary {
+                summaries.insert(name, summary);
+                changed = true;
+            }
+        }
+        if !changed {
+            return summaries;
+        }
+    }
+}
+
+fn summarize_function(func: &MirFunction, summaries: &HashMap<&str, Summary>) -> Summary {
+    let mut summary = Summary::default();
+    if func.is_pure || func.is_const {
+        return summary;
+    }
+    let origins = origins(func);
+    let origin = |op: &Operand| match op {
+        Operand::Constant(_) => Origin::Owned,
+        Operand::Place(p) => origins.get(p.name.as_str()).copied().unwrap_or(Origin::Unknown),
+    };
+    for inst in func.blocks.iter().flat_map(|b| &b.instructions) {
+        match inst {
+            MirInst::FieldStore { base, field, .. } => {
+                let target = origin(&Operand::Place(base.clone()));
+                record(&mut summary, target, || format!("stores to field `{}` of `{}`, which it did not allocate", field, base.name));
+            }
+            MirInst::IndexStore { array, .. } => {
+                let target = origin(&Operand::Place(array.clone()));
+                record(&mut summary, target, || format!("stores into `{}`, which it did not allocate", array.name));
+            }
+            MirInst::Call { func: callee, args, .. } => {
+                if HANDLE_WRITES.contains(&callee.as_str()) {
+                    if let Some(handle) = args.first() {
+                        record(&mut summary, origin(handle), || format!("calls `{}` on a handle it did not allocate", callee));
+                    }
+                    continue;
+                }
+                // A spawned task receives its argument like a callee would
+                let (target, passed): (&str, Vec<Origin>) = match task_fn_arg(callee) {
+                    Some(pos) => match args.get(pos) {
+                        Some(Operand::Constant(Constant::FnRef(task))) if callee == "spawn" => {
+                            (task.as_str(), args.get(1).map(origin).into_iter().collect())
+                        }
+                        // parallel_for passes indices, which are never owned by the caller
+                        Some(Operand::Constant(Constant::FnRef(task))) => (task.as_str(), vec![Origin::Unknown]),
+                        _ => continue,
+                    },
+                    None => (callee.as_str(), args.iter().map(origin).collect()),
+                };
+                let Some(callee_summary) = summaries.get(target) else { continue };
+                if let Some(reason) = &callee_summary.unknown {
+                    summary.unknown.get_or_insert_with(|| format!("calls `{}`, which {}", target, reason));
+                }
+                for &i in &callee_summary.writes_params {
+                    let arg = passed.get(i).copied().unwrap_or(Origin::Unknown);
+                    record(&mut summary, arg, || format!("passes a handle it did not allocate to `{}`, which writes through it", target));
+                }
+            }
+            _ => {}
+        }
+    }
+    summary
+}
+
+/// Note a write through memory of `target` origin
+fn record(summary: &mut Summary, target: Origin, what: impl FnOnce() -> String) {
+    match target {
+        Origin::Owned => {}
+        Origin::Param(i) => {
+            summary.writes_params.insert(i);
+        }
+        Origin::Unknown => {
+            summary.unknown.get_or_insert_with(what);
+        }
+    }
+}
+
+/// Origin of every place in `func` that holds a handle of known origin
+fn origins(func: &MirFunction) -> HashMap<&str, Origin> {
+    let mut origins: HashMap<&str, Origin> =
+        func.params.iter().enumerate().map(|(i, (name, _))| (name.as_str(), Origin::Param(i))).collect();
+    // Places assigned more than once (loops, shadowing) merge their origins
+    let mut assigned: HashSet<&str> = HashSet::new();
+    loop {
+        let mut changed = false;
+        for inst in func.blocks.iter().flat_map(|b| &b.instructions) {
+            let (dest, origin) = match inst {
+                MirInst::Call { dest: Some(d), func: callee, .. } if ALLOCATORS.contains(&callee.as_str()) => {
+                    (d, Origin::Owned)
+                }
+                MirInst::StructInit { dest, .. } | MirInst::ArrayInit { dest, .. } | MirInst::EnumVariant { dest, .. } => {
+                    (dest, Origin::Owned)
+                }
+                MirInst::Const { dest, .. } => (dest, Origin::Owned),
+                MirInst::Copy { dest, src } => {
+                    (dest, origins.get(src.name.as_str()).copied().unwrap_or(Origin::Unknown))
+                }
+                MirInst::Phi { dest, values } => {
+                    let mut merged = None;
+                    for (value, _) in values {
+                        let o = match value {
+                            Operand::Constant(_) => Origin::Owned,
+                            Operand::Place(p) => match origins.get(p.name.as_str()) {
+                                Some(&o) => o,
+                                // Not assigned yet on this pass: decided once it is
+                                None if !assigned.contains(p.name.as_str()) => continue,
+                                None => Origin::Unknown,
+                            },
+                        };
+                        merged = Some(merge(merged, o));
+                    }
+                    (dest, merged.unwrap_or(Origin::Unknown))
+                }
+                MirInst::BinOp { dest, .. }
+                | MirInst::UnaryOp { dest, .. }
+                | MirInst::FieldAccess { dest, .. }
+                | MirInst::IndexLoad { dest, .. }
+                | MirInst::Call { dest: Some(dest), .. } => (dest, Origin::Unknown),
+                _ => continue,
+            };
+            let name = dest.name.as_str();
+            let new = if assigned.insert(name) && !origins.contains_key(name) {
+                origin
+            } else {
+                merge(origins.get(name).copied(), origin)
+            };
+            if origins.get(name) != Some(&new) {
+                origins.insert(name, new);
+                changed = true;
+            }
+        }
+        if !changed {
+            return origins;
+        }
+    }
+}
+
+fn merge(a: Option<Origin>, b: Origin) -> Origin {
+    match a {
+        None => b,
+        Some(a) if a == b => a,
+        Some(_) => Origin::Unknown,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::mir::test_util::{block, call, function, int, place, program, var};
+    use crate::mir::Terminator;
+
+    fn fn_ref(n: &str) -> Operand {
+        Operand::Constant(Constant::FnRef(n.to_string()))
+    }
+
+    /// `fn name(params)` running `instructions` and returning 0
+    fn single_block(name: &str, params: &[&str], instructions: Vec<MirInst>) -> MirFunction {
+        function(name, params, &[], vec![block("entry", instructions, Terminator::Return(Some(int(0))))])
+    }
+
+    #[test]
+    fn test_local_writes_and_pure_tasks_are_accepted() {
+        // fn work(i) = { let v = vec_new(); vec_push(v, i); fill(v); vec_len(v) }
+        let work = single_block("work", &["i"], vec![
+            call(Some("v"), "vec_new", vec![]),
+            MirInst::Copy { dest: place("w"), src: place("v") },
+            call(None, "vec_push", vec![var("w"), var("i")]),
+            call(Some("r"), "fill", vec![var("v")]),
+        ]);
+        let fill = single_block("fill", &["v"], vec![call(None, "vec_set", vec![var("v"), int(0), int(1)])]);
+        let mut table = single_block("table", &["i"], vec![call(None, "vec_set", vec![var("i"), int(0), int(1)])]);
+        table.is_pure = true;
+        let main = single_block("main", &[], vec![
+            call(Some("s"), "parallel_for", vec![int(0), int(10), fn_ref("work")]),
+            call(Some("t"), "parallel_for", vec![int(0), int(10), fn_ref("table")]),
+            // spawn hands the buffer to the one task
+            call(Some("b"), "vec_new", vec![]),
+            call(Some("h"), "spawn", vec![fn_ref("fill"), var("b")]),
+        ]);
+        assert_eq!(check(&program(vec![work, fill, table, main])), Ok(()));
+    }
+
+    #[test]
+    fn test_shared_writes_are_reported() {
+        // Writes through a handle it loaded from shared memory
+        let load = single_block("load", &["i"], vec![
+            call(Some("h"), "vec_get", vec![int(4096), var("i")]),
+            call(None, "vec_push", vec![var("h"), var("i")]),
+        ]);
+        // Treats its index as a handle, through a (recursive) helper
+        let helper = single_block("helper", &["v", "n"], vec![
+            call(None, "vec_set", vec![var("v"), var("n"), int(0)]),
+            call(Some("r"), "helper", vec![var("v"), var("n")]),
+        ]);
+        let index = single_block("index", &["i"], vec![call(Some("r"), "helper", vec![var("i"), int(0)])]);
+        let main = single_block("main", &[], vec![
+            call(Some("h"), "spawn", vec![fn_ref("load"), int(1)]),
+            call(Some("s"), "parallel_for", vec![int(0), int(10), fn_ref("index")]),
+            // index is fine for spawn: it only writes its own argument
+            call(Some("t"), "spawn", vec![fn_ref("index"), int(3)]),
+        ]);
+
+        let errors = check(&program(vec![load, helper, index, main])).unwrap_err();
+        assert_eq!(errors.len(), 2);
+        assert_eq!((errors[0].builtin.as_str(), errors[0].task.as_str()), ("spawn", "load"));
+        assert!(errors[0].reason.contains("`vec_push`"), "{}", errors[0].reason);
+        assert_eq!((errors[1].builtin.as_str(), errors[1].task.as_str()), ("parallel_for", "index"));
+        assert!(errors[1].to_string().contains("mark it @pure"));
+    }
+}
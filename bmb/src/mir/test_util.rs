@@ -0,0 +1,42 @@
+//! Builders for MIR fixtures in unit tests
+
+use super::{BasicBlock, Constant, MirFunction, MirInst, MirProgram, MirType, Operand, Place, Terminator};
+
+pub fn place(name: &str) -> Place {
+    Place::new(name)
+}
+
+pub fn var(name: &str) -> Operand {
+    Operand::Place(place(name))
+}
+
+pub fn int(n: i64) -> Operand {
+    Operand::Constant(Constant::Int(n))
+}
+
+pub fn block(label: &str, instructions: Vec<MirInst>, terminator: Terminator) -> BasicBlock {
+    BasicBlock { label: label.to_string(), instructions, terminator }
+}
+
+pub fn call(dest: Option<&str>, func: &str, args: Vec<Operand>) -> MirInst {
+    MirInst::Call { dest: dest.map(place), func: func.to_string(), args }
+}
+
+/// Function returning `i64` whose parameters are all `i64`
+pub fn function(name: &str, params: &[&str], locals: &[(&str, MirType)], blocks: Vec<BasicBlock>) -> MirFunction {
+    MirFunction {
+        name: name.to_string(),
+        params: params.iter().map(|p| (p.to_string(), MirType::I64)).collect(),
+        ret_ty: MirType::I64,
+        locals: locals.iter().map(|(n, t)| (n.to_string(), t.clone())).collect(),
+        blocks,
+        preconditions: vec![],
+        postconditions: vec![],
+        is_pure: false,
+        is_const: false,
+    }
+}
+
+pub fn program(functions: Vec<MirFunction>) -> MirProgram {
+    MirProgram { functions, extern_fns: vec![] }
+}
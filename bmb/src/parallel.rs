@@ -0,0 +1,127 @@
+//! Data-parallel helpers for the compiler pipeline
+//!
+//! Workers claim items one at a time from a shared cursor (dynamic
+//! self-scheduling), so a few expensive functions cannot leave the other
+//! threads idle the way a static split would. Results always come back in
+//! input order, which keeps compiler output independent of the job count.
+
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+/// Resolve a `--jobs` value: 0 means one worker per available core
+pub fn resolve_jobs(jobs: usize) -> usize {
+    if jobs > 0 {
+        return jobs;
+    }
+    std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1)
+}
+
+/// Apply `f` to every item on up to `jobs` threads, returning results in order
+pub fn map<T, R, F>(items: &[T], jobs: usize, f: F) -> Vec<R>
+where
+    T: Sync,
+    R: Send,
+    F: Fn(&T) -> R + Sync,
+{
+    let workers = resolve_jobs(jobs).min(items.len());
+    if workers <= 1 {
+        return items.iter().map(f).collect();
+    }
+
+    let cursor = AtomicUsize::new(0);
+    let mut parts: Vec<(usize, R)> = std::thread::scope(|scope| {
+        let handles: Vec<_> = (0..workers)
+            .map(|_| {
+                scope.spawn(|| {
+                    let mut done = Vec::new();
+                    loop {
+                        let i = cursor.fetch_add(1, Ordering::Relaxed);
+                        if i >= items.len() {
+                            break done;
+                        }
+                        done.push((i, f(&items[i])));
+                    }
+                })
+            })
+            .collect();
+        handles
+            .into_iter()
+            .flat_map(|h| h.join().unwrap_or_else(|e| std::panic::resume_unwind(e)))
+            .collect()
+    });
+
+    parts.sort_unstable_by_key(|(i, _)| *i);
+    parts.into_iter().map(|(_, r)| r).collect()
+}
+
+/// Apply `f` to every item in place on up to `jobs` threads, returning
+/// per-item results in order
+pub fn map_mut<T, R, F>(items: &mut [T], jobs: usize, f: F) -> Vec<R>
+where
+    T: Send,
+    R: Send,
+    F: Fn(&mut T) -> R + Sync,
+{
+    let workers = resolve_jobs(jobs).min(items.len());
+    if workers <= 1 {
+        return items.iter_mut().map(f).collect();
+    }
+
+    let queue = Mutex::new(items.iter_mut().enumerate());
+    let mut parts: Vec<(usize, R)> = std::thread::scope(|scope| {
+        let handles: Vec<_> = (0..workers)
+            .map(|_| {
+                scope.spawn(|| {
+                    let mut done = Vec::new();
+                    loop {
+                        // Hold the lock only long enough to claim the next item
+                        let next = queue.lock().unwrap_or_else(|e| e.into_inner()).next();
+                        match next {
+                            Some((i, item)) => done.push((i, f(item))),
+                            None => break done,
+                        }
+                    }
+                })
+            })
+            .collect();
+        handles
+            .into_iter()
+            .flat_map(|h| h.join().unwrap_or_else(|e| std::panic::resume_unwind(e)))
+            .collect()
+    });
+
+    parts.sort_unstable_by_key(|(i, _)| *i);
+    parts.into_iter().map(|(_, r)| r).collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_map_preserves_order() {
+        let items: Vec<u64> = (0..1000).collect();
+        for jobs in [1, 2, 7] {
+            let out = map(&items, jobs, |x| x * x);
+            assert_eq!(out, items.iter().map(|x| x * x).collect::<Vec<_>>());
+        }
+    }
+
+    #[test]
+    fn test_map_mut_updates_in_place() {
+        let mut items: Vec<u64> = (0..500).collect();
+        let old = map_mut(&mut items, 4, |x| {
+            let before = *x;
+            *x += 1;
+            before
+        });
+        assert_eq!(old, (0..500).collect::<Vec<_>>());
+        assert_eq!(items, (1..501).collect::<Vec<_>>());
+    }
+
+    #[test]
+    fn test_resolve_jobs() {
+        assert_eq!(resolve_jobs(3), 3);
+        assert!(resolve_jobs(0) >= 1);
+    }
+}
@@ -2,7 +2,7 @@
 
 use crate::ast::{Program, Span};
 use crate::error::{CompileError, Result};
-use crate::lexer::Token;
+use crate::lexer::{self, Token};
 
 #[cfg(test)]
 mod tests;
@@ -20,18 +20,34 @@ pub fn parse(_filename: &str, _source: &str, tokens: Vec<(Token, Span)>) -> Resu
 
     grammar::ProgramParser::new()
         .parse(token_iter)
-        .map_err(|e| {
-            let span = match &e {
-                lalrpop_util::ParseError::InvalidToken { location } => Span::new(*location, *location + 1),
-                lalrpop_util::ParseError::UnrecognizedEof { location, .. } => {
-                    Span::new(*location, *location + 1)
-                }
-                lalrpop_util::ParseError::UnrecognizedToken { token, .. } => {
-                    Span::new(token.0, token.2)
-                }
-                lalrpop_util::ParseError::ExtraToken { token } => Span::new(token.0, token.2),
-                lalrpop_util::ParseError::User { .. } => Span::new(0, 1),
-            };
-            CompileError::parser(format!("{e}"), span)
-        })
+        .map_err(parse_error)
+}
+
+/// Lex and parse `source` in one streaming pass
+///
+/// The parser pulls tokens straight from the lexer instead of going through
+/// a token vector. A lexer error takes precedence over the parse error it
+/// causes (the token stream simply ends there).
+pub fn parse_source(_filename: &str, source: &str) -> Result<Program> {
+    let mut tokens = lexer::tokens(source);
+    let parsed = grammar::ProgramParser::new().parse(tokens.by_ref());
+    if let Some(e) = tokens.take_error() {
+        return Err(e);
+    }
+    parsed.map_err(parse_error)
+}
+
+fn parse_error<E: std::fmt::Display>(e: lalrpop_util::ParseError<usize, Token, E>) -> CompileError {
+    let span = match &e {
+        lalrpop_util::ParseError::InvalidToken { location } => Span::new(*location, *location + 1),
+        lalrpop_util::ParseError::UnrecognizedEof { location, .. } => {
+            Span::new(*location, *location + 1)
+        }
+        lalrpop_util::ParseError::UnrecognizedToken { token, .. } => {
+            Span::new(token.0, token.2)
+        }
+        lalrpop_util::ParseError::ExtraToken { token } => Span::new(token.0, token.2),
+        lalrpop_util::ParseError::User { .. } => Span::new(0, 1),
+    };
+    CompileError::parser(format!("{e}"), span)
 }
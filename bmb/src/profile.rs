@@ -0,0 +1,322 @@
+//! Compile-time profiling for `bmb build --time-passes` and `--trace`
+//!
+//! A `Profiler` collects timed spans from any thread: compiler phases
+//! (lexing, parsing, type checking, ...), each MIR optimization pass run and
+//! the per-function optimization that contains them. Each span records wall
+//! time, the allocations made by its thread (via the binary's
+//! `CountingAlloc`; zero when it is not installed) and optionally an IR size.
+//!
+//! The spans can be summarized as a table (`report`) or written in Chrome
+//! trace-event format (`write_trace`), which `chrome://tracing` and Perfetto
+//! load directly. A disabled profiler records nothing and costs one branch
+//! per span.
+
+use std::collections::HashMap;
+use std::fmt::Write as _;
+use std::path::Path;
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+use crate::interp::alloc::AllocStats;
+
+/// What a span measures; the table groups rows by kind
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum SpanKind {
+    /// A pipeline phase (lex, parse, type check, codegen, clang, ...)
+    Phase,
+    /// One run of an optimization pass on one function
+    Pass,
+    /// Fixed-point optimization of one function (trace only)
+    Function,
+}
+
+impl SpanKind {
+    fn as_str(self) -> &'static str {
+        match self {
+            SpanKind::Phase => "phase",
+            SpanKind::Pass => "pass",
+            SpanKind::Function => "function",
+        }
+    }
+}
+
+#[derive(Debug, Clone)]
+struct Record {
+    kind: SpanKind,
+    name: String,
+    thread: u64,
+    start: Duration,
+    duration: Duration,
+    allocs: AllocStats,
+    /// Phase: IR size afterwards; pass: change in MIR instructions
+    size: Option<i64>,
+}
+
+/// Collects spans for one build
+#[derive(Debug)]
+pub struct Profiler {
+    enabled: bool,
+    origin: Instant,
+    records: Mutex<Vec<Record>>,
+}
+
+static NEXT_THREAD: AtomicU64 = AtomicU64::new(1);
+
+thread_local! {
+    static THREAD: u64 = NEXT_THREAD.fetch_add(1, Ordering::Relaxed);
+}
+
+impl Profiler {
+    /// A profiler that records spans
+    pub fn new() -> Self {
+        Self { enabled: true, origin: Instant::now(), records: Mutex::new(Vec::new()) }
+    }
+
+    /// A profiler that ignores every span
+    pub fn disabled() -> Self {
+        Self { enabled: false, ..Self::new() }
+    }
+
+    pub fn is_enabled(&self) -> bool {
+        self.enabled
+    }
+
+    /// Start a span; it is recorded when the guard is dropped
+    pub fn span(&self, kind: SpanKind, name: impl Into<String>) -> Span<'_> {
+        let state = self.enabled.then(|| SpanState {
+            kind,
+            name: name.into(),
+            start: Instant::now(),
+            allocs: AllocStats::current(),
+            size: None,
+        });
+        Span { profiler: self, state }
+    }
+
+    /// Time `f` as a span of `kind`
+    pub fn time<R>(&self, kind: SpanKind, name: &str, f: impl FnOnce() -> R) -> R {
+        let _span = self.span(kind, name);
+        f()
+    }
+
+    fn records(&self) -> Vec<Record> {
+        self.records.lock().map(|r| r.clone()).unwrap_or_default()
+    }
+
+    /// Summarize the recorded spans as a `--time-passes` table: phases in
+    /// pipeline order, then optimization passes by total time. Pass times
+    /// add up the work of all optimization threads.
+    pub fn report(&self) -> String {
+        let records = self.records();
+        let total = records
+            .iter()
+            .filter(|r| r.kind == SpanKind::Phase)
+            .map(|r| r.start + r.duration)
+            .max()
+            .unwrap_or_default()
+            .saturating_sub(records.iter().map(|r| r.start).min().unwrap_or_default());
+
+        struct Row {
+            name: String,
+            runs: usize,
+            time: Duration,
+            allocs: AllocStats,
+            size: Option<i64>,
+        }
+        let mut rows: Vec<(SpanKind, Row)> = Vec::new();
+        let mut index: HashMap<(SpanKind, String), usize> = HashMap::new();
+        for r in records.iter().filter(|r| r.kind != SpanKind::Function) {
+            let i = *index.entry((r.kind, r.name.clone())).or_insert_with(|| {
+                rows.push((r.kind, Row {
+                    name: r.name.clone(),
+                    runs: 0,
+                    time: Duration::ZERO,
+                    allocs: AllocStats::default(),
+                    size: None,
+                }));
+                rows.len() - 1
+            });
+            let row = &mut rows[i].1;
+            row.runs += 1;
+            row.time += r.duration;
+            row.allocs.count += r.allocs.count;
+            row.allocs.bytes += r.allocs.bytes;
+            row.size = match (r.kind, row.size, r.size) {
+                (SpanKind::Pass, Some(a), Some(b)) => Some(a + b),
+                (_, old, new) => new.or(old),
+            };
+        }
+        let (mut phases, mut passes): (Vec<_>, Vec<_>) =
+            rows.into_iter().partition(|(kind, _)| *kind == SpanKind::Phase);
+        passes.sort_by(|a, b| b.1.time.cmp(&a.1.time));
+
+        let mut out = String::new();
+        let _ = writeln!(
+            out,
+            "{:<28} {:>6} {:>11} {:>6} {:>10} {:>11} {:>10}",
+            "phase", "runs", "time", "%", "allocs", "alloc KiB", "IR size"
+        );
+        let section = |out: &mut String, title: &str, rows: &mut Vec<(SpanKind, Row)>| {
+            if rows.is_empty() {
+                return;
+            }
+            let _ = writeln!(out, "-- {}", title);
+            for (kind, row) in rows.drain(..) {
+                let pct = if total.is_zero() { 0.0 } else { 100.0 * row.time.as_secs_f64() / total.as_secs_f64() };
+                let size = match (kind, row.size) {
+                    (_, None) => String::new(),
+                    (SpanKind::Pass, Some(delta)) => format!("{:+}", delta),
+                    (_, Some(size)) => size.to_string(),
+                };
+                let _ = writeln!(
+                    out,
+                    "{:<28} {:>6} {:>11} {:>5.1}% {:>10} {:>11.1} {:>10}",
+                    row.name,
+                    row.runs,
+                    format!("{:.2?}", row.time),
+                    pct,
+                    row.allocs.count,
+                    row.allocs.bytes as f64 / 1024.0,
+                    size
+                );
+            }
+        };
+        section(&mut out, "phases", &mut phases);
+        section(&mut out, "MIR passes (time summed over threads, IR size = change in instructions)", &mut passes);
+        let _ = writeln!(out, "{:<28} {:>6} {:>11}", "total", "", format!("{:.2?}", total));
+        out
+    }
+
+    /// Write the spans as a Chrome trace (`{"traceEvents": [...]}`)
+    pub fn write_trace(&self, path: &Path) -> std::io::Result<()> {
+        let events: Vec<serde_json::Value> = self
+            .records()
+            .iter()
+            .map(|r| {
+                let mut args = serde_json::json!({
+                    "allocs": r.allocs.count,
+                    "alloc_bytes": r.allocs.bytes,
+                });
+                if let Some(size) = r.size {
+                    args["ir_size"] = size.into();
+                }
+                serde_json::json!({
+                    "name": r.name,
+                    "cat": r.kind.as_str(),
+                    "ph": "X",
+                    "ts": r.start.as_secs_f64() * 1e6,
+                    "dur": r.duration.as_secs_f64() * 1e6,
+                    "pid": 1,
+                    "tid": r.thread,
+                    "args": args,
+                })
+            })
+            .collect();
+        let trace = serde_json::json!({ "traceEvents": events, "displayTimeUnit": "ms" });
+        std::fs::write(path, serde_json::to_string(&trace)?)
+    }
+}
+
+impl Default for Profiler {
+    fn default() -> Self {
+        Self::disabled()
+    }
+}
+
+struct SpanState {
+    kind: SpanKind,
+    name: String,
+    start: Instant,
+    allocs: AllocStats,
+    size: Option<i64>,
+}
+
+/// An open span; records itself when dropped
+pub struct Span<'a> {
+    profiler: &'a Profiler,
+    state: Option<SpanState>,
+}
+
+impl Span<'_> {
+    /// Attach an IR size (tokens, items, instructions, bytes) to the span
+    pub fn set_size(&mut self, size: impl TryInto<i64>) {
+        if let Some(state) = &mut self.state {
+            state.size = size.try_into().ok();
+        }
+    }
+
+    /// Whether the span is being recorded (skip computing sizes otherwise)
+    pub fn is_recording(&self) -> bool {
+        self.state.is_some()
+    }
+
+    /// End the span now rather than at the end of the scope
+    pub fn finish(self) {}
+}
+
+impl Drop for Span<'_> {
+    fn drop(&mut self) {
+        let Some(state) = self.state.take() else { return };
+        let record = Record {
+            kind: state.kind,
+            name: state.name,
+            thread: THREAD.with(|t| *t),
+            start: state.start.duration_since(self.profiler.origin),
+            duration: state.start.elapsed(),
+            allocs: AllocStats::current().since(state.allocs),
+            size: state.size,
+        };
+        if let Ok(mut records) = self.profiler.records.lock() {
+            records.push(record);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_profiler_report_and_trace() {
+        let profiler = Profiler::new();
+        {
+            let mut span = profiler.span(SpanKind::Phase, "lex");
+            span.set_size(42usize);
+        }
+        std::thread::scope(|scope| {
+            for _ in 0..2 {
+                scope.spawn(|| {
+                    let _f = profiler.span(SpanKind::Function, "main");
+                    let mut pass = profiler.span(SpanKind::Pass, "constant_folding");
+                    pass.set_size(-3);
+                });
+            }
+        });
+
+        let report = profiler.report();
+        let lex = report.lines().find(|l| l.starts_with("lex ")).unwrap();
+        assert!(lex.ends_with(" 42"), "{}", lex);
+        let pass = report.lines().find(|l| l.starts_with("constant_folding")).unwrap();
+        assert!(pass.contains(" 2 ") && pass.ends_with(" -6"), "{}", pass);
+        assert!(!report.contains("main"));
+
+        let path = std::env::temp_dir().join(format!("bmb_trace_{}.json", std::process::id()));
+        profiler.write_trace(&path).unwrap();
+        let trace: serde_json::Value = serde_json::from_str(&std::fs::read_to_string(&path).unwrap()).unwrap();
+        let _ = std::fs::remove_file(&path);
+        let events = trace["traceEvents"].as_array().unwrap();
+        assert_eq!(events.len(), 5);
+        assert!(events.iter().all(|e| e["ph"] == "X"));
+        assert_eq!(events.iter().filter(|e| e["cat"] == "function").count(), 2);
+    }
+
+    #[test]
+    fn test_disabled_profiler_records_nothing() {
+        let profiler = Profiler::disabled();
+        let span = profiler.span(SpanKind::Phase, "parse");
+        assert!(!span.is_recording());
+        drop(span);
+        assert!(profiler.records().is_empty());
+    }
+}
@@ -10,6 +10,7 @@
 
 use crate::index::{FunctionEntry, ProjectIndex, SymbolEntry, SymbolKind, TypeEntry};
 use serde::{Deserialize, Serialize};
+use std::collections::{HashMap, HashSet, VecDeque};
 use std::path::Path;
 
 /// Query result wrapper
@@ -34,28 +35,123 @@ pub struct QueryError {
 }
 
 /// Query engine for the index
+///
+/// The engine is built once per index and kept resident by `bmb q serve`, so
+/// `new` precomputes everything a query would otherwise rediscover with a
+/// linear scan: name lookups, lowercased symbol names (sorted for prefix
+/// search) and the reverse call graph used by `deps --reverse` and `impact`.
 pub struct QueryEngine {
     index: ProjectIndex,
+    /// Function name -> position in `index.functions`
+    functions_by_name: HashMap<String, usize>,
+    /// Type name -> position in `index.types`
+    types_by_name: HashMap<String, usize>,
+    /// Lowercased symbol names, parallel to `index.symbols`
+    symbol_names_lower: Vec<String>,
+    /// Positions in `index.symbols`, ordered by lowercased name
+    symbols_sorted: Vec<usize>,
+    /// Callee name -> positions of the functions that call it (self-calls excluded)
+    callers: HashMap<String, Vec<usize>>,
 }
 
 impl QueryEngine {
     pub fn new(index: ProjectIndex) -> Self {
-        Self { index }
+        let mut functions_by_name = HashMap::with_capacity(index.functions.len());
+        let mut callers: HashMap<String, Vec<usize>> = HashMap::new();
+        for (i, f) in index.functions.iter().enumerate() {
+            functions_by_name.entry(f.name.clone()).or_insert(i);
+            if let Some(body) = &f.body_info {
+                let mut seen = HashSet::new();
+                for callee in &body.calls {
+                    if *callee != f.name && seen.insert(callee.as_str()) {
+                        callers.entry(callee.clone()).or_default().push(i);
+                    }
+                }
+            }
+        }
+
+        let mut types_by_name = HashMap::with_capacity(index.types.len());
+        for (i, t) in index.types.iter().enumerate() {
+            types_by_name.entry(t.name.clone()).or_insert(i);
+        }
+
+        let symbol_names_lower: Vec<String> =
+            index.symbols.iter().map(|s| s.name.to_lowercase()).collect();
+        let mut symbols_sorted: Vec<usize> = (0..index.symbols.len()).collect();
+        symbols_sorted.sort_by(|&a, &b| symbol_names_lower[a].cmp(&symbol_names_lower[b]));
+
+        Self {
+            index,
+            functions_by_name,
+            types_by_name,
+            symbol_names_lower,
+            symbols_sorted,
+            callers,
+        }
+    }
+
+    /// The index this engine answers queries from
+    pub fn index(&self) -> &ProjectIndex {
+        &self.index
+    }
+
+    fn find_function(&self, name: &str) -> Option<&FunctionEntry> {
+        self.functions_by_name.get(name).map(|&i| &self.index.functions[i])
+    }
+
+    fn find_type(&self, name: &str) -> Option<&TypeEntry> {
+        self.types_by_name.get(name).map(|&i| &self.index.types[i])
+    }
+
+    /// Functions that call `name` directly, in index order
+    fn direct_callers(&self, name: &str) -> impl Iterator<Item = &FunctionEntry> {
+        self.callers
+            .get(name)
+            .into_iter()
+            .flatten()
+            .map(|&i| &self.index.functions[i])
     }
 
     /// Query symbols by pattern
     pub fn query_symbols(&self, pattern: &str, kind: Option<SymbolKind>, pub_only: bool) -> QueryResult<SymbolEntry> {
         let pattern_lower = pattern.to_lowercase();
+        let candidates = (0..self.index.symbols.len())
+            .filter(|&i| self.symbol_names_lower[i].contains(&pattern_lower));
+        self.symbol_result(pattern, candidates, kind, pub_only)
+    }
 
-        let matches: Vec<SymbolEntry> = self
-            .index
-            .symbols
+    /// Query symbols whose name starts with `prefix` (case-insensitive)
+    ///
+    /// Served from the sorted name table with a binary search, so the cost
+    /// depends on the number of matches rather than the size of the index.
+    pub fn query_symbols_prefix(&self, prefix: &str, kind: Option<SymbolKind>, pub_only: bool) -> QueryResult<SymbolEntry> {
+        let prefix_lower = prefix.to_lowercase();
+        let start = self
+            .symbols_sorted
+            .partition_point(|&i| self.symbol_names_lower[i].as_str() < prefix_lower.as_str());
+        let mut candidates: Vec<usize> = self.symbols_sorted[start..]
             .iter()
+            .copied()
+            .take_while(|&i| self.symbol_names_lower[i].starts_with(&prefix_lower))
+            .collect();
+        // Report prefix matches in index order, like substring matches
+        candidates.sort_unstable();
+        self.symbol_result(prefix, candidates.into_iter(), kind, pub_only)
+    }
+
+    fn symbol_result(
+        &self,
+        pattern: &str,
+        candidates: impl Iterator<Item = usize>,
+        kind: Option<SymbolKind>,
+        pub_only: bool,
+    ) -> QueryResult<SymbolEntry> {
+        let matches: Vec<SymbolEntry> = candidates
+            .map(|i| &self.index.symbols[i])
             .filter(|s| {
-                let name_match = s.name.to_lowercase().contains(&pattern_lower);
                 let kind_match = kind.is_none_or(|k| s.kind == k);
                 let pub_match = !pub_only || s.is_pub;
-                name_match && kind_match && pub_match
+                kind_match && pub_match
             })
             .cloned()
             .collect();
@@ -83,7 +179,7 @@ impl QueryEngine {
 
     /// Query function by name
     pub fn query_function(&self, name: &str) -> QueryResult<FunctionEntry> {
-        let func = self.index.functions.iter().find(|f| f.name == name);
+        let func = self.find_function(name);
 
         match func {
             Some(f) => QueryResult {
@@ -143,7 +239,7 @@ impl QueryEngine {
 
     /// Query type by name
     pub fn query_type(&self, name: &str) -> QueryResult<TypeEntry> {
-        let ty = self.index.types.iter().find(|t| t.name == name);
+        let ty = self.find_type(name);
 
         match ty {
             Some(t) => QueryResult {
@@ -245,12 +341,10 @@ impl QueryEngine {
         self.index
             .symbols
             .iter()
-            .filter(|s| {
-                let name_lower = s.name.to_lowercase();
-                levenshtein(&name_lower, &pattern_lower) <= 3
-            })
+            .zip(&self.symbol_names_lower)
+            .filter(|(_, name_lower)| levenshtein(name_lower, &pattern_lower) <= 3)
             .take(5)
-            .map(|s| s.name.clone())
+            .map(|(s, _)| s.name.clone())
             .collect()
     }
 
@@ -466,7 +560,7 @@ impl QueryEngine {
 
     fn query_function_deps(&self, name: &str, reverse: bool, transitive: bool) -> DepsResult {
         // Find the target function
-        let func = self.index.functions.iter().find(|f| f.name == name);
+        let func = self.find_function(name);
 
         match func {
             Some(f) => {
@@ -490,24 +584,19 @@ impl QueryEngine {
 
                 // Get transitive calls if requested
                 if transitive {
-                    let mut visited = std::collections::HashSet::new();
+                    let mut visited = HashSet::new();
                     visited.insert(name.to_string());
                     self.collect_transitive_calls(&calls, &mut visited, &mut calls.clone());
                 }
 
                 // Find who calls this function (reverse deps)
                 if reverse {
-                    for other_fn in &self.index.functions {
-                        if let Some(body) = &other_fn.body_info
-                            && body.calls.contains(&name.to_string())
-                            && other_fn.name != name
-                        {
-                            called_by.push(CallerInfo {
-                                name: other_fn.name.clone(),
-                                file: other_fn.file.clone(),
-                                line: other_fn.line,
-                            });
-                        }
+                    for other_fn in self.direct_callers(name) {
+                        called_by.push(CallerInfo {
+                            name: other_fn.name.clone(),
+                            file: other_fn.file.clone(),
+                            line: other_fn.line,
+                        });
                     }
                 }
 
@@ -536,7 +625,7 @@ impl QueryEngine {
     fn collect_transitive_calls(
         &self,
         current_calls: &[CallInfo],
-        visited: &mut std::collections::HashSet<String>,
+        visited: &mut HashSet<String>,
         all_calls: &mut Vec<CallInfo>,
     ) {
         for call in current_calls {
@@ -545,7 +634,7 @@ impl QueryEngine {
             }
             visited.insert(call.name.clone());
 
-            if let Some(func) = self.index.functions.iter().find(|f| f.name == call.name)
+            if let Some(func) = self.find_function(&call.name)
                 && let Some(body) = &func.body_info
             {
                 for nested_call in &body.calls {
@@ -564,7 +653,7 @@ impl QueryEngine {
     }
 
     fn query_type_deps(&self, name: &str, reverse: bool) -> DepsResult {
-        let type_entry = self.index.types.iter().find(|t| t.name == name);
+        let type_entry = self.find_type(name);
 
         match type_entry {
             Some(_t) => {
@@ -611,7 +700,7 @@ impl QueryEngine {
 
     /// v0.47: Query contract details for a function
     pub fn query_contract(&self, name: &str, uses_old_filter: bool) -> ContractResult {
-        let func = self.index.functions.iter().find(|f| f.name == name);
+        let func = self.find_function(name);
 
         match func {
             Some(f) => {
@@ -708,7 +797,7 @@ impl QueryEngine {
     }
 
     fn query_function_context(&self, name: &str, depth: usize, include_tests: bool) -> ContextResult {
-        let func = self.index.functions.iter().find(|f| f.name == name);
+        let func = self.find_function(name);
 
         match func {
             Some(f) => {
@@ -746,7 +835,7 @@ impl QueryEngine {
                 // Collect dependencies
                 let mut dep_functions = Vec::new();
                 let mut dep_types = Vec::new();
-                let mut visited = std::collections::HashSet::new();
+                let mut visited = HashSet::new();
                 visited.insert(name.to_string());
 
                 if let Some(body) = &f.body_info {
@@ -760,19 +849,14 @@ impl QueryEngine {
                 self.add_type_to_context(&f.signature.return_type, &mut dep_types);
 
                 // Find dependents (reverse deps)
-                let mut dependents = Vec::new();
-                for other_fn in &self.index.functions {
-                    if let Some(body) = &other_fn.body_info
-                        && body.calls.contains(&name.to_string())
-                        && other_fn.name != name
-                    {
-                        dependents.push(DependentInfo {
-                            name: other_fn.name.clone(),
-                            file: other_fn.file.clone(),
-                            line: other_fn.line,
-                        });
-                    }
-                }
+                let dependents: Vec<DependentInfo> = self
+                    .direct_callers(name)
+                    .map(|other_fn| DependentInfo {
+                        name: other_fn.name.clone(),
+                        file: other_fn.file.clone(),
+                        line: other_fn.line,
+                    })
+                    .collect();
 
                 // Find related tests
                 let related_tests = if include_tests {
@@ -832,7 +916,7 @@ impl QueryEngine {
         &self,
         calls: &[String],
         depth: usize,
-        visited: &mut std::collections::HashSet<String>,
+        visited: &mut HashSet<String>,
         dep_functions: &mut Vec<TargetInfo>,
     ) {
         if depth == 0 {
@@ -845,7 +929,7 @@ impl QueryEngine {
             }
             visited.insert(call_name.clone());
 
-            if let Some(func) = self.index.functions.iter().find(|f| &f.name == call_name) {
+            if let Some(func) = self.find_function(call_name) {
                 let contracts_summary = func.contracts.as_ref().map(|c| {
                     let mut parts = Vec::new();
                     if let Some(pre) = &c.pre {
@@ -904,7 +988,7 @@ impl QueryEngine {
         }
 
         // Find type in index
-        if let Some(type_entry) = self.index.types.iter().find(|t| t.name == base_name) {
+        if let Some(type_entry) = self.find_type(base_name) {
             dep_types.push(TargetInfo {
                 kind: type_entry.kind.clone(),
                 name: type_entry.name.clone(),
@@ -917,7 +1001,7 @@ impl QueryEngine {
     }
 
     fn query_type_context(&self, name: &str, include_tests: bool) -> ContextResult {
-        let type_entry = self.index.types.iter().find(|t| t.name == name);
+        let type_entry = self.find_type(name);
 
         match type_entry {
             Some(t) => {
@@ -1224,30 +1308,40 @@ impl QueryEngine {
         }
 
         // Find the function
-        let func = self.index.functions.iter().find(|f| f.name == name);
+        let func = self.find_function(name);
 
         match func {
             Some(_f) => {
                 // Find direct callers
-                let mut direct_callers = Vec::new();
-                let mut files_affected = std::collections::HashSet::new();
-
-                for other_fn in &self.index.functions {
-                    if let Some(body) = &other_fn.body_info
-                        && body.calls.contains(&name.to_string())
-                        && other_fn.name != name
-                    {
-                        direct_callers.push(CallerInfo {
-                            name: other_fn.name.clone(),
-                            file: other_fn.file.clone(),
-                            line: other_fn.line,
-                        });
-                        files_affected.insert(other_fn.file.clone());
+                let direct_callers: Vec<CallerInfo> = self
+                    .direct_callers(name)
+                    .map(|other_fn| CallerInfo {
+                        name: other_fn.name.clone(),
+                        file: other_fn.file.clone(),
+                        line: other_fn.line,
+                    })
+                    .collect();
+
+                // Walk the reverse call graph: every function that can reach
+                // the target through some call chain is affected
+                let mut reached: HashSet<usize> = HashSet::new();
+                let mut queue: VecDeque<&str> = VecDeque::from([name]);
+                while let Some(callee) = queue.pop_front() {
+                    for &i in self.callers.get(callee).into_iter().flatten() {
+                        let caller = &self.index.functions[i];
+                        if caller.name != name && reached.insert(i) {
+                            queue.push_back(&caller.name);
+                        }
                     }
                 }
-
-                // Count transitive callers (simplified: just count direct for now)
-                let transitive_callers = direct_callers.len();
+                let transitive_callers = reached.len();
+                let mut files_affected: Vec<String> = reached
+                    .iter()
+                    .map(|&i| self.index.functions[i].file.clone())
+                    .collect::<HashSet<_>>()
+                    .into_iter()
+                    .collect();
+                files_affected.sort();
 
                 // Determine if breaking based on change description
                 let breaking = change.contains("add param")
@@ -1262,7 +1356,7 @@ impl QueryEngine {
                         breaking,
                         direct_callers,
                         transitive_callers,
-                        files_affected: files_affected.into_iter().collect(),
+                        files_affected,
                     },
                     error: None,
                 }
@@ -1522,4 +1616,69 @@ mod tests {
         assert_eq!(levenshtein("hello", "helo"), 1);
         assert_eq!(levenshtein("kitten", "sitting"), 3);
     }
+
+    fn engine(call_graph: &[(&str, &[&str])]) -> QueryEngine {
+        use crate::index::{BodyInfo, FunctionSignature, IndexGenerator};
+
+        let mut index = IndexGenerator::new("demo").generate();
+        for (i, (name, calls)) in call_graph.iter().enumerate() {
+            index.functions.push(FunctionEntry {
+                name: name.to_string(),
+                file: format!("{}.bmb", name),
+                line: 1,
+                is_pub: true,
+                signature: FunctionSignature { params: Vec::new(), return_type: "i64".to_string() },
+                contracts: None,
+                body_info: Some(BodyInfo {
+                    calls: calls.iter().map(|c| c.to_string()).collect(),
+                    recursive: calls.contains(name),
+                    has_loop: false,
+                }),
+            });
+            index.symbols.push(SymbolEntry {
+                kind: SymbolKind::Function,
+                name: name.to_string(),
+                file: format!("{}.bmb", name),
+                line: i + 1,
+                is_pub: true,
+                signature: None,
+                doc: None,
+            });
+        }
+        QueryEngine::new(index)
+    }
+
+    fn names(result: &QueryResult<SymbolEntry>) -> Vec<&str> {
+        result.matches.iter().flatten().map(|s| s.name.as_str()).collect()
+    }
+
+    #[test]
+    fn test_symbol_prefix_lookup() {
+        let engine = engine(&[("parse_expr", &[]), ("ParseItem", &[]), ("unparse", &[]), ("par", &[])]);
+        assert_eq!(names(&engine.query_symbols_prefix("parse", None, false)), ["parse_expr", "ParseItem"]);
+        assert_eq!(names(&engine.query_symbols("parse", None, false)), ["parse_expr", "ParseItem", "unparse"]);
+        assert!(engine.query_symbols_prefix("zzz", None, false).error.is_some());
+    }
+
+    #[test]
+    fn test_impact_counts_transitive_callers() {
+        // main -> run -> step -> leaf, and leaf is also called by the recursive helper
+        let engine = engine(&[
+            ("leaf", &[]),
+            ("step", &["leaf", "leaf"]),
+            ("run", &["step"]),
+            ("main", &["run", "step"]),
+            ("helper", &["helper", "leaf"]),
+        ]);
+        let impact = engine.query_impact("fn:leaf", "rename").impact;
+        let direct: Vec<&str> = impact.direct_callers.iter().map(|c| c.name.as_str()).collect();
+        assert_eq!(direct, ["step", "helper"]);
+        assert_eq!(impact.transitive_callers, 4);
+        assert_eq!(impact.files_affected, ["helper.bmb", "main.bmb", "run.bmb", "step.bmb"]);
+        assert!(impact.breaking);
+
+        let deps = engine.query_deps("fn:step", true, false);
+        let callers: Vec<&str> = deps.called_by.iter().map(|c| c.name.as_str()).collect();
+        assert_eq!(callers, ["run", "main"]);
+    }
 }
@@ -1,5 +1,6 @@
 //! REPL (Read-Eval-Print Loop) for BMB
 
+use crate::ast::{FnDef, Item, Program};
 use crate::interp::Interpreter;
 use crate::lexer::tokenize;
 use crate::parser::parse;
@@ -15,6 +16,10 @@ pub struct Repl {
     editor: DefaultEditor,
     interpreter: Interpreter,
     history_path: Option<PathBuf>,
+    /// Functions defined so far, so each input sees earlier definitions
+    definitions: Vec<FnDef>,
+    /// Evaluate on the bytecode VM (`:vm`)
+    use_vm: bool,
 }
 
 impl Repl {
@@ -30,6 +35,8 @@ impl Repl {
             editor,
             interpreter,
             history_path,
+            definitions: Vec::new(),
+            use_vm: false,
         };
 
         // Load history if available
@@ -106,6 +113,11 @@ impl Repl {
                 print!("\x1B[2J\x1B[1;1H");
                 false
             }
+            ":vm" => {
+                self.use_vm = !self.use_vm;
+                println!("Bytecode VM {}", if self.use_vm { "on" } else { "off" });
+                false
+            }
             _ => {
                 println!("Unknown command: {cmd}");
                 println!("Type :help for help.");
@@ -120,6 +132,7 @@ impl Repl {
         println!("  :help, :h, :?   Show this help");
         println!("  :quit, :q       Exit the REPL");
         println!("  :clear          Clear the screen");
+        println!("  :vm             Toggle the bytecode VM");
         println!();
         println!("You can enter:");
         println!("  - Expressions: 1 + 2, if true then 1 else 2");
@@ -162,14 +175,14 @@ impl Repl {
 
             // Parse
             let program = match parse("<repl>", &source, tokens) {
-                Ok(p) => p,
+                Ok(p) => self.with_definitions(p),
                 Err(e) => {
                     last_error = Some(format!("Parse error: {}", e.message()));
                     continue;
                 }
             };
 
-            // Type check (without function registration for now)
+            // Type check together with earlier definitions
             let mut checker = crate::types::TypeChecker::new();
             if checker.check_program(&program).is_err() {
                 // Type check failed, try next type
@@ -177,6 +190,22 @@ impl Repl {
             }
 
             // Type check passed, now run it
+            if self.use_vm {
+                match crate::vm::compile_ast(&program, "__repl__") {
+                    Ok(compiled) => {
+                        match crate::vm::run(&compiled) {
+                            Ok(value) => {
+                                if !matches!(value, crate::interp::Value::Unit) {
+                                    println!("{value}");
+                                }
+                            }
+                            Err(err) => eprintln!("Runtime error: {}", err.message),
+                        }
+                        return;
+                    }
+                    Err(e) => eprintln!("note: {e}; using the interpreter"),
+                }
+            }
             self.interpreter.load(&program);
             match self.interpreter.run(&program) {
                 Ok(value) => {
@@ -226,6 +255,7 @@ impl Repl {
         match parse("<repl>", source, tokens) {
             Ok(program) => {
                 // Load any function definitions
+                self.remember_definitions(&program);
                 self.interpreter.load(&program);
 
                 // Run the program (which will call __repl__ or main)
@@ -248,6 +278,25 @@ impl Repl {
     }
 }
 
+impl Repl {
+    /// Record (or replace) the functions a definition input declares
+    fn remember_definitions(&mut self, program: &Program) {
+        for item in &program.items {
+            if let Item::FnDef(def) = item {
+                self.definitions.retain(|d| d.name.node != def.name.node);
+                self.definitions.push(def.clone());
+            }
+        }
+    }
+
+    /// Prepend earlier definitions to a wrapped expression
+    fn with_definitions(&self, program: Program) -> Program {
+        let mut items: Vec<Item> = self.definitions.iter().cloned().map(Item::FnDef).collect();
+        items.extend(program.items);
+        Program { header: program.header, items }
+    }
+}
+
 impl Default for Repl {
     fn default() -> Self {
         Self::new().expect("Failed to create REPL")
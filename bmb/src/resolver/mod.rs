@@ -99,6 +99,8 @@ pub struct Resolver {
     modules: HashMap<String, Module>,
     /// Module load order (for dependency tracking)
     load_order: Vec<String>,
+    /// Worker threads for parsing a program's imports (0 = one per core)
+    jobs: usize,
 }
 
 impl Resolver {
@@ -108,9 +110,16 @@ impl Resolver {
             base_dir: base_dir.as_ref().to_path_buf(),
             modules: HashMap::new(),
             load_order: Vec::new(),
+            jobs: 0,
         }
     }
 
+    /// Set the number of threads used to parse imported modules
+    pub fn with_jobs(mut self, jobs: usize) -> Self {
+        self.jobs = jobs;
+        self
+    }
+
     /// Get the base directory
     pub fn base_dir(&self) -> &Path {
         &self.base_dir
@@ -126,35 +135,8 @@ impl Resolver {
         // Resolve file path
         let file_path = self.resolve_module_path(module_name)?;
 
-        // Read the file
-        let source = std::fs::read_to_string(&file_path).map_err(|e| {
-            CompileError::io_error(format!(
-                "Failed to read module '{}' at {:?}: {}",
-                module_name, file_path, e
-            ))
-        })?;
-
-        // Tokenize
-        let tokens = crate::lexer::tokenize(&source)?;
-
-        // Parse
-        let program = crate::parser::parse(module_name, &source, tokens)?;
-
-        // Extract exports (pub items)
-        let exports = Self::extract_exports(&program);
-
-        // Create and store the module
-        let module = Module {
-            name: module_name.to_string(),
-            path: file_path,
-            program,
-            exports,
-        };
-
-        self.modules.insert(module_name.to_string(), module);
-        self.load_order.push(module_name.to_string());
-
-        Ok(self.modules.get(module_name).unwrap())
+        let module = Self::parse_module(module_name, file_path)?;
+        Ok(self.insert_module(module))
     }
 
     /// v0.70: Load a module with span for error localization
@@ -167,7 +149,13 @@ impl Resolver {
         // Resolve file path (with span for better error messages)
         let file_path = self.resolve_module_path_with_span(module_name, span)?;
 
-        // Read the file
+        let module = Self::parse_module(module_name, file_path)?;
+        Ok(self.insert_module(module))
+    }
+
+    /// Read and parse a module file (touches no resolver state, so it can
+    /// run on any thread)
+    fn parse_module(module_name: &str, file_path: PathBuf) -> Result<Module> {
         let source = std::fs::read_to_string(&file_path).map_err(|e| {
             CompileError::io_error(format!(
                 "Failed to read module '{}' at {:?}: {}",
@@ -175,27 +163,59 @@ impl Resolver {
             ))
         })?;
 
-        // Tokenize
-        let tokens = crate::lexer::tokenize(&source)?;
-
-        // Parse
-        let program = crate::parser::parse(module_name, &source, tokens)?;
+        // Lex and parse in one streaming pass
+        let program = crate::parser::parse_source(module_name, &source)?;
 
         // Extract exports (pub items)
         let exports = Self::extract_exports(&program);
 
-        // Create and store the module
-        let module = Module {
+        Ok(Module {
             name: module_name.to_string(),
             path: file_path,
             program,
             exports,
-        };
+        })
+    }
 
-        self.modules.insert(module_name.to_string(), module);
-        self.load_order.push(module_name.to_string());
+    /// Store a parsed module, recording its load order
+    fn insert_module(&mut self, module: Module) -> &Module {
+        let name = module.name.clone();
+        self.load_order.push(name.clone());
+        self.modules.entry(name).or_insert(module)
+    }
+
+    /// Parse every module a program imports that is not loaded yet
+    ///
+    /// Paths are resolved in `use` order up to the first module that cannot
+    /// be found, then those files are read and parsed concurrently. Modules
+    /// are stored in `use` order and the first failing module's error is
+    /// returned; the missing module itself is left for `resolve_use`.
+    fn preload_uses(&mut self, program: &Program) -> Result<()> {
+        let mut pending: Vec<(String, PathBuf)> = Vec::new();
+        for item in &program.items {
+            if let Item::Use(use_stmt) = item
+                && let Some(first) = use_stmt.path.first()
+                && !self.modules.contains_key(&first.node)
+                && !pending.iter().any(|(name, _)| *name == first.node)
+            {
+                match self.resolve_module_path_with_span(&first.node, first.span) {
+                    Ok(path) => pending.push((first.node.clone(), path)),
+                    // resolve_use reports it once it gets that far
+                    Err(_) => break,
+                }
+            }
+        }
 
-        Ok(self.modules.get(module_name).unwrap())
+        // A single module has nothing to overlap with; resolve_use loads it
+        if pending.len() >= 2 {
+            let parsed = crate::parallel::map(&pending, self.jobs, |(name, path)| {
+                Self::parse_module(name, path.clone())
+            });
+            for module in parsed {
+                self.insert_module(module?);
+            }
+        }
+        Ok(())
     }
 
     /// Resolve a module name to a file path
@@ -290,8 +310,8 @@ impl Resolver {
             match item {
                 Item::FnDef(fn_def) if fn_def.visibility == Visibility::Public => {
                     exports.insert(
-                        fn_def.name.node.clone(),
-                        ExportedItem::Function(fn_def.name.node.clone()),
+                        fn_def.name.node.to_string(),
+                        ExportedItem::Function(fn_def.name.node.to_string()),
                     );
                 }
                 Item::StructDef(struct_def) if struct_def.visibility == Visibility::Public => {
@@ -316,6 +336,7 @@ impl Resolver {
     /// Resolve all use statements in a program, loading required modules
     pub fn resolve_uses(&mut self, program: &Program) -> Result<ResolvedImports> {
         let mut imports = ResolvedImports::new();
+        self.preload_uses(program)?;
 
         for item in &program.items {
             if let Item::Use(use_stmt) = item {
@@ -483,6 +504,26 @@ mod tests {
         assert_eq!(resolver.module_count(), 0);
     }
 
+    #[test]
+    fn test_preload_leaves_missing_module_to_resolve_use() {
+        let dir = std::env::temp_dir().join(format!("bmb_resolver_{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let span = Span { start: 4, end: 11 };
+        let program = Program {
+            header: None,
+            items: vec![Item::Use(UseStmt {
+                path: vec![crate::ast::Spanned::new("missing".to_string(), span)],
+                span,
+            })],
+        };
+
+        let mut resolver = Resolver::new(&dir).with_jobs(4);
+        let err = resolver.resolve_uses(&program).unwrap_err();
+        assert!(err.message().contains("Module 'missing' not found"));
+        assert_eq!(resolver.module_count(), 0);
+        std::fs::remove_dir_all(&dir).ok();
+    }
+
     #[test]
     fn test_resolved_imports() {
         let mut imports = ResolvedImports::new();
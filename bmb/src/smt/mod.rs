@@ -4,7 +4,9 @@
 //! for contract verification (pre/post conditions).
 
 mod translator;
+mod session;
 mod solver;
 
 pub use translator::{SmtTranslator, SmtLibGenerator, TranslateError};
-pub use solver::{SmtSolver, SolverResult, VerifyResult, Counterexample};
+pub use session::{SessionPool, Z3Session};
+pub use solver::{SmtSolver, SolverResult, SolverError, VerifyResult, Counterexample};
@@ -0,0 +1,181 @@
+//! Long-lived Z3 sessions
+//!
+//! Starting a Z3 process dominates the cost of small verification queries.
+//! A session keeps one `z3 -in` process alive and runs each script inside
+//! `(push)`/`(pop)`, so declarations and assertions never leak between
+//! queries. `SessionPool` hands sessions to concurrent callers.
+
+use std::io::{BufRead, BufReader, Write};
+use std::process::{Child, ChildStdin, ChildStdout, Command, Stdio};
+use std::sync::Mutex;
+
+use super::solver::SolverError;
+
+/// One interactive Z3 process
+pub struct Z3Session {
+    child: Child,
+    stdin: ChildStdin,
+    stdout: BufReader<ChildStdout>,
+    /// Logic fixed by `(set-logic ...)` at startup, if any
+    logic: Option<String>,
+    /// Counter for end-of-query markers
+    queries: u64,
+}
+
+impl Z3Session {
+    /// Start a session; `timeout` (seconds) applies to each `(check-sat)`
+    pub fn start(z3_path: &str, timeout: u32, logic: Option<&str>) -> Result<Self, SolverError> {
+        let mut child = Command::new(z3_path)
+            .arg("-in")
+            .stdin(Stdio::piped())
+            .stdout(Stdio::piped())
+            .stderr(Stdio::null())
+            .spawn()
+            .map_err(|e| SolverError::ProcessError(format!("failed to start z3: {}", e)))?;
+
+        let stdin = child.stdin.take()
+            .ok_or_else(|| SolverError::ProcessError("z3 stdin unavailable".into()))?;
+        let stdout = child.stdout.take()
+            .ok_or_else(|| SolverError::ProcessError("z3 stdout unavailable".into()))?;
+
+        let mut session = Self {
+            child,
+            stdin,
+            stdout: BufReader::new(stdout),
+            logic: logic.map(str::to_string),
+            queries: 0,
+        };
+
+        let mut prelude = format!("(set-option :timeout {})\n", timeout.saturating_mul(1000));
+        if let Some(logic) = logic {
+            prelude.push_str(&format!("(set-logic {})\n", logic));
+        }
+        session.send(&prelude)?;
+        Ok(session)
+    }
+
+    /// Logic this session was started with
+    pub fn logic(&self) -> Option<&str> {
+        self.logic.as_deref()
+    }
+
+    /// Run one SMT-LIB2 script and return Z3's output for it
+    ///
+    /// `(set-logic ...)` lines are dropped (the session's logic applies).
+    /// A trailing `(get-info :reason-unknown)` lets callers tell a timeout
+    /// from a genuine `unknown`.
+    pub fn run(&mut self, script: &str) -> Result<String, SolverError> {
+        self.queries += 1;
+        let marker = format!("bmb-end-{}", self.queries);
+
+        let mut input = String::with_capacity(script.len() + 96);
+        input.push_str("(push 1)\n");
+        for line in script.lines() {
+            if !line.trim_start().starts_with("(set-logic") {
+                input.push_str(line);
+                input.push('\n');
+            }
+        }
+        input.push_str("(get-info :reason-unknown)\n(pop 1)\n");
+        input.push_str(&format!("(echo \"{}\")\n", marker));
+        self.send(&input)?;
+
+        let mut output = String::new();
+        let mut line = String::new();
+        loop {
+            line.clear();
+            let n = self.stdout.read_line(&mut line)
+                .map_err(|e| SolverError::ProcessError(format!("failed to read from z3: {}", e)))?;
+            if n == 0 {
+                return Err(SolverError::ProcessError("z3 session exited".into()));
+            }
+            if line.trim_end() == marker {
+                return Ok(output);
+            }
+            output.push_str(&line);
+        }
+    }
+
+    fn send(&mut self, text: &str) -> Result<(), SolverError> {
+        self.stdin.write_all(text.as_bytes())
+            .and_then(|_| self.stdin.flush())
+            .map_err(|e| SolverError::ProcessError(format!("failed to write to z3: {}", e)))
+    }
+}
+
+impl Drop for Z3Session {
+    fn drop(&mut self) {
+        let _ = self.child.kill();
+        let _ = self.child.wait();
+    }
+}
+
+/// Bounded pool of idle sessions shared by concurrent verifiers
+pub struct SessionPool {
+    idle: Mutex<Vec<Z3Session>>,
+}
+
+impl SessionPool {
+    pub fn new() -> Self {
+        Self { idle: Mutex::new(Vec::new()) }
+    }
+
+    /// Take an idle session started with `logic`, if one exists
+    pub fn checkout(&self, logic: Option<&str>) -> Option<Z3Session> {
+        let mut idle = self.idle.lock().unwrap_or_else(|e| e.into_inner());
+        let pos = idle.iter().position(|s| s.logic() == logic)?;
+        Some(idle.swap_remove(pos))
+    }
+
+    /// Return a healthy session; beyond `capacity` idle sessions it is closed
+    pub fn checkin(&self, session: Z3Session, capacity: usize) {
+        let mut idle = self.idle.lock().unwrap_or_else(|e| e.into_inner());
+        if idle.len() < capacity {
+            idle.push(session);
+        }
+    }
+
+    /// Number of idle sessions
+    pub fn idle_count(&self) -> usize {
+        self.idle.lock().unwrap_or_else(|e| e.into_inner()).len()
+    }
+}
+
+impl Default for SessionPool {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// The `(set-logic ...)` a script requests, if any
+pub fn script_logic(script: &str) -> Option<&str> {
+    script.lines().find_map(|line| {
+        line.trim()
+            .strip_prefix("(set-logic")
+            .and_then(|rest| rest.trim().strip_suffix(')'))
+            .map(str::trim)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_script_logic() {
+        assert_eq!(script_logic("; header\n(set-logic QF_LIA)\n(check-sat)\n"), Some("QF_LIA"));
+        assert_eq!(script_logic("(check-sat)\n"), None);
+    }
+
+    #[test]
+    fn test_session_roundtrip() {
+        // Needs a real z3; skipped where it is not installed
+        let Ok(mut session) = Z3Session::start("z3", 5, Some("QF_LIA")) else { return };
+        let sat = session.run("(declare-const x Int)\n(assert (> x 1))\n(check-sat)\n");
+        let Ok(sat) = sat else { return };
+        assert!(sat.starts_with("sat"));
+        // The pop discarded x's assertion
+        let unsat = session.run("(declare-const x Int)\n(assert (> x 1))\n(assert (< x 0))\n(check-sat)\n").unwrap();
+        assert!(unsat.starts_with("unsat"));
+    }
+}
@@ -1,10 +1,17 @@
 //! Z3 SMT solver interface via external process
 //!
-//! Invokes Z3 on generated SMT-LIB2 files and parses results.
+//! Invokes Z3 on generated SMT-LIB2 files and parses results. Queries run
+//! in pooled long-lived sessions (see `session`), and definite answers are
+//! memoized by script hash so `bmb verify` can persist them between runs.
 
 use std::collections::HashMap;
 use std::io::Write;
 use std::process::{Command, Stdio};
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+use super::session::{script_logic, SessionPool, Z3Session};
+use crate::build::cache::ContentHasher;
 
 /// SMT solver interface
 pub struct SmtSolver {
@@ -12,6 +19,15 @@ pub struct SmtSolver {
     z3_path: String,
     /// Timeout in seconds
     timeout: u32,
+    /// Maximum idle sessions kept alive (0 = one process per query)
+    sessions: usize,
+    /// Idle Z3 sessions
+    pool: SessionPool,
+    /// Sat/unsat answers keyed by script hash, with whether this solver
+    /// has asked for them (only those are worth persisting)
+    cache: Mutex<HashMap<String, (SolverResult, bool)>>,
+    /// Queries answered from the cache
+    cache_hits: AtomicUsize,
 }
 
 impl SmtSolver {
@@ -20,6 +36,10 @@ impl SmtSolver {
         Self {
             z3_path: "z3".to_string(),
             timeout: 10,
+            sessions: 1,
+            pool: SessionPool::new(),
+            cache: Mutex::new(HashMap::new()),
+            cache_hits: AtomicUsize::new(0),
         }
     }
 
@@ -35,6 +55,42 @@ impl SmtSolver {
         self
     }
 
+    /// Keep up to `n` Z3 sessions alive for concurrent callers;
+    /// 0 starts a fresh process for every query
+    pub fn with_sessions(mut self, n: usize) -> Self {
+        self.sessions = n;
+        self
+    }
+
+    /// Cache key of an SMT-LIB2 script
+    pub fn script_key(smt_script: &str) -> String {
+        ContentHasher::new().field(smt_script.as_bytes()).finish()
+    }
+
+    /// Seed the result cache, e.g. from a saved proof index
+    pub fn preload_cache(&self, entries: impl IntoIterator<Item = (String, SolverResult)>) {
+        let mut cache = self.cache.lock().unwrap_or_else(|e| e.into_inner());
+        cache.extend(entries.into_iter().map(|(k, v)| (k, (v, false))));
+    }
+
+    /// Sat/unsat answers for the scripts solved so far (fresh or from the
+    /// cache), sorted by key; preloaded entries never asked for are dropped
+    pub fn cached_results(&self) -> Vec<(String, SolverResult)> {
+        let cache = self.cache.lock().unwrap_or_else(|e| e.into_inner());
+        let mut entries: Vec<_> = cache
+            .iter()
+            .filter(|(_, (_, used))| *used)
+            .map(|(k, (v, _))| (k.clone(), v.clone()))
+            .collect();
+        entries.sort_by(|a, b| a.0.cmp(&b.0));
+        entries
+    }
+
+    /// Number of queries answered from the cache
+    pub fn cache_hits(&self) -> usize {
+        self.cache_hits.load(Ordering::Relaxed)
+    }
+
     /// Check if Z3 is available
     pub fn is_available(&self) -> bool {
         Command::new(&self.z3_path)
@@ -47,7 +103,58 @@ impl SmtSolver {
     }
 
     /// Run Z3 on the given SMT-LIB2 script
+    ///
+    /// Answers come from the cache when the identical script was solved
+    /// before; only sat/unsat are cached, since unknown and timeout may
+    /// resolve differently with another timeout or solver load.
     pub fn solve(&self, smt_script: &str) -> Result<SolverResult, SolverError> {
+        let key = Self::script_key(smt_script);
+        if let Some((hit, used)) = self.cache.lock().unwrap_or_else(|e| e.into_inner()).get_mut(&key) {
+            *used = true;
+            self.cache_hits.fetch_add(1, Ordering::Relaxed);
+            return Ok(hit.clone());
+        }
+
+        let result = if self.sessions > 0 {
+            self.solve_in_session(smt_script)
+        } else {
+            self.solve_once(smt_script)
+        };
+
+        if let Ok(answer @ (SolverResult::Sat(_) | SolverResult::Unsat)) = &result {
+            self.cache.lock().unwrap_or_else(|e| e.into_inner()).insert(key, (answer.clone(), true));
+        }
+        result
+    }
+
+    /// Solve on a pooled session, falling back to a one-shot process if
+    /// a session cannot be started or dies mid-query
+    fn solve_in_session(&self, smt_script: &str) -> Result<SolverResult, SolverError> {
+        let logic = script_logic(smt_script);
+        let session = match self.pool.checkout(logic) {
+            Some(session) => Ok(session),
+            None => Z3Session::start(&self.z3_path, self.timeout, logic),
+        };
+        let Ok(mut session) = session else {
+            return self.solve_once(smt_script);
+        };
+
+        match session.run(smt_script) {
+            Ok(output) => {
+                self.pool.checkin(session, self.sessions);
+                match self.parse_result(&output)? {
+                    SolverResult::Unknown if output.contains("\"timeout\"") || output.contains("canceled") => {
+                        Ok(SolverResult::Timeout)
+                    }
+                    other => Ok(other),
+                }
+            }
+            Err(_) => self.solve_once(smt_script),
+        }
+    }
+
+    /// Run one Z3 process for the script
+    fn solve_once(&self, smt_script: &str) -> Result<SolverResult, SolverError> {
         let mut child = Command::new(&self.z3_path)
             .arg("-in")
             .arg(format!("-T:{}", self.timeout))
@@ -312,6 +419,22 @@ mod tests {
         assert_eq!(solver.timeout, 10);
     }
 
+    #[test]
+    fn test_solve_uses_cache() {
+        // A missing binary proves the answer never reached a process
+        let solver = SmtSolver::new().with_path("/nonexistent/z3");
+        let script = "(set-logic QF_LIA)\n(check-sat)\n";
+        solver.preload_cache([
+            (SmtSolver::script_key(script), SolverResult::Unsat),
+            ("stale".to_string(), SolverResult::Unsat),
+        ]);
+
+        assert!(matches!(solver.solve(script), Ok(SolverResult::Unsat)));
+        assert_eq!(solver.cache_hits(), 1);
+        assert!(solver.solve("(check-sat)\n").is_err());
+        assert_eq!(solver.cached_results().len(), 1);
+    }
+
     #[test]
     fn test_solver_with_options() {
         let solver = SmtSolver::new()
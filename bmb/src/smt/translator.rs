@@ -103,7 +103,7 @@ impl SmtTranslator {
             let sort = Self::type_to_sort(&param.ty.node);
             let name = &param.name.node;
             generator.declare_var(name, sort);
-            self.var_types.insert(name.clone(), sort);
+            self.var_types.insert(name.to_string(), sort);
         }
 
         // Declare __ret__ for return value
@@ -192,10 +192,10 @@ impl SmtTranslator {
             Expr::Unit => Ok("true".to_string()),
 
             Expr::Var(name) => {
-                if self.var_types.contains_key(name) {
-                    Ok(name.clone())
+                if self.var_types.contains_key(name.as_str()) {
+                    Ok(name.to_string())
                 } else {
-                    Err(TranslateError::UndefinedVariable(name.clone()))
+                    Err(TranslateError::UndefinedVariable(name.to_string()))
                 }
             }
 
@@ -42,6 +42,25 @@ pub enum Constructor {
     ArrayRest { min_size: usize },
 }
 
+/// Constructor of a literal pattern
+pub(crate) fn literal_constructor(lit: &LiteralPattern) -> Constructor {
+    match lit {
+        LiteralPattern::Int(n) => Constructor::IntLit(*n),
+        LiteralPattern::Float(f) => Constructor::FloatLit(f.to_bits()),
+        LiteralPattern::Bool(b) => Constructor::BoolLit(*b),
+        LiteralPattern::String(s) => Constructor::StringLit(s.clone()),
+    }
+}
+
+/// Constructor of a range pattern, as an inclusive integer range
+pub(crate) fn range_constructor(start: &LiteralPattern, end: &LiteralPattern, inclusive: bool) -> Constructor {
+    let (start, end) = match (start, end) {
+        (LiteralPattern::Int(s), LiteralPattern::Int(e)) => (*s, if inclusive { *e } else { *e - 1 }),
+        _ => (i64::MIN, i64::MAX), // Non-int ranges match everything
+    };
+    Constructor::IntRange { start, end }
+}
+
 /// Result of exhaustiveness check
 #[derive(Debug)]
 pub struct ExhaustivenessResult {
@@ -76,18 +95,10 @@ impl DeconstructedPattern {
         match pattern {
             Pattern::Wildcard | Pattern::Var(_) => DeconstructedPattern::wildcard(),
 
-            Pattern::Literal(lit) => {
-                let ctor = match lit {
-                    LiteralPattern::Int(n) => Constructor::IntLit(*n),
-                    LiteralPattern::Float(f) => Constructor::FloatLit(f.to_bits()),
-                    LiteralPattern::Bool(b) => Constructor::BoolLit(*b),
-                    LiteralPattern::String(s) => Constructor::StringLit(s.clone()),
-                };
-                DeconstructedPattern {
-                    constructor: ctor,
-                    fields: vec![],
-                }
-            }
+            Pattern::Literal(lit) => DeconstructedPattern {
+                constructor: literal_constructor(lit),
+                fields: vec![],
+            },
 
             Pattern::EnumVariant {
                 enum_name,
@@ -158,18 +169,10 @@ impl DeconstructedPattern {
                 start,
                 end,
                 inclusive,
-            } => {
-                let (s, e) = match (start, end) {
-                    (LiteralPattern::Int(s), LiteralPattern::Int(e)) => {
-                        (*s, if *inclusive { *e } else { *e - 1 })
-                    }
-                    _ => (i64::MIN, i64::MAX), // Non-int ranges match everything
-                };
-                DeconstructedPattern {
-                    constructor: Constructor::IntRange { start: s, end: e },
-                    fields: vec![],
-                }
-            }
+            } => DeconstructedPattern {
+                constructor: range_constructor(start, end, *inclusive),
+                fields: vec![],
+            },
 
             Pattern::Or(alts) => {
                 // For or-patterns, we expand them during analysis
@@ -362,7 +365,7 @@ fn substitute_type(ty: &Type, subst: &HashMap<String, Type>) -> Type {
 
 /// v0.57: Expand Or-patterns into multiple individual patterns
 /// e.g., `true | false` becomes [`true`, `false`]
-fn expand_or_pattern(pattern: &Pattern) -> Vec<&Pattern> {
+pub(crate) fn expand_or_pattern(pattern: &Pattern) -> Vec<&Pattern> {
     match pattern {
         Pattern::Or(alts) => {
             // Recursively expand nested Or-patterns
@@ -318,6 +318,8 @@ impl TypeChecker {
         functions.insert("assert".to_string(), (vec![Type::Bool], Type::Unit));
         // read_int() -> i64
         functions.insert("read_int".to_string(), (vec![], Type::I64));
+        // flush() -> i64 (writes buffered stdout, returns 0)
+        functions.insert("flush".to_string(), (vec![], Type::I64));
         // abs(n) -> i64
         functions.insert("abs".to_string(), (vec![Type::I64], Type::I64));
         // min(a, b) -> i64
@@ -336,6 +338,14 @@ impl TypeChecker {
         functions.insert("file_exists".to_string(), (vec![Type::String], Type::I64));
         // file_size(path: String) -> i64 (-1 = error)
         functions.insert("file_size".to_string(), (vec![Type::String], Type::I64));
+        // read_file_mapped(path: String) -> String (native: zero-copy mmap view)
+        functions.insert("read_file_mapped".to_string(), (vec![Type::String], Type::String));
+        // file_open(path: String) -> i64 (line reader handle, -1 = error)
+        functions.insert("file_open".to_string(), (vec![Type::String], Type::I64));
+        // read_line(handle: i64) -> String (next line with its newline, "" at EOF)
+        functions.insert("read_line".to_string(), (vec![Type::I64], Type::String));
+        // file_close(handle: i64) -> i64 (0 = closed, -1 = invalid handle)
+        functions.insert("file_close".to_string(), (vec![Type::I64], Type::I64));
 
         // v0.31.11: Process execution builtins for Phase 32.0.2 Bootstrap Infrastructure
         // exec(command: String, args: String) -> i64 (exit code)
@@ -358,6 +368,10 @@ impl TypeChecker {
         functions.insert("sb_new".to_string(), (vec![], Type::I64));
         // sb_push(id: i64, str: String) -> i64 (same ID for chaining)
         functions.insert("sb_push".to_string(), (vec![Type::I64, Type::String], Type::I64));
+        // sb_push_char(id: i64, code: i64) -> i64 (appends one character, no temporary string)
+        functions.insert("sb_push_char".to_string(), (vec![Type::I64, Type::I64], Type::I64));
+        // sb_push_int(id: i64, n: i64) -> i64 (appends decimal digits, no temporary string)
+        functions.insert("sb_push_int".to_string(), (vec![Type::I64, Type::I64], Type::I64));
         // sb_build(id: i64) -> String (final string)
         functions.insert("sb_build".to_string(), (vec![Type::I64], Type::String));
         // sb_len(id: i64) -> i64 (total length)
@@ -365,6 +379,17 @@ impl TypeChecker {
         // sb_clear(id: i64) -> i64 (same ID)
         functions.insert("sb_clear".to_string(), (vec![Type::I64], Type::I64));
 
+        // String arena regions (native runtime frees a whole region at once)
+        // arena_push() -> i64 (new nesting depth, -1 if nested too deeply)
+        functions.insert("arena_push".to_string(), (vec![], Type::I64));
+        // arena_pop() -> i64 (remaining depth, -1 if no region is open)
+        functions.insert("arena_pop".to_string(), (vec![], Type::I64));
+
+        // Thread pool (native runtime); spawn and parallel_for take a function
+        // by name and are checked by check_task_call
+        // join(task: i64) -> i64 (waits for a spawned task, returns its result)
+        functions.insert("join".to_string(), (vec![Type::I64], Type::I64));
+
         // v0.31.21: Character conversion builtins
         // v0.50.18: chr returns String to match runtime behavior (C runtime returns char*)
         // chr(code: i64) -> String (creates single-char string from code point)
@@ -380,6 +405,15 @@ impl TypeChecker {
         // str_len(s: String) -> i64 (Unicode character count, O(n))
         // Note: s.len() returns byte length (O(1)), str_len returns char count
         functions.insert("str_len".to_string(), (vec![Type::String], Type::I64));
+        // Byte-level search (SIMD kernels in the native runtime); indices are byte offsets
+        // str_find(s: String, needle: String, from: i64) -> i64 (first match at or after from, -1 if none)
+        functions.insert("str_find".to_string(), (vec![Type::String, Type::String, Type::I64], Type::I64));
+        // str_find_byte(s: String, byte: i64, from: i64) -> i64 (first index at or after from, -1 if none)
+        functions.insert("str_find_byte".to_string(), (vec![Type::String, Type::I64, Type::I64], Type::I64));
+        // str_count_byte(s: String, byte: i64) -> i64
+        functions.insert("str_count_byte".to_string(), (vec![Type::String, Type::I64], Type::I64));
+        // str_starts_with(s: String, prefix: String) -> i64 (1 or 0)
+        functions.insert("str_starts_with".to_string(), (vec![Type::String, Type::String], Type::I64));
 
         // v0.34: Math intrinsics for Phase 34.4 Benchmark Gate (n_body, mandelbrot_fp)
         // sqrt(x: f64) -> f64 (square root)
@@ -468,6 +502,22 @@ impl TypeChecker {
         // hashset_free(set: i64) -> Unit (deallocate hashset)
         functions.insert("hashset_free".to_string(), (vec![Type::I64], Type::Unit));
 
+        // String-keyed map: String -> i64 (same return conventions as hashmap_*)
+        // strmap_new() -> i64
+        functions.insert("strmap_new".to_string(), (vec![], Type::I64));
+        // strmap_insert(map: i64, key: String, value: i64) -> i64 (old value or 0)
+        functions.insert("strmap_insert".to_string(), (vec![Type::I64, Type::String, Type::I64], Type::I64));
+        // strmap_get(map: i64, key: String) -> i64 (value or i64::MIN)
+        functions.insert("strmap_get".to_string(), (vec![Type::I64, Type::String], Type::I64));
+        // strmap_contains(map: i64, key: String) -> i64 (1 or 0)
+        functions.insert("strmap_contains".to_string(), (vec![Type::I64, Type::String], Type::I64));
+        // strmap_remove(map: i64, key: String) -> i64 (removed value or i64::MIN)
+        functions.insert("strmap_remove".to_string(), (vec![Type::I64, Type::String], Type::I64));
+        // strmap_len(map: i64) -> i64
+        functions.insert("strmap_len".to_string(), (vec![Type::I64], Type::I64));
+        // strmap_free(map: i64) -> Unit
+        functions.insert("strmap_free".to_string(), (vec![Type::I64], Type::Unit));
+
         Self {
             env: HashMap::new(),
             functions,
@@ -533,7 +583,7 @@ impl TypeChecker {
                 Item::FnDef(f) if f.visibility == Visibility::Public => {
                     if f.type_params.is_empty() {
                         let param_tys: Vec<_> = f.params.iter().map(|p| p.ty.node.clone()).collect();
-                        self.functions.insert(f.name.node.clone(), (param_tys, f.ret_ty.node.clone()));
+                        self.functions.insert(f.name.node.to_string(), (param_tys, f.ret_ty.node.clone()));
                     } else {
                         let type_param_names: Vec<_> = f.type_params.iter().map(|tp| tp.name.as_str()).collect();
                         let param_tys: Vec<_> = f.params.iter()
@@ -541,7 +591,7 @@ impl TypeChecker {
                             .collect();
                         let ret_ty = self.resolve_type_vars(&f.ret_ty.node, &type_param_names);
                         self.generic_functions.insert(
-                            f.name.node.clone(),
+                            f.name.node.to_string(),
                             (f.type_params.clone(), param_tys, ret_ty)
                         );
                     }
@@ -587,6 +637,17 @@ impl TypeChecker {
 
     /// Check entire program
     pub fn check_program(&mut self, program: &Program) -> Result<()> {
+        self.check_program_where(program, |_| true)
+    }
+
+    /// Check a program, type checking only the function bodies selected by
+    /// `check_body`
+    ///
+    /// Declarations and signatures of every item are still registered, so
+    /// selected bodies see the whole program. The LSP server skips bodies
+    /// that checked cleanly against the same declarations before. Unused
+    /// function warnings are only complete when every body is checked.
+    pub fn check_program_where(&mut self, program: &Program, check_body: impl Fn(&FnDef) -> bool) -> Result<()> {
         // First pass: collect type definitions (structs and enums)
         for item in &program.items {
             match item {
@@ -682,25 +743,25 @@ impl TypeChecker {
                         && f.name.node != "main"
                         && !f.name.node.starts_with('_')
                     {
-                        self.private_functions.insert(f.name.node.clone(), f.name.span);
+                        self.private_functions.insert(f.name.node.to_string(), f.name.span);
                     }
 
                     // v0.50.11: Check for duplicate function definitions
-                    if let Some(original_span) = self.function_spans.get(&f.name.node) {
+                    if let Some(original_span) = self.function_spans.get(f.name.node.as_str()) {
                         self.add_warning(CompileWarning::duplicate_function(
-                            &f.name.node,
+                            f.name.node.as_str(),
                             f.name.span,
                             *original_span,
                         ));
                     } else {
-                        self.function_spans.insert(f.name.node.clone(), f.name.span);
+                        self.function_spans.insert(f.name.node.to_string(), f.name.span);
                     }
 
                     // v0.15: Handle generic functions separately
                     if f.type_params.is_empty() {
                         let param_tys: Vec<_> = f.params.iter().map(|p| p.ty.node.clone()).collect();
                         self.functions
-                            .insert(f.name.node.clone(), (param_tys, f.ret_ty.node.clone()));
+                            .insert(f.name.node.to_string(), (param_tys, f.ret_ty.node.clone()));
                     } else {
                         // Convert Named types that match type params to TypeVar
                         let type_param_names: Vec<_> = f.type_params.iter().map(|tp| tp.name.as_str()).collect();
@@ -709,7 +770,7 @@ impl TypeChecker {
                             .collect();
                         let ret_ty = self.resolve_type_vars(&f.ret_ty.node, &type_param_names);
                         self.generic_functions.insert(
-                            f.name.node.clone(),
+                            f.name.node.to_string(),
                             (f.type_params.clone(), param_tys, ret_ty)
                         );
                     }
@@ -748,7 +809,7 @@ impl TypeChecker {
                             .map(|p| self.substitute_self(&p.ty.node, &i.target_type.node))
                             .collect();
                         let ret_type = self.substitute_self(&method.ret_ty.node, &i.target_type.node);
-                        methods.insert(method.name.node.clone(), (param_types, ret_type));
+                        methods.insert(method.name.node.to_string(), (param_types, ret_type));
                     }
 
                     // v0.80: Track that this trait is implemented
@@ -766,7 +827,8 @@ impl TypeChecker {
         // Third pass: type check function bodies (extern fn has no body)
         for item in &program.items {
             match item {
-                Item::FnDef(f) => self.check_fn(f)?,
+                Item::FnDef(f) if check_body(f) => self.check_fn(f)?,
+                Item::FnDef(_) => {}
                 Item::StructDef(_) | Item::EnumDef(_) | Item::Use(_) | Item::ExternFn(_) => {}
                 // v0.20.1: Traits and impls already registered
                 Item::TraitDef(_) | Item::ImplBlock(_) => {}
@@ -847,6 +909,56 @@ impl TypeChecker {
         self.used_names.insert(name.to_string());
     }
 
+    /// `spawn(f, x)` and `parallel_for(lo, hi, f)`: `f` names a top-level
+    /// `fn(i64) -> i64`, the other arguments are i64. Whether `f` may race
+    /// is checked on MIR (`mir::race`), where its callees are resolved.
+    fn check_task_call(&mut self, builtin: &str, fn_pos: usize, args: &[Spanned<Expr>], span: Span) -> Result<Type> {
+        let arity = if builtin == "spawn" { 2 } else { 3 };
+        if args.len() != arity {
+            return Err(CompileError::type_error(
+                format!("`{}` expects {} arguments, got {}", builtin, arity, args.len()),
+                span,
+            ));
+        }
+        for (i, arg) in args.iter().enumerate() {
+            if i != fn_pos {
+                let arg_ty = self.infer(&arg.node, arg.span)?;
+                self.unify(&Type::I64, &arg_ty, arg.span)?;
+                continue;
+            }
+            let Expr::Var(name) = &arg.node else {
+                return Err(CompileError::type_error(
+                    format!("`{}` runs a top-level function on the thread pool; pass its name", builtin),
+                    arg.span,
+                ));
+            };
+            let signature = if self.env.contains_key(name.as_str()) { None } else { self.functions.get(name.as_str()).cloned() };
+            match signature {
+                Some((params, ret)) if params == [Type::I64] && ret == Type::I64 => {
+                    self.called_functions.insert(name.to_string());
+                    self.mark_name_used(name);
+                }
+                Some((params, ret)) => {
+                    let params: Vec<String> = params.iter().map(|p| p.to_string()).collect();
+                    return Err(CompileError::type_error(
+                        format!(
+                            "`{}` needs a function `fn(i64) -> i64`, but `{}` is `fn({}) -> {}`",
+                            builtin, name, params.join(", "), ret
+                        ),
+                        arg.span,
+                    ));
+                }
+                None => {
+                    return Err(CompileError::type_error(
+                        format!("`{}` needs the name of a top-level function, found `{}`", builtin, name),
+                        arg.span,
+                    ));
+                }
+            }
+        }
+        Ok(Type::I64)
+    }
+
     /// v0.75: Mark all type names in a type as used (for import tracking)
     /// Recursively walks the type to find Named and Generic types
     fn mark_type_names_used(&mut self, ty: &Type) {
@@ -1128,9 +1240,9 @@ impl TypeChecker {
             } else {
                 self.resolve_type_vars(&param.ty.node, &type_param_names)
             };
-            self.env.insert(param.name.node.clone(), resolved_ty);
+            self.env.insert(param.name.node.to_string(), resolved_ty);
             // v0.49: Track parameter binding for unused detection
-            self.binding_tracker.bind(param.name.node.clone(), param.name.span);
+            self.binding_tracker.bind(param.name.node.to_string(), param.name.span);
         }
 
         // Set current return type for `ret` keyword
@@ -1169,7 +1281,7 @@ impl TypeChecker {
 
         if !has_postcondition && !is_main && !is_underscore && !is_trusted && !is_unit_return {
             self.add_warning(CompileWarning::missing_postcondition(
-                &f.name.node,
+                f.name.node.as_str(),
                 f.name.span,
             ));
         }
@@ -1191,13 +1303,13 @@ impl TypeChecker {
             if let Some((existing_name, _)) = self.contract_signatures.get(&key) {
                 // Found a function with equivalent contract
                 self.add_warning(CompileWarning::semantic_duplication(
-                    &f.name.node,
+                    f.name.node.as_str(),
                     existing_name,
                     f.name.span,
                 ));
             } else {
                 // First function with this signature+postcondition
-                self.contract_signatures.insert(key, (f.name.node.clone(), f.name.span));
+                self.contract_signatures.insert(key, (f.name.node.to_string(), f.name.span));
             }
         }
 
@@ -1278,7 +1390,7 @@ impl TypeChecker {
             Expr::Var(name) => {
                 // v0.48: Mark variable as used for unused binding detection
                 self.binding_tracker.mark_used(name);
-                self.env.get(name).cloned().ok_or_else(|| {
+                self.env.get(name.as_str()).cloned().ok_or_else(|| {
                     // v0.62: Suggest similar variable names
                     let var_names: Vec<&str> = self.env.keys().map(|s| s.as_str()).collect();
                     let suggestion = find_similar_name(name, &var_names, 2);
@@ -1447,10 +1559,17 @@ impl TypeChecker {
                 // v0.74: Mark imported function as used
                 self.mark_name_used(func);
                 // v0.76: Track function calls for unused function detection
-                self.called_functions.insert(func.clone());
+                self.called_functions.insert(func.to_string());
+
+                // Thread pool builtins, unless the program defines its own
+                if let Some(fn_pos) = crate::mir::race::task_fn_arg(func)
+                    && !self.functions.contains_key(func.as_str())
+                {
+                    return self.check_task_call(func, fn_pos, args, span);
+                }
 
                 // v0.20.0: First try closure/function variable
-                if let Some(var_ty) = self.env.get(func).cloned()
+                if let Some(var_ty) = self.env.get(func.as_str()).cloned()
                     && let Type::Fn { params: param_tys, ret: ret_ty } = var_ty
                 {
                     if args.len() != param_tys.len() {
@@ -1473,7 +1592,7 @@ impl TypeChecker {
                 }
 
                 // v0.15: Try non-generic functions
-                if let Some((param_tys, ret_ty)) = self.functions.get(func).cloned() {
+                if let Some((param_tys, ret_ty)) = self.functions.get(func.as_str()).cloned() {
                     if args.len() != param_tys.len() {
                         return Err(CompileError::type_error(
                             format!(
@@ -1494,7 +1613,7 @@ impl TypeChecker {
                 }
 
                 // v0.15: Try generic functions
-                if let Some((type_params, param_tys, ret_ty)) = self.generic_functions.get(func).cloned() {
+                if let Some((type_params, param_tys, ret_ty)) = self.generic_functions.get(func.as_str()).cloned() {
                     if args.len() != param_tys.len() {
                         return Err(CompileError::type_error(
                             format!(
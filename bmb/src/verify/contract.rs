@@ -16,6 +16,8 @@ use crate::smt::{
 /// Contract verifier for BMB programs
 pub struct ContractVerifier {
     solver: SmtSolver,
+    /// Functions verified concurrently (one Z3 session each)
+    jobs: usize,
 }
 
 impl ContractVerifier {
@@ -23,9 +25,23 @@ impl ContractVerifier {
     pub fn new() -> Self {
         Self {
             solver: SmtSolver::new(),
+            jobs: 1,
         }
     }
 
+    /// Verify up to `n` functions at once (0 = one per core), keeping a
+    /// Z3 session alive per worker
+    pub fn with_jobs(mut self, n: usize) -> Self {
+        self.jobs = crate::parallel::resolve_jobs(n);
+        self.solver = self.solver.with_sessions(self.jobs);
+        self
+    }
+
+    /// The underlying solver (result cache access)
+    pub fn solver(&self) -> &SmtSolver {
+        &self.solver
+    }
+
     /// Set custom Z3 path
     pub fn with_z3_path(mut self, path: &str) -> Self {
         self.solver = self.solver.with_path(path);
@@ -51,24 +67,28 @@ impl ContractVerifier {
         let mut function_index: HashMap<String, &FnDef> = HashMap::new();
         for item in &program.items {
             if let Item::FnDef(func) = item {
-                function_index.insert(func.name.node.clone(), func);
+                function_index.insert(func.name.node.to_string(), func);
             }
         }
 
-        for item in &program.items {
-            match item {
-                Item::FnDef(func) => {
-                    let func_report = self.verify_function_with_index(func, &function_index);
-                    report.functions.push(func_report);
-                }
+        let functions: Vec<&FnDef> = program
+            .items
+            .iter()
+            .filter_map(|item| match item {
+                Item::FnDef(func) => Some(func),
                 // Struct, Enum, Use, and ExternFn don't need verification
-                Item::StructDef(_) | Item::EnumDef(_) | Item::Use(_) | Item::ExternFn(_) => {}
+                Item::StructDef(_) | Item::EnumDef(_) | Item::Use(_) | Item::ExternFn(_) => None,
                 // v0.20.1: Trait system not yet included in verification
-                Item::TraitDef(_) | Item::ImplBlock(_) => {}
+                Item::TraitDef(_) | Item::ImplBlock(_) => None,
                 // v0.50.6: Type aliases don't need verification
-                Item::TypeAlias(_) => {}
-            }
-        }
+                Item::TypeAlias(_) => None,
+            })
+            .collect();
+
+        // Functions are independent obligations; reports keep source order
+        report.functions = crate::parallel::map(&functions, self.jobs, |func| {
+            self.verify_function_with_index(func, &function_index)
+        });
 
         report
     }
@@ -85,7 +105,7 @@ impl ContractVerifier {
         function_index: &HashMap<String, &FnDef>,
     ) -> FunctionReport {
         let name = func.name.node.clone();
-        let mut report = FunctionReport::new(name.clone());
+        let mut report = FunctionReport::new(name.to_string());
 
         // v0.31: Check for @trust attribute - skip verification if present
         if let Some(trust_attr) = func.attributes.iter().find(|a| a.is_trust()) {
@@ -444,7 +464,7 @@ impl ContractVerifier {
         for (param_idx, arg) in args.iter().enumerate() {
             if let Expr::Call { func: arg_func_name, .. } = &arg.node {
                 // Argument is a function call - get its postcondition
-                let Some(arg_func) = function_index.get(arg_func_name) else { continue };
+                let Some(arg_func) = function_index.get(arg_func_name.as_str()) else { continue };
                 let Some(arg_post) = &arg_func.post else { continue };
 
                 // Check if arg's postcondition conflicts with callee's precondition
@@ -1025,7 +1045,7 @@ mod tests {
         let func = FnDef {
             attributes: vec![],
             visibility: Visibility::Private,
-            name: spanned("test".to_string()),
+            name: spanned("test".into()),
             type_params: vec![],
             params: vec![],
             ret_name: None,
@@ -1051,7 +1071,7 @@ mod tests {
 
         // Create a function with duplicate contracts
         let same_condition = spanned(Expr::Binary {
-            left: Box::new(spanned(Expr::Var("x".to_string()))),
+            left: Box::new(spanned(Expr::Var("x".into()))),
             op: crate::ast::BinOp::Ge,
             right: Box::new(spanned(Expr::IntLit(0))),
         });
@@ -1059,10 +1079,10 @@ mod tests {
         let func = FnDef {
             attributes: vec![],
             visibility: Visibility::Private,
-            name: spanned("test_func".to_string()),
+            name: spanned("test_func".into()),
             type_params: vec![],
             params: vec![crate::ast::Param {
-                name: spanned("x".to_string()),
+                name: spanned("x".into()),
                 ty: spanned(Type::I64),
             }],
             ret_name: Some(spanned("r".to_string())),
@@ -1081,7 +1101,7 @@ mod tests {
                     span: dummy_span(),
                 },
             ],
-            body: spanned(Expr::Var("x".to_string())),
+            body: spanned(Expr::Var("x".into())),
             span: dummy_span(),
         };
 
@@ -1109,22 +1129,22 @@ mod tests {
         let func = FnDef {
             attributes: vec![],
             visibility: Visibility::Private,
-            name: spanned("trivial_fn".to_string()),
+            name: spanned("trivial_fn".into()),
             type_params: vec![],
             params: vec![crate::ast::Param {
-                name: spanned("x".to_string()),
+                name: spanned("x".into()),
                 ty: spanned(Type::I64),
             }],
             ret_name: None,
             ret_ty: spanned(Type::I64),
             pre: None,
             post: Some(spanned(Expr::Binary {
-                left: Box::new(spanned(Expr::Var("ret".to_string()))),
+                left: Box::new(spanned(Expr::Var("ret".into()))),
                 op: crate::ast::BinOp::Eq,
-                right: Box::new(spanned(Expr::Var("ret".to_string()))),
+                right: Box::new(spanned(Expr::Var("ret".into()))),
             })),
             contracts: vec![],
-            body: spanned(Expr::Var("x".to_string())),
+            body: spanned(Expr::Var("x".into())),
             span: dummy_span(),
         };
 
@@ -1148,10 +1168,10 @@ mod tests {
         let func = FnDef {
             attributes: vec![],
             visibility: Visibility::Private,
-            name: spanned("trivial_pre".to_string()),
+            name: spanned("trivial_pre".into()),
             type_params: vec![],
             params: vec![crate::ast::Param {
-                name: spanned("x".to_string()),
+                name: spanned("x".into()),
                 ty: spanned(Type::I64),
             }],
             ret_name: None,
@@ -1159,7 +1179,7 @@ mod tests {
             pre: Some(spanned(Expr::BoolLit(true))),
             post: None,
             contracts: vec![],
-            body: spanned(Expr::Var("x".to_string())),
+            body: spanned(Expr::Var("x".into())),
             span: dummy_span(),
         };
 
@@ -1183,27 +1203,27 @@ mod tests {
         let func = FnDef {
             attributes: vec![],
             visibility: Visibility::Private,
-            name: spanned("non_trivial_fn".to_string()),
+            name: spanned("non_trivial_fn".into()),
             type_params: vec![],
             params: vec![crate::ast::Param {
-                name: spanned("x".to_string()),
+                name: spanned("x".into()),
                 ty: spanned(Type::I64),
             }],
             ret_name: None,
             ret_ty: spanned(Type::I64),
             pre: Some(spanned(Expr::Binary {
-                left: Box::new(spanned(Expr::Var("x".to_string()))),
+                left: Box::new(spanned(Expr::Var("x".into()))),
                 op: crate::ast::BinOp::Gt,
                 right: Box::new(spanned(Expr::IntLit(0))),
             })),
             post: Some(spanned(Expr::Binary {
-                left: Box::new(spanned(Expr::Var("ret".to_string()))),
+                left: Box::new(spanned(Expr::Var("ret".into()))),
                 op: crate::ast::BinOp::Gt,
                 right: Box::new(spanned(Expr::IntLit(0))),
             })),
             contracts: vec![],
             body: spanned(Expr::Binary {
-                left: Box::new(spanned(Expr::Var("x".to_string()))),
+                left: Box::new(spanned(Expr::Var("x".into()))),
                 op: crate::ast::BinOp::Add,
                 right: Box::new(spanned(Expr::IntLit(1))),
             }),
@@ -1232,30 +1252,30 @@ mod tests {
         let func = FnDef {
             attributes: vec![],
             visibility: Visibility::Private,
-            name: spanned("impossible".to_string()),
+            name: spanned("impossible".into()),
             type_params: vec![],
             params: vec![crate::ast::Param {
-                name: spanned("x".to_string()),
+                name: spanned("x".into()),
                 ty: spanned(Type::I64),
             }],
             ret_name: None,
             ret_ty: spanned(Type::I64),
             pre: Some(spanned(Expr::Binary {
                 left: Box::new(spanned(Expr::Binary {
-                    left: Box::new(spanned(Expr::Var("x".to_string()))),
+                    left: Box::new(spanned(Expr::Var("x".into()))),
                     op: crate::ast::BinOp::Gt,
                     right: Box::new(spanned(Expr::IntLit(0))),
                 })),
                 op: crate::ast::BinOp::And,
                 right: Box::new(spanned(Expr::Binary {
-                    left: Box::new(spanned(Expr::Var("x".to_string()))),
+                    left: Box::new(spanned(Expr::Var("x".into()))),
                     op: crate::ast::BinOp::Lt,
                     right: Box::new(spanned(Expr::IntLit(0))),
                 })),
             })),
             post: None,
             contracts: vec![],
-            body: spanned(Expr::Var("x".to_string())),
+            body: spanned(Expr::Var("x".into())),
             span: dummy_span(),
         };
 
@@ -1281,22 +1301,22 @@ mod tests {
         let func = FnDef {
             attributes: vec![],
             visibility: Visibility::Private,
-            name: spanned("possible".to_string()),
+            name: spanned("possible".into()),
             type_params: vec![],
             params: vec![crate::ast::Param {
-                name: spanned("x".to_string()),
+                name: spanned("x".into()),
                 ty: spanned(Type::I64),
             }],
             ret_name: None,
             ret_ty: spanned(Type::I64),
             pre: Some(spanned(Expr::Binary {
-                left: Box::new(spanned(Expr::Var("x".to_string()))),
+                left: Box::new(spanned(Expr::Var("x".into()))),
                 op: crate::ast::BinOp::Gt,
                 right: Box::new(spanned(Expr::IntLit(0))),
             })),
             post: None,
             contracts: vec![],
-            body: spanned(Expr::Var("x".to_string())),
+            body: spanned(Expr::Var("x".into())),
             span: dummy_span(),
         };
 
@@ -0,0 +1,704 @@
+//! Register bytecode and the MIR-to-bytecode compiler
+//!
+//! Every MIR place gets a fixed register in its function's frame.
+//! Registers are untagged 64-bit words: the MIR type of each place picks
+//! the instruction (`Add` vs `FAdd`, signed compare, ...), so no value
+//! carries a runtime tag. Constants get registers of their own, filled
+//! from the frame template when a call enters the function, and phi nodes
+//! become moves on the incoming edges.
+
+use std::collections::{HashMap, HashSet};
+use std::rc::Rc;
+
+use thiserror::Error;
+
+use crate::interp::BuiltinFn;
+use crate::mir::{Constant, MirBinOp, MirFunction, MirInst, MirProgram, MirType, MirUnaryOp, Operand, Place, Terminator};
+
+/// Register index within a frame
+pub type Reg = u16;
+
+/// Destination of a call whose result is discarded
+pub const NO_REG: Reg = Reg::MAX;
+
+/// Static kind of a register's contents
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Kind {
+    /// Any integer type, stored as i64
+    Int,
+    /// f64 bits
+    Float,
+    /// 0 or 1
+    Bool,
+    /// Unicode scalar value
+    Char,
+    /// Index into `Program::strings`
+    Str,
+    /// Always 0
+    Unit,
+}
+
+impl Kind {
+    fn of(ty: &MirType) -> Option<Kind> {
+        match ty {
+            MirType::I32 | MirType::I64 | MirType::U32 | MirType::U64 => Some(Kind::Int),
+            MirType::F64 => Some(Kind::Float),
+            MirType::Bool => Some(Kind::Bool),
+            MirType::Char => Some(Kind::Char),
+            MirType::String => Some(Kind::Str),
+            MirType::Unit => Some(Kind::Unit),
+            MirType::Struct { .. } | MirType::StructPtr(_) | MirType::Enum { .. } | MirType::Array { .. } => None,
+        }
+    }
+}
+
+/// One instruction. Jump targets are instruction indices.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Op {
+    Mov { dst: Reg, src: Reg },
+
+    // Integer arithmetic wraps, matching native code
+    Add { dst: Reg, a: Reg, b: Reg },
+    Sub { dst: Reg, a: Reg, b: Reg },
+    Mul { dst: Reg, a: Reg, b: Reg },
+    Div { dst: Reg, a: Reg, b: Reg },
+    Mod { dst: Reg, a: Reg, b: Reg },
+    AddSat { dst: Reg, a: Reg, b: Reg },
+    SubSat { dst: Reg, a: Reg, b: Reg },
+    MulSat { dst: Reg, a: Reg, b: Reg },
+    Shl { dst: Reg, a: Reg, b: Reg },
+    Shr { dst: Reg, a: Reg, b: Reg },
+    Band { dst: Reg, a: Reg, b: Reg },
+    Bor { dst: Reg, a: Reg, b: Reg },
+    Bxor { dst: Reg, a: Reg, b: Reg },
+
+    // Word equality (ints, bools, chars, interned strings) and signed order
+    Eq { dst: Reg, a: Reg, b: Reg },
+    Ne { dst: Reg, a: Reg, b: Reg },
+    Lt { dst: Reg, a: Reg, b: Reg },
+    Le { dst: Reg, a: Reg, b: Reg },
+    Gt { dst: Reg, a: Reg, b: Reg },
+    Ge { dst: Reg, a: Reg, b: Reg },
+
+    FAdd { dst: Reg, a: Reg, b: Reg },
+    FSub { dst: Reg, a: Reg, b: Reg },
+    FMul { dst: Reg, a: Reg, b: Reg },
+    FDiv { dst: Reg, a: Reg, b: Reg },
+    FEq { dst: Reg, a: Reg, b: Reg },
+    FNe { dst: Reg, a: Reg, b: Reg },
+    FLt { dst: Reg, a: Reg, b: Reg },
+    FLe { dst: Reg, a: Reg, b: Reg },
+    FGt { dst: Reg, a: Reg, b: Reg },
+    FGe { dst: Reg, a: Reg, b: Reg },
+
+    And { dst: Reg, a: Reg, b: Reg },
+    Or { dst: Reg, a: Reg, b: Reg },
+    Implies { dst: Reg, a: Reg, b: Reg },
+
+    Neg { dst: Reg, src: Reg },
+    FNeg { dst: Reg, src: Reg },
+    Not { dst: Reg, src: Reg },
+    Bnot { dst: Reg, src: Reg },
+
+    Jmp { target: u32 },
+    /// Jump when the register is zero
+    JmpIfNot { cond: Reg, target: u32 },
+    /// Jump through `Function::switches[table]`
+    Switch { src: Reg, table: u32 },
+
+    /// Call `Function::calls[site]`
+    Call { dst: Reg, site: u32 },
+    /// Call `Function::builtin_calls[site]`
+    CallBuiltin { dst: Reg, site: u32 },
+    Ret { src: Reg },
+    /// MIR `unreachable`
+    Trap,
+}
+
+/// User-function call site
+#[derive(Debug, Clone)]
+pub struct CallSite {
+    /// Index into `Program::functions`
+    pub func: u32,
+    /// Argument registers, copied into the callee's parameters
+    pub args: Vec<Reg>,
+}
+
+/// Builtin call site; arguments are converted to interpreter values
+#[derive(Debug, Clone)]
+pub struct BuiltinCall {
+    pub name: String,
+    pub func: BuiltinFn,
+    pub args: Vec<(Reg, Kind)>,
+    pub ret: Kind,
+}
+
+/// Resolved `switch` terminator
+#[derive(Debug, Clone)]
+pub struct SwitchTable {
+    pub cases: Vec<(i64, u32)>,
+    pub default: u32,
+}
+
+/// A compiled function
+#[derive(Debug, Clone)]
+pub struct Function {
+    pub name: String,
+    pub params: Vec<Kind>,
+    pub ret: Kind,
+    /// Registers per frame
+    pub frame_size: usize,
+    /// Initial contents of registers `params.len()..frame_size`
+    pub template: Vec<u64>,
+    pub code: Vec<Op>,
+    pub calls: Vec<CallSite>,
+    pub builtin_calls: Vec<BuiltinCall>,
+    pub switches: Vec<SwitchTable>,
+}
+
+/// A compiled program
+#[derive(Debug, Clone)]
+pub struct Program {
+    pub functions: Vec<Function>,
+    /// Interned string constants
+    pub strings: Vec<Rc<String>>,
+    /// Index of the entry function
+    pub entry: u32,
+}
+
+/// Reasons a program cannot run on the VM (callers fall back to the
+/// tree-walking interpreter)
+#[derive(Debug, Error)]
+pub enum VmCompileError {
+    #[error("entry function `{0}` not found")]
+    NoEntry(String),
+
+    #[error("unknown function `{callee}` called from `{func}`")]
+    UnknownFunction { func: String, callee: String },
+
+    #[error("`{func}`: {what} is not supported by the VM")]
+    Unsupported { func: String, what: String },
+}
+
+/// Compile the functions reachable from `entry`
+pub fn compile(
+    mir: &MirProgram,
+    entry: &str,
+    builtin: impl Fn(&str) -> Option<BuiltinFn>,
+) -> Result<Program, VmCompileError> {
+    let by_name: HashMap<&str, &MirFunction> = mir.functions.iter().map(|f| (f.name.as_str(), f)).collect();
+    if !by_name.contains_key(entry) {
+        return Err(VmCompileError::NoEntry(entry.to_string()));
+    }
+
+    // Builtins take precedence over user functions, as in the interpreter
+    let mut order: Vec<&MirFunction> = Vec::new();
+    let mut index: HashMap<&str, u32> = HashMap::new();
+    let mut stack = vec![entry];
+    index.insert(entry, 0);
+    while let Some(name) = stack.pop() {
+        let func = by_name[name];
+        order.push(func);
+        for inst in func.blocks.iter().flat_map(|b| &b.instructions) {
+            if let MirInst::Call { func: callee, .. } = inst
+                && builtin(callee).is_none()
+                && by_name.contains_key(callee.as_str())
+                && !index.contains_key(callee.as_str())
+            {
+                index.insert(callee.as_str(), index.len() as u32);
+                stack.push(callee.as_str());
+            }
+        }
+    }
+    order.sort_by_key(|f| index[f.name.as_str()]);
+
+    let signatures = order
+        .iter()
+        .map(|f| {
+            let unsupported = |what: String| VmCompileError::Unsupported { func: f.name.clone(), what };
+            let params = f
+                .params
+                .iter()
+                .map(|(name, ty)| Kind::of(ty).ok_or_else(|| unsupported(format!("parameter `{}: {:?}`", name, ty))))
+                .collect::<Result<Vec<_>, _>>()?;
+            let ret = Kind::of(&f.ret_ty).ok_or_else(|| unsupported(format!("return type {:?}", f.ret_ty)))?;
+            Ok((params, ret))
+        })
+        .collect::<Result<Vec<_>, VmCompileError>>()?;
+
+    let mut strings = StringPool::default();
+    let functions = order
+        .iter()
+        .map(|f| FnCompiler::new(f, &index, &signatures, &builtin, &mut strings)?.compile())
+        .collect::<Result<Vec<_>, _>>()?;
+
+    Ok(Program { functions, strings: strings.values, entry: 0 })
+}
+
+#[derive(Default)]
+struct StringPool {
+    values: Vec<Rc<String>>,
+    ids: HashMap<String, u64>,
+}
+
+impl StringPool {
+    fn intern(&mut self, s: &str) -> u64 {
+        if let Some(&id) = self.ids.get(s) {
+            return id;
+        }
+        let id = self.values.len() as u64;
+        self.values.push(Rc::new(s.to_string()));
+        self.ids.insert(s.to_string(), id);
+        id
+    }
+}
+
+/// Where a jump must land once code layout is known
+enum Target {
+    Block(usize),
+    Stub(usize),
+}
+
+struct FnCompiler<'a, B> {
+    func: &'a MirFunction,
+    index: &'a HashMap<&'a str, u32>,
+    signatures: &'a [(Vec<Kind>, Kind)],
+    builtin: &'a B,
+    strings: &'a mut StringPool,
+    regs: HashMap<&'a str, Reg>,
+    kinds: Vec<Kind>,
+    /// Initial value per register (constants; zero otherwise)
+    init: Vec<u64>,
+    consts: HashMap<(u8, u64), Reg>,
+    labels: HashMap<&'a str, usize>,
+    /// Incoming phi moves per (pred label, succ block): (dest, source)
+    phi_moves: HashMap<(&'a str, usize), Vec<(Reg, Reg)>>,
+    code: Vec<Op>,
+    calls: Vec<CallSite>,
+    builtin_calls: Vec<BuiltinCall>,
+    switches: Vec<(Vec<(i64, Target)>, Target)>,
+    fixups: Vec<(usize, Target)>,
+    /// Edge stubs: phi moves on a conditional edge, then a jump to the block
+    stubs: Vec<(Vec<(Reg, Reg)>, usize)>,
+}
+
+impl<'a, B: Fn(&str) -> Option<BuiltinFn>> FnCompiler<'a, B> {
+    fn new(
+        func: &'a MirFunction,
+        index: &'a HashMap<&'a str, u32>,
+        signatures: &'a [(Vec<Kind>, Kind)],
+        builtin: &'a B,
+        strings: &'a mut StringPool,
+    ) -> Result<Self, VmCompileError> {
+        let mut c = FnCompiler {
+            func,
+            index,
+            signatures,
+            builtin,
+            strings,
+            regs: HashMap::new(),
+            kinds: Vec::new(),
+            init: Vec::new(),
+            consts: HashMap::new(),
+            labels: func.blocks.iter().enumerate().map(|(i, b)| (b.label.as_str(), i)).collect(),
+            phi_moves: HashMap::new(),
+            code: Vec::new(),
+            calls: Vec::new(),
+            builtin_calls: Vec::new(),
+            switches: Vec::new(),
+            fixups: Vec::new(),
+            stubs: Vec::new(),
+        };
+
+        // Parameters first, so a call copies arguments to registers 0..n
+        let mut locals: Vec<&(String, MirType)> = func.locals.iter().collect();
+        locals.sort_by(|a, b| a.0.cmp(&b.0));
+        for (name, ty) in func.params.iter().chain(locals) {
+            if c.regs.contains_key(name.as_str()) {
+                continue;
+            }
+            let kind = Kind::of(ty).ok_or_else(|| c.unsupported(format!("local `{}: {:?}`", name, ty)))?;
+            let reg = c.alloc(kind, 0)?;
+            c.regs.insert(name.as_str(), reg);
+        }
+        Ok(c)
+    }
+
+    fn unsupported(&self, what: impl Into<String>) -> VmCompileError {
+        VmCompileError::Unsupported { func: self.func.name.clone(), what: what.into() }
+    }
+
+    fn alloc(&mut self, kind: Kind, init: u64) -> Result<Reg, VmCompileError> {
+        let reg = self.kinds.len();
+        if reg >= NO_REG as usize {
+            return Err(self.unsupported("more than 65534 registers"));
+        }
+        self.kinds.push(kind);
+        self.init.push(init);
+        Ok(reg as Reg)
+    }
+
+    fn place(&self, place: &Place) -> Result<(Reg, Kind), VmCompileError> {
+        let reg = *self
+            .regs
+            .get(place.name.as_str())
+            .ok_or_else(|| self.unsupported(format!("untyped place `{}`", place.name)))?;
+        Ok((reg, self.kinds[reg as usize]))
+    }
+
+    fn constant(&mut self, c: &Constant) -> Result<(Reg, Kind), VmCompileError> {
+        let (kind, bits) = match c {
+            Constant::Int(n) => (Kind::Int, *n as u64),
+            Constant::Float(f) => (Kind::Float, f.to_bits()),
+            Constant::Bool(b) => (Kind::Bool, *b as u64),
+            Constant::Char(ch) => (Kind::Char, *ch as u64),
+            Constant::String(s) => (Kind::Str, self.strings.intern(s)),
+            Constant::Unit => (Kind::Unit, 0),
+            Constant::FnRef(name) => return Err(self.unsupported(format!("function reference `{}`", name))),
+        };
+        let key = (kind as u8, bits);
+        if let Some(&reg) = self.consts.get(&key) {
+            return Ok((reg, kind));
+        }
+        let reg = self.alloc(kind, bits)?;
+        self.consts.insert(key, reg);
+        Ok((reg, kind))
+    }
+
+    fn operand(&mut self, op: &Operand) -> Result<(Reg, Kind), VmCompileError> {
+        match op {
+            Operand::Place(p) => self.place(p),
+            Operand::Constant(c) => self.constant(c),
+        }
+    }
+
+    fn block_index(&self, label: &str) -> Result<usize, VmCompileError> {
+        self.labels
+            .get(label)
+            .copied()
+            .ok_or_else(|| self.unsupported(format!("jump to unknown block `{}`", label)))
+    }
+
+    fn compile(mut self) -> Result<Function, VmCompileError> {
+        self.collect_phis()?;
+
+        let func = self.func;
+        let mut block_pc = Vec::with_capacity(func.blocks.len());
+        for (i, block) in func.blocks.iter().enumerate() {
+            block_pc.push(self.code.len() as u32);
+            for inst in &block.instructions {
+                self.instruction(inst)?;
+            }
+            self.terminator(&block.label, &block.terminator, i)?;
+        }
+
+        let mut stub_pc = Vec::with_capacity(self.stubs.len());
+        for (moves, succ) in std::mem::take(&mut self.stubs) {
+            stub_pc.push(self.code.len() as u32);
+            self.parallel_moves(&moves)?;
+            self.jump(Target::Block(succ));
+        }
+
+        let resolve = |t: &Target| match t {
+            Target::Block(b) => block_pc[*b],
+            Target::Stub(s) => stub_pc[*s],
+        };
+        for (at, target) in &self.fixups {
+            let pc = resolve(target);
+            match &mut self.code[*at] {
+                Op::Jmp { target } | Op::JmpIfNot { target, .. } => *target = pc,
+                _ => unreachable!("fixup on a non-jump"),
+            }
+        }
+        let switches = self
+            .switches
+            .iter()
+            .map(|(cases, default)| SwitchTable {
+                cases: cases.iter().map(|(v, t)| (*v, resolve(t))).collect(),
+                default: resolve(default),
+            })
+            .collect();
+
+        let params = func.params.len();
+        let (param_kinds, ret) = self.signatures[self.index[func.name.as_str()] as usize].clone();
+        Ok(Function {
+            name: func.name.clone(),
+            params: param_kinds,
+            ret,
+            frame_size: self.kinds.len(),
+            template: self.init[params..].to_vec(),
+            code: self.code,
+            calls: self.calls,
+            builtin_calls: self.builtin_calls,
+            switches,
+        })
+    }
+
+    /// Turn every phi into moves on its incoming edges
+    fn collect_phis(&mut self) -> Result<(), VmCompileError> {
+        let func = self.func;
+        for (succ, block) in func.blocks.iter().enumerate() {
+            for inst in &block.instructions {
+                if let MirInst::Phi { dest, values } = inst {
+                    let (dst, kind) = self.place(dest)?;
+                    for (value, pred) in values {
+                        let (src, src_kind) = self.operand(value)?;
+                        if src_kind != kind {
+                            return Err(self.unsupported(format!("phi mixing {:?} and {:?}", kind, src_kind)));
+                        }
+                        self.phi_moves.entry((pred.as_str(), succ)).or_default().push((dst, src));
+                    }
+                }
+            }
+        }
+        Ok(())
+    }
+
+    fn emit(&mut self, op: Op) {
+        self.code.push(op);
+    }
+
+    fn jump(&mut self, target: Target) {
+        self.fixups.push((self.code.len(), target));
+        self.emit(Op::Jmp { target: 0 });
+    }
+
+    /// Copy `src` registers into `dst` registers as if simultaneously
+    fn parallel_moves(&mut self, moves: &[(Reg, Reg)]) -> Result<(), VmCompileError> {
+        let dests: HashSet<Reg> = moves.iter().map(|(d, _)| *d).collect();
+        if moves.iter().all(|(_, s)| !dests.contains(s)) {
+            for &(dst, src) in moves {
+                self.emit(Op::Mov { dst, src });
+            }
+            return Ok(());
+        }
+        let mut temps = Vec::with_capacity(moves.len());
+        for &(_, src) in moves {
+            let tmp = self.alloc(self.kinds[src as usize], 0)?;
+            self.emit(Op::Mov { dst: tmp, src });
+            temps.push(tmp);
+        }
+        for (&(dst, _), tmp) in moves.iter().zip(temps) {
+            self.emit(Op::Mov { dst, src: tmp });
+        }
+        Ok(())
+    }
+
+    /// Target for the edge `pred -> label`, through a stub if it carries phi moves
+    fn edge(&mut self, pred: &'a str, label: &str, conditional: bool) -> Result<Target, VmCompileError> {
+        let succ = self.block_index(label)?;
+        match self.phi_moves.get(&(pred, succ)) {
+            Some(moves) if conditional => {
+                self.stubs.push((moves.clone(), succ));
+                Ok(Target::Stub(self.stubs.len() - 1))
+            }
+            Some(moves) => {
+                let moves = moves.clone();
+                self.parallel_moves(&moves)?;
+                Ok(Target::Block(succ))
+            }
+            None => Ok(Target::Block(succ)),
+        }
+    }
+
+    fn terminator(&mut self, label: &'a str, term: &Terminator, block: usize) -> Result<(), VmCompileError> {
+        match term {
+            Terminator::Return(value) => {
+                let ret = self.signatures[self.index[self.func.name.as_str()] as usize].1;
+                let (src, kind) = match value {
+                    Some(v) => self.operand(v)?,
+                    None => self.constant(&Constant::Unit)?,
+                };
+                if kind != ret && ret != Kind::Unit {
+                    return Err(self.unsupported(format!("returning {:?} as {:?}", kind, ret)));
+                }
+                self.emit(Op::Ret { src });
+            }
+            Terminator::Goto(target) => {
+                let target = self.edge(label, target, false)?;
+                // Fall through to the next block where possible
+                if !matches!(target, Target::Block(b) if b == block + 1) {
+                    self.jump(target);
+                }
+            }
+            Terminator::Branch { cond, then_label, else_label } => {
+                let (cond, kind) = self.operand(cond)?;
+                if !matches!(kind, Kind::Bool | Kind::Int) {
+                    return Err(self.unsupported(format!("branch on {:?}", kind)));
+                }
+                let then_t = self.edge(label, then_label, true)?;
+                let else_t = self.edge(label, else_label, true)?;
+                self.fixups.push((self.code.len(), else_t));
+                self.emit(Op::JmpIfNot { cond, target: 0 });
+                if !matches!(then_t, Target::Block(b) if b == block + 1) {
+                    self.jump(then_t);
+                }
+            }
+            Terminator::Switch { discriminant, cases, default } => {
+                let (src, kind) = self.operand(discriminant)?;
+                if !matches!(kind, Kind::Int | Kind::Bool | Kind::Char) {
+                    return Err(self.unsupported(format!("switch on {:?}", kind)));
+                }
+                let mut targets = Vec::with_capacity(cases.len());
+                for (value, case_label) in cases {
+                    targets.push((*value, self.edge(label, case_label, true)?));
+                }
+                let default = self.edge(label, default, true)?;
+                self.switches.push((targets, default));
+                self.emit(Op::Switch { src, table: self.switches.len() as u32 - 1 });
+            }
+            Terminator::Unreachable => self.emit(Op::Trap),
+        }
+        Ok(())
+    }
+
+    fn instruction(&mut self, inst: &MirInst) -> Result<(), VmCompileError> {
+        match inst {
+            MirInst::Const { dest, value } => {
+                let (dst, kind) = self.place(dest)?;
+                let (src, src_kind) = self.constant(value)?;
+                self.expect_kind(dst, kind, src_kind, "constant")?;
+                self.emit(Op::Mov { dst, src });
+            }
+            MirInst::Copy { dest, src } => {
+                let (dst, kind) = self.place(dest)?;
+                let (src, src_kind) = self.place(src)?;
+                self.expect_kind(dst, kind, src_kind, "copy")?;
+                self.emit(Op::Mov { dst, src });
+            }
+            MirInst::BinOp { dest, op, lhs, rhs } => {
+                let (dst, dst_kind) = self.place(dest)?;
+                let (a, a_kind) = self.operand(lhs)?;
+                let (b, b_kind) = self.operand(rhs)?;
+                let (operands, result, code) = binop(*op, dst, a, b, a_kind)
+                    .ok_or_else(|| self.unsupported(format!("{:?} on {:?}", op, a_kind)))?;
+                if a_kind != b_kind || !operands.contains(&a_kind) || dst_kind != result {
+                    return Err(self.unsupported(format!(
+                        "{:?} on {:?} and {:?} into {:?}",
+                        op, a_kind, b_kind, dst_kind
+                    )));
+                }
+                self.emit(code);
+            }
+            MirInst::UnaryOp { dest, op, src } => {
+                let (dst, dst_kind) = self.place(dest)?;
+                let (src, kind) = self.operand(src)?;
+                let (operand, code) = match op {
+                    MirUnaryOp::Neg => (Kind::Int, Op::Neg { dst, src }),
+                    MirUnaryOp::FNeg => (Kind::Float, Op::FNeg { dst, src }),
+                    MirUnaryOp::Bnot => (Kind::Int, Op::Bnot { dst, src }),
+                    MirUnaryOp::Not => (Kind::Bool, Op::Not { dst, src }),
+                };
+                if kind != operand || dst_kind != operand {
+                    return Err(self.unsupported(format!("{:?} on {:?}", op, kind)));
+                }
+                self.emit(code);
+            }
+            MirInst::Call { dest, func: callee, args } => self.call(dest.as_ref(), callee, args)?,
+            // Handled as edge moves by `collect_phis`
+            MirInst::Phi { .. } => {}
+            MirInst::StructInit { .. }
+            | MirInst::FieldAccess { .. }
+            | MirInst::FieldStore { .. }
+            | MirInst::EnumVariant { .. }
+            | MirInst::ArrayInit { .. }
+            | MirInst::IndexLoad { .. }
+            | MirInst::IndexStore { .. } => {
+                return Err(self.unsupported("aggregate values (structs, enums, arrays)"));
+            }
+        }
+        Ok(())
+    }
+
+    fn expect_kind(&self, dst: Reg, want: Kind, got: Kind, what: &str) -> Result<(), VmCompileError> {
+        if want == got {
+            Ok(())
+        } else {
+            Err(self.unsupported(format!("{} of {:?} into {:?} register {}", what, got, want, dst)))
+        }
+    }
+
+    fn call(&mut self, dest: Option<&Place>, callee: &str, args: &[Operand]) -> Result<(), VmCompileError> {
+        let dest = dest.map(|d| self.place(d)).transpose()?;
+        let mut arg_regs = Vec::with_capacity(args.len());
+        for arg in args {
+            arg_regs.push(self.operand(arg)?);
+        }
+
+        if let Some(func) = (self.builtin)(callee) {
+            // Strings built at run time have no home in the VM's string pool
+            let ret = dest.map_or(Kind::Unit, |(_, k)| k);
+            if ret == Kind::Str {
+                return Err(self.unsupported(format!("builtin `{}` returning a string", callee)));
+            }
+            self.builtin_calls.push(BuiltinCall { name: callee.to_string(), func, args: arg_regs, ret });
+            let site = self.builtin_calls.len() as u32 - 1;
+            self.emit(Op::CallBuiltin { dst: dest.map_or(NO_REG, |(r, _)| r), site });
+            return Ok(());
+        }
+
+        let Some(&idx) = self.index.get(callee) else {
+            return Err(VmCompileError::UnknownFunction { func: self.func.name.clone(), callee: callee.to_string() });
+        };
+        let (params, ret) = &self.signatures[idx as usize];
+        let kinds: Vec<Kind> = arg_regs.iter().map(|(_, k)| *k).collect();
+        if kinds != *params {
+            return Err(self.unsupported(format!("call to `{}` with arguments {:?}", callee, kinds)));
+        }
+        if let Some((_, k)) = dest
+            && k != *ret
+            && k != Kind::Unit
+        {
+            return Err(self.unsupported(format!("`{}` result {:?} stored as {:?}", callee, ret, k)));
+        }
+        self.calls.push(CallSite { func: idx, args: arg_regs.into_iter().map(|(r, _)| r).collect() });
+        let site = self.calls.len() as u32 - 1;
+        self.emit(Op::Call { dst: dest.map_or(NO_REG, |(r, _)| r), site });
+        Ok(())
+    }
+}
+
+/// (accepted operand kinds, result kind, instruction) for a binary op
+fn binop(op: MirBinOp, dst: Reg, a: Reg, b: Reg, lhs: Kind) -> Option<(&'static [Kind], Kind, Op)> {
+    const INT: &[Kind] = &[Kind::Int];
+    const FLOAT: &[Kind] = &[Kind::Float];
+    const BOOL: &[Kind] = &[Kind::Bool];
+    const ORDERED: &[Kind] = &[Kind::Int, Kind::Char];
+    const WORD: &[Kind] = &[Kind::Int, Kind::Bool, Kind::Char, Kind::Str, Kind::Unit];
+    Some(match op {
+        MirBinOp::Add | MirBinOp::AddWrap => (INT, lhs, Op::Add { dst, a, b }),
+        MirBinOp::Sub | MirBinOp::SubWrap => (INT, lhs, Op::Sub { dst, a, b }),
+        MirBinOp::Mul | MirBinOp::MulWrap => (INT, lhs, Op::Mul { dst, a, b }),
+        MirBinOp::Div => (INT, Kind::Int, Op::Div { dst, a, b }),
+        MirBinOp::Mod => (INT, Kind::Int, Op::Mod { dst, a, b }),
+        MirBinOp::AddSat => (INT, Kind::Int, Op::AddSat { dst, a, b }),
+        MirBinOp::SubSat => (INT, Kind::Int, Op::SubSat { dst, a, b }),
+        MirBinOp::MulSat => (INT, Kind::Int, Op::MulSat { dst, a, b }),
+        MirBinOp::Shl => (INT, Kind::Int, Op::Shl { dst, a, b }),
+        MirBinOp::Shr => (INT, Kind::Int, Op::Shr { dst, a, b }),
+        MirBinOp::Band => (INT, Kind::Int, Op::Band { dst, a, b }),
+        MirBinOp::Bor => (INT, Kind::Int, Op::Bor { dst, a, b }),
+        MirBinOp::Bxor => (INT, Kind::Int, Op::Bxor { dst, a, b }),
+        MirBinOp::Eq => (WORD, Kind::Bool, Op::Eq { dst, a, b }),
+        MirBinOp::Ne => (WORD, Kind::Bool, Op::Ne { dst, a, b }),
+        MirBinOp::Lt => (ORDERED, Kind::Bool, Op::Lt { dst, a, b }),
+        MirBinOp::Le => (ORDERED, Kind::Bool, Op::Le { dst, a, b }),
+        MirBinOp::Gt => (ORDERED, Kind::Bool, Op::Gt { dst, a, b }),
+        MirBinOp::Ge => (ORDERED, Kind::Bool, Op::Ge { dst, a, b }),
+        MirBinOp::FAdd => (FLOAT, Kind::Float, Op::FAdd { dst, a, b }),
+        MirBinOp::FSub => (FLOAT, Kind::Float, Op::FSub { dst, a, b }),
+        MirBinOp::FMul => (FLOAT, Kind::Float, Op::FMul { dst, a, b }),
+        MirBinOp::FDiv => (FLOAT, Kind::Float, Op::FDiv { dst, a, b }),
+        MirBinOp::FEq => (FLOAT, Kind::Bool, Op::FEq { dst, a, b }),
+        MirBinOp::FNe => (FLOAT, Kind::Bool, Op::FNe { dst, a, b }),
+        MirBinOp::FLt => (FLOAT, Kind::Bool, Op::FLt { dst, a, b }),
+        MirBinOp::FLe => (FLOAT, Kind::Bool, Op::FLe { dst, a, b }),
+        MirBinOp::FGt => (FLOAT, Kind::Bool, Op::FGt { dst, a, b }),
+        MirBinOp::FGe => (FLOAT, Kind::Bool, Op::FGe { dst, a, b }),
+        MirBinOp::And => (BOOL, Kind::Bool, Op::And { dst, a, b }),
+        MirBinOp::Or => (BOOL, Kind::Bool, Op::Or { dst, a, b }),
+        MirBinOp::Implies => (BOOL, Kind::Bool, Op::Implies { dst, a, b }),
+        // Checked arithmetic yields Option values
+        MirBinOp::AddChecked | MirBinOp::SubChecked | MirBinOp::MulChecked => return None,
+    })
+}
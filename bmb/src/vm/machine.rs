@@ -0,0 +1,249 @@
+//! Bytecode dispatch loop
+//!
+//! All frames share one register file; a call copies its arguments and the
+//! callee's constant template into a fresh window and pushes a return
+//! record, so BMB recursion never recurses in Rust.
+
+use std::rc::Rc;
+
+use super::bytecode::{Function, Kind, NO_REG, Op, Program, Reg};
+use crate::interp::{InterpResult, RuntimeError, Value};
+
+/// Maximum call depth before reporting a stack overflow
+const MAX_FRAMES: usize = 100_000;
+
+/// Suspended caller
+struct Frame {
+    func: u32,
+    /// Resume address
+    pc: usize,
+    /// Start of the caller's register window
+    base: usize,
+    /// Caller register receiving the result
+    dst: Reg,
+}
+
+/// Executes a compiled program
+pub struct Vm<'p> {
+    program: &'p Program,
+    regs: Vec<u64>,
+    frames: Vec<Frame>,
+    /// Reused argument buffer for builtin calls
+    scratch: Vec<Value>,
+}
+
+impl<'p> Vm<'p> {
+    pub fn new(program: &'p Program) -> Self {
+        Self { program, regs: Vec::with_capacity(1024), frames: Vec::new(), scratch: Vec::new() }
+    }
+
+    /// Run the entry function (which takes no arguments)
+    pub fn run(&mut self) -> InterpResult<Value> {
+        let entry = &self.program.functions[self.program.entry as usize];
+        if !entry.params.is_empty() {
+            return Err(RuntimeError::arity_mismatch(&entry.name, entry.params.len(), 0));
+        }
+        let bits = self.execute(self.program.entry)?;
+        Ok(self.to_value(bits, entry.ret))
+    }
+
+    fn enter(&mut self, func: &Function, base: usize) {
+        let params = func.params.len();
+        self.regs.resize(base + params, 0);
+        self.regs.extend_from_slice(&func.template);
+    }
+
+    fn execute(&mut self, entry: u32) -> InterpResult<u64> {
+        let program = self.program;
+        let mut fi = entry;
+        let mut func = &program.functions[fi as usize];
+        let mut base = 0;
+        let mut pc = 0;
+        self.regs.clear();
+        self.frames.clear();
+        self.enter(func, 0);
+
+        macro_rules! r {
+            ($reg:expr) => {
+                self.regs[base + $reg as usize]
+            };
+        }
+        macro_rules! int_op {
+            ($dst:expr, $a:expr, $b:expr, |$x:ident, $y:ident| $e:expr) => {{
+                let $x = r!($a) as i64;
+                let $y = r!($b) as i64;
+                r!($dst) = ($e) as u64;
+            }};
+        }
+        macro_rules! float_op {
+            ($dst:expr, $a:expr, $b:expr, |$x:ident, $y:ident| $e:expr) => {{
+                let $x = f64::from_bits(r!($a));
+                let $y = f64::from_bits(r!($b));
+                r!($dst) = ($e).to_bits();
+            }};
+        }
+        macro_rules! cmp_op {
+            ($dst:expr, $a:expr, $b:expr, $t:ty, |$x:ident, $y:ident| $e:expr) => {{
+                let $x = r!($a) as $t;
+                let $y = r!($b) as $t;
+                r!($dst) = ($e) as u64;
+            }};
+        }
+        macro_rules! fcmp_op {
+            ($dst:expr, $a:expr, $b:expr, |$x:ident, $y:ident| $e:expr) => {{
+                let $x = f64::from_bits(r!($a));
+                let $y = f64::from_bits(r!($b));
+                r!($dst) = ($e) as u64;
+            }};
+        }
+
+        loop {
+            let op = func.code[pc];
+            pc += 1;
+            match op {
+                Op::Mov { dst, src } => r!(dst) = r!(src),
+
+                Op::Add { dst, a, b } => int_op!(dst, a, b, |x, y| x.wrapping_add(y)),
+                Op::Sub { dst, a, b } => int_op!(dst, a, b, |x, y| x.wrapping_sub(y)),
+                Op::Mul { dst, a, b } => int_op!(dst, a, b, |x, y| x.wrapping_mul(y)),
+                Op::Div { dst, a, b } => {
+                    if r!(b) == 0 {
+                        return Err(RuntimeError::division_by_zero());
+                    }
+                    int_op!(dst, a, b, |x, y| x.wrapping_div(y))
+                }
+                Op::Mod { dst, a, b } => {
+                    if r!(b) == 0 {
+                        return Err(RuntimeError::division_by_zero());
+                    }
+                    int_op!(dst, a, b, |x, y| x.wrapping_rem(y))
+                }
+                Op::AddSat { dst, a, b } => int_op!(dst, a, b, |x, y| x.saturating_add(y)),
+                Op::SubSat { dst, a, b } => int_op!(dst, a, b, |x, y| x.saturating_sub(y)),
+                Op::MulSat { dst, a, b } => int_op!(dst, a, b, |x, y| x.saturating_mul(y)),
+                Op::Shl { dst, a, b } => int_op!(dst, a, b, |x, y| x.wrapping_shl(y as u32)),
+                Op::Shr { dst, a, b } => int_op!(dst, a, b, |x, y| x.wrapping_shr(y as u32)),
+                Op::Band { dst, a, b } => int_op!(dst, a, b, |x, y| x & y),
+                Op::Bor { dst, a, b } => int_op!(dst, a, b, |x, y| x | y),
+                Op::Bxor { dst, a, b } => int_op!(dst, a, b, |x, y| x ^ y),
+
+                Op::Eq { dst, a, b } => cmp_op!(dst, a, b, u64, |x, y| x == y),
+                Op::Ne { dst, a, b } => cmp_op!(dst, a, b, u64, |x, y| x != y),
+                Op::Lt { dst, a, b } => cmp_op!(dst, a, b, i64, |x, y| x < y),
+                Op::Le { dst, a, b } => cmp_op!(dst, a, b, i64, |x, y| x <= y),
+                Op::Gt { dst, a, b } => cmp_op!(dst, a, b, i64, |x, y| x > y),
+                Op::Ge { dst, a, b } => cmp_op!(dst, a, b, i64, |x, y| x >= y),
+
+                Op::FAdd { dst, a, b } => float_op!(dst, a, b, |x, y| x + y),
+                Op::FSub { dst, a, b } => float_op!(dst, a, b, |x, y| x - y),
+                Op::FMul { dst, a, b } => float_op!(dst, a, b, |x, y| x * y),
+                Op::FDiv { dst, a, b } => float_op!(dst, a, b, |x, y| x / y),
+                Op::FEq { dst, a, b } => fcmp_op!(dst, a, b, |x, y| x == y),
+                Op::FNe { dst, a, b } => fcmp_op!(dst, a, b, |x, y| x != y),
+                Op::FLt { dst, a, b } => fcmp_op!(dst, a, b, |x, y| x < y),
+                Op::FLe { dst, a, b } => fcmp_op!(dst, a, b, |x, y| x <= y),
+                Op::FGt { dst, a, b } => fcmp_op!(dst, a, b, |x, y| x > y),
+                Op::FGe { dst, a, b } => fcmp_op!(dst, a, b, |x, y| x >= y),
+
+                Op::And { dst, a, b } => r!(dst) = r!(a) & r!(b),
+                Op::Or { dst, a, b } => r!(dst) = r!(a) | r!(b),
+                Op::Implies { dst, a, b } => r!(dst) = ((r!(a) == 0) as u64) | r!(b),
+
+                Op::Neg { dst, src } => r!(dst) = (r!(src) as i64).wrapping_neg() as u64,
+                Op::FNeg { dst, src } => r!(dst) = (-f64::from_bits(r!(src))).to_bits(),
+                Op::Not { dst, src } => r!(dst) = (r!(src) == 0) as u64,
+                Op::Bnot { dst, src } => r!(dst) = !r!(src),
+
+                Op::Jmp { target } => pc = target as usize,
+                Op::JmpIfNot { cond, target } => {
+                    if r!(cond) == 0 {
+                        pc = target as usize;
+                    }
+                }
+                Op::Switch { src, table } => {
+                    let value = r!(src) as i64;
+                    let table = &func.switches[table as usize];
+                    pc = table
+                        .cases
+                        .iter()
+                        .find(|(v, _)| *v == value)
+                        .map_or(table.default, |(_, t)| *t) as usize;
+                }
+
+                Op::Call { dst, site } => {
+                    if self.frames.len() >= MAX_FRAMES {
+                        return Err(RuntimeError::stack_overflow());
+                    }
+                    let site = &func.calls[site as usize];
+                    let callee = &program.functions[site.func as usize];
+                    let new_base = base + func.frame_size;
+                    self.regs.truncate(new_base);
+                    for &arg in &site.args {
+                        let v = r!(arg);
+                        self.regs.push(v);
+                    }
+                    self.enter(callee, new_base);
+                    self.frames.push(Frame { func: fi, pc, base, dst });
+                    fi = site.func;
+                    func = callee;
+                    base = new_base;
+                    pc = 0;
+                }
+                Op::CallBuiltin { dst, site } => {
+                    let call = &func.builtin_calls[site as usize];
+                    self.scratch.clear();
+                    for &(reg, kind) in &call.args {
+                        let v = self.to_value(r!(reg), kind);
+                        self.scratch.push(v);
+                    }
+                    let result = (call.func)(&self.scratch)?;
+                    if dst != NO_REG {
+                        r!(dst) = from_value(result, call.ret, &call.name)?;
+                    }
+                }
+                Op::Ret { src } => {
+                    let value = r!(src);
+                    let Some(frame) = self.frames.pop() else {
+                        return Ok(value);
+                    };
+                    fi = frame.func;
+                    func = &program.functions[fi as usize];
+                    base = frame.base;
+                    pc = frame.pc;
+                    if frame.dst != NO_REG {
+                        r!(frame.dst) = value;
+                    }
+                }
+                Op::Trap => {
+                    return Err(RuntimeError::type_error("reachable code", &format!("unreachable in {}", func.name)));
+                }
+            }
+        }
+    }
+
+    fn to_value(&self, bits: u64, kind: Kind) -> Value {
+        match kind {
+            Kind::Int => Value::Int(bits as i64),
+            Kind::Float => Value::Float(f64::from_bits(bits)),
+            Kind::Bool => Value::Bool(bits != 0),
+            Kind::Char => Value::Char(char::from_u32(bits as u32).unwrap_or('\0')),
+            Kind::Str => Value::Str(Rc::clone(&self.program.strings[bits as usize])),
+            Kind::Unit => Value::Unit,
+        }
+    }
+}
+
+/// Convert a builtin's result into register bits
+fn from_value(value: Value, kind: Kind, builtin: &str) -> InterpResult<u64> {
+    match (kind, value) {
+        (Kind::Int, Value::Int(n)) => Ok(n as u64),
+        (Kind::Float, Value::Float(f)) => Ok(f.to_bits()),
+        (Kind::Bool, Value::Bool(b)) => Ok(b as u64),
+        (Kind::Char, Value::Char(c)) => Ok(c as u64),
+        (Kind::Unit, _) => Ok(0),
+        (kind, value) => Err(RuntimeError::type_error(
+            &format!("{:?} from {}", kind, builtin),
+            value.type_name(),
+        )),
+    }
+}
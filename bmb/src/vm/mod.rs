@@ -0,0 +1,248 @@
+//! Bytecode VM
+//!
+//! A faster alternative to the tree-walking interpreter for `bmb run` and
+//! the REPL. Optimized MIR is compiled to register bytecode (`bytecode`)
+//! and executed by a single dispatch loop (`machine`) over untagged 64-bit
+//! registers, so arithmetic and calls allocate nothing.
+//!
+//! The VM covers scalar programs: integers, floats, bools, chars, string
+//! constants, user calls and builtins. Anything else (structs, enums,
+//! arrays, strings built at run time) is rejected at compile time and the
+//! caller falls back to the interpreter.
+
+mod bytecode;
+mod machine;
+
+pub use bytecode::{compile, Function, Kind, Op, Program, Reg, VmCompileError};
+pub use machine::Vm;
+
+use crate::ast;
+use crate::interp::{InterpResult, Interpreter, Value};
+use crate::mir::{OptLevel, OptimizationPipeline};
+
+/// Lower, optimize and compile a type-checked program for the VM
+pub fn compile_ast(program: &ast::Program, entry: &str) -> Result<Program, VmCompileError> {
+    let mut mir = crate::mir::lower_program(program);
+    OptimizationPipeline::for_level(OptLevel::Release).optimize(&mut mir);
+    let builtins = Interpreter::new();
+    compile(&mir, entry, |name| builtins.builtin(name))
+}
+
+/// Run a compiled program's entry function
+pub fn run(program: &Program) -> InterpResult<Value> {
+    Vm::new(program).run()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::interp::ErrorKind;
+    use crate::mir::test_util::{block, call, function, int, place, program, var};
+    use crate::mir::{MirBinOp, MirFunction, MirInst, MirProgram, MirType, Terminator};
+
+    fn main_calling(callee: &str, arg: i64) -> MirFunction {
+        function(
+            "main",
+            &[],
+            &[("r", MirType::I64)],
+            vec![block(
+                "entry",
+                vec![call(Some("r"), callee, vec![int(arg)])],
+                Terminator::Return(Some(var("r"))),
+            )],
+        )
+    }
+
+    fn run_main(mir: &MirProgram) -> InterpResult<Value> {
+        let compiled = compile(mir, "main", |_| None).expect("compiles");
+        run(&compiled)
+    }
+
+    /// fib(n) = if n < 2 { n } else { fib(n - 1) + fib(n - 2) }, with a phi join
+    fn fib() -> MirFunction {
+        let bin = |dest: &str, op, lhs, rhs| MirInst::BinOp { dest: place(dest), op, lhs, rhs };
+        let call = |dest: &str, arg: &str| MirInst::Call {
+            dest: Some(place(dest)),
+            func: "fib".to_string(),
+            args: vec![var(arg)],
+        };
+        function(
+            "fib",
+            &["n"],
+            &[
+                ("c", MirType::Bool),
+                ("a", MirType::I64),
+                ("b", MirType::I64),
+                ("x", MirType::I64),
+                ("y", MirType::I64),
+                ("s", MirType::I64),
+                ("r", MirType::I64),
+            ],
+            vec![
+                block(
+                    "entry",
+                    vec![bin("c", MirBinOp::Lt, var("n"), int(2))],
+                    Terminator::Branch { cond: var("c"), then_label: "join".into(), else_label: "rec".into() },
+                ),
+                block(
+                    "rec",
+                    vec![
+                        bin("a", MirBinOp::Sub, var("n"), int(1)),
+                        bin("b", MirBinOp::Sub, var("n"), int(2)),
+                        call("x", "a"),
+                        call("y", "b"),
+                        bin("s", MirBinOp::Add, var("x"), var("y")),
+                    ],
+                    Terminator::Goto("join".into()),
+                ),
+                block(
+                    "join",
+                    vec![MirInst::Phi {
+                        dest: place("r"),
+                        values: vec![(var("n"), "entry".into()), (var("s"), "rec".into())],
+                    }],
+                    Terminator::Return(Some(var("r"))),
+                ),
+            ],
+        )
+    }
+
+    #[test]
+    fn test_vm_recursive_fib() {
+        let mir = program(vec![main_calling("fib", 20), fib()]);
+        assert!(matches!(run_main(&mir), Ok(Value::Int(6765))));
+    }
+
+    #[test]
+    fn test_vm_loop_with_swapping_phis() {
+        // (a, b) = (0, 1); repeat n times: (a, b) = (b, a + b); return a
+        let mir = program(vec![
+            main_calling("fib_iter", 50),
+            function(
+                "fib_iter",
+                &["n"],
+                &[
+                    ("a", MirType::I64),
+                    ("b", MirType::I64),
+                    ("i", MirType::I64),
+                    ("c", MirType::Bool),
+                    ("t", MirType::I64),
+                    ("j", MirType::I64),
+                ],
+                vec![
+                    block("entry", vec![], Terminator::Goto("head".into())),
+                    block(
+                        "head",
+                        vec![
+                            MirInst::Phi { dest: place("a"), values: vec![(int(0), "entry".into()), (var("b"), "body".into())] },
+                            MirInst::Phi { dest: place("b"), values: vec![(int(1), "entry".into()), (var("t"), "body".into())] },
+                            MirInst::Phi { dest: place("i"), values: vec![(int(0), "entry".into()), (var("j"), "body".into())] },
+                            MirInst::BinOp { dest: place("c"), op: MirBinOp::Lt, lhs: var("i"), rhs: var("n") },
+                        ],
+                        Terminator::Branch { cond: var("c"), then_label: "body".into(), else_label: "exit".into() },
+                    ),
+                    block(
+                        "body",
+                        vec![
+                            MirInst::BinOp { dest: place("t"), op: MirBinOp::Add, lhs: var("a"), rhs: var("b") },
+                            MirInst::BinOp { dest: place("j"), op: MirBinOp::Add, lhs: var("i"), rhs: int(1) },
+                        ],
+                        Terminator::Goto("head".into()),
+                    ),
+                    block("exit", vec![], Terminator::Return(Some(var("a")))),
+                ],
+            ),
+        ]);
+        assert!(matches!(run_main(&mir), Ok(Value::Int(12586269025))));
+    }
+
+    #[test]
+    fn test_vm_switch_and_division_by_zero() {
+        let classify = function(
+            "classify",
+            &["n"],
+            &[("q", MirType::I64)],
+            vec![
+                block(
+                    "entry",
+                    vec![],
+                    Terminator::Switch {
+                        discriminant: var("n"),
+                        cases: vec![(0, "zero".into()), (7, "seven".into())],
+                        default: "other".into(),
+                    },
+                ),
+                block("zero", vec![], Terminator::Return(Some(int(100)))),
+                block("seven", vec![], Terminator::Return(Some(int(700)))),
+                block(
+                    "other",
+                    vec![MirInst::BinOp { dest: place("q"), op: MirBinOp::Div, lhs: int(10), rhs: var("n") }],
+                    Terminator::Return(Some(var("q"))),
+                ),
+            ],
+        );
+        for (arg, want) in [(0, 100), (7, 700), (5, 2)] {
+            let mir = program(vec![main_calling("classify", arg), classify.clone()]);
+            assert!(matches!(run_main(&mir), Ok(Value::Int(n)) if n == want));
+        }
+
+        let div = function(
+            "div",
+            &["n"],
+            &[("q", MirType::I64)],
+            vec![block(
+                "entry",
+                vec![MirInst::BinOp { dest: place("q"), op: MirBinOp::Div, lhs: int(1), rhs: var("n") }],
+                Terminator::Return(Some(var("q"))),
+            )],
+        );
+        let mir = program(vec![main_calling("div", 0), div]);
+        assert!(matches!(run_main(&mir), Err(e) if e.kind == ErrorKind::DivisionByZero));
+    }
+
+    #[test]
+    fn test_vm_deep_recursion_overflows_cleanly() {
+        // f(n) = f(n + 1) never returns; the VM must report, not crash
+        let f = function(
+            "f",
+            &["n"],
+            &[("m", MirType::I64), ("r", MirType::I64)],
+            vec![block(
+                "entry",
+                vec![
+                    MirInst::BinOp { dest: place("m"), op: MirBinOp::Add, lhs: var("n"), rhs: int(1) },
+                    MirInst::Call { dest: Some(place("r")), func: "f".into(), args: vec![var("m")] },
+                ],
+                Terminator::Return(Some(var("r"))),
+            )],
+        );
+        let mir = program(vec![main_calling("f", 0), f]);
+        assert!(matches!(run_main(&mir), Err(e) if e.kind == ErrorKind::StackOverflow));
+    }
+
+    #[test]
+    fn test_vm_calls_builtins() {
+        let interp = Interpreter::new();
+        let mir = program(vec![main_calling("abs", -42)]);
+        let compiled = compile(&mir, "main", |name| interp.builtin(name)).unwrap();
+        assert!(matches!(run(&compiled), Ok(Value::Int(42))));
+    }
+
+    #[test]
+    fn test_vm_rejects_unsupported_programs() {
+        let with_struct = function(
+            "main",
+            &[],
+            &[("p", MirType::StructPtr("Point".into()))],
+            vec![block("entry", vec![], Terminator::Return(Some(int(0))))],
+        );
+        assert!(matches!(
+            compile(&program(vec![with_struct]), "main", |_| None),
+            Err(VmCompileError::Unsupported { .. })
+        ));
+
+        let mir = program(vec![main_calling("missing", 1)]);
+        assert!(matches!(compile(&mir, "main", |_| None), Err(VmCompileError::UnknownFunction { .. })));
+        assert!(matches!(compile(&mir, "nope", |_| None), Err(VmCompileError::NoEntry(_))));
+    }
+}
@@ -1,9 +1,20 @@
 // BMB Runtime Library
 // Provides basic I/O functions for BMB programs
 
+// mmap/MAP_ANONYMOUS and friends are not exposed under strict -std=c11
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+// dl_iterate_phdr (runtime stats) is a GNU extension in glibc
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
 
 // Windows binary mode support
 #ifdef _WIN32
@@ -11,6 +22,14 @@
 #include <fcntl.h>
 #endif
 
+// Runtime state that code on pool threads touches (output buffer, string
+// arena, builder and reader tables) is kept per thread; see Thread Pool.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define BMB_THREAD_LOCAL __declspec(thread)
+#else
+#define BMB_THREAD_LOCAL _Thread_local
+#endif
+
 // Initialize stdout to binary mode on Windows (prevents LF -> CRLF conversion)
 static void init_binary_stdout(void) {
 #ifdef _WIN32
@@ -18,34 +37,109 @@ static void init_binary_stdout(void) {
 #endif
 }
 
+// ===================================================
+// Buffered stdout
+// All print functions append to one runtime-owned buffer that is written
+// with a single fwrite when full, so hot print loops pay neither stdio
+// locking nor printf parsing per call. The buffer is flushed at exit
+// (atexit, so exit() paths are covered), before reading stdin, before
+// running child processes, before diagnostics go to stderr, and by the
+// flush() builtin. Every thread has its own buffer; pool workers flush
+// theirs when a task finishes, so a task's output is written whole and
+// before join() or parallel_for() returns.
+// ===================================================
+
+#define BMB_OUT_BUF_SIZE (64 * 1024)
+
+static BMB_THREAD_LOCAL char bmb_out_buf[BMB_OUT_BUF_SIZE];
+static BMB_THREAD_LOCAL size_t bmb_out_len = 0;
+
+// Write pending output and flush stdio
+static void bmb_out_flush(void) {
+    if (bmb_out_len) {
+        fwrite(bmb_out_buf, 1, bmb_out_len, stdout);
+        bmb_out_len = 0;
+    }
+    fflush(stdout);
+}
+
+static void bmb_out_write(const char* p, size_t n) {
+    if (bmb_out_len + n > BMB_OUT_BUF_SIZE) {
+        bmb_out_flush();
+        // Too big to be worth buffering: write straight through
+        if (n >= BMB_OUT_BUF_SIZE) {
+            fwrite(p, 1, n, stdout);
+            return;
+        }
+    }
+    memcpy(bmb_out_buf + bmb_out_len, p, n);
+    bmb_out_len += n;
+}
+
+static void bmb_out_byte(char c) {
+    if (bmb_out_len == BMB_OUT_BUF_SIZE) bmb_out_flush();
+    bmb_out_buf[bmb_out_len++] = c;
+}
+
+// Format n in decimal into out (at least 20 bytes); returns the length
+static int64_t bmb_format_i64(char* out, int64_t n) {
+    char tmp[20];
+    int64_t i = 0;
+    uint64_t u = n < 0 ? (uint64_t)0 - (uint64_t)n : (uint64_t)n;
+    do {
+        tmp[i++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    int64_t len = 0;
+    if (n < 0) out[len++] = '-';
+    while (i) out[len++] = tmp[--i];
+    return len;
+}
+
+static void bmb_out_i64(int64_t x) {
+    // Format straight into the buffer; 21 bytes covers sign and newline
+    if (bmb_out_len + 21 > BMB_OUT_BUF_SIZE) bmb_out_flush();
+    bmb_out_len += (size_t)bmb_format_i64(bmb_out_buf + bmb_out_len, x);
+}
+
+static void bmb_out_f64(double x) {
+    char tmp[32];
+    int n = snprintf(tmp, sizeof tmp, "%g", x);
+    bmb_out_write(tmp, (size_t)n);
+}
+
 // Print i64 without newline
 void bmb_print_i64(int64_t x) {
-    printf("%lld", (long long)x);
+    bmb_out_i64(x);
 }
 
 // Print i64 with newline
 void bmb_println_i64(int64_t x) {
-    printf("%lld\n", (long long)x);
+    bmb_out_i64(x);
+    bmb_out_byte('\n');
 }
 
 // Print f64 without newline
 void bmb_print_f64(double x) {
-    printf("%g", x);
+    bmb_out_f64(x);
 }
 
 // Print f64 with newline
 void bmb_println_f64(double x) {
-    printf("%g\n", x);
+    bmb_out_f64(x);
+    bmb_out_byte('\n');
 }
 
 // Print boolean
 void bmb_println_bool(int b) {
-    printf("%s\n", b ? "true" : "false");
+    if (b) bmb_out_write("true\n", 5);
+    else bmb_out_write("false\n", 6);
 }
 
 // Assert condition
 void bmb_assert(int cond, const char* msg) {
     if (!cond) {
+        bmb_out_flush();
         fprintf(stderr, "Assertion failed: %s\n", msg);
         exit(1);
     }
@@ -53,6 +147,7 @@ void bmb_assert(int cond, const char* msg) {
 
 // Panic with message
 void bmb_panic(const char* msg) {
+    bmb_out_flush();
     fprintf(stderr, "panic: %s\n", msg);
     exit(1);
 }
@@ -73,17 +168,30 @@ void bmb_panic(const char* msg) {
 
 // println(i64) - Print i64 with newline (bootstrap version)
 void println(int64_t x) {
-    printf("%lld\n", (long long)x);
+    bmb_out_i64(x);
+    bmb_out_byte('\n');
 }
 
 // print(i64) - Print i64 without newline
 void print(int64_t x) {
-    printf("%lld", (long long)x);
+    bmb_out_i64(x);
+}
+
+// flush() - Write buffered stdout now (returns 0)
+int64_t bmb_flush(void) {
+    bmb_out_flush();
+    return 0;
+}
+
+int64_t flush(void) {
+    return bmb_flush();
 }
 
 // read_int() - Read i64 from stdin
 int64_t read_int(void) {
     int64_t x;
+    // Make any prompt visible before blocking on input
+    bmb_out_flush();
     if (scanf("%lld", (long long*)&x) != 1) {
         fprintf(stderr, "Error: failed to read integer\n");
         exit(1);
@@ -94,6 +202,7 @@ int64_t read_int(void) {
 // assert(i1) - Assert condition is true
 void assert(int cond) {
     if (!cond) {
+        bmb_out_flush();
         fprintf(stderr, "Assertion failed\n");
         exit(1);
     }
@@ -119,38 +228,420 @@ int64_t max(int64_t a, int64_t b) {
 // For native Bootstrap compiler support
 // ===================================================
 
-#include <string.h>
 #include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
-// String type in BMB native runtime: heap-allocated char* with length
-// Uses refcount=1 always (simplified GC model)
-
-typedef struct {
+// String type in BMB native runtime: length-prefixed bytes.
+// Owned strings keep header and payload in one contiguous arena block (data
+// points just past the header) and are always NUL-terminated.
+// Views (cap == 0) are zero-copy slices: data points into the buffer of
+// `owner` and is NOT necessarily NUL-terminated; use bmb_string_cstr()
+// wherever a C string is required.
+// Static strings are string literals emitted by the compiler as constant
+// globals (header and NUL-terminated data in read-only memory). They are
+// self-owned views: cap == 0 and owner points at the header itself (see
+// bmb_string_is_static). They must never be freed, released by arena_pop,
+// or written to.
+// Reader lines (see read_line) are owned by their line reader and reused by
+// its next read; their owner is bmb_transient_owner, and slicing one copies.
+
+typedef struct BmbString {
     char* data;
     int64_t len;
-    int64_t cap;
+    int64_t cap;                 // bytes reserved at data; 0 marks a view
+    struct BmbString* owner;     // views: string owning the buffer; static: itself;
+                                 // reader lines: &bmb_transient_owner; NULL otherwise
 } BmbString;
 
-// Global string pool for interning (simplified)
-#define MAX_STRINGS 65536
-static BmbString* string_pool[MAX_STRINGS];
-static int64_t string_pool_count = 0;
+// Marks headers whose bytes are overwritten by a later runtime call
+static BmbString bmb_transient_owner;
 
-// Allocate new string
-BmbString* bmb_string_new(const char* data, int64_t len) {
-    BmbString* s = (BmbString*)malloc(sizeof(BmbString));
-    s->data = (char*)malloc(len + 1);
-    memcpy(s->data, data, len);
+#define BMB_STRING_IS_VIEW(s) ((s)->cap == 0)
+#define BMB_STRING_IS_TRANSIENT(s) ((s)->owner == &bmb_transient_owner)
+
+// Compiler-emitted literal header in read-only memory
+static inline int bmb_string_is_static(const BmbString* s) {
+    return s->owner == s && s->cap == 0;
+}
+
+// ===================================================
+// Runtime Statistics (BMB_RUNTIME_STATS)
+// With BMB_RUNTIME_STATS set, every allocating runtime API counts its calls
+// and the bytes it requests, and the program reports at exit: per-API
+// totals, the peak RSS, the arena high-water mark and the call sites that
+// allocate most. The value is a comma-separated list of "text" (or "1"),
+// "json", "leaks" (also summarize what is still live at exit) and
+// "file=PATH" (write the report there instead of stderr).
+// Call sites are sampled: on average one allocation in
+// BMB_RUNTIME_STATS_SAMPLE (default 256) on each thread records its return
+// address, so the hot path only decrements a thread-local countdown. Counters are per thread
+// and summed at exit. With the variable unset each hook is one predictable
+// branch on a flag that is written once before any pool thread starts.
+// vec_* and box_* are inlined by the compiler; `bmb build --runtime-stats`
+// routes them through this runtime so they are counted too.
+// ===================================================
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BMB_COLD __attribute__((cold, noinline))
+#define BMB_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define BMB_CALLER() __builtin_return_address(0)
+#else
+#include <intrin.h>
+#define BMB_COLD
+#define BMB_UNLIKELY(x) (x)
+#define BMB_CALLER() _ReturnAddress()
+#endif
+
+typedef enum {
+    BMB_API_STRING_NEW,       // bmb_string_new (copies, literals, empty results)
+    BMB_API_STRING_CONCAT,
+    BMB_API_STRING_SLICE,     // view headers
+    BMB_API_STRING_CSTR,      // view bytes copied for libc
+    BMB_API_CHR,
+    BMB_API_READ_FILE,
+    BMB_API_FILE_OPEN,        // reader buffers
+    BMB_API_READ_LINE,        // line buffer growth
+    BMB_API_SB_PUSH,          // bytes copied into builders
+    BMB_API_SB_GROW,          // builder buffer growth
+    BMB_API_SB_BUILD,
+    BMB_API_VEC_NEW,
+    BMB_API_VEC_GROW,
+    BMB_API_BOX_NEW,
+    BMB_API_HASH_NEW,
+    BMB_API_HASH_GROW,
+    BMB_API_HASH_KEY,         // strmap key copies
+    BMB_API_ARENA_CHUNK,      // chunks and large blocks behind all strings
+    BMB_API_COUNT
+} BmbApi;
+
+static const char* const bmb_api_names[BMB_API_COUNT] = {
+    "string_new", "string_concat", "string_slice", "string_cstr", "chr",
+    "read_file", "file_open", "read_line", "sb_push", "sb_grow", "sb_build",
+    "vec_new", "vec_grow", "box_new", "hashmap_new", "hashmap_grow",
+    "strmap_key", "arena_chunk",
+};
+
+// Objects whose creation and release are both visible to the runtime
+typedef enum {
+    BMB_LIVE_VEC,
+    BMB_LIVE_BOX,
+    BMB_LIVE_HASH,
+    BMB_LIVE_BUILDER,
+    BMB_LIVE_READER,
+    BMB_LIVE_COUNT
+} BmbLive;
+
+#define BMB_STATS_SITES 1024        // sampled call-site table (power of two)
+#define BMB_STATS_DEFAULT_SAMPLE 256
+
+// One block per thread that allocated; linked so the report can sum them.
+// Only the owning thread writes a block (relaxed load + store, no lock
+// prefix), the report reads them at exit.
+typedef struct BmbStatBlock {
+    atomic_llong calls[BMB_API_COUNT];
+    atomic_llong bytes[BMB_API_COUNT];
+    struct BmbStatBlock* next;
+} BmbStatBlock;
+
+// Key (return address << 8 | api + 1); 0 marks a free slot
+typedef struct {
+    atomic_ullong key;
+    atomic_llong samples;
+    atomic_llong bytes;
+} BmbStatSite;
+
+static int bmb_stats_on = 0;
+static int64_t bmb_stats_sample = BMB_STATS_DEFAULT_SAMPLE;
+static _Atomic(BmbStatBlock*) bmb_stat_blocks = NULL;
+static BMB_THREAD_LOCAL BmbStatBlock* bmb_stat_local = NULL;
+static BMB_THREAD_LOCAL int64_t bmb_stat_countdown = 0;
+static BMB_THREAD_LOCAL uint64_t bmb_stat_rng = 0;
+static BmbStatSite bmb_stat_sites[BMB_STATS_SITES];
+static atomic_llong bmb_stat_sites_dropped;   // samples that found the table full
+static atomic_llong bmb_stat_live[BMB_LIVE_COUNT];
+static atomic_llong bmb_stat_arena_bytes;     // chunk and large-block bytes held
+static atomic_llong bmb_stat_arena_peak;
+
+static void bmb_stat_add(atomic_llong* c, int64_t n) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+static void bmb_stat_sample_site(BmbApi api, int64_t bytes, void* caller) {
+    uint64_t key = ((uint64_t)(uintptr_t)caller << 8) | (uint64_t)(api + 1);
+    uint64_t h = (key * 0x9E3779B97F4A7C15ull) >> 54;
+    for (uint64_t k = 0; k < BMB_STATS_SITES; k++) {
+        BmbStatSite* e = &bmb_stat_sites[(h + k) & (BMB_STATS_SITES - 1)];
+        unsigned long long cur = atomic_load_explicit(&e->key, memory_order_relaxed);
+        if (cur == 0 && atomic_compare_exchange_strong(&e->key, &cur, key)) cur = key;
+        if (cur == key) {
+            atomic_fetch_add_explicit(&e->samples, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&e->bytes, bytes, memory_order_relaxed);
+            return;
+        }
+    }
+    atomic_fetch_add_explicit(&bmb_stat_sites_dropped, 1, memory_order_relaxed);
+}
+
+// Next sampling interval: uniform in [1, 2 * period), so the mean is the
+// period but a loop alternating allocation kinds can't alias with it
+static int64_t bmb_stat_next_interval(void) {
+    uint64_t x = bmb_stat_rng;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    bmb_stat_rng = x;
+    return 1 + (int64_t)(x % (uint64_t)(2 * bmb_stats_sample - 1));
+}
+
+BMB_COLD
+static void bmb_stat_record(BmbApi api, int64_t bytes, void* caller) {
+    BmbStatBlock* b = bmb_stat_local;
+    if (!b) {
+        b = (BmbStatBlock*)calloc(1, sizeof(BmbStatBlock));
+        if (!b) return;
+        b->next = atomic_load(&bmb_stat_blocks);
+        while (!atomic_compare_exchange_weak(&bmb_stat_blocks, &b->next, b)) {}
+        bmb_stat_local = b;
+        bmb_stat_rng = (uint64_t)(uintptr_t)b | 1;
+        bmb_stat_countdown = bmb_stat_next_interval();
+    }
+    bmb_stat_add(&b->calls[api], 1);
+    bmb_stat_add(&b->bytes[api], bytes);
+    if (caller && --bmb_stat_countdown <= 0) {
+        bmb_stat_countdown = bmb_stat_next_interval();
+        bmb_stat_sample_site(api, bytes, caller);
+    }
+}
+
+// Count one call of `api` requesting `bytes`. A macro so the return
+// address is that of the API function's caller.
+#define BMB_STAT(api, bytes) \
+    do { \
+        if (BMB_UNLIKELY(bmb_stats_on)) bmb_stat_record((api), (int64_t)(bytes), BMB_CALLER()); \
+    } while (0)
+
+// Runtime-internal allocations: counted, but no call site is sampled
+#define BMB_STAT_INTERNAL(api, bytes) \
+    do { \
+        if (BMB_UNLIKELY(bmb_stats_on)) bmb_stat_record((api), (int64_t)(bytes), NULL); \
+    } while (0)
+
+#define BMB_STAT_LIVE(kind, delta) \
+    do { \
+        if (BMB_UNLIKELY(bmb_stats_on)) \
+            atomic_fetch_add_explicit(&bmb_stat_live[(kind)], (delta), memory_order_relaxed); \
+    } while (0)
+
+// Track bytes held by arena chunks (positive delta: acquired)
+static void bmb_stat_arena(int64_t delta) {
+    if (!BMB_UNLIKELY(bmb_stats_on)) return;
+    int64_t now = atomic_fetch_add_explicit(&bmb_stat_arena_bytes, delta, memory_order_relaxed) + delta;
+    int64_t peak = atomic_load_explicit(&bmb_stat_arena_peak, memory_order_relaxed);
+    while (now > peak &&
+           !atomic_compare_exchange_weak_explicit(&bmb_stat_arena_peak, &peak, now,
+                                                  memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+// ===================================================
+// String Arena (region allocator)
+// Strings are bump-allocated from large chunks and never freed one by one.
+// bmb_arena_push() opens a region; bmb_arena_pop() releases every string
+// allocated since the matching push, so a compiler phase can drop all of
+// its temporaries at once. Strings allocated outside any region live until
+// process exit. A string must not be used after its region is popped.
+// Each thread has its own chunks and region stack: strings may be read
+// from any thread, but only regions of the allocating thread release them.
+// ===================================================
+
+#define BMB_ARENA_CHUNK_SIZE ((size_t)1 << 20)   // 1 MiB bump chunks
+#define BMB_ARENA_LARGE_SIZE (BMB_ARENA_CHUNK_SIZE / 4)
+#define BMB_ARENA_ALIGN 16
+#define BMB_ARENA_MAX_DEPTH 256
+#define BMB_ARENA_ROUND(n) (((n) + (BMB_ARENA_ALIGN - 1)) & ~(size_t)(BMB_ARENA_ALIGN - 1))
+
+typedef struct BmbArenaChunk {
+    struct BmbArenaChunk* prev;
+    size_t size;   // usable bytes after the header
+    size_t used;   // bytes handed out so far
+} BmbArenaChunk;
+
+#define BMB_ARENA_HEADER BMB_ARENA_ROUND(sizeof(BmbArenaChunk))
+
+typedef struct {
+    BmbArenaChunk* chunk;   // current bump chunk at push time
+    size_t used;            // its fill level at push time
+    BmbArenaChunk* large;   // newest large block at push time
+} BmbArenaMark;
+
+// Bump chunks (head is the one being filled) and dedicated large blocks
+static BMB_THREAD_LOCAL BmbArenaChunk* arena_chunks = NULL;
+static BMB_THREAD_LOCAL BmbArenaChunk* arena_large = NULL;
+// One released chunk kept around so push/pop cycles don't hit malloc
+static BMB_THREAD_LOCAL BmbArenaChunk* arena_spare = NULL;
+static BMB_THREAD_LOCAL BmbArenaMark arena_marks[BMB_ARENA_MAX_DEPTH];
+static BMB_THREAD_LOCAL int64_t arena_depth = 0;
+
+static BmbArenaChunk* bmb_arena_new_chunk(size_t size) {
+    BmbArenaChunk* c = (BmbArenaChunk*)malloc(BMB_ARENA_HEADER + size);
+    if (!c) {
+        fprintf(stderr, "panic: out of memory (arena chunk of %zu bytes)\n", size);
+        exit(1);
+    }
+    c->prev = NULL;
+    c->size = size;
+    c->used = 0;
+    BMB_STAT_INTERNAL(BMB_API_ARENA_CHUNK, BMB_ARENA_HEADER + size);
+    bmb_stat_arena((int64_t)(BMB_ARENA_HEADER + size));
+    return c;
+}
+
+static void bmb_arena_free_chunk(BmbArenaChunk* c) {
+    bmb_stat_arena(-(int64_t)(BMB_ARENA_HEADER + c->size));
+    free(c);
+}
+
+static void bmb_arena_release_chunk(BmbArenaChunk* c) {
+    if (!arena_spare && c->size == BMB_ARENA_CHUNK_SIZE) {
+        arena_spare = c;
+    } else {
+        bmb_arena_free_chunk(c);
+    }
+}
+
+// Allocate n bytes (16-byte aligned) from the current region
+static void* bmb_arena_alloc(size_t n) {
+    n = BMB_ARENA_ROUND(n);
+
+    // Large blocks get their own allocation so they don't strand chunk space
+    if (n >= BMB_ARENA_LARGE_SIZE) {
+        BmbArenaChunk* c = bmb_arena_new_chunk(n);
+        c->used = n;
+        c->prev = arena_large;
+        arena_large = c;
+        return (char*)c + BMB_ARENA_HEADER;
+    }
+
+    BmbArenaChunk* c = arena_chunks;
+    if (!c || c->size - c->used < n) {
+        if (arena_spare) {
+            c = arena_spare;
+            arena_spare = NULL;
+            c->used = 0;
+        } else {
+            c = bmb_arena_new_chunk(BMB_ARENA_CHUNK_SIZE);
+        }
+        c->prev = arena_chunks;
+        arena_chunks = c;
+    }
+    void* p = (char*)c + BMB_ARENA_HEADER + c->used;
+    c->used += n;
+    return p;
+}
+
+// Open a new region; returns the new nesting depth (-1 if nested too deeply)
+int64_t bmb_arena_push(void) {
+    if (arena_depth >= BMB_ARENA_MAX_DEPTH) return -1;
+    BmbArenaMark* m = &arena_marks[arena_depth];
+    m->chunk = arena_chunks;
+    m->used = arena_chunks ? arena_chunks->used : 0;
+    m->large = arena_large;
+    return ++arena_depth;
+}
+
+// Release every string allocated since the matching push.
+// Returns the remaining nesting depth (-1 if there is no open region).
+int64_t bmb_arena_pop(void) {
+    if (arena_depth <= 0) return -1;
+    BmbArenaMark* m = &arena_marks[--arena_depth];
+
+    while (arena_chunks && arena_chunks != m->chunk) {
+        BmbArenaChunk* prev = arena_chunks->prev;
+        bmb_arena_release_chunk(arena_chunks);
+        arena_chunks = prev;
+    }
+    if (arena_chunks) arena_chunks->used = m->used;
+
+    while (arena_large && arena_large != m->large) {
+        BmbArenaChunk* prev = arena_large->prev;
+        bmb_arena_free_chunk(arena_large);
+        arena_large = prev;
+    }
+    return arena_depth;
+}
+
+// Release s early if it is the newest allocation of the innermost region;
+// anything else is left for bmb_arena_pop. Static literals, views and
+// reader lines do not own an arena block and are never released here.
+void bmb_string_free(BmbString* s) {
+    if (!s || bmb_string_is_static(s) || BMB_STRING_IS_VIEW(s) || BMB_STRING_IS_TRANSIENT(s)) return;
+    const BmbArenaMark* m = arena_depth > 0 ? &arena_marks[arena_depth - 1] : NULL;
+
+    if (arena_large && (char*)s == (char*)arena_large + BMB_ARENA_HEADER) {
+        if (m && arena_large == m->large) return;
+        BmbArenaChunk* prev = arena_large->prev;
+        bmb_arena_free_chunk(arena_large);
+        arena_large = prev;
+        return;
+    }
+
+    // Only headers with inline bytes (bmb_string_alloc) are one block
+    BmbArenaChunk* c = arena_chunks;
+    size_t n = BMB_ARENA_ROUND(sizeof(BmbString) + (size_t)s->cap);
+    if (!c || s->data != (char*)(s + 1) || n > c->used || (char*)s != (char*)c + BMB_ARENA_HEADER + (c->used - n)) return;
+    if (m && c == m->chunk && c->used - n < m->used) return;
+    c->used -= n;
+}
+
+// Allocate a string with room for len bytes plus the NUL terminator.
+// The caller fills data[0..len); the terminator is already written.
+static BmbString* bmb_string_alloc(int64_t len) {
+    BmbString* s = (BmbString*)bmb_arena_alloc(sizeof(BmbString) + (size_t)len + 1);
+    s->data = (char*)(s + 1);
     s->data[len] = '\0';
     s->len = len;
     s->cap = len + 1;
-    if (string_pool_count < MAX_STRINGS) {
-        string_pool[string_pool_count++] = s;
-    }
+    s->owner = NULL;
+    return s;
+}
+
+// Create a zero-copy view of bytes [start, start+len) of s.
+// Views of views point at the root owner so chains never form.
+static BmbString* bmb_string_view(BmbString* s, int64_t start, int64_t len) {
+    BmbString* v = (BmbString*)bmb_arena_alloc(sizeof(BmbString));
+    v->data = s->data + start;
+    v->len = len;
+    v->cap = 0;
+    v->owner = s->owner ? s->owner : s;
+    return v;
+}
+
+// NUL-terminated bytes of s for libc calls. A view that ends at its owner's
+// terminator is returned as is; otherwise the bytes are copied into the
+// current arena region. The header is left alone: it may be shared and
+// belong to an outer region that outlives the copy. The result is only
+// meant for the libc call at hand.
+static const char* bmb_string_cstr(BmbString* s) {
+    if (!BMB_STRING_IS_VIEW(s) || s->data[s->len] == '\0') return s->data;
+    BMB_STAT(BMB_API_STRING_CSTR, s->len + 1);
+    char* copy = (char*)bmb_arena_alloc((size_t)s->len + 1);
+    memcpy(copy, s->data, s->len);
+    copy[s->len] = '\0';
+    return copy;
+}
+
+// Allocate new string
+BmbString* bmb_string_new(const char* data, int64_t len) {
+    BMB_STAT(BMB_API_STRING_NEW, sizeof(BmbString) + len + 1);
+    BmbString* s = bmb_string_alloc(len);
+    memcpy(s->data, data, len);
     return s;
 }
 
-// String from C string literal
+// String from a C string (copies; compiled literals are static BmbString globals)
 BmbString* bmb_string_from_cstr(const char* cstr) {
     return bmb_string_new(cstr, strlen(cstr));
 }
@@ -166,13 +657,17 @@ int64_t bmb_string_char_at(BmbString* s, int64_t idx) {
     return (int64_t)(unsigned char)s->data[idx];
 }
 
-// Slice string [start, end)
+// Slice string [start, end) as a zero-copy view of s
 BmbString* bmb_string_slice(BmbString* s, int64_t start, int64_t end) {
     if (!s) return bmb_string_new("", 0);
     if (start < 0) start = 0;
     if (end > s->len) end = s->len;
     if (start >= end) return bmb_string_new("", 0);
-    return bmb_string_new(s->data + start, end - start);
+    // A reader line is overwritten by the next read: slices must not share it
+    if (BMB_STRING_IS_TRANSIENT(s)) return bmb_string_new(s->data + start, end - start);
+    if (start == 0 && end == s->len) return s;
+    BMB_STAT(BMB_API_STRING_SLICE, sizeof(BmbString));
+    return bmb_string_view(s, start, end - start);
 }
 
 // Concatenate two strings
@@ -181,18 +676,10 @@ BmbString* bmb_string_concat(BmbString* a, BmbString* b) {
     if (!a) return bmb_string_new(b->data, b->len);
     if (!b) return bmb_string_new(a->data, a->len);
 
-    int64_t newlen = a->len + b->len;
-    char* data = (char*)malloc(newlen + 1);
-    memcpy(data, a->data, a->len);
-    memcpy(data + a->len, b->data, b->len);
-    data[newlen] = '\0';
-    BmbString* result = (BmbString*)malloc(sizeof(BmbString));
-    result->data = data;
-    result->len = newlen;
-    result->cap = newlen + 1;
-    if (string_pool_count < MAX_STRINGS) {
-        string_pool[string_pool_count++] = result;
-    }
+    BMB_STAT(BMB_API_STRING_CONCAT, sizeof(BmbString) + a->len + b->len + 1);
+    BmbString* result = bmb_string_alloc(a->len + b->len);
+    memcpy(result->data, a->data, a->len);
+    memcpy(result->data + a->len, b->data, b->len);
     return result;
 }
 
@@ -201,6 +688,8 @@ int64_t bmb_string_eq(BmbString* a, BmbString* b) {
     if (!a && !b) return 1;
     if (!a || !b) return 0;
     if (a->len != b->len) return 0;
+    // Views of the same bytes (e.g. repeated slices of one token)
+    if (a->data == b->data) return 1;
     return memcmp(a->data, b->data, a->len) == 0 ? 1 : 0;
 }
 
@@ -214,8 +703,10 @@ int64_t bmb_cstr_eq(const char* a, const char* b) {
 
 // chr(i64) -> String: ASCII code to single character string
 BmbString* bmb_chr(int64_t code) {
-    char buf[2] = { (char)code, '\0' };
-    return bmb_string_new(buf, 1);
+    BMB_STAT(BMB_API_CHR, sizeof(BmbString) + 2);
+    BmbString* s = bmb_string_alloc(1);
+    s->data[0] = (char)code;
+    return s;
 }
 
 // ord(String) -> i64: First character's ASCII code
@@ -224,27 +715,19 @@ int64_t bmb_ord(BmbString* s) {
     return (int64_t)(unsigned char)s->data[0];
 }
 
-// Flag to track if binary mode has been initialized
-static int binary_mode_initialized = 0;
-
 // Print string without newline
 void bmb_print_str(BmbString* s) {
-    // Initialize binary mode on first call (prevents LF -> CRLF on Windows)
-    if (!binary_mode_initialized) {
-        init_binary_stdout();
-        binary_mode_initialized = 1;
-    }
     if (s && s->data) {
-        fwrite(s->data, 1, s->len, stdout);
+        bmb_out_write(s->data, (size_t)s->len);
     }
 }
 
 // Print string with newline
 void bmb_println_str(BmbString* s) {
     if (s && s->data) {
-        fwrite(s->data, 1, s->len, stdout);
+        bmb_out_write(s->data, (size_t)s->len);
     }
-    putchar('\n');
+    bmb_out_byte('\n');
 }
 
 // ===================================================
@@ -255,46 +738,44 @@ void bmb_println_str(BmbString* s) {
 int64_t bmb_file_exists(BmbString* path) {
     if (!path) return 0;
     struct stat st;
-    return stat(path->data, &st) == 0 ? 1 : 0;
+    return stat(bmb_string_cstr(path), &st) == 0 ? 1 : 0;
 }
 
 // Get file size (-1 on error)
 int64_t bmb_file_size(BmbString* path) {
     if (!path) return -1;
     struct stat st;
-    if (stat(path->data, &st) != 0) return -1;
+    if (stat(bmb_string_cstr(path), &st) != 0) return -1;
     return (int64_t)st.st_size;
 }
 
 // Read entire file to string
 BmbString* bmb_read_file(BmbString* path) {
     if (!path) return bmb_string_new("", 0);
-    FILE* f = fopen(path->data, "rb");
+    FILE* f = fopen(bmb_string_cstr(path), "rb");
     if (!f) return bmb_string_new("", 0);
 
     fseek(f, 0, SEEK_END);
     long size = ftell(f);
     fseek(f, 0, SEEK_SET);
 
-    char* data = (char*)malloc(size + 1);
-    size_t read = fread(data, 1, size, f);
-    data[read] = '\0';
+    if (size < 0) size = 0;
+
+    BMB_STAT(BMB_API_READ_FILE, sizeof(BmbString) + size + 1);
+    BmbString* result = bmb_string_alloc(size);
+    size_t read = fread(result->data, 1, size, f);
     fclose(f);
 
-    BmbString* result = (BmbString*)malloc(sizeof(BmbString));
-    result->data = data;
-    result->len = read;
-    result->cap = size + 1;
-    if (string_pool_count < MAX_STRINGS) {
-        string_pool[string_pool_count++] = result;
-    }
+    // Short read: shrink the logical length, the block stays as allocated
+    result->data[read] = '\0';
+    result->len = (int64_t)read;
     return result;
 }
 
 // Write string to file (returns 0 on success, -1 on error)
 int64_t bmb_write_file(BmbString* path, BmbString* content) {
     if (!path || !content) return -1;
-    FILE* f = fopen(path->data, "wb");
+    FILE* f = fopen(bmb_string_cstr(path), "wb");
     if (!f) return -1;
     fwrite(content->data, 1, content->len, f);
     fclose(f);
@@ -304,110 +785,1184 @@ int64_t bmb_write_file(BmbString* path, BmbString* content) {
 // Append string to file (returns 0 on success, -1 on error)
 int64_t bmb_append_file(BmbString* path, BmbString* content) {
     if (!path || !content) return -1;
-    FILE* f = fopen(path->data, "ab");
+    FILE* f = fopen(bmb_string_cstr(path), "ab");
     if (!f) return -1;
     fwrite(content->data, 1, content->len, f);
     fclose(f);
     return 0;
 }
 
+// Map a whole file read-only and return a zero-copy view of it.
+// The file is mapped over an anonymous reservation one page longer than
+// the file, so the byte after the content is always a readable NUL and
+// the view can be passed to libc without a copy. Mappings stay valid until
+// process exit; they are page-cache backed and cost no heap. Falls back to
+// bmb_read_file where mmap is unavailable or the file cannot be mapped.
+BmbString* bmb_read_file_mapped(BmbString* path) {
+    if (!path) return bmb_string_new("", 0);
+#ifdef _WIN32
+    return bmb_read_file(path);
+#else
+    int fd = open(bmb_string_cstr(path), O_RDONLY);
+    if (fd < 0) return bmb_string_new("", 0);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return bmb_read_file(path);
+    }
+
+    size_t size = (size_t)st.st_size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t span = (size + page) & ~(page - 1);   // always > size
+    char* base = (char*)mmap(NULL, span, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return bmb_read_file(path);
+    }
+    if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, span);
+        close(fd);
+        return bmb_read_file(path);
+    }
+    close(fd);  // the mapping keeps the file referenced
+
+    // The mapping is page cache, not heap: only the header is counted
+    BMB_STAT(BMB_API_READ_FILE, sizeof(BmbString));
+    BmbString* s = (BmbString*)bmb_arena_alloc(sizeof(BmbString));
+    s->data = base;
+    s->len = (int64_t)size;
+    s->cap = 0;
+    s->owner = NULL;
+    return s;
+#endif
+}
+
+// ===================================================
+// Streaming line reader
+// file_open() returns a handle; each read_line() returns the next line
+// including its '\n' (so "" means end of file) in a per-handle buffer
+// that is reused by the next call. Memory stays constant no matter how
+// large the file is. A line is valid until the next read_line or
+// file_close on the same handle and must be copied (e.g. concatenated or
+// pushed to a StringBuilder) if it is needed longer; string_slice copies
+// out of it by itself. Readers are allocated one by one and only reused,
+// never moved, so a line header stays at its address.
+// ===================================================
+
+#define BMB_READER_BUF_SIZE (64 * 1024)
+
+typedef struct {
+    FILE* f;
+    char* in;               // raw read buffer
+    int64_t in_pos;
+    int64_t in_end;
+    BmbString line;         // header returned by read_line
+    int64_t line_cap;       // bytes reserved at line.data
+    int64_t next_free;      // free-list link while released
+    int live;
+} BmbLineReader;
+
+// Per thread: a handle is only valid on the thread that opened it
+static BMB_THREAD_LOCAL BmbLineReader** readers = NULL;
+static BMB_THREAD_LOCAL int64_t reader_count = 0;
+static BMB_THREAD_LOCAL int64_t reader_cap = 0;
+static BMB_THREAD_LOCAL int64_t reader_free = -1;
+
+static BmbLineReader* bmb_reader_get(int64_t handle) {
+    if (handle < 0 || handle >= reader_count) return NULL;
+    BmbLineReader* r = readers[handle];
+    return r->live ? r : NULL;
+}
+
+// Open a file for line reading; returns a handle or -1
+int64_t bmb_file_open(BmbString* path) {
+    if (!path) return -1;
+    FILE* f = fopen(bmb_string_cstr(path), "rb");
+    if (!f) return -1;
+
+    int64_t handle;
+    if (reader_free >= 0) {
+        handle = reader_free;
+        reader_free = readers[handle]->next_free;
+    } else {
+        if (reader_count >= reader_cap) {
+            int64_t cap = reader_cap ? reader_cap * 2 : 16;
+            BmbLineReader** grown = (BmbLineReader**)realloc(readers, (size_t)cap * sizeof(BmbLineReader*));
+            if (!grown) {
+                fclose(f);
+                return -1;
+            }
+            readers = grown;
+            reader_cap = cap;
+        }
+        readers[reader_count] = (BmbLineReader*)malloc(sizeof(BmbLineReader));
+        if (!readers[reader_count]) {
+            fclose(f);
+            return -1;
+        }
+        handle = reader_count++;
+    }
+
+    BmbLineReader* r = readers[handle];
+    r->f = f;
+    r->in = (char*)malloc(BMB_READER_BUF_SIZE);
+    r->in_pos = 0;
+    r->in_end = 0;
+    r->line_cap = 256;
+    r->line.data = (char*)malloc((size_t)r->line_cap);
+    r->line.len = 0;
+    r->line.cap = r->line_cap;
+    r->line.owner = &bmb_transient_owner;
+    r->next_free = -1;
+    r->live = 1;
+    if (!r->in || !r->line.data) {
+        fprintf(stderr, "panic: out of memory (file reader)\n");
+        exit(1);
+    }
+    BMB_STAT(BMB_API_FILE_OPEN, BMB_READER_BUF_SIZE + r->line_cap);
+    BMB_STAT_LIVE(BMB_LIVE_READER, 1);
+    return handle;
+}
+
+// Read the next line (with its '\n'); "" at end of file
+BmbString* bmb_read_line(int64_t handle) {
+    BmbLineReader* r = bmb_reader_get(handle);
+    if (!r) return bmb_string_new("", 0);
+
+    int64_t len = 0;
+    int64_t grown = 0;
+    for (;;) {
+        if (r->in_pos == r->in_end) {
+            r->in_pos = 0;
+            r->in_end = (int64_t)fread(r->in, 1, BMB_READER_BUF_SIZE, r->f);
+            if (r->in_end == 0) break;
+        }
+        char* start = r->in + r->in_pos;
+        int64_t avail = r->in_end - r->in_pos;
+        char* nl = (char*)memchr(start, '\n', (size_t)avail);
+        int64_t n = nl ? (int64_t)(nl - start) + 1 : avail;
+
+        if (len + n + 1 > r->line_cap) {
+            int64_t cap = r->line_cap;
+            while (cap < len + n + 1) cap *= 2;
+            char* grown_data = (char*)realloc(r->line.data, (size_t)cap);
+            if (!grown_data) {
+                fprintf(stderr, "panic: out of memory (line of %lld bytes)\n", (long long)(len + n));
+                exit(1);
+            }
+            r->line.data = grown_data;
+            grown += cap - r->line_cap;
+            r->line_cap = cap;
+        }
+        memcpy(r->line.data + len, start, (size_t)n);
+        len += n;
+        r->in_pos += n;
+        if (nl) break;
+    }
+
+    r->line.data[len] = '\0';
+    r->line.len = len;
+    r->line.cap = r->line_cap;
+    BMB_STAT(BMB_API_READ_LINE, grown);
+    return &r->line;
+}
+
+// Close a reader (returns 0, or -1 for an invalid handle)
+int64_t bmb_file_close(int64_t handle) {
+    BmbLineReader* r = bmb_reader_get(handle);
+    if (!r) return -1;
+    fclose(r->f);
+    free(r->in);
+    free(r->line.data);
+    r->live = 0;
+    r->next_free = reader_free;
+    reader_free = handle;
+    BMB_STAT_LIVE(BMB_LIVE_READER, -1);
+    return 0;
+}
+
 // ===================================================
 // StringBuilder Runtime Functions (Phase 32.3)
+// Each builder owns one geometrically growing buffer, so push is amortized
+// O(1) and len is O(1). The buffer is a BmbArenaChunk-headed malloc block:
+// sb_build adopts large buffers into the current arena region as the
+// result string's payload (no copy) and copies small ones, keeping the
+// buffer for the next builder. Handles are recycled through a free list;
+// sb_build consumes the handle, matching the interpreter.
 // ===================================================
 
+#define BMB_SB_INITIAL_CAP 256
+// Results at least this long hand their buffer over instead of being copied
+#define BMB_SB_ADOPT_MIN 4096
+
 typedef struct {
-    char** fragments;
-    int64_t* lengths;
-    int64_t count;
-    int64_t capacity;
+    BmbArenaChunk* block;   // header + buffer; NULL until the first push
+    int64_t len;
+    int64_t cap;            // usable buffer bytes (one is kept for the NUL)
+    int64_t next_free;      // free-list link while released
+    int live;
 } StringBuilder;
 
-#define MAX_STRING_BUILDERS 1024
-static StringBuilder* builders[MAX_STRING_BUILDERS];
-static int64_t builder_count = 0;
+// Per thread: a handle is only valid on the thread that created it
+static BMB_THREAD_LOCAL StringBuilder* builders = NULL;
+static BMB_THREAD_LOCAL int64_t builder_count = 0;
+static BMB_THREAD_LOCAL int64_t builder_cap = 0;
+static BMB_THREAD_LOCAL int64_t builder_free = -1;
+
+#define BMB_SB_DATA(sb) ((char*)(sb)->block + BMB_ARENA_HEADER)
+
+static StringBuilder* bmb_sb_get(int64_t handle) {
+    if (handle < 0 || handle >= builder_count) return NULL;
+    StringBuilder* sb = &builders[handle];
+    return sb->live ? sb : NULL;
+}
+
+// Make room for `extra` more bytes plus the terminating NUL
+static void bmb_sb_reserve(StringBuilder* sb, int64_t extra) {
+    int64_t need = sb->len + extra + 1;
+    if (need <= sb->cap) return;
+    int64_t cap = sb->cap ? sb->cap : BMB_SB_INITIAL_CAP;
+    while (cap < need) cap *= 2;
+    BmbArenaChunk* block = (BmbArenaChunk*)realloc(sb->block, BMB_ARENA_HEADER + (size_t)cap);
+    if (!block) {
+        fprintf(stderr, "panic: out of memory (string builder of %lld bytes)\n", (long long)cap);
+        exit(1);
+    }
+    BMB_STAT_INTERNAL(BMB_API_SB_GROW, cap - sb->cap);
+    sb->block = block;
+    sb->cap = cap;
+}
 
 // Create new StringBuilder, return handle (index)
 int64_t bmb_sb_new(void) {
-    if (builder_count >= MAX_STRING_BUILDERS) return -1;
-    StringBuilder* sb = (StringBuilder*)malloc(sizeof(StringBuilder));
-    sb->fragments = (char**)malloc(64 * sizeof(char*));
-    sb->lengths = (int64_t*)malloc(64 * sizeof(int64_t));
-    sb->count = 0;
-    sb->capacity = 64;
-    builders[builder_count] = sb;
-    return builder_count++;
+    int64_t handle;
+    if (builder_free >= 0) {
+        handle = builder_free;
+        builder_free = builders[handle].next_free;
+    } else {
+        if (builder_count >= builder_cap) {
+            int64_t cap = builder_cap ? builder_cap * 2 : 64;
+            StringBuilder* grown = (StringBuilder*)realloc(builders, (size_t)cap * sizeof(StringBuilder));
+            if (!grown) return -1;
+            builders = grown;
+            builder_cap = cap;
+        }
+        handle = builder_count++;
+        builders[handle].block = NULL;
+        builders[handle].cap = 0;
+    }
+    StringBuilder* sb = &builders[handle];
+    sb->len = 0;
+    sb->next_free = -1;
+    sb->live = 1;
+    BMB_STAT_LIVE(BMB_LIVE_BUILDER, 1);
+    return handle;
 }
 
 // Push string to StringBuilder
 int64_t bmb_sb_push(int64_t handle, BmbString* s) {
-    if (handle < 0 || handle >= builder_count) return -1;
-    StringBuilder* sb = builders[handle];
+    StringBuilder* sb = bmb_sb_get(handle);
     if (!sb || !s) return -1;
+    BMB_STAT(BMB_API_SB_PUSH, s->len);
+    bmb_sb_reserve(sb, s->len);
+    memcpy(BMB_SB_DATA(sb) + sb->len, s->data, s->len);
+    sb->len += s->len;
+    return 0;
+}
 
-    if (sb->count >= sb->capacity) {
-        sb->capacity *= 2;
-        sb->fragments = (char**)realloc(sb->fragments, sb->capacity * sizeof(char*));
-        sb->lengths = (int64_t*)realloc(sb->lengths, sb->capacity * sizeof(int64_t));
-    }
+// Push a single byte without creating a temporary string
+int64_t bmb_sb_push_char(int64_t handle, int64_t c) {
+    StringBuilder* sb = bmb_sb_get(handle);
+    if (!sb) return -1;
+    BMB_STAT(BMB_API_SB_PUSH, 1);
+    bmb_sb_reserve(sb, 1);
+    BMB_SB_DATA(sb)[sb->len++] = (char)c;
+    return 0;
+}
 
-    char* copy = (char*)malloc(s->len + 1);
-    memcpy(copy, s->data, s->len);
-    copy[s->len] = '\0';
-    sb->fragments[sb->count] = copy;
-    sb->lengths[sb->count] = s->len;
-    sb->count++;
+// Push the decimal form of n without creating a temporary string
+int64_t bmb_sb_push_int(int64_t handle, int64_t n) {
+    StringBuilder* sb = bmb_sb_get(handle);
+    if (!sb) return -1;
+    bmb_sb_reserve(sb, 20);
+    int64_t n_len = bmb_format_i64(BMB_SB_DATA(sb) + sb->len, n);
+    BMB_STAT(BMB_API_SB_PUSH, n_len);
+    sb->len += n_len;
     return 0;
 }
 
 // Get total length
 int64_t bmb_sb_len(int64_t handle) {
-    if (handle < 0 || handle >= builder_count) return 0;
-    StringBuilder* sb = builders[handle];
-    if (!sb) return 0;
-    int64_t total = 0;
-    for (int64_t i = 0; i < sb->count; i++) {
-        total += sb->lengths[i];
-    }
-    return total;
+    StringBuilder* sb = bmb_sb_get(handle);
+    return sb ? sb->len : 0;
 }
 
-// Build final string
+// Build final string and release the handle
 BmbString* bmb_sb_build(int64_t handle) {
-    if (handle < 0 || handle >= builder_count) return bmb_string_new("", 0);
-    StringBuilder* sb = builders[handle];
+    StringBuilder* sb = bmb_sb_get(handle);
     if (!sb) return bmb_string_new("", 0);
 
-    int64_t total = bmb_sb_len(handle);
-    char* data = (char*)malloc(total + 1);
-    int64_t pos = 0;
-    for (int64_t i = 0; i < sb->count; i++) {
-        memcpy(data + pos, sb->fragments[i], sb->lengths[i]);
-        pos += sb->lengths[i];
+    BmbString* result;
+    if (sb->len >= BMB_SB_ADOPT_MIN) {
+        // Hand the buffer to the arena as a large block of the current region
+        BmbArenaChunk* block = sb->block;
+        block->size = (size_t)sb->cap;
+        block->used = (size_t)sb->cap;
+        block->prev = arena_large;
+        arena_large = block;
+        bmb_stat_arena((int64_t)(BMB_ARENA_HEADER + block->size));
+        BMB_STAT(BMB_API_SB_BUILD, sizeof(BmbString));
+
+        result = (BmbString*)bmb_arena_alloc(sizeof(BmbString));
+        result->data = BMB_SB_DATA(sb);
+        result->data[sb->len] = '\0';
+        result->len = sb->len;
+        result->cap = sb->len + 1;
+        result->owner = NULL;
+
+        sb->block = NULL;
+        sb->cap = 0;
+    } else {
+        BMB_STAT(BMB_API_SB_BUILD, sizeof(BmbString) + sb->len + 1);
+        result = bmb_string_alloc(sb->len);
+        if (sb->len) memcpy(result->data, BMB_SB_DATA(sb), sb->len);
     }
-    data[total] = '\0';
 
-    BmbString* result = (BmbString*)malloc(sizeof(BmbString));
-    result->data = data;
-    result->len = total;
-    result->cap = total + 1;
-    if (string_pool_count < MAX_STRINGS) {
-        string_pool[string_pool_count++] = result;
-    }
+    sb->live = 0;
+    sb->next_free = builder_free;
+    builder_free = handle;
+    BMB_STAT_LIVE(BMB_LIVE_BUILDER, -1);
     return result;
 }
 
 // Clear StringBuilder
 int64_t bmb_sb_clear(int64_t handle) {
-    if (handle < 0 || handle >= builder_count) return -1;
-    StringBuilder* sb = builders[handle];
+    StringBuilder* sb = bmb_sb_get(handle);
     if (!sb) return -1;
-    for (int64_t i = 0; i < sb->count; i++) {
-        free(sb->fragments[i]);
+    sb->len = 0;
+    return 0;
+}
+
+// ===================================================
+// Vector Runtime Functions
+// A vector handle points at a BmbVec header with separately allocated
+// i64 data. This is the one layout shared by the text codegen (which
+// inlines vec_new/get/set/len/push/pop/free as direct loads and stores),
+// bmb/runtime/bmb_runtime.c and the interpreter. Only the slow paths live
+// here: growth, called from the inline vec_push when len == cap, and the
+// out-of-bounds report for checked vec_get. Both are cold so the inline
+// hot path stays a compare plus a store.
+// ===================================================
+
+typedef struct BmbVec {
+    int64_t* data;
+    int64_t len;
+    int64_t cap;
+} BmbVec;
+
+#define BMB_VEC_MIN_CAP 4
+
+// Grow a vector so that at least one more element fits
+BMB_COLD
+void bmb_vec_grow(BmbVec* v) {
+    int64_t new_cap = v->cap == 0 ? BMB_VEC_MIN_CAP : v->cap * 2;
+    int64_t* data = (int64_t*)realloc(v->data, (size_t)new_cap * sizeof(int64_t));
+    if (!data) {
+        bmb_out_flush();
+        fprintf(stderr, "panic: out of memory (vector of %lld elements)\n", (long long)new_cap);
+        exit(1);
+    }
+    BMB_STAT(BMB_API_VEC_GROW, (new_cap - v->cap) * (int64_t)sizeof(int64_t));
+    v->data = data;
+    v->cap = new_cap;
+}
+
+// Grow a stack vector (escape analysis' vec_new_inline): its header is
+// followed by the inline elements, which stay in the caller's frame, so
+// the first spill copies them to the heap instead of realloc'ing
+BMB_COLD
+void bmb_vec_grow_inline(BmbVec* v) {
+    int64_t* inline_data = (int64_t*)(v + 1);
+    if (v->data != inline_data) {
+        bmb_vec_grow(v);
+        return;
     }
-    sb->count = 0;
+    int64_t new_cap = v->cap * 2;
+    int64_t* data = (int64_t*)malloc((size_t)new_cap * sizeof(int64_t));
+    if (!data) {
+        bmb_out_flush();
+        fprintf(stderr, "panic: out of memory (vector of %lld elements)\n", (long long)new_cap);
+        exit(1);
+    }
+    memcpy(data, inline_data, (size_t)v->len * sizeof(int64_t));
+    BMB_STAT(BMB_API_VEC_GROW, new_cap * (int64_t)sizeof(int64_t));
+    v->data = data;
+    v->cap = new_cap;
+}
+
+// Report an out-of-bounds vec_get (same wording as the interpreter)
+BMB_COLD
+void bmb_vec_index_oob(int64_t index, int64_t len) {
+    bmb_out_flush();
+    fprintf(stderr, "panic: vec_get: index %lld out of bounds (len=%lld)\n",
+            (long long)index, (long long)len);
+    exit(1);
+}
+
+// Out-of-line vec_new/vec_with_capacity/vec_free and box_new_i64/
+// box_free_i64. The text codegen inlines these as malloc/free; builds with
+// --runtime-stats call them instead so Runtime Statistics can count them.
+static BmbVec* bmb_vec_alloc(int64_t cap, void* caller) {
+    BmbVec* v = (BmbVec*)malloc(sizeof(BmbVec));
+    int64_t* data = cap > 0 ? (int64_t*)malloc((size_t)cap * sizeof(int64_t)) : NULL;
+    if (!v || (cap > 0 && !data)) {
+        bmb_out_flush();
+        fprintf(stderr, "panic: out of memory (vector of %lld elements)\n", (long long)cap);
+        exit(1);
+    }
+    v->data = data;
+    v->len = 0;
+    v->cap = cap > 0 ? cap : 0;
+    if (BMB_UNLIKELY(bmb_stats_on)) {
+        bmb_stat_record(BMB_API_VEC_NEW, (int64_t)sizeof(BmbVec) + v->cap * (int64_t)sizeof(int64_t), caller);
+    }
+    BMB_STAT_LIVE(BMB_LIVE_VEC, 1);
+    return v;
+}
+
+int64_t bmb_vec_new(void) {
+    return (int64_t)(intptr_t)bmb_vec_alloc(0, BMB_CALLER());
+}
+
+int64_t bmb_vec_with_capacity(int64_t cap) {
+    return (int64_t)(intptr_t)bmb_vec_alloc(cap, BMB_CALLER());
+}
+
+void bmb_vec_free(int64_t vec) {
+    BmbVec* v = (BmbVec*)(intptr_t)vec;
+    if (!v) return;
+    free(v->data);
+    free(v);
+    BMB_STAT_LIVE(BMB_LIVE_VEC, -1);
+}
+
+int64_t bmb_box_new_i64(int64_t value) {
+    int64_t* p = (int64_t*)malloc(sizeof(int64_t));
+    if (!p) {
+        bmb_out_flush();
+        fprintf(stderr, "panic: out of memory (box)\n");
+        exit(1);
+    }
+    *p = value;
+    BMB_STAT(BMB_API_BOX_NEW, sizeof(int64_t));
+    BMB_STAT_LIVE(BMB_LIVE_BOX, 1);
+    return (int64_t)(intptr_t)p;
+}
+
+void bmb_box_free_i64(int64_t box) {
+    if (!box) return;
+    free((int64_t*)(intptr_t)box);
+    BMB_STAT_LIVE(BMB_LIVE_BOX, -1);
+}
+
+// ===================================================
+// HashMap / HashSet Runtime Functions (RFC-0007)
+// Open addressing in the Swiss-table style: one control byte per slot
+// (EMPTY, DELETED, or the low 7 hash bits of a full slot) scanned 16 at a
+// time, with SSE2 compares where available. Groups are probed linearly and
+// the first 16 control bytes are mirrored past the end so a group load
+// never wraps. Hashes are wyhash (final v4). Handles are table pointers.
+// hashmap_* / hashset_* take i64 keys; strmap_* take String keys and copy
+// the key bytes, so keys outlive the arena region they came from.
+// ===================================================
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BMB_HT_SSE2 1
+#endif
+
+#define BMB_HT_GROUP 16
+#define BMB_HT_MIN_CAP 16
+#define BMB_CTRL_EMPTY ((uint8_t)0x80)
+#define BMB_CTRL_DELETED ((uint8_t)0xFE)
+#define BMB_HT_MISSING INT64_MIN
+
+// wyhash final v4 (public domain, Wang Yi)
+static const uint64_t bmb_wyp[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+static inline void bmb_wymum(uint64_t* a, uint64_t* b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t bmb_wymix(uint64_t a, uint64_t b) {
+    bmb_wymum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t bmb_wyr8(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint64_t bmb_wyr4(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline uint64_t bmb_wyr3(const uint8_t* p, size_t k) {
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+static uint64_t bmb_wyhash(const void* key, size_t len) {
+    const uint8_t* p = (const uint8_t*)key;
+    uint64_t seed = bmb_wymix(bmb_wyp[0], bmb_wyp[1]);
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (bmb_wyr4(p) << 32) | bmb_wyr4(p + ((len >> 3) << 2));
+            b = (bmb_wyr4(p + len - 4) << 32) | bmb_wyr4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = bmb_wyr3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = bmb_wymix(bmb_wyr8(p) ^ bmb_wyp[1], bmb_wyr8(p + 8) ^ seed);
+                see1 = bmb_wymix(bmb_wyr8(p + 16) ^ bmb_wyp[2], bmb_wyr8(p + 24) ^ see1);
+                see2 = bmb_wymix(bmb_wyr8(p + 32) ^ bmb_wyp[3], bmb_wyr8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = bmb_wymix(bmb_wyr8(p) ^ bmb_wyp[1], bmb_wyr8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = bmb_wyr8(p + i - 16);
+        b = bmb_wyr8(p + i - 8);
+    }
+    a ^= bmb_wyp[1];
+    b ^= seed;
+    bmb_wymum(&a, &b);
+    return bmb_wymix(a ^ bmb_wyp[0] ^ len, b ^ bmb_wyp[1]);
+}
+
+static inline uint64_t bmb_hash_key_i64(int64_t k) {
+    return bmb_wymix((uint64_t)k ^ bmb_wyp[0], bmb_wyp[1]);
+}
+
+typedef struct {
+    int64_t key;        // i64 key, or the key length for string keys
+    int64_t value;
+    char* str;          // string keys: owned copy of the key bytes
+} BmbHashEntry;
+
+typedef struct {
+    uint8_t* ctrl;          // cap + BMB_HT_GROUP control bytes
+    BmbHashEntry* entries;
+    int64_t cap;            // power of two
+    int64_t len;
+    int64_t growth_left;    // EMPTY slots that may still be filled
+    int string_keys;
+} BmbHashTable;
+
+// Bit i set where group byte i equals h2
+static inline uint32_t bmb_group_match(const uint8_t* g, uint8_t h2) {
+#ifdef BMB_HT_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)g);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+#else
+    uint32_t m = 0;
+    for (int i = 0; i < BMB_HT_GROUP; i++) m |= (uint32_t)(g[i] == h2) << i;
+    return m;
+#endif
+}
+
+// Bit i set where group byte i is EMPTY or DELETED (high bit set)
+static inline uint32_t bmb_group_match_free(const uint8_t* g) {
+#ifdef BMB_HT_SSE2
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)g));
+#else
+    uint32_t m = 0;
+    for (int i = 0; i < BMB_HT_GROUP; i++) m |= (uint32_t)(g[i] >> 7) << i;
+    return m;
+#endif
+}
+
+static inline uint32_t bmb_group_match_empty(const uint8_t* g) {
+    return bmb_group_match(g, BMB_CTRL_EMPTY);
+}
+
+static inline int bmb_ctz32(uint32_t m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(m);
+#else
+    int n = 0;
+    while (!(m & 1)) { m >>= 1; n++; }
+    return n;
+#endif
+}
+
+// Leading zeros of a nonzero 16-bit group mask
+static inline int bmb_clz16(uint32_t m) {
+    int n = 0;
+    for (uint32_t bit = 1u << 15; !(m & bit); bit >>= 1) n++;
+    return n;
+}
+
+static inline void bmb_ht_set_ctrl(BmbHashTable* t, int64_t i, uint8_t c) {
+    t->ctrl[i] = c;
+    if (i < BMB_HT_GROUP) t->ctrl[t->cap + i] = c;
+}
+
+// Control bytes plus entries of a table with cap slots
+#define BMB_HT_BYTES(cap) ((cap) + BMB_HT_GROUP + (cap) * (int64_t)sizeof(BmbHashEntry))
+
+static void bmb_ht_init(BmbHashTable* t, int64_t cap) {
+    t->cap = cap;
+    t->len = 0;
+    t->growth_left = cap - cap / 8;   // max load factor 7/8
+    t->ctrl = (uint8_t*)malloc((size_t)(cap + BMB_HT_GROUP));
+    t->entries = (BmbHashEntry*)malloc((size_t)cap * sizeof(BmbHashEntry));
+    if (!t->ctrl || !t->entries) {
+        fprintf(stderr, "panic: out of memory (hash table of %lld slots)\n", (long long)cap);
+        exit(1);
+    }
+    memset(t->ctrl, BMB_CTRL_EMPTY, (size_t)(cap + BMB_HT_GROUP));
+}
+
+static inline uint64_t bmb_ht_hash_entry(const BmbHashTable* t, const BmbHashEntry* e) {
+    return t->string_keys ? bmb_wyhash(e->str, (size_t)e->key) : bmb_hash_key_i64(e->key);
+}
+
+// First EMPTY or DELETED slot on the probe sequence of hash
+static int64_t bmb_ht_find_free(const BmbHashTable* t, uint64_t hash) {
+    int64_t mask = t->cap - 1;
+    int64_t pos = (int64_t)(hash >> 7) & mask;
+    for (;;) {
+        uint32_t m = bmb_group_match_free(t->ctrl + pos);
+        if (m) return (pos + bmb_ctz32(m)) & mask;
+        pos = (pos + BMB_HT_GROUP) & mask;
+    }
+}
+
+// Rebuild with room for at least one more entry (also purges tombstones)
+static void bmb_ht_grow(BmbHashTable* t) {
+    int64_t cap = t->cap;
+    if (t->len + 1 > (cap - cap / 8) / 2) cap *= 2;
+    BmbHashTable old = *t;
+    bmb_ht_init(t, cap);
+    BMB_STAT_INTERNAL(BMB_API_HASH_GROW, BMB_HT_BYTES(cap));
+    t->string_keys = old.string_keys;
+    for (int64_t i = 0; i < old.cap; i++) {
+        if (old.ctrl[i] & 0x80) continue;
+        uint64_t h = bmb_ht_hash_entry(t, &old.entries[i]);
+        int64_t j = bmb_ht_find_free(t, h);
+        bmb_ht_set_ctrl(t, j, (uint8_t)(h & 0x7F));
+        t->entries[j] = old.entries[i];
+    }
+    t->len = old.len;
+    t->growth_left -= old.len;
+    free(old.ctrl);
+    free(old.entries);
+}
+
+// Slot holding the key, or -1
+static int64_t bmb_ht_find(const BmbHashTable* t, uint64_t hash, int64_t key, const char* str) {
+    int64_t mask = t->cap - 1;
+    int64_t pos = (int64_t)(hash >> 7) & mask;
+    uint8_t h2 = (uint8_t)(hash & 0x7F);
+    for (;;) {
+        const uint8_t* g = t->ctrl + pos;
+        uint32_t m = bmb_group_match(g, h2);
+        while (m) {
+            int64_t i = (pos + bmb_ctz32(m)) & mask;
+            const BmbHashEntry* e = &t->entries[i];
+            if (e->key == key && (!str || memcmp(e->str, str, (size_t)key) == 0)) return i;
+            m &= m - 1;
+        }
+        if (bmb_group_match_empty(g)) return -1;
+        pos = (pos + BMB_HT_GROUP) & mask;
+    }
+}
+
+static BmbHashTable* bmb_ht_new(int string_keys) {
+    BmbHashTable* t = (BmbHashTable*)malloc(sizeof(BmbHashTable));
+    if (!t) return NULL;
+    bmb_ht_init(t, BMB_HT_MIN_CAP);
+    t->string_keys = string_keys;
+    BMB_STAT_LIVE(BMB_LIVE_HASH, 1);
+    return t;
+}
+
+// Insert or update; returns the old value, or 0 for a new key.
+// str/len describe a string key (copied on insert); str is NULL for i64 keys.
+static int64_t bmb_ht_insert(BmbHashTable* t, int64_t key, const char* str, int64_t value, int* is_new) {
+    uint64_t h = str ? bmb_wyhash(str, (size_t)key) : bmb_hash_key_i64(key);
+    int64_t i = bmb_ht_find(t, h, key, str);
+    if (i >= 0) {
+        int64_t old = t->entries[i].value;
+        t->entries[i].value = value;
+        if (is_new) *is_new = 0;
+        return old;
+    }
+    i = bmb_ht_find_free(t, h);
+    if (t->ctrl[i] == BMB_CTRL_EMPTY && t->growth_left == 0) {
+        bmb_ht_grow(t);
+        i = bmb_ht_find_free(t, h);
+    }
+    if (t->ctrl[i] == BMB_CTRL_EMPTY) t->growth_left--;
+    bmb_ht_set_ctrl(t, i, (uint8_t)(h & 0x7F));
+    BmbHashEntry* e = &t->entries[i];
+    e->key = key;
+    e->value = value;
+    e->str = NULL;
+    if (str) {
+        e->str = (char*)malloc(key ? (size_t)key : 1);
+        if (!e->str) {
+            fprintf(stderr, "panic: out of memory (hash key)\n");
+            exit(1);
+        }
+        memcpy(e->str, str, (size_t)key);
+        BMB_STAT_INTERNAL(BMB_API_HASH_KEY, key);
+    }
+    t->len++;
+    if (is_new) *is_new = 1;
     return 0;
 }
 
+// Remove; returns the removed value or BMB_HT_MISSING
+static int64_t bmb_ht_remove(BmbHashTable* t, int64_t key, const char* str) {
+    uint64_t h = str ? bmb_wyhash(str, (size_t)key) : bmb_hash_key_i64(key);
+    int64_t i = bmb_ht_find(t, h, key, str);
+    if (i < 0) return BMB_HT_MISSING;
+    int64_t value = t->entries[i].value;
+    free(t->entries[i].str);
+    // If no 16-byte window through slot i is free of EMPTY bytes, no probe
+    // ever passed over it, so it can go back to EMPTY without a tombstone.
+    int64_t mask = t->cap - 1;
+    uint32_t after = bmb_group_match_empty(t->ctrl + i);                        // bit 0 = slot i
+    uint32_t before = bmb_group_match_empty(t->ctrl + ((i - BMB_HT_GROUP) & mask)); // bit 15 = slot i-1
+    if (after && before && bmb_ctz32(after) + bmb_clz16(before) < BMB_HT_GROUP) {
+        bmb_ht_set_ctrl(t, i, BMB_CTRL_EMPTY);
+        t->growth_left++;
+    } else {
+        bmb_ht_set_ctrl(t, i, BMB_CTRL_DELETED);
+    }
+    t->len--;
+    return value;
+}
+
+static int64_t bmb_ht_get(const BmbHashTable* t, int64_t key, const char* str) {
+    uint64_t h = str ? bmb_wyhash(str, (size_t)key) : bmb_hash_key_i64(key);
+    int64_t i = bmb_ht_find(t, h, key, str);
+    return i >= 0 ? t->entries[i].value : BMB_HT_MISSING;
+}
+
+static void bmb_ht_free(BmbHashTable* t) {
+    if (!t) return;
+    if (t->string_keys) {
+        for (int64_t i = 0; i < t->cap; i++) {
+            if (!(t->ctrl[i] & 0x80)) free(t->entries[i].str);
+        }
+    }
+    free(t->ctrl);
+    free(t->entries);
+    free(t);
+    BMB_STAT_LIVE(BMB_LIVE_HASH, -1);
+}
+
+#define BMB_HT(handle) ((BmbHashTable*)(intptr_t)(handle))
+
+// hash_i64(x) - same mixing function as the interpreter
+int64_t hash_i64(int64_t x) {
+    uint64_t h = (uint64_t)x * 0x517cc1b727220a95ull;
+    return (int64_t)(h ^ (h >> 32));
+}
+
+// hashmap_new() -> handle (0 on allocation failure)
+int64_t hashmap_new(void) {
+    BMB_STAT(BMB_API_HASH_NEW, sizeof(BmbHashTable) + BMB_HT_BYTES(BMB_HT_MIN_CAP));
+    return (int64_t)(intptr_t)bmb_ht_new(0);
+}
+
+// hashmap_insert(map, key, value) -> old value, or 0 for a new key
+int64_t hashmap_insert(int64_t map, int64_t key, int64_t value) {
+    if (!map) return 0;
+    return bmb_ht_insert(BMB_HT(map), key, NULL, value, NULL);
+}
+
+// hashmap_get(map, key) -> value, or i64::MIN if absent
+int64_t hashmap_get(int64_t map, int64_t key) {
+    if (!map) return BMB_HT_MISSING;
+    return bmb_ht_get(BMB_HT(map), key, NULL);
+}
+
+int64_t hashmap_contains(int64_t map, int64_t key) {
+    if (!map) return 0;
+    BmbHashTable* t = BMB_HT(map);
+    return bmb_ht_find(t, bmb_hash_key_i64(key), key, NULL) >= 0 ? 1 : 0;
+}
+
+// hashmap_remove(map, key) -> removed value, or i64::MIN if absent
+int64_t hashmap_remove(int64_t map, int64_t key) {
+    if (!map) return BMB_HT_MISSING;
+    return bmb_ht_remove(BMB_HT(map), key, NULL);
+}
+
+int64_t hashmap_len(int64_t map) {
+    return map ? BMB_HT(map)->len : 0;
+}
+
+void hashmap_free(int64_t map) {
+    bmb_ht_free(BMB_HT(map));
+}
+
+// HashSet<i64>: a hashmap whose values are unused
+int64_t hashset_new(void) {
+    BMB_STAT(BMB_API_HASH_NEW, sizeof(BmbHashTable) + BMB_HT_BYTES(BMB_HT_MIN_CAP));
+    return (int64_t)(intptr_t)bmb_ht_new(0);
+}
+
+// hashset_insert(set, value) -> 1 if newly added, 0 if already present
+int64_t hashset_insert(int64_t set, int64_t value) {
+    if (!set) return 0;
+    int is_new = 0;
+    bmb_ht_insert(BMB_HT(set), value, NULL, 1, &is_new);
+    return is_new;
+}
+
+int64_t hashset_contains(int64_t set, int64_t value) {
+    return hashmap_contains(set, value);
+}
+
+// hashset_remove(set, value) -> 1 if removed, 0 if absent
+int64_t hashset_remove(int64_t set, int64_t value) {
+    if (!set) return 0;
+    return bmb_ht_remove(BMB_HT(set), value, NULL) != BMB_HT_MISSING ? 1 : 0;
+}
+
+int64_t hashset_len(int64_t set) {
+    return hashmap_len(set);
+}
+
+void hashset_free(int64_t set) {
+    hashmap_free(set);
+}
+
+// String -> i64 map (same return conventions as hashmap_*)
+int64_t strmap_new(void) {
+    BMB_STAT(BMB_API_HASH_NEW, sizeof(BmbHashTable) + BMB_HT_BYTES(BMB_HT_MIN_CAP));
+    return (int64_t)(intptr_t)bmb_ht_new(1);
+}
+
+int64_t strmap_insert(int64_t map, BmbString* key, int64_t value) {
+    if (!map || !key) return 0;
+    return bmb_ht_insert(BMB_HT(map), key->len, key->data, value, NULL);
+}
+
+int64_t strmap_get(int64_t map, BmbString* key) {
+    if (!map || !key) return BMB_HT_MISSING;
+    return bmb_ht_get(BMB_HT(map), key->len, key->data);
+}
+
+int64_t strmap_contains(int64_t map, BmbString* key) {
+    if (!map || !key) return 0;
+    uint64_t h = bmb_wyhash(key->data, (size_t)key->len);
+    return bmb_ht_find(BMB_HT(map), h, key->len, key->data) >= 0 ? 1 : 0;
+}
+
+int64_t strmap_remove(int64_t map, BmbString* key) {
+    if (!map || !key) return BMB_HT_MISSING;
+    return bmb_ht_remove(BMB_HT(map), key->len, key->data);
+}
+
+int64_t strmap_len(int64_t map) {
+    return hashmap_len(map);
+}
+
+void strmap_free(int64_t map) {
+    hashmap_free(map);
+}
+
+// ===================================================
+// String Search Kernels
+// Byte scan, byte count and substring search over BmbString bytes, in
+// SSE2 and AVX2 (x86-64) and NEON (AArch64) variants. One variant is picked
+// from the CPU at startup (bmb_simd_init; the first call resolves it if
+// main() is not ours). BMB_SIMD=scalar|sse2|avx2|neon forces a variant for
+// benchmarking. Vector loops never read past len: the part shorter than one
+// vector is finished by scalar code. Substring search compares the first
+// and last needle byte a vector at a time and only memcmp's candidates.
+// ===================================================
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BMB_SIMD_AVX2 1
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BMB_SIMD_NEON 1
+#endif
+
+static inline int bmb_popcount32(uint32_t m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(m);
+#else
+    int n = 0;
+    for (; m; m &= m - 1) n++;
+    return n;
+#endif
+}
+
+typedef struct {
+    const char* name;
+    int64_t (*find_byte)(const uint8_t* p, int64_t n, uint8_t c);
+    int64_t (*count_byte)(const uint8_t* p, int64_t n, uint8_t c);
+    // Needle length 2 <= m <= n
+    int64_t (*find)(const uint8_t* h, int64_t n, const uint8_t* nd, int64_t m);
+} BmbStrKernels;
+
+static BmbStrKernels bmb_str_kernels;
+
+// Scalar finish shared by every variant: candidates at positions i.. only
+static int64_t bmb_find_from(const uint8_t* h, int64_t n, const uint8_t* nd, int64_t m, int64_t i) {
+    for (; i + m <= n; i++) {
+        if (h[i] == nd[0] && h[i + m - 1] == nd[m - 1] && memcmp(h + i + 1, nd + 1, (size_t)(m - 2)) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int64_t bmb_find_byte_scalar(const uint8_t* p, int64_t n, uint8_t c) {
+    const uint8_t* r = (const uint8_t*)memchr(p, c, (size_t)n);
+    return r ? r - p : -1;
+}
+
+static int64_t bmb_count_byte_scalar(const uint8_t* p, int64_t n, uint8_t c) {
+    int64_t count = 0;
+    for (int64_t i = 0; i < n; i++) count += p[i] == c;
+    return count;
+}
+
+static int64_t bmb_find_scalar(const uint8_t* h, int64_t n, const uint8_t* nd, int64_t m) {
+    int64_t i = 0;
+    while (i + m <= n) {
+        const uint8_t* r = (const uint8_t*)memchr(h + i, nd[0], (size_t)(n - m + 1 - i));
+        if (!r) return -1;
+        i = r - h;
+        if (h[i + m - 1] == nd[m - 1] && memcmp(h + i + 1, nd + 1, (size_t)(m - 2)) == 0) return i;
+        i++;
+    }
+    return -1;
+}
+
+#ifdef BMB_HT_SSE2
+static int64_t bmb_find_byte_sse2(const uint8_t* p, int64_t n, uint8_t c) {
+    __m128i v = _mm_set1_epi8((char)c);
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), v));
+        if (m) return i + bmb_ctz32(m);
+    }
+    for (; i < n; i++) if (p[i] == c) return i;
+    return -1;
+}
+
+static int64_t bmb_count_byte_sse2(const uint8_t* p, int64_t n, uint8_t c) {
+    __m128i v = _mm_set1_epi8((char)c);
+    int64_t count = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        count += bmb_popcount32((uint32_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), v)));
+    }
+    return count + bmb_count_byte_scalar(p + i, n - i, c);
+}
+
+static int64_t bmb_find_sse2(const uint8_t* h, int64_t n, const uint8_t* nd, int64_t m) {
+    __m128i first = _mm_set1_epi8((char)nd[0]);
+    __m128i last = _mm_set1_epi8((char)nd[m - 1]);
+    int64_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(h + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(h + i + m - 1));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        for (; mask; mask &= mask - 1) {
+            int64_t j = i + bmb_ctz32(mask);
+            if (memcmp(h + j + 1, nd + 1, (size_t)(m - 2)) == 0) return j;
+        }
+    }
+    return bmb_find_from(h, n, nd, m, i);
+}
+#endif
+
+#ifdef BMB_SIMD_AVX2
+__attribute__((target("avx2")))
+static int64_t bmb_find_byte_avx2(const uint8_t* p, int64_t n, uint8_t c) {
+    __m256i v = _mm256_set1_epi8((char)c);
+    int64_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), v));
+        if (m) return i + bmb_ctz32(m);
+    }
+    for (; i < n; i++) if (p[i] == c) return i;
+    return -1;
+}
+
+__attribute__((target("avx2")))
+static int64_t bmb_count_byte_avx2(const uint8_t* p, int64_t n, uint8_t c) {
+    __m256i v = _mm256_set1_epi8((char)c);
+    int64_t count = 0, i = 0;
+    for (; i + 32 <= n; i += 32) {
+        count += bmb_popcount32((uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), v)));
+    }
+    return count + bmb_count_byte_scalar(p + i, n - i, c);
+}
+
+__attribute__((target("avx2")))
+static int64_t bmb_find_avx2(const uint8_t* h, int64_t n, const uint8_t* nd, int64_t m) {
+    __m256i first = _mm256_set1_epi8((char)nd[0]);
+    __m256i last = _mm256_set1_epi8((char)nd[m - 1]);
+    int64_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(h + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(h + i + m - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        for (; mask; mask &= mask - 1) {
+            int64_t j = i + bmb_ctz32(mask);
+            if (memcmp(h + j + 1, nd + 1, (size_t)(m - 2)) == 0) return j;
+        }
+    }
+    return bmb_find_from(h, n, nd, m, i);
+}
+#endif
+
+#ifdef BMB_SIMD_NEON
+// 4 mask bits per byte lane (vshrn trick: NEON has no movemask)
+static inline uint64_t bmb_neon_mask(uint8x16_t eq) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+}
+
+static int64_t bmb_find_byte_neon(const uint8_t* p, int64_t n, uint8_t c) {
+    uint8x16_t v = vdupq_n_u8(c);
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint64_t m = bmb_neon_mask(vceqq_u8(vld1q_u8(p + i), v));
+        if (m) return i + (__builtin_ctzll(m) >> 2);
+    }
+    for (; i < n; i++) if (p[i] == c) return i;
+    return -1;
+}
+
+static int64_t bmb_count_byte_neon(const uint8_t* p, int64_t n, uint8_t c) {
+    uint8x16_t v = vdupq_n_u8(c);
+    uint8x16_t one = vdupq_n_u8(1);
+    int64_t count = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        count += vaddvq_u8(vandq_u8(vceqq_u8(vld1q_u8(p + i), v), one));
+    }
+    return count + bmb_count_byte_scalar(p + i, n - i, c);
+}
+
+static int64_t bmb_find_neon(const uint8_t* h, int64_t n, const uint8_t* nd, int64_t m) {
+    uint8x16_t first = vdupq_n_u8(nd[0]);
+    uint8x16_t last = vdupq_n_u8(nd[m - 1]);
+    int64_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(h + i), first), vceqq_u8(vld1q_u8(h + i + m - 1), last));
+        for (uint64_t mask = bmb_neon_mask(eq); mask; ) {
+            int bit = __builtin_ctzll(mask) >> 2;
+            int64_t j = i + bit;
+            if (memcmp(h + j + 1, nd + 1, (size_t)(m - 2)) == 0) return j;
+            mask &= ~((uint64_t)0xF << (bit * 4));
+        }
+    }
+    return bmb_find_from(h, n, nd, m, i);
+}
+#endif
+
+// Pick the string kernels for this CPU (or the BMB_SIMD override)
+void bmb_simd_init(void) {
+    const char* force = getenv("BMB_SIMD");
+    BmbStrKernels k = { "scalar", bmb_find_byte_scalar, bmb_count_byte_scalar, bmb_find_scalar };
+    if (force && strcmp(force, "scalar") == 0) {
+        bmb_str_kernels = k;
+        return;
+    }
+#ifdef BMB_HT_SSE2
+    k = (BmbStrKernels){ "sse2", bmb_find_byte_sse2, bmb_count_byte_sse2, bmb_find_sse2 };
+#endif
+#ifdef BMB_SIMD_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && !(force && strcmp(force, "sse2") == 0)) {
+        k = (BmbStrKernels){ "avx2", bmb_find_byte_avx2, bmb_count_byte_avx2, bmb_find_avx2 };
+    }
+#endif
+#ifdef BMB_SIMD_NEON
+    k = (BmbStrKernels){ "neon", bmb_find_byte_neon, bmb_count_byte_neon, bmb_find_neon };
+#endif
+    bmb_str_kernels = k;
+}
+
+static inline const BmbStrKernels* bmb_str_k(void) {
+    if (!bmb_str_kernels.find) bmb_simd_init();
+    return &bmb_str_kernels;
+}
+
+// str_find(s, needle, from) -> first index >= from where needle occurs, or -1
+int64_t str_find(BmbString* s, BmbString* needle, int64_t from) {
+    if (!s || !needle) return -1;
+    if (from < 0) from = 0;
+    int64_t m = needle->len;
+    if (from + m > s->len) return -1;
+    if (m == 0) return from;
+    const uint8_t* h = (const uint8_t*)s->data + from;
+    int64_t r = m == 1
+        ? bmb_str_k()->find_byte(h, s->len - from, (uint8_t)needle->data[0])
+        : bmb_str_k()->find(h, s->len - from, (const uint8_t*)needle->data, m);
+    return r < 0 ? -1 : from + r;
+}
+
+// str_find_byte(s, byte, from) -> first index >= from holding byte, or -1
+int64_t str_find_byte(BmbString* s, int64_t byte, int64_t from) {
+    if (!s) return -1;
+    if (from < 0) from = 0;
+    if (from >= s->len) return -1;
+    int64_t r = bmb_str_k()->find_byte((const uint8_t*)s->data + from, s->len - from, (uint8_t)byte);
+    return r < 0 ? -1 : from + r;
+}
+
+// str_count_byte(s, byte) -> number of bytes equal to byte
+int64_t str_count_byte(BmbString* s, int64_t byte) {
+    if (!s || s->len == 0) return 0;
+    return bmb_str_k()->count_byte((const uint8_t*)s->data, s->len, (uint8_t)byte);
+}
+
+// str_starts_with(s, prefix) -> 1 if s begins with prefix, else 0
+// (a single memcmp: libc already vectorizes it)
+int64_t str_starts_with(BmbString* s, BmbString* prefix) {
+    if (!s || !prefix) return 0;
+    if (prefix->len > s->len) return 0;
+    return memcmp(s->data, prefix->data, (size_t)prefix->len) == 0 ? 1 : 0;
+}
+
 // ===================================================
 // Process Execution Runtime Functions (Phase 32.3)
 // ===================================================
@@ -415,13 +1970,15 @@ int64_t bmb_sb_clear(int64_t handle) {
 // Execute shell command (returns exit code)
 int64_t bmb_system(BmbString* cmd) {
     if (!cmd) return -1;
-    return system(cmd->data);
+    // Keep our output ordered before the child's
+    bmb_out_flush();
+    return system(bmb_string_cstr(cmd));
 }
 
 // Get environment variable
 BmbString* bmb_getenv(BmbString* name) {
     if (!name) return bmb_string_new("", 0);
-    char* val = getenv(name->data);
+    char* val = getenv(bmb_string_cstr(name));
     if (!val) return bmb_string_new("", 0);
     return bmb_string_from_cstr(val);
 }
@@ -473,6 +2030,22 @@ BmbString* read_file(BmbString* path) {
     return bmb_read_file(path);
 }
 
+BmbString* read_file_mapped(BmbString* path) {
+    return bmb_read_file_mapped(path);
+}
+
+int64_t file_open(BmbString* path) {
+    return bmb_file_open(path);
+}
+
+BmbString* read_line(int64_t handle) {
+    return bmb_read_line(handle);
+}
+
+int64_t file_close(int64_t handle) {
+    return bmb_file_close(handle);
+}
+
 int64_t write_file(BmbString* path, BmbString* content) {
     return bmb_write_file(path, content);
 }
@@ -490,6 +2063,14 @@ int64_t sb_push(int64_t handle, BmbString* s) {
     return bmb_sb_push(handle, s);
 }
 
+int64_t sb_push_char(int64_t handle, int64_t c) {
+    return bmb_sb_push_char(handle, c);
+}
+
+int64_t sb_push_int(int64_t handle, int64_t n) {
+    return bmb_sb_push_int(handle, n);
+}
+
 int64_t sb_len(int64_t handle) {
     return bmb_sb_len(handle);
 }
@@ -507,12 +2088,311 @@ void print_str(BmbString* s) {
     bmb_print_str(s);
 }
 
+// String arena wrappers
+int64_t arena_push(void) {
+    return bmb_arena_push();
+}
+
+int64_t arena_pop(void) {
+    return bmb_arena_pop();
+}
+
+// ===================================================
+// Thread Pool (work stealing)
+// spawn(f, x) queues f(x) as a task and returns its handle; join(h) waits
+// for the task, frees it and returns its result. parallel_for(lo, hi, f)
+// splits [lo, hi) into chunks across the pool and returns the wrapping sum
+// of f(i). Every thread owns a deque: it pushes and pops its own tasks at
+// the back while idle threads steal from the front of the others. A thread
+// waiting in join or parallel_for runs queued tasks instead of blocking, so
+// nested parallelism cannot deadlock.
+// The pool starts on first use, which is always on the main thread (pool
+// threads only exist once it has started). BMB_THREADS sets its size,
+// main thread included; the default is one thread per CPU.
+// ===================================================
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+typedef CRITICAL_SECTION bmb_mutex_t;
+typedef CONDITION_VARIABLE bmb_cond_t;
+#define bmb_mutex_init(m) InitializeCriticalSection(m)
+#define bmb_mutex_lock(m) EnterCriticalSection(m)
+#define bmb_mutex_unlock(m) LeaveCriticalSection(m)
+#define bmb_cond_init(c) InitializeConditionVariable(c)
+#define bmb_cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define bmb_cond_signal(c) WakeConditionVariable(c)
+#define bmb_thread_yield() SwitchToThread()
+#else
+#include <pthread.h>
+#include <sched.h>
+typedef pthread_mutex_t bmb_mutex_t;
+typedef pthread_cond_t bmb_cond_t;
+#define bmb_mutex_init(m) pthread_mutex_init(m, NULL)
+#define bmb_mutex_lock(m) pthread_mutex_lock(m)
+#define bmb_mutex_unlock(m) pthread_mutex_unlock(m)
+#define bmb_cond_init(c) pthread_cond_init(c, NULL)
+#define bmb_cond_wait(c, m) pthread_cond_wait(c, m)
+#define bmb_cond_signal(c) pthread_cond_signal(c)
+#define bmb_thread_yield() sched_yield()
+#endif
+
+#define BMB_POOL_MAX_THREADS 256
+#define BMB_POOL_STACK_SIZE ((size_t)16 << 20)   // same as the main stack on Windows
+#define BMB_PAR_CHUNKS_PER_THREAD 4               // parallel_for chunks, for load balance
+
+typedef int64_t (*BmbTaskFn)(int64_t);
+
+typedef struct {
+    BmbTaskFn fn;
+    int64_t lo;              // fn runs on every i in [lo, hi)
+    int64_t hi;
+    int64_t result;          // wrapping sum of fn(i)
+    atomic_int done;
+} BmbTask;
+
+typedef struct {
+    bmb_mutex_t lock;
+    BmbTask** items;         // ring buffer: items[(head + k) % cap] for k < len
+    int64_t head;
+    int64_t len;
+    int64_t cap;
+} BmbDeque;
+
+static BmbDeque bmb_deques[BMB_POOL_MAX_THREADS];
+static int bmb_pool_threads = 0;               // 0 until the pool starts
+static atomic_llong bmb_pool_queued;           // pushed and not yet taken
+static atomic_int bmb_pool_sleepers;
+static bmb_mutex_t bmb_pool_idle_lock;
+static bmb_cond_t bmb_pool_idle;
+static BMB_THREAD_LOCAL int bmb_worker_id = 0;   // own deque; 0 is the main thread
+
+static void bmb_deque_push(BmbDeque* d, BmbTask* t) {
+    bmb_mutex_lock(&d->lock);
+    if (d->len == d->cap) {
+        int64_t cap = d->cap ? d->cap * 2 : 64;
+        BmbTask** items = (BmbTask**)malloc((size_t)cap * sizeof(BmbTask*));
+        if (!items) {
+            fprintf(stderr, "panic: out of memory (task queue)\n");
+            exit(1);
+        }
+        for (int64_t k = 0; k < d->len; k++) items[k] = d->items[(d->head + k) % d->cap];
+        free(d->items);
+        d->items = items;
+        d->head = 0;
+        d->cap = cap;
+    }
+    d->items[(d->head + d->len) % d->cap] = t;
+    d->len++;
+    bmb_mutex_unlock(&d->lock);
+}
+
+// Take the newest task (owner) or the oldest one (thief)
+static BmbTask* bmb_deque_take(BmbDeque* d, int newest) {
+    BmbTask* t = NULL;
+    bmb_mutex_lock(&d->lock);
+    if (d->len > 0) {
+        if (newest) {
+            t = d->items[(d->head + d->len - 1) % d->cap];
+        } else {
+            t = d->items[d->head];
+            d->head = (d->head + 1) % d->cap;
+        }
+        d->len--;
+    }
+    bmb_mutex_unlock(&d->lock);
+    return t;
+}
+
+static void bmb_pool_push(BmbTask* t) {
+    // Counted before it is visible so the count never undershoots
+    atomic_fetch_add(&bmb_pool_queued, 1);
+    bmb_deque_push(&bmb_deques[bmb_worker_id], t);
+    if (atomic_load(&bmb_pool_sleepers) > 0) {
+        bmb_mutex_lock(&bmb_pool_idle_lock);
+        bmb_cond_signal(&bmb_pool_idle);
+        bmb_mutex_unlock(&bmb_pool_idle_lock);
+    }
+}
+
+// Own deque first, then steal round-robin from the others
+static BmbTask* bmb_pool_find(void) {
+    if (atomic_load(&bmb_pool_queued) <= 0) return NULL;
+    BmbTask* t = bmb_deque_take(&bmb_deques[bmb_worker_id], 1);
+    for (int k = 1; !t && k < bmb_pool_threads; k++) {
+        t = bmb_deque_take(&bmb_deques[(bmb_worker_id + k) % bmb_pool_threads], 0);
+    }
+    if (t) atomic_fetch_sub(&bmb_pool_queued, 1);
+    return t;
+}
+
+static int64_t bmb_task_sum(BmbTaskFn fn, int64_t lo, int64_t hi) {
+    uint64_t sum = 0;
+    for (int64_t i = lo; i < hi; i++) sum += (uint64_t)fn(i);
+    return (int64_t)sum;
+}
+
+static void bmb_task_run(BmbTask* t) {
+    t->result = bmb_task_sum(t->fn, t->lo, t->hi);
+    // Pool threads hand their output over before the task counts as done
+    if (bmb_worker_id != 0 && bmb_out_len) bmb_out_flush();
+    atomic_store_explicit(&t->done, 1, memory_order_release);
+}
+
+static void bmb_task_wait(BmbTask* t) {
+    while (!atomic_load_explicit(&t->done, memory_order_acquire)) {
+        BmbTask* other = bmb_pool_find();
+        if (other) {
+            bmb_task_run(other);
+        } else {
+            bmb_thread_yield();
+        }
+    }
+}
+
+static void bmb_worker_loop(int id) {
+    bmb_worker_id = id;
+    for (;;) {
+        BmbTask* t = bmb_pool_find();
+        if (t) {
+            bmb_task_run(t);
+            continue;
+        }
+        bmb_mutex_lock(&bmb_pool_idle_lock);
+        atomic_fetch_add(&bmb_pool_sleepers, 1);
+        while (atomic_load(&bmb_pool_queued) <= 0) bmb_cond_wait(&bmb_pool_idle, &bmb_pool_idle_lock);
+        atomic_fetch_sub(&bmb_pool_sleepers, 1);
+        bmb_mutex_unlock(&bmb_pool_idle_lock);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI bmb_worker_main(LPVOID arg) {
+    bmb_worker_loop((int)(intptr_t)arg);
+    return 0;
+}
+#else
+static void* bmb_worker_main(void* arg) {
+    bmb_worker_loop((int)(intptr_t)arg);
+    return NULL;
+}
+#endif
+
+static int bmb_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+static void bmb_pool_start(void) {
+    if (bmb_pool_threads) return;
+    int n = bmb_cpu_count();
+    const char* env = getenv("BMB_THREADS");
+    if (env && atoi(env) > 0) n = atoi(env);
+    if (n > BMB_POOL_MAX_THREADS) n = BMB_POOL_MAX_THREADS;
+
+    bmb_mutex_init(&bmb_pool_idle_lock);
+    bmb_cond_init(&bmb_pool_idle);
+    for (int i = 0; i < n; i++) bmb_mutex_init(&bmb_deques[i].lock);
+    bmb_pool_threads = n;
+
+    // A thread that fails to start only leaves its (empty) deque unserved
+#ifdef _WIN32
+    for (int i = 1; i < n; i++) {
+        HANDLE h = CreateThread(NULL, BMB_POOL_STACK_SIZE, bmb_worker_main, (LPVOID)(intptr_t)i,
+                                STACK_SIZE_PARAM_IS_A_RESERVATION, NULL);
+        if (h) CloseHandle(h);
+    }
+#else
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, BMB_POOL_STACK_SIZE);
+    for (int i = 1; i < n; i++) {
+        pthread_t thread;
+        pthread_create(&thread, &attr, bmb_worker_main, (void*)(intptr_t)i);
+    }
+    pthread_attr_destroy(&attr);
+#endif
+}
+
+static BmbTask* bmb_task_new(BmbTaskFn fn, int64_t lo, int64_t hi) {
+    BmbTask* t = (BmbTask*)malloc(sizeof(BmbTask));
+    if (!t) {
+        fprintf(stderr, "panic: out of memory (task)\n");
+        exit(1);
+    }
+    t->fn = fn;
+    t->lo = lo;
+    t->hi = hi;
+    t->result = 0;
+    atomic_init(&t->done, 0);
+    return t;
+}
+
+// spawn(f, x): run f(x) on the pool; returns a handle for join
+int64_t bmb_spawn(BmbTaskFn fn, int64_t arg) {
+    bmb_pool_start();
+    // Keep our output ordered before the task's
+    if (bmb_out_len) bmb_out_flush();
+    BmbTask* t = bmb_task_new(fn, arg, arg + 1);
+    bmb_pool_push(t);
+    return (int64_t)(intptr_t)t;
+}
+
+// join(h): wait for a spawned task and return f(x); each handle joins once
+int64_t bmb_join(int64_t handle) {
+    BmbTask* t = (BmbTask*)(intptr_t)handle;
+    if (!t) return 0;
+    bmb_task_wait(t);
+    int64_t result = t->result;
+    free(t);
+    return result;
+}
+
+// parallel_for(lo, hi, f): wrapping sum of f(i) for i in [lo, hi)
+int64_t bmb_parallel_for(int64_t lo, int64_t hi, BmbTaskFn fn) {
+    if (hi <= lo) return 0;
+    bmb_pool_start();
+    uint64_t n = (uint64_t)hi - (uint64_t)lo;
+    uint64_t chunks = (uint64_t)bmb_pool_threads * BMB_PAR_CHUNKS_PER_THREAD;
+    if (chunks > n) chunks = n;
+    if (bmb_pool_threads == 1 || chunks < 2) return bmb_task_sum(fn, lo, hi);
+
+    if (bmb_out_len) bmb_out_flush();
+    BmbTask* tasks[BMB_POOL_MAX_THREADS * BMB_PAR_CHUNKS_PER_THREAD];
+    uint64_t step = n / chunks, extra = n % chunks;
+    int64_t start = lo;
+    for (uint64_t c = 0; c < chunks; c++) {
+        int64_t end = (int64_t)((uint64_t)start + step + (c < extra ? 1 : 0));
+        tasks[c] = bmb_task_new(fn, start, end);
+        start = end;
+    }
+    // Queue all but the first chunk, which this thread runs itself
+    for (uint64_t c = 1; c < chunks; c++) bmb_pool_push(tasks[c]);
+    uint64_t sum = (uint64_t)bmb_task_sum(fn, tasks[0]->lo, tasks[0]->hi);
+    free(tasks[0]);
+    for (uint64_t c = 1; c < chunks; c++) {
+        bmb_task_wait(tasks[c]);
+        sum += (uint64_t)tasks[c]->result;
+        free(tasks[c]);
+    }
+    return (int64_t)sum;
+}
+
 // ===================================================
 // Command-line Argument Runtime Functions (v0.31.23)
 // Phase 32.3.G: CLI Independence
 // ===================================================
 
-// Global storage for command-line arguments
+// Global storage for command-line arguments (written once by main() before
+// any pool thread starts, read-only afterwards)
 static int bmb_argc = 0;
 static char** bmb_argv = NULL;
 
@@ -548,6 +2428,207 @@ BmbString* bmb_get_arg(int64_t idx) {
     return bmb_string_from_cstr(bmb_argv[idx]);
 }
 
+// ===================================================
+// Runtime Statistics Report
+// bmb_stats_init() reads BMB_RUNTIME_STATS before the program starts and
+// registers bmb_stats_report() with atexit, so panics and exit() paths
+// are reported too. Call sites are printed as offsets into the executable
+// (`addr2line -f -e <program> <offset>`); counts for sampled sites are
+// scaled by the sampling period and therefore approximate.
+// ===================================================
+
+#ifdef _WIN32
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#include <sys/resource.h>
+#else
+#include <link.h>
+#include <sys/resource.h>
+#endif
+
+#define BMB_STATS_TOP_SITES 20
+
+static int bmb_stats_json = 0;
+static int bmb_stats_leaks = 0;
+static char bmb_stats_path[1024];
+
+// Peak resident set size in bytes (0 if unknown)
+static int64_t bmb_peak_rss(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return (int64_t)pmc.PeakWorkingSetSize;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return (int64_t)ru.ru_maxrss;          // bytes on macOS
+#else
+    return (int64_t)ru.ru_maxrss * 1024;   // KiB elsewhere
+#endif
+#endif
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+static int bmb_image_base_cb(struct dl_phdr_info* info, size_t size, void* out) {
+    (void)size;
+    *(uintptr_t*)out = (uintptr_t)info->dlpi_addr;
+    return 1;   // the first object is the executable
+}
+#endif
+
+// Load address of the executable, subtracted from sampled return addresses
+static uintptr_t bmb_image_base(void) {
+#ifdef _WIN32
+    return (uintptr_t)GetModuleHandleW(NULL);
+#elif defined(__APPLE__)
+    return (uintptr_t)_dyld_get_image_vmaddr_slide(0);
+#else
+    uintptr_t base = 0;
+    dl_iterate_phdr(bmb_image_base_cb, &base);
+    return base;
+#endif
+}
+
+typedef struct {
+    uint64_t key;
+    int64_t samples;
+    int64_t bytes;
+} BmbSiteRow;
+
+static int bmb_site_row_cmp(const void* a, const void* b) {
+    int64_t x = ((const BmbSiteRow*)a)->bytes, y = ((const BmbSiteRow*)b)->bytes;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void bmb_stats_report(void) {
+    bmb_out_flush();
+
+    int64_t calls[BMB_API_COUNT] = {0}, bytes[BMB_API_COUNT] = {0};
+    for (BmbStatBlock* b = atomic_load(&bmb_stat_blocks); b; b = b->next) {
+        for (int a = 0; a < BMB_API_COUNT; a++) {
+            calls[a] += atomic_load_explicit(&b->calls[a], memory_order_relaxed);
+            bytes[a] += atomic_load_explicit(&b->bytes[a], memory_order_relaxed);
+        }
+    }
+
+    static BmbSiteRow rows[BMB_STATS_SITES];
+    size_t nrows = 0;
+    for (size_t i = 0; i < BMB_STATS_SITES; i++) {
+        uint64_t key = atomic_load_explicit(&bmb_stat_sites[i].key, memory_order_relaxed);
+        if (!key) continue;
+        rows[nrows].key = key;
+        rows[nrows].samples = atomic_load_explicit(&bmb_stat_sites[i].samples, memory_order_relaxed);
+        rows[nrows].bytes = atomic_load_explicit(&bmb_stat_sites[i].bytes, memory_order_relaxed);
+        nrows++;
+    }
+    qsort(rows, nrows, sizeof(BmbSiteRow), bmb_site_row_cmp);
+    if (nrows > BMB_STATS_TOP_SITES) nrows = BMB_STATS_TOP_SITES;
+    uintptr_t base = bmb_image_base();
+
+    int64_t peak_rss = bmb_peak_rss();
+    int64_t arena_held = atomic_load(&bmb_stat_arena_bytes);
+    int64_t arena_peak = atomic_load(&bmb_stat_arena_peak);
+    int64_t dropped = atomic_load(&bmb_stat_sites_dropped);
+    static const char* const live_names[BMB_LIVE_COUNT] = {
+        "vectors", "boxes", "hash_tables", "string_builders", "line_readers",
+    };
+
+    FILE* out = stderr;
+    if (bmb_stats_path[0]) {
+        out = fopen(bmb_stats_path, "w");
+        if (!out) {
+            fprintf(stderr, "bmb runtime stats: cannot write %s\n", bmb_stats_path);
+            return;
+        }
+    }
+
+    if (bmb_stats_json) {
+        fprintf(out, "{\"sample_period\":%lld,\"apis\":{", (long long)bmb_stats_sample);
+        for (int a = 0; a < BMB_API_COUNT; a++) {
+            fprintf(out, "%s\"%s\":{\"calls\":%lld,\"bytes\":%lld}", a ? "," : "",
+                    bmb_api_names[a], (long long)calls[a], (long long)bytes[a]);
+        }
+        fprintf(out, "},\"peak_rss_bytes\":%lld,\"arena\":{\"held_bytes\":%lld,\"peak_bytes\":%lld},\"sites\":[",
+                (long long)peak_rss, (long long)arena_held, (long long)arena_peak);
+        for (size_t i = 0; i < nrows; i++) {
+            fprintf(out, "%s{\"offset\":\"0x%llx\",\"api\":\"%s\",\"samples\":%lld,\"est_calls\":%lld,\"est_bytes\":%lld}",
+                    i ? "," : "", (unsigned long long)((uintptr_t)(rows[i].key >> 8) - base),
+                    bmb_api_names[(rows[i].key & 0xFF) - 1], (long long)rows[i].samples,
+                    (long long)(rows[i].samples * bmb_stats_sample), (long long)(rows[i].bytes * bmb_stats_sample));
+        }
+        fprintf(out, "],\"sites_dropped\":%lld", (long long)dropped);
+        if (bmb_stats_leaks) {
+            fprintf(out, ",\"live_at_exit\":{\"arena_bytes\":%lld,\"arena_regions\":%lld",
+                    (long long)arena_held, (long long)arena_depth);
+            for (int k = 0; k < BMB_LIVE_COUNT; k++) {
+                fprintf(out, ",\"%s\":%lld", live_names[k], (long long)atomic_load(&bmb_stat_live[k]));
+            }
+            fprintf(out, "}");
+        }
+        fprintf(out, "}\n");
+    } else {
+        int64_t total_calls = 0, total_bytes = 0;
+        fprintf(out, "== bmb runtime stats ==\n%-16s %14s %16s\n", "api", "calls", "bytes");
+        for (int a = 0; a < BMB_API_COUNT; a++) {
+            if (!calls[a]) continue;
+            fprintf(out, "%-16s %14lld %16lld\n", bmb_api_names[a], (long long)calls[a], (long long)bytes[a]);
+            if (a != BMB_API_ARENA_CHUNK) {   // chunks back the string APIs above
+                total_calls += calls[a];
+                total_bytes += bytes[a];
+            }
+        }
+        fprintf(out, "%-16s %14lld %16lld\n", "total", (long long)total_calls, (long long)total_bytes);
+        fprintf(out, "peak rss: %lld bytes\n", (long long)peak_rss);
+        fprintf(out, "arena: %lld bytes held at exit, %lld peak\n", (long long)arena_held, (long long)arena_peak);
+        if (nrows) {
+            fprintf(out, "top allocation sites (1 in %lld sampled; addr2line -f -e <program> <offset>):\n",
+                    (long long)bmb_stats_sample);
+            for (size_t i = 0; i < nrows; i++) {
+                fprintf(out, "  0x%-12llx %-16s ~%lld calls ~%lld bytes\n",
+                        (unsigned long long)((uintptr_t)(rows[i].key >> 8) - base),
+                        bmb_api_names[(rows[i].key & 0xFF) - 1],
+                        (long long)(rows[i].samples * bmb_stats_sample),
+                        (long long)(rows[i].bytes * bmb_stats_sample));
+            }
+            if (dropped) fprintf(out, "  (%lld samples dropped: site table full)\n", (long long)dropped);
+        }
+        if (bmb_stats_leaks) {
+            fprintf(out, "live at exit:\n  arena bytes: %lld\n  arena regions: %lld\n",
+                    (long long)arena_held, (long long)arena_depth);
+            for (int k = 0; k < BMB_LIVE_COUNT; k++) {
+                fprintf(out, "  %s: %lld\n", live_names[k], (long long)atomic_load(&bmb_stat_live[k]));
+            }
+        }
+    }
+    if (out != stderr) fclose(out);
+}
+
+// Parse BMB_RUNTIME_STATS; called once from main() before the user program
+static void bmb_stats_init(void) {
+    const char* opts = getenv("BMB_RUNTIME_STATS");
+    if (!opts || !*opts || strcmp(opts, "0") == 0) return;
+    for (const char* p = opts; *p;) {
+        size_t n = strcspn(p, ",");
+        if (n == 4 && strncmp(p, "json", 4) == 0) {
+            bmb_stats_json = 1;
+        } else if (n == 5 && strncmp(p, "leaks", 5) == 0) {
+            bmb_stats_leaks = 1;
+        } else if (n > 5 && strncmp(p, "file=", 5) == 0 && n - 5 < sizeof(bmb_stats_path)) {
+            memcpy(bmb_stats_path, p + 5, n - 5);
+            bmb_stats_path[n - 5] = '\0';
+        }
+        // "1", "text" and unknown words just enable the text report
+        p += n;
+        if (*p == ',') p++;
+    }
+    const char* sample = getenv("BMB_RUNTIME_STATS_SAMPLE");
+    if (sample && atoll(sample) > 0) bmb_stats_sample = atoll(sample);
+    bmb_stats_on = 1;
+    atexit(bmb_stats_report);
+}
+
 // ===================================================
 // Entry Point Wrapper (v0.31.23)
 // BMB's main() is renamed to bmb_user_main() in codegen
@@ -559,6 +2640,11 @@ int64_t bmb_user_main(void);
 
 // Real main entry point
 int main(int argc, char** argv) {
+    // Binary stdout once up front (prevents LF -> CRLF on Windows)
+    init_binary_stdout();
+    atexit(bmb_out_flush);
+    bmb_simd_init();
+    bmb_stats_init();
     bmb_init_argv(argc, argv);
     return (int)bmb_user_main();
 }
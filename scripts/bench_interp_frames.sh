@@ -0,0 +1,57 @@
+#!/bin/bash
+# Interpreter variable storage benchmark
+# Times `bmb run` on the valid examples and the bootstrap fibonacci/collatz
+# programs under each --frames mode (env, scope, slots). Output of every
+# mode is checked against env; "n/a" marks a program the ScopeStack path
+# cannot run (it rejects for loops, ranges, references, closures).
+#
+# Usage: scripts/bench_interp_frames.sh [path/to/bmb] [runs]
+
+set -e
+
+BMB="${1:-target/release/bmb}"
+RUNS="${2:-5}"
+OUT="$(mktemp -d)"
+trap 'rm -rf "$OUT"' EXIT
+
+MODES="env scope slots"
+
+printf "%-32s" "program"
+for m in $MODES; do printf "%10s" "$m"; done
+echo
+
+declare -A TOTAL
+for m in $MODES; do TOTAL[$m]=0; done
+
+for src in tests/examples/valid/*.bmb examples/bootstrap_test/fibonacci.bmb examples/bootstrap_test/collatz.bmb; do
+    name="$(basename "$src" .bmb)"
+    # Skip programs the default interpreter cannot run either
+    "$BMB" run "$src" --frames env > "$OUT/env.out" 2>&1 || continue
+    printf "%-32s" "$name"
+    for m in $MODES; do
+        if ! "$BMB" run "$src" --frames "$m" > "$OUT/$m.out" 2>&1; then
+            printf "%10s" "n/a"
+            continue
+        fi
+        if ! cmp -s "$OUT/env.out" "$OUT/$m.out"; then
+            echo
+            echo "error: $name output differs between env and $m" >&2
+            exit 1
+        fi
+        best=""
+        for _ in $(seq "$RUNS"); do
+            start=$(date +%s%N)
+            "$BMB" run "$src" --frames "$m" > /dev/null 2>&1
+            end=$(date +%s%N)
+            us=$(( (end - start) / 1000 ))
+            if [ -z "$best" ] || [ "$us" -lt "$best" ]; then best=$us; fi
+        done
+        TOTAL[$m]=$(( TOTAL[$m] + best ))
+        printf "%8sus" "$best"
+    done
+    echo
+done
+
+printf "%-32s" "total (runnable in mode)"
+for m in $MODES; do printf "%8sus" "${TOTAL[$m]}"; done
+echo
@@ -0,0 +1,48 @@
+#!/bin/bash
+# Parallel build scaling benchmark
+# Times `bmb build --emit-ir` on the bootstrap compiler sources at
+# increasing --jobs counts. The cache is disabled so every run does the
+# full optimize + emit work, and each IR is checked against --jobs 1.
+#
+# Usage: scripts/bench_parallel_build.sh [path/to/bmb] [runs]
+
+set -e
+
+BMB="${1:-target/release/bmb}"
+RUNS="${2:-3}"
+OUT="$(mktemp -d)"
+trap 'rm -rf "$OUT"' EXIT
+
+MAX_JOBS="$(nproc 2>/dev/null || echo 4)"
+JOBS_LIST="1 2 4 8"
+[[ " $JOBS_LIST " == *" $MAX_JOBS "* ]] || JOBS_LIST="$JOBS_LIST $MAX_JOBS"
+
+printf "%-24s" "source"
+for j in $JOBS_LIST; do
+    [ "$j" -le "$MAX_JOBS" ] && printf "%10s" "-j$j"
+done
+echo
+
+for src in bootstrap/compiler.bmb bootstrap/llvm_ir.bmb bootstrap/parser.bmb bootstrap/types.bmb; do
+    name="$(basename "$src" .bmb)"
+    printf "%-24s" "$name"
+    for j in $JOBS_LIST; do
+        [ "$j" -le "$MAX_JOBS" ] || continue
+        mkdir -p "$OUT/j$j"
+        best=""
+        for _ in $(seq "$RUNS"); do
+            start=$(date +%s%N)
+            "$BMB" build "$src" --release --emit-ir --no-cache -j "$j" -o "$OUT/j$j/$name" > /dev/null
+            end=$(date +%s%N)
+            ms=$(( (end - start) / 1000000 ))
+            if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then best=$ms; fi
+        done
+        if ! cmp -s "$OUT/j1/$name.ll" "$OUT/j$j/$name.ll"; then
+            echo
+            echo "error: $name IR differs between -j1 and -j$j" >&2
+            exit 1
+        fi
+        printf "%8sms" "$best"
+    done
+    echo
+done
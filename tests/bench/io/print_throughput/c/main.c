@@ -0,0 +1,14 @@
+// print/println throughput: 2,000,000 lines of integers and strings
+#include <stdio.h>
+
+int main(void) {
+    for (long long row = 0; row < 1000; row++) {
+        for (long long col = 0; col < 1000; col++) {
+            long long v = row * 1000 + col;
+            printf("%lld\n", v);
+            fputs("line ", stdout);
+            printf("%lld\n", v);
+        }
+    }
+    return 0;
+}
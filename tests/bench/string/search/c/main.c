@@ -0,0 +1,37 @@
+// String search throughput: a 1 MiB haystack of "abcdefghijklmno\n"
+// lines with a single "needle" at the end, searched 200 times each way.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static long long count_nl(const char* s, size_t len) {
+    long long n = 0;
+    for (const char* p = s; (p = memchr(p, '\n', len - (size_t)(p - s))) != NULL; p++) n++;
+    return n;
+}
+
+static long long count_nl_slow(const char* s, size_t len) {
+    long long n = 0;
+    for (size_t i = 0; i < len; i++) n += (s[i] == '\n');
+    return n;
+}
+
+int main(void) {
+    const char* line = "abcdefghijklmno\n";
+    size_t len = 65536 * 16 + 6;
+    char* s = malloc(len + 1);
+    for (size_t i = 0; i < 65536; i++) memcpy(s + i * 16, line, 16);
+    memcpy(s + 65536 * 16, "needle", 7);
+
+    long long fast = 0, slow = 0;
+    for (int iter = 0; iter < 200; iter++) {
+        const char* hit = memmem(s, len, "needle", 6);
+        fast += (hit ? (long long)(hit - s) : -1) + count_nl(s, len);
+    }
+    for (int iter = 0; iter < 200; iter++) slow += count_nl_slow(s, len);
+
+    printf("%lld\n%lld\n", fast, slow);
+    free(s);
+    return 0;
+}